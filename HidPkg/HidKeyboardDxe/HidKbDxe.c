@@ -247,8 +247,6 @@ HIDKeyboardDriverBindingStart (
     goto ErrorExit;
   }
 
-  InitializeListHead (&HidKeyboardDevice->NsKeyList);
-
   // Initialize Keyboard Layout
   Status = InitKeyboardLayout (HidKeyboardDevice);
   if (EFI_ERROR (Status)) {
@@ -317,10 +315,18 @@ HIDKeyboardDriverBindingStart (
   //
 ErrorExit:
   if (HidKeyboardDevice != NULL) {
-    if (HidKeyboardDevice->LastReport != NULL) {
-      FreePool (HidKeyboardDevice->LastReport);
+    if (HidKeyboardDevice->ReportMap != NULL) {
+      HidKbFreeReportMap (HidKeyboardDevice->ReportMap);
+    }
+
+    if (HidKeyboardDevice->KeyTable != NULL) {
+      HidKbFreeKeyTable (HidKeyboardDevice->KeyTable);
     }
 
+    HidKeyQueueDestroy (&HidKeyboardDevice->HidKeyQueue);
+    HidKeyQueueDestroy (&HidKeyboardDevice->EfiKeyQueue);
+    HidKeyQueueDestroy (&HidKeyboardDevice->EfiKeyQueueForNotify);
+
     if (HidKeyboardDevice->SimpleInput.WaitForKey != NULL) {
       gBS->CloseEvent (HidKeyboardDevice->SimpleInput.WaitForKey);
     }
@@ -449,12 +455,25 @@ HIDKeyboardDriverBindingStop (
     FreeUnicodeStringTable (HidKeyboardDevice->ControllerNameTable);
   }
 
-  DestroyQueue (&HidKeyboardDevice->HidKeyQueue);
-  DestroyQueue (&HidKeyboardDevice->EfiKeyQueue);
-  DestroyQueue (&HidKeyboardDevice->EfiKeyQueueForNotify);
+  if ((HidKeyboardDevice->HidKeyQueue.Overflows != 0) || (HidKeyboardDevice->EfiKeyQueue.Overflows != 0) ||
+      (HidKeyboardDevice->EfiKeyQueueForNotify.Overflows != 0))
+  {
+    DEBUG ((
+      DEBUG_WARN,
+      "[%a] - Keys dropped on full queues: HID %d, EFI %d, notify %d\n",
+      __FUNCTION__,
+      HidKeyboardDevice->HidKeyQueue.Overflows,
+      HidKeyboardDevice->EfiKeyQueue.Overflows,
+      HidKeyboardDevice->EfiKeyQueueForNotify.Overflows
+      ));
+  }
+
+  HidKeyQueueDestroy (&HidKeyboardDevice->HidKeyQueue);
+  HidKeyQueueDestroy (&HidKeyboardDevice->EfiKeyQueue);
+  HidKeyQueueDestroy (&HidKeyboardDevice->EfiKeyQueueForNotify);
 
-  if (HidKeyboardDevice->LastReport != NULL) {
-    FreePool (HidKeyboardDevice->LastReport);
+  if (HidKeyboardDevice->ReportMap != NULL) {
+    HidKbFreeReportMap (HidKeyboardDevice->ReportMap);
   }
 
   FreePool (HidKeyboardDevice);
@@ -488,13 +507,7 @@ HIDKeyboardReadKeyStrokeWorker (
     return EFI_INVALID_PARAMETER;
   }
 
-  if (IsQueueEmpty (&HidKeyboardDevice->EfiKeyQueue)) {
-    return EFI_NOT_READY;
-  }
-
-  Dequeue (&HidKeyboardDevice->EfiKeyQueue, KeyData, sizeof (*KeyData));
-
-  return EFI_SUCCESS;
+  return HidKeyQueueDequeue (&HidKeyboardDevice->EfiKeyQueue, KeyData, sizeof (*KeyData));
 }
 
 /**
@@ -531,8 +544,8 @@ HIDKeyboardReset (
   // only reset private data structures.
   if (!ExtendedVerification) {
     // Clear the key buffer of this keyboard
-    InitQueue (&HidKeyboardDevice->HidKeyQueue, sizeof (HID_KEY));
-    InitQueue (&HidKeyboardDevice->EfiKeyQueue, sizeof (EFI_KEY_DATA));
+    HidKeyQueueInit (&HidKeyboardDevice->HidKeyQueue, sizeof (HID_KEY), HIDKBD_HID_KEY_QUEUE_DEPTH);
+    HidKeyQueueInit (&HidKeyboardDevice->EfiKeyQueue, sizeof (EFI_KEY_DATA), HIDKBD_KEY_QUEUE_DEPTH);
     return EFI_SUCCESS;
   }
 
@@ -626,38 +639,27 @@ HIDKeyboardWaitForKey (
 {
   HID_KB_DEV    *HidKeyboardDevice;
   EFI_KEY_DATA  KeyData;
-  EFI_TPL       OldTpl;
 
   HidKeyboardDevice = (HID_KB_DEV *)Context;
   ASSERT (NULL != HidKeyboardDevice);
 
-  //
-  // Enter critical section
-  //
-  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-
   //
   // WaitforKey doesn't support the partial key.
   // Considering if the partial keystroke is enabled, there maybe a partial
   // keystroke in the queue, so here skip the partial keystroke and get the
-  // next key from the queue
+  // next key from the queue. The queue needs no critical section.
   //
-  if (IsQueueEmpty (&HidKeyboardDevice->EfiKeyQueue)) {
+  if (HidKeyQueueIsEmpty (&HidKeyboardDevice->EfiKeyQueue)) {
     DEBUG ((DEBUG_VERBOSE, "[%a] - WaitForKey Queue empty!\n", __FUNCTION__));
   }
 
-  while (!IsQueueEmpty (&HidKeyboardDevice->EfiKeyQueue)) {
+  while (!EFI_ERROR (HidKeyQueuePeek (&HidKeyboardDevice->EfiKeyQueue, &KeyData, sizeof (EFI_KEY_DATA)))) {
     //
     // If there is pending key, signal the event.
     //
-    CopyMem (
-      &KeyData,
-      HidKeyboardDevice->EfiKeyQueue.Buffer[HidKeyboardDevice->EfiKeyQueue.Head],
-      sizeof (EFI_KEY_DATA)
-      );
     if ((KeyData.Key.ScanCode == SCAN_NULL) && (KeyData.Key.UnicodeChar == CHAR_NULL)) {
       DEBUG ((DEBUG_VERBOSE, "[%a] - WaitForKey, DeQueued, ScanCode = %d \n", __FUNCTION__, KeyData.Key.ScanCode));
-      Dequeue (&HidKeyboardDevice->EfiKeyQueue, &KeyData, sizeof (EFI_KEY_DATA));
+      HidKeyQueueDequeue (&HidKeyboardDevice->EfiKeyQueue, NULL, sizeof (EFI_KEY_DATA));
       continue;
     }
 
@@ -665,11 +667,6 @@ HIDKeyboardWaitForKey (
     gBS->SignalEvent (Event);
     break;
   }
-
-  //
-  // Leave critical section and return
-  //
-  gBS->RestoreTPL (OldTpl);
 }
 
 /**
@@ -1059,7 +1056,6 @@ KeyNotifyProcessHandler (
   LIST_ENTRY                     *Link;
   LIST_ENTRY                     *NotifyList;
   KEYBOARD_CONSOLE_IN_EX_NOTIFY  *CurrentNotify;
-  EFI_TPL                        OldTpl;
 
   HidKeyboardDevice = (HID_KB_DEV *)Context;
 
@@ -1068,15 +1064,7 @@ KeyNotifyProcessHandler (
   //
   NotifyList = &HidKeyboardDevice->NotifyList;
   while (TRUE) {
-    //
-    // Enter critical section
-    //
-    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
-    Status = Dequeue (&HidKeyboardDevice->EfiKeyQueueForNotify, &KeyData, sizeof (KeyData));
-    //
-    // Leave critical section
-    //
-    gBS->RestoreTPL (OldTpl);
+    Status = HidKeyQueueDequeue (&HidKeyboardDevice->EfiKeyQueueForNotify, &KeyData, sizeof (KeyData));
     if (EFI_ERROR (Status)) {
       break;
     }
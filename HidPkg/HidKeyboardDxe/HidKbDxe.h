@@ -45,29 +45,24 @@ Environment:
 #include <Protocol/HidKeyboardProtocol.h>
 #include <Library/HiiLib.h>
 
-#define KEYBOARD_TIMER_INTERVAL  200000         // 0.02s
+#include "HidKeyboardReport.h"
+#include "HidKeyboardLayout.h"
+#include "HidKeyQueue.h"
 
-#define MAX_KEY_ALLOWED  32
+#define KEYBOARD_TIMER_INTERVAL  200000         // 0.02s
 
 #define HZ                   1000 * 1000 * 10
 #define HIDKBD_REPEAT_DELAY  ((HZ) / 2)
 #define HIDKBD_REPEAT_RATE   ((HZ) / 50)
 
-#define HID_KEYBOARD_DRIVER_VERSION  0x10
-
-#define INPUT_REPORT_HEADER_SIZE  (OFFSET_OF(KEYBOARD_HID_INPUT_BUFFER, KeyCode))
-
-typedef struct {
-  BOOLEAN    Down;
-  UINT8      KeyCode;
-} HID_KEY;
+//
+// Depth of the EFI key queues. The HID key queue also holds every key change
+// of a single report.
+//
+#define HIDKBD_KEY_QUEUE_DEPTH      PcdGet32 (PcdHidKeyboardKeyQueueDepth)
+#define HIDKBD_HID_KEY_QUEUE_DEPTH  MAX (HIDKBD_KEY_QUEUE_DEPTH, HID_KB_MAX_KEY_CHANGES)
 
-typedef struct {
-  VOID     *Buffer[MAX_KEY_ALLOWED + 1];
-  UINTN    Head;
-  UINTN    Tail;
-  UINTN    ItemSize;
-} HID_SIMPLE_QUEUE;
+#define HID_KEYBOARD_DRIVER_VERSION  0x10
 
 #define HID_KB_DEV_SIGNATURE                   SIGNATURE_32 ('h', 'k', 'b', 'd')
 #define HID_KB_CONSOLE_IN_EX_NOTIFY_SIGNATURE  SIGNATURE_32 ('h', 'k', 'b', 'x')
@@ -79,26 +74,6 @@ typedef struct _KEYBOARD_CONSOLE_IN_EX_NOTIFY {
   LIST_ENTRY                 NotifyEntry;
 } KEYBOARD_CONSOLE_IN_EX_NOTIFY;
 
-#define HID_NS_KEY_SIGNATURE  SIGNATURE_32 ('h', 'n', 's', 'k')
-
-typedef struct {
-  UINTN                 Signature;
-  LIST_ENTRY            Link;
-
-  //
-  // The number of EFI_NS_KEY_MODIFIER children definitions
-  //
-  UINTN                 KeyCount;
-
-  //
-  // NsKey[0] : Non-spacing key
-  // NsKey[1] ~ NsKey[KeyCount] : Physical keys
-  //
-  EFI_KEY_DESCRIPTOR    *NsKey;
-} HID_NS_KEY;
-
-#define HID_NS_KEY_FORM_FROM_LINK(a)  CR (a, HID_NS_KEY, Link, HID_NS_KEY_SIGNATURE)
-
 ///
 /// Structure to describe HID keyboard device
 ///
@@ -111,12 +86,16 @@ typedef struct {
   EFI_SIMPLE_TEXT_INPUT_EX_PROTOCOL    SimpleInputEx;
   HID_KEYBOARD_PROTOCOL                *KeyboardProtocol;
 
-  HID_SIMPLE_QUEUE                     HidKeyQueue;
-  HID_SIMPLE_QUEUE                     EfiKeyQueue;
-  HID_SIMPLE_QUEUE                     EfiKeyQueueForNotify;
+  HID_KEY_QUEUE                        HidKeyQueue;
+  HID_KEY_QUEUE                        EfiKeyQueue;
+  HID_KEY_QUEUE                        EfiKeyQueueForNotify;
 
-  KEYBOARD_HID_INPUT_BUFFER            *LastReport;
-  UINTN                                LastReportSize;
+  //
+  // Compiled from the report descriptor of a report protocol keyboard,
+  // and the keys held down after the last report.
+  //
+  HID_KB_REPORT_MAP                    *ReportMap;
+  HID_KB_KEY_BITMAP                    KeyBitmap;
   UINT8                                CurKeyCode;
 
   UINT8                                RepeatKey;
@@ -151,11 +130,11 @@ typedef struct {
   EFI_EVENT                            KeyNotifyProcessEvent;
 
   //
-  // Non-spacing key list
+  // Key translation tables of the current keyboard layout, and the
+  // non-spacing key waiting for the next keystroke (0 if none).
   //
-  LIST_ENTRY                           NsKeyList;
-  HID_NS_KEY                           *CurrentNsKey;
-  EFI_KEY_DESCRIPTOR                   *KeyConvertionTable;
+  HID_KB_KEY_TABLE                     *KeyTable;
+  UINT16                               CurrentNsKey;
   EFI_EVENT                            KeyboardLayoutEvent;
 } HID_KB_DEV;
 
@@ -0,0 +1,314 @@
+/** @file HidKeyQueue.c
+
+  Fixed depth ring of fixed size key slots.
+
+  Slot i of the ring starts with sequence number i. A producer may fill the
+  slot at position Pos when its sequence is Pos, and publishes the item by
+  setting it to Pos + 1. A consumer may take the item at position Pos when the
+  sequence is Pos + 1, and frees the slot for the next lap by setting it to
+  Pos + depth. Head and Tail only ever move forward by compare exchange, so a
+  queue operation that is interrupted leaves at most one slot claimed but not
+  yet filled or emptied, and every other operation skips past it instead of
+  waiting for it.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SynchronizationLib.h>
+
+#include "HidKeyQueue.h"
+
+//
+// Where a queue operation can be interrupted between two of its steps. Host
+// tests run other queue operations here, the way an event at a higher TPL would.
+//
+#ifndef HID_KEY_QUEUE_PREEMPTION_POINT
+#define HID_KEY_QUEUE_PREEMPTION_POINT(Queue)
+#endif
+
+typedef struct {
+  volatile UINT32    Sequence;
+  UINT32             Reserved;
+  //
+  // The item follows.
+  //
+} HID_KEY_QUEUE_SLOT;
+
+#define HID_KEY_QUEUE_SLOT_AT(Queue, Position) \
+  ((HID_KEY_QUEUE_SLOT *)((Queue)->Slots + (UINTN)((Position) & (Queue)->Mask) * (Queue)->SlotSize))
+
+#define HID_KEY_QUEUE_ITEM(Slot)  ((UINT8 *)(Slot) + sizeof (HID_KEY_QUEUE_SLOT))
+
+/**
+  Create the queue, or empty it if it has been created before.
+
+  @param  Queue     Points to the queue.
+  @param  ItemSize  Size of the single item.
+  @param  Depth     Number of items the queue holds, rounded up to a power of two.
+
+  @retval EFI_SUCCESS            The queue is empty and ready for use.
+  @retval EFI_INVALID_PARAMETER  ItemSize or Depth is 0, or Depth is above HID_KEY_QUEUE_MAX_DEPTH.
+  @retval EFI_OUT_OF_RESOURCES   The slots could not be allocated.
+
+**/
+EFI_STATUS
+HidKeyQueueInit (
+  IN OUT  HID_KEY_QUEUE  *Queue,
+  IN      UINTN          ItemSize,
+  IN      UINTN          Depth
+  )
+{
+  UINT32  Index;
+
+  if ((ItemSize == 0) || (ItemSize > MAX_UINT16) || (Depth == 0) || (Depth > HID_KEY_QUEUE_MAX_DEPTH)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Queue->Slots != NULL) {
+    //
+    // Empty the queue the way a consumer would, a producer may be adding to
+    // it at the same time.
+    //
+    ASSERT (ItemSize == Queue->ItemSize);
+    while (!EFI_ERROR (HidKeyQueueDequeue (Queue, NULL, Queue->ItemSize))) {
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  if ((Depth & (Depth - 1)) != 0) {
+    Depth = GetPowerOfTwo32 ((UINT32)Depth) << 1;
+  }
+
+  Queue->ItemSize = (UINT32)ItemSize;
+  Queue->SlotSize = (UINT32)ALIGN_VALUE (sizeof (HID_KEY_QUEUE_SLOT) + ItemSize, sizeof (UINT64));
+  Queue->Mask     = (UINT32)Depth - 1;
+  Queue->Slots    = AllocateZeroPool (Depth * Queue->SlotSize);
+  if (Queue->Slots == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index <= Queue->Mask; Index++) {
+    HID_KEY_QUEUE_SLOT_AT (Queue, Index)->Sequence = Index;
+  }
+
+  Queue->Head      = 0;
+  Queue->Tail      = 0;
+  Queue->Overflows = 0;
+  MemoryFence ();
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Destroy the queue.
+
+  @param Queue    Points to the queue.
+**/
+VOID
+HidKeyQueueDestroy (
+  IN OUT HID_KEY_QUEUE  *Queue
+  )
+{
+  if (Queue->Slots != NULL) {
+    FreePool (Queue->Slots);
+    Queue->Slots = NULL;
+  }
+}
+
+/**
+  Check whether the queue has an item ready to dequeue.
+
+  @param  Queue     Points to the queue.
+
+  @retval TRUE      Queue is empty, or its first item is still being enqueued.
+  @retval FALSE     Queue is not empty.
+
+**/
+BOOLEAN
+HidKeyQueueIsEmpty (
+  IN  HID_KEY_QUEUE  *Queue
+  )
+{
+  UINT32  Position;
+
+  Position = Queue->Head;
+  return (BOOLEAN)(HID_KEY_QUEUE_SLOT_AT (Queue, Position)->Sequence != Position + 1);
+}
+
+/**
+  Enqueue the item to the queue.
+
+  If the queue is full the item is dropped and counted in Queue->Overflows.
+
+  @param  Queue     Points to the queue.
+  @param  Item      Points to the item to be enqueued.
+  @param  ItemSize  Size of the item.
+
+  @retval EFI_SUCCESS           Item was successfully enqueued.
+  @retval EFI_BUFFER_TOO_SMALL  The queue is full, the item was dropped.
+
+**/
+EFI_STATUS
+HidKeyQueueEnqueue (
+  IN OUT  HID_KEY_QUEUE  *Queue,
+  IN      CONST VOID     *Item,
+  IN      UINTN          ItemSize
+  )
+{
+  HID_KEY_QUEUE_SLOT  *Slot;
+  UINT32              Position;
+  INT32               Lag;
+
+  ASSERT (ItemSize == Queue->ItemSize);
+
+  while (TRUE) {
+    Position = Queue->Tail;
+    Slot     = HID_KEY_QUEUE_SLOT_AT (Queue, Position);
+    Lag      = (INT32)(Slot->Sequence - Position);
+    HID_KEY_QUEUE_PREEMPTION_POINT (Queue);
+    if (Lag < 0) {
+      //
+      // The consumer has not emptied this slot since the last lap.
+      //
+      if (InterlockedIncrement (&Queue->Overflows) == 1) {
+        DEBUG ((DEBUG_WARN, "[%a] - Key queue of %d is full, dropping keys\n", __FUNCTION__, Queue->Mask + 1));
+      }
+
+      return EFI_BUFFER_TOO_SMALL;
+    }
+
+    if ((Lag == 0) && (InterlockedCompareExchange32 (&Queue->Tail, Position, Position + 1) == Position)) {
+      break;
+    }
+
+    //
+    // Another producer claimed the slot first.
+    //
+  }
+
+  HID_KEY_QUEUE_PREEMPTION_POINT (Queue);
+  CopyMem (HID_KEY_QUEUE_ITEM (Slot), Item, ItemSize);
+  HID_KEY_QUEUE_PREEMPTION_POINT (Queue);
+
+  //
+  // Publish the item after its contents.
+  //
+  MemoryFence ();
+  Slot->Sequence = Position + 1;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Dequeue a item from the queue.
+
+  @param  Queue     Points to the queue.
+  @param  Item      Receives the item, NULL to discard it.
+  @param  ItemSize  Size of the item.
+
+  @retval EFI_SUCCESS        Item was successfully dequeued.
+  @retval EFI_NOT_READY      The queue is empty.
+
+**/
+EFI_STATUS
+HidKeyQueueDequeue (
+  IN OUT  HID_KEY_QUEUE  *Queue,
+  OUT     VOID           *Item OPTIONAL,
+  IN      UINTN          ItemSize
+  )
+{
+  HID_KEY_QUEUE_SLOT  *Slot;
+  UINT32              Position;
+  INT32               Lag;
+
+  ASSERT (ItemSize == Queue->ItemSize);
+
+  while (TRUE) {
+    Position = Queue->Head;
+    Slot     = HID_KEY_QUEUE_SLOT_AT (Queue, Position);
+    Lag      = (INT32)(Slot->Sequence - (Position + 1));
+    HID_KEY_QUEUE_PREEMPTION_POINT (Queue);
+    if (Lag < 0) {
+      //
+      // Nothing has been published at this position yet.
+      //
+      return EFI_NOT_READY;
+    }
+
+    if ((Lag == 0) && (InterlockedCompareExchange32 (&Queue->Head, Position, Position + 1) == Position)) {
+      break;
+    }
+
+    //
+    // Another consumer took the item first.
+    //
+  }
+
+  HID_KEY_QUEUE_PREEMPTION_POINT (Queue);
+  MemoryFence ();
+  if (Item != NULL) {
+    CopyMem (Item, HID_KEY_QUEUE_ITEM (Slot), ItemSize);
+  }
+
+  HID_KEY_QUEUE_PREEMPTION_POINT (Queue);
+
+  //
+  // Hand the slot to the producer of the next lap after the item is copied out.
+  //
+  MemoryFence ();
+  Slot->Sequence = Position + Queue->Mask + 1;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy the first item of the queue without dequeuing it.
+
+  @param  Queue     Points to the queue.
+  @param  Item      Receives the item.
+  @param  ItemSize  Size of the item.
+
+  @retval EFI_SUCCESS        Item was successfully copied.
+  @retval EFI_NOT_READY      The queue is empty.
+
+**/
+EFI_STATUS
+HidKeyQueuePeek (
+  IN      HID_KEY_QUEUE  *Queue,
+  OUT     VOID           *Item,
+  IN      UINTN          ItemSize
+  )
+{
+  HID_KEY_QUEUE_SLOT  *Slot;
+  UINT32              Position;
+
+  ASSERT (ItemSize == Queue->ItemSize);
+
+  while (TRUE) {
+    Position = Queue->Head;
+    Slot     = HID_KEY_QUEUE_SLOT_AT (Queue, Position);
+    if (Slot->Sequence != Position + 1) {
+      return EFI_NOT_READY;
+    }
+
+    MemoryFence ();
+    CopyMem (Item, HID_KEY_QUEUE_ITEM (Slot), ItemSize);
+    HID_KEY_QUEUE_PREEMPTION_POINT (Queue);
+
+    //
+    // The copy is good if nobody dequeued the item while it was made.
+    //
+    MemoryFence ();
+    if (Queue->Head == Position) {
+      return EFI_SUCCESS;
+    }
+  }
+}
@@ -0,0 +1,134 @@
+/** @file HidKeyQueue.h
+
+  Fixed depth ring of fixed size key slots shared between the report callback
+  and repeat timer that produce keys and the Simple Text Input services that
+  consume them.
+
+  Every slot carries a sequence number that says whether it is free for the
+  producer that claims its position or holds an item for the consumer that
+  claims it. Positions are claimed with a compare exchange, so an event that
+  interrupts a queue operation at a higher TPL completes its own operation
+  without waiting on the one it interrupted, and no caller needs to raise TPL.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _HID_KEY_QUEUE_H_
+#define _HID_KEY_QUEUE_H_
+
+#include <Uefi.h>
+
+#define HID_KEY_QUEUE_MAX_DEPTH  0x10000
+
+typedef struct {
+  UINT8              *Slots;
+  UINT32             SlotSize;
+  UINT32             ItemSize;
+  UINT32             Mask;                // Depth - 1, the depth is a power of two
+  volatile UINT32    Head;                // Position of the next item to dequeue
+  volatile UINT32    Tail;                // Position of the next slot to enqueue into
+  volatile UINT32    Overflows;           // Items dropped because the queue was full
+} HID_KEY_QUEUE;
+
+/**
+  Create the queue, or empty it if it has been created before.
+
+  @param  Queue     Points to the queue.
+  @param  ItemSize  Size of the single item.
+  @param  Depth     Number of items the queue holds, rounded up to a power of two.
+
+  @retval EFI_SUCCESS            The queue is empty and ready for use.
+  @retval EFI_INVALID_PARAMETER  ItemSize or Depth is 0, or Depth is above HID_KEY_QUEUE_MAX_DEPTH.
+  @retval EFI_OUT_OF_RESOURCES   The slots could not be allocated.
+
+**/
+EFI_STATUS
+HidKeyQueueInit (
+  IN OUT  HID_KEY_QUEUE  *Queue,
+  IN      UINTN          ItemSize,
+  IN      UINTN          Depth
+  );
+
+/**
+  Destroy the queue.
+
+  @param Queue    Points to the queue.
+**/
+VOID
+HidKeyQueueDestroy (
+  IN OUT HID_KEY_QUEUE  *Queue
+  );
+
+/**
+  Check whether the queue has an item ready to dequeue.
+
+  @param  Queue     Points to the queue.
+
+  @retval TRUE      Queue is empty, or its first item is still being enqueued.
+  @retval FALSE     Queue is not empty.
+
+**/
+BOOLEAN
+HidKeyQueueIsEmpty (
+  IN  HID_KEY_QUEUE  *Queue
+  );
+
+/**
+  Enqueue the item to the queue.
+
+  If the queue is full the item is dropped and counted in Queue->Overflows.
+
+  @param  Queue     Points to the queue.
+  @param  Item      Points to the item to be enqueued.
+  @param  ItemSize  Size of the item.
+
+  @retval EFI_SUCCESS           Item was successfully enqueued.
+  @retval EFI_BUFFER_TOO_SMALL  The queue is full, the item was dropped.
+
+**/
+EFI_STATUS
+HidKeyQueueEnqueue (
+  IN OUT  HID_KEY_QUEUE  *Queue,
+  IN      CONST VOID     *Item,
+  IN      UINTN          ItemSize
+  );
+
+/**
+  Dequeue a item from the queue.
+
+  @param  Queue     Points to the queue.
+  @param  Item      Receives the item, NULL to discard it.
+  @param  ItemSize  Size of the item.
+
+  @retval EFI_SUCCESS        Item was successfully dequeued.
+  @retval EFI_NOT_READY      The queue is empty.
+
+**/
+EFI_STATUS
+HidKeyQueueDequeue (
+  IN OUT  HID_KEY_QUEUE  *Queue,
+  OUT     VOID           *Item OPTIONAL,
+  IN      UINTN          ItemSize
+  );
+
+/**
+  Copy the first item of the queue without dequeuing it.
+
+  @param  Queue     Points to the queue.
+  @param  Item      Receives the item.
+  @param  ItemSize  Size of the item.
+
+  @retval EFI_SUCCESS        Item was successfully copied.
+  @retval EFI_NOT_READY      The queue is empty.
+
+**/
+EFI_STATUS
+HidKeyQueuePeek (
+  IN      HID_KEY_QUEUE  *Queue,
+  OUT     VOID           *Item,
+  IN      UINTN          ItemSize
+  );
+
+#endif // _HID_KEY_QUEUE_H_
@@ -13,39 +13,6 @@
 
 #include "HidKbDxe.h"
 
-#define HID_KEYBOARD_KEY_COUNT  105
-
-#define HID_KEYBOARD_LANGUAGE_STR_LEN     5         // RFC4646 Language Code: "en-US"
-#define HID_KEYBOARD_DESCRIPTION_STR_LEN  (16 + 1)  // Description: "English Keyboard"
-
-#pragma pack (1)
-typedef struct {
-  //
-  // This 4-bytes total array length is required by PreparePackageList()
-  //
-  UINT32                    Length;
-
-  //
-  // Keyboard Layout package definition
-  //
-  EFI_HII_PACKAGE_HEADER    PackageHeader;
-  UINT16                    LayoutCount;
-
-  //
-  // EFI_HII_KEYBOARD_LAYOUT
-  //
-  UINT16                    LayoutLength;
-  EFI_GUID                  Guid;
-  UINT32                    LayoutDescriptorStringOffset;
-  UINT8                     DescriptorCount;
-  EFI_KEY_DESCRIPTOR        KeyDescriptor[HID_KEYBOARD_KEY_COUNT];
-  UINT16                    DescriptionCount;
-  CHAR16                    Language[HID_KEYBOARD_LANGUAGE_STR_LEN];
-  CHAR16                    Space;
-  CHAR16                    DescriptionString[HID_KEYBOARD_DESCRIPTION_STR_LEN];
-} HID_KEYBOARD_LAYOUT_PACK_BIN;
-#pragma pack()
-
 /**
   Initialize HID keyboard device and all private data
   structures.
@@ -64,7 +31,7 @@ InitHidKeyboard (
 /**
   Initialize USB keyboard layout.
 
-  This function initializes Key Convertion Table for the USB keyboard device.
+  This function initializes the key table for the USB keyboard device.
   It first tries to retrieve layout from HII database. If failed and default
   layout is enabled, then it just uses the default layout.
 
@@ -96,6 +63,11 @@ ReleaseKeyboardLayoutResources (
   Initial processing of the HID key report. Processes and queues individual keys
   in the key report.
 
+  The report is translated into the bitmap of keys held down and compared
+  with the bitmap of the previous report, so the cost does not depend on how
+  many keys the report can carry.
+
+  @param  Interface                 - BootKeyboard or ReportKeyboard.
   @param  *HidInputReportBuffer     - Pointer to the buffer containing HID key report.
   @param  HidInputReportBufferSize  - gives the size of the input report buffer.
   @param  *HidKeyboardDevice        - pointer to HID_KB_DEV struct.
@@ -105,9 +77,10 @@ ReleaseKeyboardLayoutResources (
 **/
 VOID
 ProcessKeyStroke (
-  IN UINT8       *HidInputReportBuffer,
-  IN UINTN       HidInputReportBufferSize,
-  IN HID_KB_DEV  *HidKeyboardDevice
+  IN KEYBOARD_HID_INTERFACE  Interface,
+  IN UINT8                   *HidInputReportBuffer,
+  IN UINTN                   HidInputReportBufferSize,
+  IN HID_KB_DEV              *HidKeyboardDevice
   );
 
 /**
@@ -175,89 +148,6 @@ HIDProcessKeyStrokesCallback (
   IN VOID                    *Context
   );
 
-/**
-  Create the queue.
-
-  @param  Queue     Points to the queue.
-  @param  ItemSize  Size of the single item.
-
-**/
-VOID
-InitQueue (
-  IN OUT  HID_SIMPLE_QUEUE  *Queue,
-  IN      UINTN             ItemSize
-  );
-
-/**
-  Destroy the queue
-
-  @param Queue    Points to the queue.
-**/
-VOID
-DestroyQueue (
-  IN OUT HID_SIMPLE_QUEUE  *Queue
-  );
-
-/**
-  Check whether the queue is empty.
-
-  @param  Queue     Points to the queue.
-
-  @retval TRUE      Queue is empty.
-  @retval FALSE     Queue is not empty.
-
-**/
-BOOLEAN
-IsQueueEmpty (
-  IN  HID_SIMPLE_QUEUE  *Queue
-  );
-
-/**
-  Check whether the queue is full.
-
-  @param  Queue     Points to the queue.
-
-  @retval TRUE      Queue is full.
-  @retval FALSE     Queue is not full.
-
-**/
-BOOLEAN
-IsQueueFull (
-  IN  HID_SIMPLE_QUEUE  *Queue
-  );
-
-/**
-  Enqueue the item to the queue.
-
-  @param  Queue     Points to the queue.
-  @param  Item      Points to the item to be enqueued.
-  @param  ItemSize  Size of the item.
-**/
-VOID
-Enqueue (
-  IN OUT  HID_SIMPLE_QUEUE  *Queue,
-  IN      VOID              *Item,
-  IN      UINTN             ItemSize
-  );
-
-/**
-  Dequeue a item from the queue.
-
-  @param  Queue     Points to the queue.
-  @param  Item      Receives the item.
-  @param  ItemSize  Size of the item.
-
-  @retval EFI_SUCCESS        Item was successfully dequeued.
-  @retval EFI_DEVICE_ERROR   The queue is empty.
-
-**/
-EFI_STATUS
-Dequeue (
-  IN OUT  HID_SIMPLE_QUEUE  *Queue,
-  OUT  VOID                 *Item,
-  IN      UINTN             ItemSize
-  );
-
 /**
 Sends CAPSLOCK LED status to keyboard
 
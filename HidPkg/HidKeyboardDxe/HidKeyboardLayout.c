@@ -0,0 +1,632 @@
+/** @file HidKeyboardLayout.c
+
+  Default keyboard layout and compilation of keyboard layouts into flat key
+  translation tables.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+
+Portions derived from UsbKbDxe:
+Copyright (c) 2004 - 2018, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Guid/HidKeyBoardLayout.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "HidKeyboardLayout.h"
+
+HID_KEYBOARD_LAYOUT_PACK_BIN  mHidKeyboardLayoutBin = {
+  sizeof (HID_KEYBOARD_LAYOUT_PACK_BIN),   // Binary size
+
+  //
+  // EFI_HII_PACKAGE_HEADER
+  //
+  {
+    sizeof (HID_KEYBOARD_LAYOUT_PACK_BIN) - sizeof (UINT32),
+    EFI_HII_PACKAGE_KEYBOARD_LAYOUT
+  },
+  1,                                                                                                                               // LayoutCount
+  sizeof (HID_KEYBOARD_LAYOUT_PACK_BIN) - sizeof (UINT32) - sizeof (EFI_HII_PACKAGE_HEADER) - sizeof (UINT16),                     // LayoutLength
+  HID_KEYBOARD_LAYOUT_KEY_GUID,                                                                                                    // KeyGuid
+  sizeof (UINT16) + sizeof (EFI_GUID) + sizeof (UINT32) + sizeof (UINT8) + (HID_KEYBOARD_KEY_COUNT * sizeof (EFI_KEY_DESCRIPTOR)), // LayoutDescriptorStringOffset
+  HID_KEYBOARD_KEY_COUNT,                                                                                                          // DescriptorCount
+  {
+    //
+    // EFI_KEY_DESCRIPTOR (total number is HID_KEYBOARD_KEY_COUNT)
+    //
+    { EfiKeyC1,         'a',  'A',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyB5,         'b',  'B',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyB3,         'c',  'C',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyC3,         'd',  'D',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD3,         'e',  'E',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyC4,         'f',  'F',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyC5,         'g',  'G',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyC6,         'h',  'H',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD8,         'i',  'I',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyC7,         'j',  'J',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyC8,         'k',  'K',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyC9,         'l',  'L',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyB7,         'm',  'M',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyB6,         'n',  'N',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD9,         'o',  'O',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD10,        'p',  'P',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD1,         'q',  'Q',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD4,         'r',  'R',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyC2,         's',  'S',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD5,         't',  'T',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD7,         'u',  'U',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyB4,         'v',  'V',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD2,         'w',  'W',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyB2,         'x',  'X',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD6,         'y',  'Y',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyB1,         'z',  'Z',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyE1,         '1',  '!',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE2,         '2',  '@',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE3,         '3',  '#',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE4,         '4',  '$',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE5,         '5',  '%',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE6,         '6',  '^',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE7,         '7',  '&',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE8,         '8',  '*',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE9,         '9',  '(',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE10,        '0',  ')',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyEnter,      0x0d, 0x0d, 0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyEsc,        0x1b, 0x1b, 0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyBackSpace,  0x08, 0x08, 0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyTab,        0x09, 0x09, 0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeySpaceBar,   ' ',  ' ',  0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyE11,        '-',  '_',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE12,        '=',  '+',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyD11,        '[',  '{',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyD12,        ']',  '}',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyD13,        '\\', '|',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyC12,        '\\', '|',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyC10,        ';',  ':',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyC11,        '\'', '"',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyE0,         '`',  '~',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyB8,         ',',  '<',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyB9,         '.',  '>',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyB10,        '/',  '?',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+    { EfiKeyCapsLock,   0x00, 0x00, 0,   0,   EFI_CAPS_LOCK_MODIFIER,           0                                                          },
+    { EfiKeyF1,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_ONE_MODIFIER,    0                                                          },
+    { EfiKeyF2,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_TWO_MODIFIER,    0                                                          },
+    { EfiKeyF3,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_THREE_MODIFIER,  0                                                          },
+    { EfiKeyF4,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_FOUR_MODIFIER,   0                                                          },
+    { EfiKeyF5,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_FIVE_MODIFIER,   0                                                          },
+    { EfiKeyF6,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_SIX_MODIFIER,    0                                                          },
+    { EfiKeyF7,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_SEVEN_MODIFIER,  0                                                          },
+    { EfiKeyF8,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_EIGHT_MODIFIER,  0                                                          },
+    { EfiKeyF9,         0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_NINE_MODIFIER,   0                                                          },
+    { EfiKeyF10,        0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_TEN_MODIFIER,    0                                                          },
+    { EfiKeyF11,        0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_ELEVEN_MODIFIER, 0                                                          },
+    { EfiKeyF12,        0x00, 0x00, 0,   0,   EFI_FUNCTION_KEY_TWELVE_MODIFIER, 0                                                          },
+    { EfiKeyPrint,      0x00, 0x00, 0,   0,   EFI_PRINT_MODIFIER,               0                                                          },
+    { EfiKeySLck,       0x00, 0x00, 0,   0,   EFI_SCROLL_LOCK_MODIFIER,         0                                                          },
+    { EfiKeyPause,      0x00, 0x00, 0,   0,   EFI_PAUSE_MODIFIER,               0                                                          },
+    { EfiKeyIns,        0x00, 0x00, 0,   0,   EFI_INSERT_MODIFIER,              0                                                          },
+    { EfiKeyHome,       0x00, 0x00, 0,   0,   EFI_HOME_MODIFIER,                0                                                          },
+    { EfiKeyPgUp,       0x00, 0x00, 0,   0,   EFI_PAGE_UP_MODIFIER,             0                                                          },
+    { EfiKeyDel,        0x00, 0x00, 0,   0,   EFI_DELETE_MODIFIER,              0                                                          },
+    { EfiKeyEnd,        0x00, 0x00, 0,   0,   EFI_END_MODIFIER,                 0                                                          },
+    { EfiKeyPgDn,       0x00, 0x00, 0,   0,   EFI_PAGE_DOWN_MODIFIER,           0                                                          },
+    { EfiKeyRightArrow, 0x00, 0x00, 0,   0,   EFI_RIGHT_ARROW_MODIFIER,         0                                                          },
+    { EfiKeyLeftArrow,  0x00, 0x00, 0,   0,   EFI_LEFT_ARROW_MODIFIER,          0                                                          },
+    { EfiKeyDownArrow,  0x00, 0x00, 0,   0,   EFI_DOWN_ARROW_MODIFIER,          0                                                          },
+    { EfiKeyUpArrow,    0x00, 0x00, 0,   0,   EFI_UP_ARROW_MODIFIER,            0                                                          },
+    { EfiKeyNLck,       0x00, 0x00, 0,   0,   EFI_NUM_LOCK_MODIFIER,            0                                                          },
+    { EfiKeySlash,      '/',  '/',  0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyAsterisk,   '*',  '*',  0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyMinus,      '-',  '-',  0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyPlus,       '+',  '+',  0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyEnter,      0x0d, 0x0d, 0,   0,   EFI_NULL_MODIFIER,                0                                                          },
+    { EfiKeyOne,        '1',  '1',  0,   0,   EFI_END_MODIFIER,                 EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyTwo,        '2',  '2',  0,   0,   EFI_DOWN_ARROW_MODIFIER,          EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyThree,      '3',  '3',  0,   0,   EFI_PAGE_DOWN_MODIFIER,           EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyFour,       '4',  '4',  0,   0,   EFI_LEFT_ARROW_MODIFIER,          EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyFive,       '5',  '5',  0,   0,   EFI_NULL_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeySix,        '6',  '6',  0,   0,   EFI_RIGHT_ARROW_MODIFIER,         EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeySeven,      '7',  '7',  0,   0,   EFI_HOME_MODIFIER,                EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyEight,      '8',  '8',  0,   0,   EFI_UP_ARROW_MODIFIER,            EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyNine,       '9',  '9',  0,   0,   EFI_PAGE_UP_MODIFIER,             EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyZero,       '0',  '0',  0,   0,   EFI_INSERT_MODIFIER,              EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyPeriod,     '.',  '.',  0,   0,   EFI_DELETE_MODIFIER,              EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_NUM_LOCK  },
+    { EfiKeyA4,         0x00, 0x00, 0,   0,   EFI_MENU_MODIFIER,                0                                                          },
+    { EfiKeyLCtrl,      0,    0,    0,   0,   EFI_LEFT_CONTROL_MODIFIER,        0                                                          },
+    { EfiKeyLShift,     0,    0,    0,   0,   EFI_LEFT_SHIFT_MODIFIER,          0                                                          },
+    { EfiKeyLAlt,       0,    0,    0,   0,   EFI_LEFT_ALT_MODIFIER,            0                                                          },
+    { EfiKeyA0,         0,    0,    0,   0,   EFI_LEFT_LOGO_MODIFIER,           0                                                          },
+    { EfiKeyRCtrl,      0,    0,    0,   0,   EFI_RIGHT_CONTROL_MODIFIER,       0                                                          },
+    { EfiKeyRShift,     0,    0,    0,   0,   EFI_RIGHT_SHIFT_MODIFIER,         0                                                          },
+    { EfiKeyA2,         0,    0,    0,   0,   EFI_RIGHT_ALT_MODIFIER,           0                                                          },
+    { EfiKeyA3,         0,    0,    0,   0,   EFI_RIGHT_LOGO_MODIFIER,          0                                                          },
+  },
+  1,                                                                                                                                        // DescriptionCount
+  { 'e',              'n',  '-',  'U', 'S' },                                                                                               // RFC4646 language code
+  ' ',                                                                                                                                      // Space
+  { 'E',              'n',  'g',  'l', 'i', 's',                              'h', ' ', 'K', 'e', 'y', 'b', 'o', 'a', 'r', 'd', '\0'     }, // DescriptionString[]
+};
+
+//
+// EFI_KEY to HID Keycode conversion table
+// EFI_KEY is defined in UEFI spec.
+// HID Keycode is defined in HID HID Firmware spec.
+//
+UINT8  EfiKeyToHidKeyCodeConvertionTable[] = {
+  0xe0,  //  EfiKeyLCtrl
+  0xe3,  //  EfiKeyA0
+  0xe2,  //  EfiKeyLAlt
+  0x2c,  //  EfiKeySpaceBar
+  0xe6,  //  EfiKeyA2
+  0xe7,  //  EfiKeyA3
+  0x65,  //  EfiKeyA4
+  0xe4,  //  EfiKeyRCtrl
+  0x50,  //  EfiKeyLeftArrow
+  0x51,  //  EfiKeyDownArrow
+  0x4F,  //  EfiKeyRightArrow
+  0x62,  //  EfiKeyZero
+  0x63,  //  EfiKeyPeriod
+  0x28,  //  EfiKeyEnter
+  0xe1,  //  EfiKeyLShift
+  0x64,  //  EfiKeyB0
+  0x1D,  //  EfiKeyB1
+  0x1B,  //  EfiKeyB2
+  0x06,  //  EfiKeyB3
+  0x19,  //  EfiKeyB4
+  0x05,  //  EfiKeyB5
+  0x11,  //  EfiKeyB6
+  0x10,  //  EfiKeyB7
+  0x36,  //  EfiKeyB8
+  0x37,  //  EfiKeyB9
+  0x38,  //  EfiKeyB10
+  0xe5,  //  EfiKeyRShift
+  0x52,  //  EfiKeyUpArrow
+  0x59,  //  EfiKeyOne
+  0x5A,  //  EfiKeyTwo
+  0x5B,  //  EfiKeyThree
+  0x39,  //  EfiKeyCapsLock
+  0x04,  //  EfiKeyC1
+  0x16,  //  EfiKeyC2
+  0x07,  //  EfiKeyC3
+  0x09,  //  EfiKeyC4
+  0x0A,  //  EfiKeyC5
+  0x0B,  //  EfiKeyC6
+  0x0D,  //  EfiKeyC7
+  0x0E,  //  EfiKeyC8
+  0x0F,  //  EfiKeyC9
+  0x33,  //  EfiKeyC10
+  0x34,  //  EfiKeyC11
+  0x32,  //  EfiKeyC12
+  0x5C,  //  EfiKeyFour
+  0x5D,  //  EfiKeyFive
+  0x5E,  //  EfiKeySix
+  0x57,  //  EfiKeyPlus
+  0x2B,  //  EfiKeyTab
+  0x14,  //  EfiKeyD1
+  0x1A,  //  EfiKeyD2
+  0x08,  //  EfiKeyD3
+  0x15,  //  EfiKeyD4
+  0x17,  //  EfiKeyD5
+  0x1C,  //  EfiKeyD6
+  0x18,  //  EfiKeyD7
+  0x0C,  //  EfiKeyD8
+  0x12,  //  EfiKeyD9
+  0x13,  //  EfiKeyD10
+  0x2F,  //  EfiKeyD11
+  0x30,  //  EfiKeyD12
+  0x31,  //  EfiKeyD13
+  0x4C,  //  EfiKeyDel
+  0x4D,  //  EfiKeyEnd
+  0x4E,  //  EfiKeyPgDn
+  0x5F,  //  EfiKeySeven
+  0x60,  //  EfiKeyEight
+  0x61,  //  EfiKeyNine
+  0x35,  //  EfiKeyE0
+  0x1E,  //  EfiKeyE1
+  0x1F,  //  EfiKeyE2
+  0x20,  //  EfiKeyE3
+  0x21,  //  EfiKeyE4
+  0x22,  //  EfiKeyE5
+  0x23,  //  EfiKeyE6
+  0x24,  //  EfiKeyE7
+  0x25,  //  EfiKeyE8
+  0x26,  //  EfiKeyE9
+  0x27,  //  EfiKeyE10
+  0x2D,  //  EfiKeyE11
+  0x2E,  //  EfiKeyE12
+  0x2A,  //  EfiKeyBackSpace
+  0x49,  //  EfiKeyIns
+  0x4A,  //  EfiKeyHome
+  0x4B,  //  EfiKeyPgUp
+  0x53,  //  EfiKeyNLck
+  0x54,  //  EfiKeySlash
+  0x55,  //  EfiKeyAsterisk
+  0x56,  //  EfiKeyMinus
+  0x29,  //  EfiKeyEsc
+  0x3A,  //  EfiKeyF1
+  0x3B,  //  EfiKeyF2
+  0x3C,  //  EfiKeyF3
+  0x3D,  //  EfiKeyF4
+  0x3E,  //  EfiKeyF5
+  0x3F,  //  EfiKeyF6
+  0x40,  //  EfiKeyF7
+  0x41,  //  EfiKeyF8
+  0x42,  //  EfiKeyF9
+  0x43,  //  EfiKeyF10
+  0x44,  //  EfiKeyF11
+  0x45,  //  EfiKeyF12
+  0x46,  //  EfiKeyPrint
+  0x47,  //  EfiKeySLck
+  0x48   //  EfiKeyPause
+};
+
+//
+// Keyboard modifier value to EFI Scan Code conversion table
+// EFI Scan Code and the modifier values are defined in UEFI spec.
+//
+UINT8  ModifierValueToEfiScanCodeConvertionTable[] = {
+  SCAN_NULL,       // EFI_NULL_MODIFIER
+  SCAN_NULL,       // EFI_LEFT_CONTROL_MODIFIER
+  SCAN_NULL,       // EFI_RIGHT_CONTROL_MODIFIER
+  SCAN_NULL,       // EFI_LEFT_ALT_MODIFIER
+  SCAN_NULL,       // EFI_RIGHT_ALT_MODIFIER
+  SCAN_NULL,       // EFI_ALT_GR_MODIFIER
+  SCAN_INSERT,     // EFI_INSERT_MODIFIER
+  SCAN_DELETE,     // EFI_DELETE_MODIFIER
+  SCAN_PAGE_DOWN,  // EFI_PAGE_DOWN_MODIFIER
+  SCAN_PAGE_UP,    // EFI_PAGE_UP_MODIFIER
+  SCAN_HOME,       // EFI_HOME_MODIFIER
+  SCAN_END,        // EFI_END_MODIFIER
+  SCAN_NULL,       // EFI_LEFT_SHIFT_MODIFIER
+  SCAN_NULL,       // EFI_RIGHT_SHIFT_MODIFIER
+  SCAN_NULL,       // EFI_CAPS_LOCK_MODIFIER
+  SCAN_NULL,       // EFI_NUM_LOCK_MODIFIER
+  SCAN_LEFT,       // EFI_LEFT_ARROW_MODIFIER
+  SCAN_RIGHT,      // EFI_RIGHT_ARROW_MODIFIER
+  SCAN_DOWN,       // EFI_DOWN_ARROW_MODIFIER
+  SCAN_UP,         // EFI_UP_ARROW_MODIFIER
+  SCAN_NULL,       // EFI_NS_KEY_MODIFIER
+  SCAN_NULL,       // EFI_NS_KEY_DEPENDENCY_MODIFIER
+  SCAN_F1,         // EFI_FUNCTION_KEY_ONE_MODIFIER
+  SCAN_F2,         // EFI_FUNCTION_KEY_TWO_MODIFIER
+  SCAN_F3,         // EFI_FUNCTION_KEY_THREE_MODIFIER
+  SCAN_F4,         // EFI_FUNCTION_KEY_FOUR_MODIFIER
+  SCAN_F5,         // EFI_FUNCTION_KEY_FIVE_MODIFIER
+  SCAN_F6,         // EFI_FUNCTION_KEY_SIX_MODIFIER
+  SCAN_F7,         // EFI_FUNCTION_KEY_SEVEN_MODIFIER
+  SCAN_F8,         // EFI_FUNCTION_KEY_EIGHT_MODIFIER
+  SCAN_F9,         // EFI_FUNCTION_KEY_NINE_MODIFIER
+  SCAN_F10,        // EFI_FUNCTION_KEY_TEN_MODIFIER
+  SCAN_F11,        // EFI_FUNCTION_KEY_ELEVEN_MODIFIER
+  SCAN_F12,        // EFI_FUNCTION_KEY_TWELVE_MODIFIER
+  //
+  // For Partial Keystroke support
+  //
+  SCAN_NULL,       // EFI_PRINT_MODIFIER
+  SCAN_NULL,       // EFI_SYS_REQUEST_MODIFIER
+  SCAN_NULL,       // EFI_SCROLL_LOCK_MODIFIER
+  SCAN_PAUSE,      // EFI_PAUSE_MODIFIER
+  SCAN_NULL,       // EFI_BREAK_MODIFIER
+  SCAN_NULL,       // EFI_LEFT_LOGO_MODIFIER
+  SCAN_NULL,       // EFI_RIGHT_LOGO_MODIFER
+  SCAN_NULL,       // EFI_MENU_MODIFER
+};
+
+/**
+  Check whether a HID keycode has a key entry, i.e. lies in the range
+  [0x4, 0x65] or [0xe0, 0xe7].
+
+  @param  KeyCode  HID keycode.
+
+  @retval TRUE     The keycode can be translated.
+  @retval FALSE    The keycode is reserved or out of range.
+
+**/
+STATIC
+BOOLEAN
+IsTranslatableKeyCode (
+  IN UINTN  KeyCode
+  )
+{
+  return (BOOLEAN)(((KeyCode >= 0x04) && (KeyCode <= 0x65)) || ((KeyCode >= 0xe0) && (KeyCode <= 0xe7)));
+}
+
+/**
+  Compile one key descriptor into a key entry, translating it in every
+  combination of Shift, AltGr, Caps Lock and Num Lock.
+
+  @param  Entry          The key entry to fill in.
+  @param  KeyDescriptor  The key descriptor, aligned.
+
+**/
+STATIC
+VOID
+CompileKeyEntry (
+  OUT HID_KB_KEY_ENTRY          *Entry,
+  IN  CONST EFI_KEY_DESCRIPTOR  *KeyDescriptor
+  )
+{
+  UINTN          State;
+  EFI_INPUT_KEY  *Key;
+
+  ZeroMem (Entry, sizeof (*Entry));
+  CopyMem (&Entry->Descriptor, KeyDescriptor, sizeof (EFI_KEY_DESCRIPTOR));
+
+  //
+  // Make sure modifier of Key Descriptor is in the valid range according to UEFI spec.
+  //
+  if (KeyDescriptor->Modifier >= ARRAY_SIZE (ModifierValueToEfiScanCodeConvertionTable)) {
+    Entry->Flags |= HID_KB_KEY_BAD_MODIFIER;
+    return;
+  }
+
+  //
+  // A class of printable characters that are normally adjusted by shift
+  // modifiers, e.g. Shift Key + 'f' key = 'F', need not report the shift state.
+  //
+  if (((KeyDescriptor->AffectedAttribute & EFI_AFFECTED_BY_STANDARD_SHIFT) != 0) &&
+      (KeyDescriptor->Unicode != CHAR_NULL) && (KeyDescriptor->ShiftedUnicode != CHAR_NULL) &&
+      (KeyDescriptor->Unicode != KeyDescriptor->ShiftedUnicode))
+  {
+    Entry->Flags |= HID_KB_KEY_SHIFT_ADJUSTED;
+  }
+
+  for (State = 0; State < HID_KB_STATE_COUNT; State++) {
+    Key              = &Entry->Key[State];
+    Key->ScanCode    = ModifierValueToEfiScanCodeConvertionTable[KeyDescriptor->Modifier];
+    Key->UnicodeChar = KeyDescriptor->Unicode;
+
+    if ((KeyDescriptor->AffectedAttribute & EFI_AFFECTED_BY_STANDARD_SHIFT) != 0) {
+      if ((State & HID_KB_STATE_SHIFT) != 0) {
+        Key->UnicodeChar = KeyDescriptor->ShiftedUnicode;
+        if ((State & HID_KB_STATE_ALT_GR) != 0) {
+          Key->UnicodeChar = KeyDescriptor->ShiftedAltGrUnicode;
+        }
+      } else if ((State & HID_KB_STATE_ALT_GR) != 0) {
+        Key->UnicodeChar = KeyDescriptor->AltGrUnicode;
+      }
+    }
+
+    if (((KeyDescriptor->AffectedAttribute & EFI_AFFECTED_BY_CAPS_LOCK) != 0) && ((State & HID_KB_STATE_CAPS_LOCK) != 0)) {
+      if (Key->UnicodeChar == KeyDescriptor->Unicode) {
+        Key->UnicodeChar = KeyDescriptor->ShiftedUnicode;
+      } else if (Key->UnicodeChar == KeyDescriptor->ShiftedUnicode) {
+        Key->UnicodeChar = KeyDescriptor->Unicode;
+      }
+    }
+
+    if ((KeyDescriptor->AffectedAttribute & EFI_AFFECTED_BY_NUM_LOCK) != 0) {
+      //
+      // For key affected by NumLock, if NumLock is on and Shift is not pressed, then it means
+      // normal key, instead of original control key. So the ScanCode should be cleaned.
+      // Otherwise, it means control key, so preserve the EFI Scan Code and clear the unicode keycode.
+      //
+      if (((State & HID_KB_STATE_NUM_LOCK) != 0) && ((State & HID_KB_STATE_SHIFT) == 0)) {
+        Key->ScanCode = SCAN_NULL;
+      } else {
+        Key->UnicodeChar = CHAR_NULL;
+      }
+    }
+
+    //
+    // Translate Unicode 0x1B (ESC) to EFI Scan Code
+    //
+    if ((Key->UnicodeChar == 0x1B) && (Key->ScanCode == SCAN_NULL)) {
+      Key->ScanCode    = SCAN_ESC;
+      Key->UnicodeChar = CHAR_NULL;
+    }
+  }
+}
+
+/**
+  Compile a keyboard layout into a key table.
+
+  @param  Layout  - the keyboard layout, as returned by EFI_HII_DATABASE_PROTOCOL.GetKeyboardLayout.
+  @param  Table   - returns the key table, free it with HidKbFreeKeyTable.
+
+  @retval EFI_SUCCESS           - the key table was compiled.
+  @retval EFI_INVALID_PARAMETER - a pointer is NULL.
+  @retval EFI_COMPROMISED_DATA  - the layout is truncated or maps a key to no HID keycode.
+  @retval EFI_OUT_OF_RESOURCES  - the key table could not be allocated.
+**/
+EFI_STATUS
+HidKbCompileKeyTable (
+  IN  CONST EFI_HII_KEYBOARD_LAYOUT  *Layout,
+  OUT HID_KB_KEY_TABLE               **Table
+  )
+{
+  CONST EFI_KEY_DESCRIPTOR  *Descriptors;
+  EFI_KEY_DESCRIPTOR        TempKey;
+  HID_KB_KEY_TABLE          *KeyTable;
+  HID_KB_KEY_ENTRY          *Entry;
+  HID_KB_KEY_ENTRY          *Child;
+  UINT16                    *NsKeyEntry;
+  UINTN                     DescriptorCount;
+  UINTN                     NsKeyCount;
+  UINTN                     Index;
+  UINTN                     Index2;
+  UINTN                     KeyCode;
+  UINT8                     EfiKey;
+
+  if ((Layout == NULL) || (Table == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Table          = NULL;
+  DescriptorCount = Layout->DescriptorCount;
+  if (Layout->LayoutLength < sizeof (EFI_HII_KEYBOARD_LAYOUT) + DescriptorCount * sizeof (EFI_KEY_DESCRIPTOR)) {
+    DEBUG ((DEBUG_ERROR, "[%a] - Layout of %u bytes cannot hold %u key descriptors\n", __FUNCTION__, (UINT32)Layout->LayoutLength, (UINT32)DescriptorCount));
+    return EFI_COMPROMISED_DATA;
+  }
+
+  //
+  // The descriptors follow the header unaligned. Count the non-spacing keys
+  // that have a physical key table of their own.
+  //
+  Descriptors = (CONST EFI_KEY_DESCRIPTOR *)((CONST UINT8 *)Layout + sizeof (EFI_HII_KEYBOARD_LAYOUT));
+  NsKeyCount  = 0;
+  for (Index = 0; Index < DescriptorCount; Index++) {
+    CopyMem (&TempKey, &Descriptors[Index], sizeof (EFI_KEY_DESCRIPTOR));
+    if (TempKey.Modifier == EFI_NS_KEY_MODIFIER) {
+      NsKeyCount++;
+    }
+  }
+
+  //
+  // One allocation: the table, the blank entry plus one entry per
+  // descriptor, then 256 physical key entries per non-spacing key.
+  //
+  KeyTable = AllocateZeroPool (
+               sizeof (HID_KB_KEY_TABLE) +
+               (DescriptorCount + 1) * sizeof (HID_KB_KEY_ENTRY) +
+               NsKeyCount * ARRAY_SIZE (KeyTable->KeyEntry) * sizeof (UINT16)
+               );
+  if (KeyTable == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  KeyTable->Entries    = (HID_KB_KEY_ENTRY *)(KeyTable + 1);
+  KeyTable->NsKeyEntry = (UINT16 *)(KeyTable->Entries + DescriptorCount + 1);
+  KeyTable->EntryCount = 1;
+  KeyTable->NsKeyCount = 0;
+
+  ZeroMem (&TempKey, sizeof (TempKey));
+  CompileKeyEntry (&KeyTable->Entries[0], &TempKey);
+  for (KeyCode = 0; KeyCode < ARRAY_SIZE (KeyTable->KeyEntry); KeyCode++) {
+    KeyTable->KeyEntry[KeyCode] = IsTranslatableKeyCode (KeyCode) ? 0 : HID_KB_NO_KEY_ENTRY;
+  }
+
+  for (Index = 0; Index < DescriptorCount; Index++) {
+    CopyMem (&TempKey, &Descriptors[Index], sizeof (EFI_KEY_DESCRIPTOR));
+
+    //
+    // Fill the key into the keycode table, whose index is the HID keycode.
+    //
+    EfiKey = (UINT8)TempKey.Key;
+    if (((UINTN)TempKey.Key >= ARRAY_SIZE (EfiKeyToHidKeyCodeConvertionTable)) ||
+        (KeyTable->KeyEntry[EfiKeyToHidKeyCodeConvertionTable[EfiKey]] == HID_KB_NO_KEY_ENTRY))
+    {
+      DEBUG ((DEBUG_ERROR, "[%a] - Key descriptor %u has no HID keycode\n", __FUNCTION__, (UINT32)Index));
+      FreePool (KeyTable);
+      return EFI_COMPROMISED_DATA;
+    }
+
+    Entry = &KeyTable->Entries[KeyTable->EntryCount];
+    CompileKeyEntry (Entry, &TempKey);
+    KeyTable->KeyEntry[EfiKeyToHidKeyCodeConvertionTable[EfiKey]] = (UINT16)KeyTable->EntryCount;
+    KeyTable->EntryCount++;
+
+    //
+    // A non-spacing key is followed by the physical keys that can come after
+    // it. They only get entries, the keycode table keeps the plain keys.
+    //
+    if (TempKey.Modifier == EFI_NS_KEY_MODIFIER) {
+      KeyTable->NsKeyCount++;
+      Entry->NsKey = (UINT16)KeyTable->NsKeyCount;
+      for (Index2 = Index + 1; Index2 < DescriptorCount; Index2++) {
+        CopyMem (&TempKey, &Descriptors[Index2], sizeof (EFI_KEY_DESCRIPTOR));
+        if (TempKey.Modifier != EFI_NS_KEY_DEPENDENCY_MODIFIER) {
+          break;
+        }
+
+        CompileKeyEntry (&KeyTable->Entries[KeyTable->EntryCount], &TempKey);
+        KeyTable->EntryCount++;
+      }
+
+      Index = Index2 - 1;
+    }
+  }
+
+  //
+  // There are two EfiKeyEnter, duplicate its key entry
+  //
+  KeyTable->KeyEntry[0x58] = KeyTable->KeyEntry[0x28];
+
+  //
+  // Point every keycode whose key has a definition after a non-spacing key
+  // at that definition. The first definition of a key wins.
+  //
+  for (Index = 1; Index < KeyTable->EntryCount; Index++) {
+    Entry = &KeyTable->Entries[Index];
+    if (Entry->NsKey == 0) {
+      continue;
+    }
+
+    NsKeyEntry = &KeyTable->NsKeyEntry[(Entry->NsKey - 1) * ARRAY_SIZE (KeyTable->KeyEntry)];
+    for (Index2 = Index + 1; Index2 < KeyTable->EntryCount; Index2++) {
+      Child = &KeyTable->Entries[Index2];
+      if (Child->Descriptor.Modifier != EFI_NS_KEY_DEPENDENCY_MODIFIER) {
+        break;
+      }
+
+      for (KeyCode = 0; KeyCode < ARRAY_SIZE (KeyTable->KeyEntry); KeyCode++) {
+        if ((KeyTable->KeyEntry[KeyCode] != HID_KB_NO_KEY_ENTRY) && (NsKeyEntry[KeyCode] == 0) &&
+            (KeyTable->Entries[KeyTable->KeyEntry[KeyCode]].Descriptor.Key == Child->Descriptor.Key))
+        {
+          NsKeyEntry[KeyCode] = (UINT16)Index2;
+        }
+      }
+    }
+  }
+
+  *Table = KeyTable;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free a key table returned by HidKbCompileKeyTable.
+
+  @param  Table - the key table, may be NULL.
+**/
+VOID
+HidKbFreeKeyTable (
+  IN HID_KB_KEY_TABLE  *Table
+  )
+{
+  if (Table != NULL) {
+    FreePool (Table);
+  }
+}
+
+/**
+  Look up the key entry of a HID keycode.
+
+  @param  Table    - the key table, may be NULL.
+  @param  NsKey    - the NsKey of the non-spacing key pressed before, or 0.
+  @param  KeyCode  - HID keycode.
+
+  @return The key entry, the physical key definition following NsKey if there is one.
+          NULL if there is no table or KeyCode is not a valid keycode.
+**/
+CONST HID_KB_KEY_ENTRY *
+HidKbLookupKey (
+  IN CONST HID_KB_KEY_TABLE  *Table,
+  IN UINT16                  NsKey,
+  IN UINT8                   KeyCode
+  )
+{
+  UINT16  Index;
+  UINT16  PhysicalKey;
+
+  if (Table == NULL) {
+    return NULL;
+  }
+
+  Index = Table->KeyEntry[KeyCode];
+  if (Index == HID_KB_NO_KEY_ENTRY) {
+    return NULL;
+  }
+
+  if ((NsKey != 0) && (NsKey <= Table->NsKeyCount)) {
+    PhysicalKey = Table->NsKeyEntry[(NsKey - 1) * ARRAY_SIZE (Table->KeyEntry) + KeyCode];
+    if (PhysicalKey != 0) {
+      Index = PhysicalKey;
+    }
+  }
+
+  return &Table->Entries[Index];
+}
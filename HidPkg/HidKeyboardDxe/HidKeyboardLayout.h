@@ -0,0 +1,144 @@
+/** @file HidKeyboardLayout.h
+
+  Compiles an HII keyboard layout into flat key translation tables.
+
+  Every HID keycode indexes straight into a table of key entries, and every
+  entry holds the EFI_INPUT_KEY it produces in each combination of Shift,
+  AltGr, Caps Lock and Num Lock. Each non-spacing (dead) key gets its own
+  keycode indexed table of the physical keys that follow it, so translating a
+  keystroke never walks a list or allocates.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+
+  Portions derived from UsbKbDxe:
+  Copyright (c) 2004 - 2018, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _HID_KEYBOARD_LAYOUT_H_
+#define _HID_KEYBOARD_LAYOUT_H_
+
+#include <Uefi.h>
+#include <Uefi/UefiInternalFormRepresentation.h>
+#include <Protocol/SimpleTextIn.h>
+
+#define HID_KEYBOARD_KEY_COUNT  105
+
+#define HID_KEYBOARD_LANGUAGE_STR_LEN     5         // RFC4646 Language Code: "en-US"
+#define HID_KEYBOARD_DESCRIPTION_STR_LEN  (16 + 1)  // Description: "English Keyboard"
+
+#pragma pack (1)
+typedef struct {
+  //
+  // This 4-bytes total array length is required by PreparePackageList()
+  //
+  UINT32                    Length;
+
+  //
+  // Keyboard Layout package definition
+  //
+  EFI_HII_PACKAGE_HEADER    PackageHeader;
+  UINT16                    LayoutCount;
+
+  //
+  // EFI_HII_KEYBOARD_LAYOUT
+  //
+  UINT16                    LayoutLength;
+  EFI_GUID                  Guid;
+  UINT32                    LayoutDescriptorStringOffset;
+  UINT8                     DescriptorCount;
+  EFI_KEY_DESCRIPTOR        KeyDescriptor[HID_KEYBOARD_KEY_COUNT];
+  UINT16                    DescriptionCount;
+  CHAR16                    Language[HID_KEYBOARD_LANGUAGE_STR_LEN];
+  CHAR16                    Space;
+  CHAR16                    DescriptionString[HID_KEYBOARD_DESCRIPTION_STR_LEN];
+} HID_KEYBOARD_LAYOUT_PACK_BIN;
+#pragma pack()
+
+//
+// The default (en-US) keyboard layout package.
+//
+extern HID_KEYBOARD_LAYOUT_PACK_BIN  mHidKeyboardLayoutBin;
+
+//
+// Lock and shift state a keystroke is translated in, the index into
+// HID_KB_KEY_ENTRY.Key.
+//
+#define HID_KB_STATE_SHIFT      BIT0
+#define HID_KB_STATE_ALT_GR     BIT1
+#define HID_KB_STATE_CAPS_LOCK  BIT2
+#define HID_KB_STATE_NUM_LOCK   BIT3
+#define HID_KB_STATE_COUNT      16
+
+//
+// HID_KB_KEY_TABLE.KeyEntry of a keycode outside [0x04, 0x65] and [0xE0, 0xE7].
+//
+#define HID_KB_NO_KEY_ENTRY  0xFFFF
+
+//
+// HID_KB_KEY_ENTRY.Flags
+//
+#define HID_KB_KEY_SHIFT_ADJUSTED  BIT0     // A printable key whose character already reflects Shift
+#define HID_KB_KEY_BAD_MODIFIER    BIT1     // Modifier is outside the range defined by the UEFI spec
+
+typedef struct {
+  EFI_KEY_DESCRIPTOR    Descriptor;
+  UINT16                NsKey;                      // Non-spacing keys: 1-based index of their physical key table
+  UINT16                Flags;
+  EFI_INPUT_KEY         Key[HID_KB_STATE_COUNT];
+} HID_KB_KEY_ENTRY;
+
+typedef struct {
+  UINTN               EntryCount;
+  HID_KB_KEY_ENTRY    *Entries;                     // Entries[0] is the key of a keycode the layout leaves out
+  UINTN               NsKeyCount;
+  UINT16              *NsKeyEntry;                  // NsKeyCount tables of 256 entries, 0 if the key has no definition after that NS key
+  UINT16              KeyEntry[256];                // Indexed by HID keycode
+} HID_KB_KEY_TABLE;
+
+/**
+  Compile a keyboard layout into a key table.
+
+  @param  Layout  - the keyboard layout, as returned by EFI_HII_DATABASE_PROTOCOL.GetKeyboardLayout.
+  @param  Table   - returns the key table, free it with HidKbFreeKeyTable.
+
+  @retval EFI_SUCCESS           - the key table was compiled.
+  @retval EFI_INVALID_PARAMETER - a pointer is NULL.
+  @retval EFI_COMPROMISED_DATA  - the layout is truncated or maps a key to no HID keycode.
+  @retval EFI_OUT_OF_RESOURCES  - the key table could not be allocated.
+**/
+EFI_STATUS
+HidKbCompileKeyTable (
+  IN  CONST EFI_HII_KEYBOARD_LAYOUT  *Layout,
+  OUT HID_KB_KEY_TABLE               **Table
+  );
+
+/**
+  Free a key table returned by HidKbCompileKeyTable.
+
+  @param  Table - the key table, may be NULL.
+**/
+VOID
+HidKbFreeKeyTable (
+  IN HID_KB_KEY_TABLE  *Table
+  );
+
+/**
+  Look up the key entry of a HID keycode.
+
+  @param  Table    - the key table, may be NULL.
+  @param  NsKey    - the NsKey of the non-spacing key pressed before, or 0.
+  @param  KeyCode  - HID keycode.
+
+  @return The key entry, the physical key definition following NsKey if there is one.
+          NULL if there is no table or KeyCode is not a valid keycode.
+**/
+CONST HID_KB_KEY_ENTRY *
+HidKbLookupKey (
+  IN CONST HID_KB_KEY_TABLE  *Table,
+  IN UINT16                  NsKey,
+  IN UINT8                   KeyCode
+  );
+
+#endif // _HID_KEYBOARD_LAYOUT_H_
@@ -0,0 +1,520 @@
+/** @file HidKeyboardReport.c
+
+  Translates keyboard HID reports into a bitmap of pressed keys.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/HidReportDescriptorLib.h>
+
+#include "HidKeyboardReport.h"
+
+#define KEY_BIT_SET(Bitmap, Usage)  ((Bitmap)->Bits[(Usage) >> 5] |= (1u << ((Usage) & 0x1F)))
+#define KEY_BIT_GET(Bitmap, Usage)  (((Bitmap)->Bits[(Usage) >> 5] & (1u << ((Usage) & 0x1F))) != 0)
+
+//
+// 0x00 is no key, 0x01 - 0x03 are keyboard errors.
+//
+#define IS_KEY_USAGE(Usage)  ((Usage) > 0x03)
+
+/**
+  Check whether a field reports keys.
+
+  @param  Field - the report field.
+
+  @retval TRUE  - the field is an input on the keyboard page this driver can read.
+  @retval FALSE - the field is ignored.
+**/
+STATIC
+BOOLEAN
+IsKeyboardField (
+  IN CONST HID_REPORT_FIELD  *Field
+  )
+{
+  if ((Field->ReportType != HidReportInput) ||
+      (HID_USAGE_PAGE (Field->UsageMinimum) != HID_KB_USAGE_PAGE) ||
+      (HID_USAGE_PAGE (Field->UsageMaximum) != HID_KB_USAGE_PAGE) ||
+      (Field->UsageMinimum > Field->UsageMaximum))
+  {
+    return FALSE;
+  }
+
+  //
+  // Array elements are indices, wider than 16 bits cannot address the page.
+  //
+  if (((Field->Flags & HID_MAIN_ITEM_VARIABLE) == 0) && (Field->BitSize > 16)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Mark the keys a field reports on.
+
+  @param  Field - the keyboard field.
+  @param  Cover - the bitmap to update.
+**/
+STATIC
+VOID
+AddFieldCover (
+  IN     CONST HID_REPORT_FIELD  *Field,
+  IN OUT HID_KB_KEY_BITMAP       *Cover
+  )
+{
+  UINT32  Usage;
+  UINT32  Last;
+
+  Usage = HID_USAGE_ID (Field->UsageMinimum);
+  Last  = HID_USAGE_ID (Field->UsageMaximum);
+  if ((Field->Flags & HID_MAIN_ITEM_VARIABLE) != 0) {
+    Last = MIN (Last, Usage + Field->Count - 1);
+  }
+
+  for ( ; Usage <= MIN (Last, MAX_UINT8); Usage++) {
+    KEY_BIT_SET (Cover, Usage);
+  }
+}
+
+/**
+  Compile the keyboard input fields of a report descriptor into a report map.
+
+  @param  Descriptor      - the report descriptor.
+  @param  DescriptorSize  - size of the report descriptor in bytes.
+  @param  Map             - returns the report map, free it with HidKbFreeReportMap.
+
+  @retval EFI_SUCCESS           - the report map was compiled.
+  @retval EFI_INVALID_PARAMETER - a pointer is NULL.
+  @retval EFI_UNSUPPORTED       - the descriptor has no keyboard input fields.
+  @retval EFI_OUT_OF_RESOURCES  - the report map could not be allocated.
+  @retval other                 - the descriptor could not be parsed.
+**/
+EFI_STATUS
+HidKbCompileReportMap (
+  IN  CONST UINT8        *Descriptor,
+  IN  UINTN              DescriptorSize,
+  OUT HID_KB_REPORT_MAP  **Map
+  )
+{
+  EFI_STATUS           Status;
+  HID_REPORT_LAYOUT    *Layout;
+  HID_KB_REPORT_MAP    *NewMap;
+  HID_KB_REPORT_GROUP  *Group;
+  HID_REPORT_FIELD     *Field;
+  UINTN                FieldCount;
+  UINTN                GroupCount;
+  UINTN                Index;
+  UINTN                GroupIndex;
+  UINT32               EndBit;
+
+  if ((Descriptor == NULL) || (Map == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Map = NULL;
+
+  Status = HidParseReportDescriptor (Descriptor, DescriptorSize, &Layout);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "[%a] - Failed to parse report descriptor: %r\n", __FUNCTION__, Status));
+    return Status;
+  }
+
+  NewMap = AllocateZeroPool (sizeof (*NewMap));
+  if (NewMap == NULL) {
+    HidFreeReportLayout (Layout);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SetMem (NewMap->GroupByReportId, sizeof (NewMap->GroupByReportId), HID_KB_NO_REPORT_GROUP);
+
+  //
+  // Number the groups in the order their report IDs first appear.
+  //
+  FieldCount = 0;
+  GroupCount = 0;
+  for (Index = 0; Index < Layout->FieldCount; Index++) {
+    Field = &Layout->Fields[Index];
+    if (!IsKeyboardField (Field)) {
+      continue;
+    }
+
+    if (NewMap->GroupByReportId[Field->ReportId] == HID_KB_NO_REPORT_GROUP) {
+      if (GroupCount == HID_KB_NO_REPORT_GROUP) {
+        continue;
+      }
+
+      NewMap->GroupByReportId[Field->ReportId] = (UINT8)GroupCount++;
+    }
+
+    FieldCount++;
+  }
+
+  if (FieldCount == 0) {
+    DEBUG ((DEBUG_WARN, "[%a] - Report descriptor has no keyboard input fields.\n", __FUNCTION__));
+    FreePool (NewMap);
+    HidFreeReportLayout (Layout);
+    return EFI_UNSUPPORTED;
+  }
+
+  NewMap->Groups = AllocateZeroPool (GroupCount * sizeof (HID_KB_REPORT_GROUP));
+  NewMap->Fields = AllocatePool (FieldCount * sizeof (HID_REPORT_FIELD));
+  if ((NewMap->Groups == NULL) || (NewMap->Fields == NULL)) {
+    HidKbFreeReportMap (NewMap);
+    HidFreeReportLayout (Layout);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewMap->GroupCount    = GroupCount;
+  NewMap->ReportIdsUsed = Layout->ReportIdsUsed;
+
+  FieldCount = 0;
+  for (GroupIndex = 0; GroupIndex < GroupCount; GroupIndex++) {
+    Group             = &NewMap->Groups[GroupIndex];
+    Group->FirstField = (UINT32)FieldCount;
+    for (Index = 0; Index < Layout->FieldCount; Index++) {
+      Field = &Layout->Fields[Index];
+      if (!IsKeyboardField (Field) || (NewMap->GroupByReportId[Field->ReportId] != GroupIndex)) {
+        continue;
+      }
+
+      CopyMem (&NewMap->Fields[FieldCount++], Field, sizeof (*Field));
+      Group->ReportId = Field->ReportId;
+      EndBit          = Field->BitOffset + (UINT32)Field->Count * Field->BitSize;
+      if ((EndBit + 7) / 8 > Group->MinReportSize) {
+        Group->MinReportSize = (UINT16)((EndBit + 7) / 8);
+      }
+
+      AddFieldCover (Field, &Group->Cover);
+    }
+
+    Group->FieldCount = (UINT32)(FieldCount - Group->FirstField);
+  }
+
+  HidFreeReportLayout (Layout);
+  *Map = NewMap;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free a report map returned by HidKbCompileReportMap.
+
+  @param  Map - the report map, may be NULL.
+**/
+VOID
+HidKbFreeReportMap (
+  IN HID_KB_REPORT_MAP  *Map
+  )
+{
+  if (Map == NULL) {
+    return;
+  }
+
+  if (Map->Groups != NULL) {
+    FreePool (Map->Groups);
+  }
+
+  if (Map->Fields != NULL) {
+    FreePool (Map->Fields);
+  }
+
+  FreePool (Map);
+}
+
+/**
+  Add the keys one field reports as pressed to a bitmap.
+
+  @param  Field       - the keyboard field.
+  @param  Report      - the input report.
+  @param  ReportSize  - size of the report in bytes, holds the whole field.
+  @param  Keys        - the bitmap to update.
+
+  @retval EFI_SUCCESS   - Keys was updated.
+  @retval EFI_NOT_READY - the field reports a rollover error.
+**/
+STATIC
+EFI_STATUS
+AddFieldKeys (
+  IN     CONST HID_REPORT_FIELD  *Field,
+  IN     CONST UINT8             *Report,
+  IN     UINTN                   ReportSize,
+  IN OUT HID_KB_KEY_BITMAP       *Keys
+  )
+{
+  UINT32  Bit;
+  UINT32  Usage;
+  UINT32  Value;
+  INT32   Signed;
+  UINTN   Index;
+
+  Usage = HID_USAGE_ID (Field->UsageMinimum);
+
+  if ((Field->Flags & HID_MAIN_ITEM_VARIABLE) != 0) {
+    //
+    // Bitmap: element N is the state of usage UsageMinimum + N.
+    //
+    for (Index = 0; Index < Field->Count; Index++, Usage++) {
+      if (Field->BitSize == 1) {
+        Bit   = Field->BitOffset + (UINT32)Index;
+        Value = (Report[Bit >> 3] >> (Bit & 0x7)) & 1;
+      } else {
+        HidGetReportFieldValue (Field, Report, ReportSize, Index, &Value);
+      }
+
+      if ((Value == 0) || (Usage > HID_USAGE_ID (Field->UsageMaximum)) || (Usage > MAX_UINT8)) {
+        continue;
+      }
+
+      if (Usage == HID_KB_USAGE_ERROR_ROLLOVER) {
+        return EFI_NOT_READY;
+      }
+
+      if (IS_KEY_USAGE (Usage)) {
+        KEY_BIT_SET (Keys, Usage);
+      }
+    }
+
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Array: every element holds the index of one pressed key.
+  //
+  for (Index = 0; Index < Field->Count; Index++) {
+    HidGetReportFieldValue (Field, Report, ReportSize, Index, &Value);
+    Signed = HidSignExtendFieldValue (Field, Value);
+    if ((Signed < Field->LogicalMinimum) || (Signed > Field->LogicalMaximum)) {
+      continue;
+    }
+
+    Usage = HID_USAGE_ID (Field->UsageMinimum) + (UINT32)(Signed - Field->LogicalMinimum);
+    if ((Usage > HID_USAGE_ID (Field->UsageMaximum)) || (Usage > MAX_UINT8)) {
+      continue;
+    }
+
+    if (Usage == HID_KB_USAGE_ERROR_ROLLOVER) {
+      return EFI_NOT_READY;
+    }
+
+    if (IS_KEY_USAGE (Usage)) {
+      KEY_BIT_SET (Keys, Usage);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Translate a report protocol keyboard report into the bitmap of pressed keys.
+
+  Keys that the report does not cover keep the state they have in Current.
+
+  @param  Map         - the report map of the keyboard.
+  @param  Report      - the input report, starting with the report ID if IDs are used.
+  @param  ReportSize  - size of the report in bytes.
+  @param  Current     - the keys pressed before this report.
+  @param  Next        - returns the keys pressed after this report.
+
+  @retval EFI_SUCCESS           - Next was updated.
+  @retval EFI_NOT_FOUND         - the report ID has no keyboard fields.
+  @retval EFI_BUFFER_TOO_SMALL  - the report is shorter than its fields.
+  @retval EFI_NOT_READY         - the keyboard reported a rollover error, Next is unchanged.
+**/
+EFI_STATUS
+HidKbReportToBitmap (
+  IN  CONST HID_KB_REPORT_MAP  *Map,
+  IN  CONST UINT8              *Report,
+  IN  UINTN                    ReportSize,
+  IN  CONST HID_KB_KEY_BITMAP  *Current,
+  OUT HID_KB_KEY_BITMAP        *Next
+  )
+{
+  EFI_STATUS                 Status;
+  CONST HID_KB_REPORT_GROUP  *Group;
+  HID_KB_KEY_BITMAP          Keys;
+  UINT8                      ReportId;
+  UINTN                      Index;
+
+  ASSERT ((Map != NULL) && (Report != NULL) && (Current != NULL) && (Next != NULL));
+
+  ReportId = 0;
+  if (Map->ReportIdsUsed) {
+    if (ReportSize == 0) {
+      return EFI_BUFFER_TOO_SMALL;
+    }
+
+    ReportId = Report[0];
+  }
+
+  if (Map->GroupByReportId[ReportId] == HID_KB_NO_REPORT_GROUP) {
+    return EFI_NOT_FOUND;
+  }
+
+  Group = &Map->Groups[Map->GroupByReportId[ReportId]];
+  if (ReportSize < Group->MinReportSize) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  ZeroMem (&Keys, sizeof (Keys));
+  for (Index = 0; Index < Group->FieldCount; Index++) {
+    Status = AddFieldKeys (&Map->Fields[Group->FirstField + Index], Report, ReportSize, &Keys);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (Keys.Bits); Index++) {
+    Next->Bits[Index] = (Current->Bits[Index] & ~Group->Cover.Bits[Index]) | Keys.Bits[Index];
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Translate a boot keyboard report into the bitmap of pressed keys.
+
+  The report may carry more or fewer than six keycodes, see KEYBOARD_HID_INPUT_BUFFER.
+
+  @param  Report      - the boot keyboard report.
+  @param  ReportSize  - size of the report in bytes.
+  @param  Next        - returns the keys pressed after this report.
+
+  @retval EFI_SUCCESS           - Next was updated.
+  @retval EFI_BUFFER_TOO_SMALL  - the report has no modifier byte.
+  @retval EFI_NOT_READY         - the keyboard reported a rollover error, Next is unchanged.
+**/
+EFI_STATUS
+HidKbBootReportToBitmap (
+  IN  CONST UINT8        *Report,
+  IN  UINTN              ReportSize,
+  OUT HID_KB_KEY_BITMAP  *Next
+  )
+{
+  HID_KB_KEY_BITMAP  Keys;
+  UINTN              Index;
+
+  ASSERT ((Report != NULL) && (Next != NULL));
+
+  //
+  // Byte 0 holds the modifiers, byte 1 is reserved and the rest are keycodes.
+  //
+  if (ReportSize < 2) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  ZeroMem (&Keys, sizeof (Keys));
+  Keys.Bits[HID_KB_USAGE_LEFT_CONTROL >> 5] = (UINT32)Report[0] << (HID_KB_USAGE_LEFT_CONTROL & 0x1F);
+  for (Index = 2; Index < ReportSize; Index++) {
+    if (Report[Index] == HID_KB_USAGE_ERROR_ROLLOVER) {
+      return EFI_NOT_READY;
+    }
+
+    if (IS_KEY_USAGE (Report[Index])) {
+      KEY_BIT_SET (&Keys, Report[Index]);
+    }
+  }
+
+  CopyMem (Next, &Keys, sizeof (Keys));
+  return EFI_SUCCESS;
+}
+
+/**
+  Append the keys set in one word of a difference.
+
+  @param  Diff        - the changed keys of the word.
+  @param  Base        - usage of bit 0 of the word.
+  @param  Down        - whether the keys are now pressed.
+  @param  Changes     - the change list.
+  @param  Count       - entries used in the change list, updated.
+  @param  MaxChanges  - number of entries in the change list.
+**/
+STATIC
+VOID
+AppendChanges (
+  IN     UINT32   Diff,
+  IN     UINT32   Base,
+  IN     BOOLEAN  Down,
+  OUT    HID_KEY  *Changes,
+  IN OUT UINTN    *Count,
+  IN     UINTN    MaxChanges
+  )
+{
+  while ((Diff != 0) && (*Count < MaxChanges)) {
+    Changes[*Count].KeyCode = (UINT8)(Base + (UINT32)LowBitSet32 (Diff));
+    Changes[*Count].Down    = Down;
+    (*Count)++;
+    Diff &= Diff - 1;
+  }
+}
+
+/**
+  List the keys that changed between two bitmaps.
+
+  Modifier keys come first, then released keys, then pressed keys, each in
+  ascending usage order.
+
+  @param  Old         - the keys pressed before.
+  @param  New         - the keys pressed now.
+  @param  Changes     - returns the changed keys.
+  @param  MaxChanges  - number of entries in Changes.
+
+  @return the number of entries written to Changes.
+**/
+UINTN
+HidKbDiffBitmaps (
+  IN  CONST HID_KB_KEY_BITMAP  *Old,
+  IN  CONST HID_KB_KEY_BITMAP  *New,
+  OUT HID_KEY                  *Changes,
+  IN  UINTN                    MaxChanges
+  )
+{
+  UINTN   Count;
+  UINTN   Word;
+  UINT32  Diff;
+  UINT32  ModifierMask;
+  UINT32  Usage;
+
+  ASSERT ((Old != NULL) && (New != NULL) && (Changes != NULL));
+
+  Count = 0;
+
+  //
+  // Modifiers in ascending order, pressed or released.
+  //
+  ModifierMask = (UINT32)0xFF << (HID_KB_USAGE_LEFT_CONTROL & 0x1F);
+  Diff         = (Old->Bits[HID_KB_USAGE_LEFT_CONTROL >> 5] ^ New->Bits[HID_KB_USAGE_LEFT_CONTROL >> 5]) & ModifierMask;
+  while ((Diff != 0) && (Count < MaxChanges)) {
+    Usage                  = (HID_KB_USAGE_LEFT_CONTROL & ~0x1F) + (UINT32)LowBitSet32 (Diff);
+    Changes[Count].KeyCode = (UINT8)Usage;
+    Changes[Count].Down    = KEY_BIT_GET (New, Usage);
+    Count++;
+    Diff &= Diff - 1;
+  }
+
+  for (Word = 0; Word < ARRAY_SIZE (Old->Bits); Word++) {
+    Diff = Old->Bits[Word] & ~New->Bits[Word];
+    if (Word == (HID_KB_USAGE_LEFT_CONTROL >> 5)) {
+      Diff &= ~ModifierMask;
+    }
+
+    AppendChanges (Diff, (UINT32)Word * 32, FALSE, Changes, &Count, MaxChanges);
+  }
+
+  for (Word = 0; Word < ARRAY_SIZE (Old->Bits); Word++) {
+    Diff = New->Bits[Word] & ~Old->Bits[Word];
+    if (Word == (HID_KB_USAGE_LEFT_CONTROL >> 5)) {
+      Diff &= ~ModifierMask;
+    }
+
+    AppendChanges (Diff, (UINT32)Word * 32, TRUE, Changes, &Count, MaxChanges);
+  }
+
+  return Count;
+}
@@ -0,0 +1,163 @@
+/** @file HidKeyboardReport.h
+
+  Translates keyboard HID reports into a bitmap of pressed keys.
+
+  Report protocol keyboards are described by a compiled report map: the input
+  fields on the Keyboard/Keypad usage page grouped by report ID. A report is
+  turned into a bitmap of keyboard page usages and compared against the bitmap
+  of the previous report, so an N-key rollover keyboard with a bitmap report
+  costs the same as a six key array report.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _HID_KEYBOARD_REPORT_H_
+#define _HID_KEYBOARD_REPORT_H_
+
+#include <Uefi.h>
+#include <Library/HidReportDescriptorLib.h>
+
+#define HID_KB_USAGE_PAGE            0x07
+#define HID_KB_USAGE_ERROR_ROLLOVER  0x01
+#define HID_KB_USAGE_LEFT_CONTROL    0xE0
+#define HID_KB_USAGE_RIGHT_GUI       0xE7
+
+#define HID_KB_IS_MODIFIER(Usage)  (((Usage) >= HID_KB_USAGE_LEFT_CONTROL) && ((Usage) <= HID_KB_USAGE_RIGHT_GUI))
+
+//
+// Every keyboard page usage can change at once.
+//
+#define HID_KB_MAX_KEY_CHANGES  256
+
+#define HID_KB_NO_REPORT_GROUP  0xFF
+
+typedef struct {
+  BOOLEAN    Down;
+  UINT8      KeyCode;
+} HID_KEY;
+
+///
+/// One bit per keyboard page usage 0x00 - 0xFF.
+///
+typedef struct {
+  UINT32    Bits[8];
+} HID_KB_KEY_BITMAP;
+
+///
+/// The keyboard fields of one report ID.
+///
+typedef struct {
+  UINT8                ReportId;
+  UINT16               MinReportSize;       // Bytes needed to hold every field of the group
+  UINT32               FirstField;
+  UINT32               FieldCount;
+  HID_KB_KEY_BITMAP    Cover;               // Keys this report reports on, pressed or not
+} HID_KB_REPORT_GROUP;
+
+typedef struct {
+  BOOLEAN                ReportIdsUsed;
+  UINTN                  GroupCount;
+  HID_KB_REPORT_GROUP    *Groups;
+  HID_REPORT_FIELD       *Fields;                    // Ordered by group
+  UINT8                  GroupByReportId[256];       // HID_KB_NO_REPORT_GROUP if not a keyboard report
+} HID_KB_REPORT_MAP;
+
+/**
+  Compile the keyboard input fields of a report descriptor into a report map.
+
+  @param  Descriptor      - the report descriptor.
+  @param  DescriptorSize  - size of the report descriptor in bytes.
+  @param  Map             - returns the report map, free it with HidKbFreeReportMap.
+
+  @retval EFI_SUCCESS           - the report map was compiled.
+  @retval EFI_INVALID_PARAMETER - a pointer is NULL.
+  @retval EFI_UNSUPPORTED       - the descriptor has no keyboard input fields.
+  @retval EFI_OUT_OF_RESOURCES  - the report map could not be allocated.
+  @retval other                 - the descriptor could not be parsed.
+**/
+EFI_STATUS
+HidKbCompileReportMap (
+  IN  CONST UINT8        *Descriptor,
+  IN  UINTN              DescriptorSize,
+  OUT HID_KB_REPORT_MAP  **Map
+  );
+
+/**
+  Free a report map returned by HidKbCompileReportMap.
+
+  @param  Map - the report map, may be NULL.
+**/
+VOID
+HidKbFreeReportMap (
+  IN HID_KB_REPORT_MAP  *Map
+  );
+
+/**
+  Translate a report protocol keyboard report into the bitmap of pressed keys.
+
+  Keys that the report does not cover keep the state they have in Current.
+
+  @param  Map         - the report map of the keyboard.
+  @param  Report      - the input report, starting with the report ID if IDs are used.
+  @param  ReportSize  - size of the report in bytes.
+  @param  Current     - the keys pressed before this report.
+  @param  Next        - returns the keys pressed after this report.
+
+  @retval EFI_SUCCESS           - Next was updated.
+  @retval EFI_NOT_FOUND         - the report ID has no keyboard fields.
+  @retval EFI_BUFFER_TOO_SMALL  - the report is shorter than its fields.
+  @retval EFI_NOT_READY         - the keyboard reported a rollover error, Next is unchanged.
+**/
+EFI_STATUS
+HidKbReportToBitmap (
+  IN  CONST HID_KB_REPORT_MAP  *Map,
+  IN  CONST UINT8              *Report,
+  IN  UINTN                    ReportSize,
+  IN  CONST HID_KB_KEY_BITMAP  *Current,
+  OUT HID_KB_KEY_BITMAP        *Next
+  );
+
+/**
+  Translate a boot keyboard report into the bitmap of pressed keys.
+
+  The report may carry more or fewer than six keycodes, see KEYBOARD_HID_INPUT_BUFFER.
+
+  @param  Report      - the boot keyboard report.
+  @param  ReportSize  - size of the report in bytes.
+  @param  Next        - returns the keys pressed after this report.
+
+  @retval EFI_SUCCESS           - Next was updated.
+  @retval EFI_BUFFER_TOO_SMALL  - the report has no modifier byte.
+  @retval EFI_NOT_READY         - the keyboard reported a rollover error, Next is unchanged.
+**/
+EFI_STATUS
+HidKbBootReportToBitmap (
+  IN  CONST UINT8        *Report,
+  IN  UINTN              ReportSize,
+  OUT HID_KB_KEY_BITMAP  *Next
+  );
+
+/**
+  List the keys that changed between two bitmaps.
+
+  Modifier keys come first, then released keys, then pressed keys, each in
+  ascending usage order.
+
+  @param  Old         - the keys pressed before.
+  @param  New         - the keys pressed now.
+  @param  Changes     - returns the changed keys.
+  @param  MaxChanges  - number of entries in Changes.
+
+  @return the number of entries written to Changes.
+**/
+UINTN
+HidKbDiffBitmaps (
+  IN  CONST HID_KB_KEY_BITMAP  *Old,
+  IN  CONST HID_KB_KEY_BITMAP  *New,
+  OUT HID_KEY                  *Changes,
+  IN  UINTN                    MaxChanges
+  );
+
+#endif // _HID_KEYBOARD_REPORT_H_
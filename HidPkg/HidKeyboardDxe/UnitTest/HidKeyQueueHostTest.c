@@ -0,0 +1,510 @@
+/** @file
+  This module tests the key queue of HidKeyboardDxe, including queue
+  operations interrupted at every step by other queue operations the way
+  events at a higher TPL interrupt them.
+
+  Copyright (c) Microsoft Corporation
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PseudoRandomLib.h>
+#include <Library/UnitTestLib.h>
+#include "../HidKeyQueue.h"
+
+#define UNIT_TEST_NAME     "HID Key Queue Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define STRESS_ITEMS      60000
+#define STRESS_MAX_NEST   3
+
+#define ITEM_FREE      0
+#define ITEM_QUEUED    1
+#define ITEM_DROPPED   2
+#define ITEM_CONSUMED  3
+
+typedef struct {
+  UINT32    Serial;
+  UINT16    Producer;
+  UINT16    Check;
+} TEST_ITEM;
+
+///
+/// State of a stress run. Producer n is the producer at nesting level n, so
+/// one producer never interrupts itself, like an event at a given TPL.
+///
+typedef struct {
+  BOOLEAN    Active;
+  BOOLEAN    NestedConsumers;
+  UINTN      Nesting;
+  UINT32     NextSerial;
+  UINT32     Dropped;
+  UINT32     Failures;
+  UINT32     LastSerial[STRESS_MAX_NEST + 1];
+  UINT8      State[STRESS_ITEMS];
+} STRESS_CONTEXT;
+
+STATIC STRESS_CONTEXT  mStress;
+STATIC UINT64          mRandomState;
+
+STATIC
+VOID
+StressPreempt (
+  IN HID_KEY_QUEUE  *Queue
+  );
+
+//
+// Build the queue with a preemption point that runs nested queue operations.
+//
+#define HID_KEY_QUEUE_PREEMPTION_POINT(Queue)  StressPreempt (Queue)
+#include "../HidKeyQueue.c"
+
+STATIC
+UINT16
+ItemCheck (
+  IN UINT32  Serial,
+  IN UINT16  Producer
+  )
+{
+  return (UINT16)((Serial * 0x9E3779B1) >> 16) ^ Producer;
+}
+
+/**
+ * @brief Produce one item from the producer of the current nesting level.
+ */
+STATIC
+VOID
+StressProduce (
+  IN HID_KEY_QUEUE  *Queue
+  )
+{
+  TEST_ITEM   Item;
+  EFI_STATUS  Status;
+
+  if (mStress.NextSerial >= STRESS_ITEMS) {
+    return;
+  }
+
+  Item.Serial   = mStress.NextSerial++;
+  Item.Producer = (UINT16)mStress.Nesting;
+  Item.Check    = ItemCheck (Item.Serial, Item.Producer);
+  Status        = HidKeyQueueEnqueue (Queue, &Item, sizeof (Item));
+  if (Status == EFI_SUCCESS) {
+    mStress.State[Item.Serial] = ITEM_QUEUED;
+  } else if (Status == EFI_BUFFER_TOO_SMALL) {
+    mStress.State[Item.Serial] = ITEM_DROPPED;
+    mStress.Dropped++;
+  } else {
+    mStress.Failures++;
+  }
+}
+
+/**
+ * @brief Consume one item and check it was queued, intact and not seen before.
+ */
+STATIC
+VOID
+StressConsume (
+  IN HID_KEY_QUEUE  *Queue
+  )
+{
+  TEST_ITEM   Item;
+  TEST_ITEM   Peeked;
+  EFI_STATUS  PeekStatus;
+
+  PeekStatus = HidKeyQueuePeek (Queue, &Peeked, sizeof (Peeked));
+  if (EFI_ERROR (HidKeyQueueDequeue (Queue, &Item, sizeof (Item)))) {
+    return;
+  }
+
+  if ((Item.Serial >= STRESS_ITEMS) || (Item.Producer > STRESS_MAX_NEST) ||
+      (Item.Check != ItemCheck (Item.Serial, Item.Producer)) ||
+      (mStress.State[Item.Serial] != ITEM_QUEUED))
+  {
+    mStress.Failures++;
+    return;
+  }
+
+  if ((PeekStatus == EFI_SUCCESS) && (Peeked.Check != ItemCheck (Peeked.Serial, Peeked.Producer))) {
+    mStress.Failures++;
+  }
+
+  //
+  // With a single consumer, every producer's items come out in order.
+  //
+  if (!mStress.NestedConsumers) {
+    if ((mStress.LastSerial[Item.Producer] != MAX_UINT32) && (Item.Serial <= mStress.LastSerial[Item.Producer])) {
+      mStress.Failures++;
+    }
+
+    mStress.LastSerial[Item.Producer] = Item.Serial;
+  }
+
+  mStress.State[Item.Serial] = ITEM_CONSUMED;
+}
+
+/**
+ * @brief Interrupt a queue operation with other queue operations.
+ */
+STATIC
+VOID
+StressPreempt (
+  IN HID_KEY_QUEUE  *Queue
+  )
+{
+  UINTN  Count;
+
+  if (!mStress.Active || (mStress.Nesting >= STRESS_MAX_NEST) || ((PseudoRandomNext (&mRandomState) % 8) != 0)) {
+    return;
+  }
+
+  mStress.Nesting++;
+  for (Count = PseudoRandomNext (&mRandomState) % 4; Count > 0; Count--) {
+    if (mStress.NestedConsumers && ((PseudoRandomNext (&mRandomState) % 2) == 0)) {
+      StressConsume (Queue);
+    } else {
+      StressProduce (Queue);
+    }
+  }
+
+  mStress.Nesting--;
+}
+
+/**
+ * @brief Run a stress pass and check every queued item came out exactly once.
+ */
+STATIC
+UNIT_TEST_STATUS
+RunStress (
+  IN UINTN    Depth,
+  IN BOOLEAN  NestedConsumers,
+  IN UINT32   StartPosition
+  )
+{
+  HID_KEY_QUEUE  Queue;
+  UINTN          Index;
+  UINTN          Count;
+  UINT32         Consumed;
+  UINT32         Dropped;
+
+  ZeroMem (&Queue, sizeof (Queue));
+  UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueInit (&Queue, sizeof (TEST_ITEM), Depth));
+
+  //
+  // Start the positions where they wrap around soon.
+  //
+  for (Index = 0; Index <= Queue.Mask; Index++) {
+    HID_KEY_QUEUE_SLOT_AT (&Queue, StartPosition + Index)->Sequence = StartPosition + (UINT32)Index;
+  }
+
+  Queue.Head = StartPosition;
+  Queue.Tail = StartPosition;
+
+  ZeroMem (&mStress, sizeof (mStress));
+  SetMem32 (mStress.LastSerial, sizeof (mStress.LastSerial), MAX_UINT32);
+  mStress.NestedConsumers = NestedConsumers;
+  mStress.Active          = TRUE;
+  while (mStress.NextSerial < STRESS_ITEMS) {
+    //
+    // A burst of keys, then a burst of reads.
+    //
+    for (Count = PseudoRandomNext (&mRandomState) % (2 * Depth + 1); Count > 0; Count--) {
+      StressProduce (&Queue);
+    }
+
+    for (Count = PseudoRandomNext (&mRandomState) % (3 * Depth + 1); Count > 0; Count--) {
+      StressConsume (&Queue);
+    }
+  }
+
+  mStress.Active = FALSE;
+  while (!HidKeyQueueIsEmpty (&Queue)) {
+    StressConsume (&Queue);
+  }
+
+  UT_ASSERT_STATUS_EQUAL (HidKeyQueueDequeue (&Queue, NULL, sizeof (TEST_ITEM)), EFI_NOT_READY);
+  UT_ASSERT_EQUAL (mStress.Failures, 0);
+  UT_ASSERT_EQUAL (Queue.Overflows, mStress.Dropped);
+
+  Consumed = 0;
+  Dropped  = 0;
+  for (Index = 0; Index < STRESS_ITEMS; Index++) {
+    UT_ASSERT_NOT_EQUAL (mStress.State[Index], ITEM_FREE);
+    UT_ASSERT_NOT_EQUAL (mStress.State[Index], ITEM_QUEUED);
+    if (mStress.State[Index] == ITEM_CONSUMED) {
+      Consumed++;
+    } else {
+      Dropped++;
+    }
+  }
+
+  UT_ASSERT_EQUAL (Consumed + Dropped, STRESS_ITEMS);
+  UT_ASSERT_EQUAL (Dropped, mStress.Dropped);
+  UT_ASSERT_TRUE (Queue.Head == Queue.Tail);
+
+  UT_LOG_INFO (
+    "Depth %d%a: %d keys read, %d dropped\n",
+    Queue.Mask + 1,
+    NestedConsumers ? ", nested readers" : "",
+    Consumed,
+    Dropped
+    );
+
+  HidKeyQueueDestroy (&Queue);
+  UT_ASSERT_TRUE (Queue.Slots == NULL);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Depths round up to a power of two, bad sizes are rejected and
+ * initializing again empties the queue.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestInit (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_KEY_QUEUE  Queue;
+  TEST_ITEM      Item;
+
+  ZeroMem (&Queue, sizeof (Queue));
+  UT_ASSERT_STATUS_EQUAL (HidKeyQueueInit (&Queue, 0, 8), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (HidKeyQueueInit (&Queue, sizeof (Item), 0), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (HidKeyQueueInit (&Queue, sizeof (Item), HID_KEY_QUEUE_MAX_DEPTH + 1), EFI_INVALID_PARAMETER);
+  UT_ASSERT_TRUE (Queue.Slots == NULL);
+
+  UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueInit (&Queue, sizeof (Item), 5));
+  UT_ASSERT_EQUAL (Queue.Mask, 7);
+  UT_ASSERT_EQUAL (Queue.SlotSize % sizeof (UINT64), 0);
+  UT_ASSERT_TRUE (HidKeyQueueIsEmpty (&Queue));
+
+  ZeroMem (&Item, sizeof (Item));
+  UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueEnqueue (&Queue, &Item, sizeof (Item)));
+  UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueEnqueue (&Queue, &Item, sizeof (Item)));
+  UT_ASSERT_FALSE (HidKeyQueueIsEmpty (&Queue));
+
+  UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueInit (&Queue, sizeof (Item), 5));
+  UT_ASSERT_TRUE (HidKeyQueueIsEmpty (&Queue));
+  UT_ASSERT_EQUAL (Queue.Mask, 7);
+
+  HidKeyQueueDestroy (&Queue);
+  HidKeyQueueDestroy (&Queue);
+  UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueInit (&Queue, sizeof (Item), HID_KEY_QUEUE_MAX_DEPTH));
+  UT_ASSERT_EQUAL (Queue.Mask, HID_KEY_QUEUE_MAX_DEPTH - 1);
+  HidKeyQueueDestroy (&Queue);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Items come out in order, a full queue drops and counts new items,
+ * and peeking leaves the item in place.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestFifoAndOverflow (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_KEY_QUEUE  Queue;
+  TEST_ITEM      Item;
+  UINT32         Lap;
+  UINT32         Index;
+
+  ZeroMem (&Queue, sizeof (Queue));
+  UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueInit (&Queue, sizeof (Item), 4));
+  UT_ASSERT_STATUS_EQUAL (HidKeyQueueDequeue (&Queue, &Item, sizeof (Item)), EFI_NOT_READY);
+  UT_ASSERT_STATUS_EQUAL (HidKeyQueuePeek (&Queue, &Item, sizeof (Item)), EFI_NOT_READY);
+
+  for (Lap = 0; Lap < 5; Lap++) {
+    for (Index = 0; Index < 6; Index++) {
+      Item.Serial = Lap * 100 + Index;
+      if (Index < 4) {
+        UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueEnqueue (&Queue, &Item, sizeof (Item)));
+      } else {
+        UT_ASSERT_STATUS_EQUAL (HidKeyQueueEnqueue (&Queue, &Item, sizeof (Item)), EFI_BUFFER_TOO_SMALL);
+      }
+    }
+
+    UT_ASSERT_EQUAL (Queue.Overflows, (Lap + 1) * 2);
+
+    UT_ASSERT_NOT_EFI_ERROR (HidKeyQueuePeek (&Queue, &Item, sizeof (Item)));
+    UT_ASSERT_EQUAL (Item.Serial, Lap * 100);
+    for (Index = 0; Index < 4; Index++) {
+      UT_ASSERT_NOT_EFI_ERROR (HidKeyQueueDequeue (&Queue, &Item, sizeof (Item)));
+      UT_ASSERT_EQUAL (Item.Serial, Lap * 100 + Index);
+    }
+
+    UT_ASSERT_TRUE (HidKeyQueueIsEmpty (&Queue));
+  }
+
+  HidKeyQueueDestroy (&Queue);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Producers interrupted at every step by higher level producers and
+ * one reader: nothing is lost or duplicated and each producer's keys stay in order.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestInterruptedProducers (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+
+  mRandomState = 0x51554555;
+  Status       = RunStress (4, FALSE, 0);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  Status = RunStress (64, FALSE, 0);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  return RunStress (256, FALSE, 0);
+}
+
+/**
+ * @brief Producers and readers interrupting each other at every step:
+ * every key is read exactly once or counted as dropped.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestInterruptedReaders (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+
+  mRandomState = 0x52454144;
+  Status       = RunStress (2, TRUE, 0);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  Status = RunStress (16, TRUE, 0);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  return RunStress (64, TRUE, 0);
+}
+
+/**
+ * @brief The positions wrap around 2^32 in the middle of the run.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestPositionWrap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UNIT_TEST_STATUS  Status;
+
+  mRandomState = 0x57524150;
+  Status       = RunStress (8, FALSE, MAX_UINT32 - 1000);
+  if (Status != UNIT_TEST_PASSED) {
+    return Status;
+  }
+
+  return RunStress (8, TRUE, MAX_UINT32 - 3);
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  key queue and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UefiTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      QueueSuiteHandle;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Create a suite
+  //
+  Status = CreateUnitTestSuite (&QueueSuiteHandle, Framework, "HidKeyboardDxe key queue", "HidKeyboardDxe.HID.KeyQueue", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for QueueSuiteHandle\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // Register Tests
+  //
+  AddTestCase (QueueSuiteHandle, "Create and empty queues", "Init", TestInit, NULL, NULL, NULL);
+  AddTestCase (QueueSuiteHandle, "Keep order and count overflows", "FifoOverflow", TestFifoAndOverflow, NULL, NULL, NULL);
+  AddTestCase (QueueSuiteHandle, "Interrupted producers", "InterruptedProducers", TestInterruptedProducers, NULL, NULL, NULL);
+  AddTestCase (QueueSuiteHandle, "Interrupted producers and readers", "InterruptedReaders", TestInterruptedReaders, NULL, NULL, NULL);
+  AddTestCase (QueueSuiteHandle, "Wrap queue positions", "PositionWrap", TestPositionWrap, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UefiTestMain ();
+}
@@ -0,0 +1,785 @@
+/** @file
+  This module tests the compilation of keyboard layouts into key translation
+  tables, compares the tables against the descriptor walk they replace and
+  benchmarks both.
+
+  Copyright (c) Microsoft Corporation
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PseudoRandomLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UnitTestLib.h>
+#include "../HidKeyboardLayout.h"
+
+#define UNIT_TEST_NAME     "HID Keyboard Layout Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define BENCHMARK_STROKES  4096
+#define BENCHMARK_PASSES   64
+
+//
+// Keycode range of the original key descriptor table.
+//
+#define REF_KEY_COUNT                 0x6A
+#define REF_NON_MODIFIER_KEY_COUNT    0x62
+#define REF_VALID_KEYCODE(KeyCode)    ((((KeyCode) >= 0x04) && ((KeyCode) <= 0x65)) || (((KeyCode) >= 0xE0) && ((KeyCode) <= 0xE7)))
+
+extern UINT8  EfiKeyToHidKeyCodeConvertionTable[];
+extern UINT8  ModifierValueToEfiScanCodeConvertionTable[];
+
+///
+/// The non-spacing key list and keycode table the key table replaces.
+///
+typedef struct _REF_NS_KEY {
+  struct _REF_NS_KEY    *Next;
+  UINTN                 KeyCount;
+  EFI_KEY_DESCRIPTOR    *NsKey;
+} REF_NS_KEY;
+
+typedef struct {
+  EFI_KEY_DESCRIPTOR    Table[REF_KEY_COUNT];
+  REF_NS_KEY            *NsKeys;
+  REF_NS_KEY            *CurrentNsKey;
+} REF_LAYOUT;
+
+///
+/// A keyboard layout under test and its dead keys.
+///
+typedef struct {
+  CONST CHAR8                *Name;
+  EFI_HII_KEYBOARD_LAYOUT    *Layout;
+  UINT8                      DeadKeys[4];
+  UINTN                      DeadKeyCount;
+} TEST_LAYOUT;
+
+STATIC TEST_LAYOUT  mLayouts[2];
+STATIC UINT64       mRandomState;
+
+/**
+ * @brief Find a key descriptor the way the original keycode table did.
+ */
+STATIC
+EFI_KEY_DESCRIPTOR *
+RefGetKeyDescriptor (
+  IN REF_LAYOUT  *Ref,
+  IN UINT8       KeyCode
+  )
+{
+  if (!REF_VALID_KEYCODE (KeyCode)) {
+    return NULL;
+  }
+
+  if (KeyCode <= 0x65) {
+    return &Ref->Table[KeyCode - 4];
+  }
+
+  return &Ref->Table[KeyCode - 0xE0 + REF_NON_MODIFIER_KEY_COUNT];
+}
+
+/**
+ * @brief Load a layout into the original keycode table and non-spacing key list.
+ */
+STATIC
+VOID
+RefLoad (
+  OUT REF_LAYOUT                     *Ref,
+  IN  CONST EFI_HII_KEYBOARD_LAYOUT  *Layout
+  )
+{
+  EFI_KEY_DESCRIPTOR  *KeyDescriptor;
+  EFI_KEY_DESCRIPTOR  TempKey;
+  REF_NS_KEY          *NsKey;
+  REF_NS_KEY          **Tail;
+  UINTN               Index;
+  UINTN               Index2;
+
+  ZeroMem (Ref, sizeof (*Ref));
+  Tail          = &Ref->NsKeys;
+  KeyDescriptor = (EFI_KEY_DESCRIPTOR *)((UINT8 *)Layout + sizeof (EFI_HII_KEYBOARD_LAYOUT));
+  for (Index = 0; Index < Layout->DescriptorCount; Index++) {
+    CopyMem (&TempKey, &KeyDescriptor[Index], sizeof (TempKey));
+    CopyMem (RefGetKeyDescriptor (Ref, EfiKeyToHidKeyCodeConvertionTable[TempKey.Key]), &TempKey, sizeof (TempKey));
+    if (TempKey.Modifier == EFI_NS_KEY_MODIFIER) {
+      NsKey = AllocateZeroPool (sizeof (REF_NS_KEY));
+      for (Index2 = Index + 1; Index2 < Layout->DescriptorCount; Index2++) {
+        CopyMem (&TempKey, &KeyDescriptor[Index2], sizeof (TempKey));
+        if (TempKey.Modifier != EFI_NS_KEY_DEPENDENCY_MODIFIER) {
+          break;
+        }
+
+        NsKey->KeyCount++;
+      }
+
+      NsKey->NsKey = AllocateCopyPool ((NsKey->KeyCount + 1) * sizeof (EFI_KEY_DESCRIPTOR), &KeyDescriptor[Index]);
+      *Tail        = NsKey;
+      Tail         = &NsKey->Next;
+      Index       += NsKey->KeyCount;
+    }
+  }
+
+  CopyMem (RefGetKeyDescriptor (Ref, 0x58), RefGetKeyDescriptor (Ref, 0x28), sizeof (EFI_KEY_DESCRIPTOR));
+}
+
+STATIC
+VOID
+RefFree (
+  IN REF_LAYOUT  *Ref
+  )
+{
+  REF_NS_KEY  *NsKey;
+
+  while (Ref->NsKeys != NULL) {
+    NsKey       = Ref->NsKeys;
+    Ref->NsKeys = NsKey->Next;
+    FreePool (NsKey->NsKey);
+    FreePool (NsKey);
+  }
+}
+
+/**
+ * @brief Translate a keycode with the descriptor walk the key table replaces.
+ */
+STATIC
+EFI_STATUS
+RefTranslate (
+  IN OUT REF_LAYOUT     *Ref,
+  IN     UINT8          KeyCode,
+  IN     UINTN          State,
+  OUT    EFI_INPUT_KEY  *Key,
+  OUT    BOOLEAN        *ShiftCleared
+  )
+{
+  EFI_KEY_DESCRIPTOR  *KeyDescriptor;
+  REF_NS_KEY          *NsKey;
+  UINTN               Index;
+
+  *ShiftCleared = FALSE;
+  KeyDescriptor = RefGetKeyDescriptor (Ref, KeyCode);
+  if (KeyDescriptor == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (KeyDescriptor->Modifier == EFI_NS_KEY_MODIFIER) {
+    for (NsKey = Ref->NsKeys; NsKey != NULL; NsKey = NsKey->Next) {
+      if (NsKey->NsKey[0].Key == KeyDescriptor->Key) {
+        break;
+      }
+    }
+
+    Ref->CurrentNsKey = NsKey;
+    return EFI_NOT_READY;
+  }
+
+  if (Ref->CurrentNsKey != NULL) {
+    for (Index = 1; Index <= Ref->CurrentNsKey->KeyCount; Index++) {
+      if (Ref->CurrentNsKey->NsKey[Index].Key == KeyDescriptor->Key) {
+        KeyDescriptor = &Ref->CurrentNsKey->NsKey[Index];
+        break;
+      }
+    }
+
+    Ref->CurrentNsKey = NULL;
+  }
+
+  if (KeyDescriptor->Modifier > EFI_MENU_MODIFIER) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Key->ScanCode    = ModifierValueToEfiScanCodeConvertionTable[KeyDescriptor->Modifier];
+  Key->UnicodeChar = KeyDescriptor->Unicode;
+  if ((KeyDescriptor->AffectedAttribute & EFI_AFFECTED_BY_STANDARD_SHIFT) != 0) {
+    if ((State & HID_KB_STATE_SHIFT) != 0) {
+      Key->UnicodeChar = KeyDescriptor->ShiftedUnicode;
+      if ((KeyDescriptor->Unicode != CHAR_NULL) && (KeyDescriptor->ShiftedUnicode != CHAR_NULL) &&
+          (KeyDescriptor->Unicode != KeyDescriptor->ShiftedUnicode))
+      {
+        *ShiftCleared = TRUE;
+      }
+
+      if ((State & HID_KB_STATE_ALT_GR) != 0) {
+        Key->UnicodeChar = KeyDescriptor->ShiftedAltGrUnicode;
+      }
+    } else {
+      Key->UnicodeChar = KeyDescriptor->Unicode;
+      if ((State & HID_KB_STATE_ALT_GR) != 0) {
+        Key->UnicodeChar = KeyDescriptor->AltGrUnicode;
+      }
+    }
+  }
+
+  if (((KeyDescriptor->AffectedAttribute & EFI_AFFECTED_BY_CAPS_LOCK) != 0) && ((State & HID_KB_STATE_CAPS_LOCK) != 0)) {
+    if (Key->UnicodeChar == KeyDescriptor->Unicode) {
+      Key->UnicodeChar = KeyDescriptor->ShiftedUnicode;
+    } else if (Key->UnicodeChar == KeyDescriptor->ShiftedUnicode) {
+      Key->UnicodeChar = KeyDescriptor->Unicode;
+    }
+  }
+
+  if ((KeyDescriptor->AffectedAttribute & EFI_AFFECTED_BY_NUM_LOCK) != 0) {
+    if (((State & HID_KB_STATE_NUM_LOCK) != 0) && ((State & HID_KB_STATE_SHIFT) == 0)) {
+      Key->ScanCode = SCAN_NULL;
+    } else {
+      Key->UnicodeChar = CHAR_NULL;
+    }
+  }
+
+  if ((Key->UnicodeChar == 0x1B) && (Key->ScanCode == SCAN_NULL)) {
+    Key->ScanCode    = SCAN_ESC;
+    Key->UnicodeChar = CHAR_NULL;
+  }
+
+  if ((Key->UnicodeChar == 0) && (Key->ScanCode == SCAN_NULL)) {
+    return EFI_NOT_READY;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+ * @brief Translate a keycode with the key table, as HIDKeyCodeToEfiInputKey does.
+ */
+STATIC
+EFI_STATUS
+TableTranslate (
+  IN     CONST HID_KB_KEY_TABLE  *Table,
+  IN OUT UINT16                  *NsKey,
+  IN     UINT8                   KeyCode,
+  IN     UINTN                   State,
+  OUT    EFI_INPUT_KEY           *Key,
+  OUT    BOOLEAN                 *ShiftCleared
+  )
+{
+  CONST HID_KB_KEY_ENTRY  *KeyEntry;
+
+  *ShiftCleared = FALSE;
+  KeyEntry      = HidKbLookupKey (Table, 0, KeyCode);
+  if (KeyEntry == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (KeyEntry->NsKey != 0) {
+    *NsKey = KeyEntry->NsKey;
+    return EFI_NOT_READY;
+  }
+
+  if (*NsKey != 0) {
+    KeyEntry = HidKbLookupKey (Table, *NsKey, KeyCode);
+    *NsKey   = 0;
+  }
+
+  if ((KeyEntry->Flags & HID_KB_KEY_BAD_MODIFIER) != 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  *Key          = KeyEntry->Key[State];
+  *ShiftCleared = (BOOLEAN)(((State & HID_KB_STATE_SHIFT) != 0) && ((KeyEntry->Flags & HID_KB_KEY_SHIFT_ADJUSTED) != 0));
+  if ((Key->UnicodeChar == 0) && (Key->ScanCode == SCAN_NULL)) {
+    return EFI_NOT_READY;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+ * @brief Build a layout from the default one with two dead keys and an
+ * AltGr character, like an international layout.
+ */
+STATIC
+EFI_HII_KEYBOARD_LAYOUT *
+BuildDeadKeyLayout (
+  VOID
+  )
+{
+  STATIC CONST EFI_KEY_DESCRIPTOR  Grave[] = {
+    { EfiKeyE0,       0,      0,      0, 0, EFI_NS_KEY_MODIFIER,            0                                                          },
+    { EfiKeyC1,       0x00E0, 0x00C0, 0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD3,       0x00E8, 0x00C8, 0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD8,       0x00EC, 0x00CC, 0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD9,       0x00F2, 0x00D2, 0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD7,       0x00F9, 0x00D9, 0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeySpaceBar, '`',    '~',    0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+  };
+  STATIC CONST EFI_KEY_DESCRIPTOR  Acute[] = {
+    { EfiKeyC11,      0,      0,      0, 0, EFI_NS_KEY_MODIFIER,            0                                                          },
+    { EfiKeyC1,       0x00E1, 0x00C1, 0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeyD3,       0x00E9, 0x00C9, 0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT | EFI_AFFECTED_BY_CAPS_LOCK },
+    { EfiKeySpaceBar, '\'',   '"',    0, 0, EFI_NS_KEY_DEPENDENCY_MODIFIER, EFI_AFFECTED_BY_STANDARD_SHIFT                             },
+  };
+  CONST EFI_HII_KEYBOARD_LAYOUT  *Default;
+  EFI_HII_KEYBOARD_LAYOUT        *Layout;
+  EFI_KEY_DESCRIPTOR             *Out;
+  EFI_KEY_DESCRIPTOR             Key;
+  UINTN                          Count;
+  UINTN                          Index;
+
+  Default = (CONST EFI_HII_KEYBOARD_LAYOUT *)&mHidKeyboardLayoutBin.LayoutLength;
+  Count   = Default->DescriptorCount + ARRAY_SIZE (Grave) + ARRAY_SIZE (Acute);
+  Layout  = AllocateZeroPool (sizeof (EFI_HII_KEYBOARD_LAYOUT) + Count * sizeof (EFI_KEY_DESCRIPTOR));
+  if (Layout == NULL) {
+    return NULL;
+  }
+
+  Out   = (EFI_KEY_DESCRIPTOR *)((UINT8 *)Layout + sizeof (EFI_HII_KEYBOARD_LAYOUT));
+  Count = 0;
+  for (Index = 0; Index < Default->DescriptorCount; Index++) {
+    CopyMem (&Key, &mHidKeyboardLayoutBin.KeyDescriptor[Index], sizeof (Key));
+    if (Key.Key == EfiKeyE0) {
+      CopyMem (&Out[Count], Grave, sizeof (Grave));
+      Count += ARRAY_SIZE (Grave);
+      continue;
+    }
+
+    if (Key.Key == EfiKeyC11) {
+      CopyMem (&Out[Count], Acute, sizeof (Acute));
+      Count += ARRAY_SIZE (Acute);
+      continue;
+    }
+
+    if (Key.Key == EfiKeyE4) {
+      Key.AltGrUnicode        = 0x20AC;
+      Key.ShiftedAltGrUnicode = 0x00A3;
+    }
+
+    CopyMem (&Out[Count], &Key, sizeof (Key));
+    Count++;
+  }
+
+  Layout->LayoutLength    = (UINT16)(sizeof (EFI_HII_KEYBOARD_LAYOUT) + Count * sizeof (EFI_KEY_DESCRIPTOR));
+  Layout->DescriptorCount = (UINT8)Count;
+  return Layout;
+}
+
+/**
+ * @brief The default layout compiles into one entry per descriptor and no
+ * dead keys, and translates like a US keyboard.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestCompileDefaultLayout (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS              Status;
+  HID_KB_KEY_TABLE        *Table;
+  CONST HID_KB_KEY_ENTRY  *Entry;
+
+  Status = HidKbCompileKeyTable (mLayouts[0].Layout, &Table);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Table->EntryCount, HID_KEYBOARD_KEY_COUNT + 1);
+  UT_ASSERT_EQUAL (Table->NsKeyCount, 0);
+
+  Entry = HidKbLookupKey (Table, 0, 0x04);
+  UT_ASSERT_NOT_NULL (Entry);
+  UT_ASSERT_EQUAL (Entry->Key[0].UnicodeChar, 'a');
+  UT_ASSERT_EQUAL (Entry->Key[HID_KB_STATE_SHIFT].UnicodeChar, 'A');
+  UT_ASSERT_EQUAL (Entry->Key[HID_KB_STATE_CAPS_LOCK].UnicodeChar, 'A');
+  UT_ASSERT_EQUAL (Entry->Key[HID_KB_STATE_SHIFT | HID_KB_STATE_CAPS_LOCK].UnicodeChar, 'a');
+  UT_ASSERT_TRUE ((Entry->Flags & HID_KB_KEY_SHIFT_ADJUSTED) != 0);
+
+  //
+  // Escape becomes a scan code, keypad keys follow NumLock.
+  //
+  Entry = HidKbLookupKey (Table, 0, 0x29);
+  UT_ASSERT_EQUAL (Entry->Key[0].ScanCode, SCAN_ESC);
+  UT_ASSERT_EQUAL (Entry->Key[0].UnicodeChar, CHAR_NULL);
+  Entry = HidKbLookupKey (Table, 0, 0x59);
+  UT_ASSERT_EQUAL (Entry->Key[HID_KB_STATE_NUM_LOCK].UnicodeChar, '1');
+  UT_ASSERT_EQUAL (Entry->Key[HID_KB_STATE_NUM_LOCK].ScanCode, SCAN_NULL);
+  UT_ASSERT_EQUAL (Entry->Key[0].UnicodeChar, CHAR_NULL);
+  UT_ASSERT_EQUAL (Entry->Key[0].ScanCode, SCAN_END);
+
+  //
+  // Keypad Enter shares the entry of Enter, reserved keycodes have none.
+  //
+  UT_ASSERT_TRUE (HidKbLookupKey (Table, 0, 0x58) == HidKbLookupKey (Table, 0, 0x28));
+  UT_ASSERT_TRUE (HidKbLookupKey (Table, 0, 0x00) == NULL);
+  UT_ASSERT_TRUE (HidKbLookupKey (Table, 0, 0x03) == NULL);
+  UT_ASSERT_TRUE (HidKbLookupKey (Table, 0, 0x66) == NULL);
+  UT_ASSERT_TRUE (HidKbLookupKey (Table, 0, 0xE8) == NULL);
+  UT_ASSERT_TRUE (HidKbLookupKey (NULL, 0, 0x04) == NULL);
+
+  //
+  // A stale dead key index is ignored.
+  //
+  UT_ASSERT_TRUE (HidKbLookupKey (Table, 7, 0x04) == HidKbLookupKey (Table, 0, 0x04));
+
+  HidKbFreeKeyTable (Table);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Dead keys change the key that follows them, and only that key.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestDeadKeys (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS        Status;
+  HID_KB_KEY_TABLE  *Table;
+  UINT16            NsKey;
+  EFI_INPUT_KEY     Key;
+  BOOLEAN           ShiftCleared;
+
+  Status = HidKbCompileKeyTable (mLayouts[1].Layout, &Table);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Table->NsKeyCount, 2);
+
+  //
+  // ` then a
+  //
+  NsKey = 0;
+  UT_ASSERT_STATUS_EQUAL (TableTranslate (Table, &NsKey, 0x35, 0, &Key, &ShiftCleared), EFI_NOT_READY);
+  UT_ASSERT_NOT_EQUAL (NsKey, 0);
+  UT_ASSERT_NOT_EFI_ERROR (TableTranslate (Table, &NsKey, 0x04, 0, &Key, &ShiftCleared));
+  UT_ASSERT_EQUAL (Key.UnicodeChar, 0x00E0);
+  UT_ASSERT_EQUAL (NsKey, 0);
+
+  //
+  // ' then Shift+e, then e on its own
+  //
+  UT_ASSERT_STATUS_EQUAL (TableTranslate (Table, &NsKey, 0x34, 0, &Key, &ShiftCleared), EFI_NOT_READY);
+  UT_ASSERT_NOT_EFI_ERROR (TableTranslate (Table, &NsKey, 0x08, HID_KB_STATE_SHIFT, &Key, &ShiftCleared));
+  UT_ASSERT_EQUAL (Key.UnicodeChar, 0x00C9);
+  UT_ASSERT_TRUE (ShiftCleared);
+  UT_ASSERT_NOT_EFI_ERROR (TableTranslate (Table, &NsKey, 0x08, 0, &Key, &ShiftCleared));
+  UT_ASSERT_EQUAL (Key.UnicodeChar, 'e');
+
+  //
+  // ' then a key without a combination gives the plain key, ' then ` waits again.
+  //
+  UT_ASSERT_STATUS_EQUAL (TableTranslate (Table, &NsKey, 0x34, 0, &Key, &ShiftCleared), EFI_NOT_READY);
+  UT_ASSERT_NOT_EFI_ERROR (TableTranslate (Table, &NsKey, 0x05, 0, &Key, &ShiftCleared));
+  UT_ASSERT_EQUAL (Key.UnicodeChar, 'b');
+  UT_ASSERT_STATUS_EQUAL (TableTranslate (Table, &NsKey, 0x34, 0, &Key, &ShiftCleared), EFI_NOT_READY);
+  UT_ASSERT_STATUS_EQUAL (TableTranslate (Table, &NsKey, 0x35, 0, &Key, &ShiftCleared), EFI_NOT_READY);
+  UT_ASSERT_NOT_EFI_ERROR (TableTranslate (Table, &NsKey, 0x2C, 0, &Key, &ShiftCleared));
+  UT_ASSERT_EQUAL (Key.UnicodeChar, '`');
+
+  //
+  // AltGr
+  //
+  UT_ASSERT_NOT_EFI_ERROR (TableTranslate (Table, &NsKey, 0x21, HID_KB_STATE_ALT_GR, &Key, &ShiftCleared));
+  UT_ASSERT_EQUAL (Key.UnicodeChar, 0x20AC);
+  UT_ASSERT_NOT_EFI_ERROR (TableTranslate (Table, &NsKey, 0x21, HID_KB_STATE_ALT_GR | HID_KB_STATE_SHIFT, &Key, &ShiftCleared));
+  UT_ASSERT_EQUAL (Key.UnicodeChar, 0x00A3);
+
+  HidKbFreeKeyTable (Table);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Every keycode in every shift and lock state, alone and after every
+ * dead key, translates exactly like the descriptor walk.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestMatchesDescriptorWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS        Status;
+  EFI_STATUS        RefStatus;
+  HID_KB_KEY_TABLE  *Table;
+  REF_LAYOUT        Ref;
+  UINTN             LayoutIndex;
+  UINTN             Prefix;
+  UINTN             KeyCode;
+  UINTN             State;
+  UINT16            NsKey;
+  EFI_INPUT_KEY     Key;
+  EFI_INPUT_KEY     RefKey;
+  BOOLEAN           ShiftCleared;
+  BOOLEAN           RefShiftCleared;
+
+  for (LayoutIndex = 0; LayoutIndex < ARRAY_SIZE (mLayouts); LayoutIndex++) {
+    Status = HidKbCompileKeyTable (mLayouts[LayoutIndex].Layout, &Table);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    RefLoad (&Ref, mLayouts[LayoutIndex].Layout);
+
+    for (Prefix = 0; Prefix <= mLayouts[LayoutIndex].DeadKeyCount; Prefix++) {
+      for (KeyCode = 0; KeyCode < 256; KeyCode++) {
+        for (State = 0; State < HID_KB_STATE_COUNT; State++) {
+          NsKey            = 0;
+          Ref.CurrentNsKey = NULL;
+          if (Prefix != 0) {
+            UT_ASSERT_STATUS_EQUAL (TableTranslate (Table, &NsKey, mLayouts[LayoutIndex].DeadKeys[Prefix - 1], 0, &Key, &ShiftCleared), EFI_NOT_READY);
+            UT_ASSERT_STATUS_EQUAL (RefTranslate (&Ref, mLayouts[LayoutIndex].DeadKeys[Prefix - 1], 0, &RefKey, &RefShiftCleared), EFI_NOT_READY);
+          }
+
+          ZeroMem (&Key, sizeof (Key));
+          ZeroMem (&RefKey, sizeof (RefKey));
+          Status    = TableTranslate (Table, &NsKey, (UINT8)KeyCode, State, &Key, &ShiftCleared);
+          RefStatus = RefTranslate (&Ref, (UINT8)KeyCode, State, &RefKey, &RefShiftCleared);
+          UT_ASSERT_STATUS_EQUAL (Status, RefStatus);
+          UT_ASSERT_EQUAL ((NsKey != 0), (Ref.CurrentNsKey != NULL));
+          if (!EFI_ERROR (Status)) {
+            UT_ASSERT_EQUAL (Key.ScanCode, RefKey.ScanCode);
+            UT_ASSERT_EQUAL (Key.UnicodeChar, RefKey.UnicodeChar);
+            UT_ASSERT_EQUAL (ShiftCleared, RefShiftCleared);
+          }
+        }
+      }
+    }
+
+    RefFree (&Ref);
+    HidKbFreeKeyTable (Table);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Truncated layouts and keys without a HID keycode are rejected.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestRejectsBadLayouts (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_HII_KEYBOARD_LAYOUT  *Layout;
+  EFI_KEY_DESCRIPTOR       *Descriptors;
+  HID_KB_KEY_TABLE         *Table;
+  UINTN                    Size;
+
+  UT_ASSERT_STATUS_EQUAL (HidKbCompileKeyTable (NULL, &Table), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (HidKbCompileKeyTable (mLayouts[0].Layout, NULL), EFI_INVALID_PARAMETER);
+
+  Size   = mLayouts[1].Layout->LayoutLength;
+  Layout = AllocateCopyPool (Size, mLayouts[1].Layout);
+  UT_ASSERT_NOT_NULL (Layout);
+
+  Layout->LayoutLength = (UINT16)(Size - 1);
+  Table                = (HID_KB_KEY_TABLE *)Layout;
+  UT_ASSERT_STATUS_EQUAL (HidKbCompileKeyTable (Layout, &Table), EFI_COMPROMISED_DATA);
+  UT_ASSERT_TRUE (Table == NULL);
+
+  //
+  // EfiKeyPause is the last EFI_KEY, one past it has no keycode.
+  //
+  Layout->LayoutLength = (UINT16)Size;
+  Descriptors          = (EFI_KEY_DESCRIPTOR *)((UINT8 *)Layout + sizeof (EFI_HII_KEYBOARD_LAYOUT));
+  Descriptors[3].Key   = (EFI_KEY)(EfiKeyPause + 1);
+  UT_ASSERT_STATUS_EQUAL (HidKbCompileKeyTable (Layout, &Table), EFI_COMPROMISED_DATA);
+
+  //
+  // A bad modifier only poisons its own key.
+  //
+  Descriptors[3].Key      = EfiKeyC1;
+  Descriptors[3].Modifier = 0x7FFF;
+  UT_ASSERT_NOT_EFI_ERROR (HidKbCompileKeyTable (Layout, &Table));
+  UT_ASSERT_TRUE ((HidKbLookupKey (Table, 0, 0x04)->Flags & HID_KB_KEY_BAD_MODIFIER) != 0);
+  HidKbFreeKeyTable (Table);
+
+  FreePool (Layout);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Time a stream of keystrokes, dead keys included, through the
+ * descriptor walk and through the key table. Results must agree.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS        Status;
+  HID_KB_KEY_TABLE  *Table;
+  REF_LAYOUT        Ref;
+  UINT8             *KeyCodes;
+  UINT8             *States;
+  UINTN             LayoutIndex;
+  UINTN             Pass;
+  UINTN             Index;
+  UINT16            NsKey;
+  EFI_INPUT_KEY     Key;
+  BOOLEAN           ShiftCleared;
+  UINT64            Start;
+  UINT64            RefNs;
+  UINT64            TableNs;
+  UINT32            RefSum;
+  UINT32            TableSum;
+
+  KeyCodes = AllocatePool (BENCHMARK_STROKES);
+  States   = AllocatePool (BENCHMARK_STROKES);
+  UT_ASSERT_NOT_NULL (KeyCodes);
+  UT_ASSERT_NOT_NULL (States);
+
+  for (LayoutIndex = 0; LayoutIndex < ARRAY_SIZE (mLayouts); LayoutIndex++) {
+    mRandomState = 0x4B455953 + LayoutIndex;
+    for (Index = 0; Index < BENCHMARK_STROKES; Index++) {
+      if ((mLayouts[LayoutIndex].DeadKeyCount != 0) && (PseudoRandomNext (&mRandomState) % 8 == 0)) {
+        KeyCodes[Index] = mLayouts[LayoutIndex].DeadKeys[PseudoRandomNext (&mRandomState) % mLayouts[LayoutIndex].DeadKeyCount];
+      } else {
+        KeyCodes[Index] = (UINT8)(0x04 + PseudoRandomNext (&mRandomState) % 0x62);
+      }
+
+      States[Index] = (UINT8)(PseudoRandomNext (&mRandomState) % HID_KB_STATE_COUNT);
+    }
+
+    Status = HidKbCompileKeyTable (mLayouts[LayoutIndex].Layout, &Table);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    RefLoad (&Ref, mLayouts[LayoutIndex].Layout);
+
+    RefSum = 0;
+    Start  = GetPerformanceCounter ();
+    for (Pass = 0; Pass < BENCHMARK_PASSES; Pass++) {
+      for (Index = 0; Index < BENCHMARK_STROKES; Index++) {
+        if (RefTranslate (&Ref, KeyCodes[Index], States[Index], &Key, &ShiftCleared) == EFI_SUCCESS) {
+          RefSum = RefSum * 31 + (((UINT32)Key.ScanCode << 16) | Key.UnicodeChar);
+        }
+      }
+    }
+
+    RefNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+
+    TableSum = 0;
+    NsKey    = 0;
+    Start    = GetPerformanceCounter ();
+    for (Pass = 0; Pass < BENCHMARK_PASSES; Pass++) {
+      for (Index = 0; Index < BENCHMARK_STROKES; Index++) {
+        if (TableTranslate (Table, &NsKey, KeyCodes[Index], States[Index], &Key, &ShiftCleared) == EFI_SUCCESS) {
+          TableSum = TableSum * 31 + (((UINT32)Key.ScanCode << 16) | Key.UnicodeChar);
+        }
+      }
+    }
+
+    TableNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+
+    RefFree (&Ref);
+    HidKbFreeKeyTable (Table);
+    UT_ASSERT_EQUAL (RefSum, TableSum);
+
+    UT_LOG_INFO (
+      "%a: %d keystrokes.  Descriptor walk %ld us.  Key table %ld us.\n",
+      mLayouts[LayoutIndex].Name,
+      BENCHMARK_STROKES * BENCHMARK_PASSES,
+      RefNs / 1000,
+      TableNs / 1000
+      );
+  }
+
+  FreePool (KeyCodes);
+  FreePool (States);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  keyboard layout compilation and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UefiTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      LayoutSuiteHandle;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // The shipped layout, and one with dead keys and AltGr.
+  //
+  mLayouts[0].Name         = "en-US";
+  mLayouts[0].Layout       = (EFI_HII_KEYBOARD_LAYOUT *)&mHidKeyboardLayoutBin.LayoutLength;
+  mLayouts[0].DeadKeyCount = 0;
+  mLayouts[1].Name         = "en-US international";
+  mLayouts[1].Layout       = BuildDeadKeyLayout ();
+  mLayouts[1].DeadKeys[0]  = 0x35;
+  mLayouts[1].DeadKeys[1]  = 0x34;
+  mLayouts[1].DeadKeyCount = 2;
+  if (mLayouts[1].Layout == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Create a suite
+  //
+  Status = CreateUnitTestSuite (&LayoutSuiteHandle, Framework, "HidKeyboardDxe key translation tables", "HidKeyboardDxe.HID.Layout", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for LayoutSuiteHandle\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // Register Tests
+  //
+  AddTestCase (LayoutSuiteHandle, "Compile the default layout", "DefaultLayout", TestCompileDefaultLayout, NULL, NULL, NULL);
+  AddTestCase (LayoutSuiteHandle, "Translate dead key combinations", "DeadKeys", TestDeadKeys, NULL, NULL, NULL);
+  AddTestCase (LayoutSuiteHandle, "Match the descriptor walk for every key and state", "MatchWalk", TestMatchesDescriptorWalk, NULL, NULL, NULL);
+  AddTestCase (LayoutSuiteHandle, "Reject bad layouts", "BadLayouts", TestRejectsBadLayouts, NULL, NULL, NULL);
+  AddTestCase (LayoutSuiteHandle, "Benchmark descriptor walk vs key table", "Benchmark", TestBenchmark, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  if (mLayouts[1].Layout != NULL) {
+    FreePool (mLayouts[1].Layout);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UefiTestMain ();
+}
@@ -0,0 +1,612 @@
+/** @file
+  This module tests the translation of boot and report protocol keyboard
+  HID reports into pressed key bitmaps and key change lists.
+
+  Copyright (c) Microsoft Corporation
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PseudoRandomLib.h>
+#include <Library/UnitTestLib.h>
+#include "../HidKeyboardReport.h"
+
+#define UNIT_TEST_NAME     "HID Keyboard Report Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define FUZZ_ITERATIONS  20000
+
+//
+// N-key rollover keyboard: report 1 carries the modifiers and a 120 key
+// bitmap, report 2 is a consumer control the keyboard driver ignores.
+//
+STATIC CONST UINT8  mNkroKeyboardDescriptor[] = {
+  0x05, 0x01,       // Usage Page (Generic Desktop)
+  0x09, 0x06,       // Usage (Keyboard)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x01,       //   Report ID (1)
+  0x05, 0x07,       //   Usage Page (Keyboard)
+  0x19, 0xE0,       //   Usage Minimum (Left Control)
+  0x29, 0xE7,       //   Usage Maximum (Right GUI)
+  0x15, 0x00,       //   Logical Minimum (0)
+  0x25, 0x01,       //   Logical Maximum (1)
+  0x75, 0x01,       //   Report Size (1)
+  0x95, 0x08,       //   Report Count (8)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0x19, 0x00,       //   Usage Minimum (0)
+  0x29, 0x77,       //   Usage Maximum (0x77)
+  0x95, 0x78,       //   Report Count (120)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0x05, 0x08,       //   Usage Page (LEDs)
+  0x19, 0x01,       //   Usage Minimum (Num Lock)
+  0x29, 0x05,       //   Usage Maximum (Kana)
+  0x95, 0x05,       //   Report Count (5)
+  0x91, 0x02,       //   Output (Data, Variable, Absolute)
+  0x95, 0x03,       //   Report Count (3)
+  0x91, 0x01,       //   Output (Constant)
+  0xC0,             // End Collection
+  0x05, 0x0C,       // Usage Page (Consumer)
+  0x09, 0x01,       // Usage (Consumer Control)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x02,       //   Report ID (2)
+  0x19, 0x00,       //   Usage Minimum (0)
+  0x2A, 0xFF, 0x03, //   Usage Maximum (0x3FF)
+  0x15, 0x00,       //   Logical Minimum (0)
+  0x26, 0xFF, 0x03, //   Logical Maximum (0x3FF)
+  0x75, 0x10,       //   Report Size (16)
+  0x95, 0x01,       //   Report Count (1)
+  0x81, 0x00,       //   Input (Data, Array)
+  0xC0              // End Collection
+};
+
+#define NKRO_REPORT_SIZE      17
+#define NKRO_CONSUMER_OFFSET  47      // Start of the consumer control collection
+
+//
+// Keyboard that splits its keys over two reports: report 1 is a boot style
+// array of the first 0x65 keys, report 3 a bitmap of keys 0x68 - 0x77.
+//
+STATIC CONST UINT8  mSplitKeyboardDescriptor[] = {
+  0x05, 0x01,       // Usage Page (Generic Desktop)
+  0x09, 0x06,       // Usage (Keyboard)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x01,       //   Report ID (1)
+  0x05, 0x07,       //   Usage Page (Keyboard)
+  0x19, 0xE0,       //   Usage Minimum (Left Control)
+  0x29, 0xE7,       //   Usage Maximum (Right GUI)
+  0x15, 0x00,       //   Logical Minimum (0)
+  0x25, 0x01,       //   Logical Maximum (1)
+  0x75, 0x01,       //   Report Size (1)
+  0x95, 0x08,       //   Report Count (8)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0x75, 0x08,       //   Report Size (8)
+  0x95, 0x01,       //   Report Count (1)
+  0x81, 0x01,       //   Input (Constant)
+  0x19, 0x00,       //   Usage Minimum (0)
+  0x29, 0x65,       //   Usage Maximum (0x65)
+  0x25, 0x65,       //   Logical Maximum (0x65)
+  0x95, 0x06,       //   Report Count (6)
+  0x81, 0x00,       //   Input (Data, Array)
+  0x85, 0x03,       //   Report ID (3)
+  0x19, 0x68,       //   Usage Minimum (0x68)
+  0x29, 0x77,       //   Usage Maximum (0x77)
+  0x25, 0x01,       //   Logical Maximum (1)
+  0x75, 0x01,       //   Report Size (1)
+  0x95, 0x10,       //   Report Count (16)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0xC0              // End Collection
+};
+
+STATIC UINT64  mRandomState;
+
+STATIC
+BOOLEAN
+KeyIsDown (
+  IN CONST HID_KB_KEY_BITMAP  *Bitmap,
+  IN UINT32                   Usage
+  )
+{
+  return (BOOLEAN)((Bitmap->Bits[Usage / 32] & (1u << (Usage % 32))) != 0);
+}
+
+STATIC
+VOID
+SetKey (
+  IN OUT HID_KB_KEY_BITMAP  *Bitmap,
+  IN     UINT32             Usage
+  )
+{
+  Bitmap->Bits[Usage / 32] |= 1u << (Usage % 32);
+}
+
+/**
+ * @brief Build an NKRO report with the given modifier byte and keys.
+ */
+STATIC
+VOID
+BuildNkroReport (
+  OUT UINT8        *Report,
+  IN  UINT8        Modifiers,
+  IN  CONST UINT8  *Keys,
+  IN  UINTN        KeyCount
+  )
+{
+  UINTN  Index;
+
+  ZeroMem (Report, NKRO_REPORT_SIZE);
+  Report[0] = 1;
+  Report[1] = Modifiers;
+  for (Index = 0; Index < KeyCount; Index++) {
+    Report[2 + Keys[Index] / 8] |= (UINT8)(1 << (Keys[Index] % 8));
+  }
+}
+
+/**
+ * @brief The NKRO descriptor compiles to one keyboard report group.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestCompileNkroMap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  HID_KB_REPORT_MAP  *Map;
+
+  Status = HidKbCompileReportMap (mNkroKeyboardDescriptor, sizeof (mNkroKeyboardDescriptor), &Map);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  UT_ASSERT_TRUE (Map->ReportIdsUsed);
+  UT_ASSERT_EQUAL (Map->GroupCount, 1);
+  UT_ASSERT_EQUAL (Map->GroupByReportId[1], 0);
+  UT_ASSERT_EQUAL (Map->GroupByReportId[2], HID_KB_NO_REPORT_GROUP);
+  UT_ASSERT_EQUAL (Map->Groups[0].ReportId, 1);
+  UT_ASSERT_EQUAL (Map->Groups[0].FieldCount, 2);
+  UT_ASSERT_EQUAL (Map->Groups[0].MinReportSize, NKRO_REPORT_SIZE);
+  UT_ASSERT_TRUE (KeyIsDown (&Map->Groups[0].Cover, 0x77));
+  UT_ASSERT_TRUE (KeyIsDown (&Map->Groups[0].Cover, 0xE7));
+  UT_ASSERT_FALSE (KeyIsDown (&Map->Groups[0].Cover, 0x78));
+
+  HidKbFreeReportMap (Map);
+
+  //
+  // The consumer control collection alone has no keys.
+  //
+  Status = HidKbCompileReportMap (&mNkroKeyboardDescriptor[NKRO_CONSUMER_OFFSET], sizeof (mNkroKeyboardDescriptor) - NKRO_CONSUMER_OFFSET, &Map);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_UNSUPPORTED);
+  UT_ASSERT_TRUE (Map == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief NKRO reports set every pressed key, including more than six, and
+ * other report IDs are left alone.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestNkroReportToBitmap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINT8  Keys[] = { 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x1D, 0x77 };
+  EFI_STATUS          Status;
+  HID_KB_REPORT_MAP   *Map;
+  HID_KB_KEY_BITMAP   Current;
+  HID_KB_KEY_BITMAP   Next;
+  HID_KB_KEY_BITMAP   Expected;
+  UINT8               Report[NKRO_REPORT_SIZE];
+  UINTN               Index;
+
+  Status = HidKbCompileReportMap (mNkroKeyboardDescriptor, sizeof (mNkroKeyboardDescriptor), &Map);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  ZeroMem (&Current, sizeof (Current));
+  BuildNkroReport (Report, 0x22, Keys, ARRAY_SIZE (Keys));
+  Status = HidKbReportToBitmap (Map, Report, sizeof (Report), &Current, &Next);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  ZeroMem (&Expected, sizeof (Expected));
+  for (Index = 0; Index < ARRAY_SIZE (Keys); Index++) {
+    SetKey (&Expected, Keys[Index]);
+  }
+
+  SetKey (&Expected, 0xE1);
+  SetKey (&Expected, 0xE5);
+  UT_ASSERT_MEM_EQUAL (&Next, &Expected, sizeof (Expected));
+
+  //
+  // Reserved usages 0x00 - 0x03 never show up as keys.
+  //
+  Report[2] |= 0x0D;
+  Status     = HidKbReportToBitmap (Map, Report, sizeof (Report), &Current, &Next);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_MEM_EQUAL (&Next, &Expected, sizeof (Expected));
+
+  //
+  // Error rollover keeps the previous state.
+  //
+  Report[2] |= 0x02;
+  SetMem (&Next, sizeof (Next), 0xA5);
+  Status = HidKbReportToBitmap (Map, Report, sizeof (Report), &Current, &Next);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+  UT_ASSERT_EQUAL (Next.Bits[0], 0xA5A5A5A5);
+
+  Report[0] = 2;
+  UT_ASSERT_STATUS_EQUAL (HidKbReportToBitmap (Map, Report, sizeof (Report), &Current, &Next), EFI_NOT_FOUND);
+  Report[0] = 1;
+  UT_ASSERT_STATUS_EQUAL (HidKbReportToBitmap (Map, Report, sizeof (Report) - 1, &Current, &Next), EFI_BUFFER_TOO_SMALL);
+  UT_ASSERT_STATUS_EQUAL (HidKbReportToBitmap (Map, Report, 0, &Current, &Next), EFI_BUFFER_TOO_SMALL);
+
+  HidKbFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Keys reported by one report ID survive reports with another ID.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestSplitReportCover (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  HID_KB_REPORT_MAP  *Map;
+  HID_KB_KEY_BITMAP  State;
+  HID_KB_KEY_BITMAP  Next;
+  UINT8              ArrayReport[9];
+  UINT8              BitmapReport[3];
+
+  Status = HidKbCompileReportMap (mSplitKeyboardDescriptor, sizeof (mSplitKeyboardDescriptor), &Map);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Map->GroupCount, 2);
+  UT_ASSERT_EQUAL (Map->Groups[0].MinReportSize, sizeof (ArrayReport));
+  UT_ASSERT_EQUAL (Map->Groups[1].MinReportSize, sizeof (BitmapReport));
+
+  ZeroMem (&State, sizeof (State));
+
+  //
+  // Report 3: key 0x68 and 0x77 down.
+  //
+  BitmapReport[0] = 3;
+  BitmapReport[1] = 0x01;
+  BitmapReport[2] = 0x80;
+  UT_ASSERT_NOT_EFI_ERROR (HidKbReportToBitmap (Map, BitmapReport, sizeof (BitmapReport), &State, &Next));
+  CopyMem (&State, &Next, sizeof (State));
+
+  //
+  // Report 1: Left Control and 'a' down, an out of range index is ignored.
+  //
+  ZeroMem (ArrayReport, sizeof (ArrayReport));
+  ArrayReport[0] = 1;
+  ArrayReport[1] = 0x01;
+  ArrayReport[3] = 0x04;
+  ArrayReport[4] = 0x99;
+  UT_ASSERT_NOT_EFI_ERROR (HidKbReportToBitmap (Map, ArrayReport, sizeof (ArrayReport), &State, &Next));
+  CopyMem (&State, &Next, sizeof (State));
+
+  UT_ASSERT_TRUE (KeyIsDown (&State, 0x68));
+  UT_ASSERT_TRUE (KeyIsDown (&State, 0x77));
+  UT_ASSERT_TRUE (KeyIsDown (&State, 0xE0));
+  UT_ASSERT_TRUE (KeyIsDown (&State, 0x04));
+  UT_ASSERT_FALSE (KeyIsDown (&State, 0x99));
+
+  //
+  // Releasing everything in report 1 leaves the report 3 keys down.
+  //
+  ZeroMem (ArrayReport, sizeof (ArrayReport));
+  ArrayReport[0] = 1;
+  UT_ASSERT_NOT_EFI_ERROR (HidKbReportToBitmap (Map, ArrayReport, sizeof (ArrayReport), &State, &Next));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0x68));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0x77));
+  UT_ASSERT_FALSE (KeyIsDown (&Next, 0xE0));
+  UT_ASSERT_FALSE (KeyIsDown (&Next, 0x04));
+
+  //
+  // Error rollover in the array keeps the previous state.
+  //
+  ArrayReport[5] = 0x01;
+  UT_ASSERT_STATUS_EQUAL (HidKbReportToBitmap (Map, ArrayReport, sizeof (ArrayReport), &State, &Next), EFI_NOT_READY);
+
+  HidKbFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Boot reports of any length translate into the same bitmap as NKRO.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestBootReportToBitmap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_KB_KEY_BITMAP  Next;
+  UINT8              Report[10];
+
+  Report[0] = 0x81;
+  Report[1] = 0x00;
+  Report[2] = 0x04;
+  Report[3] = 0x00;
+  Report[4] = 0x03;
+  Report[5] = 0x2C;
+  Report[6] = 0x00;
+  Report[7] = 0x00;
+  Report[8] = 0x65;
+  Report[9] = 0x1E;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidKbBootReportToBitmap (Report, sizeof (Report), &Next));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0xE0));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0xE7));
+  UT_ASSERT_FALSE (KeyIsDown (&Next, 0xE1));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0x04));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0x2C));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0x65));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0x1E));
+  UT_ASSERT_FALSE (KeyIsDown (&Next, 0x03));
+  UT_ASSERT_FALSE (KeyIsDown (&Next, 0x00));
+
+  //
+  // A report with only the header releases everything.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (HidKbBootReportToBitmap (Report, 2, &Next));
+  UT_ASSERT_TRUE (KeyIsDown (&Next, 0xE0));
+  UT_ASSERT_FALSE (KeyIsDown (&Next, 0x04));
+
+  UT_ASSERT_STATUS_EQUAL (HidKbBootReportToBitmap (Report, 1, &Next), EFI_BUFFER_TOO_SMALL);
+
+  Report[3] = 0x01;
+  SetMem (&Next, sizeof (Next), 0xA5);
+  UT_ASSERT_STATUS_EQUAL (HidKbBootReportToBitmap (Report, sizeof (Report), &Next), EFI_NOT_READY);
+  UT_ASSERT_EQUAL (Next.Bits[7], 0xA5A5A5A5);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Changes list modifiers, then releases, then presses.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestDiffOrdering (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_KB_KEY_BITMAP  Old;
+  HID_KB_KEY_BITMAP  New;
+  HID_KEY            Changes[HID_KB_MAX_KEY_CHANGES];
+  UINTN              Count;
+
+  ZeroMem (&Old, sizeof (Old));
+  ZeroMem (&New, sizeof (New));
+  SetKey (&Old, 0xE1);
+  SetKey (&Old, 0x04);
+  SetKey (&Old, 0x05);
+  SetKey (&Old, 0xE8);
+  SetKey (&New, 0xE0);
+  SetKey (&New, 0x05);
+  SetKey (&New, 0x06);
+  SetKey (&New, 0x77);
+
+  Count = HidKbDiffBitmaps (&Old, &New, Changes, ARRAY_SIZE (Changes));
+  UT_ASSERT_EQUAL (Count, 6);
+  UT_ASSERT_TRUE (Changes[0].KeyCode == 0xE0 && Changes[0].Down);
+  UT_ASSERT_TRUE (Changes[1].KeyCode == 0xE1 && !Changes[1].Down);
+  UT_ASSERT_TRUE (Changes[2].KeyCode == 0x04 && !Changes[2].Down);
+  UT_ASSERT_TRUE (Changes[3].KeyCode == 0xE8 && !Changes[3].Down);
+  UT_ASSERT_TRUE (Changes[4].KeyCode == 0x06 && Changes[4].Down);
+  UT_ASSERT_TRUE (Changes[5].KeyCode == 0x77 && Changes[5].Down);
+
+  //
+  // Nothing changed, nothing listed; the list is capped.
+  //
+  UT_ASSERT_EQUAL (HidKbDiffBitmaps (&New, &New, Changes, ARRAY_SIZE (Changes)), 0);
+  UT_ASSERT_EQUAL (HidKbDiffBitmaps (&Old, &New, Changes, 3), 3);
+  UT_ASSERT_TRUE (Changes[2].KeyCode == 0x04 && !Changes[2].Down);
+
+  //
+  // Every key at once.
+  //
+  SetMem (&New, sizeof (New), 0xFF);
+  ZeroMem (&Old, sizeof (Old));
+  UT_ASSERT_EQUAL (HidKbDiffBitmaps (&Old, &New, Changes, ARRAY_SIZE (Changes)), HID_KB_MAX_KEY_CHANGES);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Random NKRO reports match a byte by byte model, and applying the
+ * change list to the old state always yields the new state.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestFuzzReports (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  HID_KB_REPORT_MAP  *Map;
+  HID_KB_KEY_BITMAP  State;
+  HID_KB_KEY_BITMAP  Next;
+  HID_KB_KEY_BITMAP  Expected;
+  HID_KB_KEY_BITMAP  Replayed;
+  HID_KEY            Changes[HID_KB_MAX_KEY_CHANGES];
+  UINT8              Report[NKRO_REPORT_SIZE];
+  UINTN              Iteration;
+  UINTN              Index;
+  UINTN              Count;
+  UINT32             Usage;
+  BOOLEAN            Rollover;
+
+  Status = HidKbCompileReportMap (mNkroKeyboardDescriptor, sizeof (mNkroKeyboardDescriptor), &Map);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  mRandomState = 0x4E4B524F;
+  ZeroMem (&State, sizeof (State));
+  for (Iteration = 0; Iteration < FUZZ_ITERATIONS; Iteration++) {
+    //
+    // Mostly sparse reports, like real typing, with the odd dense one.
+    //
+    ZeroMem (Report, sizeof (Report));
+    Report[0] = 1;
+    for (Index = 1; Index < sizeof (Report); Index++) {
+      if ((Iteration % 16 == 0) || (PseudoRandomNext (&mRandomState) % 8 == 0)) {
+        Report[Index] = (UINT8)PseudoRandomNext (&mRandomState);
+      }
+    }
+
+    ZeroMem (&Expected, sizeof (Expected));
+    Rollover = (BOOLEAN)((Report[2] & 0x02) != 0);
+    for (Index = 0; Index < 8; Index++) {
+      if ((Report[1] & (1 << Index)) != 0) {
+        SetKey (&Expected, 0xE0 + (UINT32)Index);
+      }
+    }
+
+    for (Usage = 4; Usage < 0x78; Usage++) {
+      if ((Report[2 + Usage / 8] & (1 << (Usage % 8))) != 0) {
+        SetKey (&Expected, Usage);
+      }
+    }
+
+    Status = HidKbReportToBitmap (Map, Report, sizeof (Report), &State, &Next);
+    if (Rollover) {
+      UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+      continue;
+    }
+
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_MEM_EQUAL (&Next, &Expected, sizeof (Expected));
+
+    Count = HidKbDiffBitmaps (&State, &Next, Changes, ARRAY_SIZE (Changes));
+    CopyMem (&Replayed, &State, sizeof (Replayed));
+    for (Index = 0; Index < Count; Index++) {
+      UT_ASSERT_EQUAL (KeyIsDown (&Replayed, Changes[Index].KeyCode), !Changes[Index].Down);
+      Replayed.Bits[Changes[Index].KeyCode / 32] ^= 1u << (Changes[Index].KeyCode % 32);
+    }
+
+    UT_ASSERT_MEM_EQUAL (&Replayed, &Next, sizeof (Next));
+    CopyMem (&State, &Next, sizeof (State));
+  }
+
+  //
+  // Random bytes of every length never read past the report.
+  //
+  for (Iteration = 0; Iteration < FUZZ_ITERATIONS; Iteration++) {
+    UINT8  *Exact;
+    UINTN  Size;
+
+    Size  = (UINTN)(PseudoRandomNext (&mRandomState) % (sizeof (Report) + 4)) + 1;
+    Exact = AllocatePool (Size);
+    UT_ASSERT_NOT_NULL (Exact);
+    for (Index = 0; Index < Size; Index++) {
+      Exact[Index] = (UINT8)PseudoRandomNext (&mRandomState);
+    }
+
+    HidKbReportToBitmap (Map, Exact, Size, &State, &Next);
+    HidKbBootReportToBitmap (Exact, Size, &Next);
+    FreePool (Exact);
+  }
+
+  HidKbFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  keyboard report translation and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UefiTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ReportSuiteHandle;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Create a suite
+  //
+  Status = CreateUnitTestSuite (&ReportSuiteHandle, Framework, "HidKeyboardDxe keyboard report translation", "HidKeyboardDxe.HID.Report", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ReportSuiteHandle\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // Register Tests
+  //
+  AddTestCase (ReportSuiteHandle, "Compile an NKRO keyboard report descriptor", "CompileMap", TestCompileNkroMap, NULL, NULL, NULL);
+  AddTestCase (ReportSuiteHandle, "Translate NKRO reports into key bitmaps", "NkroReport", TestNkroReportToBitmap, NULL, NULL, NULL);
+  AddTestCase (ReportSuiteHandle, "Keep keys of other report IDs", "SplitReports", TestSplitReportCover, NULL, NULL, NULL);
+  AddTestCase (ReportSuiteHandle, "Translate boot reports into key bitmaps", "BootReport", TestBootReportToBitmap, NULL, NULL, NULL);
+  AddTestCase (ReportSuiteHandle, "List key changes in processing order", "DiffOrdering", TestDiffOrdering, NULL, NULL, NULL);
+  AddTestCase (ReportSuiteHandle, "Random reports match the model and replay", "Fuzz", TestFuzzReports, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UefiTestMain ();
+}
@@ -0,0 +1,653 @@
+/** @file HidDigitizerReport.c
+
+  Translates multi-touch digitizer HID reports into absolute pointer state.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/HidReportDescriptorLib.h>
+
+#include "HidDigitizerReport.h"
+
+#define HID_GENERIC_DESKTOP_USAGE_PAGE  0x01
+#define HID_GENERIC_DESKTOP_USAGE_X     0x30
+#define HID_GENERIC_DESKTOP_USAGE_Y     0x31
+#define HID_BUTTON_USAGE_PAGE           0x09
+
+/**
+  Check whether a field is a value of the contact report of a digitizer.
+
+  @param  Field - the report field.
+
+  @retval TRUE  - the field is a variable input of a touch pad or touch screen.
+  @retval FALSE - the field is ignored.
+**/
+STATIC
+BOOLEAN
+IsDigitizerField (
+  IN CONST HID_REPORT_FIELD  *Field
+  )
+{
+  if ((Field->ReportType != HidReportInput) ||
+      ((Field->Flags & HID_MAIN_ITEM_VARIABLE) == 0) ||
+      (Field->UsageMinimum > Field->UsageMaximum))
+  {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((Field->ApplicationUsage == HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_TOUCH_PAD)) ||
+                   (Field->ApplicationUsage == HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_TOUCH_SCREEN)));
+}
+
+/**
+  Record where a value sits, unless an earlier field already reports it.
+
+  @param  Value   - the value to record.
+  @param  Field   - the field that holds the value.
+  @param  Element - the element of the field that holds the value.
+**/
+STATIC
+VOID
+SetDigitizerValue (
+  OUT HID_DIGITIZER_VALUE     *Value,
+  IN  CONST HID_REPORT_FIELD  *Field,
+  IN  UINT16                  Element
+  )
+{
+  if (Value->Present) {
+    return;
+  }
+
+  CopyMem (&Value->Field, Field, sizeof (*Field));
+  Value->Element = Element;
+  Value->Present = TRUE;
+}
+
+/**
+  Read a value from a report that holds every value of the map.
+
+  @param  Value       - the value.
+  @param  Report      - the input report.
+  @param  ReportSize  - size of the report in bytes.
+
+  @return The value, 0 if the report has no such value.
+**/
+STATIC
+INT32
+GetDigitizerValue (
+  IN CONST HID_DIGITIZER_VALUE  *Value,
+  IN CONST UINT8                *Report,
+  IN UINTN                      ReportSize
+  )
+{
+  UINT32  Raw;
+
+  if (!Value->Present || EFI_ERROR (HidGetReportFieldValue (&Value->Field, Report, ReportSize, Value->Element, &Raw))) {
+    return 0;
+  }
+
+  return HidSignExtendFieldValue (&Value->Field, Raw);
+}
+
+/**
+  Grow the report size of a map to hold a value.
+
+  @param  Map   - the digitizer map.
+  @param  Value - the value.
+**/
+STATIC
+VOID
+AddValueSize (
+  IN OUT HID_DIGITIZER_MAP          *Map,
+  IN     CONST HID_DIGITIZER_VALUE  *Value
+  )
+{
+  UINT32  EndBit;
+
+  if (!Value->Present) {
+    return;
+  }
+
+  EndBit = Value->Field.BitOffset + (UINT32)(Value->Element + 1) * Value->Field.BitSize;
+  if ((EndBit + 7) / 8 > Map->MinReportSize) {
+    Map->MinReportSize = (UINT16)((EndBit + 7) / 8);
+  }
+}
+
+/**
+  Assign one element of a contact report field to the value it reports.
+
+  @param  Map         - the digitizer map being compiled.
+  @param  Collections - the finger collection of each slot of the map.
+  @param  Field       - the field.
+  @param  Element     - the element of the field.
+  @param  Usage       - the usage of the element.
+**/
+STATIC
+VOID
+AddDigitizerElement (
+  IN OUT HID_DIGITIZER_MAP       *Map,
+  IN OUT UINT16                  *Collections,
+  IN     CONST HID_REPORT_FIELD  *Field,
+  IN     UINT16                  Element,
+  IN     UINT32                  Usage
+  )
+{
+  HID_DIGITIZER_SLOT  *Slot;
+  UINT32              Index;
+
+  if (Field->CollectionUsage != HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_FINGER)) {
+    //
+    // Values that describe the whole frame.
+    //
+    if (Usage == HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_CONTACT_COUNT)) {
+      SetDigitizerValue (&Map->ContactCount, Field, Element);
+    } else if ((HID_USAGE_PAGE (Usage) == HID_BUTTON_USAGE_PAGE) &&
+               (HID_USAGE_ID (Usage) >= 1) && (HID_USAGE_ID (Usage) <= HID_DIGITIZER_MAX_BUTTONS))
+    {
+      SetDigitizerValue (&Map->Buttons[HID_USAGE_ID (Usage) - 1], Field, Element);
+    }
+
+    return;
+  }
+
+  //
+  // Every finger collection is one contact slot, numbered in descriptor order.
+  //
+  for (Index = 0; Index < Map->SlotCount; Index++) {
+    if (Collections[Index] == Field->CollectionIndex) {
+      break;
+    }
+  }
+
+  if (Index == Map->SlotCount) {
+    if (Map->SlotCount == HID_DIGITIZER_MAX_CONTACTS) {
+      return;
+    }
+
+    Collections[Map->SlotCount++] = Field->CollectionIndex;
+  }
+
+  Slot = &Map->Slots[Index];
+  switch (Usage) {
+    case HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_TIP_SWITCH):
+      SetDigitizerValue (&Slot->TipSwitch, Field, Element);
+      break;
+    case HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_CONFIDENCE):
+      SetDigitizerValue (&Slot->Confidence, Field, Element);
+      break;
+    case HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_CONTACT_ID):
+      SetDigitizerValue (&Slot->ContactId, Field, Element);
+      break;
+    case HID_USAGE (HID_GENERIC_DESKTOP_USAGE_PAGE, HID_GENERIC_DESKTOP_USAGE_X):
+      SetDigitizerValue (&Slot->X, Field, Element);
+      break;
+    case HID_USAGE (HID_GENERIC_DESKTOP_USAGE_PAGE, HID_GENERIC_DESKTOP_USAGE_Y):
+      SetDigitizerValue (&Slot->Y, Field, Element);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+  Compile the contact input fields of a report descriptor into a digitizer map.
+
+  @param  Descriptor      - the report descriptor.
+  @param  DescriptorSize  - size of the report descriptor in bytes.
+  @param  Map             - returns the digitizer map, free it with HidDigitizerFreeReportMap.
+
+  @retval EFI_SUCCESS           - the digitizer map was compiled.
+  @retval EFI_INVALID_PARAMETER - a pointer is NULL.
+  @retval EFI_UNSUPPORTED       - the descriptor has no finger collection with a tip switch and coordinates.
+  @retval EFI_OUT_OF_RESOURCES  - the digitizer map could not be allocated.
+  @retval other                 - the descriptor could not be parsed.
+**/
+EFI_STATUS
+HidDigitizerCompileReportMap (
+  IN  CONST UINT8        *Descriptor,
+  IN  UINTN              DescriptorSize,
+  OUT HID_DIGITIZER_MAP  **Map
+  )
+{
+  EFI_STATUS          Status;
+  HID_REPORT_LAYOUT   *Layout;
+  HID_DIGITIZER_MAP   *NewMap;
+  HID_DIGITIZER_SLOT  *Slot;
+  HID_REPORT_FIELD    *Field;
+  UINT16              Collections[HID_DIGITIZER_MAX_CONTACTS];
+  UINT32              ApplicationUsage;
+  UINT32              Usage;
+  UINTN               Index;
+  UINT32              SlotIndex;
+  UINT16              Element;
+
+  if ((Descriptor == NULL) || (Map == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Map = NULL;
+
+  Status = HidParseReportDescriptor (Descriptor, DescriptorSize, &Layout);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "[%a] - Failed to parse report descriptor: %r\n", __FUNCTION__, Status));
+    return Status;
+  }
+
+  NewMap = AllocateZeroPool (sizeof (*NewMap));
+  if (NewMap == NULL) {
+    HidFreeReportLayout (Layout);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // The contact report is the report of the first finger collection. Devices
+  // that also describe a mouse or configuration collection report those with
+  // other report IDs.
+  //
+  ApplicationUsage = 0;
+  for (Index = 0; Index < Layout->FieldCount; Index++) {
+    Field = &Layout->Fields[Index];
+    if (IsDigitizerField (Field) &&
+        (Field->CollectionUsage == HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_FINGER)))
+    {
+      ApplicationUsage = Field->ApplicationUsage;
+      NewMap->ReportId = Field->ReportId;
+      break;
+    }
+  }
+
+  for (Index = 0; Index < Layout->FieldCount; Index++) {
+    Field = &Layout->Fields[Index];
+    if (!IsDigitizerField (Field) || (Field->ApplicationUsage != ApplicationUsage) || (Field->ReportId != NewMap->ReportId)) {
+      continue;
+    }
+
+    //
+    // Element N reports usage UsageMinimum + N, elements past the range repeat
+    // UsageMaximum and add nothing.
+    //
+    for (Element = 0; Element < Field->Count; Element++) {
+      Usage = Field->UsageMinimum + Element;
+      AddDigitizerElement (NewMap, Collections, Field, Element, Usage);
+      if (Usage >= Field->UsageMaximum) {
+        break;
+      }
+    }
+  }
+
+  NewMap->ReportIdsUsed = Layout->ReportIdsUsed;
+  HidFreeReportLayout (Layout);
+
+  //
+  // Keep the slots that say where a contact is and whether it touches.
+  //
+  SlotIndex = 0;
+  for (Index = 0; Index < NewMap->SlotCount; Index++) {
+    Slot = &NewMap->Slots[Index];
+    if (!Slot->TipSwitch.Present || !Slot->X.Present || !Slot->Y.Present) {
+      continue;
+    }
+
+    if (SlotIndex != Index) {
+      CopyMem (&NewMap->Slots[SlotIndex], Slot, sizeof (*Slot));
+    }
+
+    SlotIndex++;
+  }
+
+  NewMap->SlotCount = SlotIndex;
+  if (NewMap->SlotCount == 0) {
+    DEBUG ((DEBUG_WARN, "[%a] - Report descriptor has no usable finger collections.\n", __FUNCTION__));
+    FreePool (NewMap);
+    return EFI_UNSUPPORTED;
+  }
+
+  NewMap->TouchPad = (BOOLEAN)(ApplicationUsage == HID_USAGE (HID_DIGITIZER_USAGE_PAGE, HID_DIGITIZER_USAGE_TOUCH_PAD));
+  NewMap->MinX     = NewMap->Slots[0].X.Field.LogicalMinimum;
+  NewMap->MaxX     = NewMap->Slots[0].X.Field.LogicalMaximum;
+  NewMap->MinY     = NewMap->Slots[0].Y.Field.LogicalMinimum;
+  NewMap->MaxY     = NewMap->Slots[0].Y.Field.LogicalMaximum;
+  if ((NewMap->MaxX <= NewMap->MinX) || (NewMap->MaxY <= NewMap->MinY)) {
+    DEBUG ((DEBUG_WARN, "[%a] - Contact coordinates have an empty logical range.\n", __FUNCTION__));
+    FreePool (NewMap);
+    return EFI_UNSUPPORTED;
+  }
+
+  for (Index = 0; Index < NewMap->SlotCount; Index++) {
+    Slot = &NewMap->Slots[Index];
+    AddValueSize (NewMap, &Slot->TipSwitch);
+    AddValueSize (NewMap, &Slot->Confidence);
+    AddValueSize (NewMap, &Slot->ContactId);
+    AddValueSize (NewMap, &Slot->X);
+    AddValueSize (NewMap, &Slot->Y);
+  }
+
+  AddValueSize (NewMap, &NewMap->ContactCount);
+  for (Index = 0; Index < HID_DIGITIZER_MAX_BUTTONS; Index++) {
+    AddValueSize (NewMap, &NewMap->Buttons[Index]);
+  }
+
+  *Map = NewMap;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free a digitizer map returned by HidDigitizerCompileReportMap.
+
+  @param  Map - the digitizer map, may be NULL.
+**/
+VOID
+HidDigitizerFreeReportMap (
+  IN HID_DIGITIZER_MAP  *Map
+  )
+{
+  if (Map != NULL) {
+    FreePool (Map);
+  }
+}
+
+/**
+  Add a digitizer report to the frame being assembled.
+
+  @param  Map         - the digitizer map of the device.
+  @param  Tracker     - the frame assembly state of the device.
+  @param  Report      - the input report, starting with the report ID if IDs are used.
+  @param  ReportSize  - size of the report in bytes.
+  @param  Frame       - returns the frame when it is complete.
+
+  @retval EFI_SUCCESS           - Frame holds the contacts touching the digitizer.
+  @retval EFI_NOT_READY         - the frame continues in the next report.
+  @retval EFI_NOT_FOUND         - the report ID is not the contact report.
+  @retval EFI_BUFFER_TOO_SMALL  - the report is shorter than its fields.
+**/
+EFI_STATUS
+HidDigitizerParseReport (
+  IN     CONST HID_DIGITIZER_MAP  *Map,
+  IN OUT HID_DIGITIZER_TRACKER    *Tracker,
+  IN     CONST UINT8              *Report,
+  IN     UINTN                    ReportSize,
+  OUT    HID_DIGITIZER_FRAME      *Frame
+  )
+{
+  HID_DIGITIZER_FRAME       *Pending;
+  CONST HID_DIGITIZER_SLOT  *Slot;
+  HID_DIGITIZER_CONTACT     *Contact;
+  INT32                     Count;
+  UINT32                    Index;
+
+  if ((ReportSize == 0) || (Map->ReportIdsUsed && (Report[0] != Map->ReportId))) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (ReportSize < Map->MinReportSize) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Pending = &Tracker->Pending;
+
+  //
+  // A report with a contact count starts a frame. In hybrid mode the reports
+  // that carry the rest of its contacts have a count of 0.
+  //
+  Count = Map->ContactCount.Present ? GetDigitizerValue (&Map->ContactCount, Report, ReportSize) : (INT32)Map->SlotCount;
+  if ((Count > 0) || (Tracker->Received >= Tracker->Expected)) {
+    ZeroMem (Pending, sizeof (*Pending));
+    Tracker->Expected = (UINT32)MAX (Count, 0);
+    Tracker->Received = 0;
+    for (Index = 0; Index < HID_DIGITIZER_MAX_BUTTONS; Index++) {
+      if (GetDigitizerValue (&Map->Buttons[Index], Report, ReportSize) != 0) {
+        Pending->Buttons |= 1u << Index;
+      }
+    }
+  }
+
+  for (Index = 0; (Index < Map->SlotCount) && (Tracker->Received < Tracker->Expected); Index++) {
+    Slot = &Map->Slots[Index];
+    Tracker->Received++;
+
+    //
+    // Contacts that lifted off, and those the device takes for a palm, do not touch.
+    //
+    if ((GetDigitizerValue (&Slot->TipSwitch, Report, ReportSize) == 0) ||
+        (Slot->Confidence.Present && (GetDigitizerValue (&Slot->Confidence, Report, ReportSize) == 0)) ||
+        (Pending->ContactCount == HID_DIGITIZER_MAX_CONTACTS))
+    {
+      continue;
+    }
+
+    Contact     = &Pending->Contacts[Pending->ContactCount++];
+    Contact->Id = Slot->ContactId.Present ? (UINT32)GetDigitizerValue (&Slot->ContactId, Report, ReportSize) : Tracker->Received;
+    Contact->X  = GetDigitizerValue (&Slot->X, Report, ReportSize);
+    Contact->Y  = GetDigitizerValue (&Slot->Y, Report, ReportSize);
+  }
+
+  if (Tracker->Received < Tracker->Expected) {
+    return EFI_NOT_READY;
+  }
+
+  CopyMem (Frame, Pending, sizeof (*Frame));
+  return EFI_SUCCESS;
+}
+
+/**
+  Find a contact of a frame by its ID.
+
+  @param  Frame - the frame.
+  @param  Id    - the contact ID.
+
+  @return The contact, NULL if the frame has no contact with that ID.
+**/
+STATIC
+CONST HID_DIGITIZER_CONTACT *
+FindContact (
+  IN CONST HID_DIGITIZER_FRAME  *Frame,
+  IN UINT32                     Id
+  )
+{
+  UINT32  Index;
+
+  for (Index = 0; Index < Frame->ContactCount; Index++) {
+    if (Frame->Contacts[Index].Id == Id) {
+      return &Frame->Contacts[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Scale digitizer motion to pointer motion, carrying the fraction to the next call.
+
+  @param  Delta         - motion in digitizer units.
+  @param  DigitizerMin  - logical minimum of the digitizer axis.
+  @param  DigitizerMax  - logical maximum of the digitizer axis.
+  @param  PointerMin    - minimum of the pointer axis.
+  @param  PointerMax    - maximum of the pointer axis.
+  @param  Remainder     - the fraction carried between calls.
+
+  @return Motion in pointer units.
+**/
+STATIC
+INT64
+ScaleMotion (
+  IN     INT64   Delta,
+  IN     INT32   DigitizerMin,
+  IN     INT32   DigitizerMax,
+  IN     UINT64  PointerMin,
+  IN     UINT64  PointerMax,
+  IN OUT INT64   *Remainder
+  )
+{
+  return DivS64x64Remainder (
+           MultS64x64 (Delta, (INT64)(PointerMax - PointerMin)) + *Remainder,
+           (INT64)DigitizerMax - DigitizerMin,
+           Remainder
+           );
+}
+
+/**
+  Scale a digitizer coordinate to a pointer coordinate.
+
+  @param  Value         - the coordinate in digitizer units.
+  @param  DigitizerMin  - logical minimum of the digitizer axis.
+  @param  DigitizerMax  - logical maximum of the digitizer axis.
+  @param  PointerMin    - minimum of the pointer axis.
+  @param  PointerMax    - maximum of the pointer axis.
+
+  @return The coordinate in pointer units.
+**/
+STATIC
+UINT64
+ScaleCoordinate (
+  IN INT32   Value,
+  IN INT32   DigitizerMin,
+  IN INT32   DigitizerMax,
+  IN UINT64  PointerMin,
+  IN UINT64  PointerMax
+  )
+{
+  Value = MIN (MAX (Value, DigitizerMin), DigitizerMax);
+  return PointerMin + DivU64x64Remainder (
+                        MultU64x64 ((UINT64)((INT64)Value - DigitizerMin), PointerMax - PointerMin),
+                        (UINT64)((INT64)DigitizerMax - DigitizerMin),
+                        NULL
+                        );
+}
+
+/**
+  Move a pointer coordinate, staying within its range.
+
+  @param  Current - the coordinate.
+  @param  Delta   - the motion.
+  @param  Min     - minimum of the axis.
+  @param  Max     - maximum of the axis.
+
+  @return The moved coordinate.
+**/
+STATIC
+UINT64
+MoveCoordinate (
+  IN UINT64  Current,
+  IN INT64   Delta,
+  IN UINT64  Min,
+  IN UINT64  Max
+  )
+{
+  return (UINT64)MIN (MAX ((INT64)Current + Delta, (INT64)Min), (INT64)Max);
+}
+
+/**
+  Turn a complete frame into pointer state.
+
+  A touch screen puts the pointer at its first contact and reports the touch as
+  the active button. A touch pad moves the pointer with one finger, scrolls
+  with two by moving Z with their vertical motion, and reports its pad button
+  as the active button, or as the alternate button when clicked with two
+  fingers. Coordinates are scaled from the digitizer range to the pointer mode.
+
+  @param  Map      - the digitizer map of the device.
+  @param  Tracker  - the gesture state of the device.
+  @param  Frame    - the frame, as returned by HidDigitizerParseReport.
+  @param  Mode     - the absolute pointer mode.
+  @param  State    - the pointer state to update.
+**/
+VOID
+HidDigitizerApplyFrame (
+  IN     CONST HID_DIGITIZER_MAP          *Map,
+  IN OUT HID_DIGITIZER_TRACKER            *Tracker,
+  IN     CONST HID_DIGITIZER_FRAME        *Frame,
+  IN     CONST EFI_ABSOLUTE_POINTER_MODE  *Mode,
+  IN OUT EFI_ABSOLUTE_POINTER_STATE       *State
+  )
+{
+  CONST HID_DIGITIZER_CONTACT  *Contact;
+  CONST HID_DIGITIZER_CONTACT  *Previous;
+  INT64                        DeltaY;
+  UINT32                       Index;
+
+  if (!Map->TouchPad) {
+    //
+    // Touch screen: the first finger down is the pointer.
+    //
+    if (Frame->ContactCount == 0) {
+      State->ActiveButtons = 0;
+    } else {
+      State->CurrentX      = ScaleCoordinate (Frame->Contacts[0].X, Map->MinX, Map->MaxX, Mode->AbsoluteMinX, Mode->AbsoluteMaxX);
+      State->CurrentY      = ScaleCoordinate (Frame->Contacts[0].Y, Map->MinY, Map->MaxY, Mode->AbsoluteMinY, Mode->AbsoluteMaxY);
+      State->ActiveButtons = EFI_ABSP_TouchActive;
+    }
+
+    CopyMem (&Tracker->Last, Frame, sizeof (*Frame));
+    return;
+  }
+
+  //
+  // Touch pad: pad buttons are mouse buttons, clicking with two fingers is the
+  // alternate (right) button.
+  //
+  State->ActiveButtons = Frame->Buttons;
+  if (((Frame->Buttons & BIT0) != 0) && (Frame->ContactCount >= 2)) {
+    State->ActiveButtons = (Frame->Buttons & ~BIT0) | EFI_ABS_AltActive;
+  }
+
+  //
+  // Motion is measured between two frames with the same fingers down, a
+  // finger landing or lifting moves nothing.
+  //
+  if ((Frame->ContactCount == 0) || (Frame->ContactCount != Tracker->Last.ContactCount) || (Frame->ContactCount > 2)) {
+    Tracker->RemainderX = 0;
+    Tracker->RemainderY = 0;
+    Tracker->RemainderZ = 0;
+  } else if (Frame->ContactCount == 1) {
+    Contact  = &Frame->Contacts[0];
+    Previous = FindContact (&Tracker->Last, Contact->Id);
+    if (Previous != NULL) {
+      State->CurrentX = MoveCoordinate (
+                          State->CurrentX,
+                          ScaleMotion (Contact->X - Previous->X, Map->MinX, Map->MaxX, Mode->AbsoluteMinX, Mode->AbsoluteMaxX, &Tracker->RemainderX),
+                          Mode->AbsoluteMinX,
+                          Mode->AbsoluteMaxX
+                          );
+      State->CurrentY = MoveCoordinate (
+                          State->CurrentY,
+                          ScaleMotion (Contact->Y - Previous->Y, Map->MinY, Map->MaxY, Mode->AbsoluteMinY, Mode->AbsoluteMaxY, &Tracker->RemainderY),
+                          Mode->AbsoluteMinY,
+                          Mode->AbsoluteMaxY
+                          );
+    }
+  } else {
+    //
+    // Two finger scroll: Z follows the mean vertical motion of both fingers.
+    //
+    DeltaY = 0;
+    for (Index = 0; Index < 2; Index++) {
+      Contact  = &Frame->Contacts[Index];
+      Previous = FindContact (&Tracker->Last, Contact->Id);
+      if (Previous == NULL) {
+        break;
+      }
+
+      DeltaY += Contact->Y - Previous->Y;
+    }
+
+    if (Index == 2) {
+      State->CurrentZ = MoveCoordinate (
+                          State->CurrentZ,
+                          ScaleMotion (DeltaY / 2, Map->MinY, Map->MaxY, Mode->AbsoluteMinZ, Mode->AbsoluteMaxZ, &Tracker->RemainderZ),
+                          Mode->AbsoluteMinZ,
+                          Mode->AbsoluteMaxZ
+                          );
+    }
+  }
+
+  CopyMem (&Tracker->Last, Frame, sizeof (*Frame));
+}
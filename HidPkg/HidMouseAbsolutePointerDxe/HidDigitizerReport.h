@@ -0,0 +1,194 @@
+/** @file HidDigitizerReport.h
+
+  Translates multi-touch digitizer HID reports into absolute pointer state.
+
+  Touch pads and touch screens are described by a compiled digitizer map: for
+  the input report that carries finger collections, where each contact slot's
+  tip switch, confidence, contact identifier and coordinates sit, and where the
+  contact count and pad buttons sit. A report is read with a fixed number of
+  field reads per slot, whatever the size of its descriptor.
+
+  Reports are assembled into frames. A device in hybrid mode reports more
+  contacts than one report holds over several reports, only the first of which
+  carries the contact count. Complete frames are then turned into pointer
+  state: a touch screen positions the pointer at its first contact, a touch pad
+  moves it by the motion of a single finger and scrolls (moves Z) with two.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef _HID_DIGITIZER_REPORT_H_
+#define _HID_DIGITIZER_REPORT_H_
+
+#include <Uefi.h>
+#include <Protocol/AbsolutePointer.h>
+#include <Library/HidReportDescriptorLib.h>
+
+#define HID_DIGITIZER_USAGE_PAGE           0x0D
+#define HID_DIGITIZER_USAGE_TOUCH_SCREEN   0x04
+#define HID_DIGITIZER_USAGE_TOUCH_PAD      0x05
+#define HID_DIGITIZER_USAGE_FINGER         0x22
+#define HID_DIGITIZER_USAGE_TIP_SWITCH     0x42
+#define HID_DIGITIZER_USAGE_CONFIDENCE     0x47
+#define HID_DIGITIZER_USAGE_CONTACT_ID     0x51
+#define HID_DIGITIZER_USAGE_CONTACT_COUNT  0x54
+
+//
+// Contacts a frame holds, and finger collections read from one report.
+//
+#define HID_DIGITIZER_MAX_CONTACTS  10
+
+//
+// Pad buttons read from the Button usage page, Button 1 to 3.
+//
+#define HID_DIGITIZER_MAX_BUTTONS  3
+
+///
+/// Where one value sits in the digitizer report.
+///
+typedef struct {
+  HID_REPORT_FIELD    Field;
+  UINT16              Element;
+  BOOLEAN             Present;              // FALSE when the report has no such value
+} HID_DIGITIZER_VALUE;
+
+///
+/// The values of one finger collection.
+///
+typedef struct {
+  HID_DIGITIZER_VALUE    TipSwitch;
+  HID_DIGITIZER_VALUE    Confidence;        // Optional, a contact without it is confident
+  HID_DIGITIZER_VALUE    ContactId;         // Optional, the slot number without it
+  HID_DIGITIZER_VALUE    X;
+  HID_DIGITIZER_VALUE    Y;
+} HID_DIGITIZER_SLOT;
+
+typedef struct {
+  BOOLEAN                TouchPad;          // Touch pad rather than touch screen
+  BOOLEAN                ReportIdsUsed;
+  UINT8                  ReportId;
+  UINT16                 MinReportSize;     // Bytes needed to hold every value
+  UINT32                 SlotCount;
+  HID_DIGITIZER_SLOT     Slots[HID_DIGITIZER_MAX_CONTACTS];
+  HID_DIGITIZER_VALUE    ContactCount;      // Optional, every slot is read in every report without it
+  HID_DIGITIZER_VALUE    Buttons[HID_DIGITIZER_MAX_BUTTONS];
+  INT32                  MinX;              // Logical range of the contact coordinates
+  INT32                  MaxX;
+  INT32                  MinY;
+  INT32                  MaxY;
+} HID_DIGITIZER_MAP;
+
+typedef struct {
+  UINT32    Id;
+  INT32     X;
+  INT32     Y;
+} HID_DIGITIZER_CONTACT;
+
+///
+/// The contacts touching the digitizer at one scan, and the pad buttons.
+///
+typedef struct {
+  UINT32                   ContactCount;
+  HID_DIGITIZER_CONTACT    Contacts[HID_DIGITIZER_MAX_CONTACTS];
+  UINT32                   Buttons;         // BIT0 is Button 1
+} HID_DIGITIZER_FRAME;
+
+///
+/// Frame assembly and gesture state of one digitizer.
+///
+typedef struct {
+  //
+  // The frame being assembled from hybrid mode reports.
+  //
+  HID_DIGITIZER_FRAME    Pending;
+  UINT32                 Expected;          // Contacts the frame reports, touching or not
+  UINT32                 Received;
+  //
+  // The frame last turned into pointer state.
+  //
+  HID_DIGITIZER_FRAME    Last;
+  INT64                  RemainderX;        // Touch pad motion not yet a whole pointer unit
+  INT64                  RemainderY;
+  INT64                  RemainderZ;
+} HID_DIGITIZER_TRACKER;
+
+/**
+  Compile the contact input fields of a report descriptor into a digitizer map.
+
+  @param  Descriptor      - the report descriptor.
+  @param  DescriptorSize  - size of the report descriptor in bytes.
+  @param  Map             - returns the digitizer map, free it with HidDigitizerFreeReportMap.
+
+  @retval EFI_SUCCESS           - the digitizer map was compiled.
+  @retval EFI_INVALID_PARAMETER - a pointer is NULL.
+  @retval EFI_UNSUPPORTED       - the descriptor has no finger collection with a tip switch and coordinates.
+  @retval EFI_OUT_OF_RESOURCES  - the digitizer map could not be allocated.
+  @retval other                 - the descriptor could not be parsed.
+**/
+EFI_STATUS
+HidDigitizerCompileReportMap (
+  IN  CONST UINT8        *Descriptor,
+  IN  UINTN              DescriptorSize,
+  OUT HID_DIGITIZER_MAP  **Map
+  );
+
+/**
+  Free a digitizer map returned by HidDigitizerCompileReportMap.
+
+  @param  Map - the digitizer map, may be NULL.
+**/
+VOID
+HidDigitizerFreeReportMap (
+  IN HID_DIGITIZER_MAP  *Map
+  );
+
+/**
+  Add a digitizer report to the frame being assembled.
+
+  @param  Map         - the digitizer map of the device.
+  @param  Tracker     - the frame assembly state of the device.
+  @param  Report      - the input report, starting with the report ID if IDs are used.
+  @param  ReportSize  - size of the report in bytes.
+  @param  Frame       - returns the frame when it is complete.
+
+  @retval EFI_SUCCESS           - Frame holds the contacts touching the digitizer.
+  @retval EFI_NOT_READY         - the frame continues in the next report.
+  @retval EFI_NOT_FOUND         - the report ID is not the contact report.
+  @retval EFI_BUFFER_TOO_SMALL  - the report is shorter than its fields.
+**/
+EFI_STATUS
+HidDigitizerParseReport (
+  IN     CONST HID_DIGITIZER_MAP  *Map,
+  IN OUT HID_DIGITIZER_TRACKER    *Tracker,
+  IN     CONST UINT8              *Report,
+  IN     UINTN                    ReportSize,
+  OUT    HID_DIGITIZER_FRAME      *Frame
+  );
+
+/**
+  Turn a complete frame into pointer state.
+
+  A touch screen puts the pointer at its first contact and reports the touch as
+  the active button. A touch pad moves the pointer with one finger, scrolls
+  with two by moving Z with their vertical motion, and reports its pad button
+  as the active button, or as the alternate button when clicked with two
+  fingers. Coordinates are scaled from the digitizer range to the pointer mode.
+
+  @param  Map      - the digitizer map of the device.
+  @param  Tracker  - the gesture state of the device.
+  @param  Frame    - the frame, as returned by HidDigitizerParseReport.
+  @param  Mode     - the absolute pointer mode.
+  @param  State    - the pointer state to update.
+**/
+VOID
+HidDigitizerApplyFrame (
+  IN     CONST HID_DIGITIZER_MAP          *Map,
+  IN OUT HID_DIGITIZER_TRACKER            *Tracker,
+  IN     CONST HID_DIGITIZER_FRAME        *Frame,
+  IN     CONST EFI_ABSOLUTE_POINTER_MODE  *Mode,
+  IN OUT EFI_ABSOLUTE_POINTER_STATE       *State
+  );
+
+#endif // _HID_DIGITIZER_REPORT_H_
@@ -245,6 +245,7 @@ Cleanup:
         gBS->CloseEvent ((HidMouseDev->AbsolutePointerProtocol).WaitForInput);
       }
 
+      HidDigitizerFreeReportMap (HidMouseDev->DigitizerMap);
       FreePool (HidMouseDev);
     }
   }
@@ -321,6 +322,10 @@ HidMouseAbsolutePointerDriverBindingStop (
          Controller
          );
 
+  if (HidMouseDev->ButtonStateOverflows != 0) {
+    DEBUG ((DEBUG_WARN, "[%a] - %d button transitions were merged into a later state.\n", __FUNCTION__, HidMouseDev->ButtonStateOverflows));
+  }
+
   //
   // Free all resources.
   //
@@ -330,6 +335,7 @@ HidMouseAbsolutePointerDriverBindingStop (
     FreeUnicodeStringTable (HidMouseDev->ControllerNameTable);
   }
 
+  HidDigitizerFreeReportMap (HidMouseDev->DigitizerMap);
   FreePool (HidMouseDev);
 
   return EFI_SUCCESS;
@@ -375,9 +381,102 @@ InitializeMouseDevice (
   HidMouseDev->State.CurrentY =
     DivU64x32 (HidMouseDev->Mode.AbsoluteMaxY + HidMouseDev->Mode.AbsoluteMinY, 2);
 
+  HidMouseDev->ButtonStateHead      = 0;
+  HidMouseDev->ButtonStateTail      = 0;
+  HidMouseDev->ButtonStateOverflows = 0;
+  HidMouseDev->LastButtons          = HidMouseDev->State.ActiveButtons;
+  HidMouseDev->LastStateTime        = 0;
+  HidMouseDev->MinStateInterval     = 0;
+  if (PcdGet32 (PcdHidMouseMaxStateRate) != 0) {
+    HidMouseDev->MinStateInterval = DivU64x32 (1000000000ULL, PcdGet32 (PcdHidMouseMaxStateRate));
+  }
+
   return EFI_SUCCESS;
 }
 
+/**
+  Check whether GetState has a state to return.
+
+  Button transitions are returned at once. A state that only moves the pointer
+  is held back until MinStateInterval has passed since the last state was
+  returned, and the reports that arrive meanwhile are folded into it.
+
+  @param  HidMouseDev       - the device.
+  @param  Now               - the current time in nanoseconds.
+
+  @retval TRUE              - GetState returns a state.
+  @retval FALSE             - GetState returns EFI_NOT_READY.
+
+**/
+STATIC
+BOOLEAN
+IsMouseStateReady (
+  IN HID_MOUSE_ABSOLUTE_POINTER_DEV  *HidMouseDev,
+  IN UINT64                          Now
+  )
+{
+  if (HidMouseDev->ButtonStateHead != HidMouseDev->ButtonStateTail) {
+    return TRUE;
+  }
+
+  if (!HidMouseDev->StateChanged) {
+    return FALSE;
+  }
+
+  if ((HidMouseDev->State.ActiveButtons != HidMouseDev->LastButtons) || (HidMouseDev->MinStateInterval == 0)) {
+    return TRUE;
+  }
+
+  //
+  // A counter that went backwards is treated as the interval having passed.
+  //
+  return (BOOLEAN)((Now < HidMouseDev->LastStateTime) || (Now - HidMouseDev->LastStateTime >= HidMouseDev->MinStateInterval));
+}
+
+/**
+  Keep the current state for GetState before a report changes its buttons.
+
+  Called when a report changes the buttons of a state that GetState has not
+  returned, so that every button transition is seen even when several arrive
+  between two calls to GetState.
+
+  @param  HidMouseDev       - the device.
+
+**/
+STATIC
+VOID
+QueueMouseButtonState (
+  IN HID_MOUSE_ABSOLUTE_POINTER_DEV  *HidMouseDev
+  )
+{
+  UINT32  Tail;
+
+  Tail = HidMouseDev->ButtonStateTail;
+  if (Tail - HidMouseDev->ButtonStateHead >= HID_MOUSE_BUTTON_STATE_DEPTH) {
+    //
+    // GetState has not been called for a while. The transition is lost in the state that replaces it.
+    //
+    if (++HidMouseDev->ButtonStateOverflows == 1) {
+      DEBUG ((DEBUG_WARN, "[%a] - button transitions are not being read, merging them.\n", __FUNCTION__));
+    }
+
+    return;
+  }
+
+  CopyMem (
+    &HidMouseDev->ButtonState[Tail & (HID_MOUSE_BUTTON_STATE_DEPTH - 1)],
+    &HidMouseDev->State,
+    sizeof (EFI_ABSOLUTE_POINTER_STATE)
+    );
+
+  //
+  // Publish the state after its contents.
+  //
+  MemoryFence ();
+  HidMouseDev->ButtonStateTail = Tail + 1;
+  HidMouseDev->LastButtons     = HidMouseDev->State.ActiveButtons;
+}
+
 /**
   Retrieves the current state of a pointer device.
 
@@ -400,6 +499,8 @@ GetMouseAbsolutePointerState (
   )
 {
   HID_MOUSE_ABSOLUTE_POINTER_DEV  *HidMouseDev;
+  UINT64                          Now;
+  UINT32                          Head;
 
   if (State == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -407,21 +508,41 @@ GetMouseAbsolutePointerState (
 
   HidMouseDev = HID_MOUSE_ABSOLUTE_POINTER_DEV_FROM_MOUSE_PROTOCOL (This);
 
-  if (!HidMouseDev->StateChanged) {
+  Now = GetTimeInNanoSecond (GetPerformanceCounter ());
+  if (!IsMouseStateReady (HidMouseDev, Now)) {
     return EFI_NOT_READY;
   }
 
-  //
-  // Retrieve mouse state from HID_MOUSE_ABSOLUTE_POINTER_DEV,
-  // which was filled by OnMouseReport()
-  //
-  CopyMem (
-    State,
-    &HidMouseDev->State,
-    sizeof (EFI_ABSOLUTE_POINTER_STATE)
-    );
+  Head = HidMouseDev->ButtonStateHead;
+  if (Head != HidMouseDev->ButtonStateTail) {
+    //
+    // Button states that later reports replaced come first, in the order they were reported.
+    //
+    MemoryFence ();
+    CopyMem (
+      State,
+      &HidMouseDev->ButtonState[Head & (HID_MOUSE_BUTTON_STATE_DEPTH - 1)],
+      sizeof (EFI_ABSOLUTE_POINTER_STATE)
+      );
+    MemoryFence ();
+    HidMouseDev->ButtonStateHead = Head + 1;
+  } else {
+    //
+    // Retrieve mouse state from HID_MOUSE_ABSOLUTE_POINTER_DEV,
+    // which was filled by OnMouseReport(). Clear StateChanged first so that a
+    // report which arrives during the copy is returned by the next call.
+    //
+    HidMouseDev->StateChanged = FALSE;
+    MemoryFence ();
+    CopyMem (
+      State,
+      &HidMouseDev->State,
+      sizeof (EFI_ABSOLUTE_POINTER_STATE)
+      );
+    HidMouseDev->LastButtons = State->ActiveButtons;
+  }
 
-  HidMouseDev->StateChanged = FALSE;
+  HidMouseDev->LastStateTime = Now;
 
   return EFI_SUCCESS;
 }
@@ -463,8 +584,12 @@ HidMouseAbsolutePointerReset (
     DivU64x32 (HidMouseDev->Mode.AbsoluteMaxX + HidMouseDev->Mode.AbsoluteMinX, 2);
   HidMouseDev->State.CurrentY =
     DivU64x32 (HidMouseDev->Mode.AbsoluteMaxY + HidMouseDev->Mode.AbsoluteMinY, 2);
+  HidMouseDev->State.CurrentZ =
+    DivU64x32 (HidMouseDev->Mode.AbsoluteMaxZ + HidMouseDev->Mode.AbsoluteMinZ, 2);
 
-  HidMouseDev->StateChanged = FALSE;
+  HidMouseDev->StateChanged    = FALSE;
+  HidMouseDev->ButtonStateHead = HidMouseDev->ButtonStateTail;
+  HidMouseDev->LastButtons     = 0;
 
   return EFI_SUCCESS;
 }
@@ -490,7 +615,7 @@ HidMouseAbsolutePointerWaitForInput (
   //
   // If there's input from mouse, signal the event.
   //
-  if (HidMouseDev->StateChanged) {
+  if (IsMouseStateReady (HidMouseDev, GetTimeInNanoSecond (GetPerformanceCounter ()))) {
     gBS->SignalEvent (Event);
   }
 }
@@ -521,6 +646,10 @@ OnMouseReport (
   HID_MOUSE_ABSOLUTE_POINTER_DEV  *HidMouseDev;
   SINGLETOUCH_HID_INPUT_BUFFER    *SingleTouchInput;
   MOUSE_HID_INPUT_BUFFER          *MouseInput;
+  EFI_ABSOLUTE_POINTER_STATE      NewState;
+  HID_DIGITIZER_MAP               *DigitizerMap;
+  HID_DIGITIZER_FRAME             Frame;
+  EFI_STATUS                      Status;
 
   HidMouseDev = (HID_MOUSE_ABSOLUTE_POINTER_DEV *)Context;
 
@@ -544,6 +673,36 @@ OnMouseReport (
     return;
   }
 
+  if (Interface == ReportDigitizerDescriptor) {
+    Status = HidDigitizerCompileReportMap (HidInputReportBuffer, HidInputReportBufferSize, &DigitizerMap);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "[%a] - Unusable digitizer report descriptor: %r\n", __FUNCTION__, Status));
+      DigitizerMap = NULL;
+    }
+
+    HidDigitizerFreeReportMap (HidMouseDev->DigitizerMap);
+    HidMouseDev->DigitizerMap = DigitizerMap;
+    ZeroMem (&HidMouseDev->DigitizerTracker, sizeof (HidMouseDev->DigitizerTracker));
+
+    if ((DigitizerMap != NULL) && DigitizerMap->TouchPad && (HidMouseDev->Mode.AbsoluteMaxZ == HidMouseDev->Mode.AbsoluteMinZ)) {
+      //
+      // Two finger scrolling moves Z, give it the range of Y and start in the middle.
+      //
+      HidMouseDev->Mode.AbsoluteMinZ = HidMouseDev->Mode.AbsoluteMinY;
+      HidMouseDev->Mode.AbsoluteMaxZ = HidMouseDev->Mode.AbsoluteMaxY;
+      HidMouseDev->State.CurrentZ    =
+        DivU64x32 (HidMouseDev->Mode.AbsoluteMaxZ + HidMouseDev->Mode.AbsoluteMinZ, 2);
+    }
+
+    return;
+  }
+
+  //
+  // Reports accumulate into the state until GetState returns it: relative
+  // motion is added up and an absolute position replaces the previous one.
+  //
+  CopyMem (&NewState, &HidMouseDev->State, sizeof (NewState));
+
   switch (Interface) {
     case SingleTouch:
       //
@@ -574,9 +733,9 @@ OnMouseReport (
         return;
       }
 
-      HidMouseDev->State.ActiveButtons = SingleTouchInput->Touch;
-      HidMouseDev->State.CurrentX      = SingleTouchInput->CurrentX;
-      HidMouseDev->State.CurrentY      = SingleTouchInput->CurrentY;
+      NewState.ActiveButtons = SingleTouchInput->Touch;
+      NewState.CurrentX      = SingleTouchInput->CurrentX;
+      NewState.CurrentY      = SingleTouchInput->CurrentY;
       break;
     case BootMouse:
       //
@@ -601,36 +760,65 @@ OnMouseReport (
 
       MouseInput = (MOUSE_HID_INPUT_BUFFER *)HidInputReportBuffer;
       // copy first byte with button state straight from report buffer - it's already formatted correctly.
-      HidMouseDev->State.ActiveButtons = HidInputReportBuffer[0];
+      NewState.ActiveButtons = HidInputReportBuffer[0];
 
-      HidMouseDev->State.CurrentX =
+      NewState.CurrentX =
         MIN (
           MAX (
-            (INT64)HidMouseDev->State.CurrentX + MouseInput->XDisplacement,
+            (INT64)NewState.CurrentX + MouseInput->XDisplacement,
             (INT64)HidMouseDev->Mode.AbsoluteMinX
             ),
           (INT64)HidMouseDev->Mode.AbsoluteMaxX
           );
-      HidMouseDev->State.CurrentY =
+      NewState.CurrentY =
         MIN (
           MAX (
-            (INT64)HidMouseDev->State.CurrentY + MouseInput->YDisplacement,
+            (INT64)NewState.CurrentY + MouseInput->YDisplacement,
             (INT64)HidMouseDev->Mode.AbsoluteMinY
             ),
           (INT64)HidMouseDev->Mode.AbsoluteMaxY
           );
       // only use Z if optional byte is included (as indicated by the report size)
       if (HidInputReportBufferSize >= sizeof (MOUSE_HID_INPUT_BUFFER)) {
-        HidMouseDev->State.CurrentZ =
+        NewState.CurrentZ =
           MIN (
             MAX (
-              (INT64)HidMouseDev->State.CurrentZ + MouseInput->ZDisplacement,
+              (INT64)NewState.CurrentZ + MouseInput->ZDisplacement,
               (INT64)HidMouseDev->Mode.AbsoluteMinZ
               ),
             (INT64)HidMouseDev->Mode.AbsoluteMaxZ
             );
       }
 
+      break;
+    case ReportDigitizer:
+      //
+      // Laid out by the ReportDigitizerDescriptor the producer passed at registration.
+      //
+      if (HidMouseDev->DigitizerMap == NULL) {
+        return;
+      }
+
+      Status = HidDigitizerParseReport (
+                 HidMouseDev->DigitizerMap,
+                 &HidMouseDev->DigitizerTracker,
+                 HidInputReportBuffer,
+                 HidInputReportBufferSize,
+                 &Frame
+                 );
+      if (EFI_ERROR (Status)) {
+        //
+        // A hybrid mode frame continues in the next report, other report IDs
+        // (mouse collections, configuration) are not contact reports.
+        //
+        if ((Status != EFI_NOT_READY) && (Status != EFI_NOT_FOUND)) {
+          DEBUG ((DEBUG_ERROR, "[%a] - invalid digitizer report: %r\n", __FUNCTION__, Status));
+        }
+
+        return;
+      }
+
+      HidDigitizerApplyFrame (HidMouseDev->DigitizerMap, &HidMouseDev->DigitizerTracker, &Frame, &HidMouseDev->Mode, &NewState);
       break;
     default:
       DEBUG ((DEBUG_ERROR, "[%a] - unrecognized HID report type.\n", __FUNCTION__));
@@ -638,6 +826,20 @@ OnMouseReport (
       return;
   }
 
+  if (CompareMem (&NewState, &HidMouseDev->State, sizeof (NewState)) == 0) {
+    //
+    // Nothing moved and no button changed, there is nothing new to read.
+    //
+    return;
+  }
+
+  if ((NewState.ActiveButtons != HidMouseDev->State.ActiveButtons) &&
+      (HidMouseDev->State.ActiveButtons != HidMouseDev->LastButtons))
+  {
+    QueueMouseButtonState (HidMouseDev);
+  }
+
+  CopyMem (&HidMouseDev->State, &NewState, sizeof (NewState));
   HidMouseDev->StateChanged = TRUE;
 
   return;
@@ -29,12 +29,23 @@
 #include <Protocol/HidPointerProtocol.h>
 
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/UefiDriverEntryPoint.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/DebugLib.h>
+#include <Library/PcdLib.h>
+#include <Library/TimerLib.h>
+
+#include "HidDigitizerReport.h"
+
+//
+// Button states that were replaced by a later report before GetState returned
+// them, see OnMouseReport(). A power of two.
+//
+#define HID_MOUSE_BUTTON_STATE_DEPTH  16
 
 //
 // Private structs
@@ -47,6 +58,25 @@ typedef struct {
   EFI_ABSOLUTE_POINTER_MODE        Mode;
   BOOLEAN                          StateChanged;
   EFI_UNICODE_STRING_TABLE         *ControllerNameTable;
+  //
+  // Button transitions that have not been returned by GetState yet. Written by
+  // OnMouseReport, read by GetState.
+  //
+  EFI_ABSOLUTE_POINTER_STATE       ButtonState[HID_MOUSE_BUTTON_STATE_DEPTH];
+  volatile UINT32                  ButtonStateHead;
+  volatile UINT32                  ButtonStateTail;
+  UINT32                           ButtonStateOverflows;
+  UINT32                           LastButtons;         // ActiveButtons of the newest state returned or queued
+  //
+  // Limit on the rate motion only states are returned by GetState and signal WaitForInput.
+  //
+  UINT64                           MinStateInterval;    // In nanoseconds, 0 for no limit
+  UINT64                           LastStateTime;       // In nanoseconds
+  //
+  // ReportDigitizer reports, laid out by the ReportDigitizerDescriptor the producer passed.
+  //
+  HID_DIGITIZER_MAP                *DigitizerMap;       // NULL until a usable descriptor arrives
+  HID_DIGITIZER_TRACKER            DigitizerTracker;
 } HID_MOUSE_ABSOLUTE_POINTER_DEV;
 
 #define HID_MOUSE_ABSOLUTE_POINTER_DEV_SIGNATURE  SIGNATURE_32 ('H', 'I', 'D', 'M')
@@ -0,0 +1,865 @@
+/** @file
+  This module tests the translation of multi-touch digitizer HID report
+  streams into frames of contacts and absolute pointer state.
+
+  Copyright (c) Microsoft Corporation
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PseudoRandomLib.h>
+#include <Library/UnitTestLib.h>
+#include "../HidDigitizerReport.h"
+
+#define UNIT_TEST_NAME     "HID Digitizer Report Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define FUZZ_ITERATIONS  20000
+
+//
+// Precision touch pad: report 3 is the mouse collection the pad reports
+// before it is switched to touch pad input mode, report 1 carries three
+// finger collections, the scan time, contact count and pad button, and
+// feature report 2 is the maximum contact count.
+//
+STATIC CONST UINT8  mTouchPadDescriptor[] = {
+  0x05, 0x01,                   // Usage Page (Generic Desktop)
+  0x09, 0x02,                   // Usage (Mouse)
+  0xA1, 0x01,                   // Collection (Application)
+  0x85, 0x03,                   //   Report ID (3)
+  0x09, 0x01,                   //   Usage (Pointer)
+  0xA1, 0x00,                   //   Collection (Physical)
+  0x05, 0x09,                   //     Usage Page (Button)
+  0x19, 0x01,                   //     Usage Minimum (Button 1)
+  0x29, 0x02,                   //     Usage Maximum (Button 2)
+  0x15, 0x00,                   //     Logical Minimum (0)
+  0x25, 0x01,                   //     Logical Maximum (1)
+  0x75, 0x01,                   //     Report Size (1)
+  0x95, 0x02,                   //     Report Count (2)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x95, 0x06,                   //     Report Count (6)
+  0x81, 0x03,                   //     Input (Constant)
+  0x05, 0x01,                   //     Usage Page (Generic Desktop)
+  0x09, 0x30,                   //     Usage (X)
+  0x09, 0x31,                   //     Usage (Y)
+  0x15, 0x81,                   //     Logical Minimum (-127)
+  0x25, 0x7F,                   //     Logical Maximum (127)
+  0x75, 0x08,                   //     Report Size (8)
+  0x95, 0x02,                   //     Report Count (2)
+  0x81, 0x06,                   //     Input (Data, Variable, Relative)
+  0xC0,                         //   End Collection
+  0xC0,                         // End Collection
+  0x05, 0x0D,                   // Usage Page (Digitizer)
+  0x09, 0x05,                   // Usage (Touch Pad)
+  0xA1, 0x01,                   // Collection (Application)
+  0x85, 0x01,                   //   Report ID (1)
+  0x09, 0x22,                   //   Usage (Finger)
+  0xA1, 0x02,                   //   Collection (Logical)
+  0x15, 0x00,                   //     Logical Minimum (0)
+  0x25, 0x01,                   //     Logical Maximum (1)
+  0x75, 0x01,                   //     Report Size (1)
+  0x95, 0x02,                   //     Report Count (2)
+  0x09, 0x47,                   //     Usage (Confidence)
+  0x09, 0x42,                   //     Usage (Tip Switch)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x25, 0x07,                   //     Logical Maximum (7)
+  0x75, 0x03,                   //     Report Size (3)
+  0x95, 0x01,                   //     Report Count (1)
+  0x09, 0x51,                   //     Usage (Contact Identifier)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x81, 0x03,                   //     Input (Constant)
+  0x05, 0x01,                   //     Usage Page (Generic Desktop)
+  0x26, 0xE4, 0x07,             //     Logical Maximum (2020)
+  0x75, 0x10,                   //     Report Size (16)
+  0x09, 0x30,                   //     Usage (X)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x26, 0x4C, 0x04,             //     Logical Maximum (1100)
+  0x09, 0x31,                   //     Usage (Y)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0xC0,                         //   End Collection
+  0x05, 0x0D,                   //   Usage Page (Digitizer)
+  0x09, 0x22,                   //   Usage (Finger)
+  0xA1, 0x02,                   //   Collection (Logical)
+  0x25, 0x01,                   //     Logical Maximum (1)
+  0x75, 0x01,                   //     Report Size (1)
+  0x95, 0x02,                   //     Report Count (2)
+  0x09, 0x47,                   //     Usage (Confidence)
+  0x09, 0x42,                   //     Usage (Tip Switch)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x25, 0x07,                   //     Logical Maximum (7)
+  0x75, 0x03,                   //     Report Size (3)
+  0x95, 0x01,                   //     Report Count (1)
+  0x09, 0x51,                   //     Usage (Contact Identifier)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x81, 0x03,                   //     Input (Constant)
+  0x05, 0x01,                   //     Usage Page (Generic Desktop)
+  0x26, 0xE4, 0x07,             //     Logical Maximum (2020)
+  0x75, 0x10,                   //     Report Size (16)
+  0x09, 0x30,                   //     Usage (X)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x26, 0x4C, 0x04,             //     Logical Maximum (1100)
+  0x09, 0x31,                   //     Usage (Y)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0xC0,                         //   End Collection
+  0x05, 0x0D,                   //   Usage Page (Digitizer)
+  0x09, 0x22,                   //   Usage (Finger)
+  0xA1, 0x02,                   //   Collection (Logical)
+  0x25, 0x01,                   //     Logical Maximum (1)
+  0x75, 0x01,                   //     Report Size (1)
+  0x95, 0x02,                   //     Report Count (2)
+  0x09, 0x47,                   //     Usage (Confidence)
+  0x09, 0x42,                   //     Usage (Tip Switch)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x25, 0x07,                   //     Logical Maximum (7)
+  0x75, 0x03,                   //     Report Size (3)
+  0x95, 0x01,                   //     Report Count (1)
+  0x09, 0x51,                   //     Usage (Contact Identifier)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x81, 0x03,                   //     Input (Constant)
+  0x05, 0x01,                   //     Usage Page (Generic Desktop)
+  0x26, 0xE4, 0x07,             //     Logical Maximum (2020)
+  0x75, 0x10,                   //     Report Size (16)
+  0x09, 0x30,                   //     Usage (X)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x26, 0x4C, 0x04,             //     Logical Maximum (1100)
+  0x09, 0x31,                   //     Usage (Y)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0xC0,                         //   End Collection
+  0x05, 0x0D,                   //   Usage Page (Digitizer)
+  0x27, 0xFF, 0xFF, 0x00, 0x00, //   Logical Maximum (65535)
+  0x75, 0x10,                   //   Report Size (16)
+  0x09, 0x56,                   //   Usage (Scan Time)
+  0x81, 0x02,                   //   Input (Data, Variable, Absolute)
+  0x25, 0x05,                   //   Logical Maximum (5)
+  0x75, 0x08,                   //   Report Size (8)
+  0x09, 0x54,                   //   Usage (Contact Count)
+  0x81, 0x02,                   //   Input (Data, Variable, Absolute)
+  0x05, 0x09,                   //   Usage Page (Button)
+  0x09, 0x01,                   //   Usage (Button 1)
+  0x25, 0x01,                   //   Logical Maximum (1)
+  0x75, 0x01,                   //   Report Size (1)
+  0x81, 0x02,                   //   Input (Data, Variable, Absolute)
+  0x75, 0x07,                   //   Report Size (7)
+  0x81, 0x03,                   //   Input (Constant)
+  0x85, 0x02,                   //   Report ID (2)
+  0x05, 0x0D,                   //   Usage Page (Digitizer)
+  0x09, 0x55,                   //   Usage (Contact Count Maximum)
+  0x25, 0x05,                   //   Logical Maximum (5)
+  0x75, 0x08,                   //   Report Size (8)
+  0xB1, 0x02,                   //   Feature (Data, Variable, Absolute)
+  0xC0                          // End Collection
+};
+
+#define TOUCH_PAD_MOUSE_SIZE   50     // Size of the mouse collection that starts the descriptor
+#define TOUCH_PAD_REPORT_SIZE  20
+
+//
+// Contacts of a recorded touch pad report: the confidence, tip switch and
+// contact identifier byte, then X and Y.
+//
+#define PAD_CONTACT(Flags, X, Y)  (Flags), (UINT8)(X), (UINT8)((X) >> 8), (UINT8)(Y), (UINT8)((Y) >> 8)
+#define PAD_FINGER(Id, X, Y)      PAD_CONTACT (0x03 | ((Id) << 2), X, Y)
+#define PAD_PALM(Id, X, Y)        PAD_CONTACT (0x02 | ((Id) << 2), X, Y)
+#define PAD_LIFT(Id, X, Y)        PAD_CONTACT (0x01 | ((Id) << 2), X, Y)
+#define PAD_UNUSED                PAD_CONTACT (0, 0, 0)
+
+#define PAD_REPORT(Contact0, Contact1, Contact2, Count, Buttons) \
+  { 0x01, Contact0, Contact1, Contact2, 0x00, 0x00, (Count), (Buttons) }
+
+//
+// Touch screen without report IDs: two finger collections without confidence,
+// then the contact count.
+//
+STATIC CONST UINT8  mTouchScreenDescriptor[] = {
+  0x05, 0x0D,                   // Usage Page (Digitizer)
+  0x09, 0x04,                   // Usage (Touch Screen)
+  0xA1, 0x01,                   // Collection (Application)
+  0x09, 0x22,                   //   Usage (Finger)
+  0xA1, 0x02,                   //   Collection (Logical)
+  0x15, 0x00,                   //     Logical Minimum (0)
+  0x25, 0x01,                   //     Logical Maximum (1)
+  0x75, 0x01,                   //     Report Size (1)
+  0x95, 0x01,                   //     Report Count (1)
+  0x09, 0x42,                   //     Usage (Tip Switch)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x75, 0x07,                   //     Report Size (7)
+  0x81, 0x03,                   //     Input (Constant)
+  0x25, 0x0F,                   //     Logical Maximum (15)
+  0x75, 0x08,                   //     Report Size (8)
+  0x09, 0x51,                   //     Usage (Contact Identifier)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x05, 0x01,                   //     Usage Page (Generic Desktop)
+  0x26, 0xFF, 0x0F,             //     Logical Maximum (4095)
+  0x75, 0x10,                   //     Report Size (16)
+  0x95, 0x02,                   //     Report Count (2)
+  0x09, 0x30,                   //     Usage (X)
+  0x09, 0x31,                   //     Usage (Y)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0xC0,                         //   End Collection
+  0x05, 0x0D,                   //   Usage Page (Digitizer)
+  0x09, 0x22,                   //   Usage (Finger)
+  0xA1, 0x02,                   //   Collection (Logical)
+  0x25, 0x01,                   //     Logical Maximum (1)
+  0x75, 0x01,                   //     Report Size (1)
+  0x95, 0x01,                   //     Report Count (1)
+  0x09, 0x42,                   //     Usage (Tip Switch)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x75, 0x07,                   //     Report Size (7)
+  0x81, 0x03,                   //     Input (Constant)
+  0x25, 0x0F,                   //     Logical Maximum (15)
+  0x75, 0x08,                   //     Report Size (8)
+  0x09, 0x51,                   //     Usage (Contact Identifier)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x05, 0x01,                   //     Usage Page (Generic Desktop)
+  0x26, 0xFF, 0x0F,             //     Logical Maximum (4095)
+  0x75, 0x10,                   //     Report Size (16)
+  0x95, 0x02,                   //     Report Count (2)
+  0x09, 0x30,                   //     Usage (X)
+  0x09, 0x31,                   //     Usage (Y)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0xC0,                         //   End Collection
+  0x05, 0x0D,                   //   Usage Page (Digitizer)
+  0x25, 0x02,                   //   Logical Maximum (2)
+  0x75, 0x08,                   //   Report Size (8)
+  0x95, 0x01,                   //   Report Count (1)
+  0x09, 0x54,                   //   Usage (Contact Count)
+  0x81, 0x02,                   //   Input (Data, Variable, Absolute)
+  0xC0                          // End Collection
+};
+
+#define TOUCH_SCREEN_REPORT_SIZE  13
+
+#define SCREEN_CONTACT(Tip, Id, X, Y)  (Tip), (Id), (UINT8)(X), (UINT8)((X) >> 8), (UINT8)(Y), (UINT8)((Y) >> 8)
+
+//
+// One finger moving right by 3 and up by 10 units a scan, lifting, and
+// landing again elsewhere.
+//
+STATIC CONST UINT8  mOneFingerStream[][TOUCH_PAD_REPORT_SIZE] = {
+  PAD_REPORT (PAD_FINGER (0, 1000, 500), PAD_UNUSED, PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_FINGER (0, 1003, 490), PAD_UNUSED, PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_FINGER (0, 1006, 480), PAD_UNUSED, PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_FINGER (0, 1009, 470), PAD_UNUSED, PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_LIFT (0, 1009, 470),   PAD_UNUSED, PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_FINGER (1, 100, 100),  PAD_UNUSED, PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_FINGER (1, 103, 100),  PAD_UNUSED, PAD_UNUSED, 1, 0)
+};
+
+//
+// Two fingers landing one after the other, then moving down together by 20
+// units a scan.
+//
+STATIC CONST UINT8  mTwoFingerScrollStream[][TOUCH_PAD_REPORT_SIZE] = {
+  PAD_REPORT (PAD_FINGER (2, 800, 600), PAD_UNUSED,                PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_FINGER (2, 800, 600), PAD_FINGER (3, 1200, 610), PAD_UNUSED, 2, 0),
+  PAD_REPORT (PAD_FINGER (2, 801, 620), PAD_FINGER (3, 1199, 630), PAD_UNUSED, 2, 0),
+  PAD_REPORT (PAD_FINGER (2, 802, 640), PAD_FINGER (3, 1198, 650), PAD_UNUSED, 2, 0),
+  PAD_REPORT (PAD_FINGER (2, 803, 660), PAD_FINGER (3, 1197, 670), PAD_UNUSED, 2, 0)
+};
+
+//
+// A finger moving while the palm rests on the pad and moves the other way.
+//
+STATIC CONST UINT8  mPalmStream[][TOUCH_PAD_REPORT_SIZE] = {
+  PAD_REPORT (PAD_FINGER (0, 1000, 500), PAD_PALM (1, 500, 900), PAD_UNUSED, 2, 0),
+  PAD_REPORT (PAD_FINGER (0, 1020, 500), PAD_PALM (1, 400, 800), PAD_UNUSED, 2, 0)
+};
+
+//
+// Five fingers in hybrid mode: the first report carries three contacts and
+// the count, the second the last two.
+//
+STATIC CONST UINT8  mHybridStream[][TOUCH_PAD_REPORT_SIZE] = {
+  PAD_REPORT (PAD_FINGER (0, 100, 100), PAD_FINGER (1, 200, 200), PAD_FINGER (2, 300, 300), 5, 1),
+  PAD_REPORT (PAD_FINGER (3, 400, 400), PAD_FINGER (4, 500, 500), PAD_UNUSED,               0, 0)
+};
+
+//
+// Clicking the pad with one finger, then with two.
+//
+STATIC CONST UINT8  mClickStream[][TOUCH_PAD_REPORT_SIZE] = {
+  PAD_REPORT (PAD_FINGER (0, 1000, 500), PAD_UNUSED,               PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_FINGER (0, 1000, 500), PAD_UNUSED,               PAD_UNUSED, 1, 1),
+  PAD_REPORT (PAD_FINGER (0, 1000, 500), PAD_UNUSED,               PAD_UNUSED, 1, 0),
+  PAD_REPORT (PAD_FINGER (0, 1000, 500), PAD_FINGER (1, 1400, 500), PAD_UNUSED, 2, 1),
+  PAD_REPORT (PAD_FINGER (0, 1000, 500), PAD_FINGER (1, 1400, 500), PAD_UNUSED, 2, 0)
+};
+
+STATIC UINT64  mRandomState;
+
+/**
+ * @brief Set up the pointer mode the driver gives a touch pad, with the
+ * pointer in the middle.
+ */
+STATIC
+VOID
+InitializePointer (
+  OUT EFI_ABSOLUTE_POINTER_MODE   *Mode,
+  OUT EFI_ABSOLUTE_POINTER_STATE  *State
+  )
+{
+  ZeroMem (Mode, sizeof (*Mode));
+  Mode->AbsoluteMaxX = 1024;
+  Mode->AbsoluteMaxY = 1024;
+  Mode->AbsoluteMaxZ = 1024;
+
+  ZeroMem (State, sizeof (*State));
+  State->CurrentX = 512;
+  State->CurrentY = 512;
+  State->CurrentZ = 512;
+}
+
+/**
+ * @brief Feed a recorded report stream to the parser and turn every
+ * complete frame into pointer state.
+ *
+ * @return The number of complete frames.
+ */
+STATIC
+UINTN
+ReplayStream (
+  IN     CONST HID_DIGITIZER_MAP          *Map,
+  IN OUT HID_DIGITIZER_TRACKER            *Tracker,
+  IN     CONST UINT8                      *Stream,
+  IN     UINTN                            ReportCount,
+  IN     UINTN                            ReportSize,
+  IN     CONST EFI_ABSOLUTE_POINTER_MODE  *Mode,
+  IN OUT EFI_ABSOLUTE_POINTER_STATE       *State
+  )
+{
+  HID_DIGITIZER_FRAME  Frame;
+  UINTN                Index;
+  UINTN                Frames;
+
+  Frames = 0;
+  for (Index = 0; Index < ReportCount; Index++) {
+    if (!EFI_ERROR (HidDigitizerParseReport (Map, Tracker, Stream + Index * ReportSize, ReportSize, &Frame))) {
+      HidDigitizerApplyFrame (Map, Tracker, &Frame, Mode, State);
+      Frames++;
+    }
+  }
+
+  return Frames;
+}
+
+/**
+ * @brief The touch pad descriptor compiles to three contact slots of report
+ * 1, and descriptors without fingers are refused.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestCompileTouchPadMap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  HID_DIGITIZER_MAP  *Map;
+  UINTN              Index;
+
+  Status = HidDigitizerCompileReportMap (mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &Map);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  UT_ASSERT_TRUE (Map->TouchPad);
+  UT_ASSERT_TRUE (Map->ReportIdsUsed);
+  UT_ASSERT_EQUAL (Map->ReportId, 1);
+  UT_ASSERT_EQUAL (Map->SlotCount, 3);
+  UT_ASSERT_EQUAL (Map->MinReportSize, TOUCH_PAD_REPORT_SIZE);
+  UT_ASSERT_EQUAL (Map->MinX, 0);
+  UT_ASSERT_EQUAL (Map->MaxX, 2020);
+  UT_ASSERT_EQUAL (Map->MinY, 0);
+  UT_ASSERT_EQUAL (Map->MaxY, 1100);
+  for (Index = 0; Index < Map->SlotCount; Index++) {
+    UT_ASSERT_TRUE (Map->Slots[Index].Confidence.Present);
+    UT_ASSERT_TRUE (Map->Slots[Index].ContactId.Present);
+    UT_ASSERT_EQUAL (Map->Slots[Index].TipSwitch.Field.BitOffset, 8 + 40 * Index + 1);
+    UT_ASSERT_EQUAL (Map->Slots[Index].X.Field.BitOffset, 8 + 40 * Index + 8);
+    UT_ASSERT_EQUAL (Map->Slots[Index].Y.Field.BitOffset, 8 + 40 * Index + 24);
+  }
+
+  UT_ASSERT_TRUE (Map->ContactCount.Present);
+  UT_ASSERT_EQUAL (Map->ContactCount.Field.BitOffset, 8 + 40 * 3 + 16);
+  UT_ASSERT_TRUE (Map->Buttons[0].Present);
+  UT_ASSERT_FALSE (Map->Buttons[1].Present);
+
+  HidDigitizerFreeReportMap (Map);
+
+  //
+  // The mouse collection alone has no fingers.
+  //
+  Status = HidDigitizerCompileReportMap (mTouchPadDescriptor, TOUCH_PAD_MOUSE_SIZE, &Map);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_UNSUPPORTED);
+  UT_ASSERT_TRUE (Map == NULL);
+
+  Status = HidDigitizerCompileReportMap (mTouchScreenDescriptor, sizeof (mTouchScreenDescriptor), &Map);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_FALSE (Map->TouchPad);
+  UT_ASSERT_FALSE (Map->ReportIdsUsed);
+  UT_ASSERT_EQUAL (Map->SlotCount, 2);
+  UT_ASSERT_EQUAL (Map->MinReportSize, TOUCH_SCREEN_REPORT_SIZE);
+  UT_ASSERT_FALSE (Map->Slots[0].Confidence.Present);
+  HidDigitizerFreeReportMap (Map);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief One finger moves the pointer by its scaled motion, carrying
+ * fractions between reports, and landing again does not move it.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestOneFingerMotion (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_DIGITIZER_MAP           *Map;
+  HID_DIGITIZER_TRACKER       Tracker;
+  EFI_ABSOLUTE_POINTER_MODE   Mode;
+  EFI_ABSOLUTE_POINTER_STATE  State;
+  UINTN                       Frames;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerCompileReportMap (mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &Map));
+  ZeroMem (&Tracker, sizeof (Tracker));
+  InitializePointer (&Mode, &State);
+
+  //
+  // Landing does not move, then 3 x 3 units of 1024 / 2020 make 4 and not
+  // 3 x 1, and 3 x -10 units of 1024 / 1100 make -27.
+  //
+  Frames = ReplayStream (Map, &Tracker, mOneFingerStream[0], 4, TOUCH_PAD_REPORT_SIZE, &Mode, &State);
+  UT_ASSERT_EQUAL (Frames, 4);
+  UT_ASSERT_EQUAL (State.CurrentX, 512 + 4);
+  UT_ASSERT_EQUAL (State.CurrentY, 512 - 27);
+  UT_ASSERT_EQUAL (State.CurrentZ, 512);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 0);
+
+  //
+  // Lifting and landing far away does not jump, the fraction is dropped.
+  //
+  Frames = ReplayStream (Map, &Tracker, mOneFingerStream[4], 3, TOUCH_PAD_REPORT_SIZE, &Mode, &State);
+  UT_ASSERT_EQUAL (Frames, 3);
+  UT_ASSERT_EQUAL (State.CurrentX, 512 + 4 + 1);
+  UT_ASSERT_EQUAL (State.CurrentY, 512 - 27);
+
+  HidDigitizerFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Two fingers moving together scroll Z without moving the pointer.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestTwoFingerScroll (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_DIGITIZER_MAP           *Map;
+  HID_DIGITIZER_TRACKER       Tracker;
+  EFI_ABSOLUTE_POINTER_MODE   Mode;
+  EFI_ABSOLUTE_POINTER_STATE  State;
+  UINTN                       Frames;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerCompileReportMap (mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &Map));
+  ZeroMem (&Tracker, sizeof (Tracker));
+  InitializePointer (&Mode, &State);
+
+  Frames = ReplayStream (Map, &Tracker, mTwoFingerScrollStream[0], ARRAY_SIZE (mTwoFingerScrollStream), TOUCH_PAD_REPORT_SIZE, &Mode, &State);
+  UT_ASSERT_EQUAL (Frames, ARRAY_SIZE (mTwoFingerScrollStream));
+
+  //
+  // 3 x 20 units of 1024 / 1100.
+  //
+  UT_ASSERT_EQUAL (State.CurrentZ, 512 + 55);
+  UT_ASSERT_EQUAL (State.CurrentX, 512);
+  UT_ASSERT_EQUAL (State.CurrentY, 512);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 0);
+
+  //
+  // Scrolling stops at the end of the Z range.
+  //
+  Mode.AbsoluteMaxZ = 520;
+  State.CurrentZ    = 512;
+  ZeroMem (&Tracker, sizeof (Tracker));
+  ReplayStream (Map, &Tracker, mTwoFingerScrollStream[0], ARRAY_SIZE (mTwoFingerScrollStream), TOUCH_PAD_REPORT_SIZE, &Mode, &State);
+  UT_ASSERT_EQUAL (State.CurrentZ, 520);
+
+  HidDigitizerFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Contacts the pad has no confidence in are left out of the frame.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestPalmRejection (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_DIGITIZER_MAP           *Map;
+  HID_DIGITIZER_TRACKER       Tracker;
+  HID_DIGITIZER_FRAME         Frame;
+  EFI_ABSOLUTE_POINTER_MODE   Mode;
+  EFI_ABSOLUTE_POINTER_STATE  State;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerCompileReportMap (mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &Map));
+  ZeroMem (&Tracker, sizeof (Tracker));
+  InitializePointer (&Mode, &State);
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerParseReport (Map, &Tracker, mPalmStream[0], TOUCH_PAD_REPORT_SIZE, &Frame));
+  UT_ASSERT_EQUAL (Frame.ContactCount, 1);
+  UT_ASSERT_EQUAL (Frame.Contacts[0].Id, 0);
+  UT_ASSERT_EQUAL (Frame.Contacts[0].X, 1000);
+  UT_ASSERT_EQUAL (Frame.Contacts[0].Y, 500);
+  HidDigitizerApplyFrame (Map, &Tracker, &Frame, &Mode, &State);
+
+  //
+  // The finger moves the pointer by 20 units of 1024 / 2020, the palm neither
+  // moves it nor makes the motion a scroll.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerParseReport (Map, &Tracker, mPalmStream[1], TOUCH_PAD_REPORT_SIZE, &Frame));
+  HidDigitizerApplyFrame (Map, &Tracker, &Frame, &Mode, &State);
+  UT_ASSERT_EQUAL (State.CurrentX, 512 + 10);
+  UT_ASSERT_EQUAL (State.CurrentY, 512);
+  UT_ASSERT_EQUAL (State.CurrentZ, 512);
+
+  HidDigitizerFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief A hybrid mode frame is complete once its last contact arrives, and a
+ * new contact count starts over.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestHybridFrames (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_DIGITIZER_MAP      *Map;
+  HID_DIGITIZER_TRACKER  Tracker;
+  HID_DIGITIZER_FRAME    Frame;
+  UINT32                 Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerCompileReportMap (mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &Map));
+  ZeroMem (&Tracker, sizeof (Tracker));
+
+  UT_ASSERT_STATUS_EQUAL (HidDigitizerParseReport (Map, &Tracker, mHybridStream[0], TOUCH_PAD_REPORT_SIZE, &Frame), EFI_NOT_READY);
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerParseReport (Map, &Tracker, mHybridStream[1], TOUCH_PAD_REPORT_SIZE, &Frame));
+  UT_ASSERT_EQUAL (Frame.ContactCount, 5);
+  UT_ASSERT_EQUAL (Frame.Buttons, BIT0);
+  for (Index = 0; Index < Frame.ContactCount; Index++) {
+    UT_ASSERT_EQUAL (Frame.Contacts[Index].Id, Index);
+    UT_ASSERT_EQUAL (Frame.Contacts[Index].X, 100 * (Index + 1));
+    UT_ASSERT_EQUAL (Frame.Contacts[Index].Y, 100 * (Index + 1));
+  }
+
+  //
+  // A frame whose continuation never comes is dropped by the next frame.
+  //
+  UT_ASSERT_STATUS_EQUAL (HidDigitizerParseReport (Map, &Tracker, mHybridStream[0], TOUCH_PAD_REPORT_SIZE, &Frame), EFI_NOT_READY);
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerParseReport (Map, &Tracker, mTwoFingerScrollStream[1], TOUCH_PAD_REPORT_SIZE, &Frame));
+  UT_ASSERT_EQUAL (Frame.ContactCount, 2);
+  UT_ASSERT_EQUAL (Frame.Buttons, 0);
+
+  //
+  // Without a pending frame, a count of 0 is every finger lifted.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerParseReport (Map, &Tracker, mHybridStream[1], TOUCH_PAD_REPORT_SIZE, &Frame));
+  UT_ASSERT_EQUAL (Frame.ContactCount, 0);
+
+  HidDigitizerFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief The pad button is the active button, and the alternate button when
+ * clicked with two fingers.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestPadClicks (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINT32         Expected[] = { 0, EFI_ABSP_TouchActive, 0, EFI_ABS_AltActive, 0 };
+  HID_DIGITIZER_MAP           *Map;
+  HID_DIGITIZER_TRACKER       Tracker;
+  EFI_ABSOLUTE_POINTER_MODE   Mode;
+  EFI_ABSOLUTE_POINTER_STATE  State;
+  UINTN                       Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerCompileReportMap (mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &Map));
+  ZeroMem (&Tracker, sizeof (Tracker));
+  InitializePointer (&Mode, &State);
+
+  for (Index = 0; Index < ARRAY_SIZE (mClickStream); Index++) {
+    UT_ASSERT_EQUAL (ReplayStream (Map, &Tracker, mClickStream[Index], 1, TOUCH_PAD_REPORT_SIZE, &Mode, &State), 1);
+    UT_ASSERT_EQUAL (State.ActiveButtons, Expected[Index]);
+    UT_ASSERT_EQUAL (State.CurrentX, 512);
+    UT_ASSERT_EQUAL (State.CurrentY, 512);
+  }
+
+  HidDigitizerFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Reports of other IDs and short reports are refused.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestRefusedReports (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_DIGITIZER_MAP      *Map;
+  HID_DIGITIZER_TRACKER  Tracker;
+  HID_DIGITIZER_FRAME    Frame;
+  UINT8                  Report[TOUCH_PAD_REPORT_SIZE];
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerCompileReportMap (mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &Map));
+  ZeroMem (&Tracker, sizeof (Tracker));
+
+  CopyMem (Report, mOneFingerStream[0], sizeof (Report));
+  UT_ASSERT_STATUS_EQUAL (HidDigitizerParseReport (Map, &Tracker, Report, sizeof (Report) - 1, &Frame), EFI_BUFFER_TOO_SMALL);
+  UT_ASSERT_STATUS_EQUAL (HidDigitizerParseReport (Map, &Tracker, Report, 0, &Frame), EFI_NOT_FOUND);
+
+  //
+  // Mouse collection report.
+  //
+  Report[0] = 3;
+  UT_ASSERT_STATUS_EQUAL (HidDigitizerParseReport (Map, &Tracker, Report, 3, &Frame), EFI_NOT_FOUND);
+
+  Report[0] = 1;
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerParseReport (Map, &Tracker, Report, sizeof (Report), &Frame));
+  UT_ASSERT_EQUAL (Frame.ContactCount, 1);
+
+  HidDigitizerFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief A touch screen puts the pointer at its first contact, scaled to the
+ * pointer range.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestTouchScreen (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINT8          Stream[][TOUCH_SCREEN_REPORT_SIZE] = {
+    { SCREEN_CONTACT (1, 7, 2048, 4095), SCREEN_CONTACT (1, 8, 100, 100), 2 },
+    { SCREEN_CONTACT (0, 7, 2048, 4095), SCREEN_CONTACT (1, 8, 0, 100),   2 },
+    { SCREEN_CONTACT (0, 8, 0, 100),     SCREEN_CONTACT (0, 0, 0, 0),     1 }
+  };
+  HID_DIGITIZER_MAP           *Map;
+  HID_DIGITIZER_TRACKER       Tracker;
+  EFI_ABSOLUTE_POINTER_MODE   Mode;
+  EFI_ABSOLUTE_POINTER_STATE  State;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerCompileReportMap (mTouchScreenDescriptor, sizeof (mTouchScreenDescriptor), &Map));
+  ZeroMem (&Tracker, sizeof (Tracker));
+  InitializePointer (&Mode, &State);
+
+  UT_ASSERT_EQUAL (ReplayStream (Map, &Tracker, Stream[0], 1, TOUCH_SCREEN_REPORT_SIZE, &Mode, &State), 1);
+  UT_ASSERT_EQUAL (State.CurrentX, 512);
+  UT_ASSERT_EQUAL (State.CurrentY, 1024);
+  UT_ASSERT_EQUAL (State.ActiveButtons, EFI_ABSP_TouchActive);
+
+  //
+  // The first finger lifted, the second one is the pointer now.
+  //
+  UT_ASSERT_EQUAL (ReplayStream (Map, &Tracker, Stream[1], 1, TOUCH_SCREEN_REPORT_SIZE, &Mode, &State), 1);
+  UT_ASSERT_EQUAL (State.CurrentX, 0);
+  UT_ASSERT_EQUAL (State.CurrentY, 25);
+  UT_ASSERT_EQUAL (State.ActiveButtons, EFI_ABSP_TouchActive);
+
+  //
+  // Lifting the last finger keeps the position.
+  //
+  UT_ASSERT_EQUAL (ReplayStream (Map, &Tracker, Stream[2], 1, TOUCH_SCREEN_REPORT_SIZE, &Mode, &State), 1);
+  UT_ASSERT_EQUAL (State.CurrentX, 0);
+  UT_ASSERT_EQUAL (State.CurrentY, 25);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 0);
+
+  HidDigitizerFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Random reports and report sizes never read past the report, never
+ * overflow a frame and keep the pointer within its range.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestFuzzReports (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_DIGITIZER_MAP           *Map;
+  HID_DIGITIZER_TRACKER       Tracker;
+  HID_DIGITIZER_FRAME         Frame;
+  EFI_ABSOLUTE_POINTER_MODE   Mode;
+  EFI_ABSOLUTE_POINTER_STATE  State;
+  UINT8                       *Report;
+  UINTN                       Size;
+  UINTN                       Iteration;
+  UINTN                       Index;
+
+  mRandomState = 0x5EED0050D161712EULL;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidDigitizerCompileReportMap (mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &Map));
+  ZeroMem (&Tracker, sizeof (Tracker));
+  InitializePointer (&Mode, &State);
+
+  for (Iteration = 0; Iteration < FUZZ_ITERATIONS; Iteration++) {
+    //
+    // Exact size allocations let the address sanitizer catch reads past the report.
+    //
+    Size   = 1 + (UINTN)(PseudoRandomNext (&mRandomState) % (TOUCH_PAD_REPORT_SIZE + 4));
+    Report = AllocatePool (Size);
+    UT_ASSERT_NOT_NULL (Report);
+    for (Index = 0; Index < Size; Index++) {
+      Report[Index] = (UINT8)PseudoRandomNext (&mRandomState);
+    }
+
+    //
+    // Mostly contact reports, with their contact count kept small now and then
+    // so that hybrid frames complete.
+    //
+    if ((PseudoRandomNext (&mRandomState) % 8) != 0) {
+      Report[0] = 1;
+    }
+
+    if ((Size > 18) && ((PseudoRandomNext (&mRandomState) % 2) != 0)) {
+      Report[18] = (UINT8)(PseudoRandomNext (&mRandomState) % 6);
+    }
+
+    if (!EFI_ERROR (HidDigitizerParseReport (Map, &Tracker, Report, Size, &Frame))) {
+      UT_ASSERT_TRUE (Frame.ContactCount <= HID_DIGITIZER_MAX_CONTACTS);
+      HidDigitizerApplyFrame (Map, &Tracker, &Frame, &Mode, &State);
+    }
+
+    UT_ASSERT_TRUE (State.CurrentX <= Mode.AbsoluteMaxX);
+    UT_ASSERT_TRUE (State.CurrentY <= Mode.AbsoluteMaxY);
+    UT_ASSERT_TRUE (State.CurrentZ <= Mode.AbsoluteMaxZ);
+    FreePool (Report);
+  }
+
+  HidDigitizerFreeReportMap (Map);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  digitizer report translation and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UefiTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      DigitizerSuiteHandle;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Create a suite
+  //
+  Status = CreateUnitTestSuite (&DigitizerSuiteHandle, Framework, "HidMouseAbsolutePointerDxe digitizer report translation", "HidMouseAbsolutePointerDxe.HID.Digitizer", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DigitizerSuiteHandle\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // Register Tests
+  //
+  AddTestCase (DigitizerSuiteHandle, "Compile touch pad and touch screen report descriptors", "CompileMap", TestCompileTouchPadMap, NULL, NULL, NULL);
+  AddTestCase (DigitizerSuiteHandle, "One finger moves the pointer", "OneFinger", TestOneFingerMotion, NULL, NULL, NULL);
+  AddTestCase (DigitizerSuiteHandle, "Two fingers scroll", "TwoFingerScroll", TestTwoFingerScroll, NULL, NULL, NULL);
+  AddTestCase (DigitizerSuiteHandle, "Contacts without confidence are ignored", "PalmRejection", TestPalmRejection, NULL, NULL, NULL);
+  AddTestCase (DigitizerSuiteHandle, "Assemble hybrid mode frames", "HybridFrames", TestHybridFrames, NULL, NULL, NULL);
+  AddTestCase (DigitizerSuiteHandle, "Pad clicks with one and two fingers", "PadClicks", TestPadClicks, NULL, NULL, NULL);
+  AddTestCase (DigitizerSuiteHandle, "Refuse other and short reports", "RefusedReports", TestRefusedReports, NULL, NULL, NULL);
+  AddTestCase (DigitizerSuiteHandle, "Touch screen positions the pointer", "TouchScreen", TestTouchScreen, NULL, NULL, NULL);
+  AddTestCase (DigitizerSuiteHandle, "Random reports stay within bounds", "Fuzz", TestFuzzReports, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UefiTestMain ();
+}
@@ -8,6 +8,7 @@
 
 #include <Uefi.h>
 #include <Library/UnitTestLib.h>
+#include <TimerLibPosix.h>
 #include "../HidMouseAbsolutePointer.h"
 
 #define UNIT_TEST_NAME     "HID Mouse Host Test"
@@ -847,6 +848,531 @@ TestOnMouseReportFuncForBootMouseValidBoundsCheck (
   @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
                                  initialize the unit tests.
 **/
+///////////////////////////////////////////////////////////////////////////////
+// REPORT COALESCING TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @brief Return TimerLib to the host clock after a test that faked the time.
+ *
+ * @param Context
+ */
+STATIC
+VOID
+EFIAPI
+UseHostClock (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TimerLibPosixUseHostClock ();
+}
+
+/**
+ * @brief Initialize a device and its absolute pointer protocol with a given
+ * limit on the rate of motion only states.
+ *
+ * @param Device            Device to initialize
+ * @param MinStateInterval  Nanoseconds between two motion only states, 0 for no limit
+ * @return UNIT_TEST_STATUS
+ */
+STATIC
+UNIT_TEST_STATUS
+InitializeCoalescingDevice (
+  OUT HID_MOUSE_ABSOLUTE_POINTER_DEV  *Device,
+  IN  UINT64                          MinStateInterval
+  )
+{
+  EFI_STATUS  Status;
+
+  ZeroMem (Device, sizeof (*Device));
+  Device->Signature                        = HID_MOUSE_ABSOLUTE_POINTER_DEV_SIGNATURE;
+  Device->AbsolutePointerProtocol.GetState = GetMouseAbsolutePointerState;
+  Device->AbsolutePointerProtocol.Reset    = HidMouseAbsolutePointerReset;
+  Device->AbsolutePointerProtocol.Mode     = &Device->Mode;
+
+  Status = InitializeMouseDevice (Device);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+
+  Device->MinStateInterval = MinStateInterval;
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Send a BootMouse HID report without Z to the device.
+ *
+ * @param Device   Device that receives the report
+ * @param Buttons  Button byte of the report
+ * @param X        X displacement
+ * @param Y        Y displacement
+ */
+STATIC
+VOID
+SendBootMouseReport (
+  IN HID_MOUSE_ABSOLUTE_POINTER_DEV  *Device,
+  IN UINT8                           Buttons,
+  IN INT8                            X,
+  IN INT8                            Y
+  )
+{
+  UINT8  Report[sizeof (MOUSE_HID_INPUT_BUFFER) - 1];
+
+  Report[0] = Buttons;
+  Report[1] = (UINT8)X;
+  Report[2] = (UINT8)Y;
+
+  OnMouseReport (BootMouse, Report, sizeof (Report), Device);
+}
+
+/**
+ * @brief Test that relative motion reported between two GetState calls is
+ * added up into one state, and that reports without news are not a new state.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestCoalesceRelativeMotion (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_MOUSE_ABSOLUTE_POINTER_DEV  device;
+  EFI_ABSOLUTE_POINTER_STATE      Before;
+  EFI_ABSOLUTE_POINTER_STATE      State;
+  EFI_STATUS                      Status;
+  UINTN                           Index;
+
+  UT_ASSERT_EQUAL (InitializeCoalescingDevice (&device, 0), UNIT_TEST_PASSED);
+  CopyMem (&Before, &device.State, sizeof (Before));
+
+  for (Index = 0; Index < 10; Index++) {
+    SendBootMouseReport (&device, 0, 7, -3);
+  }
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.CurrentX, Before.CurrentX + 70);
+  UT_ASSERT_EQUAL (State.CurrentY, Before.CurrentY - 30);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 0);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+
+  // Idle reports don't make a new state.
+  for (Index = 0; Index < 10; Index++) {
+    SendBootMouseReport (&device, 0, 0, 0);
+  }
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+
+  // Motion that ends where it started still makes a state.
+  SendBootMouseReport (&device, 0, 5, 0);
+  SendBootMouseReport (&device, 0, -5, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.CurrentX, Before.CurrentX + 70);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Test that the latest SingleTouch position between two GetState
+ * calls is returned.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestCoalesceAbsolutePosition (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_MOUSE_ABSOLUTE_POINTER_DEV  device;
+  SINGLETOUCH_HID_INPUT_BUFFER    SingleTouchInput;
+  EFI_ABSOLUTE_POINTER_STATE      State;
+  EFI_STATUS                      Status;
+  UINT16                          Index;
+
+  UT_ASSERT_EQUAL (InitializeCoalescingDevice (&device, 0), UNIT_TEST_PASSED);
+
+  ZeroMem (&SingleTouchInput, sizeof (SingleTouchInput));
+  SingleTouchInput.Touch = 1;
+  for (Index = 0; Index < 8; Index++) {
+    SingleTouchInput.CurrentX = 100 + Index;
+    SingleTouchInput.CurrentY = 200 + 2 * Index;
+    OnMouseReport (SingleTouch, (UINT8 *)&SingleTouchInput, sizeof (SingleTouchInput), &device);
+  }
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.CurrentX, 107);
+  UT_ASSERT_EQUAL (State.CurrentY, 214);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 1);
+
+  // The same position again is not a new state.
+  OnMouseReport (SingleTouch, (UINT8 *)&SingleTouchInput, sizeof (SingleTouchInput), &device);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Test that every button transition reported between two GetState
+ * calls is returned, in order, with the position it was reported at.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestButtonTransitionsAreKept (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_MOUSE_ABSOLUTE_POINTER_DEV  device;
+  SINGLETOUCH_HID_INPUT_BUFFER    SingleTouchInput;
+  EFI_ABSOLUTE_POINTER_STATE      Before;
+  EFI_ABSOLUTE_POINTER_STATE      State;
+  EFI_STATUS                      Status;
+  UINTN                           Index;
+
+  UT_ASSERT_EQUAL (InitializeCoalescingDevice (&device, 0), UNIT_TEST_PASSED);
+  CopyMem (&Before, &device.State, sizeof (Before));
+
+  // Two clicks of button 1 and moves in between, all before the first GetState.
+  SendBootMouseReport (&device, BIT0, 1, 0);
+  SendBootMouseReport (&device, BIT0, 1, 0);
+  SendBootMouseReport (&device, 0, 1, 0);
+  SendBootMouseReport (&device, 0, 1, 0);
+  SendBootMouseReport (&device, BIT0, 0, 0);
+  SendBootMouseReport (&device, 0, 0, 0);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.ActiveButtons, BIT0);
+  UT_ASSERT_EQUAL (State.CurrentX, Before.CurrentX + 2);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 0);
+  UT_ASSERT_EQUAL (State.CurrentX, Before.CurrentX + 4);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.ActiveButtons, BIT0);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 0);
+  UT_ASSERT_EQUAL (State.CurrentX, Before.CurrentX + 4);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+
+  // A tap on a touch screen between two GetState calls.
+  ZeroMem (&SingleTouchInput, sizeof (SingleTouchInput));
+  SingleTouchInput.Touch    = 1;
+  SingleTouchInput.CurrentX = 40;
+  SingleTouchInput.CurrentY = 50;
+  OnMouseReport (SingleTouch, (UINT8 *)&SingleTouchInput, sizeof (SingleTouchInput), &device);
+  SingleTouchInput.Touch = 0;
+  OnMouseReport (SingleTouch, (UINT8 *)&SingleTouchInput, sizeof (SingleTouchInput), &device);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 1);
+  UT_ASSERT_EQUAL (State.CurrentX, 40);
+  UT_ASSERT_EQUAL (State.CurrentY, 50);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 0);
+
+  // More transitions than are kept: the oldest are returned, the newest state is not lost.
+  for (Index = 0; Index < HID_MOUSE_BUTTON_STATE_DEPTH * 2; Index++) {
+    SendBootMouseReport (&device, BIT1, 0, 0);
+    SendBootMouseReport (&device, 0, 0, 0);
+  }
+
+  SendBootMouseReport (&device, BIT2, 0, 0);
+  UT_ASSERT_NOT_EQUAL (device.ButtonStateOverflows, 0);
+
+  for (Index = 0; Index < HID_MOUSE_BUTTON_STATE_DEPTH; Index++) {
+    Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+    UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+    UT_ASSERT_EQUAL (State.ActiveButtons, ((Index & 1) == 0) ? BIT1 : 0);
+  }
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.ActiveButtons, BIT2);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+
+  // Reset drops the transitions not returned yet.
+  SendBootMouseReport (&device, BIT0, 0, 0);
+  SendBootMouseReport (&device, 0, 0, 0);
+  Status = device.AbsolutePointerProtocol.Reset (&device.AbsolutePointerProtocol, FALSE);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Test that motion only states are returned no faster than the
+ * configured rate, and that button changes are returned at once.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestMotionStateRateLimit (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_MOUSE_ABSOLUTE_POINTER_DEV  device;
+  EFI_ABSOLUTE_POINTER_STATE      Before;
+  EFI_ABSOLUTE_POINTER_STATE      State;
+  EFI_STATUS                      Status;
+
+  // Time only moves when the test advances it, starting well past any interval.
+  TimerLibPosixSetFakeTime (1000000000);
+
+  // 5 states per second.
+  UT_ASSERT_EQUAL (InitializeCoalescingDevice (&device, 200000000), UNIT_TEST_PASSED);
+  CopyMem (&Before, &device.State, sizeof (Before));
+
+  // The first state after a quiet period is returned at once.
+  SendBootMouseReport (&device, 0, 3, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.CurrentX, Before.CurrentX + 3);
+
+  // Motion right after it waits for the interval.
+  SendBootMouseReport (&device, 0, 3, 0);
+  SendBootMouseReport (&device, 0, 3, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+  UT_ASSERT_TRUE (device.StateChanged);
+
+  // A button change does not, and carries the motion held back.
+  SendBootMouseReport (&device, BIT0, 3, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.CurrentX, Before.CurrentX + 12);
+  UT_ASSERT_EQUAL (State.ActiveButtons, BIT0);
+
+  // Dragging is motion only.
+  SendBootMouseReport (&device, BIT0, 3, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+
+  TimerLibPosixAdvanceFakeTime (250000000);
+  SendBootMouseReport (&device, BIT0, 3, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.CurrentX, Before.CurrentX + 18);
+  UT_ASSERT_EQUAL (State.ActiveButtons, BIT0);
+
+  return UNIT_TEST_PASSED;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DIGITIZER REPORT TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+//
+// Two finger touch pad without report IDs, coordinates 0 to 1024.
+//
+STATIC CONST UINT8  mTouchPadDescriptor[] = {
+  0x05, 0x0D,       // Usage Page (Digitizer)
+  0x09, 0x05,       // Usage (Touch Pad)
+  0xA1, 0x01,       // Collection (Application)
+  0x09, 0x22,       //   Usage (Finger)
+  0xA1, 0x02,       //   Collection (Logical)
+  0x15, 0x00,       //     Logical Minimum (0)
+  0x25, 0x01,       //     Logical Maximum (1)
+  0x75, 0x01,       //     Report Size (1)
+  0x95, 0x02,       //     Report Count (2)
+  0x09, 0x42,       //     Usage (Tip Switch)
+  0x09, 0x47,       //     Usage (Confidence)
+  0x81, 0x02,       //     Input (Data, Variable, Absolute)
+  0x75, 0x06,       //     Report Size (6)
+  0x95, 0x01,       //     Report Count (1)
+  0x25, 0x3F,       //     Logical Maximum (63)
+  0x09, 0x51,       //     Usage (Contact Identifier)
+  0x81, 0x02,       //     Input (Data, Variable, Absolute)
+  0x05, 0x01,       //     Usage Page (Generic Desktop)
+  0x26, 0x00, 0x04, //     Logical Maximum (1024)
+  0x75, 0x10,       //     Report Size (16)
+  0x95, 0x02,       //     Report Count (2)
+  0x09, 0x30,       //     Usage (X)
+  0x09, 0x31,       //     Usage (Y)
+  0x81, 0x02,       //     Input (Data, Variable, Absolute)
+  0xC0,             //   End Collection
+  0x05, 0x0D,       //   Usage Page (Digitizer)
+  0x09, 0x22,       //   Usage (Finger)
+  0xA1, 0x02,       //   Collection (Logical)
+  0x25, 0x01,       //     Logical Maximum (1)
+  0x75, 0x01,       //     Report Size (1)
+  0x95, 0x02,       //     Report Count (2)
+  0x09, 0x42,       //     Usage (Tip Switch)
+  0x09, 0x47,       //     Usage (Confidence)
+  0x81, 0x02,       //     Input (Data, Variable, Absolute)
+  0x75, 0x06,       //     Report Size (6)
+  0x95, 0x01,       //     Report Count (1)
+  0x25, 0x3F,       //     Logical Maximum (63)
+  0x09, 0x51,       //     Usage (Contact Identifier)
+  0x81, 0x02,       //     Input (Data, Variable, Absolute)
+  0x05, 0x01,       //     Usage Page (Generic Desktop)
+  0x26, 0x00, 0x04, //     Logical Maximum (1024)
+  0x75, 0x10,       //     Report Size (16)
+  0x95, 0x02,       //     Report Count (2)
+  0x09, 0x30,       //     Usage (X)
+  0x09, 0x31,       //     Usage (Y)
+  0x81, 0x02,       //     Input (Data, Variable, Absolute)
+  0xC0,             //   End Collection
+  0x05, 0x0D,       //   Usage Page (Digitizer)
+  0x25, 0x02,       //   Logical Maximum (2)
+  0x75, 0x08,       //   Report Size (8)
+  0x95, 0x01,       //   Report Count (1)
+  0x09, 0x54,       //   Usage (Contact Count)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0x05, 0x09,       //   Usage Page (Button)
+  0x09, 0x01,       //   Usage (Button 1)
+  0x25, 0x01,       //   Logical Maximum (1)
+  0x75, 0x01,       //   Report Size (1)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0x75, 0x07,       //   Report Size (7)
+  0x81, 0x03,       //   Input (Constant)
+  0xC0              // End Collection
+};
+
+/**
+ * @brief Send a report of the two finger touch pad to the device. A finger
+ * with an Id of 0 is not touching.
+ *
+ * @param Device   Device that receives the report
+ * @param Id0      Contact identifier of the first finger
+ * @param X0       X of the first finger
+ * @param Y0       Y of the first finger
+ * @param Id1      Contact identifier of the second finger
+ * @param X1       X of the second finger
+ * @param Y1       Y of the second finger
+ * @param Buttons  Pad button
+ */
+STATIC
+VOID
+SendTouchPadReport (
+  IN HID_MOUSE_ABSOLUTE_POINTER_DEV  *Device,
+  IN UINT8                           Id0,
+  IN UINT16                          X0,
+  IN UINT16                          Y0,
+  IN UINT8                           Id1,
+  IN UINT16                          X1,
+  IN UINT16                          Y1,
+  IN UINT8                           Buttons
+  )
+{
+  UINT8  Report[12];
+
+  Report[0]  = (Id0 != 0) ? (UINT8)(0x03 | (Id0 << 2)) : 0;
+  Report[1]  = (UINT8)X0;
+  Report[2]  = (UINT8)(X0 >> 8);
+  Report[3]  = (UINT8)Y0;
+  Report[4]  = (UINT8)(Y0 >> 8);
+  Report[5]  = (Id1 != 0) ? (UINT8)(0x03 | (Id1 << 2)) : 0;
+  Report[6]  = (UINT8)X1;
+  Report[7]  = (UINT8)(X1 >> 8);
+  Report[8]  = (UINT8)Y1;
+  Report[9]  = (UINT8)(Y1 >> 8);
+  Report[10] = 2;
+  Report[11] = Buttons;
+
+  OnMouseReport (ReportDigitizer, Report, sizeof (Report), Device);
+}
+
+/**
+ * @brief Test that digitizer reports are dropped until the producer passes a
+ * usable descriptor, and then move the pointer with one finger and scroll Z
+ * with two.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+TestDigitizerTouchPad (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_MOUSE_ABSOLUTE_POINTER_DEV  device;
+  EFI_ABSOLUTE_POINTER_STATE      State;
+  EFI_STATUS                      Status;
+
+  UT_ASSERT_EQUAL (InitializeCoalescingDevice (&device, 0), UNIT_TEST_PASSED);
+
+  // No descriptor yet.
+  SendTouchPadReport (&device, 1, 100, 100, 0, 0, 0, 0);
+  SendTouchPadReport (&device, 1, 200, 200, 0, 0, 0, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_NOT_READY);
+
+  // A descriptor without fingers is refused.
+  OnMouseReport (ReportDigitizerDescriptor, (UINT8 *)mTouchPadDescriptor, 6, &device);
+  UT_ASSERT_TRUE (device.DigitizerMap == NULL);
+
+  // A touch pad gets a Z range to scroll in.
+  OnMouseReport (ReportDigitizerDescriptor, (UINT8 *)mTouchPadDescriptor, sizeof (mTouchPadDescriptor), &device);
+  UT_ASSERT_NOT_NULL (device.DigitizerMap);
+  UT_ASSERT_EQUAL (device.Mode.AbsoluteMaxZ, device.Mode.AbsoluteMaxY);
+  UT_ASSERT_EQUAL (device.State.CurrentZ, 512);
+
+  // One finger lands and moves.
+  SendTouchPadReport (&device, 1, 100, 100, 0, 0, 0, 0);
+  SendTouchPadReport (&device, 1, 130, 90, 0, 0, 0, 0);
+  SendTouchPadReport (&device, 1, 150, 80, 0, 0, 0, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.CurrentX, 512 + 50);
+  UT_ASSERT_EQUAL (State.CurrentY, 512 - 20);
+  UT_ASSERT_EQUAL (State.CurrentZ, 512);
+  UT_ASSERT_EQUAL (State.ActiveButtons, 0);
+
+  // A second finger lands, and both scroll down.
+  SendTouchPadReport (&device, 1, 150, 80, 2, 400, 80, 0);
+  SendTouchPadReport (&device, 1, 150, 120, 2, 400, 130, 0);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.CurrentX, 512 + 50);
+  UT_ASSERT_EQUAL (State.CurrentY, 512 - 20);
+  UT_ASSERT_EQUAL (State.CurrentZ, 512 + 45);
+
+  // Clicking with both is the alternate button.
+  SendTouchPadReport (&device, 1, 150, 120, 2, 400, 130, 1);
+  Status = device.AbsolutePointerProtocol.GetState (&device.AbsolutePointerProtocol, &State);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (State.ActiveButtons, EFI_ABS_AltActive);
+
+  // Reset puts the scroll position back in the middle.
+  Status = device.AbsolutePointerProtocol.Reset (&device.AbsolutePointerProtocol, FALSE);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (device.State.CurrentZ, 512);
+
+  HidDigitizerFreeReportMap (device.DigitizerMap);
+
+  return UNIT_TEST_PASSED;
+}
+
 EFI_STATUS
 EFIAPI
 UefiTestMain (
@@ -859,6 +1385,8 @@ UefiTestMain (
   UNIT_TEST_SUITE_HANDLE      AbsPtrSuiteHandle;       // tests related to absolute pointer interface
   UNIT_TEST_SUITE_HANDLE      SimpleTouchSuiteHandle;  // tests using SimpleTouch hid report
   UNIT_TEST_SUITE_HANDLE      BootMouseSuiteHandle;    // tests using BootMouse hid report
+  UNIT_TEST_SUITE_HANDLE      CoalescingSuiteHandle;   // tests merging reports between GetState calls
+  UNIT_TEST_SUITE_HANDLE      DigitizerSuiteHandle;    // tests using ReportDigitizer hid reports
 
   Framework = NULL;
 
@@ -942,6 +1470,39 @@ UefiTestMain (
   AddTestCase (BootMouseSuiteHandle, "Process a BootMouse HID Report with incorrect length", "HidInputReportBufferSizeIncorrect", TestOnMouseReportFuncForBootMouseInvalidLength, NULL, NULL, NULL);
   AddTestCase (BootMouseSuiteHandle, "Process a set of BootMouse HID Reports that try to exceed min and max", "MinMaxCoordinate", TestOnMouseReportFuncForBootMouseValidBoundsCheck, NULL, NULL, NULL);
 
+  //
+  // Create a suite
+  //
+  Status = CreateUnitTestSuite (&CoalescingSuiteHandle, Framework, "HidMouseAbsolutePointerDxe report coalescing", "HidMouseAbsolutePointerDxe.Coalescing", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CoalescingSuiteHandle\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // Register Tests
+  //
+  AddTestCase (CoalescingSuiteHandle, "Relative motion between reads is added up", "RelativeMotion", TestCoalesceRelativeMotion, NULL, NULL, NULL);
+  AddTestCase (CoalescingSuiteHandle, "Latest absolute position between reads is returned", "AbsolutePosition", TestCoalesceAbsolutePosition, NULL, NULL, NULL);
+  AddTestCase (CoalescingSuiteHandle, "Button transitions between reads are all returned", "ButtonTransitions", TestButtonTransitionsAreKept, NULL, NULL, NULL);
+  AddTestCase (CoalescingSuiteHandle, "Motion only states are rate limited", "RateLimit", TestMotionStateRateLimit, NULL, UseHostClock, NULL);
+
+  //
+  // Create a suite
+  //
+  Status = CreateUnitTestSuite (&DigitizerSuiteHandle, Framework, "HidMouseAbsolutePointerDxe Digitizer HID Report", "HidMouseAbsolutePointerDxe.HID.Digitizer", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for DigitizerSuiteHandle\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  //
+  // Register Tests
+  //
+  AddTestCase (DigitizerSuiteHandle, "Process touch pad reports after their descriptor", "TouchPad", TestDigitizerTouchPad, NULL, NULL, NULL);
+
   //
   // Execute the tests.
   //
@@ -0,0 +1,140 @@
+/** @file -- HidReportDescriptorLib.h
+
+Compiles a HID report descriptor once into a flat table of report fields, so
+drivers can pull values out of each report by bit offset instead of walking
+the descriptor items for every packet.
+
+Constant (padding) main items produce no field. A variable main item with a
+list of usages is split into one field per usage, a usage range stays a single
+field whose elements take consecutive usages.
+
+Refer to USB Device Class Definition for Human Interface Devices (HID) version 1.11 section 6.2.2.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef HID_REPORT_DESCRIPTOR_LIB_H_
+#define HID_REPORT_DESCRIPTOR_LIB_H_
+
+//
+// Main item data bits.
+//
+#define HID_MAIN_ITEM_CONSTANT  BIT0
+#define HID_MAIN_ITEM_VARIABLE  BIT1
+#define HID_MAIN_ITEM_RELATIVE  BIT2
+
+//
+// A 32 bit usage, usage page in the high word and usage ID in the low word.
+//
+#define HID_USAGE(Page, Id)  (((UINT32)(Page) << 16) | (UINT16)(Id))
+#define HID_USAGE_PAGE(Usage)  ((UINT16)((Usage) >> 16))
+#define HID_USAGE_ID(Usage)    ((UINT16)(Usage))
+
+typedef enum {
+  HidReportInput,
+  HidReportOutput,
+  HidReportFeature
+} HID_REPORT_TYPE;
+
+typedef struct {
+  UINT32    ApplicationUsage;               // Usage of the enclosing application collection
+  UINT32    CollectionUsage;                // Usage of the innermost collection
+  UINT16    CollectionIndex;                // Innermost collection, numbered in descriptor order from 1
+  UINT8     ReportType;                     // HID_REPORT_TYPE
+  UINT8     ReportId;                       // 0 when the descriptor declares no report IDs
+  UINT16    Flags;                          // HID_MAIN_ITEM_* bits of the main item
+  UINT16    Count;                          // Number of elements in the field
+  UINT32    BitOffset;                      // From the start of the report, including the report ID byte
+  UINT8     BitSize;                        // Size of one element, 1 to 32
+  UINT32    UsageMinimum;                   // Usage of element 0, or of array index 0
+  UINT32    UsageMaximum;                   // Elements past the range repeat this usage
+  INT32     LogicalMinimum;
+  INT32     LogicalMaximum;
+} HID_REPORT_FIELD;
+
+typedef struct {
+  HID_REPORT_FIELD    *Fields;              // In descriptor order
+  UINTN               FieldCount;
+  BOOLEAN             ReportIdsUsed;        // Every report starts with a report ID byte
+} HID_REPORT_LAYOUT;
+
+/**
+  Compiles a HID report descriptor into a report layout.
+
+  @param[in]  Descriptor      The report descriptor.
+  @param[in]  DescriptorSize  Size of Descriptor in bytes.
+  @param[out] Layout          The new layout. Free with HidFreeReportLayout().
+
+  @retval EFI_SUCCESS             The layout was compiled.
+  @retval EFI_INVALID_PARAMETER   Descriptor or Layout is NULL.
+  @retval EFI_COMPROMISED_DATA    The descriptor is malformed: an item runs past the end, a
+                                  Pop or End Collection has no match, or a report grows too large.
+  @retval EFI_UNSUPPORTED         The descriptor nests or lists more than this parser tracks.
+  @retval EFI_OUT_OF_RESOURCES    The layout could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+HidParseReportDescriptor (
+  IN  CONST UINT8        *Descriptor,
+  IN  UINTN              DescriptorSize,
+  OUT HID_REPORT_LAYOUT  **Layout
+  );
+
+/**
+  Frees a layout returned by HidParseReportDescriptor().
+
+  @param[in]  Layout    The layout to free, may be NULL.
+
+**/
+VOID
+EFIAPI
+HidFreeReportLayout (
+  IN HID_REPORT_LAYOUT  *Layout
+  );
+
+/**
+  Reads the raw value of one element of a field from a report.
+
+  The caller is responsible for checking that the report carries Field->ReportId.
+
+  @param[in]  Field       The field.
+  @param[in]  Report      The report, starting with the report ID byte if IDs are used.
+  @param[in]  ReportSize  Size of Report in bytes.
+  @param[in]  Index       The element, less than Field->Count.
+  @param[out] Value       The element, zero extended.
+
+  @retval EFI_SUCCESS             Value was read.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL or Index is out of range.
+  @retval EFI_BUFFER_TOO_SMALL    The report ends before the element.
+
+**/
+EFI_STATUS
+EFIAPI
+HidGetReportFieldValue (
+  IN  CONST HID_REPORT_FIELD  *Field,
+  IN  CONST UINT8             *Report,
+  IN  UINTN                   ReportSize,
+  IN  UINTN                   Index,
+  OUT UINT32                  *Value
+  );
+
+/**
+  Sign extends a raw element value when the logical range of the field is signed.
+
+  @param[in]  Field   The field the value was read from.
+  @param[in]  Value   The raw value.
+
+  @return The value as a signed integer.
+
+**/
+INT32
+EFIAPI
+HidSignExtendFieldValue (
+  IN CONST HID_REPORT_FIELD  *Field,
+  IN UINT32                  Value
+  );
+
+#endif // HID_REPORT_DESCRIPTOR_LIB_H_
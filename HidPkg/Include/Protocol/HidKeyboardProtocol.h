@@ -26,9 +26,19 @@ Spec:
 typedef struct _HID_KEYBOARD_PROTOCOL HID_KEYBOARD_PROTOCOL;
 
 // Define the supported HID interfaces.
-// Currently only Boot Keyboard as defined in HID 1.11 B.1 is supported.
+// BootKeyboard      - Boot Keyboard report as defined in HID 1.11 B.1, see KEYBOARD_HID_INPUT_BUFFER.
+// ReportKeyboard    - Report protocol input report laid out by the device's report descriptor. When the
+//                     descriptor declares report IDs, the report starts with its report ID.
+// ReportKeyboardDescriptor - The HID report descriptor of a report protocol keyboard. A producer that sends
+//                     ReportKeyboard reports passes the descriptor to the callback from within
+//                     RegisterKeyboardHidReportCallback, before any ReportKeyboard report.
+//
+// SetOutputReport always takes the BootKeyboard LED format (KEYBOARD_HID_OUTPUT_BUFFER); a producer that runs
+// its device in report protocol translates it to the device's output report.
 typedef enum {
-  BootKeyboard
+  BootKeyboard,
+  ReportKeyboard,
+  ReportKeyboardDescriptor
 } KEYBOARD_HID_INTERFACE;
 
 // Structures for BootKeyboard interface
@@ -29,9 +29,18 @@ typedef struct _HID_POINTER_PROTOCOL HID_POINTER_PROTOCOL;
 // Currently supported interfaces:
 // Boot Mouse as defined in HID 1.11 B.1
 // Single Touch HID interface as defined below.
+// ReportDigitizer   - Input report of a touch pad or touch screen laid out by the device's report descriptor,
+//                     with one finger collection per contact. When the descriptor declares report IDs, the
+//                     report starts with its report ID. A precision touch pad must already be in its touch pad
+//                     input mode, setting the input mode feature report is up to the producer.
+// ReportDigitizerDescriptor - The HID report descriptor of a digitizer. A producer that sends ReportDigitizer
+//                     reports passes the descriptor to the callback from within RegisterPointerReportCallback,
+//                     before any ReportDigitizer report.
 typedef enum {
   BootMouse,
-  SingleTouch
+  SingleTouch,
+  ReportDigitizer,
+  ReportDigitizerDescriptor
 } HID_POINTER_INTERFACE;
 
 // Structures for BootMouse interface
@@ -0,0 +1,718 @@
+/** @file -- HidReportDescriptorLib.c
+
+Compiles a HID report descriptor into a flat table of report fields.
+
+The descriptor is walked twice with the same item parser, once to count the
+fields and once to fill them, so the layout is a single allocation sized
+exactly for the descriptor.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/HidReportDescriptorLib.h>
+
+//
+// Largest report this parser accepts, in bytes, including the report ID byte.
+//
+#define HID_REPORT_MAX_SIZE  4096
+
+//
+// Limits of the parser state. Descriptors that exceed them are rejected with
+// EFI_UNSUPPORTED rather than compiled into a layout with missing fields.
+//
+#define HID_PARSER_MAX_USAGES        64
+#define HID_PARSER_MAX_GLOBAL_STACK  8
+#define HID_PARSER_MAX_COLLECTIONS   16
+
+//
+// Item prefix decoding, HID 1.11 section 6.2.2.2.
+//
+#define HID_ITEM_LONG_PREFIX  0xFE
+
+#define HID_ITEM_TYPE_MAIN    0
+#define HID_ITEM_TYPE_GLOBAL  1
+#define HID_ITEM_TYPE_LOCAL   2
+
+#define HID_MAIN_TAG_INPUT           0x8
+#define HID_MAIN_TAG_OUTPUT          0x9
+#define HID_MAIN_TAG_COLLECTION      0xA
+#define HID_MAIN_TAG_FEATURE         0xB
+#define HID_MAIN_TAG_END_COLLECTION  0xC
+
+#define HID_GLOBAL_TAG_USAGE_PAGE    0x0
+#define HID_GLOBAL_TAG_LOGICAL_MIN   0x1
+#define HID_GLOBAL_TAG_LOGICAL_MAX   0x2
+#define HID_GLOBAL_TAG_REPORT_SIZE   0x7
+#define HID_GLOBAL_TAG_REPORT_ID     0x8
+#define HID_GLOBAL_TAG_REPORT_COUNT  0x9
+#define HID_GLOBAL_TAG_PUSH          0xA
+#define HID_GLOBAL_TAG_POP           0xB
+
+#define HID_LOCAL_TAG_USAGE          0x0
+#define HID_LOCAL_TAG_USAGE_MINIMUM  0x1
+#define HID_LOCAL_TAG_USAGE_MAXIMUM  0x2
+
+#define HID_COLLECTION_APPLICATION  0x01
+
+typedef struct {
+  UINT16    UsagePage;
+  UINT32    LogicalMinimum;                 // Raw item data, see LogicalMinimumSize
+  UINT8     LogicalMinimumSize;
+  UINT32    LogicalMaximum;
+  UINT8     LogicalMaximumSize;
+  UINT32    ReportSize;
+  UINT32    ReportCount;
+  UINT8     ReportId;
+} HID_PARSER_GLOBAL;
+
+typedef struct {
+  UINT32     Usages[HID_PARSER_MAX_USAGES];
+  BOOLEAN    Extended[HID_PARSER_MAX_USAGES];    // Usage page given in the item
+  UINTN      UsageCount;
+  UINT32     UsageMinimum;
+  BOOLEAN    UsageMinimumExtended;
+  BOOLEAN    HaveUsageMinimum;
+  UINT32     UsageMaximum;
+  BOOLEAN    UsageMaximumExtended;
+  BOOLEAN    HaveUsageMaximum;
+} HID_PARSER_LOCAL;
+
+typedef struct {
+  UINT32    Usage;
+  UINT32    ApplicationUsage;
+  UINT16    Index;
+} HID_PARSER_COLLECTION;
+
+typedef struct {
+  HID_PARSER_GLOBAL        Global;
+  HID_PARSER_GLOBAL        GlobalStack[HID_PARSER_MAX_GLOBAL_STACK];
+  UINTN                    GlobalDepth;
+  HID_PARSER_LOCAL         Local;
+  HID_PARSER_COLLECTION    Collections[HID_PARSER_MAX_COLLECTIONS];
+  UINTN                    CollectionDepth;
+  UINT16                   CollectionCount;
+  BOOLEAN                  ReportIdsUsed;
+  UINT32                   BitOffset[HidReportFeature + 1][256];   // Excludes the report ID byte
+  HID_REPORT_FIELD         *Fields;                                // NULL while counting
+  UINTN                    FieldCount;
+} HID_PARSER_STATE;
+
+/**
+  Sign extends item data.
+
+  @param[in]  Data    The item data.
+  @param[in]  Size    The item data size in bytes, 0 to 4.
+
+  @return The data as a signed integer.
+**/
+STATIC
+INT32
+ItemDataToSigned (
+  IN UINT32  Data,
+  IN UINT8   Size
+  )
+{
+  switch (Size) {
+    case 1:
+      return (INT8)Data;
+    case 2:
+      return (INT16)Data;
+    default:
+      return (INT32)Data;
+  }
+}
+
+/**
+  Resolves a local usage item to a 32 bit usage.
+
+  @param[in]  State     The parser state.
+  @param[in]  Usage     The usage item data.
+  @param[in]  Extended  TRUE if the item carried its own usage page.
+
+  @return The usage.
+**/
+STATIC
+UINT32
+ResolveUsage (
+  IN CONST HID_PARSER_STATE  *State,
+  IN UINT32                  Usage,
+  IN BOOLEAN                 Extended
+  )
+{
+  if (Extended) {
+    return Usage;
+  }
+
+  return HID_USAGE (State->Global.UsagePage, Usage);
+}
+
+/**
+  Records one field, or only counts it while State->Fields is NULL.
+
+  @param[in]  State         The parser state.
+  @param[in]  Template      The field with everything but the usages and count filled in.
+  @param[in]  Count         Number of elements.
+  @param[in]  UsageMinimum  Usage of the first element.
+  @param[in]  UsageMaximum  Usage of the last element.
+**/
+STATIC
+VOID
+EmitField (
+  IN HID_PARSER_STATE        *State,
+  IN CONST HID_REPORT_FIELD  *Template,
+  IN UINT32                  Count,
+  IN UINT32                  UsageMinimum,
+  IN UINT32                  UsageMaximum
+  )
+{
+  HID_REPORT_FIELD  *Field;
+
+  if (State->Fields != NULL) {
+    Field = &State->Fields[State->FieldCount];
+    CopyMem (Field, Template, sizeof (*Field));
+    Field->Count        = (UINT16)Count;
+    Field->UsageMinimum = UsageMinimum;
+    Field->UsageMaximum = UsageMaximum;
+  }
+
+  State->FieldCount++;
+}
+
+/**
+  Handles an Input, Output or Feature main item.
+
+  @param[in]  State     The parser state.
+  @param[in]  Type      The report type.
+  @param[in]  Data      The main item data.
+
+  @retval EFI_SUCCESS           The item was handled.
+  @retval EFI_COMPROMISED_DATA  The report grows too large.
+  @retval EFI_UNSUPPORTED       A data field has elements wider than 32 bits.
+**/
+STATIC
+EFI_STATUS
+ParseReportItem (
+  IN HID_PARSER_STATE  *State,
+  IN HID_REPORT_TYPE   Type,
+  IN UINT32            Data
+  )
+{
+  HID_PARSER_GLOBAL  *Global;
+  HID_PARSER_LOCAL   *Local;
+  HID_REPORT_FIELD   Template;
+  UINT64             Bits;
+  UINT32             Remaining;
+  UINT32             UsageMinimum;
+  UINT32             UsageMaximum;
+  UINTN              Index;
+
+  Global = &State->Global;
+  Local  = &State->Local;
+
+  Bits = (UINT64)Global->ReportSize * Global->ReportCount;
+  if (State->BitOffset[Type][Global->ReportId] + Bits > (HID_REPORT_MAX_SIZE - 1) * 8) {
+    DEBUG ((DEBUG_ERROR, "%a: report %u grows past %u bytes\n", __FUNCTION__, Global->ReportId, HID_REPORT_MAX_SIZE));
+    return EFI_COMPROMISED_DATA;
+  }
+
+  ZeroMem (&Template, sizeof (Template));
+  Template.ReportType = (UINT8)Type;
+  Template.ReportId   = Global->ReportId;
+  Template.Flags      = (UINT16)(Data & 0x1FF);
+  Template.BitOffset  = State->BitOffset[Type][Global->ReportId];
+  if (State->ReportIdsUsed) {
+    Template.BitOffset += 8;
+  }
+
+  State->BitOffset[Type][Global->ReportId] += (UINT32)Bits;
+
+  //
+  // Constant items are padding and produce no field.
+  //
+  if (((Data & HID_MAIN_ITEM_CONSTANT) != 0) || (Bits == 0)) {
+    return EFI_SUCCESS;
+  }
+
+  if (Global->ReportSize > 32) {
+    DEBUG ((DEBUG_ERROR, "%a: %u bit report elements are not supported\n", __FUNCTION__, Global->ReportSize));
+    return EFI_UNSUPPORTED;
+  }
+
+  Template.BitSize        = (UINT8)Global->ReportSize;
+  Template.LogicalMinimum = ItemDataToSigned (Global->LogicalMinimum, Global->LogicalMinimumSize);
+  Template.LogicalMaximum = ItemDataToSigned (Global->LogicalMaximum, Global->LogicalMaximumSize);
+  if (Template.LogicalMaximum < Template.LogicalMinimum) {
+    //
+    // Devices commonly declare an unsigned range with a maximum that has the
+    // sign bit of its item set, e.g. 0 to 0xFF in a one byte item.
+    //
+    Template.LogicalMaximum = (INT32)Global->LogicalMaximum;
+  }
+
+  if (State->CollectionDepth > 0) {
+    Template.CollectionUsage  = State->Collections[State->CollectionDepth - 1].Usage;
+    Template.CollectionIndex  = State->Collections[State->CollectionDepth - 1].Index;
+    Template.ApplicationUsage = State->Collections[State->CollectionDepth - 1].ApplicationUsage;
+  }
+
+  UsageMinimum = 0;
+  UsageMaximum = 0;
+  if (Local->HaveUsageMinimum) {
+    UsageMinimum = ResolveUsage (State, Local->UsageMinimum, Local->UsageMinimumExtended);
+    UsageMaximum = UsageMinimum;
+  }
+
+  if (Local->HaveUsageMaximum) {
+    UsageMaximum = ResolveUsage (State, Local->UsageMaximum, Local->UsageMaximumExtended);
+    if (!Local->HaveUsageMinimum) {
+      UsageMinimum = UsageMaximum;
+    }
+  }
+
+  if ((Data & HID_MAIN_ITEM_VARIABLE) == 0) {
+    //
+    // Array: each element holds an index into the usages.
+    //
+    if ((Local->UsageCount > 0) && !(Local->HaveUsageMinimum || Local->HaveUsageMaximum)) {
+      UsageMinimum = ResolveUsage (State, Local->Usages[0], Local->Extended[0]);
+      UsageMaximum = ResolveUsage (State, Local->Usages[Local->UsageCount - 1], Local->Extended[Local->UsageCount - 1]);
+    }
+
+    EmitField (State, &Template, Global->ReportCount, UsageMinimum, UsageMaximum);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Variable: the listed usages go to the first elements one field each, a
+  // usage range takes the rest. Without a range the last listed usage does.
+  //
+  Remaining = Global->ReportCount;
+  for (Index = 0; Index < Local->UsageCount && Remaining > 0; Index++) {
+    if ((Index + 1 == Local->UsageCount) && !(Local->HaveUsageMinimum || Local->HaveUsageMaximum)) {
+      break;
+    }
+
+    EmitField (
+      State,
+      &Template,
+      1,
+      ResolveUsage (State, Local->Usages[Index], Local->Extended[Index]),
+      ResolveUsage (State, Local->Usages[Index], Local->Extended[Index])
+      );
+    Template.BitOffset += Template.BitSize;
+    Remaining--;
+  }
+
+  if (Remaining == 0) {
+    return EFI_SUCCESS;
+  }
+
+  if (!(Local->HaveUsageMinimum || Local->HaveUsageMaximum) && (Index < Local->UsageCount)) {
+    UsageMinimum = ResolveUsage (State, Local->Usages[Index], Local->Extended[Index]);
+    UsageMaximum = UsageMinimum;
+  }
+
+  EmitField (State, &Template, Remaining, UsageMinimum, UsageMaximum);
+  return EFI_SUCCESS;
+}
+
+/**
+  Walks every item of the descriptor.
+
+  @param[in]  Descriptor      The report descriptor.
+  @param[in]  DescriptorSize  Size of Descriptor in bytes.
+  @param[in]  State           Zeroed parser state, with Fields set when filling.
+
+  @retval EFI_SUCCESS           The descriptor was walked.
+  @retval EFI_COMPROMISED_DATA  The descriptor is malformed.
+  @retval EFI_UNSUPPORTED       The descriptor exceeds the parser limits.
+**/
+STATIC
+EFI_STATUS
+ParseItems (
+  IN CONST UINT8       *Descriptor,
+  IN UINTN             DescriptorSize,
+  IN HID_PARSER_STATE  *State
+  )
+{
+  EFI_STATUS             Status;
+  UINTN                  Offset;
+  UINT8                  Prefix;
+  UINT8                  Size;
+  UINT8                  Type;
+  UINT8                  Tag;
+  UINT32                 Data;
+  UINTN                  Index;
+  HID_PARSER_LOCAL       *Local;
+  HID_PARSER_COLLECTION  *Collection;
+
+  Local  = &State->Local;
+  Offset = 0;
+  while (Offset < DescriptorSize) {
+    Prefix = Descriptor[Offset++];
+
+    if (Prefix == HID_ITEM_LONG_PREFIX) {
+      //
+      // No long items are defined, skip over the data size, tag and data.
+      //
+      if ((DescriptorSize - Offset < 2) || (DescriptorSize - Offset - 2 < Descriptor[Offset])) {
+        DEBUG ((DEBUG_ERROR, "%a: long item at %u runs past the end\n", __FUNCTION__, (UINT32)(Offset - 1)));
+        return EFI_COMPROMISED_DATA;
+      }
+
+      Offset += 2 + Descriptor[Offset];
+      continue;
+    }
+
+    Size = Prefix & 0x3;
+    if (Size == 3) {
+      Size = 4;
+    }
+
+    Type = (Prefix >> 2) & 0x3;
+    Tag  = Prefix >> 4;
+
+    if (DescriptorSize - Offset < Size) {
+      DEBUG ((DEBUG_ERROR, "%a: item at %u runs past the end\n", __FUNCTION__, (UINT32)(Offset - 1)));
+      return EFI_COMPROMISED_DATA;
+    }
+
+    Data = 0;
+    for (Index = 0; Index < Size; Index++) {
+      Data |= (UINT32)Descriptor[Offset + Index] << (8 * Index);
+    }
+
+    Offset += Size;
+
+    switch (Type) {
+      case HID_ITEM_TYPE_MAIN:
+        switch (Tag) {
+          case HID_MAIN_TAG_INPUT:
+            Status = ParseReportItem (State, HidReportInput, Data);
+            break;
+          case HID_MAIN_TAG_OUTPUT:
+            Status = ParseReportItem (State, HidReportOutput, Data);
+            break;
+          case HID_MAIN_TAG_FEATURE:
+            Status = ParseReportItem (State, HidReportFeature, Data);
+            break;
+          case HID_MAIN_TAG_COLLECTION:
+            if (State->CollectionDepth == HID_PARSER_MAX_COLLECTIONS) {
+              DEBUG ((DEBUG_ERROR, "%a: collections nest deeper than %d\n", __FUNCTION__, HID_PARSER_MAX_COLLECTIONS));
+              return EFI_UNSUPPORTED;
+            }
+
+            Collection = &State->Collections[State->CollectionDepth];
+            if (Local->UsageCount > 0) {
+              Collection->Usage = ResolveUsage (State, Local->Usages[0], Local->Extended[0]);
+            } else if (Local->HaveUsageMinimum) {
+              Collection->Usage = ResolveUsage (State, Local->UsageMinimum, Local->UsageMinimumExtended);
+            } else {
+              Collection->Usage = 0;
+            }
+
+            if ((Data & 0xFF) == HID_COLLECTION_APPLICATION) {
+              Collection->ApplicationUsage = Collection->Usage;
+            } else if (State->CollectionDepth > 0) {
+              Collection->ApplicationUsage = State->Collections[State->CollectionDepth - 1].ApplicationUsage;
+            } else {
+              Collection->ApplicationUsage = 0;
+            }
+
+            Collection->Index = ++State->CollectionCount;
+            State->CollectionDepth++;
+            Status = EFI_SUCCESS;
+            break;
+          case HID_MAIN_TAG_END_COLLECTION:
+            if (State->CollectionDepth == 0) {
+              DEBUG ((DEBUG_ERROR, "%a: End Collection at %u has no Collection\n", __FUNCTION__, (UINT32)(Offset - Size - 1)));
+              return EFI_COMPROMISED_DATA;
+            }
+
+            State->CollectionDepth--;
+            Status = EFI_SUCCESS;
+            break;
+          default:
+            Status = EFI_SUCCESS;
+            break;
+        }
+
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+
+        //
+        // Local items only apply to the main item that follows them.
+        //
+        ZeroMem (Local, sizeof (*Local));
+        break;
+
+      case HID_ITEM_TYPE_GLOBAL:
+        switch (Tag) {
+          case HID_GLOBAL_TAG_USAGE_PAGE:
+            State->Global.UsagePage = (UINT16)Data;
+            break;
+          case HID_GLOBAL_TAG_LOGICAL_MIN:
+            State->Global.LogicalMinimum     = Data;
+            State->Global.LogicalMinimumSize = Size;
+            break;
+          case HID_GLOBAL_TAG_LOGICAL_MAX:
+            State->Global.LogicalMaximum     = Data;
+            State->Global.LogicalMaximumSize = Size;
+            break;
+          case HID_GLOBAL_TAG_REPORT_SIZE:
+            State->Global.ReportSize = Data;
+            break;
+          case HID_GLOBAL_TAG_REPORT_COUNT:
+            State->Global.ReportCount = Data;
+            break;
+          case HID_GLOBAL_TAG_REPORT_ID:
+            if ((Data == 0) || (Data > MAX_UINT8)) {
+              DEBUG ((DEBUG_ERROR, "%a: report ID %u is invalid\n", __FUNCTION__, Data));
+              return EFI_COMPROMISED_DATA;
+            }
+
+            State->Global.ReportId = (UINT8)Data;
+            State->ReportIdsUsed   = TRUE;
+            break;
+          case HID_GLOBAL_TAG_PUSH:
+            if (State->GlobalDepth == HID_PARSER_MAX_GLOBAL_STACK) {
+              DEBUG ((DEBUG_ERROR, "%a: Push nests deeper than %d\n", __FUNCTION__, HID_PARSER_MAX_GLOBAL_STACK));
+              return EFI_UNSUPPORTED;
+            }
+
+            CopyMem (&State->GlobalStack[State->GlobalDepth++], &State->Global, sizeof (State->Global));
+            break;
+          case HID_GLOBAL_TAG_POP:
+            if (State->GlobalDepth == 0) {
+              DEBUG ((DEBUG_ERROR, "%a: Pop at %u has no Push\n", __FUNCTION__, (UINT32)(Offset - Size - 1)));
+              return EFI_COMPROMISED_DATA;
+            }
+
+            CopyMem (&State->Global, &State->GlobalStack[--State->GlobalDepth], sizeof (State->Global));
+            break;
+          default:
+            break;
+        }
+
+        break;
+
+      case HID_ITEM_TYPE_LOCAL:
+        switch (Tag) {
+          case HID_LOCAL_TAG_USAGE:
+            if (Local->UsageCount == HID_PARSER_MAX_USAGES) {
+              DEBUG ((DEBUG_ERROR, "%a: more than %d usages before a main item\n", __FUNCTION__, HID_PARSER_MAX_USAGES));
+              return EFI_UNSUPPORTED;
+            }
+
+            Local->Usages[Local->UsageCount]   = Data;
+            Local->Extended[Local->UsageCount] = (BOOLEAN)(Size == 4);
+            Local->UsageCount++;
+            break;
+          case HID_LOCAL_TAG_USAGE_MINIMUM:
+            Local->UsageMinimum         = Data;
+            Local->UsageMinimumExtended = (BOOLEAN)(Size == 4);
+            Local->HaveUsageMinimum     = TRUE;
+            break;
+          case HID_LOCAL_TAG_USAGE_MAXIMUM:
+            Local->UsageMaximum         = Data;
+            Local->UsageMaximumExtended = (BOOLEAN)(Size == 4);
+            Local->HaveUsageMaximum     = TRUE;
+            break;
+          default:
+            break;
+        }
+
+        break;
+
+      default:
+        //
+        // Reserved item type, skip it.
+        //
+        break;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Compiles a HID report descriptor into a report layout.
+
+  @param[in]  Descriptor      The report descriptor.
+  @param[in]  DescriptorSize  Size of Descriptor in bytes.
+  @param[out] Layout          The new layout. Free with HidFreeReportLayout().
+
+  @retval EFI_SUCCESS             The layout was compiled.
+  @retval EFI_INVALID_PARAMETER   Descriptor or Layout is NULL.
+  @retval EFI_COMPROMISED_DATA    The descriptor is malformed: an item runs past the end, a
+                                  Pop or End Collection has no match, or a report grows too large.
+  @retval EFI_UNSUPPORTED         The descriptor nests or lists more than this parser tracks.
+  @retval EFI_OUT_OF_RESOURCES    The layout could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+HidParseReportDescriptor (
+  IN  CONST UINT8        *Descriptor,
+  IN  UINTN              DescriptorSize,
+  OUT HID_REPORT_LAYOUT  **Layout
+  )
+{
+  EFI_STATUS         Status;
+  HID_PARSER_STATE   *State;
+  HID_REPORT_LAYOUT  *NewLayout;
+  UINTN              FieldCount;
+
+  if ((Descriptor == NULL) || (Layout == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Layout = NULL;
+
+  State = AllocatePool (sizeof (*State));
+  if (State == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem (State, sizeof (*State));
+  Status = ParseItems (Descriptor, DescriptorSize, State);
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  FieldCount = State->FieldCount;
+  NewLayout  = AllocateZeroPool (sizeof (*NewLayout) + FieldCount * sizeof (HID_REPORT_FIELD));
+  if (NewLayout == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  NewLayout->Fields = (HID_REPORT_FIELD *)(NewLayout + 1);
+
+  ZeroMem (State, sizeof (*State));
+  State->Fields = NewLayout->Fields;
+  Status        = ParseItems (Descriptor, DescriptorSize, State);
+  ASSERT_EFI_ERROR (Status);
+  ASSERT (State->FieldCount == FieldCount);
+
+  NewLayout->FieldCount    = FieldCount;
+  NewLayout->ReportIdsUsed = State->ReportIdsUsed;
+  *Layout                  = NewLayout;
+
+Exit:
+  FreePool (State);
+  return Status;
+}
+
+/**
+  Frees a layout returned by HidParseReportDescriptor().
+
+  @param[in]  Layout    The layout to free, may be NULL.
+
+**/
+VOID
+EFIAPI
+HidFreeReportLayout (
+  IN HID_REPORT_LAYOUT  *Layout
+  )
+{
+  if (Layout != NULL) {
+    FreePool (Layout);
+  }
+}
+
+/**
+  Reads the raw value of one element of a field from a report.
+
+  The caller is responsible for checking that the report carries Field->ReportId.
+
+  @param[in]  Field       The field.
+  @param[in]  Report      The report, starting with the report ID byte if IDs are used.
+  @param[in]  ReportSize  Size of Report in bytes.
+  @param[in]  Index       The element, less than Field->Count.
+  @param[out] Value       The element, zero extended.
+
+  @retval EFI_SUCCESS             Value was read.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL or Index is out of range.
+  @retval EFI_BUFFER_TOO_SMALL    The report ends before the element.
+
+**/
+EFI_STATUS
+EFIAPI
+HidGetReportFieldValue (
+  IN  CONST HID_REPORT_FIELD  *Field,
+  IN  CONST UINT8             *Report,
+  IN  UINTN                   ReportSize,
+  IN  UINTN                   Index,
+  OUT UINT32                  *Value
+  )
+{
+  UINT64  Bit;
+  UINTN   Byte;
+  UINTN   LastByte;
+  UINT64  Bits;
+
+  if ((Field == NULL) || (Report == NULL) || (Value == NULL) || (Index >= Field->Count) ||
+      (Field->BitSize == 0) || (Field->BitSize > 32))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Bit = Field->BitOffset + (UINT64)Index * Field->BitSize;
+  if (Bit + Field->BitSize > (UINT64)ReportSize * 8) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  //
+  // An element of up to 32 bits spans at most five bytes.
+  //
+  Byte     = (UINTN)(Bit / 8);
+  LastByte = (UINTN)((Bit + Field->BitSize - 1) / 8);
+  Bits     = 0;
+  while (LastByte >= Byte) {
+    Bits = LShiftU64 (Bits, 8) | Report[LastByte];
+    if (LastByte == 0) {
+      break;
+    }
+
+    LastByte--;
+  }
+
+  Bits   = RShiftU64 (Bits, (UINTN)(Bit % 8));
+  *Value = (UINT32)(Bits & (LShiftU64 (1, Field->BitSize) - 1));
+  return EFI_SUCCESS;
+}
+
+/**
+  Sign extends a raw element value when the logical range of the field is signed.
+
+  @param[in]  Field   The field the value was read from.
+  @param[in]  Value   The raw value.
+
+  @return The value as a signed integer.
+
+**/
+INT32
+EFIAPI
+HidSignExtendFieldValue (
+  IN CONST HID_REPORT_FIELD  *Field,
+  IN UINT32                  Value
+  )
+{
+  ASSERT (Field != NULL);
+
+  if ((Field->LogicalMinimum < 0) && (Field->BitSize > 0) && (Field->BitSize < 32) && ((Value & (1u << (Field->BitSize - 1))) != 0)) {
+    return (INT32)(Value | ~((1u << Field->BitSize) - 1));
+  }
+
+  return (INT32)Value;
+}
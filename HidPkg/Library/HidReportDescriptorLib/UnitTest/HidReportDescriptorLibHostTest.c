@@ -0,0 +1,600 @@
+/** @file -- HidReportDescriptorLibHostTest.c
+Host-based UnitTest for HidReportDescriptorLib.
+
+Known keyboard descriptors are checked field by field, malformed descriptors
+must be rejected, and mutated descriptors must never produce a field that
+reaches outside its report.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PseudoRandomLib.h>
+#include <Library/HidReportDescriptorLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "HidReportDescriptorLib Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define FUZZ_ITERATIONS  20000
+
+//
+// Boot keyboard, HID 1.11 appendix B.1.
+//
+STATIC CONST UINT8  mBootKeyboardDescriptor[] = {
+  0x05, 0x01,       // Usage Page (Generic Desktop)
+  0x09, 0x06,       // Usage (Keyboard)
+  0xA1, 0x01,       // Collection (Application)
+  0x05, 0x07,       //   Usage Page (Keyboard)
+  0x19, 0xE0,       //   Usage Minimum (Left Control)
+  0x29, 0xE7,       //   Usage Maximum (Right GUI)
+  0x15, 0x00,       //   Logical Minimum (0)
+  0x25, 0x01,       //   Logical Maximum (1)
+  0x75, 0x01,       //   Report Size (1)
+  0x95, 0x08,       //   Report Count (8)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0x95, 0x01,       //   Report Count (1)
+  0x75, 0x08,       //   Report Size (8)
+  0x81, 0x01,       //   Input (Constant)
+  0x95, 0x05,       //   Report Count (5)
+  0x75, 0x01,       //   Report Size (1)
+  0x05, 0x08,       //   Usage Page (LEDs)
+  0x19, 0x01,       //   Usage Minimum (Num Lock)
+  0x29, 0x05,       //   Usage Maximum (Kana)
+  0x91, 0x02,       //   Output (Data, Variable, Absolute)
+  0x95, 0x01,       //   Report Count (1)
+  0x75, 0x03,       //   Report Size (3)
+  0x91, 0x01,       //   Output (Constant)
+  0x95, 0x06,       //   Report Count (6)
+  0x75, 0x08,       //   Report Size (8)
+  0x15, 0x00,       //   Logical Minimum (0)
+  0x25, 0x65,       //   Logical Maximum (101)
+  0x05, 0x07,       //   Usage Page (Keyboard)
+  0x19, 0x00,       //   Usage Minimum (0)
+  0x29, 0x65,       //   Usage Maximum (101)
+  0x81, 0x00,       //   Input (Data, Array)
+  0xC0              // End Collection
+};
+
+//
+// N-key rollover keyboard with a bitmap report and a consumer control report.
+//
+STATIC CONST UINT8  mNkroKeyboardDescriptor[] = {
+  0x05, 0x01,       // Usage Page (Generic Desktop)
+  0x09, 0x06,       // Usage (Keyboard)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x01,       //   Report ID (1)
+  0x05, 0x07,       //   Usage Page (Keyboard)
+  0x19, 0xE0,       //   Usage Minimum (Left Control)
+  0x29, 0xE7,       //   Usage Maximum (Right GUI)
+  0x15, 0x00,       //   Logical Minimum (0)
+  0x25, 0x01,       //   Logical Maximum (1)
+  0x75, 0x01,       //   Report Size (1)
+  0x95, 0x08,       //   Report Count (8)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0x19, 0x00,       //   Usage Minimum (0)
+  0x29, 0x77,       //   Usage Maximum (0x77)
+  0x95, 0x78,       //   Report Count (120)
+  0x81, 0x02,       //   Input (Data, Variable, Absolute)
+  0xC0,             // End Collection
+  0x05, 0x0C,       // Usage Page (Consumer)
+  0x09, 0x01,       // Usage (Consumer Control)
+  0xA1, 0x01,       // Collection (Application)
+  0x85, 0x02,       //   Report ID (2)
+  0x19, 0x00,       //   Usage Minimum (0)
+  0x2A, 0xFF, 0x03, //   Usage Maximum (0x3FF)
+  0x15, 0x00,       //   Logical Minimum (0)
+  0x26, 0xFF, 0x03, //   Logical Maximum (0x3FF)
+  0x75, 0x10,       //   Report Size (16)
+  0x95, 0x01,       //   Report Count (1)
+  0x81, 0x00,       //   Input (Data, Array)
+  0xC0              // End Collection
+};
+
+//
+// Usage list, extended usage, signed range and Push/Pop.
+//
+STATIC CONST UINT8  mPointerDescriptor[] = {
+  0x05, 0x01,                   // Usage Page (Generic Desktop)
+  0x09, 0x02,                   // Usage (Mouse)
+  0xA1, 0x01,                   // Collection (Application)
+  0x09, 0x01,                   //   Usage (Pointer)
+  0xA1, 0x00,                   //   Collection (Physical)
+  0xA4,                         //     Push
+  0x05, 0x09,                   //     Usage Page (Button)
+  0x19, 0x01,                   //     Usage Minimum (1)
+  0x29, 0x03,                   //     Usage Maximum (3)
+  0x15, 0x00,                   //     Logical Minimum (0)
+  0x25, 0x01,                   //     Logical Maximum (1)
+  0x75, 0x01,                   //     Report Size (1)
+  0x95, 0x03,                   //     Report Count (3)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0x75, 0x05,                   //     Report Size (5)
+  0x95, 0x01,                   //     Report Count (1)
+  0x81, 0x03,                   //     Input (Constant)
+  0xB4,                         //     Pop
+  0x09, 0x30,                   //     Usage (X)
+  0x09, 0x31,                   //     Usage (Y)
+  0x0B, 0x38, 0x02, 0x0C, 0x00, //     Usage (Consumer AC Pan)
+  0x16, 0x01, 0x80,             //     Logical Minimum (-32767)
+  0x26, 0xFF, 0x7F,             //     Logical Maximum (32767)
+  0x75, 0x0C,                   //     Report Size (12)
+  0x95, 0x04,                   //     Report Count (4)
+  0x81, 0x06,                   //     Input (Data, Variable, Relative)
+  0x09, 0x38,                   //     Usage (Wheel)
+  0x15, 0x00,                   //     Logical Minimum (0)
+  0x25, 0xFF,                   //     Logical Maximum (255)
+  0x75, 0x08,                   //     Report Size (8)
+  0x95, 0x01,                   //     Report Count (1)
+  0x81, 0x02,                   //     Input (Data, Variable, Absolute)
+  0xC0,                         //   End Collection
+  0xC0                          // End Collection
+};
+
+STATIC UINT64  mRandomState;
+
+/**
+ * @brief Compare a field against the expected report position and usages.
+ */
+STATIC
+BOOLEAN
+FieldIs (
+  IN CONST HID_REPORT_FIELD  *Field,
+  IN UINT8                   ReportType,
+  IN UINT8                   ReportId,
+  IN UINT32                  BitOffset,
+  IN UINT8                   BitSize,
+  IN UINT16                  Count,
+  IN UINT32                  UsageMinimum,
+  IN UINT32                  UsageMaximum
+  )
+{
+  if ((Field->ReportType != ReportType) || (Field->ReportId != ReportId) || (Field->BitOffset != BitOffset) ||
+      (Field->BitSize != BitSize) || (Field->Count != Count) || (Field->UsageMinimum != UsageMinimum) ||
+      (Field->UsageMaximum != UsageMaximum))
+  {
+    UT_LOG_ERROR (
+      "Field type %d id %d offset %d size %d count %d usages %x-%x\n",
+      Field->ReportType,
+      Field->ReportId,
+      Field->BitOffset,
+      Field->BitSize,
+      Field->Count,
+      Field->UsageMinimum,
+      Field->UsageMaximum
+      );
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+ * @brief The boot keyboard descriptor compiles to the boot report format.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+BootKeyboardLayout (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  HID_REPORT_LAYOUT  *Layout;
+
+  Status = HidParseReportDescriptor (mBootKeyboardDescriptor, sizeof (mBootKeyboardDescriptor), &Layout);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  UT_ASSERT_FALSE (Layout->ReportIdsUsed);
+  UT_ASSERT_EQUAL (Layout->FieldCount, 3);
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[0], HidReportInput, 0, 0, 1, 8, HID_USAGE (0x07, 0xE0), HID_USAGE (0x07, 0xE7)));
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[1], HidReportOutput, 0, 0, 1, 5, HID_USAGE (0x08, 0x01), HID_USAGE (0x08, 0x05)));
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[2], HidReportInput, 0, 16, 8, 6, HID_USAGE (0x07, 0x00), HID_USAGE (0x07, 0x65)));
+
+  UT_ASSERT_EQUAL (Layout->Fields[0].Flags, HID_MAIN_ITEM_VARIABLE);
+  UT_ASSERT_EQUAL (Layout->Fields[2].Flags, 0);
+  UT_ASSERT_EQUAL (Layout->Fields[2].LogicalMaximum, 101);
+  UT_ASSERT_EQUAL (Layout->Fields[2].ApplicationUsage, HID_USAGE (0x01, 0x06));
+  UT_ASSERT_EQUAL (Layout->Fields[2].CollectionIndex, 1);
+
+  HidFreeReportLayout (Layout);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Report IDs shift every field by one byte and keep separate offsets.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+NkroKeyboardLayout (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  HID_REPORT_LAYOUT  *Layout;
+
+  Status = HidParseReportDescriptor (mNkroKeyboardDescriptor, sizeof (mNkroKeyboardDescriptor), &Layout);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  UT_ASSERT_TRUE (Layout->ReportIdsUsed);
+  UT_ASSERT_EQUAL (Layout->FieldCount, 3);
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[0], HidReportInput, 1, 8, 1, 8, HID_USAGE (0x07, 0xE0), HID_USAGE (0x07, 0xE7)));
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[1], HidReportInput, 1, 16, 1, 120, HID_USAGE (0x07, 0x00), HID_USAGE (0x07, 0x77)));
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[2], HidReportInput, 2, 8, 16, 1, HID_USAGE (0x0C, 0x00), HID_USAGE (0x0C, 0x3FF)));
+  UT_ASSERT_EQUAL (Layout->Fields[2].ApplicationUsage, HID_USAGE (0x0C, 0x01));
+  UT_ASSERT_EQUAL (Layout->Fields[2].CollectionIndex, 2);
+
+  HidFreeReportLayout (Layout);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Usage lists split into fields, extended usages keep their page,
+ * Push/Pop restore globals and unsigned maximums are recovered.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+PointerLayout (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  HID_REPORT_LAYOUT  *Layout;
+
+  Status = HidParseReportDescriptor (mPointerDescriptor, sizeof (mPointerDescriptor), &Layout);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  UT_ASSERT_EQUAL (Layout->FieldCount, 5);
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[0], HidReportInput, 0, 0, 1, 3, HID_USAGE (0x09, 0x01), HID_USAGE (0x09, 0x03)));
+
+  //
+  // Pop restored the Generic Desktop page and the signed range.
+  //
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[1], HidReportInput, 0, 8, 12, 1, HID_USAGE (0x01, 0x30), HID_USAGE (0x01, 0x30)));
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[2], HidReportInput, 0, 20, 12, 1, HID_USAGE (0x01, 0x31), HID_USAGE (0x01, 0x31)));
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[3], HidReportInput, 0, 32, 12, 2, HID_USAGE (0x0C, 0x238), HID_USAGE (0x0C, 0x238)));
+  UT_ASSERT_EQUAL (Layout->Fields[1].LogicalMinimum, -32767);
+  UT_ASSERT_EQUAL (Layout->Fields[1].LogicalMaximum, 32767);
+  UT_ASSERT_EQUAL (Layout->Fields[1].Flags, HID_MAIN_ITEM_VARIABLE | HID_MAIN_ITEM_RELATIVE);
+  UT_ASSERT_EQUAL (Layout->Fields[1].CollectionUsage, HID_USAGE (0x01, 0x01));
+  UT_ASSERT_EQUAL (Layout->Fields[1].ApplicationUsage, HID_USAGE (0x01, 0x02));
+  UT_ASSERT_EQUAL (Layout->Fields[1].CollectionIndex, 2);
+
+  UT_ASSERT_TRUE (FieldIs (&Layout->Fields[4], HidReportInput, 0, 56, 8, 1, HID_USAGE (0x01, 0x38), HID_USAGE (0x01, 0x38)));
+  UT_ASSERT_EQUAL (Layout->Fields[4].LogicalMinimum, 0);
+  UT_ASSERT_EQUAL (Layout->Fields[4].LogicalMaximum, 255);
+
+  HidFreeReportLayout (Layout);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Values are read across byte boundaries and sign extended only for
+ * signed fields.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+FieldValues (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS         Status;
+  HID_REPORT_LAYOUT  *Layout;
+  UINT8              Report[8];
+  UINT32             Value;
+  HID_REPORT_FIELD   Wide;
+
+  Status = HidParseReportDescriptor (mPointerDescriptor, sizeof (mPointerDescriptor), &Layout);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  //
+  // Buttons 1 and 3, X = -2 (0xFFE), Y = 0x123, pan = 0x7FF and 0x800, wheel 0xC8.
+  //
+  Report[0] = 0x05;
+  Report[1] = 0xFE;
+  Report[2] = 0x3F;
+  Report[3] = 0x12;
+  Report[4] = 0xFF;
+  Report[5] = 0x07;
+  Report[6] = 0x80;
+  Report[7] = 0xC8;
+
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Layout->Fields[0], Report, sizeof (Report), 0, &Value));
+  UT_ASSERT_EQUAL (Value, 1);
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Layout->Fields[0], Report, sizeof (Report), 1, &Value));
+  UT_ASSERT_EQUAL (Value, 0);
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Layout->Fields[0], Report, sizeof (Report), 2, &Value));
+  UT_ASSERT_EQUAL (Value, 1);
+
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Layout->Fields[1], Report, sizeof (Report), 0, &Value));
+  UT_ASSERT_EQUAL (Value, 0xFFE);
+  UT_ASSERT_EQUAL (HidSignExtendFieldValue (&Layout->Fields[1], Value), -2);
+
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Layout->Fields[2], Report, sizeof (Report), 0, &Value));
+  UT_ASSERT_EQUAL (Value, 0x123);
+
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Layout->Fields[3], Report, sizeof (Report), 0, &Value));
+  UT_ASSERT_EQUAL (Value, 0x7FF);
+  UT_ASSERT_EQUAL (HidSignExtendFieldValue (&Layout->Fields[3], Value), 2047);
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Layout->Fields[3], Report, sizeof (Report), 1, &Value));
+  UT_ASSERT_EQUAL (Value, 0x800);
+  UT_ASSERT_EQUAL (HidSignExtendFieldValue (&Layout->Fields[3], Value), -2048);
+
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Layout->Fields[4], Report, sizeof (Report), 0, &Value));
+  UT_ASSERT_EQUAL (Value, 0xC8);
+  UT_ASSERT_EQUAL (HidSignExtendFieldValue (&Layout->Fields[4], Value), 200);
+
+  UT_ASSERT_STATUS_EQUAL (HidGetReportFieldValue (&Layout->Fields[4], Report, 7, 0, &Value), EFI_BUFFER_TOO_SMALL);
+  UT_ASSERT_STATUS_EQUAL (HidGetReportFieldValue (&Layout->Fields[3], Report, sizeof (Report), 2, &Value), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (HidGetReportFieldValue (&Layout->Fields[3], NULL, sizeof (Report), 0, &Value), EFI_INVALID_PARAMETER);
+
+  //
+  // A 32 bit element that straddles five bytes.
+  //
+  ZeroMem (&Wide, sizeof (Wide));
+  Wide.BitOffset      = 4;
+  Wide.BitSize        = 32;
+  Wide.Count          = 1;
+  Wide.LogicalMinimum = MIN_INT32;
+  UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (&Wide, Report, sizeof (Report), 0, &Value));
+  UT_ASSERT_EQUAL (Value, 0xF123FFE0);
+  UT_ASSERT_EQUAL (HidSignExtendFieldValue (&Wide, Value), (INT32)0xF123FFE0);
+
+  HidFreeReportLayout (Layout);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Malformed and oversized descriptors are rejected.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+RejectsBadDescriptors (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  HID_REPORT_LAYOUT  *Layout;
+  UINT8              Buffer[256];
+  UINTN              Index;
+
+  STATIC CONST UINT8  Truncated[]     = { 0x05, 0x01, 0x26, 0xFF };
+  STATIC CONST UINT8  TruncatedLong[] = { 0xFE, 0x08, 0x01, 0x00 };
+  STATIC CONST UINT8  BadPop[]        = { 0x05, 0x01, 0xB4 };
+  STATIC CONST UINT8  BadEnd[]        = { 0x09, 0x06, 0xC0 };
+  STATIC CONST UINT8  ZeroReportId[]  = { 0x85, 0x00 };
+  STATIC CONST UINT8  TooLarge[]      = { 0x75, 0x08, 0x96, 0x00, 0x10, 0x81, 0x02 };
+  STATIC CONST UINT8  TooWide[]       = { 0x75, 0x40, 0x95, 0x01, 0x81, 0x02 };
+  STATIC CONST UINT8  WidePadding[]   = { 0x75, 0x40, 0x95, 0x01, 0x81, 0x01 };
+
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (NULL, 4, &Layout), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (Truncated, sizeof (Truncated), NULL), EFI_INVALID_PARAMETER);
+
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (Truncated, sizeof (Truncated), &Layout), EFI_COMPROMISED_DATA);
+  UT_ASSERT_TRUE (Layout == NULL);
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (TruncatedLong, sizeof (TruncatedLong), &Layout), EFI_COMPROMISED_DATA);
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (BadPop, sizeof (BadPop), &Layout), EFI_COMPROMISED_DATA);
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (BadEnd, sizeof (BadEnd), &Layout), EFI_COMPROMISED_DATA);
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (ZeroReportId, sizeof (ZeroReportId), &Layout), EFI_COMPROMISED_DATA);
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (TooLarge, sizeof (TooLarge), &Layout), EFI_COMPROMISED_DATA);
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (TooWide, sizeof (TooWide), &Layout), EFI_UNSUPPORTED);
+
+  UT_ASSERT_NOT_EFI_ERROR (HidParseReportDescriptor (WidePadding, sizeof (WidePadding), &Layout));
+  UT_ASSERT_EQUAL (Layout->FieldCount, 0);
+  HidFreeReportLayout (Layout);
+
+  //
+  // Seventeen nested collections.
+  //
+  for (Index = 0; Index < 17; Index++) {
+    Buffer[Index * 2]     = 0xA1;
+    Buffer[Index * 2 + 1] = 0x00;
+  }
+
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (Buffer, 17 * 2, &Layout), EFI_UNSUPPORTED);
+  UT_ASSERT_NOT_EFI_ERROR (HidParseReportDescriptor (Buffer, 16 * 2, &Layout));
+  HidFreeReportLayout (Layout);
+
+  //
+  // Sixty five usages before one main item.
+  //
+  for (Index = 0; Index < 65; Index++) {
+    Buffer[Index * 2]     = 0x09;
+    Buffer[Index * 2 + 1] = (UINT8)Index;
+  }
+
+  UT_ASSERT_STATUS_EQUAL (HidParseReportDescriptor (Buffer, 65 * 2, &Layout), EFI_UNSUPPORTED);
+
+  //
+  // An empty descriptor has no fields.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (HidParseReportDescriptor (Buffer, 0, &Layout));
+  UT_ASSERT_EQUAL (Layout->FieldCount, 0);
+  HidFreeReportLayout (Layout);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+ * @brief Mutated and random descriptors either fail or produce fields that
+ * stay inside the largest report.
+ *
+ * @param Context
+ * @return UNIT_TEST_STATUS
+ */
+UNIT_TEST_STATUS
+EFIAPI
+FuzzDescriptors (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST UINT8  *Seeds[]    = { mBootKeyboardDescriptor, mNkroKeyboardDescriptor, mPointerDescriptor };
+  STATIC CONST UINTN  SeedSizes[] = { sizeof (mBootKeyboardDescriptor), sizeof (mNkroKeyboardDescriptor), sizeof (mPointerDescriptor) };
+  UINT8               Descriptor[128];
+  UINT8               *Exact;
+  UINT8               *Report;
+  UINTN               Size;
+  UINTN               Iteration;
+  UINTN               Mutation;
+  UINTN               Index;
+  UINTN               Seed;
+  UINT32              Value;
+  EFI_STATUS          Status;
+  HID_REPORT_LAYOUT   *Layout;
+  HID_REPORT_FIELD    *Field;
+  UINTN               Accepted;
+
+  mRandomState = 0x48494452;
+  Accepted     = 0;
+  Report       = AllocateZeroPool (4096);
+  UT_ASSERT_NOT_NULL (Report);
+
+  for (Iteration = 0; Iteration < FUZZ_ITERATIONS; Iteration++) {
+    if (Iteration % 8 == 7) {
+      Size = (UINTN)(PseudoRandomNext (&mRandomState) % sizeof (Descriptor));
+      for (Index = 0; Index < Size; Index++) {
+        Descriptor[Index] = (UINT8)PseudoRandomNext (&mRandomState);
+      }
+    } else {
+      Seed = (UINTN)(PseudoRandomNext (&mRandomState) % ARRAY_SIZE (Seeds));
+      Size = SeedSizes[Seed];
+      CopyMem (Descriptor, Seeds[Seed], Size);
+      for (Mutation = (UINTN)(PseudoRandomNext (&mRandomState) % 4) + 1; Mutation > 0; Mutation--) {
+        Descriptor[PseudoRandomNext (&mRandomState) % Size] = (UINT8)PseudoRandomNext (&mRandomState);
+      }
+
+      if (PseudoRandomNext (&mRandomState) % 4 == 0) {
+        Size = (UINTN)(PseudoRandomNext (&mRandomState) % Size);
+      }
+    }
+
+    //
+    // Copy to an exactly sized buffer so reads past the end are caught.
+    //
+    Exact = AllocateCopyPool (MAX (Size, 1), Descriptor);
+    UT_ASSERT_NOT_NULL (Exact);
+    Status = HidParseReportDescriptor (Exact, Size, &Layout);
+    FreePool (Exact);
+
+    if (EFI_ERROR (Status)) {
+      UT_ASSERT_TRUE (Status == EFI_COMPROMISED_DATA || Status == EFI_UNSUPPORTED);
+      continue;
+    }
+
+    Accepted++;
+    for (Index = 0; Index < Layout->FieldCount; Index++) {
+      Field = &Layout->Fields[Index];
+      UT_ASSERT_TRUE (Field->BitSize >= 1 && Field->BitSize <= 32);
+      UT_ASSERT_TRUE (Field->Count >= 1);
+      UT_ASSERT_TRUE ((UINT64)Field->BitOffset + (UINT64)Field->Count * Field->BitSize <= 4096 * 8);
+      UT_ASSERT_NOT_EFI_ERROR (HidGetReportFieldValue (Field, Report, 4096, Field->Count - 1, &Value));
+    }
+
+    HidFreeReportLayout (Layout);
+  }
+
+  FreePool (Report);
+  UT_LOG_INFO ("%d of %d mutated descriptors were accepted\n", (UINT32)Accepted, FUZZ_ITERATIONS);
+  UT_ASSERT_TRUE (Accepted > 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for
+  HidReportDescriptorLib and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ParserSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the Parser Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&ParserSuite, Framework, "HidReportDescriptorLib parser", "HidReportDescriptorLib.Parser", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ParserSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ParserSuite, "Boot keyboard descriptor should match the boot report", "BootKeyboard", BootKeyboardLayout, NULL, NULL, NULL);
+  AddTestCase (ParserSuite, "Report IDs should be accounted for in field offsets", "NkroKeyboard", NkroKeyboardLayout, NULL, NULL, NULL);
+  AddTestCase (ParserSuite, "Usage lists, extended usages and Push/Pop should be handled", "Pointer", PointerLayout, NULL, NULL, NULL);
+  AddTestCase (ParserSuite, "Field values should be extracted and sign extended", "FieldValues", FieldValues, NULL, NULL, NULL);
+  AddTestCase (ParserSuite, "Malformed descriptors should be rejected", "BadDescriptors", RejectsBadDescriptors, NULL, NULL, NULL);
+  AddTestCase (ParserSuite, "Mutated descriptors should never produce out of bounds fields", "Fuzz", FuzzDescriptors, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -357,6 +357,10 @@ UsbKbHidDriverBindingStart (
   //
 ErrorExit:
   if (UsbKeyboardDevice != NULL) {
+    if (UsbKeyboardDevice->ReportDescriptor != NULL) {
+      FreePool (UsbKeyboardDevice->ReportDescriptor);
+    }
+
     FreePool (UsbKeyboardDevice);
     UsbKeyboardDevice = NULL;
   }
@@ -466,6 +470,10 @@ UsbKbHidDriverBindingStop (
     FreeUnicodeStringTable (UsbKeyboardDevice->ControllerNameTable);
   }
 
+  if (UsbKeyboardDevice->ReportDescriptor != NULL) {
+    FreePool (UsbKeyboardDevice->ReportDescriptor);
+  }
+
   FreePool (UsbKeyboardDevice);
 
   return Status;
@@ -507,6 +515,19 @@ RegisterKeyboardHidReportCallback (
     return EFI_ALREADY_STARTED;
   }
 
+  //
+  // Hand over the report descriptor before the callback is published, so it
+  // arrives ahead of the first report.
+  //
+  if (HidKeyboard->ReportInterface == ReportKeyboard) {
+    KeyboardReportCallback (
+      ReportKeyboardDescriptor,
+      HidKeyboard->ReportDescriptor,
+      HidKeyboard->ReportDescriptorSize,
+      Context
+      );
+  }
+
   HidKeyboard->KeyReportCallback        = KeyboardReportCallback;
   HidKeyboard->KeyReportCallbackContext = Context;
 
@@ -570,6 +591,9 @@ SetOutputReport (
   EFI_STATUS      Status;
   UINT8           ReportId;
   USB_KB_HID_DEV  *HidKeyboard;
+  UINT8           Report[USB_KB_MAX_LED_REPORT_SIZE];
+  UINTN           Index;
+  UINT32          Bit;
 
   if (Interface != BootKeyboard) {
     DEBUG ((DEBUG_ERROR, "[%a] - Unsupported HID report interface %d\n", __FUNCTION__, Interface));
@@ -582,6 +606,36 @@ SetOutputReport (
 
   HidKeyboard = USB_KB_HID_DEV_FROM_THIS (This);
 
+  if (HidKeyboard->ReportInterface == ReportKeyboard) {
+    if (HidKeyboard->LedReportSize == 0) {
+      return EFI_UNSUPPORTED;
+    }
+
+    //
+    // Move each boot protocol LED bit to where the report descriptor puts it.
+    //
+    ZeroMem (Report, sizeof (Report));
+    if (HidKeyboard->LedReportId != 0) {
+      Report[0] = HidKeyboard->LedReportId;
+    }
+
+    for (Index = 0; Index < USB_KB_LED_COUNT; Index++) {
+      Bit = HidKeyboard->LedBit[Index];
+      if ((Bit != USB_KB_LED_NONE) && ((HidOutputReportBuffer[0] & (1 << Index)) != 0)) {
+        Report[Bit / 8] |= (UINT8)(1 << (Bit % 8));
+      }
+    }
+
+    return UsbSetReportRequest (
+             HidKeyboard->UsbIo,
+             HidKeyboard->InterfaceDescriptor.InterfaceNumber,
+             HidKeyboard->LedReportId,
+             HID_OUTPUT_REPORT,
+             HidKeyboard->LedReportSize,
+             Report
+             );
+  }
+
   ReportId = 1;
 
   //
@@ -708,11 +762,29 @@ InitUsbKeyboard (
     UsbKeyboardDevice->InterfaceDescriptor.InterfaceNumber,
     &Protocol
     );
-  //
-  // Set boot protocol for the USB Keyboard.
-  // This driver only supports boot protocol.
-  //
-  if (Protocol != BOOT_PROTOCOL) {
+
+  UsbKeyboardDevice->ReportInterface = BootKeyboard;
+  if (FeaturePcdGet (PcdUsbKbHidUseReportProtocol)) {
+    Status = InitReportProtocol (UsbKeyboardDevice);
+    if (!EFI_ERROR (Status)) {
+      UsbKeyboardDevice->ReportInterface = ReportKeyboard;
+    } else {
+      DEBUG ((DEBUG_INFO, "[%a] - Using boot protocol: %r\n", __FUNCTION__, Status));
+    }
+  }
+
+  if (UsbKeyboardDevice->ReportInterface == ReportKeyboard) {
+    if (Protocol != REPORT_PROTOCOL) {
+      UsbSetProtocolRequest (
+        UsbKeyboardDevice->UsbIo,
+        UsbKeyboardDevice->InterfaceDescriptor.InterfaceNumber,
+        REPORT_PROTOCOL
+        );
+    }
+  } else if (Protocol != BOOT_PROTOCOL) {
+    //
+    // Set boot protocol for the USB Keyboard.
+    //
     UsbSetProtocolRequest (
       UsbKeyboardDevice->UsbIo,
       UsbKeyboardDevice->InterfaceDescriptor.InterfaceNumber,
@@ -739,6 +811,148 @@ InitUsbKeyboard (
   return EFI_SUCCESS;
 }
 
+/**
+  Switch the keyboard to report protocol when its report descriptor has
+  keyboard input fields, so keyboards with more than six key rollover report
+  every key.
+
+  @param  UsbKeyboardDevice  The USB_KB_HID_DEV instance.
+
+  @retval EFI_SUCCESS        The keyboard runs in report protocol.
+  @retval other              The keyboard should be run in boot protocol.
+
+**/
+EFI_STATUS
+InitReportProtocol (
+  IN OUT USB_KB_HID_DEV  *UsbKeyboardDevice
+  )
+{
+  EFI_STATUS              Status;
+  EFI_USB_HID_DESCRIPTOR  HidDescriptor;
+  UINT8                   *Descriptor;
+  UINT16                  DescriptorSize;
+  HID_REPORT_LAYOUT       *Layout;
+  HID_REPORT_FIELD        *Field;
+  BOOLEAN                 HasKeys;
+  UINTN                   Index;
+  UINTN                   Led;
+  UINT32                  Usage;
+  UINT32                  EndBit;
+
+  if (UsbKeyboardDevice->ReportDescriptor != NULL) {
+    FreePool (UsbKeyboardDevice->ReportDescriptor);
+    UsbKeyboardDevice->ReportDescriptor     = NULL;
+    UsbKeyboardDevice->ReportDescriptorSize = 0;
+  }
+
+  Status = UsbGetHidDescriptor (
+             UsbKeyboardDevice->UsbIo,
+             UsbKeyboardDevice->InterfaceDescriptor.InterfaceNumber,
+             &HidDescriptor
+             );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  DescriptorSize = HidDescriptor.HidClassDesc[0].DescriptorLength;
+  if ((HidDescriptor.HidClassDesc[0].DescriptorType != USB_DESC_TYPE_REPORT) || (DescriptorSize == 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Descriptor = AllocateZeroPool (DescriptorSize);
+  if (Descriptor == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = UsbGetReportDescriptor (
+             UsbKeyboardDevice->UsbIo,
+             UsbKeyboardDevice->InterfaceDescriptor.InterfaceNumber,
+             DescriptorSize,
+             Descriptor
+             );
+  if (EFI_ERROR (Status)) {
+    FreePool (Descriptor);
+    return Status;
+  }
+
+  Status = HidParseReportDescriptor (Descriptor, DescriptorSize, &Layout);
+  if (EFI_ERROR (Status)) {
+    FreePool (Descriptor);
+    return Status;
+  }
+
+  //
+  // Find the keyboard input and the output bit of each LED.
+  //
+  HasKeys                          = FALSE;
+  UsbKeyboardDevice->LedReportId   = 0;
+  UsbKeyboardDevice->LedReportSize = 0;
+  for (Led = 0; Led < USB_KB_LED_COUNT; Led++) {
+    UsbKeyboardDevice->LedBit[Led] = USB_KB_LED_NONE;
+  }
+
+  for (Index = 0; Index < Layout->FieldCount; Index++) {
+    Field = &Layout->Fields[Index];
+    if ((Field->ReportType == HidReportInput) && (HID_USAGE_PAGE (Field->UsageMinimum) == 0x07)) {
+      HasKeys = TRUE;
+      continue;
+    }
+
+    if ((Field->ReportType != HidReportOutput) || ((Field->Flags & HID_MAIN_ITEM_VARIABLE) == 0) ||
+        (Field->BitSize != 1) || (HID_USAGE_PAGE (Field->UsageMinimum) != USB_KB_LED_USAGE_PAGE))
+    {
+      continue;
+    }
+
+    //
+    // All LEDs have to live in one output report.
+    //
+    if ((UsbKeyboardDevice->LedReportSize != 0) && (Field->ReportId != UsbKeyboardDevice->LedReportId)) {
+      continue;
+    }
+
+    for (Led = 0; Led < Field->Count; Led++) {
+      Usage = HID_USAGE_ID (Field->UsageMinimum) + (UINT32)Led;
+      if ((Usage == 0) || (Usage > USB_KB_LED_COUNT) || (Field->UsageMinimum + Led > Field->UsageMaximum)) {
+        continue;
+      }
+
+      EndBit = Field->BitOffset + (UINT32)Led + 1;
+      if ((EndBit + 7) / 8 > USB_KB_MAX_LED_REPORT_SIZE) {
+        continue;
+      }
+
+      UsbKeyboardDevice->LedBit[Usage - 1] = Field->BitOffset + (UINT32)Led;
+      UsbKeyboardDevice->LedReportId       = Field->ReportId;
+      UsbKeyboardDevice->LedReportSize     = (UINT8)MAX (UsbKeyboardDevice->LedReportSize, (EndBit + 7) / 8);
+    }
+  }
+
+  //
+  // The output report ends at its last field, padding included.
+  //
+  for (Index = 0; Index < Layout->FieldCount && UsbKeyboardDevice->LedReportSize != 0; Index++) {
+    Field  = &Layout->Fields[Index];
+    EndBit = Field->BitOffset + (UINT32)Field->Count * Field->BitSize;
+    if ((Field->ReportType == HidReportOutput) && (Field->ReportId == UsbKeyboardDevice->LedReportId) &&
+        ((EndBit + 7) / 8 <= USB_KB_MAX_LED_REPORT_SIZE))
+    {
+      UsbKeyboardDevice->LedReportSize = (UINT8)MAX (UsbKeyboardDevice->LedReportSize, (EndBit + 7) / 8);
+    }
+  }
+
+  HidFreeReportLayout (Layout);
+
+  if (!HasKeys) {
+    FreePool (Descriptor);
+    return EFI_UNSUPPORTED;
+  }
+
+  UsbKeyboardDevice->ReportDescriptor     = Descriptor;
+  UsbKeyboardDevice->ReportDescriptorSize = DescriptorSize;
+  return EFI_SUCCESS;
+}
+
 /**
   Handler function for USB keyboard's asynchronous interrupt transfer.
 
@@ -790,7 +1004,8 @@ KeyboardHandler (
       );
 
     // send a HID packet with no keys pressed so that
-    // the HID layer will cancel repeat.
+    // the HID layer will cancel repeat. An empty boot
+    // report releases every key in report protocol too.
     ZeroMem (EmptyKeyPacket, sizeof (EmptyKeyPacket));
     if (UsbKeyboardDevice->KeyReportCallback != NULL) {
       UsbKeyboardDevice->KeyReportCallback (
@@ -846,7 +1061,7 @@ KeyboardHandler (
   //
   if (UsbKeyboardDevice->KeyReportCallback != NULL) {
     UsbKeyboardDevice->KeyReportCallback (
-                         BootKeyboard,
+                         UsbKeyboardDevice->ReportInterface,
                          (UINT8 *)Data,
                          DataLength,
                          UsbKeyboardDevice->KeyReportCallbackContext
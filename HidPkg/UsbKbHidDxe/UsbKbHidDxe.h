@@ -19,6 +19,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/HidReportDescriptorLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PcdLib.h>
 #include <Library/ReportStatusCodeLib.h>
@@ -39,6 +40,14 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define BOOT_PROTOCOL    0
 #define REPORT_PROTOCOL  1
 
+//
+// LED usages 1 - 5 in KEYBOARD_HID_OUTPUT_BUFFER bit order.
+//
+#define USB_KB_LED_USAGE_PAGE        0x08
+#define USB_KB_LED_COUNT             5
+#define USB_KB_LED_NONE              MAX_UINT32
+#define USB_KB_MAX_LED_REPORT_SIZE   16
+
 #define USB_HID_KB_DEV_SIGNATURE  SIGNATURE_32 ('u', 'k', 'h', 'd')
 
 ///
@@ -56,6 +65,17 @@ typedef struct {
   HID_KEYBOARD_PROTOCOL           HidKeyboard;
   KEYBOARD_HID_REPORT_CALLBACK    KeyReportCallback;
   VOID                            *KeyReportCallbackContext;
+
+  //
+  // Report protocol state. ReportInterface is BootKeyboard when the keyboard
+  // runs in boot protocol and the rest is unused.
+  //
+  KEYBOARD_HID_INTERFACE          ReportInterface;
+  UINT8                           *ReportDescriptor;
+  UINTN                           ReportDescriptorSize;
+  UINT8                           LedReportId;
+  UINT8                           LedReportSize;                // 0 if the keyboard has no LEDs
+  UINT32                          LedBit[USB_KB_LED_COUNT];     // USB_KB_LED_NONE if the LED is missing
 } USB_KB_HID_DEV;
 
 //
@@ -346,6 +366,22 @@ InitUsbKeyboard (
   IN OUT USB_KB_HID_DEV  *UsbKeyboardDevice
   );
 
+/**
+  Switch the keyboard to report protocol when its report descriptor has
+  keyboard input fields, so keyboards with more than six key rollover report
+  every key.
+
+  @param  UsbKeyboardDevice  The USB_KB_HID_DEV instance.
+
+  @retval EFI_SUCCESS        The keyboard runs in report protocol.
+  @retval other              The keyboard should be run in boot protocol.
+
+**/
+EFI_STATUS
+InitReportProtocol (
+  IN OUT USB_KB_HID_DEV  *UsbKeyboardDevice
+  );
+
 /**
   Handler function for USB keyboard's asynchronous interrupt transfer.
 
@@ -501,6 +501,7 @@ RegisterPointerReportCallback (
 
   UsbMouseHidDevice->MouseReportCallback        = PointerReportCallback;
   UsbMouseHidDevice->MouseReportCallbackContext = Context;
+  UsbMouseHidDevice->ReportForwarded            = FALSE;
 
   return EFI_SUCCESS;
 }
@@ -673,6 +674,7 @@ OnMouseInterruptComplete (
   EFI_USB_IO_PROTOCOL  *UsbIo;
   UINT8                EndpointAddr;
   UINT32               UsbResult;
+  UINTN                Index;
 
   UsbMouseHidDevice = (USB_MOUSE_HID_DEV *)Context;
   UsbIo             = UsbMouseHidDevice->UsbIo;
@@ -728,10 +730,29 @@ OnMouseInterruptComplete (
     return EFI_SUCCESS;
   }
 
+  //
+  // Many mice report at every polling interval whether or not anything
+  // happened. A report with the same buttons as the last one and no
+  // displacement carries nothing new, so don't wake the HID layer for it.
+  //
+  if (UsbMouseHidDevice->ReportForwarded && (((UINT8 *)Data)[0] == UsbMouseHidDevice->LastButtons)) {
+    for (Index = 1; Index < DataLength; Index++) {
+      if (((UINT8 *)Data)[Index] != 0) {
+        break;
+      }
+    }
+
+    if (Index == DataLength) {
+      return EFI_SUCCESS;
+    }
+  }
+
   //
   // Send report to the HID layer.
   //
   if (UsbMouseHidDevice->MouseReportCallback != NULL) {
+    UsbMouseHidDevice->ReportForwarded = TRUE;
+    UsbMouseHidDevice->LastButtons     = ((UINT8 *)Data)[0];
     UsbMouseHidDevice->MouseReportCallback (
                          BootMouse,
                          (UINT8 *)Data,
@@ -70,6 +70,8 @@ typedef struct {
   HID_POINTER_PROTOCOL            HidPointerProtocol;
   POINTER_HID_REPORT_CALLBACK     MouseReportCallback;
   VOID                            *MouseReportCallbackContext;
+  BOOLEAN                         ReportForwarded;    // A report has been sent to the callback since it was registered
+  UINT8                           LastButtons;        // Buttons of the last report sent to the callback
 } USB_MOUSE_HID_DEV;
 
 #define USB_MOUSE_HID_DEV_FROM_HID_POINTER_PROTOCOL(a) \
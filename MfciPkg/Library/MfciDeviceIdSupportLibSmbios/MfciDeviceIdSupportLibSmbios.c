@@ -3,6 +3,9 @@
   This library reads SMBIOS values to populate the MFCI Targeting UEFI Variables
   This is _a_ method of populating these variables
 
+  The SMBIOS strings are read once, by the first getter call, into a single
+  snapshot buffer that all of the getters copy from.
+
   Copyright (c) Microsoft Corporation
   SPDX-License-Identifier: BSD-2-Clause-Patent
 **/
@@ -21,33 +24,47 @@
 
 #define ID_NOT_FOUND  "Not Found"
 
+// identifies a targeting value within the snapshot
+typedef enum {
+  MFCI_DEVICE_ID_MANUFACTURER,
+  MFCI_DEVICE_ID_PRODUCT_NAME,
+  MFCI_DEVICE_ID_SERIAL_NUMBER,
+  MFCI_DEVICE_ID_OEM_01,
+  MFCI_DEVICE_ID_OEM_02,
+  MFCI_DEVICE_ID_COUNT
+} MFCI_DEVICE_ID;
+
+// Location of one targeting value within the snapshot buffer, in CHAR16s and bytes
+typedef struct {
+  UINTN    Offset;
+  UINTN    Size;
+} MFCI_ID_SNAPSHOT_ENTRY;
+
 // Note: This protocol will guarantee to be met by the Depex and located at the
 // constructor of this library, thus no null-pointer check in library code flow.
 EFI_SMBIOS_PROTOCOL  *mSmbiosProtocol;
 
+// All targeting values, NULL terminated and packed one after the other
+STATIC CHAR16                  *mIdSnapshot = NULL;
+STATIC MFCI_ID_SNAPSHOT_ENTRY  mIdSnapshotEntries[MFCI_DEVICE_ID_COUNT];
+
 /**
 
-  Acquire the string associated with the Index from smbios structure and return it.
-  The caller is responsible for freeing the string buffer.
+  Locate the string associated with the Index in the smbios structure, without copying it.
 
   @param    OptionalStrStart  The start position to search the string
-  @param    Index             The index of the string to extract
-  @param    String            The string that is extracted or ID_NOT_FOUND
-  @param    Size              Optional pointer to hold size of returned string (bytes including the terminating CHAR16 NULL)
+  @param    Index             The index of the string to locate
 
-  @retval   EFI_STATUS
+  @retval   The string, or ID_NOT_FOUND if the string is missing or empty
 
 **/
-EFI_STATUS
+CONST CHAR8 *
 GetOptionalStringByIndex (
-  IN      CHAR8   *OptionalStrStart,
-  IN      UINT8   Index,
-  OUT     CHAR16  **String,
-  OUT     UINTN   *Size   OPTIONAL
+  IN      CONST CHAR8  *OptionalStrStart,
+  IN      UINT8        Index
   )
 {
   UINTN  StrSize;
-  CHAR8  *WhichStr;
 
   StrSize = 0;
   if (Index != 0) {
@@ -63,22 +80,119 @@ GetOptionalStringByIndex (
     // Meet the end of strings set but Index is non-zero, or
     // found an empty string, or Index passed in was 0
     //
-    DEBUG ((DEBUG_ERROR, "SMBIOS string not found, returning \"%s\"\n", ID_NOT_FOUND));
-    StrSize  = sizeof (ID_NOT_FOUND);
-    WhichStr = ID_NOT_FOUND;
-  } else {
-    WhichStr = OptionalStrStart;
+    DEBUG ((DEBUG_ERROR, "SMBIOS string not found, returning \"%a\"\n", ID_NOT_FOUND));
+    return ID_NOT_FOUND;
   }
 
-  *String = AllocatePool (StrSize * sizeof (CHAR16));  // 0 page will catch AllocatePool failures
-  if (*String == NULL) {
+  return OptionalStrStart;
+}
+
+/**
+
+  Walk the SMBIOS type 1 record once and convert every targeting value into a
+  newly allocated snapshot.
+
+  @retval   EFI_SUCCESS           The snapshot was built
+  @retval   EFI_OUT_OF_RESOURCES  The snapshot buffer could not be allocated
+  @retval   Others                The SMBIOS type 1 record could not be found
+
+**/
+STATIC
+EFI_STATUS
+BuildIdSnapshot (
+  VOID
+  )
+{
+  EFI_STATUS               Status;
+  EFI_SMBIOS_HANDLE        SmbiosHandle;
+  EFI_SMBIOS_TABLE_HEADER  *Record;
+  SMBIOS_TYPE              Type;
+  SMBIOS_TABLE_TYPE1       *Type1Record;
+  CONST CHAR8              *StrStart;
+  CONST CHAR8              *AsciiIds[MFCI_DEVICE_ID_COUNT];
+  MFCI_ID_SNAPSHOT_ENTRY   Entries[MFCI_DEVICE_ID_COUNT];
+  CHAR16                   *Snapshot;
+  UINTN                    Length;
+  UINTN                    Index;
+
+  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;      // Reset handle
+  Type         = SMBIOS_TYPE_SYSTEM_INFORMATION; // Smbios type1
+  Status       = mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - SMBIOS type 1 record not found. %r\n", __FUNCTION__, Status));
+    return Status;
+  }
+
+  Type1Record = (SMBIOS_TABLE_TYPE1 *)Record;
+  StrStart    = (CONST CHAR8 *)((UINT8 *)Type1Record + Type1Record->Hdr.Length);
+
+  AsciiIds[MFCI_DEVICE_ID_MANUFACTURER]  = GetOptionalStringByIndex (StrStart, Type1Record->Manufacturer);
+  AsciiIds[MFCI_DEVICE_ID_PRODUCT_NAME]  = GetOptionalStringByIndex (StrStart, Type1Record->ProductName);
+  AsciiIds[MFCI_DEVICE_ID_SERIAL_NUMBER] = GetOptionalStringByIndex (StrStart, Type1Record->SerialNumber);
+  // OEM1 and OEM2 are empty strings in this SMBIOS example
+  AsciiIds[MFCI_DEVICE_ID_OEM_01] = "";
+  AsciiIds[MFCI_DEVICE_ID_OEM_02] = "";
+
+  Length = 0;
+  for (Index = 0; Index < MFCI_DEVICE_ID_COUNT; Index++) {
+    Entries[Index].Offset = Length;
+    Entries[Index].Size   = AsciiStrSize (AsciiIds[Index]) * sizeof (CHAR16);
+    Length               += AsciiStrSize (AsciiIds[Index]);
+  }
+
+  Snapshot = AllocatePool (Length * sizeof (CHAR16));
+  if (Snapshot == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  AsciiStrToUnicodeStrS (WhichStr, *String, StrSize);
+  for (Index = 0; Index < MFCI_DEVICE_ID_COUNT; Index++) {
+    AsciiStrToUnicodeStrS (AsciiIds[Index], Snapshot + Entries[Index].Offset, Entries[Index].Size / sizeof (CHAR16));
+  }
+
+  mIdSnapshot = Snapshot;
+  CopyMem (mIdSnapshotEntries, Entries, sizeof (mIdSnapshotEntries));
+  return EFI_SUCCESS;
+}
+
+/**
+ * Copy a targeting value out of the snapshot, taking the snapshot first if needed
+ *
+ * @param Id
+ * @param String
+ * @param StringSize
+ *
+ * It is the callers responsibility to free the buffer returned.
+ *
+ * @return EFI_STATUS
+ */
+STATIC
+EFI_STATUS
+GetIdCopy (
+  IN  MFCI_DEVICE_ID  Id,
+  OUT CHAR16          **String,
+  OUT UINTN           *StringSize  OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
 
-  if (Size != NULL) {
-    *Size = StrSize * sizeof (CHAR16);
+  if (String == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mIdSnapshot == NULL) {
+    Status = BuildIdSnapshot ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  *String = AllocateCopyPool (mIdSnapshotEntries[Id].Size, mIdSnapshot + mIdSnapshotEntries[Id].Offset);
+  if (*String == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (StringSize != NULL) {
+    *StringSize = mIdSnapshotEntries[Id].Size;
   }
 
   return EFI_SUCCESS;
@@ -101,26 +215,7 @@ MfciIdSupportGetManufacturer (
   UINTN   *ManufacturerSize   OPTIONAL
   )
 {
-  EFI_STATUS               Status;
-  EFI_SMBIOS_HANDLE        SmbiosHandle;
-  EFI_SMBIOS_TABLE_HEADER  *Record;
-  SMBIOS_TYPE              Type;
-  SMBIOS_TABLE_TYPE1       *Type1Record;
-
-  if (Manufacturer == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;      // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_INFORMATION; // Smbios type1
-  Status       = mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
-
-  Type1Record = (SMBIOS_TABLE_TYPE1 *)Record;
-  Status      = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type1Record + Type1Record->Hdr.Length), Type1Record->Manufacturer, Manufacturer, ManufacturerSize);
-  return Status;
+  return GetIdCopy (MFCI_DEVICE_ID_MANUFACTURER, Manufacturer, ManufacturerSize);
 }
 
 /**
@@ -140,26 +235,7 @@ MfciIdSupportGetProductName (
   UINTN   *ProductNameSize  OPTIONAL
   )
 {
-  EFI_STATUS               Status;
-  EFI_SMBIOS_HANDLE        SmbiosHandle;
-  EFI_SMBIOS_TABLE_HEADER  *Record;
-  SMBIOS_TYPE              Type;
-  SMBIOS_TABLE_TYPE1       *Type1Record;
-
-  if (ProductName == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;      // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_INFORMATION; // Smbios type1
-  Status       = mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
-
-  Type1Record = (SMBIOS_TABLE_TYPE1 *)Record;
-  Status      = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type1Record + Type1Record->Hdr.Length), Type1Record->ProductName, ProductName, ProductNameSize);
-  return Status;
+  return GetIdCopy (MFCI_DEVICE_ID_PRODUCT_NAME, ProductName, ProductNameSize);
 }
 
 /**
@@ -179,45 +255,7 @@ MfciIdSupportGetSerialNumber (
   UINTN   *SerialNumberSize  OPTIONAL
   )
 {
-  EFI_STATUS               Status;
-  EFI_SMBIOS_HANDLE        SmbiosHandle;
-  EFI_SMBIOS_TABLE_HEADER  *Record;
-  SMBIOS_TYPE              Type;
-  SMBIOS_TABLE_TYPE1       *Type1Record;
-
-  SmbiosHandle = SMBIOS_HANDLE_PI_RESERVED;      // Reset handle
-  Type         = SMBIOS_TYPE_SYSTEM_INFORMATION; // Smbios type1
-  Status       = mSmbiosProtocol->GetNext (mSmbiosProtocol, &SmbiosHandle, &Type, &Record, NULL);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
-
-  Type1Record = (SMBIOS_TABLE_TYPE1 *)Record;
-  Status      = GetOptionalStringByIndex ((CHAR8 *)((UINT8 *)Type1Record + Type1Record->Hdr.Length), Type1Record->SerialNumber, SerialNumber, SerialNumberSize);
-  return Status;
-}
-
-EFI_STATUS
-ReturnEmptyChar16 (
-  CHAR16  **String,
-  UINTN   *StringSize  OPTIONAL
-  )
-{
-  CHAR16  *EmptyString;
-
-  EmptyString = L"";
-  *String     = AllocatePool (sizeof (*EmptyString));
-  if (*String == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  CopyMem (*String, EmptyString, sizeof (*EmptyString));
-
-  if (StringSize != NULL) {
-    *StringSize = sizeof (*EmptyString);
-  }
-
-  return EFI_SUCCESS;
+  return GetIdCopy (MFCI_DEVICE_ID_SERIAL_NUMBER, SerialNumber, SerialNumberSize);
 }
 
 /**
@@ -237,7 +275,7 @@ MfciIdSupportGetOem1 (
   UINTN   *Oem1Size  OPTIONAL
   )
 {
-  return ReturnEmptyChar16 (Oem1, Oem1Size);
+  return GetIdCopy (MFCI_DEVICE_ID_OEM_01, Oem1, Oem1Size);
 }
 
 /**
@@ -257,7 +295,7 @@ MfciIdSupportGetOem2 (
   UINTN   *Oem2Size  OPTIONAL
   )
 {
-  return ReturnEmptyChar16 (Oem2, Oem2Size);
+  return GetIdCopy (MFCI_DEVICE_ID_OEM_02, Oem2, Oem2Size);
 }
 
 /**
@@ -280,6 +318,7 @@ MfciIdSupportConstructor (
   Status = gBS->LocateProtocol (&gEfiSmbiosProtocolGuid, NULL, (VOID **)&mSmbiosProtocol);
   if (EFI_ERROR (Status)) {
     DEBUG ((EFI_D_ERROR, "Could not locate SMBIOS protocol.  %r\n", Status));
+    return Status;
   }
 
   return Status;
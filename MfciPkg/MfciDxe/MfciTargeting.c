@@ -53,25 +53,24 @@ GetOemField (
 STATIC
 EFI_STATUS
 VerifyStringFieldHelper (
-  VOID               *PolicyBlob,
-  UINTN              PolicyBlobSize,
-  MFCI_POLICY_FIELD  TargetField
+  MFCI_PARSED_POLICY  *ParsedPolicy,
+  MFCI_POLICY_FIELD   TargetField
   )
 {
   EFI_STATUS  Status;
 
-  CHAR16  *MfciPolData = NULL;
+  CHAR16  MfciPolData[MFCI_POLICY_FIELD_MAX_LEN];
+  UINTN   MfciPolDataSize = sizeof (MfciPolData);
   CHAR16  ThisMfciPolData[MFCI_POLICY_FIELD_MAX_LEN];
   UINTN   DataSize = MFCI_POLICY_FIELD_MAX_LEN * sizeof (CHAR16);
 
-  if ((PolicyBlob == NULL) ||
-      (PolicyBlobSize == 0) ||
+  if ((ParsedPolicy == NULL) ||
       (TargetField >= MFCI_POLICY_FIELD_COUNT))
   {
     return EFI_INVALID_PARAMETER;
   }
 
-  Status = ExtractChar16 (PolicyBlob, PolicyBlobSize, gPolicyBlobFieldName[TargetField], &MfciPolData);
+  Status = ExtractChar16FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[TargetField], MfciPolData, &MfciPolDataSize);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a - Extracting String Field '%s' from Blob failed - %r.\n", __FUNCTION__, gPolicyBlobFieldName[TargetField], Status));
     goto Done;
@@ -114,11 +113,6 @@ VerifyStringFieldHelper (
   DEBUG ((DEBUG_VERBOSE, "%a - Successful match\n", __FUNCTION__));
 
 Done:
-  if (MfciPolData != NULL) {
-    FreePool (MfciPolData);
-    MfciPolData = NULL;
-  }
-
   return Status;
 }
 
@@ -131,8 +125,9 @@ VerifyTargeting (
   MFCI_POLICY_TYPE  *ExtractedPolicy
   )
 {
-  EFI_STATUS  Status;
-  UINT64      BlobNonce;
+  EFI_STATUS          Status;
+  UINT64              BlobNonce;
+  MFCI_PARSED_POLICY  *ParsedPolicy = NULL;
 
   DEBUG ((DEBUG_INFO, "MfciDxe: %a() - Enter\n", __FUNCTION__));
 
@@ -143,21 +138,26 @@ VerifyTargeting (
     goto Done;
   }
 
-  Status = EFI_SUCCESS;
+  // Extract and sanity check the policy once, every field below is a hashed lookup
+  Status = ParsePolicy (PolicyBlob, PolicyBlobSize, &ParsedPolicy);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to parse the policy blob with return status %r\n", __FUNCTION__, Status));
+    goto Done;
+  }
 
   // Steps 1 - 5: Verify Manufacturer, product name, serial number, OEM_01, & OEM_02
   for (UINTN fieldIndex = MFCI_POLICY_TARGET_MANUFACTURER;
        fieldIndex < MFCI_POLICY_TARGET_NONCE;
        fieldIndex++)
   {
-    Status = VerifyStringFieldHelper (PolicyBlob, PolicyBlobSize, fieldIndex);
+    Status = VerifyStringFieldHelper (ParsedPolicy, fieldIndex);
     if (EFI_ERROR (Status)) {
       goto Done;
     }                                      // helper function above takes care of debug logging
   }
 
   // Step 6: Verify nonce
-  Status = ExtractUint64 (PolicyBlob, PolicyBlobSize, gPolicyBlobFieldName[MFCI_POLICY_TARGET_NONCE], &BlobNonce);
+  Status = ExtractUint64FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[MFCI_POLICY_TARGET_NONCE], &BlobNonce);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a - Failed to extract nonce from policy blob with return status %r\n", __FUNCTION__, Status));
     goto Done;
@@ -170,12 +170,16 @@ VerifyTargeting (
   }
 
   // Step 7: Extract policy
-  Status = ExtractUint64 (PolicyBlob, PolicyBlobSize, gPolicyBlobFieldName[MFCI_POLICY_FIELD_UEFI_POLICY], ExtractedPolicy);
+  Status = ExtractUint64FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[MFCI_POLICY_FIELD_UEFI_POLICY], ExtractedPolicy);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a - Failed to extract the MFCI Policy from the binary blob with return status %r\n", __FUNCTION__, Status));
     goto Done;
   }
 
 Done:
+  if (ParsedPolicy != NULL) {
+    FreeParsedPolicy (ParsedPolicy);
+  }
+
   return Status;
 }
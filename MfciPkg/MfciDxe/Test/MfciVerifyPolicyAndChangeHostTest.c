@@ -58,6 +58,9 @@
 #define MFCI_TEST_TARGET_BIT     BIT16
 #define MFCI_TEST_POLICY_TARGET  (STD_ACTION_SECURE_BOOT_CLEAR | STD_ACTION_TPM_CLEAR | MFCI_TEST_TARGET_BIT)
 
+// ValidateSignature, SanityCheckSignedPolicy and the single ParsePolicy in VerifyTargeting
+#define MFCI_TEST_ATTACHED_CONTENT_CALLS  3
+
 /**
 A mocked version of GetVariable.
 
@@ -391,10 +394,10 @@ UnitTestVerifyAndChangeNormal (
   expect_value (VerifyEKUsInPkcs7Signature, SignatureSize, mCurrentMfciVerify->CurrentPolicy.PolicySize);
   will_return (VerifyEKUsInPkcs7Signature, TRUE);
 
-  expect_memory_count (Pkcs7GetAttachedContent, P7Data, mCurrentMfciVerify->CurrentPolicy.Policy, mCurrentMfciVerify->CurrentPolicy.PolicySize, MFCI_POLICY_FIELD_COUNT + 2);
-  expect_value_count (Pkcs7GetAttachedContent, P7Length, mCurrentMfciVerify->CurrentPolicy.PolicySize, MFCI_POLICY_FIELD_COUNT + 2);
+  expect_memory_count (Pkcs7GetAttachedContent, P7Data, mCurrentMfciVerify->CurrentPolicy.Policy, mCurrentMfciVerify->CurrentPolicy.PolicySize, MFCI_TEST_ATTACHED_CONTENT_CALLS);
+  expect_value_count (Pkcs7GetAttachedContent, P7Length, mCurrentMfciVerify->CurrentPolicy.PolicySize, MFCI_TEST_ATTACHED_CONTENT_CALLS);
 
-  for (Index = 0; Index < MFCI_POLICY_FIELD_COUNT + 2; Index++) {
+  for (Index = 0; Index < MFCI_TEST_ATTACHED_CONTENT_CALLS; Index++) {
     will_return (Pkcs7GetAttachedContent, mCurrentMfciVerify->CurrentPolicy.PolicyContent);
     will_return (Pkcs7GetAttachedContent, mCurrentMfciVerify->CurrentPolicy.PolicyContentSize);
   }
@@ -417,10 +420,10 @@ UnitTestVerifyAndChangeNormal (
   expect_value (VerifyEKUsInPkcs7Signature, SignatureSize, mCurrentMfciVerify->NextPolicy.PolicySize);
   will_return (VerifyEKUsInPkcs7Signature, TRUE);
 
-  expect_memory_count (Pkcs7GetAttachedContent, P7Data, mCurrentMfciVerify->NextPolicy.Policy, mCurrentMfciVerify->NextPolicy.PolicySize, MFCI_POLICY_FIELD_COUNT + 2);
-  expect_value_count (Pkcs7GetAttachedContent, P7Length, mCurrentMfciVerify->NextPolicy.PolicySize, MFCI_POLICY_FIELD_COUNT + 2);
+  expect_memory_count (Pkcs7GetAttachedContent, P7Data, mCurrentMfciVerify->NextPolicy.Policy, mCurrentMfciVerify->NextPolicy.PolicySize, MFCI_TEST_ATTACHED_CONTENT_CALLS);
+  expect_value_count (Pkcs7GetAttachedContent, P7Length, mCurrentMfciVerify->NextPolicy.PolicySize, MFCI_TEST_ATTACHED_CONTENT_CALLS);
 
-  for (Index = 0; Index < MFCI_POLICY_FIELD_COUNT + 2; Index++) {
+  for (Index = 0; Index < MFCI_TEST_ATTACHED_CONTENT_CALLS; Index++) {
     will_return (Pkcs7GetAttachedContent, mCurrentMfciVerify->NextPolicy.PolicyContent);
     will_return (Pkcs7GetAttachedContent, mCurrentMfciVerify->NextPolicy.PolicyContentSize);
   }
@@ -480,10 +483,10 @@ UnitTestVerifyAndChangeEmptyCurrent (
   expect_value (VerifyEKUsInPkcs7Signature, SignatureSize, mCurrentMfciVerify->NextPolicy.PolicySize);
   will_return (VerifyEKUsInPkcs7Signature, TRUE);
 
-  expect_memory_count (Pkcs7GetAttachedContent, P7Data, mCurrentMfciVerify->NextPolicy.Policy, mCurrentMfciVerify->NextPolicy.PolicySize, MFCI_POLICY_FIELD_COUNT + 2);
-  expect_value_count (Pkcs7GetAttachedContent, P7Length, mCurrentMfciVerify->NextPolicy.PolicySize, MFCI_POLICY_FIELD_COUNT + 2);
+  expect_memory_count (Pkcs7GetAttachedContent, P7Data, mCurrentMfciVerify->NextPolicy.Policy, mCurrentMfciVerify->NextPolicy.PolicySize, MFCI_TEST_ATTACHED_CONTENT_CALLS);
+  expect_value_count (Pkcs7GetAttachedContent, P7Length, mCurrentMfciVerify->NextPolicy.PolicySize, MFCI_TEST_ATTACHED_CONTENT_CALLS);
 
-  for (Index = 0; Index < MFCI_POLICY_FIELD_COUNT + 2; Index++) {
+  for (Index = 0; Index < MFCI_TEST_ATTACHED_CONTENT_CALLS; Index++) {
     will_return (Pkcs7GetAttachedContent, mCurrentMfciVerify->NextPolicy.PolicyContent);
     will_return (Pkcs7GetAttachedContent, mCurrentMfciVerify->NextPolicy.PolicyContentSize);
   }
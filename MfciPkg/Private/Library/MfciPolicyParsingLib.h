@@ -8,6 +8,12 @@
 #ifndef __MFCI_POLICY_PARSING_LIB_H__
 #define __MFCI_POLICY_PARSING_LIB_H__
 
+/*
+  Opaque handle to a policy payload that has been extracted from its signed blob and sanity checked.
+  Created by ParsePolicy() and released with FreeParsedPolicy().
+*/
+typedef struct _MFCI_PARSED_POLICY MFCI_PARSED_POLICY;
+
 EFI_STATUS
 EFIAPI
 ValidateBlob (
@@ -40,4 +46,44 @@ ExtractUint64 (
   OUT         UINT64  *MfciPolicyU64Value
   );
 
+/*
+  Extracts and sanity checks the policy payload of SignedPolicy once, indexing every rule so that the
+  ExtractXxxFromParsedPolicy() functions do not search or re-extract the blob.  The signature is NOT verified,
+  callers are expected to have called ValidateBlob() first.  ParsedPolicy must be freed with FreeParsedPolicy().
+*/
+EFI_STATUS
+EFIAPI
+ParsePolicy (
+  IN  CONST VOID          *SignedPolicy,
+  UINTN                   SignedPolicySize,
+  OUT MFCI_PARSED_POLICY  **ParsedPolicy
+  );
+
+/*
+  Copies the string value of MfciPolicyName into the caller provided MfciPolicyStringValue buffer and CHAR16 NULL
+  terminates it.  On EFI_BUFFER_TOO_SMALL, MfciPolicyStringValueSize is updated with the size required in bytes.
+*/
+EFI_STATUS
+EFIAPI
+ExtractChar16FromParsedPolicy (
+  IN      MFCI_PARSED_POLICY  *ParsedPolicy,
+  IN      CONST CHAR16        *MfciPolicyName,
+  OUT     CHAR16              *MfciPolicyStringValue,
+  IN OUT  UINTN               *MfciPolicyStringValueSize
+  );
+
+EFI_STATUS
+EFIAPI
+ExtractUint64FromParsedPolicy (
+  IN   MFCI_PARSED_POLICY  *ParsedPolicy,
+  IN   CONST CHAR16        *MfciPolicyName,
+  OUT  UINT64              *MfciPolicyU64Value
+  );
+
+VOID
+EFIAPI
+FreeParsedPolicy (
+  IN  MFCI_PARSED_POLICY  *ParsedPolicy
+  );
+
 #endif //__MFCI_POLICY_PARSING_LIB_H__
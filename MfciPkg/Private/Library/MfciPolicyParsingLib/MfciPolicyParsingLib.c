@@ -310,103 +310,385 @@ CalculateSizeOfValueTableEntry (
   return Size;
 }
 
-VOID
-SplitPolicyName (
-  IN OUT CHAR16  *PolicyNameToSplit,   // modified
-  OUT    CHAR16  **SubKeyName,
-  OUT    CHAR16  **ValueName
+//
+// 32 bit FNV-1a, hashed a byte at a time over the CHAR16 names
+//
+#define POLICY_HASH_OFFSET_BASIS  0x811C9DC5
+#define POLICY_HASH_PRIME         0x01000193
+
+STATIC
+UINT32
+PolicyHashString (
+  IN UINT32        Hash,
+  IN CONST CHAR16  *String,
+  IN UINTN         Length
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Length; Index++) {
+    Hash = (Hash ^ (String[Index] & 0xFF)) * POLICY_HASH_PRIME;
+    Hash = (Hash ^ (String[Index] >> 8)) * POLICY_HASH_PRIME;
+  }
+
+  return Hash;
+}
+
+/**
+  Hashes a rule name as if SubKeyName and ValueName were joined by POLICY_NAME_SEPARATOR.
+
+  @param[in]  SubKeyName        SubKey part of the name, not necessarily NULL terminated
+  @param[in]  SubKeyLength      Length of SubKeyName in CHAR16s
+  @param[in]  ValueName         Value part of the name, not necessarily NULL terminated
+  @param[in]  ValueNameLength   Length of ValueName in CHAR16s
+
+  @retval     The hash of the rule name
+**/
+STATIC
+UINT32
+PolicyHashRuleName (
+  IN CONST CHAR16  *SubKeyName,
+  IN UINTN         SubKeyLength,
+  IN CONST CHAR16  *ValueName,
+  IN UINTN         ValueNameLength
   )
 {
-  CHAR16        *BeforeSep;
-  CHAR16        *AfterSep;
   CONST CHAR16  Separator = POLICY_NAME_SEPARATOR;
-  CONST CHAR16  W_NULL    = L'\0';
+  UINT32        Hash;
 
-  ASSERT (PolicyNameToSplit != NULL  &&  SubKeyName != NULL  && ValueName != NULL);
+  Hash = PolicyHashString (POLICY_HASH_OFFSET_BASIS, SubKeyName, SubKeyLength);
+  Hash = PolicyHashString (Hash, &Separator, 1);
+  return PolicyHashString (Hash, ValueName, ValueNameLength);
+}
+
+/**
+  Compares the name of a rule in the parsed policy against a SubKeyName and ValueName pair.
 
-  // below adapted from SplitStr()
-  BeforeSep = AfterSep = PolicyNameToSplit;
+  @retval TRUE    Both parts of the name match exactly
+  @retval FALSE   Otherwise
+**/
+STATIC
+BOOLEAN
+PolicyRuleNameMatches (
+  IN CONST MFCI_PARSED_POLICY  *ParsedPolicy,
+  IN UINT16                    RuleIndex,
+  IN CONST CHAR16              *SubKeyName,
+  IN UINTN                     SubKeyLength,
+  IN CONST CHAR16              *ValueName,
+  IN UINTN                     ValueNameLength
+  )
+{
+  CONST RULE           *Rule;
+  CONST POLICY_STRING  *PolicyString;
+
+  Rule = &ParsedPolicy->Rules[RuleIndex];
+
+  PolicyString = (CONST POLICY_STRING *)(ParsedPolicy->ValueTable + Rule->OffsetToSubKeyName);
+  if ((PolicyString->StringLength != SubKeyLength * sizeof (CHAR16)) ||
+      (CompareMem (PolicyString->String, SubKeyName, PolicyString->StringLength) != 0))
+  {
+    return FALSE;
+  }
 
-  while (*AfterSep != W_NULL) {
-    if (*AfterSep == Separator) {
+  PolicyString = (CONST POLICY_STRING *)(ParsedPolicy->ValueTable + Rule->OffsetToValueName);
+  if ((PolicyString->StringLength != ValueNameLength * sizeof (CHAR16)) ||
+      (CompareMem (PolicyString->String, ValueName, PolicyString->StringLength) != 0))
+  {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Looks up the value of MfciPolicyName in the hash index of a parsed policy.
+
+  @param[in]  ParsedPolicy      A policy returned by ParsePolicy()
+  @param[in]  MfciPolicyName    "SubKeyName\ValueName" of the rule to find
+
+  @retval     Pointer to the value within the parsed policy, NULL if not found
+**/
+STATIC
+POLICY_VALUE_HEADER *
+FindParsedPolicyValue (
+  IN  MFCI_PARSED_POLICY  *ParsedPolicy,
+  IN  CONST CHAR16        *MfciPolicyName
+  )
+{
+  CONST CHAR16             *ValueName;
+  UINTN                    SubKeyLength;
+  UINTN                    ValueNameLength;
+  UINT32                   Hash;
+  UINT32                   Bucket;
+  MFCI_POLICY_HASH_BUCKET  *Entry;
+
+  DEBUG ((DEBUG_VERBOSE, "Searching for: '%s'\n", MfciPolicyName));
+
+  // Split on the first separator in place, the name is not copied
+  for (SubKeyLength = 0; MfciPolicyName[SubKeyLength] != L'\0'; SubKeyLength++) {
+    if (MfciPolicyName[SubKeyLength] == POLICY_NAME_SEPARATOR) {
       break;
     }
+  }
 
-    AfterSep++;
+  if (MfciPolicyName[SubKeyLength] != POLICY_NAME_SEPARATOR) {
+    DEBUG ((DEBUG_ERROR, "No separator in '%s'\n", MfciPolicyName));
+    return NULL;
   }
 
-  if (*AfterSep == Separator) {
-    //
-    // Find a sub-string, terminate it
-    //
-    *AfterSep = W_NULL;
-    AfterSep++;
+  ValueName       = &MfciPolicyName[SubKeyLength + 1];
+  ValueNameLength = StrLen (ValueName);
+  Hash            = PolicyHashRuleName (MfciPolicyName, SubKeyLength, ValueName, ValueNameLength);
+
+  // The table is never more than half full, so the probe always reaches an empty bucket
+  for (Bucket = Hash & ParsedPolicy->BucketMask; ; Bucket = (Bucket + 1) & ParsedPolicy->BucketMask) {
+    ParsedPolicy->Probes++;
+    Entry = &ParsedPolicy->Buckets[Bucket];
+    if (Entry->RuleIndex == MFCI_PARSED_POLICY_EMPTY_BUCKET) {
+      break;
+    }
+
+    if ((Entry->Hash == Hash) &&
+        PolicyRuleNameMatches (ParsedPolicy, Entry->RuleIndex, MfciPolicyName, SubKeyLength, ValueName, ValueNameLength))
+    {
+      return (POLICY_VALUE_HEADER *)(ParsedPolicy->ValueTable + ParsedPolicy->Rules[Entry->RuleIndex].OffsetToValue);
+    }
   }
 
-  *SubKeyName = BeforeSep;
-  *ValueName  = AfterSep; // NULL when not found
+  DEBUG ((DEBUG_ERROR, "Not Found\n"));
+  return NULL;
 }
 
 EFI_STATUS
 EFIAPI
-FindRule (
-  IN  CONST  MfciPolicyBlob       *Policy,
-  IN  CONST  CHAR16               *MfciPolicyName,
-  OUT        POLICY_VALUE_HEADER  **Value
+ParsePolicy (
+  IN  CONST VOID          *SignedPolicy,
+  UINTN                   SignedPolicySize,
+  OUT MFCI_PARSED_POLICY  **ParsedPolicy
   )
 {
-  UINT16  RulesCount       = Policy->RulesCount;
-  UINTN   RulesSize        = RulesCount * sizeof (RULE);
-  UINTN   ValueTableOffset = sizeof (MfciPolicyBlob) + RulesSize;
-  CHAR16  LocalString[POLICY_STRING_MAX_LENGTH];
-  CHAR16  *SubKeyExpected;
-  CHAR16  *ValueNameExpected;
+  EFI_STATUS          Status;
+  MfciPolicyBlob      *Policy     = NULL;
+  UINTN               PolicySize  = 0;
+  MFCI_PARSED_POLICY  *Parsed     = NULL;
+  UINT32              BucketCount = MFCI_PARSED_POLICY_MIN_BUCKETS;
+  UINT32              Bucket;
+  UINT32              Hash;
+  RULE                *Rule;
+  POLICY_STRING       *SubKeyName;
+  POLICY_STRING       *ValueName;
+
+  DEBUG ((DEBUG_INFO, "%a()\n", __FUNCTION__));
 
-  if ((Policy == NULL) || (MfciPolicyName == NULL) || (Value == NULL)) {
-    DEBUG ((DEBUG_ERROR, "Policy is NULL, Name is NULL, or Value is NULL\n"));
+  if ((SignedPolicy == NULL) || (SignedPolicySize == 0) || (ParsedPolicy == NULL)) {
+    DEBUG ((DEBUG_ERROR, "SignedPolicy NULL or SignedPolicySize 0, or ParsedPolicy NULL\n"));
     return EFI_INVALID_PARAMETER;
   }
 
-  DEBUG ((DEBUG_VERBOSE, "Searching for: '%s'\n", MfciPolicyName));
+  if (TRUE != Pkcs7GetAttachedContent (SignedPolicy, SignedPolicySize, (VOID **)&Policy, &PolicySize)) {
+    DEBUG ((DEBUG_ERROR, "Pkcs7GetAttachedContent() returns FALSE\n"));
+    Status = EFI_COMPROMISED_DATA;
+    goto _Exit;
+  }
 
-  StrCpyS (LocalString, sizeof (LocalString), MfciPolicyName);
-  SplitPolicyName (LocalString, &SubKeyExpected, &ValueNameExpected);
-  DEBUG ((DEBUG_VERBOSE, "Split SubKeyName '%s' & ValueName '%s'\n", SubKeyExpected, ValueNameExpected));
+  // Every offset and size used by the lookups below is validated here, once
+  Status = SanityCheckPolicy (Policy, PolicySize);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "SanityCheckPolicy() returned EFI_ERROR: %r\n", Status));
+    goto _Exit;
+  }
 
-  RULE   *Rules      = (RULE *)((CHAR8 *)Policy + sizeof (MfciPolicyBlob));
-  CHAR8  *ValueTable = (CHAR8 *)Policy + ValueTableOffset;
+  // Keep the load factor at or below one half
+  while (BucketCount < (UINT32)Policy->RulesCount * 2) {
+    BucketCount <<= 1;
+  }
 
-  for (UINT16 i = 0; i < RulesCount; i++) {
-    RULE  *Rule = &Rules[i];
-    DEBUG ((DEBUG_VERBOSE, "Rule #: %d  Rule* 0x%p\n", i, Rule));
+  Parsed = AllocatePool (sizeof (MFCI_PARSED_POLICY) + BucketCount * sizeof (MFCI_POLICY_HASH_BUCKET));
+  if (Parsed == NULL) {
+    DEBUG ((DEBUG_ERROR, "AllocatePool Failed\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto _Exit;
+  }
 
-    if (Rule->RootKey != UEFI_POLICIES_ROOT_KEY) {
-      DEBUG ((DEBUG_ERROR, "Incorrect Root Key found: %x\n", Rule->RootKey));
-      continue;
+  Parsed->Signature  = MFCI_PARSED_POLICY_SIGNATURE;
+  Parsed->Policy     = Policy;
+  Parsed->PolicySize = PolicySize;
+  Parsed->Rules      = (RULE *)((UINT8 *)Policy + sizeof (MfciPolicyBlob));
+  Parsed->ValueTable = (UINT8 *)Parsed->Rules + Policy->RulesCount * sizeof (RULE);
+  Parsed->BucketMask = BucketCount - 1;
+  Parsed->Probes     = 0;
+  for (Bucket = 0; Bucket < BucketCount; Bucket++) {
+    Parsed->Buckets[Bucket].Hash      = 0;
+    Parsed->Buckets[Bucket].RuleIndex = MFCI_PARSED_POLICY_EMPTY_BUCKET;
+  }
+
+  for (UINT16 i = 0; i < Policy->RulesCount; i++) {
+    Rule       = &Parsed->Rules[i];
+    SubKeyName = (POLICY_STRING *)(Parsed->ValueTable + Rule->OffsetToSubKeyName);
+    ValueName  = (POLICY_STRING *)(Parsed->ValueTable + Rule->OffsetToValueName);
+    Hash       = PolicyHashRuleName (
+                   SubKeyName->String,
+                   SubKeyName->StringLength / sizeof (CHAR16),
+                   ValueName->String,
+                   ValueName->StringLength / sizeof (CHAR16)
+                   );
+
+    for (Bucket = Hash & Parsed->BucketMask; ; Bucket = (Bucket + 1) & Parsed->BucketMask) {
+      if (Parsed->Buckets[Bucket].RuleIndex == MFCI_PARSED_POLICY_EMPTY_BUCKET) {
+        Parsed->Buckets[Bucket].Hash      = Hash;
+        Parsed->Buckets[Bucket].RuleIndex = i;
+        break;
+      }
+
+      // A duplicated name keeps its first rule, as the linear search did
+      if ((Parsed->Buckets[Bucket].Hash == Hash) &&
+          PolicyRuleNameMatches (
+            Parsed,
+            Parsed->Buckets[Bucket].RuleIndex,
+            SubKeyName->String,
+            SubKeyName->StringLength / sizeof (CHAR16),
+            ValueName->String,
+            ValueName->StringLength / sizeof (CHAR16)
+            ))
+      {
+        DEBUG ((DEBUG_WARN, "Rule #: %d duplicates rule #: %d, ignored\n", i, Parsed->Buckets[Bucket].RuleIndex));
+        break;
+      }
     }
+  }
 
-    POLICY_STRING  *PolicyString = (POLICY_STRING *)(ValueTable + Rule->OffsetToSubKeyName);
-    CONST CHAR16   *SubKeyName   = PolicyString->String;
-    CONST UINT16   SubKeyLength  = PolicyString->StringLength / sizeof (CHAR16);
-    DEBUG ((DEBUG_VERBOSE, "SubKeyLength and Name are %d and '%s'\n", SubKeyLength, SubKeyName));
-    if (0 != StrnCmp (SubKeyExpected, SubKeyName, SubKeyLength)) {
-      continue;
-    }
+  DEBUG ((DEBUG_VERBOSE, "Indexed %d Rules in %d buckets\n", Policy->RulesCount, BucketCount));
 
-    PolicyString = (POLICY_STRING *)(ValueTable + Rule->OffsetToValueName);
-    CONST CHAR16  *ValueName  = PolicyString->String;
-    CONST UINT16  ValueLength = PolicyString->StringLength / sizeof (CHAR16);
-    if (0 != StrnCmp (ValueNameExpected, ValueName, ValueLength)) {
-      continue;
+  *ParsedPolicy = Parsed;
+  Parsed        = NULL;
+  Policy        = NULL;
+  Status        = EFI_SUCCESS;
+
+_Exit:
+  if (Parsed != NULL) {
+    FreePool (Parsed);
+    Parsed = NULL;
+  }
+
+  if (Policy != NULL) {
+    FreePool (Policy);
+    Policy = NULL;
+  }
+
+  return Status;
+}
+
+EFI_STATUS
+EFIAPI
+ExtractChar16FromParsedPolicy (
+  IN      MFCI_PARSED_POLICY  *ParsedPolicy,
+  IN      CONST CHAR16        *MfciPolicyName,
+  OUT     CHAR16              *MfciPolicyStringValue,
+  IN OUT  UINTN               *MfciPolicyStringValueSize
+  )
+{
+  POLICY_VALUE_HEADER  *PolicyValue;
+  POLICY_STRING        *PolicyString;
+  UINTN                StringLength;
+  UINTN                RequiredSize;
+
+  if ((ParsedPolicy == NULL) || (ParsedPolicy->Signature != MFCI_PARSED_POLICY_SIGNATURE) ||
+      (MfciPolicyName == NULL) || (MfciPolicyStringValueSize == NULL) ||
+      ((MfciPolicyStringValue == NULL) && (*MfciPolicyStringValueSize != 0)))
+  {
+    DEBUG ((DEBUG_ERROR, "ParsedPolicy invalid, or other parameters NULL\n"));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  PolicyValue = FindParsedPolicyValue (ParsedPolicy, MfciPolicyName);
+  if (PolicyValue == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (PolicyValue->Type != POLICY_VALUE_TYPE_STRING) {
+    DEBUG ((DEBUG_ERROR, "Value Type not String, found: 0x%x\n", PolicyValue->Type));
+    return EFI_COMPROMISED_DATA;
+  }
+
+  PolicyString = &((POLICY_VALUE_STRING *)PolicyValue)->String;
+  DEBUG ((DEBUG_VERBOSE, "PolicyString Length %x\n", PolicyString->StringLength));
+
+  if ((PolicyString->StringLength % sizeof (CHAR16)) != 0) {
+    DEBUG ((DEBUG_ERROR, "PolicyString Length %x is not a multiple of sizeof(CHAR16)\n", PolicyString->StringLength));
+    return EFI_COMPROMISED_DATA;
+  }
+
+  StringLength = PolicyString->StringLength / sizeof (CHAR16);
+  for (UINTN i = 0; i < StringLength; i++) {
+    if (PolicyString->String[i] == L'\0') {
+      DEBUG ((DEBUG_ERROR, "PolicyString has an embedded NULL at %x (not permitted)\n", i));
+      return EFI_COMPROMISED_DATA;
     }
+  }
 
-    *Value = (POLICY_VALUE_HEADER *)(ValueTable + Rule->OffsetToValue);
-    DEBUG ((DEBUG_VERBOSE, "Found at address: 0x%p\n", *Value));
-    return EFI_SUCCESS;
+  RequiredSize = PolicyString->StringLength + sizeof (CHAR16);  // Reserving space to add a NULL
+  if (*MfciPolicyStringValueSize < RequiredSize) {
+    *MfciPolicyStringValueSize = RequiredSize;
+    return EFI_BUFFER_TOO_SMALL;
   }
 
-  DEBUG ((DEBUG_ERROR, "Not Found\n"));
-  return EFI_NOT_FOUND;
+  CopyMem (MfciPolicyStringValue, PolicyString->String, PolicyString->StringLength);
+  MfciPolicyStringValue[StringLength] = L'\0';  // adding Wide NULL termination
+  *MfciPolicyStringValueSize          = RequiredSize;
+
+  DEBUG ((DEBUG_VERBOSE, "TargetString '%s'\n", MfciPolicyStringValue));
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+ExtractUint64FromParsedPolicy (
+  IN   MFCI_PARSED_POLICY  *ParsedPolicy,
+  IN   CONST CHAR16        *MfciPolicyName,
+  OUT  UINT64              *MfciPolicyU64Value
+  )
+{
+  POLICY_VALUE_HEADER  *PolicyValue;
+
+  if ((ParsedPolicy == NULL) || (ParsedPolicy->Signature != MFCI_PARSED_POLICY_SIGNATURE) ||
+      (MfciPolicyName == NULL) || (MfciPolicyU64Value == NULL))
+  {
+    DEBUG ((DEBUG_ERROR, "ParsedPolicy invalid, PolicyName is NULL, or PolicyValue is NULL\n"));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  PolicyValue = FindParsedPolicyValue (ParsedPolicy, MfciPolicyName);
+  if (PolicyValue == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (PolicyValue->Type != POLICY_VALUE_TYPE_QWORD) {
+    DEBUG ((DEBUG_ERROR, "Value Type not QWORD, found: 0x%x\n", PolicyValue->Type));
+    return EFI_COMPROMISED_DATA;
+  }
+
+  *MfciPolicyU64Value = ((POLICY_VALUE_QWORD *)PolicyValue)->Value;
+  return EFI_SUCCESS;
+}
+
+VOID
+EFIAPI
+FreeParsedPolicy (
+  IN  MFCI_PARSED_POLICY  *ParsedPolicy
+  )
+{
+  if (ParsedPolicy == NULL) {
+    return;
+  }
+
+  ASSERT (ParsedPolicy->Signature == MFCI_PARSED_POLICY_SIGNATURE);
+  ParsedPolicy->Signature = 0;
+
+  if (ParsedPolicy->Policy != NULL) {
+    FreePool (ParsedPolicy->Policy);
+  }
+
+  FreePool (ParsedPolicy);
 }
 
 EFI_STATUS
@@ -418,13 +700,10 @@ ExtractChar16 (
   OUT        CHAR16  **MfciPolicyStringValue       // allocated, caller must call FreePool()
   )
 {
-  EFI_STATUS           Status;
-  MfciPolicyBlob       *Policy          = NULL;
-  UINTN                PolicySize       = 0;
-  POLICY_VALUE_HEADER  *PolicyValue     = NULL;
-  CHAR16               *TargetString    = NULL;
-  UINT32               TargetStringSize = 0; // Length of TargetString in bytes, including any null-terminator.
-  POLICY_STRING        *PolicyString;
+  EFI_STATUS          Status;
+  MFCI_PARSED_POLICY  *ParsedPolicy    = NULL;
+  CHAR16              *TargetString    = NULL;
+  UINTN               TargetStringSize = 0; // Length of TargetString in bytes, including any null-terminator.
 
   DEBUG ((DEBUG_INFO, "%a()\n", __FUNCTION__));
 
@@ -433,56 +712,37 @@ ExtractChar16 (
     return EFI_INVALID_PARAMETER;
   }
 
-  if (TRUE != Pkcs7GetAttachedContent (SignedPolicy, SignedPolicySize, (VOID **)&Policy, &PolicySize)) {
-    DEBUG ((DEBUG_ERROR, "Pkcs7GetAttachedContent() returns FALSE\n"));
-    Status = EFI_COMPROMISED_DATA;
-    goto _Exit;
-  }
-
-  Status = FindRule (Policy, MfciPolicyName, &PolicyValue);
+  Status = ParsePolicy (SignedPolicy, SignedPolicySize, &ParsedPolicy);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "FindRule returned EFI_ERROR: %r\n", Status));
+    DEBUG ((DEBUG_ERROR, "ParsePolicy returned EFI_ERROR: %r\n", Status));
     goto _Exit;
   }
 
-  DEBUG ((DEBUG_VERBOSE, "PolicyValue 0x%p\n", PolicyValue));
-
-  if (PolicyValue->Type != POLICY_VALUE_TYPE_STRING) {
-    DEBUG ((DEBUG_ERROR, "Value Type not String, found: 0x%x\n", PolicyValue->Type));
-    Status = EFI_COMPROMISED_DATA;
+  // Query the size first, the lookup is cheap
+  Status = ExtractChar16FromParsedPolicy (ParsedPolicy, MfciPolicyName, NULL, &TargetStringSize);
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    DEBUG ((DEBUG_ERROR, "ExtractChar16FromParsedPolicy returned: %r\n", Status));
     goto _Exit;
   }
 
-  PolicyString = &((POLICY_VALUE_STRING *)PolicyValue)->String;
-  DEBUG ((DEBUG_VERBOSE, "PolicyString Length %x\n", PolicyString->StringLength));
-  DEBUG ((DEBUG_VERBOSE, "PolicyString Value '%s'\n", PolicyString->String));
-
-  TargetStringSize = (PolicyString->StringLength + sizeof (CHAR16));  // Reserving space to add a NULL
-  TargetString     = AllocatePool (TargetStringSize);
+  TargetString = AllocatePool (TargetStringSize);
   if (TargetString == NULL) {
     DEBUG ((DEBUG_ERROR, "AllocatePool Failed\n"));
     Status = EFI_OUT_OF_RESOURCES;
     goto _Exit;
   }
 
-  CopyMem (TargetString, &PolicyString->String, PolicyString->StringLength);
-  TargetString[PolicyString->StringLength / sizeof (CHAR16)] = L'\0';  // adding Wide NULL termination
-  if (StrSize (TargetString) != TargetStringSize) {
-    DEBUG ((DEBUG_ERROR, "StrSize of TargetString (%x) does not match TargetStringSize (%x), there must be embedded NULLs (not permitted)\n", StrSize (TargetString), TargetStringSize));
-    Status = EFI_COMPROMISED_DATA;
+  Status = ExtractChar16FromParsedPolicy (ParsedPolicy, MfciPolicyName, TargetString, &TargetStringSize);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "ExtractChar16FromParsedPolicy returned EFI_ERROR: %r\n", Status));
     goto _Exit;
   }
 
-  DEBUG ((DEBUG_VERBOSE, "TargetString '%s'\n", TargetString));
   *MfciPolicyStringValue = TargetString;
   TargetString           = NULL;
-  Status                 = EFI_SUCCESS;
 
 _Exit:
-  if (Policy != NULL) {
-    FreePool (Policy);
-    Policy = NULL;
-  }
+  FreeParsedPolicy (ParsedPolicy);
 
   if (TargetString != NULL) {
     FreePool (TargetString);
@@ -501,10 +761,8 @@ ExtractUint64 (
   OUT         UINT64  *MfciPolicyU64Value         // caller should provide pointer to UINT64
   )
 {
-  EFI_STATUS           Status;
-  MfciPolicyBlob       *Policy      = NULL;
-  UINTN                PolicySize   = 0;
-  POLICY_VALUE_HEADER  *PolicyValue = NULL;
+  EFI_STATUS          Status;
+  MFCI_PARSED_POLICY  *ParsedPolicy = NULL;
 
   DEBUG ((DEBUG_INFO, "%a()\n", __FUNCTION__));
 
@@ -513,32 +771,16 @@ ExtractUint64 (
     return EFI_INVALID_PARAMETER;
   }
 
-  if (TRUE != Pkcs7GetAttachedContent (SignedPolicy, SignedPolicySize, (VOID **)&Policy, &PolicySize)) {
-    DEBUG ((DEBUG_ERROR, "Pkcs7GetAttachedContent() returns FALSE\n"));
-    Status = EFI_COMPROMISED_DATA;
-    goto _Exit;
-  }
-
-  Status = FindRule (Policy, MfciPolicyName, &PolicyValue);
+  Status = ParsePolicy (SignedPolicy, SignedPolicySize, &ParsedPolicy);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "FindRule returned EFI_ERROR: %r\n", Status));
+    DEBUG ((DEBUG_ERROR, "ParsePolicy returned EFI_ERROR: %r\n", Status));
     goto _Exit;
   }
 
-  if (PolicyValue->Type != POLICY_VALUE_TYPE_QWORD) {
-    DEBUG ((DEBUG_ERROR, "Value Type not QWORD, found: 0x%x\n", PolicyValue->Type));
-    Status = EFI_COMPROMISED_DATA;
-    goto _Exit;
-  }
-
-  *MfciPolicyU64Value = ((POLICY_VALUE_QWORD *)PolicyValue)->Value;
-  Status              = EFI_SUCCESS;
+  Status = ExtractUint64FromParsedPolicy (ParsedPolicy, MfciPolicyName, MfciPolicyU64Value);
 
 _Exit:
-  if (Policy != NULL) {
-    FreePool (Policy);
-    Policy = NULL;
-  }
+  FreeParsedPolicy (ParsedPolicy);
 
   return Status;
 }
@@ -101,6 +101,31 @@ typedef enum _POLICY_VALUE_TYPE {
 
 STATIC CONST GUID  gPolicyPublisherGuid = POLICY_PUBLISHER_GUID;
 
+//
+// A parsed policy indexes its rules in an open addressed hash table keyed on
+// the (SubKeyName, ValueName) pair.  RulesCount is a UINT16, so MAX_UINT16 is
+// never a valid rule index and marks an empty bucket.
+//
+#define MFCI_PARSED_POLICY_SIGNATURE     SIGNATURE_32 ('M', 'F', 'P', 'P')
+#define MFCI_PARSED_POLICY_EMPTY_BUCKET  MAX_UINT16
+#define MFCI_PARSED_POLICY_MIN_BUCKETS   8
+
+typedef struct _MFCI_POLICY_HASH_BUCKET {
+  UINT32    Hash;
+  UINT16    RuleIndex;
+} MFCI_POLICY_HASH_BUCKET;
+
+struct _MFCI_PARSED_POLICY {
+  UINT32                     Signature;
+  MfciPolicyBlob             *Policy;      // Extracted payload, owned by the parsed policy
+  UINTN                      PolicySize;
+  RULE                       *Rules;
+  UINT8                      *ValueTable;
+  UINT32                     BucketMask;   // Bucket count - 1, the bucket count is a power of 2
+  UINTN                      Probes;       // Buckets examined by lookups, for diagnostics and tests
+  MFCI_POLICY_HASH_BUCKET    Buckets[];
+};
+
 //
 #define UEFI_POLICIES_ROOT_KEY    0xEF100000
 #define MFCI_POLICY_SUB_KEY_NAME  L"UEFI"
@@ -45,3 +45,45 @@ ExtractUint64 (
 {
   return EFI_UNSUPPORTED;
 }
+
+EFI_STATUS
+EFIAPI
+ParsePolicy (
+  IN  CONST VOID          *SignedPolicy,
+  UINTN                   SignedPolicySize,
+  OUT MFCI_PARSED_POLICY  **ParsedPolicy
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_STATUS
+EFIAPI
+ExtractChar16FromParsedPolicy (
+  IN      MFCI_PARSED_POLICY  *ParsedPolicy,
+  IN      CONST CHAR16        *MfciPolicyName,
+  OUT     CHAR16              *MfciPolicyStringValue,
+  IN OUT  UINTN               *MfciPolicyStringValueSize
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+EFI_STATUS
+EFIAPI
+ExtractUint64FromParsedPolicy (
+  IN   MFCI_PARSED_POLICY  *ParsedPolicy,
+  IN   CONST CHAR16        *MfciPolicyName,
+  OUT  UINT64              *MfciPolicyU64Value
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+VOID
+EFIAPI
+FreeParsedPolicy (
+  IN  MFCI_PARSED_POLICY  *ParsedPolicy
+  )
+{
+}
@@ -0,0 +1,519 @@
+/** @file
+  Host based unit tests of the parsed policy interface of MfciPolicyParsingLib.
+
+  Covers the values returned through a parsed policy handle, and the number of
+  hash buckets examined when looking rules up in large synthetic policies.
+
+  Copyright (c) Microsoft Corporation
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+
+#include <MfciPolicyFields.h>
+#include <Library/MfciPolicyParsingLib.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+
+#include <Library/UnitTestLib.h>
+#include <UnitTests/MfciPolicyParsingUnitTest/data/packets/policy_good_manufacturing.bin.h>
+#include <UnitTests/MfciPolicyParsingUnitTest/data/packets/policy_good_manufacturing.bin.p7.h>
+#include <UnitTests/MfciPolicyParsingUnitTest/data/packets/policy_badRuleRootKey.bin.h>
+
+#include <Private/Library/MfciPolicyParsingLib/MfciPolicyParsingLibInternal.h>
+
+#define UNIT_TEST_NAME     "Mfci Policy Parsing Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+// Values in policy_good_manufacturing based on UnitTests/data/packets/GenPacket.py
+#define MFCI_TEST_MANUFACTURER  L"Contoso Computers, LLC"
+#define MFCI_TEST_PRODUCT       L"Laptop Foo"
+#define MFCI_TEST_SERIAL_NUM    L"F0013-000243546-X02"
+#define MFCI_TEST_OEM_01        L"ODM Foo"
+#define MFCI_TEST_OEM_02        L""
+#define MFCI_TEST_NONCE         0x0123456789abcdef
+#define MFCI_TEST_POLICY        (MFCI_POLICY_VALUE_ACTION_SECUREBOOT_CLEAR | MFCI_POLICY_VALUE_ACTION_TPM_CLEAR)
+
+// Synthetic policies are built as close to POLICY_BLOB_MAX_SIZE as the rule layout allows
+#define SYNTHETIC_RULE_COUNT       640
+#define SYNTHETIC_RULES_PER_GROUP  64
+#define SYNTHETIC_NAME_LENGTH      16
+
+// Content returned by the mocked Pkcs7GetAttachedContent
+STATIC CONST UINT8  *mAttachedContent;
+STATIC UINTN        mAttachedContentSize;
+STATIC UINTN        mAttachedContentCalls;
+
+// Synthetic policy under construction
+STATIC UINT8  mSyntheticPolicy[POLICY_BLOB_MAX_SIZE];
+STATIC UINTN  mSyntheticPolicySize;
+STATIC UINTN  mSyntheticValueTableSize;
+
+/**
+  Mocked version of Pkcs7GetAttachedContent, returns a copy of mAttachedContent.
+**/
+BOOLEAN
+EFIAPI
+Pkcs7GetAttachedContent (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  OUT VOID         **Content,
+  OUT UINTN        *ContentSize
+  )
+{
+  mAttachedContentCalls++;
+  if (mAttachedContent == NULL) {
+    return FALSE;
+  }
+
+  *Content     = AllocateCopyPool (mAttachedContentSize, mAttachedContent);
+  *ContentSize = mAttachedContentSize;
+  return (*Content != NULL);
+}
+
+BOOLEAN
+EFIAPI
+Pkcs7Verify (
+  IN  CONST UINT8  *P7Data,
+  IN  UINTN        P7Length,
+  IN  CONST UINT8  *TrustedCert,
+  IN  UINTN        CertLength,
+  IN  CONST UINT8  *InData,
+  IN  UINTN        DataLength
+  )
+{
+  ASSERT (FALSE);
+  return FALSE;
+}
+
+EFI_STATUS
+EFIAPI
+VerifyEKUsInPkcs7Signature (
+  IN CONST UINT8   *Pkcs7Signature,
+  IN CONST UINT32  SignatureSize,
+  IN CONST CHAR8   *RequiredEKUs[],
+  IN CONST UINT32  RequiredEKUsSize,
+  IN BOOLEAN       RequireAllPresent
+  )
+{
+  ASSERT (FALSE);
+  return EFI_NOT_READY;
+}
+
+/**
+  Appends a POLICY_STRING to the value table of the synthetic policy.
+
+  @retval   Offset of the string within the value table
+**/
+STATIC
+UINT32
+SyntheticAppendString (
+  IN CONST CHAR16  *String
+  )
+{
+  UINT8   *ValueTable;
+  UINT32  Offset;
+  UINT16  Length;
+
+  ValueTable = mSyntheticPolicy + mSyntheticPolicySize - mSyntheticValueTableSize;
+  Offset     = (UINT32)mSyntheticValueTableSize;
+  Length     = (UINT16)StrLen (String) * sizeof (CHAR16);
+
+  CopyMem (ValueTable + Offset, &Length, sizeof (Length));
+  CopyMem (ValueTable + Offset + sizeof (Length), String, Length);
+
+  mSyntheticValueTableSize += sizeof (Length) + Length;
+  mSyntheticPolicySize     += sizeof (Length) + Length;
+  ASSERT (mSyntheticPolicySize <= sizeof (mSyntheticPolicy));
+  return Offset;
+}
+
+/**
+  Appends a POLICY_VALUE_QWORD to the value table of the synthetic policy.
+
+  @retval   Offset of the value within the value table
+**/
+STATIC
+UINT32
+SyntheticAppendQword (
+  IN UINT64  Value
+  )
+{
+  POLICY_VALUE_QWORD  Qword;
+  UINT32              Offset;
+
+  Qword.Header.Type = POLICY_VALUE_TYPE_QWORD;
+  Qword.Value       = Value;
+
+  Offset = (UINT32)mSyntheticValueTableSize;
+  CopyMem (mSyntheticPolicy + mSyntheticPolicySize, &Qword, sizeof (Qword));
+
+  mSyntheticValueTableSize += sizeof (Qword);
+  mSyntheticPolicySize     += sizeof (Qword);
+  ASSERT (mSyntheticPolicySize <= sizeof (mSyntheticPolicy));
+  return Offset;
+}
+
+STATIC
+VOID
+SyntheticRuleName (
+  IN  UINTN   Index,
+  OUT CHAR16  *Name,
+  IN  UINTN   NameSize
+  )
+{
+  UnicodeSPrint (Name, NameSize, L"Group%02d\\Value%04d", Index / SYNTHETIC_RULES_PER_GROUP, Index);
+}
+
+STATIC
+UINT64
+SyntheticRuleValue (
+  IN  UINTN  Index
+  )
+{
+  return 0xA5A5000000000000ULL | (Index * 0x10001);
+}
+
+/**
+  Builds a policy of RuleCount QWORD rules named GroupXX\ValueYYYY. The SubKey
+  names are shared by every rule of a group, and the last DuplicateCount rules
+  reuse the names of the first rules with different values.
+**/
+STATIC
+VOID
+BuildSyntheticPolicy (
+  IN UINTN  RuleCount,
+  IN UINTN  DuplicateCount
+  )
+{
+  MfciPolicyBlob  *Header;
+  RULE            *Rules;
+  UINTN           Index;
+  UINTN           NameIndex;
+  UINT32          SubKeyOffset = 0;
+  CHAR16          SubKey[SYNTHETIC_NAME_LENGTH];
+  CHAR16          ValueName[SYNTHETIC_NAME_LENGTH];
+
+  ZeroMem (mSyntheticPolicy, sizeof (mSyntheticPolicy));
+
+  Header                 = (MfciPolicyBlob *)mSyntheticPolicy;
+  Header->FormatVersion  = POLICY_FORMAT_VERSION;
+  Header->PolicyVersion  = POLICY_VERSION;
+  CopyMem (&Header->PolicyPublisher, &gPolicyPublisherGuid, sizeof (GUID));
+  Header->RulesCount     = (UINT16)(RuleCount + DuplicateCount);
+
+  Rules                    = (RULE *)(mSyntheticPolicy + sizeof (MfciPolicyBlob));
+  mSyntheticPolicySize     = sizeof (MfciPolicyBlob) + (RuleCount + DuplicateCount) * sizeof (RULE);
+  mSyntheticValueTableSize = 0;
+
+  for (Index = 0; Index < RuleCount + DuplicateCount; Index++) {
+    NameIndex = (Index < RuleCount) ? Index : Index - RuleCount;
+    if ((Index == RuleCount) || (NameIndex % SYNTHETIC_RULES_PER_GROUP == 0)) {
+      UnicodeSPrint (SubKey, sizeof (SubKey), L"Group%02d", NameIndex / SYNTHETIC_RULES_PER_GROUP);
+      SubKeyOffset = SyntheticAppendString (SubKey);
+    }
+
+    UnicodeSPrint (ValueName, sizeof (ValueName), L"Value%04d", NameIndex);
+    Rules[Index].RootKey            = UEFI_POLICIES_ROOT_KEY;
+    Rules[Index].OffsetToSubKeyName = SubKeyOffset;
+    Rules[Index].OffsetToValueName  = SyntheticAppendString (ValueName);
+    Rules[Index].OffsetToValue      = SyntheticAppendQword ((Index < RuleCount) ? SyntheticRuleValue (Index) : 0);
+  }
+
+  mAttachedContent     = mSyntheticPolicy;
+  mAttachedContentSize = mSyntheticPolicySize;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+GoodPolicyPrerequisite (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  mAttachedContent      = mBin_policy_good_manufacturing;
+  mAttachedContentSize  = sizeof (mBin_policy_good_manufacturing);
+  mAttachedContentCalls = 0;
+  return UNIT_TEST_PASSED;
+}
+
+// Every field of the good policy is served from one extraction of the signed blob
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestParsedPolicyFields (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS          Status;
+  MFCI_PARSED_POLICY  *ParsedPolicy = NULL;
+  CHAR16              Buffer[MFCI_POLICY_FIELD_MAX_LEN];
+  UINTN               BufferSize;
+  UINT64              Value;
+  UINTN               Index;
+  CONST CHAR16        *Expected[] = {
+    MFCI_TEST_MANUFACTURER,
+    MFCI_TEST_PRODUCT,
+    MFCI_TEST_SERIAL_NUM,
+    MFCI_TEST_OEM_01,
+    MFCI_TEST_OEM_02
+  };
+
+  Status = ParsePolicy (mSigned_policy_good_manufacturing, sizeof (mSigned_policy_good_manufacturing), &ParsedPolicy);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_NOT_NULL (ParsedPolicy);
+
+  for (Index = 0; Index < ARRAY_SIZE (Expected); Index++) {
+    BufferSize = sizeof (Buffer);
+    Status     = ExtractChar16FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[Index], Buffer, &BufferSize);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (BufferSize, StrSize (Expected[Index]));
+    UT_ASSERT_MEM_EQUAL (Buffer, Expected[Index], BufferSize);
+  }
+
+  Status = ExtractUint64FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[MFCI_POLICY_TARGET_NONCE], &Value);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Value, MFCI_TEST_NONCE);
+
+  Status = ExtractUint64FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[MFCI_POLICY_FIELD_UEFI_POLICY], &Value);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Value, MFCI_TEST_POLICY);
+
+  UT_ASSERT_EQUAL (mAttachedContentCalls, 1);
+
+  FreeParsedPolicy (ParsedPolicy);
+  return UNIT_TEST_PASSED;
+}
+
+// Names match exactly, types are enforced and the caller buffer is sized like GetVariable
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestParsedPolicyLookupErrors (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS          Status;
+  MFCI_PARSED_POLICY  *ParsedPolicy = NULL;
+  CHAR16              Buffer[4];
+  UINTN               BufferSize;
+  UINT64              Value;
+
+  Status = ParsePolicy (mSigned_policy_good_manufacturing, sizeof (mSigned_policy_good_manufacturing), &ParsedPolicy);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, L"Target\\Nonc", &Value), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, L"Target\\NonceX", &Value), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, L"TargetX\\Nonce", &Value), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, L"TargetNonce", &Value), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, L"\\Nonce", &Value), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, L"", &Value), EFI_NOT_FOUND);
+
+  // Type mismatches
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[MFCI_POLICY_TARGET_PRODUCT], &Value), EFI_COMPROMISED_DATA);
+  BufferSize = sizeof (Buffer);
+  UT_ASSERT_STATUS_EQUAL (ExtractChar16FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[MFCI_POLICY_TARGET_NONCE], Buffer, &BufferSize), EFI_COMPROMISED_DATA);
+
+  // Too small a buffer reports the required size, and a NULL buffer may be used to query it
+  BufferSize = sizeof (Buffer);
+  UT_ASSERT_STATUS_EQUAL (ExtractChar16FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[MFCI_POLICY_TARGET_PRODUCT], Buffer, &BufferSize), EFI_BUFFER_TOO_SMALL);
+  UT_ASSERT_EQUAL (BufferSize, StrSize (MFCI_TEST_PRODUCT));
+  BufferSize = 0;
+  UT_ASSERT_STATUS_EQUAL (ExtractChar16FromParsedPolicy (ParsedPolicy, gPolicyBlobFieldName[MFCI_POLICY_TARGET_PRODUCT], NULL, &BufferSize), EFI_BUFFER_TOO_SMALL);
+  UT_ASSERT_EQUAL (BufferSize, StrSize (MFCI_TEST_PRODUCT));
+
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (NULL, gPolicyBlobFieldName[MFCI_POLICY_TARGET_NONCE], &Value), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, NULL, &Value), EFI_INVALID_PARAMETER);
+
+  FreeParsedPolicy (ParsedPolicy);
+  return UNIT_TEST_PASSED;
+}
+
+// A payload failing the sanity checks never produces a handle
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestParsePolicyRejectsBadPolicy (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MFCI_PARSED_POLICY  *ParsedPolicy = NULL;
+
+  mAttachedContent     = mBin_policy_badRuleRootKey;
+  mAttachedContentSize = sizeof (mBin_policy_badRuleRootKey);
+  UT_ASSERT_STATUS_EQUAL (ParsePolicy (mSigned_policy_good_manufacturing, sizeof (mSigned_policy_good_manufacturing), &ParsedPolicy), EFI_COMPROMISED_DATA);
+  UT_ASSERT_TRUE (ParsedPolicy == NULL);
+
+  mAttachedContent = NULL;
+  UT_ASSERT_STATUS_EQUAL (ParsePolicy (mSigned_policy_good_manufacturing, sizeof (mSigned_policy_good_manufacturing), &ParsedPolicy), EFI_COMPROMISED_DATA);
+  UT_ASSERT_TRUE (ParsedPolicy == NULL);
+
+  UT_ASSERT_STATUS_EQUAL (ParsePolicy (NULL, sizeof (mSigned_policy_good_manufacturing), &ParsedPolicy), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (ParsePolicy (mSigned_policy_good_manufacturing, 0, &ParsedPolicy), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (ParsePolicy (mSigned_policy_good_manufacturing, sizeof (mSigned_policy_good_manufacturing), NULL), EFI_INVALID_PARAMETER);
+
+  return UNIT_TEST_PASSED;
+}
+
+// Every rule of a large policy is found with about one bucket examined per lookup
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestLargePolicyLookupCount (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS          Status;
+  MFCI_PARSED_POLICY  *ParsedPolicy = NULL;
+  CHAR16              Name[2 * SYNTHETIC_NAME_LENGTH];
+  UINT64              Value;
+  UINTN               Index;
+
+  BuildSyntheticPolicy (SYNTHETIC_RULE_COUNT, 0);
+  UT_ASSERT_NOT_EFI_ERROR (SanityCheckPolicy ((MfciPolicyBlob *)mSyntheticPolicy, mSyntheticPolicySize));
+
+  Status = ParsePolicy (mSigned_policy_good_manufacturing, sizeof (mSigned_policy_good_manufacturing), &ParsedPolicy);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (ParsedPolicy->Probes, 0);
+
+  for (Index = 0; Index < SYNTHETIC_RULE_COUNT; Index++) {
+    SyntheticRuleName (Index, Name, sizeof (Name));
+    Status = ExtractUint64FromParsedPolicy (ParsedPolicy, Name, &Value);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (Value, SyntheticRuleValue (Index));
+  }
+
+  // A linear search would examine SYNTHETIC_RULE_COUNT / 2 rules per lookup on average
+  UT_LOG_INFO ("%d hits examined %d buckets\n", SYNTHETIC_RULE_COUNT, ParsedPolicy->Probes);
+  UT_ASSERT_TRUE (ParsedPolicy->Probes <= 2 * SYNTHETIC_RULE_COUNT);
+
+  // Misses stop at the first empty bucket
+  ParsedPolicy->Probes = 0;
+  for (Index = SYNTHETIC_RULE_COUNT; Index < 2 * SYNTHETIC_RULE_COUNT; Index++) {
+    SyntheticRuleName (Index, Name, sizeof (Name));
+    UT_ASSERT_STATUS_EQUAL (ExtractUint64FromParsedPolicy (ParsedPolicy, Name, &Value), EFI_NOT_FOUND);
+  }
+
+  UT_LOG_INFO ("%d misses examined %d buckets\n", SYNTHETIC_RULE_COUNT, ParsedPolicy->Probes);
+  UT_ASSERT_TRUE (ParsedPolicy->Probes <= 3 * SYNTHETIC_RULE_COUNT);
+
+  // The payload was only extracted once for all of the lookups
+  UT_ASSERT_EQUAL (mAttachedContentCalls, 1);
+
+  FreeParsedPolicy (ParsedPolicy);
+  return UNIT_TEST_PASSED;
+}
+
+// A duplicated name resolves to its first rule, as the linear search did
+UNIT_TEST_STATUS
+EFIAPI
+UnitTestDuplicateRuleKeepsFirst (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS          Status;
+  MFCI_PARSED_POLICY  *ParsedPolicy = NULL;
+  CHAR16              Name[2 * SYNTHETIC_NAME_LENGTH];
+  UINT64              Value;
+  UINTN               Index;
+
+  BuildSyntheticPolicy (SYNTHETIC_RULES_PER_GROUP, 8);
+
+  Status = ParsePolicy (mSigned_policy_good_manufacturing, sizeof (mSigned_policy_good_manufacturing), &ParsedPolicy);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  for (Index = 0; Index < SYNTHETIC_RULES_PER_GROUP; Index++) {
+    SyntheticRuleName (Index, Name, sizeof (Name));
+    Status = ExtractUint64FromParsedPolicy (ParsedPolicy, Name, &Value);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_EQUAL (Value, SyntheticRuleValue (Index));
+  }
+
+  FreeParsedPolicy (ParsedPolicy);
+
+  // The single lookup interface resolves the same way
+  SyntheticRuleName (3, Name, sizeof (Name));
+  Status = ExtractUint64 (mSigned_policy_good_manufacturing, sizeof (mSigned_policy_good_manufacturing), Name, &Value);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Value, SyntheticRuleValue (3));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  sample unit tests and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UefiTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ParsedPolicySuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the ParsedPolicySuite Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&ParsedPolicySuite, Framework, "ParsedPolicy", "MfciPolicy.ParserLib.ParsedPolicy", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ParsedPolicySuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ParsedPolicySuite, "Parsed policy should return every field of the good policy", "Fields", UnitTestParsedPolicyFields, GoodPolicyPrerequisite, NULL, NULL);
+  AddTestCase (ParsedPolicySuite, "Parsed policy lookups should match names exactly and enforce types", "LookupErrors", UnitTestParsedPolicyLookupErrors, GoodPolicyPrerequisite, NULL, NULL);
+  AddTestCase (ParsedPolicySuite, "ParsePolicy should reject a policy failing the sanity checks", "RejectBad", UnitTestParsePolicyRejectsBadPolicy, GoodPolicyPrerequisite, NULL, NULL);
+  AddTestCase (ParsedPolicySuite, "Large policy lookups should examine about one bucket each", "LookupCount", UnitTestLargePolicyLookupCount, GoodPolicyPrerequisite, NULL, NULL);
+  AddTestCase (ParsedPolicySuite, "Duplicated rule names should resolve to the first rule", "Duplicates", UnitTestDuplicateRuleKeepsFirst, GoodPolicyPrerequisite, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UefiTestMain ();
+}
@@ -21,12 +21,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 // where the ASCII fields include all characters 0x01-0xFF excluding 0x22 (the double quote "). 0x00
 // is the NULL terminator.  ASCII is not validated, and may include some UTF-8 special characters, but
-// should not have an effect on parsing.  If there is a leading quote, parsing ends at an ending quote
-// that only has whitespace, comma, or close brace.
+// should not have an effect on parsing.  A backslash starts a Json escape sequence, so a quote may be
+// included as \".
 //
 // An embedded NULL in the string will only stop parsing the string.
 //
-// A value (data to the right of the ':') may only be a quoted string, decimal number, or the word null.
+// A value (data to the right of the ':') may be a quoted string, number, true, false, the word null,
+// or a nested object or array.
 //
 // JSON_REQUEST_ELEMENT notes:
 //
@@ -42,6 +43,64 @@ typedef struct {
 
 #define JSON_NULL  "null"
 
+//
+// Pull tokenizer
+//
+// JsonTokenizerInit() and JsonNextToken() walk a complete JSON document one token
+// at a time.  Objects, arrays, strings, numbers, true, false and null are supported
+// with any nesting up to the depth limit.  Tokens point into the caller's buffer and
+// nothing is copied or allocated.  String tokens do not include the quotes and still
+// contain any escape sequences; use JsonUnescapeString() when the decoded text is needed.
+//
+// JsonLibParse() is built on the tokenizer and keeps its flat name/value behavior.
+//
+
+//
+// Max nesting of objects and arrays supported by the tokenizer
+//
+#define JSON_MAX_DEPTH  64
+
+typedef enum {
+  JsonTokenObjectStart,     // {
+  JsonTokenObjectEnd,       // }
+  JsonTokenArrayStart,      // [
+  JsonTokenArrayEnd,        // ]
+  JsonTokenName,            // "name" of a name/value pair, the ':' is consumed
+  JsonTokenString,          // "string" value
+  JsonTokenNumber,
+  JsonTokenTrue,
+  JsonTokenFalse,
+  JsonTokenNull,
+  JsonTokenEnd              // end of the document, nothing but white space remains
+} JSON_TOKEN_TYPE;
+
+//
+// Text is NOT NULL terminated.  For JsonTokenName and JsonTokenString it excludes
+// the quotes.  Depth is 0 for the top level value and increases inside each
+// object or array.  Start and end tokens have the depth of the container itself.
+//
+typedef struct {
+  JSON_TOKEN_TYPE    Type;
+  CONST CHAR8        *Text;
+  UINTN              Length;
+  UINTN              Depth;
+  BOOLEAN            HasEscapes;
+} JSON_TOKEN;
+
+//
+// Tokenizer state.  Declared here so callers can keep it on the stack; the
+// fields are private to the library.
+//
+typedef struct {
+  CONST CHAR8    *Json;
+  UINTN          Length;
+  UINTN          Offset;
+  UINTN          Depth;
+  UINTN          MaxDepth;
+  UINT64         ArrayMask;        // bit n set if the container at depth n is an array
+  UINT8          State;
+} JSON_TOKENIZER;
+
 /**
  *  Function to process a Json Element
  *
@@ -68,7 +127,8 @@ EFI_STATUS
  *
  * Don't confuse this routine for a real Json Encoder.  This code is for the
  * expected Dfci request packets. Strict formatting is required, and
- * comments are not allowed.
+ * comments are not allowed.  Quote, backslash, and control characters in
+ * names and values are escaped.
  *
  * The caller is responsible for freeing the returned Json String;
  *
@@ -91,9 +151,11 @@ JsonLibEncode (
  * @param[in]      Context for the process function
  *
  * Don't confuse this routine for a real Json Parser.  This code is for the
- * expected Dfci request blobs, and consist of a maximum of 6 name value pairs.
+ * expected Dfci request blobs, a single object of name value pairs.  Values that
+ * are objects or arrays are passed to the process function as their raw Json text.
  *
- * JsonString will be modified by the parse action.
+ * JsonString will be modified by the parse action.  Names and string values with
+ * escape sequences are decoded in place.
  * JsonElementArray will be initialized to all zeros before processing
  *
  * returns    EFI_STATUS    EFI_SUCCESS   - Processed at least one JSON element
@@ -109,4 +171,72 @@ JsonLibParse (
   IN  VOID                  *Context
   );
 
+/**
+ * JsonTokenizerInit
+ *
+ * @param[out] Tokenizer        Tokenizer to initialize
+ * @param[in]  JsonString       Json text.  Does not need to be NULL terminated.
+ * @param[in]  JsonStringLength Number of characters in JsonString
+ * @param[in]  MaxDepth         Max nesting allowed.  0 for JSON_MAX_DEPTH.
+ *
+ * JsonString must remain valid while the tokenizer and its tokens are in use.
+ *
+ * returns    EFI_STATUS    EFI_SUCCESS           - Tokenizer is ready
+ *                          EFI_INVALID_PARAMETER - NULL pointer or MaxDepth > JSON_MAX_DEPTH
+ **/
+EFI_STATUS
+EFIAPI
+JsonTokenizerInit (
+  OUT JSON_TOKENIZER  *Tokenizer,
+  IN  CONST CHAR8     *JsonString,
+  IN  UINTN           JsonStringLength,
+  IN  UINTN           MaxDepth
+  );
+
+/**
+ * JsonNextToken
+ *
+ * @param[in, out] Tokenizer    Tokenizer from JsonTokenizerInit
+ * @param[out]     Token        Next token in the document
+ *
+ * Once JsonTokenEnd has been returned every later call returns it again.
+ *
+ * returns    EFI_STATUS    EFI_SUCCESS           - Token is valid
+ *                          EFI_INVALID_PARAMETER - NULL pointer or the Json is malformed
+ *                          EFI_BAD_BUFFER_SIZE   - Nesting exceeds the depth limit
+ **/
+EFI_STATUS
+EFIAPI
+JsonNextToken (
+  IN OUT JSON_TOKENIZER  *Tokenizer,
+  OUT    JSON_TOKEN      *Token
+  );
+
+/**
+ * JsonUnescapeString
+ *
+ * @param[in]  Text         Text of a JsonTokenName or JsonTokenString token
+ * @param[in]  Length       Length of Text
+ * @param[out] Buffer       Where to write the decoded text.  May be the same as Text.
+ * @param[in]  BufferSize   Size of Buffer.  Length + 1 is always enough.
+ * @param[out] DecodedLength Number of characters written, not including the NULL terminator
+ *
+ * Escape sequences are decoded and \u escapes are written as UTF-8.  The decoded
+ * text is never longer than the input so it can be decoded in place.  The result
+ * is NULL terminated.
+ *
+ * returns    EFI_STATUS    EFI_SUCCESS           - Decoded
+ *                          EFI_BUFFER_TOO_SMALL  - Buffer can't hold the decoded text
+ *                          EFI_INVALID_PARAMETER - NULL pointer or invalid escape sequence
+ **/
+EFI_STATUS
+EFIAPI
+JsonUnescapeString (
+  IN  CONST CHAR8  *Text,
+  IN  UINTN        Length,
+  OUT CHAR8        *Buffer,
+  IN  UINTN        BufferSize,
+  OUT UINTN        *DecodedLength
+  );
+
 #endif // __JSON_LITE_H__
@@ -0,0 +1,44 @@
+/** @file -- PseudoRandomLib.h
+
+Repeatable pseudo random numbers for tests and benchmarks. The generator is
+xorshift64*: the same seed always produces the same sequence, so a failing
+randomized run can be replayed. It is not suitable for anything that needs
+unpredictable values; use RngLib for those.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef PSEUDO_RANDOM_LIB_H_
+#define PSEUDO_RANDOM_LIB_H_
+
+/**
+  Returns the next value of the generator and advances State.
+
+  @param[in, out] State   Generator state. Seed it with any value but 0.
+
+  @return The next pseudo random value.
+**/
+UINT64
+EFIAPI
+PseudoRandomNext (
+  IN OUT UINT64  *State
+  );
+
+/**
+  Returns the next value of the generator reduced to the range [0, Limit).
+
+  @param[in, out] State   Generator state. Seed it with any value but 0.
+  @param[in]      Limit   Exclusive upper bound, must not be 0.
+
+  @return A pseudo random value below Limit.
+**/
+UINT64
+EFIAPI
+PseudoRandomBelow (
+  IN OUT UINT64  *State,
+  IN     UINT64  Limit
+  );
+
+#endif // PSEUDO_RANDOM_LIB_H_
@@ -2,6 +2,11 @@
 An interface for managing a queue.
 This can currently hold a max of 100000 items
 
+Each item is a variable under the queue GUID named with its decimal id.
+The ids of each queue are kept in an in memory index which is built on first
+use and then updated by the add and pop functions, so the variable store is
+only enumerated when no valid metadata variable exists for the queue.
+
 Copyright (c) Microsoft Corporation. All rights reserved.
 SPDX-License-Identifier: BSD-2-Clause-Patent
 
@@ -18,11 +23,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Library/QueueLib.h>
 
-// TODO: should this be a PCD? So that it can be modified?
-#define DEFAULT_QUEUE_VAR_ATTR    (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS)
-#define DEFAULT_QUEUE_VAR_NAME    L"00000"
-#define DEFAULT_QUEUE_VAR_FORMAT  L"%d"
-#define DEFAULT_QUEUE_MODULO      100000
+#include "DxeQueueUefiVariableLibInternal.h"
+
+STATIC LIST_ENTRY  mQueueIndexList = INITIALIZE_LIST_HEAD_VARIABLE (mQueueIndexList);
 
 /**
   Writes a variable name string for a given ID
@@ -176,6 +179,474 @@ GetNextQueueVariableName (
   return Status;
 }
 
+/**
+  Writes the metadata variable name for a queue.
+
+  @param[in]    QueueGuid                   The Identifier of the queue
+  @param[out]   VarName                     Buffer of QUEUE_METADATA_NAME_LENGTH + 1 characters
+*/
+STATIC
+VOID
+GenerateMetadataVarName (
+  IN  EFI_GUID  *QueueGuid,
+  OUT CHAR16    *VarName
+  )
+{
+  UnicodeSPrint (VarName, (QUEUE_METADATA_NAME_LENGTH + 1) * sizeof (CHAR16), QUEUE_METADATA_VAR_FORMAT, QueueGuid);
+}
+
+/**
+  Checks if the variable backing a queue item exists.
+
+  @param[in]    QueueGuid                   The Identifier of the queue
+  @param[in]    VarId                       Id of the item
+
+  @retval       TRUE                        The variable exists
+  @retval       FALSE                       The variable does not exist
+*/
+STATIC
+BOOLEAN
+QueueItemExists (
+  IN EFI_GUID  *QueueGuid,
+  IN UINTN     VarId
+  )
+{
+  CHAR16  VarName[] = DEFAULT_QUEUE_VAR_NAME;
+  UINTN   DataSize;
+
+  GenerateVarName (VarId, VarName, sizeof (VarName));
+  DataSize = 0;
+  return (BOOLEAN)(gRT->GetVariable (VarName, QueueGuid, NULL, &DataSize, NULL) == EFI_BUFFER_TOO_SMALL);
+}
+
+/**
+  Writes the metadata variable for a queue from its index.
+
+  A failure only costs an enumeration on the next boot, so it is not returned.
+  If the write fails the old metadata is deleted so it can't be trusted later.
+
+  @param[in]    Index                       The index of the queue
+*/
+STATIC
+VOID
+WriteQueueMetadata (
+  IN QUEUE_INDEX  *Index
+  )
+{
+  EFI_STATUS      Status;
+  QUEUE_METADATA  Metadata;
+  CHAR16          VarName[QUEUE_METADATA_NAME_LENGTH + 1];
+
+  Metadata.Signature = QUEUE_METADATA_SIGNATURE;
+  Metadata.Count     = (UINT32)Index->Count;
+  Metadata.HeadId    = 0;
+  Metadata.TailId    = 0;
+  if (Index->Count != 0) {
+    Metadata.HeadId = Index->Ids[Index->First];
+    Metadata.TailId = Index->Ids[Index->First + Index->Count - 1];
+  }
+
+  GenerateMetadataVarName (&Index->QueueGuid, VarName);
+  Status = gRT->SetVariable (VarName, &gMuQueueMetadataVariableGuid, QUEUE_METADATA_VAR_ATTR, sizeof (Metadata), &Metadata);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_WARN, "[%a] - failed to write queue metadata %r\n", __FUNCTION__, Status));
+    gRT->SetVariable (VarName, &gMuQueueMetadataVariableGuid, QUEUE_METADATA_VAR_ATTR, 0, NULL);
+  }
+}
+
+/**
+  Appends an id to the back of a queue index.
+
+  @param[in]    Index                       The index of the queue
+  @param[in]    VarId                       Id to append
+
+  @retval       EFI_SUCCESS                 The id was added
+  @retval       EFI_OUT_OF_RESOURCES        The index could not be grown
+*/
+STATIC
+EFI_STATUS
+QueueIndexAppend (
+  IN QUEUE_INDEX  *Index,
+  IN UINT32       VarId
+  )
+{
+  UINT32  *NewIds;
+
+  if (Index->First + Index->Count == Index->Capacity) {
+    if (Index->First != 0) {
+      // Reclaim the space left by items popped from the front
+      CopyMem (Index->Ids, &Index->Ids[Index->First], Index->Count * sizeof (UINT32));
+      Index->First = 0;
+    } else {
+      NewIds = ReallocatePool (
+                 Index->Capacity * sizeof (UINT32),
+                 (Index->Capacity + QUEUE_INDEX_GROW) * sizeof (UINT32),
+                 Index->Ids
+                 );
+      if (NewIds == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+
+      Index->Ids       = NewIds;
+      Index->Capacity += QUEUE_INDEX_GROW;
+    }
+  }
+
+  Index->Ids[Index->First + Index->Count] = VarId;
+  Index->Count++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Removes the id at a position in a queue index.
+
+  @param[in]    Index                       The index of the queue
+  @param[in]    ItemIndex                   Position in the queue, 0 is the front
+*/
+STATIC
+VOID
+QueueIndexRemove (
+  IN QUEUE_INDEX  *Index,
+  IN UINTN        ItemIndex
+  )
+{
+  ASSERT (ItemIndex < Index->Count);
+
+  if (ItemIndex == 0) {
+    Index->First++;
+  } else {
+    CopyMem (
+      &Index->Ids[Index->First + ItemIndex],
+      &Index->Ids[Index->First + ItemIndex + 1],
+      (Index->Count - ItemIndex - 1) * sizeof (UINT32)
+      );
+  }
+
+  Index->Count--;
+  if (Index->Count == 0) {
+    Index->First = 0;
+  }
+}
+
+/**
+  Frees a queue index.
+
+  @param[in]    Index                       The index to free
+*/
+STATIC
+VOID
+FreeQueueIndex (
+  IN QUEUE_INDEX  *Index
+  )
+{
+  RemoveEntryList (&Index->Link);
+  if (Index->Ids != NULL) {
+    FreePool (Index->Ids);
+  }
+
+  FreePool (Index);
+}
+
+/**
+  Discards a queue index that no longer matches the variable store.
+
+  The metadata variable is deleted as well so the next use of the queue
+  enumerates the variable store.
+
+  @param[in]    Index                       The index to discard
+*/
+STATIC
+VOID
+InvalidateQueueIndex (
+  IN QUEUE_INDEX  *Index
+  )
+{
+  CHAR16  VarName[QUEUE_METADATA_NAME_LENGTH + 1];
+
+  GenerateMetadataVarName (&Index->QueueGuid, VarName);
+  gRT->SetVariable (VarName, &gMuQueueMetadataVariableGuid, QUEUE_METADATA_VAR_ATTR, 0, NULL);
+  FreeQueueIndex (Index);
+}
+
+/**
+  Fills a queue index from the metadata variable.
+
+  The metadata is only trusted if the ids in it are contiguous, the first and
+  last items exist and the item after the last does not.  Anything else means
+  the queue was changed without the metadata being updated.
+
+  @param[in]    Index                       An empty index for the queue
+
+  @retval       TRUE                        The index was filled
+  @retval       FALSE                       The metadata is missing or stale
+*/
+STATIC
+BOOLEAN
+LoadQueueIndexFromMetadata (
+  IN QUEUE_INDEX  *Index
+  )
+{
+  EFI_STATUS      Status;
+  QUEUE_METADATA  Metadata;
+  UINTN           DataSize;
+  UINT32          VarId;
+  CHAR16          VarName[QUEUE_METADATA_NAME_LENGTH + 1];
+
+  GenerateMetadataVarName (&Index->QueueGuid, VarName);
+  DataSize = sizeof (Metadata);
+  Status   = gRT->GetVariable (VarName, &gMuQueueMetadataVariableGuid, NULL, &DataSize, &Metadata);
+  if (EFI_ERROR (Status) || (DataSize != sizeof (Metadata)) || (Metadata.Signature != QUEUE_METADATA_SIGNATURE)) {
+    return FALSE;
+  }
+
+  if (Metadata.Count == 0) {
+    if ((Metadata.HeadId != 0) || (Metadata.TailId != 0)) {
+      return FALSE;
+    }
+  } else if ((Metadata.HeadId == 0) ||
+             (Metadata.TailId >= DEFAULT_QUEUE_MODULO) ||
+             (Metadata.TailId < Metadata.HeadId) ||
+             (Metadata.TailId - Metadata.HeadId + 1 != Metadata.Count) ||
+             !QueueItemExists (&Index->QueueGuid, Metadata.HeadId) ||
+             !QueueItemExists (&Index->QueueGuid, Metadata.TailId))
+  {
+    return FALSE;
+  }
+
+  if (QueueItemExists (&Index->QueueGuid, Metadata.TailId + 1)) {
+    return FALSE;
+  }
+
+  for (VarId = Metadata.HeadId; Index->Count < Metadata.Count; VarId++) {
+    if (EFI_ERROR (QueueIndexAppend (Index, VarId))) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Fills a queue index by enumerating the variable store once.
+
+  @param[in]    Index                       An empty index for the queue
+
+  @retval       EFI_SUCCESS                 The index was filled
+  @retval       Other                       The enumeration failed
+*/
+STATIC
+EFI_STATUS
+LoadQueueIndexFromVariables (
+  IN QUEUE_INDEX  *Index
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      *VariableName;
+  UINTN       VariableNameSize;
+  EFI_GUID    VariableGuid;
+  UINTN       VarId;
+  UINTN       Pos;
+  UINTN       Slot;
+  UINT32      *Ids;
+
+  VariableName = NULL;
+  Status       = EFI_SUCCESS;
+
+  while (Status == EFI_SUCCESS) {
+    Status = GetNextQueueVariableName (&VariableName, &VariableGuid, &VariableNameSize, &Index->QueueGuid);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (EFI_ERROR (GetIdFromVarName (VariableName, VariableNameSize, &VarId)) || (VarId == 0) || (VarId >= DEFAULT_QUEUE_MODULO)) {
+      DEBUG ((DEBUG_WARN, "[%a] - ignoring variable %s in queue %g\n", __FUNCTION__, VariableName, &Index->QueueGuid));
+      continue;
+    }
+
+    Status = QueueIndexAppend (Index, (UINT32)VarId);
+  }
+
+  if (VariableName != NULL) {
+    FreePool (VariableName);
+  }
+
+  // going all the way to the end of the varstore gives us a EFI_NOT_FOUND
+  if (Status != EFI_NOT_FOUND) {
+    return Status;
+  }
+
+  //
+  // Variables usually enumerate in the order they were written, so the ids
+  // are nearly sorted already and an insertion sort is close to linear.
+  //
+  Ids = &Index->Ids[Index->First];
+  for (Pos = 1; Pos < Index->Count; Pos++) {
+    VarId = Ids[Pos];
+    for (Slot = Pos; (Slot > 0) && (Ids[Slot - 1] > VarId); Slot--) {
+      Ids[Slot] = Ids[Slot - 1];
+    }
+
+    Ids[Slot] = (UINT32)VarId;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Gets the index of a queue, building it on first use.
+
+  @param[in]    QueueGuid                   The Identifier of the queue
+  @param[out]   Index                       The index of the queue
+
+  @retval       EFI_SUCCESS                 The index was returned
+  @retval       EFI_OUT_OF_RESOURCES        Memory for the index could not be allocated
+  @retval       Other                       The variable store could not be enumerated
+*/
+STATIC
+EFI_STATUS
+GetQueueIndex (
+  IN  EFI_GUID     *QueueGuid,
+  OUT QUEUE_INDEX  **Index
+  )
+{
+  EFI_STATUS   Status;
+  LIST_ENTRY   *Link;
+  QUEUE_INDEX  *NewIndex;
+
+  for (Link = GetFirstNode (&mQueueIndexList); !IsNull (&mQueueIndexList, Link); Link = GetNextNode (&mQueueIndexList, Link)) {
+    NewIndex = QUEUE_INDEX_FROM_LINK (Link);
+    if (CompareGuid (&NewIndex->QueueGuid, QueueGuid)) {
+      *Index = NewIndex;
+      return EFI_SUCCESS;
+    }
+  }
+
+  NewIndex = AllocateZeroPool (sizeof (QUEUE_INDEX));
+  if (NewIndex == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewIndex->Signature = QUEUE_INDEX_SIGNATURE;
+  CopyGuid (&NewIndex->QueueGuid, QueueGuid);
+  InsertTailList (&mQueueIndexList, &NewIndex->Link);
+
+  if (!LoadQueueIndexFromMetadata (NewIndex)) {
+    DEBUG ((DEBUG_INFO, "[%a] - no valid metadata for queue %g, enumerating variables\n", __FUNCTION__, QueueGuid));
+    NewIndex->First = 0;
+    NewIndex->Count = 0;
+    Status          = LoadQueueIndexFromVariables (NewIndex);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "[%a] - failed to enumerate queue %g %r\n", __FUNCTION__, QueueGuid, Status));
+      FreeQueueIndex (NewIndex);
+      return Status;
+    }
+
+    WriteQueueMetadata (NewIndex);
+  }
+
+  *Index = NewIndex;
+  return EFI_SUCCESS;
+}
+
+/**
+  Discards every in memory queue index.
+**/
+VOID
+InternalQueueIndexFlush (
+  VOID
+  )
+{
+  while (!IsListEmpty (&mQueueIndexList)) {
+    FreeQueueIndex (QUEUE_INDEX_FROM_LINK (GetFirstNode (&mQueueIndexList)));
+  }
+}
+
+/**
+  Reads the data of a queue item.
+
+  If the item variable is missing the index is stale, so it is discarded and
+  rebuilt once before giving up.
+
+  @param[in]      QueueGuid                 The Identifier of the queue
+  @param[in]      ItemIndex                 Position in the queue, 0 is the front
+  @param[in, out] Index                     The index of the queue, may be rebuilt
+  @param[out]     ItemData                  Allocated item data, NULL to only look up the item
+  @param[out]     ItemDataSize              Size of the item data
+
+  @retval         EFI_SUCCESS               The item was found
+  @retval         EFI_NOT_FOUND             ItemIndex is past the end of the queue
+  @retval         Other                     The item could not be read
+*/
+STATIC
+EFI_STATUS
+ReadQueueItem (
+  IN      EFI_GUID     *QueueGuid,
+  IN      UINTN        ItemIndex,
+  IN OUT  QUEUE_INDEX  **Index,
+  OUT     VOID         **ItemData OPTIONAL,
+  OUT     UINTN        *ItemDataSize
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      VarName[] = DEFAULT_QUEUE_VAR_NAME;
+  VOID        *VariableData;
+  UINTN       VariableDataSize;
+  BOOLEAN     Retried;
+
+  Retried = FALSE;
+  while (TRUE) {
+    if (ItemIndex >= (*Index)->Count) {
+      return EFI_NOT_FOUND;
+    }
+
+    GenerateVarName ((*Index)->Ids[(*Index)->First + ItemIndex], VarName, sizeof (VarName));
+
+    // Step 1: figure out how big the variable is
+    VariableDataSize = 0;
+    Status           = gRT->GetVariable (VarName, QueueGuid, NULL, &VariableDataSize, NULL);
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      break;
+    }
+
+    if ((Status != EFI_NOT_FOUND) || Retried) {
+      DEBUG ((DEBUG_ERROR, "[%a] - failed to get size of variable data %r\n", __FUNCTION__, Status));
+      return EFI_ERROR (Status) ? Status : EFI_NOT_FOUND;
+    }
+
+    DEBUG ((DEBUG_WARN, "[%a] - queue index for %g is stale, rebuilding\n", __FUNCTION__, QueueGuid));
+    InvalidateQueueIndex (*Index);
+    Status = GetQueueIndex (QueueGuid, Index);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Retried = TRUE;
+  }
+
+  *ItemDataSize = VariableDataSize;
+  if (ItemData == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  // Step 2: allocate and read in the data
+  VariableData = AllocatePool (VariableDataSize);
+  if (VariableData == NULL) {
+    DEBUG ((DEBUG_ERROR, "[%a] - failed to allocate resources\n", __FUNCTION__));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gRT->GetVariable (VarName, QueueGuid, NULL, &VariableDataSize, VariableData);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "[%a] - failed to read variable data\n", __FUNCTION__));
+    FreePool (VariableData);
+    return Status;
+  }
+
+  *ItemData     = VariableData;
+  *ItemDataSize = VariableDataSize;
+  return EFI_SUCCESS;
+}
+
 /**
   Gets the number of items currently in the queue.
 
@@ -192,46 +663,29 @@ GetQueueItemCount (
   OUT UINTN     *ItemCount
   )
 {
-  EFI_STATUS  Status;
-  CHAR16      *VariableName;
-  UINTN       VariableNameSize;
-  UINTN       CurrenQueueCount;
-  EFI_GUID    VariableGuid;
+  EFI_STATUS   Status;
+  QUEUE_INDEX  *Index;
 
   if ((ItemCount == NULL) || (QueueGuid == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  VariableName     = NULL;
-  CurrenQueueCount = 0;
-  Status           = EFI_SUCCESS;
-
-  // look for all the capsule queue variables
-  while (Status == EFI_SUCCESS) {
-    Status = GetNextQueueVariableName (&VariableName, &VariableGuid, &VariableNameSize, QueueGuid);
-    if (!EFI_ERROR (Status)) {
-      CurrenQueueCount += 1;
-    }
-  }
-
-  // going all the way to the end of the varstore gives us a EFI_NOT_FOUND
-  if (Status == EFI_NOT_FOUND) {
-    Status = EFI_SUCCESS;
-  }
-
-  *ItemCount = CurrenQueueCount;
-
-  if (VariableName != NULL) {
-    FreePool (VariableName);
-    VariableName = NULL;
+  Status = GetQueueIndex (QueueGuid, &Index);
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
-  return Status;
+  *ItemCount = Index->Count;
+  return EFI_SUCCESS;
 }
 
 /**
   Adds an item to the back of the queue.
 
+  If the variable for the new item already exists the index is stale, for
+  example because another module added to the queue, so it is discarded and
+  rebuilt once before giving up.
+
   @param[in]  QueueGuid     The Identifier of the queue in question
   @param[in]  ItemData      A pointer to the data that should be added to the queue
   @param[in]  ItemDataSize  The size of the data that should be added
@@ -247,47 +701,52 @@ QueueAddItem (
   IN  UINTN     ItemDataSize
   )
 {
-  EFI_STATUS  Status;
-  CHAR16      *VariableName;
-  UINTN       VariableNameSize;
-  EFI_GUID    VariableGuid;
-  UINTN       VarCurrentId;
-  UINTN       VarMaxId;
-  CHAR16      NewVarName[] = DEFAULT_QUEUE_VAR_NAME;
+  EFI_STATUS   Status;
+  QUEUE_INDEX  *Index;
+  UINTN        VarMaxId;
+  CHAR16       NewVarName[] = DEFAULT_QUEUE_VAR_NAME;
+  BOOLEAN      Retried;
 
   if ((QueueGuid == NULL) || (ItemData == NULL)) {
     return EFI_INVALID_PARAMETER;
   }
 
-  VariableName = NULL;
-  Status       = EFI_SUCCESS;
-  VarMaxId     = 0;
-
   // Step 1: get the ID of the last item in the queue
-  while (Status == EFI_SUCCESS) {
-    Status = GetNextQueueVariableName (&VariableName, &VariableGuid, &VariableNameSize, QueueGuid);
-    if (Status == EFI_NOT_FOUND) {
-      Status = EFI_SUCCESS;
-      break;
+  Status = GetQueueIndex (QueueGuid, &Index);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Retried = FALSE;
+  while (TRUE) {
+    VarMaxId = 0;
+    if (Index->Count != 0) {
+      VarMaxId = Index->Ids[Index->First + Index->Count - 1];
     }
 
-    if (EFI_ERROR (Status)) {
+    // step 2: Add one to that and make sure it isn't already used
+    VarMaxId += 1;
+    if (VarMaxId >= DEFAULT_QUEUE_MODULO) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    if (!QueueItemExists (QueueGuid, VarMaxId)) {
       break;
     }
 
-    Status   = GetIdFromVarName (VariableName, VariableNameSize, &VarCurrentId);
-    VarMaxId = MAX (VarMaxId, VarCurrentId);
-  }
+    if (Retried) {
+      DEBUG ((DEBUG_ERROR, "[%a] - item %d of queue %g exists after rebuilding the index\n", __FUNCTION__, VarMaxId, QueueGuid));
+      return EFI_DEVICE_ERROR;
+    }
 
-  if (EFI_ERROR (Status)) {
-    goto Cleanup;
-  }
+    DEBUG ((DEBUG_WARN, "[%a] - queue index for %g is stale, rebuilding\n", __FUNCTION__, QueueGuid));
+    InvalidateQueueIndex (Index);
+    Status = GetQueueIndex (QueueGuid, &Index);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
 
-  // step 2: Add one to that and generate a new variable name
-  VarMaxId += 1;
-  if (VarMaxId >= DEFAULT_QUEUE_MODULO) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Cleanup;
+    Retried = TRUE;
   }
 
   Status = GenerateVarName (VarMaxId, NewVarName, sizeof (NewVarName));
@@ -303,14 +762,20 @@ QueueAddItem (
                   ItemDataSize,
                   ItemData
                   );
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
-Cleanup:
-  if (VariableName != NULL) {
-    FreePool (VariableName);
-    VariableName = NULL;
+  // step 4: update the index and metadata
+  Status = QueueIndexAppend (Index, (UINT32)VarMaxId);
+  if (EFI_ERROR (Status)) {
+    // The item is stored, so drop the index and let it be rebuilt
+    InvalidateQueueIndex (Index);
+    return EFI_SUCCESS;
   }
 
-  return Status;
+  WriteQueueMetadata (Index);
+  return EFI_SUCCESS;
 }
 
 /**
@@ -341,83 +806,35 @@ QueuePopItemAtIndex (
   OUT UINTN     *ItemDataSize OPTIONAL
   )
 {
-  EFI_STATUS  Status;
-  CHAR16      *VariableName;
-  UINTN       VariableNameSize;
-  EFI_GUID    VariableGuid;
-  UINTN       VariableDataSize;
-  VOID        *VariableData;
-  UINTN       QueueIndex;
+  EFI_STATUS   Status;
+  QUEUE_INDEX  *Index;
+  VOID         *VariableData;
+  UINTN        VariableDataSize;
+  CHAR16       VarName[] = DEFAULT_QUEUE_VAR_NAME;
+  BOOLEAN      ReturnData;
 
   if (QueueGuid == NULL) {
     return EFI_INVALID_PARAMETER;
   }
 
-  VariableName     = NULL;
-  Status           = EFI_SUCCESS;
-  VariableData     = NULL;
-  QueueIndex       = 0;
-  VariableDataSize = 0;
-
-  // Step 1: find the variable of the first item in the queue.
-  do {
-    Status = GetNextQueueVariableName (&VariableName, &VariableGuid, &VariableNameSize, QueueGuid);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "[%a] - failed to find next item in queue\n", __FUNCTION__));
-      goto Cleanup;
-    }
-
-    QueueIndex += 1;
-  } while (Status == EFI_SUCCESS && QueueIndex <= ItemIndex);
+  Status = GetQueueIndex (QueueGuid, &Index);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
 
+  // Step 1: find the variable of the item and read it if the caller wants the data
+  VariableData = NULL;
+  ReturnData   = (BOOLEAN)((ItemData != NULL) && (ItemDataSize != NULL));
+  Status       = ReadQueueItem (QueueGuid, ItemIndex, &Index, ReturnData ? &VariableData : NULL, &VariableDataSize);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "[%a] - failed to find the queue item at index %d\n", __FUNCTION__, ItemIndex));
-    goto Cleanup;
-  }
-
-  // if they passed in non null pointers, we should return the variable data
-  if ((ItemData != NULL) && (ItemDataSize != NULL)) {
-    // Step 2: figure out how big the variable is and allocate the data for it
-    Status = gRT->GetVariable (
-                    VariableName,
-                    QueueGuid,
-                    NULL,
-                    &VariableDataSize,
-                    NULL
-                    );
-    if (Status != EFI_BUFFER_TOO_SMALL) {
-      DEBUG ((DEBUG_ERROR, "[%a] - failed to get size of variable data\n", __FUNCTION__));
-      goto Cleanup;
-    }
-
-    VariableData = AllocatePool (VariableDataSize);
-    if (VariableData == NULL) {
-      DEBUG ((DEBUG_ERROR, "[%a] - failed to allocate resources\n", __FUNCTION__));
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Cleanup;
-    }
-
-    // step 3: read in the data to the new allocated buffer
-    Status = gRT->GetVariable (
-                    VariableName,
-                    QueueGuid,
-                    NULL,
-                    &VariableDataSize,
-                    VariableData
-                    );
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "[%a] - failed to read variable data\n", __FUNCTION__));
-      goto Cleanup;
-    }
-
-    // step 4: set the return pointer correctly
-    *ItemData     = VariableData;
-    *ItemDataSize = VariableDataSize;
+    return Status;
   }
 
-  // step 5: delete the variable
+  // step 2: delete the variable
+  GenerateVarName (Index->Ids[Index->First + ItemIndex], VarName, sizeof (VarName));
   Status = gRT->SetVariable (
-                  VariableName,
+                  VarName,
                   QueueGuid,
                   DEFAULT_QUEUE_VAR_ATTR,
                   0,
@@ -425,16 +842,23 @@ QueuePopItemAtIndex (
                   );
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "[%a] - failed to delete variable\n", __FUNCTION__));
-    goto Cleanup;
+    if (VariableData != NULL) {
+      FreePool (VariableData);
+    }
+
+    return Status;
   }
 
-Cleanup:
-  if (VariableName != NULL) {
-    FreePool (VariableName);
-    VariableName = NULL;
+  // step 3: update the index and metadata, then set the return pointer
+  QueueIndexRemove (Index, ItemIndex);
+  WriteQueueMetadata (Index);
+
+  if (ReturnData) {
+    *ItemData     = VariableData;
+    *ItemDataSize = VariableDataSize;
   }
 
-  return Status;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -488,13 +912,8 @@ QueuePeekAtIndex (
   OUT UINTN     *ItemDataSize
   )
 {
-  EFI_STATUS  Status;
-  CHAR16      *VariableName;
-  UINTN       VariableNameSize;
-  EFI_GUID    VariableGuid;
-  UINTN       VariableDataSize;
-  VOID        *VariableData;
-  UINTN       QueueIndex;
+  EFI_STATUS   Status;
+  QUEUE_INDEX  *Index;
 
   if (QueueGuid == NULL) {
     DEBUG ((DEBUG_ERROR, "[%a] - invalid parameter as QueueGuid is NULL\n", __FUNCTION__));
@@ -511,71 +930,14 @@ QueuePeekAtIndex (
     return EFI_INVALID_PARAMETER;
   }
 
-  // Step 1: find the variable name of the item at the specific index (if it exists)
-  VariableName     = NULL;
-  Status           = EFI_SUCCESS;
-  VariableData     = NULL;
-  QueueIndex       = 0;
-  VariableDataSize = 0;
-
-  do {
-    Status = GetNextQueueVariableName (&VariableName, &VariableGuid, &VariableNameSize, QueueGuid);
-
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "[%a] - failed to find next item in queue\n", __FUNCTION__));
-      goto Cleanup;
-    }
-
-    QueueIndex += 1;
-  } while (Status == EFI_SUCCESS && QueueIndex <= ItemIndex);
-
+  Status = GetQueueIndex (QueueGuid, &Index);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "[%a] - failed to find the queue item at index %d\n", __FUNCTION__, ItemIndex));
-    goto Cleanup;
-  }
-
-  // Step 2: figure out how big the variable is and allocate the data for it
-  Status = gRT->GetVariable (
-                  VariableName,
-                  QueueGuid,
-                  NULL,
-                  &VariableDataSize,
-                  NULL
-                  );
-  if (EFI_ERROR (Status) && (Status != EFI_BUFFER_TOO_SMALL)) {
-    DEBUG ((DEBUG_ERROR, "[%a] - failed to find variable\n", __FUNCTION__));
-    goto Cleanup;
-  }
-
-  VariableData = AllocatePool (VariableDataSize);
-  if (VariableData == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    DEBUG ((DEBUG_ERROR, "[%a] - failed to allocate resources\n", __FUNCTION__));
-    goto Cleanup;
+    return Status;
   }
 
-  // step 3: read in the data to the new allocated buffer
-  Status = gRT->GetVariable (
-                  VariableName,
-                  QueueGuid,
-                  NULL,
-                  &VariableDataSize,
-                  VariableData
-                  );
+  Status = ReadQueueItem (QueueGuid, ItemIndex, &Index, ItemData, ItemDataSize);
   if (EFI_ERROR (Status)) {
-    FreePool (VariableData);
-    DEBUG ((DEBUG_ERROR, "[%a] - failed to read in variable\n", __FUNCTION__));
-    goto Cleanup;
-  }
-
-  // step 4: set the return pointer correctly
-  *ItemData     = VariableData;
-  *ItemDataSize = VariableDataSize;
-
-Cleanup:
-  if (VariableName != NULL) {
-    FreePool (VariableName);
-    VariableName = NULL;
+    DEBUG ((DEBUG_ERROR, "[%a] - failed to find the queue item at index %d\n", __FUNCTION__, ItemIndex));
   }
 
   return Status;
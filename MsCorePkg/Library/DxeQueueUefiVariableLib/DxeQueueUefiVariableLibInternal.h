@@ -0,0 +1,67 @@
+/** @file
+  Internal definitions for DxeQueueUefiVariableLib.
+
+  Copyright (c) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef DXE_QUEUE_UEFI_VARIABLE_LIB_INTERNAL_H_
+#define DXE_QUEUE_UEFI_VARIABLE_LIB_INTERNAL_H_
+
+// TODO: should this be a PCD? So that it can be modified?
+#define DEFAULT_QUEUE_VAR_ATTR    (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS)
+#define DEFAULT_QUEUE_VAR_NAME    L"00000"
+#define DEFAULT_QUEUE_VAR_FORMAT  L"%d"
+#define DEFAULT_QUEUE_MODULO      100000
+
+//
+// Metadata for each queue is kept in a variable under gMuQueueMetadataVariableGuid
+// named after the queue GUID.  It lets the index be rebuilt on a later boot
+// without enumerating the whole variable store.
+//
+#define QUEUE_METADATA_VAR_ATTR     (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS)
+#define QUEUE_METADATA_VAR_FORMAT   L"%g"
+#define QUEUE_METADATA_NAME_LENGTH  36
+#define QUEUE_METADATA_SIGNATURE    SIGNATURE_32 ('Q', 'M', 'D', '1')
+
+#pragma pack(1)
+typedef struct {
+  UINT32    Signature;
+  UINT32    Count;        // Number of items in the queue
+  UINT32    HeadId;       // Id of the first item, 0 if the queue is empty
+  UINT32    TailId;       // Id of the last item, 0 if the queue is empty
+} QUEUE_METADATA;
+#pragma pack()
+
+//
+// In memory index of the item ids for one queue, kept in ascending order.
+// Ids[First] is the front of the queue.
+//
+#define QUEUE_INDEX_SIGNATURE  SIGNATURE_32 ('Q', 'I', 'D', 'X')
+#define QUEUE_INDEX_GROW       32
+
+typedef struct {
+  UINT32        Signature;
+  LIST_ENTRY    Link;
+  EFI_GUID      QueueGuid;
+  UINT32        *Ids;
+  UINTN         First;
+  UINTN         Count;
+  UINTN         Capacity;
+} QUEUE_INDEX;
+
+#define QUEUE_INDEX_FROM_LINK(a)  CR (a, QUEUE_INDEX, Link, QUEUE_INDEX_SIGNATURE)
+
+/**
+  Discards every in memory queue index.
+
+  The next queue operation rebuilds its index from the metadata variable,
+  or by enumerating the variable store if the metadata is missing or stale.
+**/
+VOID
+InternalQueueIndexFlush (
+  VOID
+  );
+
+#endif
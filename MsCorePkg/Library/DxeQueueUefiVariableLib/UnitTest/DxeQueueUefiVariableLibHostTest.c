@@ -0,0 +1,693 @@
+/** @file
+  Host based unit tests for DxeQueueUefiVariableLib.
+
+  The runtime services are backed by a small in memory variable store that
+  counts calls, so the tests can check how often the store is enumerated.
+
+  Copyright (c) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/QueueLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../DxeQueueUefiVariableLibInternal.h"
+
+#define UNIT_TEST_NAME     "DxeQueueUefiVariableLib Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define MAX_FAKE_VARIABLES     1024
+#define MAX_FAKE_NAME_LENGTH   64
+#define UNRELATED_VARIABLES    40
+#define BENCHMARK_VARIABLES    400
+#define BENCHMARK_QUEUE_ITEMS  100
+
+typedef struct {
+  EFI_GUID    Guid;
+  CHAR16      Name[MAX_FAKE_NAME_LENGTH];
+  UINT32      Attributes;
+  UINT8       *Data;
+  UINTN       DataSize;
+} FAKE_VARIABLE;
+
+//
+// Variables are kept in the order they were created, like a real store.
+//
+STATIC FAKE_VARIABLE  mVariables[MAX_FAKE_VARIABLES];
+STATIC UINTN          mVariableCount;
+
+STATIC UINTN  mGetNextVariableNameCalls;
+STATIC UINTN  mGetVariableCalls;
+STATIC UINTN  mSetVariableCalls;
+
+STATIC EFI_GUID  mTestQueueGuid  = {
+  0x4b7a0e32, 0x1c9d, 0x4f8e, { 0xa3, 0x51, 0x6d, 0x2e, 0x90, 0x7c, 0x15, 0xb8 }
+};
+STATIC EFI_GUID  mOtherQueueGuid = {
+  0x9e15c6d4, 0x73a0, 0x4b2c, { 0x88, 0x0f, 0x5a, 0xe4, 0x21, 0xd9, 0x6b, 0x37 }
+};
+STATIC EFI_GUID  mUnrelatedGuid  = {
+  0x2d8f5b61, 0xe04c, 0x47a9, { 0xb6, 0x13, 0x0c, 0x7e, 0x58, 0xa2, 0xf4, 0x9d }
+};
+
+/**
+  Finds a variable in the fake store.
+
+  @retval   The position of the variable, or MAX_FAKE_VARIABLES if not found.
+**/
+STATIC
+UINTN
+FindFakeVariable (
+  IN CONST CHAR16    *Name,
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINTN  i;
+
+  for (i = 0; i < mVariableCount; i++) {
+    if (CompareGuid (&mVariables[i].Guid, Guid) && (StrCmp (mVariables[i].Name, Name) == 0)) {
+      return i;
+    }
+  }
+
+  return MAX_FAKE_VARIABLES;
+}
+
+/**
+  Mocked version of GetVariable.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+FakeGetVariable (
+  IN     CHAR16    *VariableName,
+  IN     EFI_GUID  *VendorGuid,
+  OUT    UINT32    *Attributes OPTIONAL,
+  IN OUT UINTN     *DataSize,
+  OUT    VOID      *Data OPTIONAL
+  )
+{
+  UINTN  Pos;
+
+  mGetVariableCalls++;
+  Pos = FindFakeVariable (VariableName, VendorGuid);
+  if (Pos == MAX_FAKE_VARIABLES) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (Attributes != NULL) {
+    *Attributes = mVariables[Pos].Attributes;
+  }
+
+  if ((*DataSize < mVariables[Pos].DataSize) || (Data == NULL)) {
+    *DataSize = mVariables[Pos].DataSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *DataSize = mVariables[Pos].DataSize;
+  CopyMem (Data, mVariables[Pos].Data, mVariables[Pos].DataSize);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mocked version of GetNextVariableName.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+FakeGetNextVariableName (
+  IN OUT UINTN     *VariableNameSize,
+  IN OUT CHAR16    *VariableName,
+  IN OUT EFI_GUID  *VendorGuid
+  )
+{
+  UINTN  Pos;
+  UINTN  Size;
+
+  mGetNextVariableNameCalls++;
+  if (VariableName[0] == L'\0') {
+    Pos = 0;
+  } else {
+    Pos = FindFakeVariable (VariableName, VendorGuid);
+    if (Pos == MAX_FAKE_VARIABLES) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Pos++;
+  }
+
+  if (Pos >= mVariableCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  Size = StrSize (mVariables[Pos].Name);
+  if (*VariableNameSize < Size) {
+    *VariableNameSize = Size;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *VariableNameSize = Size;
+  CopyMem (VariableName, mVariables[Pos].Name, Size);
+  CopyGuid (VendorGuid, &mVariables[Pos].Guid);
+  return EFI_SUCCESS;
+}
+
+/**
+  Mocked version of SetVariable.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+FakeSetVariable (
+  IN CHAR16    *VariableName,
+  IN EFI_GUID  *VendorGuid,
+  IN UINT32    Attributes,
+  IN UINTN     DataSize,
+  IN VOID      *Data
+  )
+{
+  UINTN  Pos;
+
+  mSetVariableCalls++;
+  Pos = FindFakeVariable (VariableName, VendorGuid);
+  if (DataSize == 0) {
+    if (Pos == MAX_FAKE_VARIABLES) {
+      return EFI_NOT_FOUND;
+    }
+
+    FreePool (mVariables[Pos].Data);
+    CopyMem (&mVariables[Pos], &mVariables[Pos + 1], (mVariableCount - Pos - 1) * sizeof (FAKE_VARIABLE));
+    mVariableCount--;
+    return EFI_SUCCESS;
+  }
+
+  if (Pos == MAX_FAKE_VARIABLES) {
+    if ((mVariableCount == MAX_FAKE_VARIABLES) || (StrSize (VariableName) > sizeof (mVariables[0].Name))) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Pos = mVariableCount++;
+    CopyGuid (&mVariables[Pos].Guid, VendorGuid);
+    StrCpyS (mVariables[Pos].Name, MAX_FAKE_NAME_LENGTH, VariableName);
+  } else {
+    FreePool (mVariables[Pos].Data);
+  }
+
+  mVariables[Pos].Attributes = Attributes;
+  mVariables[Pos].Data       = AllocateCopyPool (DataSize, Data);
+  mVariables[Pos].DataSize   = DataSize;
+  return EFI_SUCCESS;
+}
+
+EFI_RUNTIME_SERVICES  mMockRuntime = {
+  .GetVariable         = FakeGetVariable,
+  .GetNextVariableName = FakeGetNextVariableName,
+  .SetVariable         = FakeSetVariable,
+};
+
+/**
+  Clears the call counters.
+**/
+STATIC
+VOID
+ResetCounters (
+  VOID
+  )
+{
+  mGetNextVariableNameCalls = 0;
+  mGetVariableCalls         = 0;
+  mSetVariableCalls         = 0;
+}
+
+/**
+  Empties the fake store, adds some variables that are not part of any queue
+  and discards the library's index, as if the system had just booted with a
+  fresh variable store.
+**/
+STATIC
+VOID
+ResetStore (
+  IN UINTN  UnrelatedCount
+  )
+{
+  UINTN   i;
+  CHAR16  Name[MAX_FAKE_NAME_LENGTH];
+
+  for (i = 0; i < mVariableCount; i++) {
+    FreePool (mVariables[i].Data);
+  }
+
+  mVariableCount = 0;
+  for (i = 0; i < UnrelatedCount; i++) {
+    UnicodeSPrint (Name, sizeof (Name), L"Unrelated%d", i);
+    FakeSetVariable (Name, &mUnrelatedGuid, EFI_VARIABLE_BOOTSERVICE_ACCESS, sizeof (i), &i);
+  }
+
+  InternalQueueIndexFlush ();
+  ResetCounters ();
+}
+
+/**
+  Writes or deletes a queue item directly, behind the library's back.
+**/
+STATIC
+EFI_STATUS
+SetItemDirect (
+  IN EFI_GUID  *QueueGuid,
+  IN UINTN     VarId,
+  IN UINT32    *Value OPTIONAL
+  )
+{
+  CHAR16  Name[MAX_FAKE_NAME_LENGTH];
+
+  UnicodeSPrint (Name, sizeof (Name), DEFAULT_QUEUE_VAR_FORMAT, VarId);
+  return FakeSetVariable (Name, QueueGuid, DEFAULT_QUEUE_VAR_ATTR, (Value == NULL) ? 0 : sizeof (*Value), Value);
+}
+
+/**
+  Adds the values First through Last to the queue.
+**/
+STATIC
+UNIT_TEST_STATUS
+AddItems (
+  IN EFI_GUID  *QueueGuid,
+  IN UINT32    First,
+  IN UINT32    Last
+  )
+{
+  UINT32  Value;
+
+  for (Value = First; Value <= Last; Value++) {
+    UT_ASSERT_NOT_EFI_ERROR (QueueAddItem (QueueGuid, &Value, sizeof (Value)));
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Pops an item and checks its value.
+**/
+STATIC
+UNIT_TEST_STATUS
+PopAndCheck (
+  IN EFI_GUID  *QueueGuid,
+  IN UINTN     ItemIndex,
+  IN UINT32    Expected
+  )
+{
+  VOID   *Data;
+  UINTN  DataSize;
+
+  Data = NULL;
+  UT_ASSERT_NOT_EFI_ERROR (QueuePopItemAtIndex (QueueGuid, ItemIndex, &Data, &DataSize));
+  UT_ASSERT_NOT_NULL (Data);
+  UT_ASSERT_EQUAL (DataSize, sizeof (UINT32));
+  UT_ASSERT_EQUAL (*(UINT32 *)Data, Expected);
+  FreePool (Data);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks the number of items in the queue.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckCount (
+  IN EFI_GUID  *QueueGuid,
+  IN UINTN     Expected
+  )
+{
+  UINTN  Count;
+
+  UT_ASSERT_NOT_EFI_ERROR (GetQueueItemCount (QueueGuid, &Count));
+  UT_ASSERT_EQUAL (Count, Expected);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Items come out in the order they went in and the store is only enumerated
+  once, the first time the queue is used.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+QueueFifoEnumeratesOnce (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID    *Data;
+  UINTN   DataSize;
+  UINT32  Value;
+
+  ResetStore (UNRELATED_VARIABLES);
+
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 0), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (mGetNextVariableNameCalls, UNRELATED_VARIABLES + 1);
+
+  ResetCounters ();
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 1, 10), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 10), UNIT_TEST_PASSED);
+
+  UT_ASSERT_NOT_EFI_ERROR (QueuePeekAtIndex (&mTestQueueGuid, 3, &Data, &DataSize));
+  UT_ASSERT_EQUAL (*(UINT32 *)Data, 4);
+  FreePool (Data);
+
+  for (Value = 1; Value <= 10; Value++) {
+    UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, Value), UNIT_TEST_PASSED);
+  }
+
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 0), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (mGetNextVariableNameCalls, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  After a reboot the index is rebuilt from the metadata variable without
+  enumerating the store.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+QueueRestartUsesMetadata (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ResetStore (UNRELATED_VARIABLES);
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 1, 5), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 1), UNIT_TEST_PASSED);
+
+  InternalQueueIndexFlush ();
+  ResetCounters ();
+
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 4), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 2), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 6, 6), UNIT_TEST_PASSED);
+
+  InternalQueueIndexFlush ();
+
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 3), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 4), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 5), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 6), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 0), UNIT_TEST_PASSED);
+
+  // The empty queue is also described by the metadata
+  InternalQueueIndexFlush ();
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 0), UNIT_TEST_PASSED);
+
+  UT_ASSERT_EQUAL (mGetNextVariableNameCalls, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Metadata that doesn't match the items in the store is ignored and the
+  store is enumerated instead.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+QueueStaleMetadata (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  Value;
+
+  // An item added without updating the metadata
+  ResetStore (UNRELATED_VARIABLES);
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 1, 3), UNIT_TEST_PASSED);
+  Value = 4;
+  UT_ASSERT_NOT_EFI_ERROR (SetItemDirect (&mTestQueueGuid, 4, &Value));
+  InternalQueueIndexFlush ();
+  ResetCounters ();
+
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 4), UNIT_TEST_PASSED);
+  UT_ASSERT_TRUE (mGetNextVariableNameCalls > 0);
+
+  // The first item removed without updating the metadata
+  UT_ASSERT_NOT_EFI_ERROR (SetItemDirect (&mTestQueueGuid, 1, NULL));
+  InternalQueueIndexFlush ();
+  ResetCounters ();
+
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 3), UNIT_TEST_PASSED);
+  UT_ASSERT_TRUE (mGetNextVariableNameCalls > 0);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 2), UNIT_TEST_PASSED);
+
+  // The rebuilt metadata is good again
+  InternalQueueIndexFlush ();
+  ResetCounters ();
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 2), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (mGetNextVariableNameCalls, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Popping from the middle of the queue leaves a gap in the ids, which the
+  head/tail metadata can't describe, so the next boot enumerates.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+QueuePopAtIndexGap (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ResetStore (UNRELATED_VARIABLES);
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 1, 5), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 2, 3), UNIT_TEST_PASSED);
+
+  // Pop without returning the data
+  UT_ASSERT_NOT_EFI_ERROR (QueuePopItemAtIndex (&mTestQueueGuid, 3, NULL, NULL));
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 3), UNIT_TEST_PASSED);
+
+  InternalQueueIndexFlush ();
+  ResetCounters ();
+
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 3), UNIT_TEST_PASSED);
+  UT_ASSERT_TRUE (mGetNextVariableNameCalls > 0);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 1), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 2), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 4), UNIT_TEST_PASSED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  An item removed behind the library's back during the same boot is noticed
+  when it is read and the index is rebuilt.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+QueueStaleIndex (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID   *Data;
+  UINTN  DataSize;
+
+  ResetStore (UNRELATED_VARIABLES);
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 1, 3), UNIT_TEST_PASSED);
+  UT_ASSERT_NOT_EFI_ERROR (SetItemDirect (&mTestQueueGuid, 2, NULL));
+
+  UT_ASSERT_NOT_EFI_ERROR (QueuePeekAtIndex (&mTestQueueGuid, 1, &Data, &DataSize));
+  UT_ASSERT_EQUAL (*(UINT32 *)Data, 3);
+  FreePool (Data);
+
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 2), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 1, 3), UNIT_TEST_PASSED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Another module with its own index adds to the same queue.  The stale index
+  is noticed before the other module's item is overwritten and is rebuilt.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+QueueAddWithStaleIndex (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  Value;
+
+  ResetStore (UNRELATED_VARIABLES);
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 1, 2), UNIT_TEST_PASSED);
+
+  // The other module's index also ends at item 2, so it adds item 3
+  Value = 3;
+  UT_ASSERT_NOT_EFI_ERROR (SetItemDirect (&mTestQueueGuid, 3, &Value));
+  ResetCounters ();
+
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 4, 4), UNIT_TEST_PASSED);
+  UT_ASSERT_TRUE (mGetNextVariableNameCalls > 0);
+
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 4), UNIT_TEST_PASSED);
+  for (Value = 1; Value <= 4; Value++) {
+    UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, Value), UNIT_TEST_PASSED);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Empty queues, out of range indexes and independent queues.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+QueueEdgeCases (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VOID    *Data;
+  UINTN   DataSize;
+  UINT32  Value;
+
+  ResetStore (UNRELATED_VARIABLES);
+
+  UT_ASSERT_STATUS_EQUAL (QueuePopItem (&mTestQueueGuid, &Data, &DataSize), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (QueuePeekAtIndex (&mTestQueueGuid, 0, &Data, &DataSize), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (QueuePeekAtIndex (NULL, 0, &Data, &DataSize), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (GetQueueItemCount (&mTestQueueGuid, NULL), EFI_INVALID_PARAMETER);
+
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 1, 2), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (AddItems (&mOtherQueueGuid, 100, 102), UNIT_TEST_PASSED);
+  UT_ASSERT_STATUS_EQUAL (QueuePeekAtIndex (&mTestQueueGuid, 2, &Data, &DataSize), EFI_NOT_FOUND);
+  UT_ASSERT_EQUAL (CheckCount (&mTestQueueGuid, 2), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (CheckCount (&mOtherQueueGuid, 3), UNIT_TEST_PASSED);
+
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 1), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, 2), UNIT_TEST_PASSED);
+  UT_ASSERT_EQUAL (PopAndCheck (&mOtherQueueGuid, 0, 100), UNIT_TEST_PASSED);
+
+  // Ids start over once a queue is empty
+  Value = 7;
+  UT_ASSERT_NOT_EFI_ERROR (QueueAddItem (&mTestQueueGuid, &Value, sizeof (Value)));
+  DataSize = sizeof (Value);
+  UT_ASSERT_NOT_EFI_ERROR (FakeGetVariable (L"1", &mTestQueueGuid, NULL, &DataSize, &Value));
+  UT_ASSERT_EQUAL (Value, 7);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Drains a queue in a store with many other variables and logs the number of
+  runtime service calls.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+QueueDrainCost (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  Value;
+
+  ResetStore (BENCHMARK_VARIABLES);
+  UT_ASSERT_EQUAL (AddItems (&mTestQueueGuid, 1, BENCHMARK_QUEUE_ITEMS), UNIT_TEST_PASSED);
+  UT_LOG_INFO (
+    "Add %d: GetNextVariableName %d, GetVariable %d, SetVariable %d\n",
+    BENCHMARK_QUEUE_ITEMS,
+    mGetNextVariableNameCalls,
+    mGetVariableCalls,
+    mSetVariableCalls
+    );
+  UT_ASSERT_EQUAL (mGetNextVariableNameCalls, BENCHMARK_VARIABLES + 1);
+
+  InternalQueueIndexFlush ();
+  ResetCounters ();
+  for (Value = 1; Value <= BENCHMARK_QUEUE_ITEMS; Value++) {
+    UT_ASSERT_EQUAL (PopAndCheck (&mTestQueueGuid, 0, Value), UNIT_TEST_PASSED);
+  }
+
+  UT_LOG_INFO (
+    "Drain %d after reboot: GetNextVariableName %d, GetVariable %d, SetVariable %d\n",
+    BENCHMARK_QUEUE_ITEMS,
+    mGetNextVariableNameCalls,
+    mGetVariableCalls,
+    mSetVariableCalls
+    );
+  UT_ASSERT_EQUAL (mGetNextVariableNameCalls, 0);
+  UT_ASSERT_EQUAL (mGetVariableCalls, (BENCHMARK_QUEUE_ITEMS * 2) + 4);
+
+  ResetStore (0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UefiTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      TestSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&TestSuite, Framework, "Queue Variable Index", "QueueLib.Index", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for TestSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (TestSuite, "Items are first in first out and the store is enumerated once", "Fifo", QueueFifoEnumeratesOnce, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Metadata avoids enumeration after a reboot", "Metadata", QueueRestartUsesMetadata, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Stale metadata falls back to enumeration", "StaleMetadata", QueueStaleMetadata, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Popping from the middle of the queue", "PopAtIndex", QueuePopAtIndexGap, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Stale index is rebuilt", "StaleIndex", QueueStaleIndex, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Adding with a stale index doesn't overwrite an item", "StaleIndexAdd", QueueAddWithStaleIndex, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Empty queues and bad parameters", "EdgeCases", QueueEdgeCases, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Runtime service calls to drain a queue", "DrainCost", QueueDrainCost, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UefiTestMain ();
+}
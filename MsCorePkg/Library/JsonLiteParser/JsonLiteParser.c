@@ -11,68 +11,752 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Uefi.h>
 
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/JsonLiteParser.h>
 #include <Library/MemoryAllocationLib.h>
 
 //
-//  MACRO to Skip all characters up to the next ". Stop
-//  on a NULL character.
+// Tokenizer states
 //
-#define SKIP_TO_NEXT_QUOTE(a) \
-    while (('\"' != *a) &&    \
-           ('\0' != *a)) {    \
-        a++;                  \
+#define JSON_STATE_VALUE        0   // expecting a value
+#define JSON_STATE_FIRST_NAME   1   // just after '{', expecting a name or '}'
+#define JSON_STATE_NAME         2   // just after ',' in an object, expecting a name
+#define JSON_STATE_FIRST_VALUE  3   // just after '[', expecting a value or ']'
+#define JSON_STATE_NEXT         4   // after a value in a container, expecting ',' or the end
+#define JSON_STATE_DONE         5   // top level value complete
+
+#define IS_JSON_WHITE_SPACE(a)  (((a) == ' ') || ((a) == '\t') || ((a) == '\n') || ((a) == '\r'))
+#define IS_JSON_DIGIT(a)        (((a) >= '0') && ((a) <= '9'))
+
+/**
+  Move the tokenizer past any white space.
+**/
+STATIC
+VOID
+SkipWhiteSpace (
+  IN OUT JSON_TOKENIZER  *Tokenizer
+  )
+{
+  while ((Tokenizer->Offset < Tokenizer->Length) && IS_JSON_WHITE_SPACE (Tokenizer->Json[Tokenizer->Offset])) {
+    Tokenizer->Offset++;
+  }
+}
+
+/**
+  Return TRUE if the innermost open container is an array.
+**/
+STATIC
+BOOLEAN
+InArray (
+  IN JSON_TOKENIZER  *Tokenizer
+  )
+{
+  return (BOOLEAN)(((RShiftU64 (Tokenizer->ArrayMask, Tokenizer->Depth - 1)) & 1) != 0);
+}
+
+/**
+  Set the state that follows a complete value.
+**/
+STATIC
+VOID
+ValueComplete (
+  IN OUT JSON_TOKENIZER  *Tokenizer
+  )
+{
+  Tokenizer->State = (Tokenizer->Depth == 0) ? JSON_STATE_DONE : JSON_STATE_NEXT;
+}
+
+/**
+  Return the value of a hex digit or 0xFF if Char is not a hex digit.
+**/
+STATIC
+UINT8
+HexValue (
+  IN CHAR8  Char
+  )
+{
+  if (IS_JSON_DIGIT (Char)) {
+    return (UINT8)(Char - '0');
+  }
+
+  if ((Char >= 'a') && (Char <= 'f')) {
+    return (UINT8)(Char - 'a' + 10);
+  }
+
+  if ((Char >= 'A') && (Char <= 'F')) {
+    return (UINT8)(Char - 'A' + 10);
+  }
+
+  return 0xFF;
+}
+
+/**
+  Read the 4 hex digits of a \u escape.
+
+  @retval TRUE    CodeUnit is valid
+  @retval FALSE   Not 4 hex digits
+**/
+STATIC
+BOOLEAN
+ReadHex4 (
+  IN  CONST CHAR8  *Text,
+  OUT UINT32       *CodeUnit
+  )
+{
+  UINTN  i;
+  UINT8  Digit;
+
+  *CodeUnit = 0;
+  for (i = 0; i < 4; i++) {
+    Digit = HexValue (Text[i]);
+    if (Digit == 0xFF) {
+      return FALSE;
     }
 
-//
-//  MACRO to Skip blanks, tabs, \r, and \n characters.
-//
-#define SKIP_WHITE_SPACE(a) \
-    while ((' '  == *a) ||  \
-           ('\t' == *a) ||  \
-           ('\n' == *a) ||  \
-           ('\r' == *a)) {  \
-        a++;                \
+    *CodeUnit = (*CodeUnit << 4) | Digit;
+  }
+
+  return TRUE;
+}
+
+/**
+  Tokenize the quoted string at the current offset.  Escape sequences are
+  validated but not decoded.
+**/
+STATIC
+EFI_STATUS
+ReadString (
+  IN OUT JSON_TOKENIZER  *Tokenizer,
+  OUT    JSON_TOKEN      *Token
+  )
+{
+  CONST CHAR8  *Json;
+  UINTN        i;
+  UINT32       CodeUnit;
+
+  Json = Tokenizer->Json;
+  if ((Tokenizer->Offset >= Tokenizer->Length) || (Json[Tokenizer->Offset] != '\"')) {
+    DEBUG ((DEBUG_INFO, "%a - Expected a quote at offset %d\n", __FUNCTION__, Tokenizer->Offset));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (i = Tokenizer->Offset + 1; i < Tokenizer->Length; i++) {
+    if (Json[i] == '\"') {
+      break;
+    }
+
+    if (Json[i] == '\0') {
+      break;
     }
 
+    if (Json[i] == '\\') {
+      Token->HasEscapes = TRUE;
+      i++;
+      if (i >= Tokenizer->Length) {
+        break;
+      }
+
+      switch (Json[i]) {
+        case '\"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+          break;
+
+        case 'u':
+          if ((i + 4 >= Tokenizer->Length) || !ReadHex4 (&Json[i + 1], &CodeUnit)) {
+            DEBUG ((DEBUG_INFO, "%a - Invalid \\u escape at offset %d\n", __FUNCTION__, i));
+            return EFI_INVALID_PARAMETER;
+          }
+
+          i += 4;
+          break;
+
+        default:
+          DEBUG ((DEBUG_INFO, "%a - Invalid escape at offset %d\n", __FUNCTION__, i));
+          return EFI_INVALID_PARAMETER;
+      }
+    }
+  }
+
+  if ((i >= Tokenizer->Length) || (Json[i] != '\"')) {
+    DEBUG ((DEBUG_INFO, "%a - String did not end with a quote\n", __FUNCTION__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Token->Text       = &Json[Tokenizer->Offset + 1];
+  Token->Length     = i - Tokenizer->Offset - 1;
+  Tokenizer->Offset = i + 1;
+  return EFI_SUCCESS;
+}
+
 /**
-  LocalAsciiStrCat
+  Tokenize the number at the current offset.  Leading zeros are allowed.
+**/
+STATIC
+EFI_STATUS
+ReadNumber (
+  IN OUT JSON_TOKENIZER  *Tokenizer,
+  OUT    JSON_TOKEN      *Token
+  )
+{
+  CONST CHAR8  *Json;
+  UINTN        i;
+  UINTN        Digits;
 
-  Similar to AsciiStrCatS, but the source string is a count of characters with no NULL
+  Json = Tokenizer->Json;
+  i    = Tokenizer->Offset;
+  if (Json[i] == '-') {
+    i++;
+  }
+
+  for (Digits = 0; (i < Tokenizer->Length) && IS_JSON_DIGIT (Json[i]); i++, Digits++) {
+  }
+
+  if (Digits == 0) {
+    goto INVALID;
+  }
+
+  if ((i < Tokenizer->Length) && (Json[i] == '.')) {
+    for (i++, Digits = 0; (i < Tokenizer->Length) && IS_JSON_DIGIT (Json[i]); i++, Digits++) {
+    }
+
+    if (Digits == 0) {
+      goto INVALID;
+    }
+  }
+
+  if ((i < Tokenizer->Length) && ((Json[i] == 'e') || (Json[i] == 'E'))) {
+    i++;
+    if ((i < Tokenizer->Length) && ((Json[i] == '+') || (Json[i] == '-'))) {
+      i++;
+    }
+
+    for (Digits = 0; (i < Tokenizer->Length) && IS_JSON_DIGIT (Json[i]); i++, Digits++) {
+    }
+
+    if (Digits == 0) {
+      goto INVALID;
+    }
+  }
+
+  Token->Type       = JsonTokenNumber;
+  Token->Text       = &Json[Tokenizer->Offset];
+  Token->Length     = i - Tokenizer->Offset;
+  Tokenizer->Offset = i;
+  return EFI_SUCCESS;
+
+INVALID:
+  DEBUG ((DEBUG_INFO, "%a - Invalid number at offset %d\n", __FUNCTION__, Tokenizer->Offset));
+  return EFI_INVALID_PARAMETER;
+}
+
+/**
+  Tokenize the literal at the current offset if it matches.
+**/
+STATIC
+BOOLEAN
+ReadLiteral (
+  IN OUT JSON_TOKENIZER   *Tokenizer,
+  OUT    JSON_TOKEN       *Token,
+  IN     CONST CHAR8      *Literal,
+  IN     UINTN            LiteralLength,
+  IN     JSON_TOKEN_TYPE  Type
+  )
+{
+  if ((Tokenizer->Length - Tokenizer->Offset < LiteralLength) ||
+      (CompareMem (&Tokenizer->Json[Tokenizer->Offset], Literal, LiteralLength) != 0))
+  {
+    return FALSE;
+  }
+
+  Token->Type        = Type;
+  Token->Text        = &Tokenizer->Json[Tokenizer->Offset];
+  Token->Length      = LiteralLength;
+  Tokenizer->Offset += LiteralLength;
+  return TRUE;
+}
+
+/**
+  Tokenize the value at the current offset.
+**/
+STATIC
+EFI_STATUS
+ReadValue (
+  IN OUT JSON_TOKENIZER  *Tokenizer,
+  OUT    JSON_TOKEN      *Token
+  )
+{
+  EFI_STATUS  Status;
+  CHAR8       Char;
+
+  if (Tokenizer->Offset >= Tokenizer->Length) {
+    DEBUG ((DEBUG_INFO, "%a - End of string when a value was expected\n", __FUNCTION__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Char = Tokenizer->Json[Tokenizer->Offset];
+  switch (Char) {
+    case '{':
+    case '[':
+      if (Tokenizer->Depth >= Tokenizer->MaxDepth) {
+        DEBUG ((DEBUG_ERROR, "%a - Json nested more than %d deep\n", __FUNCTION__, Tokenizer->MaxDepth));
+        return EFI_BAD_BUFFER_SIZE;
+      }
+
+      if (Char == '[') {
+        Token->Type           = JsonTokenArrayStart;
+        Tokenizer->ArrayMask |= LShiftU64 (1, Tokenizer->Depth);
+        Tokenizer->State      = JSON_STATE_FIRST_VALUE;
+      } else {
+        Token->Type           = JsonTokenObjectStart;
+        Tokenizer->ArrayMask &= ~LShiftU64 (1, Tokenizer->Depth);
+        Tokenizer->State      = JSON_STATE_FIRST_NAME;
+      }
+
+      Token->Text   = &Tokenizer->Json[Tokenizer->Offset];
+      Token->Length = 1;
+      Tokenizer->Offset++;
+      Tokenizer->Depth++;
+      return EFI_SUCCESS;
+
+    case '\"':
+      Token->Type = JsonTokenString;
+      Status      = ReadString (Tokenizer, Token);
+      break;
+
+    case 't':
+      Status = ReadLiteral (Tokenizer, Token, "true", 4, JsonTokenTrue) ? EFI_SUCCESS : EFI_INVALID_PARAMETER;
+      break;
+
+    case 'f':
+      Status = ReadLiteral (Tokenizer, Token, "false", 5, JsonTokenFalse) ? EFI_SUCCESS : EFI_INVALID_PARAMETER;
+      break;
+
+    case 'n':
+      Status = ReadLiteral (Tokenizer, Token, JSON_NULL, 4, JsonTokenNull) ? EFI_SUCCESS : EFI_INVALID_PARAMETER;
+      break;
+
+    default:
+      if ((Char == '-') || IS_JSON_DIGIT (Char)) {
+        Status = ReadNumber (Tokenizer, Token);
+      } else {
+        Status = EFI_INVALID_PARAMETER;
+      }
+
+      break;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "%a - Invalid value at offset %d\n", __FUNCTION__, Tokenizer->Offset));
+    return Status;
+  }
+
+  ValueComplete (Tokenizer);
+  return EFI_SUCCESS;
+}
+
+/**
+  Close the innermost container.
 **/
 STATIC
+VOID
+CloseContainer (
+  IN OUT JSON_TOKENIZER  *Tokenizer,
+  OUT    JSON_TOKEN      *Token,
+  IN     JSON_TOKEN_TYPE  Type
+  )
+{
+  Tokenizer->Depth--;
+  Token->Type   = Type;
+  Token->Text   = &Tokenizer->Json[Tokenizer->Offset];
+  Token->Length = 1;
+  Token->Depth  = Tokenizer->Depth;
+  Tokenizer->Offset++;
+  ValueComplete (Tokenizer);
+}
+
+/**
+ * JsonTokenizerInit
+ *
+ * @param[out] Tokenizer        Tokenizer to initialize
+ * @param[in]  JsonString       Json text.  Does not need to be NULL terminated.
+ * @param[in]  JsonStringLength Number of characters in JsonString
+ * @param[in]  MaxDepth         Max nesting allowed.  0 for JSON_MAX_DEPTH.
+ *
+ * JsonString must remain valid while the tokenizer and its tokens are in use.
+ *
+ * returns    EFI_STATUS    EFI_SUCCESS           - Tokenizer is ready
+ *                          EFI_INVALID_PARAMETER - NULL pointer or MaxDepth > JSON_MAX_DEPTH
+ **/
 EFI_STATUS
-LocalAsciiStrCatS (
-  CHAR8        *Dest,
-  UINTN        DestMax,
-  CONST CHAR8  *Src,
-  UINTN        Count
+EFIAPI
+JsonTokenizerInit (
+  OUT JSON_TOKENIZER  *Tokenizer,
+  IN  CONST CHAR8     *JsonString,
+  IN  UINTN           JsonStringLength,
+  IN  UINTN           MaxDepth
   )
 {
-  while ((*Dest != '\0') && (DestMax > 0)) {
-    Dest++;
-    DestMax--;
+  if ((NULL == Tokenizer) || (NULL == JsonString) || (MaxDepth > JSON_MAX_DEPTH)) {
+    return EFI_INVALID_PARAMETER;
   }
 
-  if (Count > DestMax) {
-    return EFI_BUFFER_TOO_SMALL;
+  ZeroMem (Tokenizer, sizeof (*Tokenizer));
+  Tokenizer->Json     = JsonString;
+  Tokenizer->Length   = JsonStringLength;
+  Tokenizer->MaxDepth = (MaxDepth == 0) ? JSON_MAX_DEPTH : MaxDepth;
+  Tokenizer->State    = JSON_STATE_VALUE;
+  return EFI_SUCCESS;
+}
+
+/**
+ * JsonNextToken
+ *
+ * @param[in, out] Tokenizer    Tokenizer from JsonTokenizerInit
+ * @param[out]     Token        Next token in the document
+ *
+ * Once JsonTokenEnd has been returned every later call returns it again.
+ *
+ * returns    EFI_STATUS    EFI_SUCCESS           - Token is valid
+ *                          EFI_INVALID_PARAMETER - NULL pointer or the Json is malformed
+ *                          EFI_BAD_BUFFER_SIZE   - Nesting exceeds the depth limit
+ **/
+EFI_STATUS
+EFIAPI
+JsonNextToken (
+  IN OUT JSON_TOKENIZER  *Tokenizer,
+  OUT    JSON_TOKEN      *Token
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((NULL == Tokenizer) || (NULL == Token)) {
+    return EFI_INVALID_PARAMETER;
   }
 
-  while (Count > 0) {
-    if (*Src == '\0') {
-      *Dest = '\0';
+  SkipWhiteSpace (Tokenizer);
+  Token->Depth      = Tokenizer->Depth;
+  Token->HasEscapes = FALSE;
+
+  switch (Tokenizer->State) {
+    case JSON_STATE_DONE:
+      if (Tokenizer->Offset < Tokenizer->Length) {
+        DEBUG ((DEBUG_INFO, "%a - Unexpected data after the Json value at offset %d\n", __FUNCTION__, Tokenizer->Offset));
+        return EFI_INVALID_PARAMETER;
+      }
+
+      Token->Type   = JsonTokenEnd;
+      Token->Text   = &Tokenizer->Json[Tokenizer->Offset];
+      Token->Length = 0;
+      return EFI_SUCCESS;
+
+    case JSON_STATE_NEXT:
+      if (Tokenizer->Offset >= Tokenizer->Length) {
+        DEBUG ((DEBUG_INFO, "%a - End of string without terminator\n", __FUNCTION__));
+        return EFI_INVALID_PARAMETER;
+      }
+
+      switch (Tokenizer->Json[Tokenizer->Offset]) {
+        case ',':
+          Tokenizer->Offset++;
+          Tokenizer->State = InArray (Tokenizer) ? JSON_STATE_VALUE : JSON_STATE_NAME;
+          return JsonNextToken (Tokenizer, Token);
+
+        case '}':
+          if (!InArray (Tokenizer)) {
+            CloseContainer (Tokenizer, Token, JsonTokenObjectEnd);
+            return EFI_SUCCESS;
+          }
+
+          break;
+
+        case ']':
+          if (InArray (Tokenizer)) {
+            CloseContainer (Tokenizer, Token, JsonTokenArrayEnd);
+            return EFI_SUCCESS;
+          }
+
+          break;
+      }
+
+      DEBUG ((DEBUG_INFO, "%a - Malformed Json at offset %d\n", __FUNCTION__, Tokenizer->Offset));
+      return EFI_INVALID_PARAMETER;
+
+    case JSON_STATE_FIRST_NAME:
+      if ((Tokenizer->Offset < Tokenizer->Length) && (Tokenizer->Json[Tokenizer->Offset] == '}')) {
+        CloseContainer (Tokenizer, Token, JsonTokenObjectEnd);
+        return EFI_SUCCESS;
+      }
+
+    // Fall through to read the name
+    case JSON_STATE_NAME:
+      Token->Type = JsonTokenName;
+      Status      = ReadString (Tokenizer, Token);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+
+      SkipWhiteSpace (Tokenizer);
+      if ((Tokenizer->Offset >= Tokenizer->Length) || (Tokenizer->Json[Tokenizer->Offset] != ':')) {
+        DEBUG ((DEBUG_INFO, "%a - Value separator incorrect\n", __FUNCTION__));
+        return EFI_INVALID_PARAMETER;
+      }
+
+      Tokenizer->Offset++;
+      Tokenizer->State = JSON_STATE_VALUE;
+      return EFI_SUCCESS;
+
+    case JSON_STATE_FIRST_VALUE:
+      if ((Tokenizer->Offset < Tokenizer->Length) && (Tokenizer->Json[Tokenizer->Offset] == ']')) {
+        CloseContainer (Tokenizer, Token, JsonTokenArrayEnd);
+        return EFI_SUCCESS;
+      }
+
+    // Fall through to read the value
+    case JSON_STATE_VALUE:
+      return ReadValue (Tokenizer, Token);
+
+    default:
+      ASSERT (FALSE);
       return EFI_INVALID_PARAMETER;
+  }
+}
+
+/**
+ * JsonUnescapeString
+ *
+ * @param[in]  Text         Text of a JsonTokenName or JsonTokenString token
+ * @param[in]  Length       Length of Text
+ * @param[out] Buffer       Where to write the decoded text.  May be the same as Text.
+ * @param[in]  BufferSize   Size of Buffer.  Length + 1 is always enough.
+ * @param[out] DecodedLength Number of characters written, not including the NULL terminator
+ *
+ * Escape sequences are decoded and \\u escapes are written as UTF-8.  The decoded
+ * text is never longer than the input so it can be decoded in place.  The result
+ * is NULL terminated.
+ *
+ * returns    EFI_STATUS    EFI_SUCCESS           - Decoded
+ *                          EFI_BUFFER_TOO_SMALL  - Buffer can't hold the decoded text
+ *                          EFI_INVALID_PARAMETER - NULL pointer or invalid escape sequence
+ **/
+EFI_STATUS
+EFIAPI
+JsonUnescapeString (
+  IN  CONST CHAR8  *Text,
+  IN  UINTN        Length,
+  OUT CHAR8        *Buffer,
+  IN  UINTN        BufferSize,
+  OUT UINTN        *DecodedLength
+  )
+{
+  UINTN   i;
+  UINTN   j;
+  UINT32  CodePoint;
+  UINT32  LowSurrogate;
+  CHAR8   Utf8[4];
+  UINTN   Utf8Length;
+
+  if ((NULL == Text) || (NULL == Buffer) || (NULL == DecodedLength) || (0 == BufferSize)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (i = 0, j = 0; i < Length; j += Utf8Length) {
+    if (Text[i] != '\\') {
+      Utf8[0]    = Text[i++];
+      Utf8Length = 1;
+    } else {
+      if (i + 1 >= Length) {
+        return EFI_INVALID_PARAMETER;
+      }
+
+      Utf8Length = 1;
+      switch (Text[i + 1]) {
+        case '\"':
+        case '\\':
+        case '/':
+          Utf8[0] = Text[i + 1];
+          break;
+        case 'b':
+          Utf8[0] = '\b';
+          break;
+        case 'f':
+          Utf8[0] = '\f';
+          break;
+        case 'n':
+          Utf8[0] = '\n';
+          break;
+        case 'r':
+          Utf8[0] = '\r';
+          break;
+        case 't':
+          Utf8[0] = '\t';
+          break;
+        case 'u':
+          if ((i + 6 > Length) || !ReadHex4 (&Text[i + 2], &CodePoint)) {
+            return EFI_INVALID_PARAMETER;
+          }
+
+          if ((CodePoint >= 0xD800) && (CodePoint <= 0xDBFF)) {
+            // High surrogate must be followed by a low surrogate
+            if ((i + 12 > Length) || (Text[i + 6] != '\\') || (Text[i + 7] != 'u') ||
+                !ReadHex4 (&Text[i + 8], &LowSurrogate) || (LowSurrogate < 0xDC00) || (LowSurrogate > 0xDFFF))
+            {
+              return EFI_INVALID_PARAMETER;
+            }
+
+            CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (LowSurrogate - 0xDC00);
+            i        += 6;
+          } else if ((CodePoint >= 0xDC00) && (CodePoint <= 0xDFFF)) {
+            return EFI_INVALID_PARAMETER;
+          }
+
+          if (CodePoint < 0x80) {
+            Utf8[0] = (CHAR8)CodePoint;
+          } else if (CodePoint < 0x800) {
+            Utf8[0]    = (CHAR8)(0xC0 | (CodePoint >> 6));
+            Utf8[1]    = (CHAR8)(0x80 | (CodePoint & 0x3F));
+            Utf8Length = 2;
+          } else if (CodePoint < 0x10000) {
+            Utf8[0]    = (CHAR8)(0xE0 | (CodePoint >> 12));
+            Utf8[1]    = (CHAR8)(0x80 | ((CodePoint >> 6) & 0x3F));
+            Utf8[2]    = (CHAR8)(0x80 | (CodePoint & 0x3F));
+            Utf8Length = 3;
+          } else {
+            Utf8[0]    = (CHAR8)(0xF0 | (CodePoint >> 18));
+            Utf8[1]    = (CHAR8)(0x80 | ((CodePoint >> 12) & 0x3F));
+            Utf8[2]    = (CHAR8)(0x80 | ((CodePoint >> 6) & 0x3F));
+            Utf8[3]    = (CHAR8)(0x80 | (CodePoint & 0x3F));
+            Utf8Length = 4;
+          }
+
+          i += 4;
+          break;
+        default:
+          return EFI_INVALID_PARAMETER;
+      }
+
+      i += 2;
     }
 
-    *Dest++ = *Src++;
-    Count--;
+    // Leave room for the NULL terminator
+    if (Utf8Length >= BufferSize - j) {
+      return EFI_BUFFER_TOO_SMALL;
+    }
+
+    CopyMem (&Buffer[j], Utf8, Utf8Length);
   }
 
-  *Dest = '\0';
+  Buffer[j]      = '\0';
+  *DecodedLength = j;
   return EFI_SUCCESS;
 }
 
+/**
+  Return the number of characters Text takes once escaped for a Json string.
+  Quote, backslash, and control characters are escaped.
+**/
+STATIC
+UINTN
+JsonEscapedLength (
+  IN CONST CHAR8  *Text,
+  IN UINTN        Length
+  )
+{
+  UINTN  i;
+  UINTN  EscapedLength;
+
+  EscapedLength = Length;
+  for (i = 0; i < Length; i++) {
+    switch (Text[i]) {
+      case '\"':
+      case '\\':
+      case '\b':
+      case '\f':
+      case '\n':
+      case '\r':
+      case '\t':
+        EscapedLength += 1;
+        break;
+      default:
+        if ((UINT8)Text[i] < 0x20) {
+          // \u00XX
+          EscapedLength += 5;
+        }
+
+        break;
+    }
+  }
+
+  return EscapedLength;
+}
+
+/**
+  Write Text escaped for a Json string at Next.  Returns the position after the
+  last character written, JsonEscapedLength (Text, Length) characters later.
+**/
+STATIC
+CHAR8 *
+JsonEscapeString (
+  IN CONST CHAR8  *Text,
+  IN UINTN        Length,
+  OUT CHAR8       *Next
+  )
+{
+  STATIC CONST CHAR8  HexDigits[] = "0123456789abcdef";
+  UINTN               i;
+
+  for (i = 0; i < Length; i++) {
+    switch (Text[i]) {
+      case '\"':
+      case '\\':
+        *Next++ = '\\';
+        *Next++ = Text[i];
+        break;
+      case '\b':
+        *Next++ = '\\';
+        *Next++ = 'b';
+        break;
+      case '\f':
+        *Next++ = '\\';
+        *Next++ = 'f';
+        break;
+      case '\n':
+        *Next++ = '\\';
+        *Next++ = 'n';
+        break;
+      case '\r':
+        *Next++ = '\\';
+        *Next++ = 'r';
+        break;
+      case '\t':
+        *Next++ = '\\';
+        *Next++ = 't';
+        break;
+      default:
+        if ((UINT8)Text[i] < 0x20) {
+          *Next++ = '\\';
+          *Next++ = 'u';
+          *Next++ = '0';
+          *Next++ = '0';
+          *Next++ = HexDigits[(UINT8)Text[i] >> 4];
+          *Next++ = HexDigits[(UINT8)Text[i] & 0xF];
+        } else {
+          *Next++ = Text[i];
+        }
+
+        break;
+    }
+  }
+
+  return Next;
+}
+
 /**
  * EncodeJson
  *
@@ -82,7 +766,8 @@ LocalAsciiStrCatS (
  * @param[out] Json String Size - Where to store Json String Size
  *
  * Don't confuse this routine for a real Json Encoder.  This code is for the
- * expected Dfci request blobs. Comments are not allowed.
+ * expected Dfci request blobs. Comments are not allowed.  Quote, backslash,
+ * and control characters in names and values are escaped.
  *
  * The caller is responsible for freeing the returned Json String;
  *
@@ -96,11 +781,11 @@ JsonLibEncode (
   OUT UINTN                 *JsonStringSize
   )
 {
-  UINTN       i;
-  UINTN       ValueLen;
-  CHAR8       *RequestBuffer;
-  UINTN       RequestSize;
-  EFI_STATUS  Status;
+  UINTN  i;
+  UINTN  ValueLen;
+  CHAR8  *RequestBuffer;
+  CHAR8  *Next;
+  UINTN  RequestSize;
 
   if ((NULL == Request) || (0 == RequestCount) || (NULL == JsonString) | (NULL == JsonStringSize)) {
     return EFI_INVALID_PARAMETER;
@@ -112,18 +797,30 @@ JsonLibEncode (
   //    3*RequestCount     " characters for the name, and the : separator
   //    1*RequestCount     for the , separators and the terminating NULL
   //
+  // The size is exact so the string is written in a single pass with no
+  // rescanning of what has already been written.
+  //
   RequestSize = 2 + (4 * RequestCount);
-  Status      = EFI_SUCCESS;
 
   for (i = 0; i < RequestCount; i++) {
+    if (AsciiStrnLenS (Request[i].FieldName, Request[i].FieldLen) != Request[i].FieldLen) {
+      DEBUG ((DEBUG_ERROR, "Error encoding request.  Field %d is shorter than FieldLen\n", i));
+      return EFI_INVALID_PARAMETER;
+    }
+
     if (NULL != Request[i].Value) {
-      ValueLen     = Request[i].ValueLen;
+      if (AsciiStrnLenS (Request[i].Value, Request[i].ValueLen) != Request[i].ValueLen) {
+        DEBUG ((DEBUG_ERROR, "Error encoding request.  Value %d is shorter than ValueLen\n", i));
+        return EFI_INVALID_PARAMETER;
+      }
+
+      ValueLen     = JsonEscapedLength (Request[i].Value, Request[i].ValueLen);
       RequestSize += (2 * sizeof (CHAR8));
     } else {
-      ValueLen = AsciiStrLen (JSON_NULL);
+      ValueLen = sizeof (JSON_NULL) - sizeof (CHAR8);
     }
 
-    RequestSize += Request[i].FieldLen + ValueLen;
+    RequestSize += JsonEscapedLength (Request[i].FieldName, Request[i].FieldLen) + ValueLen;
   }
 
   RequestBuffer = AllocatePool (RequestSize);
@@ -131,40 +828,58 @@ JsonLibEncode (
     return EFI_OUT_OF_RESOURCES;
   }
 
-  RequestBuffer[0] = '{';
-  RequestBuffer[1] = '\0';
+  Next    = RequestBuffer;
+  *Next++ = '{';
   for (i = 0; i < RequestCount; i++) {
     if (0 != i) {
-      Status |= AsciiStrCatS (RequestBuffer, RequestSize, ",");
+      *Next++ = ',';
     }
 
-    Status |= AsciiStrCatS (RequestBuffer, RequestSize, "\"");
-    Status |= LocalAsciiStrCatS (RequestBuffer, RequestSize, Request[i].FieldName, Request[i].FieldLen);
-    Status |= AsciiStrCatS (RequestBuffer, RequestSize, "\":");
+    *Next++ = '\"';
+    Next    = JsonEscapeString (Request[i].FieldName, Request[i].FieldLen, Next);
+    *Next++ = '\"';
+    *Next++ = ':';
     if (NULL != Request[i].Value) {
-      Status |= AsciiStrCatS (RequestBuffer, RequestSize, "\"");
-      Status |= LocalAsciiStrCatS (RequestBuffer, RequestSize, Request[i].Value, Request[i].ValueLen);
-      Status |= AsciiStrCatS (RequestBuffer, RequestSize, "\"");
+      *Next++ = '\"';
+      Next    = JsonEscapeString (Request[i].Value, Request[i].ValueLen, Next);
+      *Next++ = '\"';
     } else {
-      Status     |= AsciiStrCatS (RequestBuffer, RequestSize, JSON_NULL);
-      RequestSize = RequestSize - (2 * sizeof (CHAR8));
-    }
-
-    if (EFI_ERROR (Status)) {
-      break;
+      CopyMem (Next, JSON_NULL, sizeof (JSON_NULL) - sizeof (CHAR8));
+      Next += sizeof (JSON_NULL) - sizeof (CHAR8);
     }
   }
 
-  Status |= AsciiStrCatS (RequestBuffer, RequestSize, "}");
+  *Next++ = '}';
+  *Next++ = '\0';
+  ASSERT ((UINTN)(Next - RequestBuffer) == RequestSize);
 
+  DEBUG ((DEBUG_VERBOSE, "Request Buffer: %a\n", RequestBuffer));
+  *JsonString     = RequestBuffer;
+  *JsonStringSize = RequestSize;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Decode a name or string token in place if it has escape sequences.
+  The text shrinks so it stays within the original Json string.
+**/
+STATIC
+EFI_STATUS
+UnescapeInPlace (
+  IN OUT JSON_TOKEN  *Token
+  )
+{
+  EFI_STATUS  Status;
+
+  if (!Token->HasEscapes) {
+    return EFI_SUCCESS;
+  }
+
+  // The closing quote is after the text and is replaced by the NULL terminator
+  Status = JsonUnescapeString (Token->Text, Token->Length, (CHAR8 *)Token->Text, Token->Length + 1, &Token->Length);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "Error parsing encode request.  Code may be =%r\n", Status));
-    FreePool (RequestBuffer);
-  } else {
-    DEBUG ((DEBUG_INFO, "Request Buffer:\n"));
-    DUMP_HEX (DEBUG_INFO, 0, RequestBuffer, RequestSize, "");
-    *JsonString     = RequestBuffer;
-    *JsonStringSize = RequestSize;
+    DEBUG ((DEBUG_ERROR, "Unable to decode string. Code = %r\n", Status));
   }
 
   return Status;
@@ -179,9 +894,11 @@ JsonLibEncode (
  * @param[in]      Context for the process function
  *
  * Don't confuse this routine for a real Json Parser.  This code is for the
- * expected Dfci request blobs, and consist of a maximum of 6 name value pairs.
+ * expected Dfci request blobs, a single object of name value pairs.  Values that
+ * are objects or arrays are passed to the process function as their raw Json text.
  *
- * JsonString will be modified by the parse action.
+ * JsonString will be modified by the parse action.  Names and string values with
+ * escape sequences are decoded in place.
  * JsonElementArray will be initialized to all zeros before processing
  *
  * returns    EFI_STATUS    EFI_SUCCESS   - Processed at least one JSON element
@@ -197,8 +914,10 @@ JsonLibParse (
   IN  VOID                  *Context
   )
 {
-  CHAR8                 *JsonChar;
+  JSON_TOKENIZER        Tokenizer;
+  JSON_TOKEN            Token;
   UINTN                 Length;
+  UINTN                 ContainerDepth;
   JSON_REQUEST_ELEMENT  Rqst;
   EFI_STATUS            Status;
   BOOLEAN               Processed;
@@ -212,8 +931,7 @@ JsonLibParse (
 
   Processed = FALSE;
   Changed   = FALSE;
-  DEBUG ((DEBUG_INFO, "Parse buffer @ %p, Size = %d:\n", JsonString, JsonStringSize));
-  DUMP_HEX (DEBUG_INFO, 0, JsonString, JsonStringSize, "");
+  DEBUG ((DEBUG_VERBOSE, "Parse buffer @ %p, Size = %d\n", JsonString, JsonStringSize));
 
   Length = AsciiStrnLenS (JsonString, JsonStringSize);
   if (Length == JsonStringSize) {
@@ -221,99 +939,77 @@ JsonLibParse (
     return EFI_INVALID_PARAMETER;
   }
 
-  JsonChar = JsonString;
-
-  SKIP_WHITE_SPACE (JsonChar);
+  JsonTokenizerInit (&Tokenizer, JsonString, Length, 0);
 
   // Consume start character
-  if ('{' != *JsonChar) {
+  Status = JsonNextToken (&Tokenizer, &Token);
+  if (EFI_ERROR (Status) || (Token.Type != JsonTokenObjectStart)) {
     DEBUG ((DEBUG_INFO, "Invalid Json Start character\n"));
     return EFI_INVALID_PARAMETER;
   }
 
-  JsonChar++;
   while (TRUE) {
-    SKIP_WHITE_SPACE (JsonChar);
-    DEBUG ((DEBUG_ERROR, "Parsing at %p\n", JsonChar));
-    // Expect a quoted name
-    if ('\"' != *JsonChar) {
-      DEBUG ((DEBUG_INFO, "Name did not start with a quote\n"));
-      return EFI_INVALID_PARAMETER;
+    // Expect a name or the end of the object
+    Status = JsonNextToken (&Tokenizer, &Token);
+    if (EFI_ERROR (Status)) {
+      return Status;
     }
 
-    JsonChar++;
-    Rqst.FieldName = JsonChar;
-
-    SKIP_TO_NEXT_QUOTE (JsonChar);
+    if (Token.Type == JsonTokenObjectEnd) {
+      if (Changed) {
+        Status = EFI_MEDIA_CHANGED;
+      } else if (Processed) {
+        Status = EFI_SUCCESS;
+      } else {
+        Status = EFI_NOT_FOUND;
+      }
 
-    if ('\"' != *JsonChar) {
-      DEBUG ((DEBUG_INFO, "Name did not end with a quote\n"));
-      return EFI_INVALID_PARAMETER;
+      return Status;
     }
 
-    Rqst.FieldLen = JsonChar - Rqst.FieldName;       // Len does not include quote
-    JsonChar++;
+    Status = UnescapeInPlace (&Token);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
 
-    SKIP_WHITE_SPACE (JsonChar);
+    Rqst.FieldName = Token.Text;
+    Rqst.FieldLen  = Token.Length;
 
-    if (':' != *JsonChar) {
-      DEBUG ((DEBUG_INFO, "Value separator incorrect\n"));
-      return EFI_INVALID_PARAMETER;
+    Status = JsonNextToken (&Tokenizer, &Token);
+    if (EFI_ERROR (Status)) {
+      return Status;
     }
 
-    JsonChar++;
-    SKIP_WHITE_SPACE (JsonChar);
-
-    // The value may be quoted, the word null, or a sequence of decimal digits.
+    // The value may be a string, number, true, false, null, or a nested object or array.
     SkipNULL = FALSE;
-    switch (*JsonChar) {
-      case '\"':                // Handle quoted value
-        JsonChar++;             // Skip quote
-        Rqst.Value = JsonChar;
-
-        SKIP_TO_NEXT_QUOTE (JsonChar);
-
-        if ('\"' != *JsonChar) {
-          DEBUG ((DEBUG_ERROR, "Value did not end with a quote\n"));
-          return EFI_INVALID_PARAMETER;
-        }
-
-        Rqst.ValueLen = JsonChar - Rqst.Value; // Len does not include trailing quote
-        JsonChar++;                            // Skip trailing quote
+    switch (Token.Type) {
+      case JsonTokenNull:
+        SkipNULL = TRUE;
         break;
 
-      case 'n':                 // Handle the word null
-        JsonChar++;
-        if ('u' != *JsonChar++) {
-          goto INVALID;
-        }
-
-        if ('l' != *JsonChar++) {
-          goto INVALID;
-        }
+      case JsonTokenObjectStart:
+      case JsonTokenArrayStart:
+        // Pass the raw Json of the nested value
+        Rqst.Value     = Token.Text;
+        ContainerDepth = Token.Depth;
+        do {
+          Status = JsonNextToken (&Tokenizer, &Token);
+          if (EFI_ERROR (Status)) {
+            return Status;
+          }
+        } while (!(((Token.Type == JsonTokenObjectEnd) || (Token.Type == JsonTokenArrayEnd)) && (Token.Depth == ContainerDepth)));
 
-        if ('l' != *JsonChar++) {
-INVALID:
-          DEBUG ((DEBUG_ERROR, "Invalid value\n"));
-          return EFI_INVALID_PARAMETER;
-        }
-
-        SkipNULL = TRUE;
+        Rqst.ValueLen = (Token.Text + 1) - Rqst.Value;
         break;
 
       default:
-        Rqst.Value = JsonChar;
-        if ((*JsonChar < '0') || (*JsonChar > '9')) {
-          goto INVALID;
+        Status = UnescapeInPlace (&Token);
+        if (EFI_ERROR (Status)) {
+          return Status;
         }
 
-        JsonChar++;
-        while ((*JsonChar >= '0') && (*JsonChar <= '9')) {
-          JsonChar++;
-        }
-
-        // JsonChar now points to next item
-        Rqst.ValueLen = JsonChar - Rqst.Value;
+        Rqst.Value    = Token.Text;
+        Rqst.ValueLen = Token.Length;
         break;
     }
 
@@ -332,35 +1028,5 @@ INVALID:
     }
 
     Processed = TRUE;
-
-    SKIP_WHITE_SPACE (JsonChar);
-
-    if (',' == *JsonChar) {
-      JsonChar++;
-      if ('\0' == *JsonChar) {
-        DEBUG ((DEBUG_ERROR, "End of string without terminator\n"));
-        return EFI_INVALID_PARAMETER;
-      }
-
-      continue;
-    }
-
-    if ('}' == *JsonChar) {
-      if (Changed) {
-        Status = EFI_MEDIA_CHANGED;
-      } else if (Processed) {
-        Status = EFI_SUCCESS;
-      } else {
-        Status = EFI_NOT_FOUND;
-      }
-
-      return Status;
-    }
-
-    DEBUG ((DEBUG_ERROR, "Malformed JsonString\n"));
-    return EFI_INVALID_PARAMETER;
   }
-
-  ASSERT (FALSE);   // Cannot get here
-  return EFI_INVALID_PARAMETER;
 }
@@ -0,0 +1,66 @@
+/** @file -- PseudoRandomLib.c
+
+Repeatable xorshift64* pseudo random numbers for tests and benchmarks.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PseudoRandomLib.h>
+
+/**
+  Returns the next value of the generator and advances State.
+
+  @param[in, out] State   Generator state. Seed it with any value but 0.
+
+  @return The next pseudo random value.
+**/
+UINT64
+EFIAPI
+PseudoRandomNext (
+  IN OUT UINT64  *State
+  )
+{
+  UINT64  X;
+
+  ASSERT (State != NULL);
+  ASSERT (*State != 0);
+
+  X      = *State;
+  X     ^= RShiftU64 (X, 12);
+  X     ^= LShiftU64 (X, 25);
+  X     ^= RShiftU64 (X, 27);
+  *State = X;
+  return MultU64x64 (X, 0x2545F4914F6CDD1DULL);
+}
+
+/**
+  Returns the next value of the generator reduced to the range [0, Limit).
+
+  @param[in, out] State   Generator state. Seed it with any value but 0.
+  @param[in]      Limit   Exclusive upper bound, must not be 0.
+
+  @return A pseudo random value below Limit.
+**/
+UINT64
+EFIAPI
+PseudoRandomBelow (
+  IN OUT UINT64  *State,
+  IN     UINT64  Limit
+  )
+{
+  UINT64  Remainder;
+
+  ASSERT (Limit != 0);
+  if (Limit == 0) {
+    return 0;
+  }
+
+  DivU64x64Remainder (PseudoRandomNext (State), Limit, &Remainder);
+  return Remainder;
+}
@@ -0,0 +1,48 @@
+/** @file
+  Controls of the TimerLibPosix host TimerLib.
+
+  By default the counter follows the host clock. A test that needs exact
+  control of time sets a fake counter instead: from then on the counter only
+  moves when the test advances it or calls a delay function, and delays return
+  at once. The fake counter counts nanoseconds.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef TIMER_LIB_POSIX_H_
+#define TIMER_LIB_POSIX_H_
+
+/**
+  Switches to the fake counter and sets it.
+
+  @param  NanoSeconds  The new value of the fake counter.
+**/
+VOID
+EFIAPI
+TimerLibPosixSetFakeTime (
+  IN UINT64  NanoSeconds
+  );
+
+/**
+  Moves the fake counter forward. Does nothing while the host clock is used.
+
+  @param  NanoSeconds  The time to add to the fake counter.
+**/
+VOID
+EFIAPI
+TimerLibPosixAdvanceFakeTime (
+  IN UINT64  NanoSeconds
+  );
+
+/**
+  Switches back to the host clock.
+**/
+VOID
+EFIAPI
+TimerLibPosixUseHostClock (
+  VOID
+  );
+
+#endif // TIMER_LIB_POSIX_H_
@@ -16,11 +16,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/JsonLiteParser.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/PrintLib.h>
+#include <Library/TimerLib.h>
 #include <Library/UefiLib.h>
 #include <Library/UnitTestLib.h>
 
 #define UNIT_TEST_APP_NAME     "Json Lite test cases"
-#define UNIT_TEST_APP_VERSION  "1.0"
+#define UNIT_TEST_APP_VERSION  "1.1"
 
 /**
 
@@ -309,6 +310,40 @@ static JSON_REQUEST_ELEMENT  mParseTest22Elements[] = {
 };
 #define mParseTest22ElementCount  (sizeof(mParseTest22Elements)/sizeof(JSON_REQUEST_ELEMENT))
 
+// *----------------------------------------------------------------------------------*
+// Decode Test 23  Escapes, true, negative numbers and nested values                 *
+// Not a literal as escaped strings are decoded in place.                            *
+// *----------------------------------------------------------------------------------*
+static CHAR8  mDecTest23Json[] = "{\"Na\\u006De\" : \"a\\\"b\", \"Obj\" : { \"x\" : [1, {\"y\":\"]}\"}] }, \"Num\":-12.5e2, \"Flag\":true}";
+#define DEC_TEST_23_1_String  "Name"
+#define DEC_TEST_23_1_Value   "a\"b"
+#define DEC_TEST_23_2_String  "Obj"
+#define DEC_TEST_23_2_Value   "{ \"x\" : [1, {\"y\":\"]}\"}] }"
+#define DEC_TEST_23_3_String  "Num"
+#define DEC_TEST_23_3_Value   "-12.5e2"
+#define DEC_TEST_23_4_String  "Flag"
+#define DEC_TEST_23_4_Value   "true"
+
+static JSON_REQUEST_ELEMENT  mParseTest23Elements[] = {
+  { DEC_TEST_23_1_String, sizeof (DEC_TEST_23_1_String) - sizeof (CHAR8), DEC_TEST_23_1_Value, sizeof (DEC_TEST_23_1_Value) - sizeof (CHAR8) },
+  { DEC_TEST_23_2_String, sizeof (DEC_TEST_23_2_String) - sizeof (CHAR8), DEC_TEST_23_2_Value, sizeof (DEC_TEST_23_2_Value) - sizeof (CHAR8) },
+  { DEC_TEST_23_3_String, sizeof (DEC_TEST_23_3_String) - sizeof (CHAR8), DEC_TEST_23_3_Value, sizeof (DEC_TEST_23_3_Value) - sizeof (CHAR8) },
+  { DEC_TEST_23_4_String, sizeof (DEC_TEST_23_4_String) - sizeof (CHAR8), DEC_TEST_23_4_Value, sizeof (DEC_TEST_23_4_Value) - sizeof (CHAR8) }
+};
+#define mParseTest23ElementCount  (sizeof(mParseTest23Elements)/sizeof(JSON_REQUEST_ELEMENT))
+
+// *----------------------------------------------------------------------------------*
+// Decode Test 24  Invalid escape sequence in a value                                *
+// *----------------------------------------------------------------------------------*
+#define DEC_TEST_24_JSON          "{\"String1\" : \"Va\\lue\"}"
+#define mParseTest24ElementCount  0
+
+// *----------------------------------------------------------------------------------*
+// Decode Test 25  Empty object                                                      *
+// *----------------------------------------------------------------------------------*
+#define DEC_TEST_25_JSON          "{ }"
+#define mParseTest25ElementCount  0
+
 // *----------------------------------------------------------------------------------------------------------------*
 // Encode Test 1 = Validate some data                                                                              *
 // *----------------------------------------------------------------------------------------------------------------*
@@ -327,6 +362,40 @@ static JSON_REQUEST_ELEMENT  mEncodeTest1Elements[] = {
 };
 #define mEncodeTest1ElementCount  (sizeof(mEncodeTest1Elements)/sizeof(JSON_REQUEST_ELEMENT))
 
+// *----------------------------------------------------------------------------------*
+// Encode Test 4 = null values                                                       *
+// *----------------------------------------------------------------------------------*
+#define ENC_TEST_4_JSON      "{\"String\":null,\"String2\":\"Value2\",\"String3\":null}"
+#define ENC_TEST_4_1_String  "String"
+#define ENC_TEST_4_2_String  "String2"
+#define ENC_TEST_4_2_Value   "Value2"
+#define ENC_TEST_4_3_String  "String3"
+
+static JSON_REQUEST_ELEMENT  mEncodeTest4Elements[] = {
+  { ENC_TEST_4_1_String, sizeof (ENC_TEST_4_1_String) - sizeof (CHAR8), NULL,               0                                         },
+  { ENC_TEST_4_2_String, sizeof (ENC_TEST_4_2_String) - sizeof (CHAR8), ENC_TEST_4_2_Value, sizeof (ENC_TEST_4_2_Value) - sizeof (CHAR8) },
+  { ENC_TEST_4_3_String, sizeof (ENC_TEST_4_3_String) - sizeof (CHAR8), NULL,               0                                         }
+};
+#define mEncodeTest4ElementCount  (sizeof(mEncodeTest4Elements)/sizeof(JSON_REQUEST_ELEMENT))
+
+// *----------------------------------------------------------------------------------*
+// Encode Test 5 = Quote, backslash, and control characters are escaped              *
+// *----------------------------------------------------------------------------------*
+#define ENC_TEST_5_JSON      "{\"Path\":\"C:\\\\x\",\"Quote\":\"say \\\"hi\\\"\",\"Ctl\\t\":\"a\\tb\\r\\n\\u0001\"}"
+#define ENC_TEST_5_1_String  "Path"
+#define ENC_TEST_5_1_Value   "C:\\x"
+#define ENC_TEST_5_2_String  "Quote"
+#define ENC_TEST_5_2_Value   "say \"hi\""
+#define ENC_TEST_5_3_String  "Ctl\t"
+#define ENC_TEST_5_3_Value   "a\tb\r\n\x01"
+
+static JSON_REQUEST_ELEMENT  mEncodeTest5Elements[] = {
+  { ENC_TEST_5_1_String, sizeof (ENC_TEST_5_1_String) - sizeof (CHAR8), ENC_TEST_5_1_Value, sizeof (ENC_TEST_5_1_Value) - sizeof (CHAR8) },
+  { ENC_TEST_5_2_String, sizeof (ENC_TEST_5_2_String) - sizeof (CHAR8), ENC_TEST_5_2_Value, sizeof (ENC_TEST_5_2_Value) - sizeof (CHAR8) },
+  { ENC_TEST_5_3_String, sizeof (ENC_TEST_5_3_String) - sizeof (CHAR8), ENC_TEST_5_3_Value, sizeof (ENC_TEST_5_3_Value) - sizeof (CHAR8) }
+};
+#define mEncodeTest5ElementCount  (sizeof(mEncodeTest5Elements)/sizeof(JSON_REQUEST_ELEMENT))
+
 // *----------------------------------------------------------------------------------*
 // Encode Test 2 = Send in NULL for request array                                    *
 // *----------------------------------------------------------------------------------*
@@ -362,8 +431,82 @@ static BASIC_TEST_CONTEXT  mParseTest19 = { DEC_TEST_19_JSON, sizeof (DEC_TEST_1
 static BASIC_TEST_CONTEXT  mParseTest20 = { DEC_TEST_20_JSON, sizeof (DEC_TEST_20_JSON), EFI_INVALID_PARAMETER, NULL, mParseTest20ElementCount, NULL };
 static BASIC_TEST_CONTEXT  mParseTest21 = { DEC_TEST_21_JSON, sizeof (DEC_TEST_21_JSON), EFI_INVALID_PARAMETER, mParseTest21Elements, mParseTest21ElementCount, NULL };
 static BASIC_TEST_CONTEXT  mParseTest22 = { DEC_TEST_22_JSON, sizeof (DEC_TEST_22_JSON), EFI_INVALID_PARAMETER, mParseTest22Elements, mParseTest22ElementCount, NULL };
+static BASIC_TEST_CONTEXT  mParseTest23 = { mDecTest23Json, sizeof (mDecTest23Json), EFI_SUCCESS, mParseTest23Elements, mParseTest23ElementCount, NULL };
+static BASIC_TEST_CONTEXT  mParseTest24 = { DEC_TEST_24_JSON, sizeof (DEC_TEST_24_JSON), EFI_INVALID_PARAMETER, NULL, mParseTest24ElementCount, NULL };
+static BASIC_TEST_CONTEXT  mParseTest25 = { DEC_TEST_25_JSON, sizeof (DEC_TEST_25_JSON), EFI_NOT_FOUND, NULL, mParseTest25ElementCount, NULL };
 
 static BASIC_TEST_CONTEXT  mEncodeTest1 = { ENC_TEST_1_JSON, sizeof (ENC_TEST_1_JSON), EFI_SUCCESS, mEncodeTest1Elements, mEncodeTest1ElementCount, NULL };
+static BASIC_TEST_CONTEXT  mEncodeTest4 = { ENC_TEST_4_JSON, sizeof (ENC_TEST_4_JSON), EFI_SUCCESS, mEncodeTest4Elements, mEncodeTest4ElementCount, NULL };
+static BASIC_TEST_CONTEXT  mEncodeTest5 = { ENC_TEST_5_JSON, sizeof (ENC_TEST_5_JSON), EFI_SUCCESS, mEncodeTest5Elements, mEncodeTest5ElementCount, NULL };
+
+// *----------------------------------------------------------------------------------*
+// * Tokenizer and benchmark data                                                     *
+// *----------------------------------------------------------------------------------*
+typedef struct {
+  JSON_TOKEN_TYPE    Type;
+  UINTN              Depth;
+  CONST CHAR8        *Text;
+} EXPECTED_TOKEN;
+
+#define TOKEN_TEST_JSON  " {\"a\":[1,-2.5E+3,true,false,null,{\"b\":\"c\\\"d\"},[]],\"e\":{}} "
+
+static EXPECTED_TOKEN  mTokenTestTokens[] = {
+  { JsonTokenObjectStart, 0, "{"       },
+  { JsonTokenName,        1, "a"       },
+  { JsonTokenArrayStart,  1, "["       },
+  { JsonTokenNumber,      2, "1"       },
+  { JsonTokenNumber,      2, "-2.5E+3" },
+  { JsonTokenTrue,        2, "true"    },
+  { JsonTokenFalse,       2, "false"   },
+  { JsonTokenNull,        2, "null"    },
+  { JsonTokenObjectStart, 2, "{"       },
+  { JsonTokenName,        3, "b"       },
+  { JsonTokenString,      3, "c\\\"d" },
+  { JsonTokenObjectEnd,   2, "}"       },
+  { JsonTokenArrayStart,  2, "["       },
+  { JsonTokenArrayEnd,    2, "]"       },
+  { JsonTokenArrayEnd,    1, "]"       },
+  { JsonTokenName,        1, "e"       },
+  { JsonTokenObjectStart, 1, "{"       },
+  { JsonTokenObjectEnd,   1, "}"       },
+  { JsonTokenObjectEnd,   0, "}"       },
+  { JsonTokenEnd,         0, ""        }
+};
+
+static CONST CHAR8  *mMalformedJson[] = {
+  "",
+  "{\"a\":}",
+  "[1,]",
+  "{\"a\" 1}",
+  "[1 2]",
+  "{\"a\":1]",
+  "[1}",
+  "\"abc",
+  "{\"a\":tru}",
+  "{\"a\":\"\\q\"}",
+  "{\"a\":\"\\u12G4\"}",
+  "1 2",
+  "-",
+  "1.",
+  "1e+",
+  "{1:2}",
+  "{\"a\":1,}",
+  "[\"a\0b\"]"
+};
+
+//
+// Payload sizes for the encode / parse benchmark
+//
+typedef struct {
+  UINTN    PayloadSize;
+} BENCHMARK_CONTEXT;
+
+#define BENCHMARK_VALUE_LENGTH  48
+
+static BENCHMARK_CONTEXT  mBenchmark1K   = { SIZE_1KB };
+static BENCHMARK_CONTEXT  mBenchmark16K  = { SIZE_16KB };
+static BENCHMARK_CONTEXT  mBenchmark256K = { SIZE_256KB };
+static BENCHMARK_CONTEXT  mBenchmark1M   = { SIZE_1MB };
 
 /// ================================================================================================
 /// ================================================================================================
@@ -517,6 +660,49 @@ JsonEncodeTest (
   return UNIT_TEST_PASSED;
 }
 
+/**
+  Encode round trip test
+
+  Encodes the test context elements, parses the result, and requires the
+  parsed elements to match the original elements.
+
+  */
+static
+UNIT_TEST_STATUS
+JsonEncodeRoundTripTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BASIC_TEST_CONTEXT  *Btc;
+  UINTN               NewStringSize;
+  INTN                i;
+  EFI_STATUS          Status;
+
+  Btc = (BASIC_TEST_CONTEXT *)Context;
+
+  DEBUG ((DEBUG_INFO, "Processing Encode round trip test\n"));
+
+  Status = JsonLibEncode (Btc->ExpectedResults, Btc->ExpectedCount, &Btc->BufferToFree, &NewStringSize);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  mApplyElementCount = 0;
+  Status             = JsonLibParse (Btc->BufferToFree, NewStringSize, JsonProcessFunction, NULL);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mApplyElementCount, Btc->ExpectedCount);
+
+  for (i = 0; i < mApplyElementCount; i++) {
+    UT_LOG_INFO ("Processing element %d\n", i);
+
+    UT_ASSERT_EQUAL (mApplyElements[i].FieldLen, Btc->ExpectedResults[i].FieldLen);
+    UT_ASSERT_MEM_EQUAL (mApplyElements[i].FieldName, Btc->ExpectedResults[i].FieldName, mApplyElements[i].FieldLen);
+
+    UT_ASSERT_EQUAL (mApplyElements[i].ValueLen, Btc->ExpectedResults[i].ValueLen);
+    UT_ASSERT_MEM_EQUAL (mApplyElements[i].Value, Btc->ExpectedResults[i].Value, mApplyElements[i].ValueLen);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
 /**
   Decode NULL test P1
 
@@ -686,6 +872,295 @@ JsonEncodeNullP4 (
   return UNIT_TEST_PASSED;
 }
 
+/**
+  Tokenize a nested document and check every token.
+**/
+static
+UNIT_TEST_STATUS
+JsonTokenizerTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  JSON_TOKENIZER  Tokenizer;
+  JSON_TOKEN      Token;
+  EFI_STATUS      Status;
+  UINTN           i;
+
+  Status = JsonTokenizerInit (&Tokenizer, TOKEN_TEST_JSON, sizeof (TOKEN_TEST_JSON) - sizeof (CHAR8), 0);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  for (i = 0; i < ARRAY_SIZE (mTokenTestTokens); i++) {
+    Status = JsonNextToken (&Tokenizer, &Token);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_LOG_INFO ("Token %d Type %d Depth %d Text %.*a\n", i, Token.Type, Token.Depth, Token.Length, Token.Text);
+    UT_ASSERT_EQUAL (Token.Type, mTokenTestTokens[i].Type);
+    UT_ASSERT_EQUAL (Token.Depth, mTokenTestTokens[i].Depth);
+    UT_ASSERT_EQUAL (Token.Length, AsciiStrLen (mTokenTestTokens[i].Text));
+    UT_ASSERT_MEM_EQUAL (Token.Text, mTokenTestTokens[i].Text, Token.Length);
+    UT_ASSERT_EQUAL (Token.HasEscapes, (BOOLEAN)(Token.Type == JsonTokenString));
+  }
+
+  // End is sticky
+  Status = JsonNextToken (&Tokenizer, &Token);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Token.Type, JsonTokenEnd);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Every malformed document must fail before JsonTokenEnd.
+**/
+static
+UNIT_TEST_STATUS
+JsonTokenizerMalformedTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  JSON_TOKENIZER  Tokenizer;
+  JSON_TOKEN      Token;
+  EFI_STATUS      Status;
+  UINTN           i;
+  UINTN           Length;
+
+  for (i = 0; i < ARRAY_SIZE (mMalformedJson); i++) {
+    // The embedded NULL case needs the full length of the literal
+    Length = (i == ARRAY_SIZE (mMalformedJson) - 1) ? 7 : AsciiStrLen (mMalformedJson[i]);
+    UT_LOG_INFO ("Malformed %d: %a\n", i, mMalformedJson[i]);
+    Status = JsonTokenizerInit (&Tokenizer, mMalformedJson[i], Length, 0);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    do {
+      Status = JsonNextToken (&Tokenizer, &Token);
+    } while (!EFI_ERROR (Status) && (Token.Type != JsonTokenEnd));
+
+    UT_ASSERT_STATUS_EQUAL (Status, EFI_INVALID_PARAMETER);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Nesting beyond the limit must be rejected.
+**/
+static
+UNIT_TEST_STATUS
+JsonTokenizerDepthTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  JSON_TOKENIZER  Tokenizer;
+  JSON_TOKEN      Token;
+  EFI_STATUS      Status;
+  CHAR8           Deep[(JSON_MAX_DEPTH + 1) * 2];
+  UINTN           Count;
+
+  SetMem (Deep, JSON_MAX_DEPTH + 1, '[');
+  SetMem (&Deep[JSON_MAX_DEPTH + 1], JSON_MAX_DEPTH + 1, ']');
+
+  // One level too deep
+  Status = JsonTokenizerInit (&Tokenizer, Deep, sizeof (Deep), 0);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Count = 0;
+  do {
+    Status = JsonNextToken (&Tokenizer, &Token);
+    Count++;
+  } while (!EFI_ERROR (Status));
+
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_BAD_BUFFER_SIZE);
+  UT_ASSERT_EQUAL (Count, JSON_MAX_DEPTH + 1);
+
+  // Exactly at the limit
+  Status = JsonTokenizerInit (&Tokenizer, &Deep[1], sizeof (Deep) - 2, 0);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  do {
+    Status = JsonNextToken (&Tokenizer, &Token);
+  } while (!EFI_ERROR (Status) && (Token.Type != JsonTokenEnd));
+
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  // Caller limit
+  Status = JsonTokenizerInit (&Tokenizer, "[[[]]]", 6, 2);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  do {
+    Status = JsonNextToken (&Tokenizer, &Token);
+  } while (!EFI_ERROR (Status));
+
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_BAD_BUFFER_SIZE);
+  UT_ASSERT_STATUS_EQUAL (JsonTokenizerInit (&Tokenizer, "[]", 2, JSON_MAX_DEPTH + 1), EFI_INVALID_PARAMETER);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Decode escape sequences into a buffer and in place.
+**/
+static
+UNIT_TEST_STATUS
+JsonUnescapeTest (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8        Escaped[]  = "a\\\"b\\\\c\\/d\\n\\t\\u0041\\u00e9\\u20AC\\ud83d\\ude00";
+  CONST CHAR8  Expected[] = "a\"b\\c/d\n\tA\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+  CHAR8        Buffer[sizeof (Escaped)];
+  UINTN        Length;
+  EFI_STATUS   Status;
+
+  Status = JsonUnescapeString (Escaped, sizeof (Escaped) - 1, Buffer, sizeof (Buffer), &Length);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Length, sizeof (Expected) - 1);
+  UT_ASSERT_MEM_EQUAL (Buffer, Expected, sizeof (Expected));
+
+  // Too small for the decoded text and terminator
+  Status = JsonUnescapeString (Escaped, sizeof (Escaped) - 1, Buffer, sizeof (Expected) - 1, &Length);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_BUFFER_TOO_SMALL);
+
+  // Lone surrogates and bad escapes
+  Status = JsonUnescapeString ("\\ud83d", 6, Buffer, sizeof (Buffer), &Length);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_INVALID_PARAMETER);
+  Status = JsonUnescapeString ("\\ude00", 6, Buffer, sizeof (Buffer), &Length);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_INVALID_PARAMETER);
+  Status = JsonUnescapeString ("ab\\", 3, Buffer, sizeof (Buffer), &Length);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_INVALID_PARAMETER);
+
+  // In place
+  Status = JsonUnescapeString (Escaped, sizeof (Escaped) - 1, Escaped, sizeof (Escaped), &Length);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (Length, sizeof (Expected) - 1);
+  UT_ASSERT_MEM_EQUAL (Escaped, Expected, sizeof (Expected));
+
+  return UNIT_TEST_PASSED;
+}
+
+//
+// Process function for the benchmark.  Only counts elements.
+//
+EFI_STATUS
+EFIAPI
+JsonCountFunction (
+  IN  JSON_REQUEST_ELEMENT  *JsonElement,
+  IN  VOID                  *Context
+  )
+{
+  (*(UINTN *)Context)++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Encode a flat object of about PayloadSize bytes, then parse it with
+  JsonLibParse and with the tokenizer.  Times are logged.
+**/
+static
+UNIT_TEST_STATUS
+JsonBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BENCHMARK_CONTEXT     *Bc;
+  JSON_REQUEST_ELEMENT  *Elements;
+  CHAR8                 *Names;
+  CHAR8                 *Values;
+  CHAR8                 *Json;
+  UINTN                 JsonSize;
+  UINTN                 Count;
+  UINTN                 Parsed;
+  UINTN                 Tokens;
+  UINTN                 i;
+  UINT64                Start;
+  UINT64                EncodeNs;
+  UINT64                ParseNs;
+  UINT64                TokenizeNs;
+  JSON_TOKENIZER        Tokenizer;
+  JSON_TOKEN            Token;
+  EFI_STATUS            Status;
+  UNIT_TEST_STATUS      Result;
+
+  Bc = (BENCHMARK_CONTEXT *)Context;
+
+  // "Fieldnnnnnnn":"<value>",
+  Count    = Bc->PayloadSize / (16 + BENCHMARK_VALUE_LENGTH + 6);
+  Elements = AllocateZeroPool (Count * sizeof (JSON_REQUEST_ELEMENT));
+  Names    = AllocateZeroPool (Count * 16);
+  Values   = AllocatePool (BENCHMARK_VALUE_LENGTH);
+  Json     = NULL;
+  Result   = UNIT_TEST_ERROR_TEST_FAILED;
+  if ((Elements == NULL) || (Names == NULL) || (Values == NULL)) {
+    goto Done;
+  }
+
+  for (i = 0; i < BENCHMARK_VALUE_LENGTH; i++) {
+    Values[i] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[i % 64];
+  }
+
+  for (i = 0; i < Count; i++) {
+    Elements[i].FieldName = &Names[i * 16];
+    Elements[i].FieldLen  = AsciiSPrint (&Names[i * 16], 16, "Field%07d", i);
+    Elements[i].Value     = Values;
+    Elements[i].ValueLen  = BENCHMARK_VALUE_LENGTH;
+  }
+
+  Start    = GetPerformanceCounter ();
+  Status   = JsonLibEncode (Elements, Count, &Json, &JsonSize);
+  EncodeNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+  if (EFI_ERROR (Status)) {
+    UT_LOG_ERROR ("JsonLibEncode failed %r\n", Status);
+    goto Done;
+  }
+
+  // Tokenize first as JsonLibParse is allowed to modify the string
+  Tokens     = 0;
+  Start      = GetPerformanceCounter ();
+  JsonTokenizerInit (&Tokenizer, Json, JsonSize - 1, 0);
+  do {
+    Status = JsonNextToken (&Tokenizer, &Token);
+    Tokens++;
+  } while (!EFI_ERROR (Status) && (Token.Type != JsonTokenEnd));
+
+  TokenizeNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+  if (EFI_ERROR (Status) || (Tokens != (Count * 2) + 3)) {
+    UT_LOG_ERROR ("Tokenize failed %r Tokens %d\n", Status, Tokens);
+    goto Done;
+  }
+
+  Parsed  = 0;
+  Start   = GetPerformanceCounter ();
+  Status  = JsonLibParse (Json, JsonSize, JsonCountFunction, &Parsed);
+  ParseNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+  if (EFI_ERROR (Status) || (Parsed != Count)) {
+    UT_LOG_ERROR ("JsonLibParse failed %r Parsed %d of %d\n", Status, Parsed, Count);
+    goto Done;
+  }
+
+  UT_LOG_INFO (
+    "%d bytes, %d elements.  Encode %ld us, JsonLibParse %ld us, Tokenize %ld us\n",
+    JsonSize,
+    Count,
+    EncodeNs / 1000,
+    ParseNs / 1000,
+    TokenizeNs / 1000
+    );
+  Result = UNIT_TEST_PASSED;
+
+Done:
+  if (Elements != NULL) {
+    FreePool (Elements);
+  }
+
+  if (Names != NULL) {
+    FreePool (Names);
+  }
+
+  if (Values != NULL) {
+    FreePool (Values);
+  }
+
+  if (Json != NULL) {
+    FreePool (Json);
+  }
+
+  return Result;
+}
+
 /// ================================================================================================
 /// ================================================================================================
 ///
@@ -695,25 +1170,23 @@ JsonEncodeNullP4 (
 /// ================================================================================================
 
 /**
-  JsonTestAppEntry
+  Set up and run the test suites.  Shared by the shell application and host test.
 
-  @param[in] ImageHandle  The firmware allocated handle for the EFI image.
-  @param[in] SystemTable  A pointer to the EFI System Table.
-
-  @retval EFI_SUCCESS     The entry point executed successfully.
-  @retval other           Some error occurred when executing this entry point.
+  @retval EFI_SUCCESS     The tests ran.
+  @retval other           Some error occurred setting up the tests.
 
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-JsonTestAppEntry (
-  IN EFI_HANDLE        ImageHandle,
-  IN EFI_SYSTEM_TABLE  *SystemTable
+UnitTestingEntry (
+  VOID
   )
 {
   UNIT_TEST_FRAMEWORK_HANDLE  Fw = NULL;
   UNIT_TEST_SUITE_HANDLE      JsonParseTests;
   UNIT_TEST_SUITE_HANDLE      JsonEncodeTests;
+  UNIT_TEST_SUITE_HANDLE      JsonTokenizerTests;
+  UNIT_TEST_SUITE_HANDLE      JsonBenchmarkTests;
   EFI_STATUS                  Status;
 
   DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
@@ -760,6 +1233,9 @@ JsonTestAppEntry (
   AddTestCase (JsonParseTests, "Json Parse Test 20", "JSON.Parse.Test20", JsonParseTest, NULL, CleanUpTestContext, &mParseTest20);
   AddTestCase (JsonParseTests, "Json Parse Test 21", "JSON.Parse.Test21", JsonParseTest, NULL, CleanUpTestContext, &mParseTest21);
   AddTestCase (JsonParseTests, "Json Parse Test 22", "JSON.Parse.Test22", JsonParseTest, NULL, CleanUpTestContext, &mParseTest22);
+  AddTestCase (JsonParseTests, "Json Parse Test 23", "JSON.Parse.Test23", JsonParseTest, NULL, CleanUpTestContext, &mParseTest23);
+  AddTestCase (JsonParseTests, "Json Parse Test 24", "JSON.Parse.Test24", JsonParseTest, NULL, CleanUpTestContext, &mParseTest24);
+  AddTestCase (JsonParseTests, "Json Parse Test 25", "JSON.Parse.Test25", JsonParseTest, NULL, CleanUpTestContext, &mParseTest25);
 
   AddTestCase (JsonParseTests, "Json Parse NULL Test 1", "JSON.Parse.NullTest1", JsonParseNullP1, NULL, CleanUpTestContext, &mParseTest1);
   AddTestCase (JsonParseTests, "Json Parse NULL Test 2", "JSON.Parse.NullTest2", JsonParseNullP2, NULL, CleanUpTestContext, &mParseTest1);
@@ -780,6 +1256,39 @@ JsonTestAppEntry (
   AddTestCase (JsonEncodeTests, "Json Encode Test 3", "JSON.EncodeTest3", JsonEncodeNullP2, NULL, CleanUpTestContext, &mEncodeTest1);
   AddTestCase (JsonEncodeTests, "Json Encode Test 4", "JSON.EncodeTest4", JsonEncodeNullP3, NULL, CleanUpTestContext, &mEncodeTest1);
   AddTestCase (JsonEncodeTests, "Json Encode Test 5", "JSON.EncodeTest5", JsonEncodeNullP4, NULL, CleanUpTestContext, &mEncodeTest1);
+  AddTestCase (JsonEncodeTests, "Json Encode Test 6", "JSON.EncodeTest6", JsonEncodeTest, NULL, CleanUpTestContext, &mEncodeTest4);
+  AddTestCase (JsonEncodeTests, "Json Encode Test 7", "JSON.EncodeTest7", JsonEncodeTest, NULL, CleanUpTestContext, &mEncodeTest5);
+  AddTestCase (JsonEncodeTests, "Json Encode Round Trip Test", "JSON.EncodeRoundTrip", JsonEncodeRoundTripTest, NULL, CleanUpTestContext, &mEncodeTest5);
+
+  //
+  // Populate the Tokenizer Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&JsonTokenizerTests, Fw, "Tokenize Json", "JSON.Tokenizer", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Json Tokenizer Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (JsonTokenizerTests, "Json Tokenize nested document", "JSON.Tokenizer.Nested", JsonTokenizerTest, NULL, NULL, NULL);
+  AddTestCase (JsonTokenizerTests, "Json Tokenize malformed documents", "JSON.Tokenizer.Malformed", JsonTokenizerMalformedTest, NULL, NULL, NULL);
+  AddTestCase (JsonTokenizerTests, "Json Tokenize depth limit", "JSON.Tokenizer.Depth", JsonTokenizerDepthTest, NULL, NULL, NULL);
+  AddTestCase (JsonTokenizerTests, "Json Unescape strings", "JSON.Tokenizer.Unescape", JsonUnescapeTest, NULL, NULL, NULL);
+
+  //
+  // Populate the Benchmark Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&JsonBenchmarkTests, Fw, "Json encode and parse timing", "JSON.Benchmark", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Json Benchmark Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (JsonBenchmarkTests, "Json Benchmark 1KB", "JSON.Benchmark.1K", JsonBenchmark, NULL, NULL, &mBenchmark1K);
+  AddTestCase (JsonBenchmarkTests, "Json Benchmark 16KB", "JSON.Benchmark.16K", JsonBenchmark, NULL, NULL, &mBenchmark16K);
+  AddTestCase (JsonBenchmarkTests, "Json Benchmark 256KB", "JSON.Benchmark.256K", JsonBenchmark, NULL, NULL, &mBenchmark256K);
+  AddTestCase (JsonBenchmarkTests, "Json Benchmark 1MB", "JSON.Benchmark.1M", JsonBenchmark, NULL, NULL, &mBenchmark1M);
 
   //
   // Execute the tests.
@@ -793,3 +1302,35 @@ EXIT:
 
   return Status;
 }
+
+/**
+  JsonTestAppEntry
+
+  @param[in] ImageHandle  The firmware allocated handle for the EFI image.
+  @param[in] SystemTable  A pointer to the EFI System Table.
+
+  @retval EFI_SUCCESS     The entry point executed successfully.
+  @retval other           Some error occurred when executing this entry point.
+
+**/
+EFI_STATUS
+EFIAPI
+JsonTestAppEntry (
+  IN EFI_HANDLE        ImageHandle,
+  IN EFI_SYSTEM_TABLE  *SystemTable
+  )
+{
+  return UnitTestingEntry ();
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
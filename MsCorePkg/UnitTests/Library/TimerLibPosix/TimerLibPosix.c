@@ -0,0 +1,171 @@
+/** @file
+  Host implementation of TimerLib using the C runtime clock().
+
+  Tests that need exact control of time can replace the clock with a fake
+  nanosecond counter through the functions in TimerLibPosix.h.
+
+  Copyright (C) Microsoft Corporation.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <time.h>
+
+#include <Base.h>
+#include <Library/BaseLib.h>
+#include <Library/TimerLib.h>
+#include <TimerLibPosix.h>
+
+STATIC BOOLEAN  mUseFakeTime;
+STATIC UINT64   mFakeTimeNs;
+
+/**
+  Switches to the fake counter and sets it.
+
+  @param  NanoSeconds  The new value of the fake counter.
+**/
+VOID
+EFIAPI
+TimerLibPosixSetFakeTime (
+  IN UINT64  NanoSeconds
+  )
+{
+  mUseFakeTime = TRUE;
+  mFakeTimeNs  = NanoSeconds;
+}
+
+/**
+  Moves the fake counter forward. Does nothing while the host clock is used.
+
+  @param  NanoSeconds  The time to add to the fake counter.
+**/
+VOID
+EFIAPI
+TimerLibPosixAdvanceFakeTime (
+  IN UINT64  NanoSeconds
+  )
+{
+  if (mUseFakeTime) {
+    mFakeTimeNs += NanoSeconds;
+  }
+}
+
+/**
+  Switches back to the host clock.
+**/
+VOID
+EFIAPI
+TimerLibPosixUseHostClock (
+  VOID
+  )
+{
+  mUseFakeTime = FALSE;
+}
+
+/**
+  Stalls the CPU for at least the given number of microseconds.
+
+  @param  MicroSeconds  The minimum number of microseconds to delay.
+
+  @return MicroSeconds
+**/
+UINTN
+EFIAPI
+MicroSecondDelay (
+  IN UINTN  MicroSeconds
+  )
+{
+  NanoSecondDelay (MultU64x32 (MicroSeconds, 1000));
+  return MicroSeconds;
+}
+
+/**
+  Stalls the CPU for at least the given number of nanoseconds.
+
+  @param  NanoSeconds The minimum number of nanoseconds to delay.
+
+  @return NanoSeconds
+**/
+UINTN
+EFIAPI
+NanoSecondDelay (
+  IN UINTN  NanoSeconds
+  )
+{
+  UINT64  Start;
+
+  if (mUseFakeTime) {
+    mFakeTimeNs += NanoSeconds;
+    return NanoSeconds;
+  }
+
+  Start = GetPerformanceCounter ();
+  while (GetTimeInNanoSecond (GetPerformanceCounter () - Start) < NanoSeconds) {
+  }
+
+  return NanoSeconds;
+}
+
+/**
+  Retrieves the current value of the host clock.
+
+  @return The current value of the performance counter.
+**/
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  if (mUseFakeTime) {
+    return mFakeTimeNs;
+  }
+
+  return (UINT64)clock ();
+}
+
+/**
+  Retrieves the performance counter properties.
+
+  @param  StartValue  The value the performance counter starts with when it rolls over.
+  @param  EndValue    The value that the performance counter ends with before it rolls over.
+
+  @return The frequency in Hz.
+**/
+UINT64
+EFIAPI
+GetPerformanceCounterProperties (
+  OUT UINT64  *StartValue   OPTIONAL,
+  OUT UINT64  *EndValue     OPTIONAL
+  )
+{
+  if (StartValue != NULL) {
+    *StartValue = 0;
+  }
+
+  if (EndValue != NULL) {
+    *EndValue = MAX_UINT64;
+  }
+
+  return mUseFakeTime ? 1000000000 : (UINT64)CLOCKS_PER_SEC;
+}
+
+/**
+  Converts elapsed ticks of performance counter to time in nanoseconds.
+
+  @param  Ticks     The number of elapsed ticks from the performance counter.
+
+  @return The elapsed time in nanoseconds.
+**/
+UINT64
+EFIAPI
+GetTimeInNanoSecond (
+  IN UINT64  Ticks
+  )
+{
+  if (mUseFakeTime) {
+    return Ticks;
+  }
+
+  return DivU64x64Remainder (MultU64x32 (Ticks, 1000000000), (UINT64)CLOCKS_PER_SEC, NULL);
+}
@@ -21,6 +21,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DevicePathLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/HiiLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/UefiHiiServicesLib.h>
 #include <Library/PrintLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
@@ -37,25 +38,41 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #pragma pack(1)
 
-// Struct Containing a HWErrRec
+// Struct Containing a HWErrRec loaded for display
 typedef struct ErrorRecord {
-  LIST_ENTRY                        entry;  // Necessary for linked list structure
+  LIST_ENTRY                        entry;  // Linkage in the page cache, most recently used first
   EFI_COMMON_ERROR_RECORD_HEADER    *error; // Pointer to the HWErrRec
   UINT32                            val;    // Page number
 } ErrorRecord;
 
+// Struct describing one HwErrRecXXXX found in the variable store
+typedef struct RecordIndexEntry {
+  UINT16     Index;                         // XXXX of the HwErrRecXXXX name
+  BOOLEAN    Invalid;                       // TRUE once the record failed to load or validate
+} RecordIndexEntry;
+
 #pragma pack()
 
 // *---------------------------------------------------------------------------------------*
 // * Global Variables                                                                      *
 // *---------------------------------------------------------------------------------------*
 STATIC  HWH_MENU_CONFIG  mHwhMenuConfiguration = { LOGS_TRUE };                             // Configuration for VFR
-LIST_ENTRY               mListHead             = INITIALIZE_LIST_HEAD_VARIABLE (mListHead); // Head of the linked list
+LIST_ENTRY               mListHead             = INITIALIZE_LIST_HEAD_VARIABLE (mListHead); // Head of the page cache
 UINT32                   NumErrorEntries       = 0;                                         // Number of HwErrRec(s)
 ErrorRecord              *currentPage          = NULL;                                      // Current record displayed on the page
 CHAR16                   UnicodeString[MAX_DISPLAY_STRING_LENGTH + 1];                      // Unicode buffer for printing
+STATIC RecordIndexEntry  *mRecordIndex         = NULL;                                      // Sorted index of every HwErrRec, one per page
+STATIC UINT32            mCachedPages          = 0;                                         // Number of ErrorRecords in the page cache
+STATIC UINTN             mRecordSizeHint       = 0;                                         // Largest HwErrRec read so far
 
 #define HWH_MENU_SIGNATURE    SIGNATURE_32('H', 'w', 'h', 'm')
+
+// Number of loaded records kept around while paging. Must be at least 2 so
+// that evicting the least recently used page never frees currentPage.
+#define HWH_MENU_PAGE_CACHE_SIZE  8
+
+// Number of CHAR16s in the "HwErrRec" prefix, excluding the terminator
+#define HWH_REC_PREFIX_LENGTH  ((sizeof (EFI_HW_ERR_REC_VAR_NAME) / sizeof (CHAR16)) - 1)
 #define NUM_SEC_DATA_ROWS     15
 #define NUM_SEC_DATA_COLUMNS  3
 
@@ -108,11 +125,11 @@ struct {
 };
 
 // *---------------------------------------------------------------------------------------*
-// * Doubly Linked List Methods                                                            *
+// * Record Index and Page Cache Methods                                                   *
 // *---------------------------------------------------------------------------------------*
 
 /**
- *  Deletes the list structure containing WHEA Errors
+ *  Deletes the page cache holding loaded WHEA Errors
  *
  *  @retval     VOID
 **/
@@ -128,11 +145,336 @@ DeleteList (
     FreePool (currentPage);                                 // free ErrorRecord
   }
 
-  currentPage = NULL;
+  currentPage  = NULL;
+  mCachedPages = 0;
+}
+
+/**
+ *  Extracts the XXXX from a HwErrRecXXXX variable name
+ *
+ *  @param[in]  Name          Variable name returned by GetNextVariableName
+ *  @param[out] RecordIndex   The hexadecimal index parsed from the name
+ *
+ *  @retval     BOOLEAN       TRUE if Name is exactly "HwErrRec" followed by four hex digits
+ *                            FALSE otherwise
+**/
+BOOLEAN
+ParseHwErrRecIndex (
+  IN  CONST CHAR16  *Name,
+  OUT UINT16        *RecordIndex
+  )
+{
+  UINT16  Value = 0;
+  UINT8   OuterLoop;
+  CHAR16  Digit;
+
+  if (StrnCmp (Name, EFI_HW_ERR_REC_VAR_NAME, HWH_REC_PREFIX_LENGTH) != 0) {
+    return FALSE;
+  }
+
+  Name += HWH_REC_PREFIX_LENGTH;
+  for (OuterLoop = 0; OuterLoop < 4; OuterLoop++) {
+    Digit = Name[OuterLoop];
+    if ((Digit >= L'0') && (Digit <= L'9')) {
+      Value = (UINT16)((Value << 4) | (Digit - L'0'));
+    } else if ((Digit >= L'A') && (Digit <= L'F')) {
+      Value = (UINT16)((Value << 4) | (Digit - L'A' + 10));
+    } else if ((Digit >= L'a') && (Digit <= L'f')) {
+      Value = (UINT16)((Value << 4) | (Digit - L'a' + 10));
+    } else {
+      return FALSE;
+    }
+  }
+
+  if (Name[4] != L'\0') {
+    return FALSE;
+  }
+
+  *RecordIndex = Value;
+  return TRUE;
+}
+
+/**
+ *  Walks the variable store once with GetNextVariableName and builds a sorted index of
+ *  every HwErrRecXXXX under gEfiHardwareErrorVariableGuid. No record data is read here.
+ *
+ *  @retval     EFI_SUCCESS             mRecordIndex and NumErrorEntries describe the records found
+ *  @retval     EFI_OUT_OF_RESOURCES    A buffer could not be allocated
+**/
+EFI_STATUS
+BuildRecordIndex (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Present;         // One bit per possible XXXX value
+  CHAR16      *Name;            // Name buffer handed to GetNextVariableName
+  CHAR16      *NewName;
+  UINTN       NameBufferSize;   // Allocated size of Name
+  UINTN       NameSize;         // Size requested by GetNextVariableName
+  EFI_GUID    Guid;
+  UINT16      RecordIndex;
+  UINT32      Count = 0;
+  UINT32      OuterLoop;
+
+  if (mRecordIndex != NULL) {
+    FreePool (mRecordIndex);
+    mRecordIndex = NULL;
+  }
+
+  NumErrorEntries = 0;
+
+  Present        = AllocateZeroPool ((MAX_UINT16 + 1) / 8);
+  NameBufferSize = EFI_HW_ERR_REC_VAR_NAME_LEN * sizeof (CHAR16);
+  Name           = AllocateZeroPool (NameBufferSize); // Empty name starts the enumeration
+  if ((Present == NULL) || (Name == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Cleanup;
+  }
+
+  while (TRUE) {
+    NameSize = NameBufferSize;
+    Status   = gRT->GetNextVariableName (&NameSize, Name, &Guid);
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      // Grow the buffer and resume from the same name
+      NewName = ReallocatePool (NameBufferSize, NameSize, Name);
+      if (NewName == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        goto Cleanup;
+      }
+
+      Name           = NewName;
+      NameBufferSize = NameSize;
+      continue;
+    }
+
+    if (EFI_ERROR (Status)) {
+      // EFI_NOT_FOUND marks the end of the variable store
+      break;
+    }
+
+    if (CompareGuid (&Guid, &gEfiHardwareErrorVariableGuid) &&
+        ParseHwErrRecIndex (Name, &RecordIndex) &&
+        ((Present[RecordIndex / 8] & (1 << (RecordIndex % 8))) == 0))
+    {
+      Present[RecordIndex / 8] |= (UINT8)(1 << (RecordIndex % 8));
+      Count++;
+    }
+  }
+
+  if (Status != EFI_NOT_FOUND) {
+    DEBUG ((DEBUG_ERROR, "%a GetNextVariableName stopped early - %r\n", __FUNCTION__, Status));
+  }
+
+  Status = EFI_SUCCESS;
+  if (Count == 0) {
+    goto Cleanup;
+  }
+
+  mRecordIndex = AllocateZeroPool (Count * sizeof (RecordIndexEntry));
+  if (mRecordIndex == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Cleanup;
+  }
+
+  // Walking the bitmap yields the records in ascending order without a sort
+  for (OuterLoop = 0; OuterLoop <= MAX_UINT16; OuterLoop++) {
+    if ((OuterLoop % 8 == 0) && (Present[OuterLoop / 8] == 0)) {
+      OuterLoop += 7;
+      continue;
+    }
+
+    if ((Present[OuterLoop / 8] & (1 << (OuterLoop % 8))) != 0) {
+      mRecordIndex[NumErrorEntries++].Index = (UINT16)OuterLoop;
+    }
+  }
+
+Cleanup:
+  if (Present != NULL) {
+    FreePool (Present);
+  }
+
+  if (Name != NULL) {
+    FreePool (Name);
+  }
+
+  return Status;
+}
+
+/**
+ *  Reads a single HwErrRecXXXX from the variable store
+ *
+ *  @param[in]  RecordIndex   The XXXX of the record being read
+ *  @param[out] Size          Size of the record returned
+ *
+ *  @retval     Pointer to a pool buffer holding the record, NULL if it could not be read
+**/
+EFI_COMMON_ERROR_RECORD_HEADER *
+ReadHwErrRec (
+  IN  UINT16  RecordIndex,
+  OUT UINTN   *Size
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      VarName[EFI_HW_ERR_REC_VAR_NAME_LEN];     // HwRecRecXXXX name of var being read
+  VOID        *Buffer = NULL;
+
+  UnicodeSPrint (
+    VarName,
+    sizeof (VarName),
+    L"%s%04X",
+    EFI_HW_ERR_REC_VAR_NAME,
+    RecordIndex
+    );
+
+  // Most records are the same size, so a buffer sized for the largest record seen so far
+  // usually lets a single GetVariable call succeed
+  *Size = mRecordSizeHint;
+  if (*Size > 0) {
+    Buffer = AllocatePool (*Size);
+    if (Buffer == NULL) {
+      return NULL;
+    }
+  }
+
+  Status = gRT->GetVariable (
+                  VarName,
+                  &gEfiHardwareErrorVariableGuid,
+                  NULL,
+                  Size,
+                  Buffer
+                  );
+
+  if (Status == EFI_BUFFER_TOO_SMALL) {
+    if (Buffer != NULL) {
+      FreePool (Buffer);
+    }
+
+    Buffer = AllocatePool (*Size);
+    if (Buffer == NULL) {
+      return NULL;
+    }
+
+    Status = gRT->GetVariable (
+                    VarName,
+                    &gEfiHardwareErrorVariableGuid,
+                    NULL,
+                    Size,
+                    Buffer
+                    );
+  }
+
+  if (EFI_ERROR (Status)) {
+    if (Buffer != NULL) {
+      FreePool (Buffer);
+    }
+
+    return NULL;
+  }
+
+  if (*Size > mRecordSizeHint) {
+    mRecordSizeHint = *Size;
+  }
+
+  return (EFI_COMMON_ERROR_RECORD_HEADER *)Buffer;
+}
+
+/**
+ *  Returns the page for the record at Slot of the index, reading it from the variable store
+ *  if it is not already in the page cache. The page returned becomes the most recently used.
+ *
+ *  @param[in]  Slot          Position of the record in mRecordIndex
+ *
+ *  @retval     Pointer to the ErrorRecord, NULL if the record could not be read or is invalid
+**/
+ErrorRecord *
+GetPage (
+  IN UINT32  Slot
+  )
+{
+  LIST_ENTRY                      *Link;
+  ErrorRecord                     *Page;
+  EFI_COMMON_ERROR_RECORD_HEADER  *ErrorRecordPointer;
+  UINTN                           Size;
+
+  for (Link = GetFirstNode (&mListHead); !IsNull (&mListHead, Link); Link = GetNextNode (&mListHead, Link)) {
+    Page = (ErrorRecord *)Link;
+    if (Page->val == Slot + 1) {
+      RemoveEntryList (Link);
+      InsertHeadList (&mListHead, Link);
+      return Page;
+    }
+  }
+
+  if (mRecordIndex[Slot].Invalid) {
+    return NULL;
+  }
+
+  ErrorRecordPointer = ReadHwErrRec (mRecordIndex[Slot].Index, &Size);
+  if ((ErrorRecordPointer == NULL) || !ValidateCperHeader (ErrorRecordPointer, Size)) {
+    // Remember the failure so paging skips this record without reading it again
+    mRecordIndex[Slot].Invalid = TRUE;
+    if (ErrorRecordPointer != NULL) {
+      FreePool (ErrorRecordPointer);
+    }
+
+    return NULL;
+  }
+
+  Page = AllocateZeroPool (sizeof (ErrorRecord));
+  if (Page == NULL) {
+    FreePool (ErrorRecordPointer);
+    return NULL;
+  }
+
+  // Evict the least recently used page. currentPage is always at the head, so it is never evicted.
+  if (mCachedPages >= HWH_MENU_PAGE_CACHE_SIZE) {
+    Link = GetPreviousNode (&mListHead, &mListHead);
+    RemoveEntryList (Link);
+    FreePool (((ErrorRecord *)Link)->error);
+    FreePool (Link);
+    mCachedPages--;
+  }
+
+  Page->error = ErrorRecordPointer;
+  Page->val   = Slot + 1;
+
+  InsertHeadList (
+    &mListHead,
+    (LIST_ENTRY *)Page
+    );
+  mCachedPages++;
+
+  return Page;
+}
+
+/**
+ *  Changes the current page to the first valid error record in the index
+ *
+ *  @retval     BOOLEAN       TRUE if currentPage was set
+ *                            FALSE if no record could be loaded
+**/
+BOOLEAN
+PageFirst (
+  VOID
+  )
+{
+  ErrorRecord  *Page;
+  UINT32       Slot;
+
+  for (Slot = 0; Slot < NumErrorEntries; Slot++) {
+    Page = GetPage (Slot);
+    if (Page != NULL) {
+      currentPage = Page;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
 }
 
 /**
- *  Changes the current page to be the current error record to be the next in the list structure
+ *  Changes the current page to be the next valid error record in the index
  *
  *  @retval     BOOLEAN       TRUE if currentPage was changed to next
  *                            FALSE otherwise
@@ -142,23 +484,27 @@ PageForward (
   VOID
   )
 {
-  LIST_ENTRY  *tmp;
+  ErrorRecord  *Page;
+  UINT32       Slot;
 
-  tmp = GetNextNode (
-          &mListHead,
-          (LIST_ENTRY *)currentPage
-          );
+  if (currentPage == NULL) {
+    return FALSE;
+  }
 
-  if (tmp != &mListHead) {
-    currentPage = (ErrorRecord *)tmp;
-    return TRUE;
+  // val is one based, so it is also the slot of the next record
+  for (Slot = currentPage->val; Slot < NumErrorEntries; Slot++) {
+    Page = GetPage (Slot);
+    if (Page != NULL) {
+      currentPage = Page;
+      return TRUE;
+    }
   }
 
   return FALSE;
 }
 
 /**
- *  Changes the current page to be the current error record to be the previous in the list structure
+ *  Changes the current page to be the previous valid error record in the index
  *
  *  @retval     BOOLEAN     TRUE if currentPage was changed to previous
  *                          FALSE otherwise
@@ -168,16 +514,19 @@ PageBackward (
   VOID
   )
 {
-  LIST_ENTRY  *tmp;
+  ErrorRecord  *Page;
+  UINT32       Slot;
 
-  tmp = GetPreviousNode (
-          &mListHead,
-          (LIST_ENTRY *)currentPage
-          );
+  if (currentPage == NULL) {
+    return FALSE;
+  }
 
-  if (tmp != &mListHead) {
-    currentPage = (ErrorRecord *)tmp;
-    return TRUE;
+  for (Slot = currentPage->val - 1; Slot > 0; Slot--) {
+    Page = GetPage (Slot - 1);
+    if (Page != NULL) {
+      currentPage = Page;
+      return TRUE;
+    }
   }
 
   return FALSE;
@@ -757,51 +1106,11 @@ UpdateDisplayStrings (
 }
 
 /**
- *  Finds the XXXX in the HwRecRecXXXX -> the next index at which a Whea record will be inserted.
- *
- *  @retval     UINT32     A Whea Index.
- *
-**/
-UINT32
-GetMaxWheaIndex (
-  VOID
-  )
-{
-  EFI_STATUS  Status;                                   // Return status
-  UINTN       Size      = 0;                            // Used to store size of HwErrRec found
-  UINT32      OuterLoop = 0;                            // Store the current index we're checking
-  CHAR16      VarName[EFI_HW_ERR_REC_VAR_NAME_LEN];     // HwRecRecXXXX used to find variable
-
-  for (OuterLoop = 0; OuterLoop <= MAX_UINT32; OuterLoop++) {
-    UnicodeSPrint (
-      VarName,
-      sizeof (VarName),
-      L"%s%04X",
-      EFI_HW_ERR_REC_VAR_NAME,
-      (UINT16)(OuterLoop & MAX_UINT16)
-      );
-
-    Status = gRT->GetVariable (
-                    VarName,
-                    &gEfiHardwareErrorVariableGuid,
-                    NULL,
-                    &Size,
-                    NULL
-                    );
-
-    // We've found the next index. Excellent.
-    if (Status == EFI_NOT_FOUND) {
-      break;
-    }
-  }
-
-  return OuterLoop;
-}
-
-/**
- *  Populates list structure with Whea Errors.
+ *  Indexes the Whea Errors in the variable store and loads the first one for display.
+ *  Remaining records are read on demand as the user pages through them.
  *
- *  @retval     VOID
+ *  @retval     EFI_SUCCESS     currentPage holds the first valid record
+ *  @retval     EFI_ABORTED     There are no valid records to display
  *
 **/
 EFI_STATUS
@@ -809,62 +1118,17 @@ PopulateWheaErrorList (
   VOID
   )
 {
-  EFI_STATUS                      Status;                               // Return status
-  UINTN                           Size = 0;                             // Size of variable being stored
-  CHAR16                          VarName[EFI_HW_ERR_REC_VAR_NAME_LEN]; // HwRecRecXXXX name of var being stored
-  EFI_COMMON_ERROR_RECORD_HEADER  *ErrorRecordPointer = NULL;           // Pointer to the start of the record
-  ErrorRecord                     *new;                                 // New record being added
-  UINT32                          OuterLoop;
-
-  NumErrorEntries = GetMaxWheaIndex ();
-
-  for (OuterLoop = NumErrorEntries; OuterLoop > 0; --OuterLoop) {
-    // Create HwRecRecXXXX string
-    UnicodeSPrint (
-      VarName,
-      sizeof (VarName),
-      L"%s%04X",
-      EFI_HW_ERR_REC_VAR_NAME,
-      OuterLoop - 1
-      );
-
-    // Determine size required to allocate
-    Status = gRT->GetVariable (
-                    VarName,
-                    &gEfiHardwareErrorVariableGuid,
-                    NULL,
-                    &Size,
-                    NULL
-                    );
-
-    if (Status != EFI_NOT_FOUND) {
-      ErrorRecordPointer = AllocatePool (Size);
-
-      // Populate the error record
-      Status = gRT->GetVariable (
-                      VarName,
-                      &gEfiHardwareErrorVariableGuid,
-                      NULL,
-                      &Size,
-                      ErrorRecordPointer
-                      );
-
-      if (ValidateCperHeader (ErrorRecordPointer, Size)) {
-        new = AllocateZeroPool (sizeof (ErrorRecord));
+  EFI_STATUS  Status;
 
-        new->error = ErrorRecordPointer;
-        new->val   = OuterLoop;
+  DeleteList ();
 
-        InsertHeadList (
-          &mListHead,
-          (LIST_ENTRY *)new
-          );
-      }
-    }
+  Status = BuildRecordIndex ();
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a Failed to index HwErrRecs - %r\n", __FUNCTION__, Status));
+    return EFI_ABORTED;
   }
 
-  if (!IsListEmpty (&mListHead)) {
-    currentPage = (ErrorRecord *)GetFirstNode (&mListHead);
+  if (PageFirst ()) {
     return EFI_SUCCESS;
   } else {
     return EFI_ABORTED;
@@ -939,8 +1203,8 @@ DriverCallback (
     case EFI_BROWSER_ACTION_FORM_CLOSE:
 
       // Capture form closing
-      if (QuestionId == HWH_MENU_LEFT_ID) {
-        currentPage = (ErrorRecord *)GetFirstNode (&mListHead);
+      if ((QuestionId == HWH_MENU_LEFT_ID) && (currentPage != NULL)) {
+        PageFirst ();
       }
 
       break;
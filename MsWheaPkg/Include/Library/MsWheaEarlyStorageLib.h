@@ -71,6 +71,30 @@ typedef struct MS_WHEA_EARLY_STORAGE_ENTRY_V0_T_DEF {
 
 #pragma pack()
 
+/**
+
+ Largest early storage region a 256 byte CMOS can hold once the RTC area in front of it is skipped
+
+**/
+#define MS_WHEA_EARLY_STORAGE_SHADOW_SIZE  0xC0
+
+/**
+
+ RAM copy of the early storage region, owned by the caller so it can live on the stack in PEI.
+
+ Data:              Region contents, header first. Only the header and active range are loaded.
+ Dirty:             One bit per byte of Data that still has to be written back to the store.
+ Sum:               16 bit sum of the header (checksum field excluded) and the active range.
+ Valid:             TRUE if the region had a good signature and checksum when it was loaded.
+
+**/
+typedef struct _MS_WHEA_EARLY_STORAGE_SHADOW {
+  UINT8      Data[MS_WHEA_EARLY_STORAGE_SHADOW_SIZE];
+  UINT8      Dirty[MS_WHEA_EARLY_STORAGE_SHADOW_SIZE / 8];
+  UINT16     Sum;
+  BOOLEAN    Valid;
+} MS_WHEA_EARLY_STORAGE_SHADOW;
+
 /**
 
 This routine returns the maximum number of bytes that can be stored in the early storage area.
@@ -225,4 +249,62 @@ MsWheaESAddRecordV0 (
   IN  EFI_GUID  *PartitionId OPTIONAL
   );
 
+/**
+
+This routine loads the header and active range of the MS WHEA store into a RAM shadow with one pass over
+the store, and verifies the signature and checksum on the way.
+
+@param[out] Shadow                    The shadow to load
+
+@retval EFI_SUCCESS                   The shadow was loaded. Shadow->Valid tells whether the store was valid.
+@retval EFI_INVALID_PARAMETER         Shadow was NULL
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowLoad (
+  OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow
+  );
+
+/**
+
+This routine appends an MS_WHEA_EARLY_STORAGE_ENTRY_V0 record to a loaded shadow. The active range and
+checksum are updated incrementally. Nothing is written to the store until MsWheaESShadowCommit is called.
+
+@param[in, out] Shadow                The shadow loaded by MsWheaESShadowLoad
+@param[in]      MsWheaEntry           The record to append
+
+@retval EFI_SUCCESS                   The record was appended
+@retval EFI_OUT_OF_RESOURCES          The store is full
+@retval EFI_INVALID_PARAMETER         Null pointer detected
+@retval EFI_VOLUME_CORRUPTED          The shadow does not hold a valid store
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowAddRecordV0 (
+  IN OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow,
+  IN MS_WHEA_EARLY_STORAGE_ENTRY_V0    *MsWheaEntry
+  );
+
+/**
+
+This routine writes the bytes of a shadow that changed since it was loaded or last committed back to the
+MS WHEA store. Any number of appends can be committed together.
+
+@param[in, out] Shadow                The shadow to commit
+
+@retval EFI_SUCCESS                   All dirty bytes were written
+@retval EFI_INVALID_PARAMETER         Shadow was NULL
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowCommit (
+  IN OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow
+  );
+
 #endif // __MS_WHEA_EARLY_STORAGE_LIB__
@@ -375,8 +375,7 @@ MsWheaESCalculateChecksum16 (
   UINT16                        *Checksum
   )
 {
-  UINT16      Data;
-  UINT32      Index;
+  UINT16      Data[MS_WHEA_EARLY_STORAGE_SHADOW_SIZE / sizeof (UINT16)];
   UINT16      Sum;
   EFI_STATUS  Status;
 
@@ -400,14 +399,15 @@ MsWheaESCalculateChecksum16 (
   Sum              = CalculateSum16 ((UINT16 *)Header, MS_WHEA_EARLY_STORAGE_HEADER_SIZE);
   Header->Checksum = *Checksum;
 
-  for (Index = 0; Index < Header->ActiveRange; Index += sizeof (Data)) {
-    Status = MsWheaEarlyStorageRead (&Data, (UINT8)sizeof (Data), (UINT8)(MS_WHEA_EARLY_STORAGE_DATA_OFFSET + Index));
+  // Read the whole active range in one pass rather than a word at a time
+  if (Header->ActiveRange != 0) {
+    Status = MsWheaEarlyStorageRead (Data, (UINT8)Header->ActiveRange, MS_WHEA_EARLY_STORAGE_DATA_OFFSET);
     if (EFI_ERROR (Status) != FALSE) {
-      DEBUG ((DEBUG_ERROR, "%a: Reading Early Storage %d failed %r\n", __FUNCTION__, Index, Status));
+      DEBUG ((DEBUG_ERROR, "%a: Reading Early Storage of %d bytes failed %r\n", __FUNCTION__, Header->ActiveRange, Status));
       goto Cleanup;
     }
 
-    Sum = Sum + Data;
+    Sum = Sum + CalculateSum16 (Data, Header->ActiveRange);
   }
 
   *Checksum = (UINT16)(0x10000 - Sum);
@@ -417,106 +417,355 @@ Cleanup:
 }
 
 /**
-This routine adds an MS_WHEA_EARLY_STORAGE_ENTRY_V0 record to the WHEA early store region. The header
-checksum and active range will be updated in the process.
 
-@param[in]  MsWheaEntry             The MS_WHEA_EARLY_STORAGE_ENTRY_V0 to be added
+This routine copies bytes into a shadow and marks the ones that need writing back as dirty.
 
-@retval     EFI_SUCCESS             The record was added
-@retval     EFI_OUT_OF_RESOURCES    The CMOS ES region is full
-@retval     EFI_INVALID_PARAMETER   MsWheaEntry was NULL
+@param[in, out] Shadow                The shadow to update
+@param[in]      Offset                The offset in the shadow, starting from the beginning of the header
+@param[in]      Ptr                   The pointer to the new bytes
+@param[in]      Size                  The number of bytes to copy
+@param[in]      Force                 TRUE to mark every byte dirty, FALSE to only mark the bytes that changed.
+                                      Bytes outside the loaded range must be forced as their store value is unknown.
+
+**/
+STATIC
+VOID
+MsWheaESShadowSetBytes (
+  IN OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow,
+  IN UINT8                             Offset,
+  IN CONST VOID                        *Ptr,
+  IN UINT8                             Size,
+  IN BOOLEAN                           Force
+  )
+{
+  CONST UINT8  *Src;
+  UINT8        Index;
+  UINT8        Target;
+
+  Src = Ptr;
+  for (Index = 0; Index < Size; Index++) {
+    Target = Offset + Index;
+    if (Force || (Shadow->Data[Target] != Src[Index])) {
+      Shadow->Data[Target]       = Src[Index];
+      Shadow->Dirty[Target / 8] |= (UINT8)(1 << (Target % 8));
+    }
+  }
+}
+
+/**
+
+This routine loads the MS WHEA store header, and optionally the active range, into a shadow.
+
+@param[out] Shadow                    The shadow to load
+@param[in]  LoadData                  TRUE to load and sum the active range and verify the checksum.
+                                      FALSE to load the header only and take the running sum from the
+                                      stored checksum, which is enough to append. If the signature or
+                                      active range of the header is bad the full load is done instead.
+
+@retval EFI_SUCCESS                   The shadow was loaded
+@retval EFI_INVALID_PARAMETER         Shadow was NULL
+@retval Others                        See MsWheaEarlyStorageRead for more details
 
 **/
 STATIC
 EFI_STATUS
-MsWheaESAddRecordV0Internal (
-  IN MS_WHEA_EARLY_STORAGE_ENTRY_V0  *MsWheaEntry
+MsWheaESShadowLoadInternal (
+  OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow,
+  IN  BOOLEAN                       LoadData
   )
 {
-  UINT8                         Offset = 0;
   EFI_STATUS                    Status;
   MS_WHEA_EARLY_STORAGE_HEADER  Header;
-  UINT16                        Checksum;
+  BOOLEAN                       ActiveRangeValid;
 
-  if (MsWheaEntry == NULL) {
+  if (Shadow == NULL) {
     Status = EFI_INVALID_PARAMETER;
     goto Cleanup;
   }
 
-  Status = MsWheaESFindSlot (
-             sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0),
-             &Offset
-             );
+  ASSERT (MsWheaEarlyStorageGetMaxSize () <= MS_WHEA_EARLY_STORAGE_SHADOW_SIZE);
 
+  ZeroMem (Shadow, sizeof (*Shadow));
+  Status = MsWheaEarlyStorageRead (Shadow->Data, MS_WHEA_EARLY_STORAGE_HEADER_SIZE, 0);
   if (EFI_ERROR (Status)) {
     goto Cleanup;
   }
 
-  Status = MsWheaEarlyStorageWrite (
-             MsWheaEntry,
-             sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0),
-             MS_WHEA_EARLY_STORAGE_DATA_OFFSET + Offset
-             );
+  CopyMem (&Header, Shadow->Data, MS_WHEA_EARLY_STORAGE_HEADER_SIZE);
 
-  if (EFI_ERROR (Status)) {
-    DEBUG ((
-      DEBUG_ERROR,
-      "%a: Clear V0 Early Storage failed at %d %r\n",
-      __FUNCTION__,
-      Offset,
-      Status
-      ));
+  ActiveRangeValid = (BOOLEAN)((Header.ActiveRange <= MsWheaESGetMaxDataCount ()) &&
+                               ((Header.ActiveRange & BIT0) == 0));
 
+  if (!LoadData && ActiveRangeValid && (Header.Signature == MS_WHEA_EARLY_STORAGE_SIGNATURE)) {
+    Shadow->Sum   = (UINT16)(0x10000 - Header.Checksum);
+    Shadow->Valid = TRUE;
     goto Cleanup;
   }
 
-  Status = MsWheaEarlyStorageRead (
-             &Header,
-             MS_WHEA_EARLY_STORAGE_HEADER_SIZE,
-             0
-             );
+  // Sum the header with the checksum field excluded
+  Shadow->Sum = (UINT16)(CalculateSum16 ((UINT16 *)Shadow->Data, MS_WHEA_EARLY_STORAGE_HEADER_SIZE) - Header.Checksum);
 
-  if (EFI_ERROR (Status)) {
+  if (!ActiveRangeValid) {
+    DEBUG ((DEBUG_ERROR, "%a: Bad active range %d\n", __FUNCTION__, Header.ActiveRange));
     goto Cleanup;
   }
 
+  if (Header.ActiveRange != 0) {
+    Status = MsWheaEarlyStorageRead (
+               &Shadow->Data[MS_WHEA_EARLY_STORAGE_DATA_OFFSET],
+               (UINT8)Header.ActiveRange,
+               MS_WHEA_EARLY_STORAGE_DATA_OFFSET
+               );
+    if (EFI_ERROR (Status)) {
+      goto Cleanup;
+    }
+
+    Shadow->Sum = Shadow->Sum + CalculateSum16 ((UINT16 *)&Shadow->Data[MS_WHEA_EARLY_STORAGE_DATA_OFFSET], Header.ActiveRange);
+  }
+
+  Shadow->Valid = (BOOLEAN)((Header.Signature == MS_WHEA_EARLY_STORAGE_SIGNATURE) &&
+                            ((UINT16)(Shadow->Sum + Header.Checksum) == 0));
+
+Cleanup:
+  return Status;
+}
+
+/**
+
+This routine loads the header and active range of the MS WHEA store into a RAM shadow with one pass over
+the store, and verifies the signature and checksum on the way.
+
+@param[out] Shadow                    The shadow to load
+
+@retval EFI_SUCCESS                   The shadow was loaded. Shadow->Valid tells whether the store was valid.
+@retval EFI_INVALID_PARAMETER         Shadow was NULL
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowLoad (
+  OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow
+  )
+{
+  return MsWheaESShadowLoadInternal (Shadow, TRUE);
+}
+
+/**
+
+This routine resets a shadow to an empty store with a fresh header. The whole header is marked dirty so
+the next MsWheaESShadowCommit rewrites it.
+
+@param[out] Shadow                    The shadow to reset
+
+**/
+STATIC
+VOID
+MsWheaESShadowReset (
+  OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow
+  )
+{
+  MS_WHEA_EARLY_STORAGE_HEADER  Header;
+
+  ZeroMem (Shadow, sizeof (*Shadow));
+  ZeroMem (&Header, sizeof (Header));
+  Header.Signature = MS_WHEA_EARLY_STORAGE_SIGNATURE;
+
+  Shadow->Sum     = CalculateSum16 ((UINT16 *)&Header, MS_WHEA_EARLY_STORAGE_HEADER_SIZE);
+  Header.Checksum = (UINT16)(0x10000 - Shadow->Sum);
+  MsWheaESShadowSetBytes (Shadow, 0, &Header, (UINT8)MS_WHEA_EARLY_STORAGE_HEADER_SIZE, TRUE);
+  Shadow->Valid = TRUE;
+}
+
+/**
+
+This routine appends an MS_WHEA_EARLY_STORAGE_ENTRY_V0 record to a loaded shadow. The active range and
+checksum are updated incrementally. Nothing is written to the store until MsWheaESShadowCommit is called.
+
+@param[in, out] Shadow                The shadow loaded by MsWheaESShadowLoad
+@param[in]      MsWheaEntry           The record to append
+
+@retval EFI_SUCCESS                   The record was appended
+@retval EFI_OUT_OF_RESOURCES          The store is full
+@retval EFI_INVALID_PARAMETER         Null pointer detected
+@retval EFI_VOLUME_CORRUPTED          The shadow does not hold a valid store
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowAddRecordV0 (
+  IN OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow,
+  IN MS_WHEA_EARLY_STORAGE_ENTRY_V0    *MsWheaEntry
+  )
+{
+  EFI_STATUS                    Status;
+  MS_WHEA_EARLY_STORAGE_HEADER  Header;
+  UINT8                         Offset;
+  UINT16                        Sum;
+
+  if ((Shadow == NULL) || (MsWheaEntry == NULL)) {
+    Status = EFI_INVALID_PARAMETER;
+    goto Cleanup;
+  }
+
+  // The running sum and active range of an invalid shadow cannot be trusted
+  if (!Shadow->Valid) {
+    Status = EFI_VOLUME_CORRUPTED;
+    goto Cleanup;
+  }
+
+  CopyMem (&Header, Shadow->Data, MS_WHEA_EARLY_STORAGE_HEADER_SIZE);
+
+  if ((Header.ActiveRange > MsWheaESGetMaxDataCount ()) ||
+      (MsWheaESGetMaxDataCount () - Header.ActiveRange < sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0)))
+  {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Cleanup;
+  }
+
+  Offset = (UINT8)(MS_WHEA_EARLY_STORAGE_DATA_OFFSET + Header.ActiveRange);
+  MsWheaESShadowSetBytes (Shadow, Offset, MsWheaEntry, (UINT8)sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0), TRUE);
+
+  // Swap the old active range out of the sum for the new one, then add the new record
+  Sum                = Shadow->Sum;
+  Sum                = (Sum - (UINT16)(Header.ActiveRange & MAX_UINT16) - (UINT16)((Header.ActiveRange >> 16) & MAX_UINT16));
   Header.ActiveRange += sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0);
+  Sum                = (Sum + (UINT16)(Header.ActiveRange & MAX_UINT16) + (UINT16)((Header.ActiveRange >> 16) & MAX_UINT16));
+  Sum                = Sum + CalculateSum16 ((UINT16 *)&Shadow->Data[Offset], sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0));
 
-  Status = MsWheaESCalculateChecksum16 (
-             &Header,
-             &Checksum
-             );
+  Shadow->Sum     = Sum;
+  Header.Checksum = (UINT16)(0x10000 - Sum);
+  MsWheaESShadowSetBytes (Shadow, 0, &Header, (UINT8)MS_WHEA_EARLY_STORAGE_HEADER_SIZE, FALSE);
+
+  Status = EFI_SUCCESS;
+
+Cleanup:
+  return Status;
+}
+
+/**
+
+This routine writes the bytes of a shadow that changed since it was loaded or last committed back to the
+MS WHEA store. Any number of appends can be committed together.
+
+@param[in, out] Shadow                The shadow to commit
+
+@retval EFI_SUCCESS                   All dirty bytes were written
+@retval EFI_INVALID_PARAMETER         Shadow was NULL
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowCommit (
+  IN OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+  UINTN       Start;
+
+  if (Shadow == NULL) {
+    Status = EFI_INVALID_PARAMETER;
+    goto Cleanup;
+  }
+
+  Status = EFI_SUCCESS;
+  Index  = 0;
+  while (Index < MS_WHEA_EARLY_STORAGE_SHADOW_SIZE) {
+    if ((Shadow->Dirty[Index / 8] & (1 << (Index % 8))) == 0) {
+      Index++;
+      continue;
+    }
+
+    // Write each run of dirty bytes with a single call
+    Start = Index;
+    while ((Index < MS_WHEA_EARLY_STORAGE_SHADOW_SIZE) &&
+           ((Shadow->Dirty[Index / 8] & (1 << (Index % 8))) != 0))
+    {
+      Index++;
+    }
+
+    Status = MsWheaEarlyStorageWrite (&Shadow->Data[Start], (UINT8)(Index - Start), (UINT8)Start);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: Writing %d bytes at %d failed %r\n", __FUNCTION__, Index - Start, Start, Status));
+      goto Cleanup;
+    }
+  }
+
+  ZeroMem (Shadow->Dirty, sizeof (Shadow->Dirty));
+
+Cleanup:
+  return Status;
+}
+
+/**
+This routine adds an MS_WHEA_EARLY_STORAGE_ENTRY_V0 record to the WHEA early store region. The header
+checksum and active range will be updated in the process.
+
+The checksum is updated from the stored one, so only the header is read and only the new record and the
+header bytes that changed are written. A store whose signature or active range is bad is reset first.
 
+@param[in]  MsWheaEntry             The MS_WHEA_EARLY_STORAGE_ENTRY_V0 to be added
+
+@retval     EFI_SUCCESS             The record was added
+@retval     EFI_OUT_OF_RESOURCES    The CMOS ES region is full
+@retval     EFI_INVALID_PARAMETER   MsWheaEntry was NULL
+
+**/
+STATIC
+EFI_STATUS
+MsWheaESAddRecordV0Internal (
+  IN MS_WHEA_EARLY_STORAGE_ENTRY_V0  *MsWheaEntry
+  )
+{
+  EFI_STATUS                    Status;
+  MS_WHEA_EARLY_STORAGE_SHADOW  Shadow;
+  MS_WHEA_EARLY_STORAGE_HEADER  Header;
+  UINT16                        Checksum;
+
+  if (MsWheaEntry == NULL) {
+    Status = EFI_INVALID_PARAMETER;
+    goto Cleanup;
+  }
+
+  Status = MsWheaESShadowLoadInternal (&Shadow, FALSE);
   if (EFI_ERROR (Status)) {
     goto Cleanup;
   }
 
-  Header.Checksum = Checksum;
+  if (!Shadow.Valid) {
+    DEBUG ((DEBUG_WARN, "%a: Early Storage is not valid, resetting it\n", __FUNCTION__));
+    MsWheaESShadowReset (&Shadow);
+  }
 
-  Status = MsWheaEarlyStorageWrite (
-             &Header,
-             MS_WHEA_EARLY_STORAGE_HEADER_SIZE,
-             0
-             );
+  Status = MsWheaESShadowAddRecordV0 (&Shadow, MsWheaEntry);
+  if (EFI_ERROR (Status)) {
+    goto Cleanup;
+  }
 
-  ZeroMem (
-    &Header,
-    sizeof (Header)
-    );
+  Status = MsWheaESShadowCommit (&Shadow);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Write V0 Early Storage failed %r\n", __FUNCTION__, Status));
+    goto Cleanup;
+  }
 
+  // Read back the checksum to make sure the header write landed
+  CopyMem (&Header, Shadow.Data, MS_WHEA_EARLY_STORAGE_HEADER_SIZE);
   Status = MsWheaEarlyStorageRead (
-             &Header,
-             MS_WHEA_EARLY_STORAGE_HEADER_SIZE,
-             0
+             &Checksum,
+             (UINT8)sizeof (Checksum),
+             OFFSET_OF (MS_WHEA_EARLY_STORAGE_HEADER, Checksum)
              );
 
-  if (Header.Checksum != Checksum) {
+  if (Checksum != Header.Checksum) {
     DEBUG ((
       DEBUG_ERROR,
       "%a: - Checksum Write Failed. Actual: %d, Expected: %d\n",
       __FUNCTION__,
-      Header.Checksum,
-      Checksum
+      Checksum,
+      Header.Checksum
       ));
   }
 
@@ -188,3 +188,70 @@ MsWheaESAddRecordV0 (
 {
   return EFI_UNSUPPORTED;
 }
+
+/**
+
+This routine loads the header and active range of the MS WHEA store into a RAM shadow with one pass over
+the store, and verifies the signature and checksum on the way.
+
+@param[out] Shadow                    The shadow to load
+
+@retval EFI_SUCCESS                   The shadow was loaded. Shadow->Valid tells whether the store was valid.
+@retval EFI_INVALID_PARAMETER         Shadow was NULL
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowLoad (
+  OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+
+This routine appends an MS_WHEA_EARLY_STORAGE_ENTRY_V0 record to a loaded shadow. The active range and
+checksum are updated incrementally. Nothing is written to the store until MsWheaESShadowCommit is called.
+
+@param[in, out] Shadow                The shadow loaded by MsWheaESShadowLoad
+@param[in]      MsWheaEntry           The record to append
+
+@retval EFI_SUCCESS                   The record was appended
+@retval EFI_OUT_OF_RESOURCES          The store is full
+@retval EFI_INVALID_PARAMETER         Null pointer detected
+@retval EFI_VOLUME_CORRUPTED          The shadow does not hold a valid store
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowAddRecordV0 (
+  IN OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow,
+  IN MS_WHEA_EARLY_STORAGE_ENTRY_V0    *MsWheaEntry
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+
+This routine writes the bytes of a shadow that changed since it was loaded or last committed back to the
+MS WHEA store. Any number of appends can be committed together.
+
+@param[in, out] Shadow                The shadow to commit
+
+@retval EFI_SUCCESS                   All dirty bytes were written
+@retval EFI_INVALID_PARAMETER         Shadow was NULL
+@retval EFI_UNSUPPORTED               The function is unimplemented
+
+**/
+EFI_STATUS
+EFIAPI
+MsWheaESShadowCommit (
+  IN OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow
+  )
+{
+  return EFI_UNSUPPORTED;
+}
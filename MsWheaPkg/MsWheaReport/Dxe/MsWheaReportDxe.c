@@ -548,84 +548,6 @@ PopulateTime (
   return !EFI_ERROR (Status);
 }
 
-/**
-Gets the Record ID variable and increments it for WHEA records
-
-@param[in,out]  *RecordID                   Pointer to a UINT64 which will contain the record ID to be put on the next WHEA Record
-
-@retval          EFI_SUCCESS                The firmware has successfully stored the variable and its data as
-                                            defined by the Attributes.
-@retval          EFI_INVALID_PARAMETER      An invalid combination of attribute bits, name, and GUID was supplied, or the
-                                            DataSize exceeds the maximum allowed.
-@retval          EFI_INVALID_PARAMETER      VariableName is an empty string.
-@retval          EFI_OUT_OF_RESOURCES       Not enough storage is available to hold the variable and its data.
-@retval          EFI_DEVICE_ERROR           The variable could not be retrieved due to a hardware error.
-@retval          EFI_WRITE_PROTECTED        The variable in question is read-only.
-@retval          EFI_WRITE_PROTECTED        The variable in question cannot be deleted.
-@retval          EFI_SECURITY_VIOLATION     The variable could not be written due to EFI_VARIABLE_TIME_BASED_AUTHENTICATED_WRITE_ACCESS being set,
-                                            but the AuthInfo does NOT pass the validation check carried out by the firmware.
-@retval          EFI_NOT_FOUND              The variable trying to be updated or deleted was not found.
-**/
-EFI_STATUS
-GetRecordID (
-  UINT64  *RecordID
-  )
-{
-  UINTN       Size = 0;
-  UINT32      Attr;
-  EFI_STATUS  Status;
-
-  // Get the last record ID number used
-  Status = gRT->GetVariable (
-                  MS_WHEA_RECORD_ID_VAR_NAME,
-                  &gMsWheaReportRecordIDGuid,
-                  &Attr,
-                  &Size,
-                  NULL
-                  );
-  if (Status == EFI_NOT_FOUND) {
-    DEBUG ((DEBUG_INFO, "%a Record ID variable not retrieved, initializing to 0\n", __FUNCTION__));
-    *RecordID = 0;
-  } else if ((Status != EFI_BUFFER_TOO_SMALL) ||
-             (Attr != MS_WHEA_RECORD_ID_VAR_ATTR) ||
-             (Size != MS_WHEA_RECORD_ID_VAR_LEN))
-  {
-    DEBUG ((
-      DEBUG_INFO,
-      "%a Record ID variable has size: 0x%x, attribute: %08x; but expecting size: 0x%x, attribute: %08x. Deleting the variable for re-initialization.\n",
-      __FUNCTION__,
-      Size,
-      Attr,
-      MS_WHEA_RECORD_ID_VAR_LEN,
-      MS_WHEA_RECORD_ID_VAR_ATTR
-      ));
-    // This variable is whacked, flush it...
-    Status = gRT->SetVariable (MS_WHEA_RECORD_ID_VAR_NAME, &gMsWheaReportRecordIDGuid, Attr, 0, NULL);
-    ASSERT_EFI_ERROR (Status);
-    *RecordID = 0;
-  } else {
-    Status = gRT->GetVariable (
-                    MS_WHEA_RECORD_ID_VAR_NAME,
-                    &gMsWheaReportRecordIDGuid,
-                    &Attr,
-                    &Size,
-                    RecordID
-                    );
-    ASSERT_EFI_ERROR (Status);
-  }
-
-  (*RecordID)++; // increment the record ID number
-
-  // Set the variable so the next record uses a unique record ID
-  return gRT->SetVariable (
-                MS_WHEA_RECORD_ID_VAR_NAME,
-                &gMsWheaReportRecordIDGuid,
-                MS_WHEA_RECORD_ID_VAR_ATTR,
-                Size,
-                RecordID
-                );
-}
-
 /**
 Register Write Architecture and Variable Architecture callbacks
 
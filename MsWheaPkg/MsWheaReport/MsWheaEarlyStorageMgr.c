@@ -57,40 +57,6 @@ Cleanup:
 
 /**
 
-This is a helper function that writes the early storage region with an offset of header size.
-
-@param[in]  Ptr                       The pointer to hold intended written data
-@param[in]  Size                      The size of intended written data
-@param[in]  Offset                    The offset of written data, ranging from 0 to
-                                      PcdMsWheaReportEarlyStorageCapacity - MS_WHEA_EARLY_STORAGE_DATA_OFFSET
-
-@retval EFI_SUCCESS                   Operation is successful
-@retval EFI_INVALID_PARAMETER         Null pointer or zero or over length request detected
-
-**/
-STATIC
-EFI_STATUS
-MsWheaESWriteData (
-  VOID   *Ptr,
-  UINT8  Size,
-  UINT8  Offset
-  )
-{
-  EFI_STATUS  Status;
-
-  if (Offset >= MsWheaESGetMaxDataCount ()) {
-    Status = EFI_INVALID_PARAMETER;
-    goto Cleanup;
-  }
-
-  Status = MsWheaEarlyStorageWrite (Ptr, Size, MS_WHEA_EARLY_STORAGE_DATA_OFFSET + Offset);
-
-Cleanup:
-  return Status;
-}
-
-/**
-
 This is a helper function that clears the early storage region with an offset of header size.
 
 @param[in]  Size                      The size of intended clear data
@@ -212,39 +178,6 @@ MsWheaESWriteHeader (
 
 /**
 
-This routine calculates the checksum of early storage region and update the range and checksum in
-header accordingly.
-
-**/
-STATIC
-VOID
-MsWheaESContentChangeChecksumHelper (
-  UINT16  *Buffer,
-  UINTN   Length
-  )
-{
-  UINT16                        Sum16;
-  MS_WHEA_EARLY_STORAGE_HEADER  Header;
-
-  DEBUG ((DEBUG_INFO, "Calculate sum content helper...\n"));
-
-  MsWheaESReadHeader (&Header);
-  Sum16 = (UINT16)(0x10000 - Header.Checksum);
-
-  // Update length field of header, update checksum accordingly
-  Sum16               = (Sum16 - (UINT16)(Header.ActiveRange & MAX_UINT16) - (UINT16)((Header.ActiveRange >> 16) & MAX_UINT16));
-  Header.ActiveRange += (UINT32)Length;
-  Sum16               = (Sum16 + (UINT16)(Header.ActiveRange & MAX_UINT16) + (UINT16)((Header.ActiveRange >> 16) & MAX_UINT16));
-
-  // Calculate updated chunk only
-  Sum16           = Sum16 + CalculateSum16 (Buffer, Length);
-  Header.Checksum = (UINT16)(0x10000 - Sum16);
-
-  MsWheaESWriteHeader (&Header);
-}
-
-/**
-
 This routine calculates and updates the checksum based on the supplied header.
 
 **/
@@ -362,29 +295,25 @@ Cleanup:
 }
 
 /**
-This routine will extract necessary Rev 0 information from supplied metadata and store onto the next
-contiguously available Early Storage data region
+This routine will extract necessary Rev 0 information from supplied metadata and append it to the
+Early Storage shadow
 
-@param[in]  MsWheaEntryMD             The pointer to reported MS WHEA error metadata
+@param[in, out] Shadow                The Early Storage shadow
+@param[in]      MsWheaEntryMD         The pointer to reported MS WHEA error metadata
 
 @retval EFI_SUCCESS                   Operation is successful
-@retval Others                        See MsWheaESFindSlot and MsWheaESWriteData for more details
+@retval Others                        See MsWheaESShadowAddRecordV0 for more details
 **/
 STATIC
 EFI_STATUS
 MsWheaESV0InfoStore (
-  IN MS_WHEA_ERROR_ENTRY_MD  *MsWheaEntryMD
+  IN OUT MS_WHEA_EARLY_STORAGE_SHADOW  *Shadow,
+  IN MS_WHEA_ERROR_ENTRY_MD            *MsWheaEntryMD
   )
 {
-  UINT8                           Offset = 0;
   EFI_STATUS                      Status;
   MS_WHEA_EARLY_STORAGE_ENTRY_V0  WheaV0;
 
-  Status = MsWheaESFindSlot (sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0), &Offset);
-  if (EFI_ERROR (Status) != FALSE) {
-    goto Cleanup;
-  }
-
   SetMem (&WheaV0, sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0), 0);
 
   WheaV0.Rev              = MsWheaEntryMD->Rev;
@@ -395,15 +324,11 @@ MsWheaESV0InfoStore (
   CopyMem (&WheaV0.PartitionID, &MsWheaEntryMD->IhvSharingGuid, sizeof (EFI_GUID));
   CopyMem (&WheaV0.ModuleID, &MsWheaEntryMD->ModuleID, sizeof (EFI_GUID));
 
-  Status = MsWheaESWriteData (&WheaV0, sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0), Offset);
+  Status = MsWheaESShadowAddRecordV0 (Shadow, &WheaV0);
   if (EFI_ERROR (Status) != FALSE) {
-    DEBUG ((DEBUG_ERROR, "%a: Clear V0 Early Storage failed at %d %r\n", __FUNCTION__, Offset, Status));
-    goto Cleanup;
+    DEBUG ((DEBUG_ERROR, "%a: Add V0 Early Storage failed %r\n", __FUNCTION__, Status));
   }
 
-  MsWheaESContentChangeChecksumHelper ((UINT16 *)&WheaV0, sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0));
-
-Cleanup:
   return Status;
 }
 
@@ -571,7 +496,7 @@ This routine will store data onto Early Storage data region based on supplied MS
 @param[in]  MsWheaEntryMD             The pointer to reported MS WHEA error metadata
 
 @retval EFI_SUCCESS                   Operation is successful
-@retval Others                        See MsWheaESFindSlot and MsWheaESWriteData for more
+@retval Others                        See MsWheaESShadowAddRecordV0 and MsWheaESShadowCommit for more
                                       details
 **/
 EFI_STATUS
@@ -583,6 +508,7 @@ MsWheaESStoreEntry (
   UINT8                         Rev    = 0;
   EFI_STATUS                    Status = EFI_SUCCESS;
   MS_WHEA_EARLY_STORAGE_HEADER  Header;
+  MS_WHEA_EARLY_STORAGE_SHADOW  Shadow;
 
   if (MsWheaEntryMD == NULL) {
     DEBUG ((DEBUG_ERROR, "%a: input pointer cannot be null!\n", __FUNCTION__));
@@ -590,18 +516,21 @@ MsWheaESStoreEntry (
     goto Cleanup;
   }
 
-  // Make sure the Early Storage is valid.
-  if (MsWheaESRegionIsValid (&Header) == FALSE) {
+  // Load the Early Storage once, which also makes sure it is valid.
+  Status = MsWheaESShadowLoad (&Shadow);
+  if (EFI_ERROR (Status) || (Shadow.Valid == FALSE)) {
     DEBUG ((DEBUG_ERROR, "%a: the Early Storage is not valid!\n", __FUNCTION__));
     Status = EFI_NOT_FOUND;
     goto Cleanup;
   }
 
+  CopyMem (&Header, Shadow.Data, MS_WHEA_EARLY_STORAGE_HEADER_SIZE);
+
   Rev = MsWheaEntryMD->Rev;
   switch (Rev) {
     case MS_WHEA_REV_0:
       // Store Rev0 structure
-      Status = MsWheaESV0InfoStore (MsWheaEntryMD);
+      Status = MsWheaESV0InfoStore (&Shadow, MsWheaEntryMD);
       break;
     default:
       // Any unsupported revisions are not stored
@@ -609,7 +538,9 @@ MsWheaESStoreEntry (
       break;
   }
 
-  if (Status == EFI_OUT_OF_RESOURCES) {
+  if (Status == EFI_SUCCESS) {
+    Status = MsWheaESShadowCommit (&Shadow);
+  } else if (Status == EFI_OUT_OF_RESOURCES) {
     // Early Storage is full, write the header error section
     DEBUG ((DEBUG_WARN, "%a: the Early Storage is full at %d!\n", __FUNCTION__, Header.ActiveRange));
     MsWheaESSetHeaderFull (MsWheaEntryMD->Phase, &Header);
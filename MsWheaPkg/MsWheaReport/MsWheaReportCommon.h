@@ -37,6 +37,11 @@ Definition wrapper to unify all bert/hwerrrec related specification versioning
 #define MS_WHEA_RECORD_ID_VAR_LEN   sizeof (UINT64)
 #define MS_WHEA_RECORD_ID_VAR_ATTR  (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS)
 
+//
+// Number of record IDs reserved by each write of the RecordID variable
+//
+#define MS_WHEA_RECORD_ID_BATCH_SIZE  32
+
 /**
 
  Accepted phase values
@@ -148,7 +153,8 @@ PopulateTime (
   );
 
 /**
-Gets the Record ID variable and increments it for WHEA records
+Gets the next record ID for WHEA records. IDs are reserved in the Record ID variable
+MS_WHEA_RECORD_ID_BATCH_SIZE at a time.
 
 @param[in,out]  *RecordID                   Pointer to a UINT64 which will contain the record ID to be put on the next WHEA Record
 
@@ -23,6 +23,23 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define STATIC    // Nothing...
 #endif
 
+//
+// HwErrRec slot cache. Built from one enumeration of the variable store, it holds a bit
+// for every slot known to be in use, so the holes left by deleted records can be reused
+// without probing each name in turn. mHwErrRecSearchStart is the lowest slot that may be
+// free. Slots the cache believes are free are still confirmed with one GetVariable before
+// use, in case another agent wrote a record since the scan.
+//
+STATIC UINT8   *mHwErrRecUsedBitmap = NULL;
+STATIC UINT32  mHwErrRecSearchStart = 0;
+
+//
+// Record ID reservation. Ids up to mRecordIDLimit have been reserved in the RecordID
+// variable, and mRecordID is the last one handed out.
+//
+STATIC UINT64  mRecordID      = 0;
+STATIC UINT64  mRecordIDLimit = 0;
+
 /**
 This routine will fill out the CPER header for caller.
 
@@ -344,9 +361,283 @@ Cleanup:
 
 /**
 
+Reads the RecordID variable, which holds the last record ID reserved by any agent.
+
+@param[out]  RecordID                   The last reserved record ID, 0 if there is none
+
+@retval EFI_SUCCESS                     RecordID was populated.
+@retval Others                          See GetVariable for more details
+
+**/
+STATIC
+EFI_STATUS
+MsWheaReadRecordID (
+  OUT UINT64  *RecordID
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Size;
+  UINT32      Attr;
+
+  Size   = MS_WHEA_RECORD_ID_VAR_LEN;
+  Status = WheaGetVariable (
+             MS_WHEA_RECORD_ID_VAR_NAME,
+             &gMsWheaReportRecordIDGuid,
+             &Attr,
+             &Size,
+             RecordID
+             );
+  if (Status == EFI_NOT_FOUND) {
+    DEBUG ((DEBUG_INFO, "%a Record ID variable not retrieved, initializing to 0\n", __FUNCTION__));
+    *RecordID = 0;
+    Status    = EFI_SUCCESS;
+  } else if (((Status == EFI_SUCCESS) || (Status == EFI_BUFFER_TOO_SMALL)) &&
+             ((Attr != MS_WHEA_RECORD_ID_VAR_ATTR) || (Size != MS_WHEA_RECORD_ID_VAR_LEN)))
+  {
+    DEBUG ((
+      DEBUG_INFO,
+      "%a Record ID variable has size: 0x%x, attribute: %08x; but expecting size: 0x%x, attribute: %08x. Deleting the variable for re-initialization.\n",
+      __FUNCTION__,
+      Size,
+      Attr,
+      MS_WHEA_RECORD_ID_VAR_LEN,
+      MS_WHEA_RECORD_ID_VAR_ATTR
+      ));
+    // This variable is whacked, flush it...
+    Status = WheaSetVariable (MS_WHEA_RECORD_ID_VAR_NAME, &gMsWheaReportRecordIDGuid, Attr, 0, NULL);
+    ASSERT_EFI_ERROR (Status);
+    *RecordID = 0;
+    Status    = EFI_SUCCESS;
+  }
+
+  return Status;
+}
+
+/**
+Gets the next record ID for WHEA records.
+
+Record IDs are reserved MS_WHEA_RECORD_ID_BATCH_SIZE at a time, so the RecordID variable is
+only written once per batch rather than once per record. The variable is read again before
+each reservation so blocks reserved by other agents are not reused. IDs left over in a block
+at reset are skipped; record IDs only need to be unique and increasing.
+
+@param[in,out]  *RecordID                   Pointer to a UINT64 which will contain the record ID to be put on the next WHEA Record
+
+@retval          EFI_SUCCESS                The record ID was reserved.
+@retval          Others                     See GetVariable/SetVariable for more details. RecordID is still
+                                            populated, but may not have been reserved.
+**/
+EFI_STATUS
+GetRecordID (
+  UINT64  *RecordID
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      LastReserved;
+  UINT64      NewLimit;
+
+  if (mRecordID < mRecordIDLimit) {
+    *RecordID = ++mRecordID;
+    return EFI_SUCCESS;
+  }
+
+  // Get the last record ID number reserved
+  Status = MsWheaReadRecordID (&LastReserved);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a Record ID variable could not be read - %r\n", __FUNCTION__, Status));
+    *RecordID = mRecordID + 1;
+    return Status;
+  }
+
+  mRecordID = MAX (mRecordID, LastReserved);
+  NewLimit  = mRecordID + MS_WHEA_RECORD_ID_BATCH_SIZE;
+
+  // Set the variable so the next batch of records uses unique record IDs
+  Status = WheaSetVariable (
+             MS_WHEA_RECORD_ID_VAR_NAME,
+             &gMsWheaReportRecordIDGuid,
+             MS_WHEA_RECORD_ID_VAR_ATTR,
+             MS_WHEA_RECORD_ID_VAR_LEN,
+             &NewLimit
+             );
+  if (EFI_ERROR (Status)) {
+    // Hand out the next ID anyway, but try to reserve again next time
+    *RecordID = mRecordID + 1;
+    return Status;
+  }
+
+  mRecordIDLimit = NewLimit;
+  *RecordID      = ++mRecordID;
+  return EFI_SUCCESS;
+}
+
+/**
+
+Parses the slot number out of a HwErrRecXXXX variable name.
+
+@param[in]  VarName                     The variable name
+@param[out] Slot                        The slot number
+
+@retval TRUE                            VarName is HwErrRec followed by 4 hexadecimal digits.
+@retval FALSE                           Otherwise.
+
+**/
+STATIC
+BOOLEAN
+MsWheaParseSlotFromName (
+  IN  CONST CHAR16  *VarName,
+  OUT UINT32        *Slot
+  )
+{
+  UINTN   Index;
+  CHAR16  Char;
+
+  if (StrnCmp (VarName, EFI_HW_ERR_REC_VAR_NAME, StrLen (EFI_HW_ERR_REC_VAR_NAME)) != 0) {
+    return FALSE;
+  }
+
+  VarName += StrLen (EFI_HW_ERR_REC_VAR_NAME);
+  *Slot    = 0;
+  for (Index = 0; Index < 4; Index++) {
+    Char = VarName[Index];
+    if ((Char >= L'0') && (Char <= L'9')) {
+      *Slot = (*Slot << 4) | (Char - L'0');
+    } else if ((Char >= L'A') && (Char <= L'F')) {
+      *Slot = (*Slot << 4) | (Char - L'A' + 10);
+    } else if ((Char >= L'a') && (Char <= L'f')) {
+      *Slot = (*Slot << 4) | (Char - L'a' + 10);
+    } else {
+      return FALSE;
+    }
+  }
+
+  return (BOOLEAN)(VarName[Index] == L'\0');
+}
+
+/**
+
+Discards the HwErrRec slot cache. The next slot lookup will scan the variable store again.
+
+**/
+STATIC
+VOID
+MsWheaInvalidateSlotCache (
+  VOID
+  )
+{
+  if (mHwErrRecUsedBitmap != NULL) {
+    FreePool (mHwErrRecUsedBitmap);
+    mHwErrRecUsedBitmap = NULL;
+  }
+
+  mHwErrRecSearchStart = 0;
+}
+
+/**
+
+Builds the HwErrRec slot cache with one pass over the variable store.
+
+@retval EFI_SUCCESS                     The cache was built.
+@retval EFI_OUT_OF_RESOURCES            Memory for the cache could not be allocated.
+@retval Others                          See GetNextVariableName for more details
+
+**/
+STATIC
+EFI_STATUS
+MsWheaBuildSlotCache (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Bitmap;
+  CHAR16      *Name;
+  CHAR16      *NewName;
+  UINTN       NameSize;
+  UINTN       NewNameSize;
+  EFI_GUID    Guid;
+  UINT32      Slot;
+  UINT32      MaxCount;
+
+  MaxCount = (UINT32)PcdGet16 (PcdVariableHardwareMaxCount) + 1;
+  NameSize = EFI_HW_ERR_REC_VAR_NAME_LEN * sizeof (CHAR16);
+  Bitmap   = AllocateZeroPool ((MaxCount + 7) / 8);
+  Name     = AllocateZeroPool (NameSize);
+  if ((Bitmap == NULL) || (Name == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Cleanup;
+  }
+
+  while (TRUE) {
+    NewNameSize = NameSize;
+    Status      = WheaGetNextVariableName (&NewNameSize, Name, &Guid);
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      NewName = ReallocatePool (NameSize, NewNameSize, Name);
+      if (NewName == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+        break;
+      }
+
+      Name     = NewName;
+      NameSize = NewNameSize;
+      continue;
+    }
+
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    if (CompareGuid (&Guid, &gEfiHardwareErrorVariableGuid) &&
+        MsWheaParseSlotFromName (Name, &Slot) &&
+        (Slot < MaxCount))
+    {
+      Bitmap[Slot / 8] |= (UINT8)(1 << (Slot % 8));
+    }
+  }
+
+  if (Status == EFI_NOT_FOUND) {
+    MsWheaInvalidateSlotCache ();
+    mHwErrRecUsedBitmap = Bitmap;
+    Bitmap              = NULL;
+    Status              = EFI_SUCCESS;
+  }
+
+Cleanup:
+  if (Bitmap != NULL) {
+    FreePool (Bitmap);
+  }
+
+  if (Name != NULL) {
+    FreePool (Name);
+  }
+
+  return Status;
+}
+
+/**
+
+Marks a HwErrRec slot as in use in the slot cache, if there is one.
+
+@param[in]  Slot                        The slot number
+
+**/
+STATIC
+VOID
+MsWheaMarkSlotUsed (
+  IN UINT32  Slot
+  )
+{
+  if ((mHwErrRecUsedBitmap != NULL) && (Slot <= PcdGet16 (PcdVariableHardwareMaxCount))) {
+    mHwErrRecUsedBitmap[Slot / 8] |= (UINT8)(1 << (Slot % 8));
+  }
+}
+
+/**
+
 This routine accepts the pointer to a UINT16 number. It will iterate through each HwErrRecXXXX and stops
 after PcdVariableHardwareMaxCount iterations or spotted a slot that returns EFI_NOT_FOUND.
 
+This is the fallback used when the variable store can't be enumerated to build the slot cache.
+
 @param[out]  next                       The pointer to output result holder
 
 @retval EFI_SUCCESS                     Entry addition is successful.
@@ -357,7 +648,7 @@ after PcdVariableHardwareMaxCount iterations or spotted a slot that returns EFI_
 **/
 STATIC
 EFI_STATUS
-MsWheaFindNextAvailableSlot (
+MsWheaProbeNextAvailableSlot (
   OUT UINT16  *next
   )
 {
@@ -402,6 +693,85 @@ Cleanup:
 
 /**
 
+This routine accepts the pointer to a UINT16 number and returns the lowest HwErrRecXXXX slot that
+is not in use, up to PcdVariableHardwareMaxCount.
+
+The first call scans the variable store once to build the slot cache. Later calls start from the
+lowest slot that may be free and confirm the candidate with a single GetVariable.
+
+@param[out]  next                       The pointer to output result holder
+
+@retval EFI_SUCCESS                     Entry addition is successful.
+@retval EFI_INVALID_PARAMETER           Input pointer is NULL.
+@retval EFI_OUT_OF_RESOURCES            No available slot for HwErrRec.
+@retval Others                          See GetVariable for more details
+
+**/
+STATIC
+EFI_STATUS
+MsWheaFindNextAvailableSlot (
+  OUT UINT16  *next
+  )
+{
+  EFI_STATUS  Status;
+  UINT32      Index;
+  UINT32      MaxCount;
+  UINTN       Size;
+  CHAR16      VarName[EFI_HW_ERR_REC_VAR_NAME_LEN];
+
+  if (next == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mHwErrRecUsedBitmap == NULL) {
+    Status = MsWheaBuildSlotCache ();
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_INFO, "%a: Slot cache not built (%r), probing each slot\n", __FUNCTION__, Status));
+      return MsWheaProbeNextAvailableSlot (next);
+    }
+  }
+
+  MaxCount = (UINT32)PcdGet16 (PcdVariableHardwareMaxCount) + 1;
+  for (Index = mHwErrRecSearchStart; Index < MaxCount; Index++) {
+    // Skip whole bytes of used slots
+    if (((Index % 8) == 0) && (mHwErrRecUsedBitmap[Index / 8] == MAX_UINT8)) {
+      Index += 7;
+      continue;
+    }
+
+    if ((mHwErrRecUsedBitmap[Index / 8] & (1 << (Index % 8))) != 0) {
+      continue;
+    }
+
+    Size = 0;
+    UnicodeSPrint (VarName, sizeof (VarName), L"%s%04X", EFI_HW_ERR_REC_VAR_NAME, (UINT16)(Index & MAX_UINT16));
+    Status = WheaGetVariable (
+               VarName,
+               &gEfiHardwareErrorVariableGuid,
+               NULL,
+               &Size,
+               NULL
+               );
+    if (Status == EFI_NOT_FOUND) {
+      mHwErrRecSearchStart = Index;
+      *next                = (UINT16)(Index & MAX_UINT16);
+      return EFI_SUCCESS;
+    }
+
+    if ((Status != EFI_SUCCESS) && (Status != EFI_BUFFER_TOO_SMALL)) {
+      return Status;
+    }
+
+    // Written by someone else since the scan
+    MsWheaMarkSlotUsed (Index);
+  }
+
+  mHwErrRecSearchStart = MaxCount;
+  return EFI_OUT_OF_RESOURCES;
+}
+
+/**
+
 Clear all the HwErrRec entries on flash.
 
 @retval EFI_SUCCESS                     Entry addition is successful.
@@ -484,6 +854,8 @@ MsWheaClearAllEntries (
     FreePool (Name);
   }
 
+  MsWheaInvalidateSlotCache ();
+
   DEBUG ((DEBUG_ERROR, "%a exit...\n", __FUNCTION__));
 
   return Status;
@@ -563,6 +935,7 @@ MsWheaReportHERAdd (
     DEBUG ((DEBUG_ERROR, "%a: Write size of %d at index %04X failed with (%r)\n", __FUNCTION__, Size, Index, Status));
   } else {
     DEBUG ((DEBUG_INFO, "%a: Write size of %d at index %04X succeeded\n", __FUNCTION__, Size, Index));
+    MsWheaMarkSlotUsed (Index);
   }
 
 Cleanup:
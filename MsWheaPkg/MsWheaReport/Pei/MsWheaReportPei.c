@@ -126,7 +126,7 @@ PopulateTime (
 }
 
 // A do-nothing function so MsWHeaReportCommon.c doesn't encounter an error when calling GetRecordID() during Pei phase.
-// Dxe phase drivers actually populate time, see GetRecordID() in MsWheaReportDxe.c
+// Dxe and Mm phase drivers reserve record IDs, see GetRecordID() in MsWheaReportHER.c
 EFI_STATUS
 GetRecordID (
   UINT64  *RecordID
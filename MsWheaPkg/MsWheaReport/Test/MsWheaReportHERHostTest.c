@@ -17,6 +17,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DebugLib.h>
 #include <Library/UnitTestLib.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/PrintLib.h>
 
 #include "../MsWheaReportHER.h"
 
@@ -27,7 +28,28 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #endif
 
 #define UNIT_TEST_NAME     "MsWheaReport HER Unit Test"
-#define UNIT_TEST_VERSION  "0.1"
+#define UNIT_TEST_VERSION  "0.2"
+
+#define FAKE_STORE_MAX_ENTRIES  256
+
+//
+// A minimal variable store used by the tests that need GetVariable, GetNextVariableName and SetVariable
+// to agree with each other. Only the first 8 bytes of data are kept, which is enough for the Record ID.
+//
+typedef struct {
+  BOOLEAN     InUse;
+  CHAR16      Name[EFI_HW_ERR_REC_VAR_NAME_LEN];
+  EFI_GUID    Guid;
+  UINT32      Attributes;
+  UINTN       DataSize;
+  UINT64      Data;
+} FAKE_VARIABLE;
+
+STATIC BOOLEAN        mUseFakeStore = FALSE;
+STATIC FAKE_VARIABLE  mFakeStore[FAKE_STORE_MAX_ENTRIES];
+STATIC UINTN          mGetVariableCalls;
+STATIC UINTN          mGetNextVariableNameCalls;
+STATIC UINTN          mSetVariableCalls;
 
 //
 // Prototypes of Internal Functions
@@ -44,6 +66,158 @@ MsWheaAnFBuffer (
   IN OUT UINT32                    *PayloadSize
   );
 
+VOID
+MsWheaInvalidateSlotCache (
+  VOID
+  );
+
+extern UINT64  mRecordID;
+extern UINT64  mRecordIDLimit;
+
+/**
+Finds a variable in the fake store.
+
+@retval NULL                          The variable is not in the store.
+@retval Others                        The store entry.
+
+**/
+STATIC
+FAKE_VARIABLE *
+FakeStoreFind (
+  IN CONST CHAR16    *VariableName,
+  IN CONST EFI_GUID  *VendorGuid
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < FAKE_STORE_MAX_ENTRIES; Index++) {
+    if (mFakeStore[Index].InUse &&
+        (StrCmp (mFakeStore[Index].Name, VariableName) == 0) &&
+        CompareGuid (&mFakeStore[Index].Guid, VendorGuid))
+    {
+      return &mFakeStore[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+Adds or replaces a variable in the fake store without counting a SetVariable call.
+Tests use this to stand in for records written by someone else.
+
+**/
+STATIC
+VOID
+FakeStorePut (
+  IN CONST CHAR16    *VariableName,
+  IN CONST EFI_GUID  *VendorGuid,
+  IN UINT32          Attributes,
+  IN UINTN           DataSize,
+  IN UINT64          Data
+  )
+{
+  FAKE_VARIABLE  *Var;
+  UINTN          Index;
+
+  Var = FakeStoreFind (VariableName, VendorGuid);
+  for (Index = 0; (Var == NULL) && (Index < FAKE_STORE_MAX_ENTRIES); Index++) {
+    if (!mFakeStore[Index].InUse) {
+      Var = &mFakeStore[Index];
+    }
+  }
+
+  assert_non_null (Var);
+  Var->InUse = TRUE;
+  StrCpyS (Var->Name, EFI_HW_ERR_REC_VAR_NAME_LEN, VariableName);
+  CopyGuid (&Var->Guid, VendorGuid);
+  Var->Attributes = Attributes;
+  Var->DataSize   = DataSize;
+  Var->Data       = Data;
+}
+
+/**
+Adds HwErrRecXXXX to the fake store.
+
+**/
+STATIC
+VOID
+FakeStorePutRecord (
+  IN UINT16  Slot
+  )
+{
+  CHAR16  VarName[EFI_HW_ERR_REC_VAR_NAME_LEN];
+
+  UnicodeSPrint (VarName, sizeof (VarName), L"%s%04X", EFI_HW_ERR_REC_VAR_NAME, Slot);
+  FakeStorePut (VarName, &gEfiHardwareErrorVariableGuid, EFI_VARIABLE_NON_VOLATILE, 0x100, 0);
+}
+
+/**
+Empties the fake store, zeroes the call counters and resets the HER caches.
+
+**/
+STATIC
+VOID
+FakeStoreReset (
+  VOID
+  )
+{
+  ZeroMem (mFakeStore, sizeof (mFakeStore));
+  mGetVariableCalls         = 0;
+  mGetNextVariableNameCalls = 0;
+  mSetVariableCalls         = 0;
+  mRecordID                 = 0;
+  mRecordIDLimit            = 0;
+  MsWheaInvalidateSlotCache ();
+}
+
+/**
+Switches the variable service mocks over to the fake store.
+
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FakeStoreSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FakeStoreReset ();
+  mUseFakeStore = TRUE;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+Switches the variable service mocks back to cmocka and resets the HER caches.
+
+**/
+VOID
+EFIAPI
+FakeStoreCleanup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FakeStoreReset ();
+  mUseFakeStore = FALSE;
+}
+
+/**
+Fills out a basic error entry for MsWheaReportHERAdd.
+
+**/
+STATIC
+VOID
+InitTestEntry (
+  OUT MS_WHEA_ERROR_ENTRY_MD  *TestEntry
+  )
+{
+  ZeroMem (TestEntry, sizeof (*TestEntry));
+  TestEntry->Phase            = MS_WHEA_PHASE_DXE;
+  TestEntry->ErrorSeverity    = EFI_GENERIC_ERROR_FATAL;
+  TestEntry->ErrorStatusValue = TEST_RSC_CRITICAL_5;
+  CopyGuid (&TestEntry->ModuleID, &mTestGuid1);
+  CopyGuid (&TestEntry->LibraryID, &mTestGuid2);
+}
+
 /**
 A mocked version of GetVariable.
 
@@ -61,11 +235,32 @@ WheaGetVariable (
   OUT    VOID                        *Data           OPTIONAL
   )
 {
-  EFI_STATUS  ReturnStatus;
+  EFI_STATUS     ReturnStatus;
+  FAKE_VARIABLE  *Var;
 
-  ReturnStatus = (EFI_STATUS)mock ();
+  if (!mUseFakeStore) {
+    ReturnStatus = (EFI_STATUS)mock ();
+    return ReturnStatus;
+  }
 
-  return ReturnStatus;
+  mGetVariableCalls++;
+  Var = FakeStoreFind (VariableName, VendorGuid);
+  if (Var == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (Attributes != NULL) {
+    *Attributes = Var->Attributes;
+  }
+
+  if (*DataSize < Var->DataSize) {
+    *DataSize = Var->DataSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *DataSize = Var->DataSize;
+  CopyMem (Data, &Var->Data, MIN (Var->DataSize, sizeof (Var->Data)));
+  return EFI_SUCCESS;
 }
 
 /**
@@ -83,7 +278,51 @@ WheaGetNextVariableName (
   IN OUT EFI_GUID  *VendorGuid
   )
 {
-  return EFI_ABORTED;
+  UINTN  Index;
+  UINTN  NameSize;
+
+  if (!mUseFakeStore) {
+    return EFI_ABORTED;
+  }
+
+  mGetNextVariableNameCalls++;
+
+  // An empty name starts the walk, otherwise continue after the current variable.
+  Index = 0;
+  if (VariableName[0] != L'\0') {
+    while ((Index < FAKE_STORE_MAX_ENTRIES) &&
+           !(mFakeStore[Index].InUse &&
+             (StrCmp (mFakeStore[Index].Name, VariableName) == 0) &&
+             CompareGuid (&mFakeStore[Index].Guid, VendorGuid)))
+    {
+      Index++;
+    }
+
+    if (Index == FAKE_STORE_MAX_ENTRIES) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Index++;
+  }
+
+  while ((Index < FAKE_STORE_MAX_ENTRIES) && !mFakeStore[Index].InUse) {
+    Index++;
+  }
+
+  if (Index == FAKE_STORE_MAX_ENTRIES) {
+    return EFI_NOT_FOUND;
+  }
+
+  NameSize = StrSize (mFakeStore[Index].Name);
+  if (*VariableNameSize < NameSize) {
+    *VariableNameSize = NameSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *VariableNameSize = NameSize;
+  CopyMem (VariableName, mFakeStore[Index].Name, NameSize);
+  CopyGuid (VendorGuid, &mFakeStore[Index].Guid);
+  return EFI_SUCCESS;
 }
 
 /**
@@ -103,7 +342,28 @@ WheaSetVariable (
   IN  VOID      *Data
   )
 {
-  return EFI_ABORTED;
+  FAKE_VARIABLE  *Var;
+  UINT64         Value;
+
+  if (!mUseFakeStore) {
+    return EFI_ABORTED;
+  }
+
+  mSetVariableCalls++;
+  if (DataSize == 0) {
+    Var = FakeStoreFind (VariableName, VendorGuid);
+    if (Var == NULL) {
+      return EFI_NOT_FOUND;
+    }
+
+    Var->InUse = FALSE;
+    return EFI_SUCCESS;
+  }
+
+  Value = 0;
+  CopyMem (&Value, Data, MIN (DataSize, sizeof (Value)));
+  FakeStorePut (VariableName, VendorGuid, Attributes, DataSize, Value);
+  return EFI_SUCCESS;
 }
 
 BOOLEAN
@@ -115,15 +375,6 @@ PopulateTime (
   return FALSE;
 }
 
-EFI_STATUS
-GetRecordID (
-  UINT64  *RecordID
-  )
-{
-  // Stub implementation.
-  return EFI_ABORTED;
-}
-
 EFI_STATUS
 EFIAPI
 MsWheaESStoreEntry (
@@ -420,6 +671,182 @@ AnFCorrectlyPopulatesDynamicallySizedData (
   return UNIT_TEST_PASSED;
 }
 
+UNIT_TEST_STATUS
+EFIAPI
+SlotCacheReusesHolesWithOneScan (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_ERROR_ENTRY_MD  TestEntry;
+  UINT16                  Slot;
+  UINTN                   ScanCalls;
+
+  for (Slot = 0; Slot < 10; Slot++) {
+    if ((Slot != 3) && (Slot != 7)) {
+      FakeStorePutRecord (Slot);
+    }
+  }
+
+  InitTestEntry (&TestEntry);
+
+  // The first add scans the store and lands in the first hole.
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaReportHERAdd (&TestEntry));
+  UT_ASSERT_NOT_NULL (FakeStoreFind (L"HwErrRec0003", &gEfiHardwareErrorVariableGuid));
+  ScanCalls = mGetNextVariableNameCalls;
+  UT_ASSERT_NOT_EQUAL (ScanCalls, 0);
+
+  // Later adds fill the remaining hole and then append, without scanning again.
+  mGetVariableCalls = 0;
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaReportHERAdd (&TestEntry));
+  UT_ASSERT_NOT_NULL (FakeStoreFind (L"HwErrRec0007", &gEfiHardwareErrorVariableGuid));
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaReportHERAdd (&TestEntry));
+  UT_ASSERT_NOT_NULL (FakeStoreFind (L"HwErrRec000A", &gEfiHardwareErrorVariableGuid));
+  UT_ASSERT_EQUAL (mGetNextVariableNameCalls, ScanCalls);
+
+  // One GetVariable per add to confirm the slot; the record IDs come from the batch reserved by the first add.
+  UT_ASSERT_EQUAL (mGetVariableCalls, 2);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+SlotCacheSkipsSlotsWrittenByOthers (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT16  Result;
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaFindNextAvailableSlot (&Result));
+  UT_ASSERT_EQUAL (Result, 0);
+
+  // Someone else takes slots 0 and 1 after the cache was built.
+  FakeStorePutRecord (0);
+  FakeStorePutRecord (1);
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaFindNextAvailableSlot (&Result));
+  UT_ASSERT_EQUAL (Result, 2);
+
+  // Slot 0 is reported free again once it is deleted and the cache is dropped.
+  UT_ASSERT_NOT_EFI_ERROR (WheaSetVariable (L"HwErrRec0000", &gEfiHardwareErrorVariableGuid, 0, 0, NULL));
+  MsWheaInvalidateSlotCache ();
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaFindNextAvailableSlot (&Result));
+  UT_ASSERT_EQUAL (Result, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+RecordIDsAreReservedInBatches (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64         RecordID;
+  UINTN          Index;
+  FAKE_VARIABLE  *Var;
+
+  FakeStorePut (MS_WHEA_RECORD_ID_VAR_NAME, &gMsWheaReportRecordIDGuid, MS_WHEA_RECORD_ID_VAR_ATTR, MS_WHEA_RECORD_ID_VAR_LEN, 100);
+
+  for (Index = 1; Index <= MS_WHEA_RECORD_ID_BATCH_SIZE + 8; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (GetRecordID (&RecordID));
+    UT_ASSERT_EQUAL (RecordID, 100 + Index);
+  }
+
+  // Two blocks were reserved, each with one read and one write.
+  UT_ASSERT_EQUAL (mSetVariableCalls, 2);
+  UT_ASSERT_EQUAL (mGetVariableCalls, 2);
+
+  Var = FakeStoreFind (MS_WHEA_RECORD_ID_VAR_NAME, &gMsWheaReportRecordIDGuid);
+  UT_ASSERT_NOT_NULL (Var);
+  UT_ASSERT_EQUAL (Var->Data, 100 + 2 * MS_WHEA_RECORD_ID_BATCH_SIZE);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+RecordIDsSkipBlocksReservedByOthers (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  RecordID;
+  UINTN   Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (GetRecordID (&RecordID));
+  UT_ASSERT_EQUAL (RecordID, 1);
+
+  // Another agent reserves a block beyond ours while ours is still in use.
+  FakeStorePut (MS_WHEA_RECORD_ID_VAR_NAME, &gMsWheaReportRecordIDGuid, MS_WHEA_RECORD_ID_VAR_ATTR, MS_WHEA_RECORD_ID_VAR_LEN, 500);
+
+  for (Index = 2; Index <= MS_WHEA_RECORD_ID_BATCH_SIZE; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (GetRecordID (&RecordID));
+    UT_ASSERT_EQUAL (RecordID, Index);
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (GetRecordID (&RecordID));
+  UT_ASSERT_EQUAL (RecordID, 501);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+RecordIDResetsWhenVariableIsMalformed (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  RecordID;
+
+  FakeStorePut (MS_WHEA_RECORD_ID_VAR_NAME, &gMsWheaReportRecordIDGuid, MS_WHEA_RECORD_ID_VAR_ATTR, sizeof (UINT32), 100);
+
+  UT_ASSERT_NOT_EFI_ERROR (GetRecordID (&RecordID));
+  UT_ASSERT_EQUAL (RecordID, 1);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+ErrorStormVariableServiceCalls (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_ERROR_ENTRY_MD  TestEntry;
+  UINT16                  Slot;
+  UINTN                   Index;
+  UINTN                   StormSize;
+
+  // A store already holding 64 records, then a storm that fills it up.
+  for (Slot = 0; Slot < 64; Slot++) {
+    FakeStorePutRecord (Slot);
+  }
+
+  StormSize = FAKE_STORE_MAX_ENTRIES - 64 - 1;
+  InitTestEntry (&TestEntry);
+  for (Index = 0; Index < StormSize; Index++) {
+    UT_ASSERT_NOT_EFI_ERROR (MsWheaReportHERAdd (&TestEntry));
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: %d records: GetVariable %d, GetNextVariableName %d, SetVariable %d\n",
+    __FUNCTION__,
+    StormSize,
+    mGetVariableCalls,
+    mGetNextVariableNameCalls,
+    mSetVariableCalls
+    ));
+
+  // One store scan, one probe per record and one Record ID read per batch, where probing
+  // each slot in turn would have read 64 + n variables for the n-th record.
+  UT_ASSERT_EQUAL (mGetNextVariableNameCalls, 64 + 1);
+  UT_ASSERT_EQUAL (mGetVariableCalls, StormSize + (StormSize + MS_WHEA_RECORD_ID_BATCH_SIZE - 1) / MS_WHEA_RECORD_ID_BATCH_SIZE);
+  UT_ASSERT_EQUAL (mSetVariableCalls, StormSize + (StormSize + MS_WHEA_RECORD_ID_BATCH_SIZE - 1) / MS_WHEA_RECORD_ID_BATCH_SIZE);
+
+  return UNIT_TEST_PASSED;
+}
+
 // TODO: Test MsWheaAnFBuffer for exceeding the MaxHwRecErrSize. ASSERT in these cases
 //      because this should be caught in dev.
 
@@ -445,6 +872,8 @@ UefiTestMain (
   UNIT_TEST_FRAMEWORK_HANDLE  Framework;
   UNIT_TEST_SUITE_HANDLE      FindNextSuite;
   UNIT_TEST_SUITE_HANDLE      AnFBufferSuite;
+  UNIT_TEST_SUITE_HANDLE      SlotCacheSuite;
+  UNIT_TEST_SUITE_HANDLE      RecordIDSuite;
 
   Framework = NULL;
 
@@ -485,8 +914,36 @@ UefiTestMain (
   }
 
   AddTestCase (AnFBufferSuite, "AnFHandleOutOfResources", "OutOfResources", AnFHandleOutOfResources, NULL, NULL, NULL);
-  AddTestCase (AnFBufferSuite, "AnFCorrectlyPopulatesFixedSizedData", "FixedSizedData", AnFCorrectlyPopulatesFixedSizedData, NULL, NULL, NULL);
-  AddTestCase (AnFBufferSuite, "AnFCorrectlyPopulatesDynamicallySizedData", "DynamicallySizedData", AnFCorrectlyPopulatesDynamicallySizedData, NULL, NULL, NULL);
+  AddTestCase (AnFBufferSuite, "AnFCorrectlyPopulatesFixedSizedData", "FixedSizedData", AnFCorrectlyPopulatesFixedSizedData, FakeStoreSetup, FakeStoreCleanup, NULL);
+  AddTestCase (AnFBufferSuite, "AnFCorrectlyPopulatesDynamicallySizedData", "DynamicallySizedData", AnFCorrectlyPopulatesDynamicallySizedData, FakeStoreSetup, FakeStoreCleanup, NULL);
+
+  //
+  // Populate the SlotCacheSuite Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&SlotCacheSuite, Framework, "HwErrRec Slot Cache Tests", "SlotCache.General", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SlotCacheSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (SlotCacheSuite, "Should reuse holes after a single scan", "ReuseHoles", SlotCacheReusesHolesWithOneScan, FakeStoreSetup, FakeStoreCleanup, NULL);
+  AddTestCase (SlotCacheSuite, "Should skip slots written by others", "SkipForeign", SlotCacheSkipsSlotsWrittenByOthers, FakeStoreSetup, FakeStoreCleanup, NULL);
+  AddTestCase (SlotCacheSuite, "Should bound variable service calls in an error storm", "ErrorStorm", ErrorStormVariableServiceCalls, FakeStoreSetup, FakeStoreCleanup, NULL);
+
+  //
+  // Populate the RecordIDSuite Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&RecordIDSuite, Framework, "GetRecordID Tests", "RecordID.General", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for RecordIDSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (RecordIDSuite, "Should reserve record IDs in batches", "Batches", RecordIDsAreReservedInBatches, FakeStoreSetup, FakeStoreCleanup, NULL);
+  AddTestCase (RecordIDSuite, "Should skip blocks reserved by others", "SkipForeign", RecordIDsSkipBlocksReservedByOthers, FakeStoreSetup, FakeStoreCleanup, NULL);
+  AddTestCase (RecordIDSuite, "Should reset a malformed Record ID variable", "Malformed", RecordIDResetsWhenVariableIsMalformed, FakeStoreSetup, FakeStoreCleanup, NULL);
 
   //
   // Execute the tests.
@@ -0,0 +1,490 @@
+/** @file -- MsWheaEarlyStorageLibHostTest.c
+Host-based UnitTest for MsWheaEarlyStorageLib, backed by a fake CMOS that counts port accesses.
+
+Copyright (c) Microsoft Corporation
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PcdLib.h>
+#include <Library/UnitTestLib.h>
+#include <Library/MsWheaEarlyStorageLib.h>
+
+#define UNIT_TEST_NAME     "MsWheaEarlyStorageLib Unit Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define FAKE_CMOS_SIZE           256
+#define FAKE_CMOS_STORE_OFFSET   0x40
+#define FAKE_CMOS_LO_INDEX_PORT  0x70
+#define FAKE_CMOS_LO_DATA_PORT   0x71
+#define FAKE_CMOS_HI_INDEX_PORT  0x72
+#define FAKE_CMOS_HI_DATA_PORT   0x73
+
+#define HEADER_SIZE  sizeof (MS_WHEA_EARLY_STORAGE_HEADER)
+#define ENTRY_SIZE   sizeof (MS_WHEA_EARLY_STORAGE_ENTRY_V0)
+
+STATIC UINT8  mFakeCmos[FAKE_CMOS_SIZE];
+STATIC UINT8  mLoIndex;
+STATIC UINT8  mHiIndex;
+STATIC UINTN  mPortReads;
+STATIC UINTN  mPortWrites;
+STATIC UINTN  mDataWrites;
+
+/**
+  Fake CMOS data port read.
+**/
+UINT8
+EFIAPI
+IoRead8 (
+  IN UINTN  Port
+  )
+{
+  mPortReads++;
+  switch (Port) {
+    case FAKE_CMOS_LO_DATA_PORT:
+      return mFakeCmos[mLoIndex];
+    case FAKE_CMOS_HI_DATA_PORT:
+      return mFakeCmos[mHiIndex];
+    default:
+      fail_msg ("Unexpected read of port 0x%x", (UINT32)Port);
+      return 0;
+  }
+}
+
+/**
+  Fake CMOS index and data port write.
+**/
+UINT8
+EFIAPI
+IoWrite8 (
+  IN UINTN  Port,
+  IN UINT8  Value
+  )
+{
+  mPortWrites++;
+  switch (Port) {
+    case FAKE_CMOS_LO_INDEX_PORT:
+      mLoIndex = Value;
+      break;
+    case FAKE_CMOS_HI_INDEX_PORT:
+      mHiIndex = Value;
+      break;
+    case FAKE_CMOS_LO_DATA_PORT:
+      mDataWrites++;
+      mFakeCmos[mLoIndex] = Value;
+      break;
+    case FAKE_CMOS_HI_DATA_PORT:
+      mDataWrites++;
+      mFakeCmos[mHiIndex] = Value;
+      break;
+    default:
+      fail_msg ("Unexpected write of port 0x%x", (UINT32)Port);
+      break;
+  }
+
+  return Value;
+}
+
+/**
+  Zeroes the port access counters.
+**/
+STATIC
+VOID
+ResetPortCounters (
+  VOID
+  )
+{
+  mPortReads  = 0;
+  mPortWrites = 0;
+  mDataWrites = 0;
+}
+
+/**
+  Returns the early storage header as it currently sits in the fake CMOS.
+**/
+STATIC
+MS_WHEA_EARLY_STORAGE_HEADER *
+FakeCmosHeader (
+  VOID
+  )
+{
+  return (MS_WHEA_EARLY_STORAGE_HEADER *)&mFakeCmos[FAKE_CMOS_STORE_OFFSET];
+}
+
+/**
+  Checks the stored checksum against a full recalculation.
+**/
+STATIC
+BOOLEAN
+FakeCmosChecksumIsValid (
+  VOID
+  )
+{
+  MS_WHEA_EARLY_STORAGE_HEADER  Header;
+  UINT16                        Checksum;
+
+  CopyMem (&Header, FakeCmosHeader (), HEADER_SIZE);
+  if (EFI_ERROR (MsWheaESCalculateChecksum16 (&Header, &Checksum))) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)(Checksum == Header.Checksum);
+}
+
+/**
+  Fills out a test record.
+**/
+STATIC
+VOID
+InitTestEntry (
+  OUT MS_WHEA_EARLY_STORAGE_ENTRY_V0  *Entry,
+  IN  UINT32                          Seed
+  )
+{
+  ZeroMem (Entry, ENTRY_SIZE);
+  Entry->Rev              = MS_WHEA_REV_0;
+  Entry->Phase            = (UINT8)Seed;
+  Entry->ErrorStatusValue = 0xA0000000 | Seed;
+  Entry->AdditionalInfo1  = 0x1111111100000000ull | Seed;
+  Entry->AdditionalInfo2  = 0x2222222200000000ull | Seed;
+  Entry->ModuleID.Data1   = Seed;
+}
+
+/**
+  Puts an empty, valid early storage store in a blank fake CMOS.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FakeCmosSetup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_EARLY_STORAGE_HEADER  Header;
+
+  SetMem (mFakeCmos, sizeof (mFakeCmos), PcdGet8 (PcdMsWheaEarlyStorageDefaultValue));
+  ZeroMem (&Header, HEADER_SIZE);
+  Header.Signature = MS_WHEA_EARLY_STORAGE_SIGNATURE;
+  Header.Checksum  = CalculateCheckSum16 ((UINT16 *)&Header, HEADER_SIZE);
+  CopyMem (FakeCmosHeader (), &Header, HEADER_SIZE);
+
+  ResetPortCounters ();
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+ShadowLoadReadsStoreOnce (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_EARLY_STORAGE_SHADOW  Shadow;
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (1, 2, 3, NULL, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (4, 5, 6, NULL, NULL));
+
+  ResetPortCounters ();
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  UT_ASSERT_TRUE (Shadow.Valid);
+  UT_ASSERT_MEM_EQUAL (Shadow.Data, &mFakeCmos[FAKE_CMOS_STORE_OFFSET], HEADER_SIZE + 2 * ENTRY_SIZE);
+
+  // One index write and one data read per byte of header and active range, nothing else
+  UT_ASSERT_EQUAL (mPortReads, HEADER_SIZE + 2 * ENTRY_SIZE);
+  UT_ASSERT_EQUAL (mPortWrites, HEADER_SIZE + 2 * ENTRY_SIZE);
+  UT_ASSERT_EQUAL (mDataWrites, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+ShadowAppendKeepsChecksumValid (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_EARLY_STORAGE_SHADOW    Shadow;
+  MS_WHEA_EARLY_STORAGE_ENTRY_V0  Entry;
+  UINT32                          Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  for (Index = 0; Index < 3; Index++) {
+    InitTestEntry (&Entry, Index);
+    UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowAddRecordV0 (&Shadow, &Entry));
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowCommit (&Shadow));
+
+  UT_ASSERT_EQUAL (FakeCmosHeader ()->ActiveRange, 3 * ENTRY_SIZE);
+  UT_ASSERT_TRUE (FakeCmosChecksumIsValid ());
+  for (Index = 0; Index < 3; Index++) {
+    InitTestEntry (&Entry, Index);
+    UT_ASSERT_MEM_EQUAL (&mFakeCmos[FAKE_CMOS_STORE_OFFSET + HEADER_SIZE + Index * ENTRY_SIZE], &Entry, ENTRY_SIZE);
+  }
+
+  // A fresh load agrees with the incremental sum
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  UT_ASSERT_TRUE (Shadow.Valid);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+ShadowCommitWritesOnlyDirtyBytes (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_EARLY_STORAGE_SHADOW    Shadow;
+  MS_WHEA_EARLY_STORAGE_ENTRY_V0  Entry;
+  MS_WHEA_EARLY_STORAGE_HEADER    OldHeader;
+  UINT8                           *Old;
+  UINT8                           *New;
+  UINTN                           Index;
+  UINTN                           Changed;
+  UINT32                          Count;
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  CopyMem (&OldHeader, FakeCmosHeader (), HEADER_SIZE);
+
+  // Several appends share one header write-back
+  for (Count = 0; Count < 3; Count++) {
+    InitTestEntry (&Entry, Count);
+    UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowAddRecordV0 (&Shadow, &Entry));
+  }
+
+  UT_ASSERT_EQUAL (mDataWrites, 0);
+  ResetPortCounters ();
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowCommit (&Shadow));
+
+  Old     = (UINT8 *)&OldHeader;
+  New     = (UINT8 *)FakeCmosHeader ();
+  Changed = 0;
+  for (Index = 0; Index < HEADER_SIZE; Index++) {
+    if (Old[Index] != New[Index]) {
+      Changed++;
+    }
+  }
+
+  UT_ASSERT_TRUE (Changed <= 4);
+  UT_ASSERT_EQUAL (mDataWrites, 3 * ENTRY_SIZE + Changed);
+  UT_ASSERT_EQUAL (mPortReads, 0);
+
+  // Nothing left to write
+  ResetPortCounters ();
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowCommit (&Shadow));
+  UT_ASSERT_EQUAL (mPortWrites, 0);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+ShadowLoadDetectsCorruption (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_EARLY_STORAGE_SHADOW  Shadow;
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (1, 2, 3, NULL, NULL));
+
+  // Flipped data byte
+  mFakeCmos[FAKE_CMOS_STORE_OFFSET + HEADER_SIZE + 5] ^= 0x10;
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  UT_ASSERT_FALSE (Shadow.Valid);
+  mFakeCmos[FAKE_CMOS_STORE_OFFSET + HEADER_SIZE + 5] ^= 0x10;
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  UT_ASSERT_TRUE (Shadow.Valid);
+
+  // Active range beyond the store
+  FakeCmosHeader ()->ActiveRange = 0x1000;
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  UT_ASSERT_FALSE (Shadow.Valid);
+
+  // Blank CMOS
+  SetMem (mFakeCmos, sizeof (mFakeCmos), PcdGet8 (PcdMsWheaEarlyStorageDefaultValue));
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  UT_ASSERT_FALSE (Shadow.Valid);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+AddRecordResetsBadHeader (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_EARLY_STORAGE_SHADOW    Shadow;
+  MS_WHEA_EARLY_STORAGE_ENTRY_V0  Entry;
+  STATIC CONST UINT32             BadRanges[] = { 1, ENTRY_SIZE + 1, 0x1000, MAX_UINT32 - 1 };
+  UINTN                           Index;
+
+  for (Index = 0; Index < ARRAY_SIZE (BadRanges); Index++) {
+    FakeCmosSetup (Context);
+    UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (1, 2, 3, NULL, NULL));
+    FakeCmosHeader ()->ActiveRange = BadRanges[Index];
+
+    UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+    UT_ASSERT_FALSE (Shadow.Valid);
+    InitTestEntry (&Entry, 0);
+    UT_ASSERT_STATUS_EQUAL (MsWheaESShadowAddRecordV0 (&Shadow, &Entry), EFI_VOLUME_CORRUPTED);
+
+    UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (4, 5, 6, NULL, NULL));
+    UT_ASSERT_EQUAL (FakeCmosHeader ()->ActiveRange, ENTRY_SIZE);
+    UT_ASSERT_TRUE (FakeCmosChecksumIsValid ());
+  }
+
+  // Blank CMOS has no signature
+  SetMem (mFakeCmos, sizeof (mFakeCmos), PcdGet8 (PcdMsWheaEarlyStorageDefaultValue));
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (4, 5, 6, NULL, NULL));
+  UT_ASSERT_EQUAL (FakeCmosHeader ()->Signature, MS_WHEA_EARLY_STORAGE_SIGNATURE);
+  UT_ASSERT_EQUAL (FakeCmosHeader ()->ActiveRange, ENTRY_SIZE);
+  UT_ASSERT_TRUE (FakeCmosChecksumIsValid ());
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+ShadowAddStopsWhenFull (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MS_WHEA_EARLY_STORAGE_SHADOW    Shadow;
+  MS_WHEA_EARLY_STORAGE_ENTRY_V0  Entry;
+  UINT32                          Count;
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowLoad (&Shadow));
+  for (Count = 0; Count < MsWheaESGetMaxDataCount () / ENTRY_SIZE; Count++) {
+    InitTestEntry (&Entry, Count);
+    UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowAddRecordV0 (&Shadow, &Entry));
+  }
+
+  UT_ASSERT_STATUS_EQUAL (MsWheaESShadowAddRecordV0 (&Shadow, &Entry), EFI_OUT_OF_RESOURCES);
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESShadowCommit (&Shadow));
+  UT_ASSERT_TRUE (FakeCmosChecksumIsValid ());
+
+  UT_ASSERT_STATUS_EQUAL (MsWheaESAddRecordV0 (1, 2, 3, NULL, NULL), EFI_OUT_OF_RESOURCES);
+  UT_ASSERT_STATUS_EQUAL (MsWheaESShadowAddRecordV0 (NULL, &Entry), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (MsWheaESShadowAddRecordV0 (&Shadow, NULL), EFI_INVALID_PARAMETER);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+AddRecordPortAccessBudget (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT32  ActiveRange;
+  UINTN   Accesses;
+
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (1, 2, 3, NULL, NULL));
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (4, 5, 6, NULL, NULL));
+  UT_ASSERT_TRUE (FakeCmosChecksumIsValid ());
+
+  ActiveRange = FakeCmosHeader ()->ActiveRange;
+  ResetPortCounters ();
+  UT_ASSERT_NOT_EFI_ERROR (MsWheaESAddRecordV0 (7, 8, 9, NULL, NULL));
+  Accesses = mPortReads + mPortWrites;
+  UT_ASSERT_TRUE (FakeCmosChecksumIsValid ());
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: %d port accesses, re-reading the header and summing the active range took %d\n",
+    __FUNCTION__,
+    Accesses,
+    2 * (4 * HEADER_SIZE + ENTRY_SIZE + ActiveRange)
+    ));
+
+  // Header read, record write, at most 4 changed header bytes and the checksum read back.
+  // Each byte costs an index write plus a data access.
+  UT_ASSERT_TRUE (Accesses <= 2 * (HEADER_SIZE + ENTRY_SIZE + 4 + sizeof (UINT16)));
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  sample unit tests and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UefiTestMain (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ShadowSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the ShadowSuite Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&ShadowSuite, Framework, "Early Storage Shadow Tests", "Shadow.General", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ShadowSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ShadowSuite, "Load should read the store once", "LoadOnce", ShadowLoadReadsStoreOnce, FakeCmosSetup, NULL, NULL);
+  AddTestCase (ShadowSuite, "Appends should keep the checksum valid", "Checksum", ShadowAppendKeepsChecksumValid, FakeCmosSetup, NULL, NULL);
+  AddTestCase (ShadowSuite, "Commit should only write dirty bytes", "DirtyOnly", ShadowCommitWritesOnlyDirtyBytes, FakeCmosSetup, NULL, NULL);
+  AddTestCase (ShadowSuite, "Load should detect a corrupt store", "Corrupt", ShadowLoadDetectsCorruption, FakeCmosSetup, NULL, NULL);
+  AddTestCase (ShadowSuite, "MsWheaESAddRecordV0 should reset a store with a bad header", "BadHeader", AddRecordResetsBadHeader, FakeCmosSetup, NULL, NULL);
+  AddTestCase (ShadowSuite, "Appends should stop when the store is full", "Full", ShadowAddStopsWhenFull, FakeCmosSetup, NULL, NULL);
+  AddTestCase (ShadowSuite, "MsWheaESAddRecordV0 should stay within its port access budget", "AddBudget", AddRecordPortAccessBudget, FakeCmosSetup, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UefiTestMain ();
+}
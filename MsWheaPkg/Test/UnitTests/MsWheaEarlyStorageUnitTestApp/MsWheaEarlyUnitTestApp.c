@@ -66,13 +66,6 @@ MsWheaESReadData (
   UINT8  Offset
   );
 
-EFI_STATUS
-MsWheaESWriteData (
-  VOID   *Ptr,
-  UINT8  Size,
-  UINT8  Offset
-  );
-
 VOID
 MsWheaESReadHeader (
   MS_WHEA_EARLY_STORAGE_HEADER  *Header
@@ -83,12 +76,6 @@ MsWheaESWriteHeader (
   MS_WHEA_EARLY_STORAGE_HEADER  *Header
   );
 
-VOID
-MsWheaESContentChangeChecksumHelper (
-  UINT16  *Buffer,
-  UINTN   Length
-  );
-
 VOID
 MsWheaESHeaderChangeChecksumHelper (
   MS_WHEA_EARLY_STORAGE_HEADER  *Header
@@ -99,6 +86,42 @@ MsWheaESRegionIsValid (
   OUT MS_WHEA_EARLY_STORAGE_HEADER  *OutPutHeader OPTIONAL
   );
 
+/**
+
+Writes the early storage data region, which starts after the header.
+
+**/
+EFI_STATUS
+MsWheaESWriteData (
+  VOID   *Ptr,
+  UINT8  Size,
+  UINT8  Offset
+  )
+{
+  if (Offset >= MsWheaESGetMaxDataCount ()) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return MsWheaEarlyStorageWrite (Ptr, Size, (UINT8)(sizeof (MS_WHEA_EARLY_STORAGE_HEADER) + Offset));
+}
+
+/**
+
+Grows the active range by Length bytes of data already written to the store and updates the checksum.
+
+**/
+VOID
+MsWheaESContentChangeChecksumHelper (
+  UINTN  Length
+  )
+{
+  MS_WHEA_EARLY_STORAGE_HEADER  Header;
+
+  MsWheaESReadHeader (&Header);
+  Header.ActiveRange += (UINT32)Length;
+  MsWheaESHeaderChangeChecksumHelper (&Header);
+}
+
 EFI_STATUS
 EFIAPI
 TestReportFunction (
@@ -329,7 +352,7 @@ MsWheaESContentUpdateTest (
   UINT8  Data;
 
   MsWheaESWriteData (TestDataArray, sizeof (TestDataArray), 0);
-  MsWheaESContentChangeChecksumHelper (TestDataArray, sizeof (TestDataArray));
+  MsWheaESContentChangeChecksumHelper (sizeof (TestDataArray));
 
   MsWheaESReadHeader (&UnitTestHeader);
 
@@ -379,7 +402,7 @@ MsWheaESFindSlotTest (
   UINT8  Slot;
 
   MsWheaESWriteData (TestDataArray, sizeof (TestDataArray), 0);
-  MsWheaESContentChangeChecksumHelper (TestDataArray, sizeof (TestDataArray));
+  MsWheaESContentChangeChecksumHelper (sizeof (TestDataArray));
 
   MsWheaESReadHeader (&UnitTestHeader);
 
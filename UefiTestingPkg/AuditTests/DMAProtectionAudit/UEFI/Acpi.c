@@ -27,116 +27,62 @@ for purpose of easy ACPI table parsing
 
 #include "Acpi.h"
 
-/**
-  This function scan ACPI table in RSDT.
-
-  @param[in]  Rsdt      ACPI RSDT
-  @param[in]  Signature ACPI table signature
-
-  @return ACPI table
-**/
-VOID *
-ScanTableInRSDT (
-  IN RSDT_TABLE  *Rsdt,
-  IN UINT32      Signature
-  )
-{
-  UINTN                        Index;
-  UINT32                       EntryCount;
-  UINT32                       *EntryPtr;
-  EFI_ACPI_DESCRIPTION_HEADER  *Table;
-
-  EntryCount = (Rsdt->Header.Length - sizeof (EFI_ACPI_DESCRIPTION_HEADER)) / sizeof (UINT32);
-
-  EntryPtr = &Rsdt->Entry;
-  for (Index = 0; Index < EntryCount; Index++, EntryPtr++) {
-    Table = (EFI_ACPI_DESCRIPTION_HEADER *)((UINTN)(*EntryPtr));
-    if ((Table != NULL) && (Table->Signature == Signature)) {
-      return Table;
-    }
-  }
-
-  return NULL;
-}
+STATIC ACPI_TABLE_INDEX  *mAcpiTableIndex = NULL;
 
 /**
-  This function scan ACPI table in XSDT.
+  Get the index of the ACPI tables, building it on first use.
 
-  @param[in]  Xsdt      ACPI XSDT
-  @param[in]  Signature ACPI table signature
+  @param[in]  Resolve   Resolver for multi element DMAR device scopes. Only
+                        used by the call that builds the index.
+  @param[out] Index     Returns the index.
 
-  @return ACPI table
+  @retval EFI_SUCCESS     The index is returned.
+  @retval EFI_NOT_FOUND   There is no ACPI configuration table.
+  @retval Others          The index could not be built.
 **/
-VOID *
-ScanTableInXSDT (
-  IN XSDT_TABLE  *Xsdt,
-  IN UINT32      Signature
+EFI_STATUS
+GetAcpiTableIndex (
+  IN  ACPI_INDEX_RESOLVE_DEVICE_SCOPE  Resolve  OPTIONAL,
+  OUT ACPI_TABLE_INDEX                 **Index
   )
 {
-  UINTN                        Index;
-  UINT32                       EntryCount;
-  UINT64                       EntryPtr;
-  UINTN                        BasePtr;
-  EFI_ACPI_DESCRIPTION_HEADER  *Table;
-
-  EntryCount = (Xsdt->Header.Length - sizeof (EFI_ACPI_DESCRIPTION_HEADER)) / sizeof (UINT64);
-
-  BasePtr = (UINTN)(&(Xsdt->Entry));
-  for (Index = 0; Index < EntryCount; Index++) {
-    CopyMem (&EntryPtr, (VOID *)(BasePtr + Index * sizeof (UINT64)), sizeof (UINT64));
-    Table = (EFI_ACPI_DESCRIPTION_HEADER *)((UINTN)(EntryPtr));
-    if ((Table != NULL) && (Table->Signature == Signature)) {
-      return Table;
-    }
-  }
-
-  return NULL;
-}
-
-/**
-  This function scan ACPI table in RSDP.
+  EFI_STATUS  Status;
+  VOID        *AcpiConfigurationTable = NULL;
 
-  @param[in]  Rsdp      ACPI RSDP
-  @param[in]  Signature ACPI table signature
+  if (mAcpiTableIndex != NULL) {
+    *Index = mAcpiTableIndex;
+    return EFI_SUCCESS;
+  }
 
-  @return ACPI table
-**/
-VOID *
-FindAcpiPtr (
-  IN EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER  *Rsdp,
-  IN UINT32                                        Signature
-  )
-{
-  EFI_ACPI_DESCRIPTION_HEADER  *AcpiTable;
-  RSDT_TABLE                   *Rsdt;
-  XSDT_TABLE                   *Xsdt;
-
-  AcpiTable = NULL;
-
-  //
-  // Check ACPI2.0 table
-  //
-  Rsdt = (RSDT_TABLE *)(UINTN)Rsdp->RsdtAddress;
-  Xsdt = NULL;
-  if ((Rsdp->Revision >= 2) && (Rsdp->XsdtAddress < (UINT64)(UINTN)-1)) {
-    Xsdt = (XSDT_TABLE *)(UINTN)Rsdp->XsdtAddress;
+  Status = EfiGetSystemConfigurationTable (
+             &gEfiAcpi20TableGuid,
+             &AcpiConfigurationTable
+             );
+  if (EFI_ERROR (Status)) {
+    Status = EfiGetSystemConfigurationTable (
+               &gEfiAcpi10TableGuid,
+               &AcpiConfigurationTable
+               );
   }
 
-  //
-  // Check Xsdt
-  //
-  if (Xsdt != NULL) {
-    AcpiTable = ScanTableInXSDT (Xsdt, Signature);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
   }
 
-  //
-  // Check Rsdt
-  //
-  if ((AcpiTable == NULL) && (Rsdt != NULL)) {
-    AcpiTable = ScanTableInRSDT (Rsdt, Signature);
+  ASSERT (AcpiConfigurationTable != NULL);
+
+  Status = AcpiTableIndexBuild (
+             (EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *)AcpiConfigurationTable,
+             Resolve,
+             &mAcpiTableIndex
+             );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to index the ACPI tables - %r\n", __FUNCTION__, Status));
+    return Status;
   }
 
-  return AcpiTable;
+  *Index = mAcpiTableIndex;
+  return EFI_SUCCESS;
 }
 
 /**
@@ -151,8 +97,8 @@ GetAcpiTable (
   OUT VOID    **AcpiTable
   )
 {
-  EFI_STATUS  Status;
-  VOID        *AcpiConfigurationTable = NULL;
+  EFI_STATUS        Status;
+  ACPI_TABLE_INDEX  *Index;
 
   if (AcpiTable == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -160,29 +106,14 @@ GetAcpiTable (
     return EFI_ALREADY_STARTED;
   }
 
-  *AcpiTable = NULL;
-  Status     = EfiGetSystemConfigurationTable (
-                 &gEfiAcpi20TableGuid,
-                 &AcpiConfigurationTable
-                 );
+  Status = GetAcpiTableIndex (NULL, &Index);
   if (EFI_ERROR (Status)) {
-    Status = EfiGetSystemConfigurationTable (
-               &gEfiAcpi10TableGuid,
-               &AcpiConfigurationTable
-               );
+    return Status;
   }
 
+  Status = AcpiTableIndexGetTable (Index, AcpiSignature, 0, AcpiTable);
   if (EFI_ERROR (Status)) {
-    return EFI_NOT_FOUND;
-  }
-
-  ASSERT (AcpiConfigurationTable != NULL);
-
-  *AcpiTable = FindAcpiPtr (
-                 (EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER *)AcpiConfigurationTable,
-                 AcpiSignature
-                 );
-  if (*AcpiTable == NULL) {
+    *AcpiTable = NULL;
     return EFI_NOT_FOUND;
   }
 
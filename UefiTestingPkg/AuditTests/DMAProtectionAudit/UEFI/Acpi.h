@@ -13,6 +13,8 @@ for purpose of easy ACPI table parsing
 #ifndef __ACPI_UNIT_TEST_H__
 #define __ACPI_UNIT_TEST_H__
 
+#include "AcpiTableIndex.h"
+
 #pragma pack(1)
 
 typedef struct {
@@ -27,6 +29,23 @@ typedef struct {
 
 #pragma pack()
 
+/**
+  Get the index of the ACPI tables, building it on first use.
+
+  @param[in]  Resolve   Resolver for multi element DMAR device scopes. Only
+                        used by the call that builds the index.
+  @param[out] Index     Returns the index.
+
+  @retval EFI_SUCCESS     The index is returned.
+  @retval EFI_NOT_FOUND   There is no ACPI configuration table.
+  @retval Others          The index could not be built.
+**/
+EFI_STATUS
+GetAcpiTableIndex (
+  IN  ACPI_INDEX_RESOLVE_DEVICE_SCOPE  Resolve  OPTIONAL,
+  OUT ACPI_TABLE_INDEX                 **Index
+  );
+
 /**
   Get the ACPI table.
 
@@ -0,0 +1,1026 @@
+/** @file AcpiTableIndex.c
+
+Walks the XSDT/RSDT and the DMAR and IVRS tables once and keeps what the
+audit needs in sorted arrays. Device scopes and reserved regions may overlap,
+so each entry also carries the largest end seen up to it; a lookup binary
+searches for the last entry starting at or below the key and walks back only
+while that running maximum still reaches the key.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HeapSortLib.h>
+#include <Library/MemoryAllocationLib.h>
+
+#include "Acpi.h"
+#include "IVRS/IVRS.h"
+
+typedef struct {
+  ACPI_TABLE_INDEX                   *Index;
+  ACPI_INDEX_RESOLVE_DEVICE_SCOPE    Resolve;
+  BOOLEAN                            Fill;    // FALSE while only counting
+} ACPI_INDEX_BUILDER;
+
+STATIC
+INTN
+EFIAPI
+CompareTables (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  CONST ACPI_INDEX_TABLE  *A;
+  CONST ACPI_INDEX_TABLE  *B;
+
+  A = (CONST ACPI_INDEX_TABLE *)Left;
+  B = (CONST ACPI_INDEX_TABLE *)Right;
+  if (A->Signature != B->Signature) {
+    return (A->Signature < B->Signature) ? -1 : 1;
+  }
+
+  return (A->Order == B->Order) ? 0 : ((A->Order < B->Order) ? -1 : 1);
+}
+
+STATIC
+INTN
+EFIAPI
+CompareUnits (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  CONST ACPI_INDEX_REMAP_UNIT  *A;
+  CONST ACPI_INDEX_REMAP_UNIT  *B;
+
+  A = (CONST ACPI_INDEX_REMAP_UNIT *)Left;
+  B = (CONST ACPI_INDEX_REMAP_UNIT *)Right;
+  if (A->Segment != B->Segment) {
+    return (A->Segment < B->Segment) ? -1 : 1;
+  }
+
+  if (A->BaseAddress != B->BaseAddress) {
+    return (A->BaseAddress < B->BaseAddress) ? -1 : 1;
+  }
+
+  return (A->Order == B->Order) ? 0 : ((A->Order < B->Order) ? -1 : 1);
+}
+
+STATIC
+INTN
+EFIAPI
+CompareScopes (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  CONST ACPI_INDEX_DEVICE_SCOPE  *A;
+  CONST ACPI_INDEX_DEVICE_SCOPE  *B;
+
+  A = (CONST ACPI_INDEX_DEVICE_SCOPE *)Left;
+  B = (CONST ACPI_INDEX_DEVICE_SCOPE *)Right;
+  if (A->First != B->First) {
+    return (A->First < B->First) ? -1 : 1;
+  }
+
+  if (A->Last != B->Last) {
+    return (A->Last < B->Last) ? -1 : 1;
+  }
+
+  return (A->Unit == B->Unit) ? 0 : ((A->Unit < B->Unit) ? -1 : 1);
+}
+
+STATIC
+INTN
+EFIAPI
+CompareRegions (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  CONST ACPI_INDEX_RESERVED_REGION  *A;
+  CONST ACPI_INDEX_RESERVED_REGION  *B;
+
+  A = (CONST ACPI_INDEX_RESERVED_REGION *)Left;
+  B = (CONST ACPI_INDEX_RESERVED_REGION *)Right;
+  if (A->Base != B->Base) {
+    return (A->Base < B->Base) ? -1 : 1;
+  }
+
+  return (A->Limit == B->Limit) ? 0 : ((A->Limit < B->Limit) ? -1 : 1);
+}
+
+/**
+  Returns the position of the first table with Signature in the first Count
+  tables, or the position where it would be inserted.
+**/
+STATIC
+UINTN
+FindFirstTable (
+  IN CONST ACPI_INDEX_TABLE  *Tables,
+  IN       UINTN             Count,
+  IN       UINT32            Signature
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  Low  = 0;
+  High = Count;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Tables[Middle].Signature < Signature) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  return Low;
+}
+
+STATIC
+VOID
+AddTable (
+  IN OUT ACPI_TABLE_INDEX             *Index,
+  IN     EFI_ACPI_DESCRIPTION_HEADER  *Table
+  )
+{
+  Index->Tables[Index->TableCount].Signature = Table->Signature;
+  Index->Tables[Index->TableCount].Order     = (UINT32)Index->TableCount;
+  Index->Tables[Index->TableCount].Table     = Table;
+  Index->TableCount++;
+}
+
+/**
+  Index the tables of the XSDT, then the tables of the RSDT whose signature
+  the XSDT does not have, the same precedence the audit used when it scanned
+  the two for every lookup.
+**/
+STATIC
+EFI_STATUS
+IndexRootTables (
+  IN OUT ACPI_TABLE_INDEX                              *Index,
+  IN     EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER  *Rsdp
+  )
+{
+  RSDT_TABLE                   *Rsdt;
+  XSDT_TABLE                   *Xsdt;
+  UINTN                        RsdtCount;
+  UINTN                        XsdtCount;
+  UINTN                        Entry;
+  UINTN                        Position;
+  UINT32                       RsdtEntry;
+  UINT64                       XsdtEntry;
+  EFI_ACPI_DESCRIPTION_HEADER  *Table;
+  ACPI_INDEX_TABLE             Scratch;
+
+  Rsdt = (RSDT_TABLE *)(UINTN)Rsdp->RsdtAddress;
+  Xsdt = NULL;
+  if ((Rsdp->Revision >= 2) && (Rsdp->XsdtAddress < (UINT64)(UINTN)-1)) {
+    Xsdt = (XSDT_TABLE *)(UINTN)Rsdp->XsdtAddress;
+  }
+
+  XsdtCount = 0;
+  if (Xsdt != NULL) {
+    XsdtCount = (Xsdt->Header.Length - sizeof (EFI_ACPI_DESCRIPTION_HEADER)) / sizeof (UINT64);
+  }
+
+  RsdtCount = 0;
+  if (Rsdt != NULL) {
+    RsdtCount = (Rsdt->Header.Length - sizeof (EFI_ACPI_DESCRIPTION_HEADER)) / sizeof (UINT32);
+  }
+
+  if (XsdtCount + RsdtCount == 0) {
+    return EFI_SUCCESS;
+  }
+
+  Index->Tables = AllocatePool ((XsdtCount + RsdtCount) * sizeof (ACPI_INDEX_TABLE));
+  if (Index->Tables == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Entry = 0; Entry < XsdtCount; Entry++) {
+    CopyMem (&XsdtEntry, (UINT8 *)&Xsdt->Entry + Entry * sizeof (UINT64), sizeof (UINT64));
+    Table = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)XsdtEntry;
+    if (Table != NULL) {
+      AddTable (Index, Table);
+    }
+  }
+
+  XsdtCount = Index->TableCount;
+  HeapSort (Index->Tables, XsdtCount, sizeof (ACPI_INDEX_TABLE), CompareTables, &Scratch);
+
+  for (Entry = 0; Entry < RsdtCount; Entry++) {
+    CopyMem (&RsdtEntry, (UINT8 *)&Rsdt->Entry + Entry * sizeof (UINT32), sizeof (UINT32));
+    Table = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)RsdtEntry;
+    if (Table == NULL) {
+      continue;
+    }
+
+    Position = FindFirstTable (Index->Tables, XsdtCount, Table->Signature);
+    if ((Position < XsdtCount) && (Index->Tables[Position].Signature == Table->Signature)) {
+      continue;
+    }
+
+    AddTable (Index, Table);
+  }
+
+  HeapSort (Index->Tables, Index->TableCount, sizeof (ACPI_INDEX_TABLE), CompareTables, &Scratch);
+  return EFI_SUCCESS;
+}
+
+/**
+  Count a remapping unit and, when filling, store it.
+
+  @return The parse order of the unit, which its scopes refer to until the
+          units are sorted.
+**/
+STATIC
+UINT32
+AddUnit (
+  IN OUT ACPI_INDEX_BUILDER  *Builder,
+  IN     UINT16              Segment,
+  IN     UINT8               Type,
+  IN     UINT8               Flags,
+  IN     UINT64              BaseAddress,
+  IN     VOID                *Header
+  )
+{
+  ACPI_INDEX_REMAP_UNIT  *Unit;
+  UINT32                 Order;
+
+  Order = (UINT32)Builder->Index->UnitCount++;
+  if (Builder->Fill) {
+    Unit              = &Builder->Index->Units[Order];
+    Unit->Segment     = Segment;
+    Unit->Type        = Type;
+    Unit->Flags       = Flags;
+    Unit->Order       = Order;
+    Unit->BaseAddress = BaseAddress;
+    Unit->Header      = Header;
+  }
+
+  return Order;
+}
+
+STATIC
+VOID
+AddScope (
+  IN OUT ACPI_INDEX_BUILDER  *Builder,
+  IN     UINT32              First,
+  IN     UINT32              Last,
+  IN     UINT8               Type,
+  IN     UINT32              Unit
+  )
+{
+  ACPI_INDEX_DEVICE_SCOPE  *Scope;
+
+  if (Builder->Fill) {
+    Scope        = &Builder->Index->Scopes[Builder->Index->ScopeCount];
+    Scope->First = First;
+    Scope->Last  = Last;
+    Scope->Type  = Type;
+    Scope->Unit  = Unit;
+  }
+
+  Builder->Index->ScopeCount++;
+}
+
+STATIC
+VOID
+AddRegion (
+  IN OUT ACPI_INDEX_BUILDER  *Builder,
+  IN     UINT64              Base,
+  IN     UINT64              Limit,
+  IN     UINT16              Segment,
+  IN     UINT8               Type,
+  IN     VOID                *Header
+  )
+{
+  ACPI_INDEX_RESERVED_REGION  *Region;
+
+  if (Builder->Fill) {
+    Region          = &Builder->Index->Regions[Builder->Index->RegionCount];
+    Region->Base    = Base;
+    Region->Limit   = Limit;
+    Region->Segment = Segment;
+    Region->Type    = Type;
+    Region->Header  = Header;
+  }
+
+  Builder->Index->RegionCount++;
+}
+
+/**
+  Returns TRUE if a structure of Length bytes that needs at least MinLength
+  bytes fits between Structure and End.
+**/
+STATIC
+BOOLEAN
+StructureFits (
+  IN UINTN  Structure,
+  IN UINTN  End,
+  IN UINTN  Length,
+  IN UINTN  MinLength
+  )
+{
+  return (Length >= MinLength) && (Structure <= End) && (Length <= End - Structure);
+}
+
+STATIC
+EFI_STATUS
+IndexDrhd (
+  IN OUT ACPI_INDEX_BUILDER         *Builder,
+  IN     EFI_ACPI_DMAR_DRHD_HEADER  *Drhd
+  )
+{
+  EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER  *Scope;
+  EFI_ACPI_DMAR_PCI_PATH                       *Path;
+  EFI_STATUS                                   Status;
+  UINTN                                        End;
+  UINT32                                       Unit;
+  UINT32                                       SourceId;
+  UINT8                                        Bus;
+  UINT8                                        Device;
+  UINT8                                        Function;
+
+  Unit = AddUnit (
+           Builder,
+           Drhd->SegmentNumber,
+           EFI_ACPI_DMAR_TYPE_DRHD,
+           ((Drhd->Flags & EFI_ACPI_DMAR_DRHD_FLAGS_INCLUDE_PCI_ALL) != 0) ? ACPI_INDEX_UNIT_INCLUDE_ALL : 0,
+           Drhd->RegisterBaseAddress,
+           Drhd
+           );
+
+  End   = (UINTN)Drhd + Drhd->Header.Length;
+  Scope = (EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *)(Drhd + 1);
+  while ((UINTN)Scope < End) {
+    if ((End - (UINTN)Scope < sizeof (*Scope)) ||
+        !StructureFits ((UINTN)Scope, End, Scope->Length, sizeof (*Scope) + sizeof (EFI_ACPI_DMAR_PCI_PATH)))
+    {
+      DEBUG ((DEBUG_ERROR, "%a - Bad device scope length in DRHD 0x%lx\n", __FUNCTION__, Drhd->RegisterBaseAddress));
+      return EFI_COMPROMISED_DATA;
+    }
+
+    Path = (EFI_ACPI_DMAR_PCI_PATH *)(Scope + 1);
+    if (Scope->Length == sizeof (*Scope) + sizeof (EFI_ACPI_DMAR_PCI_PATH)) {
+      Bus      = Scope->StartBusNumber;
+      Device   = Path->Device;
+      Function = Path->Function;
+    } else if (Builder->Resolve == NULL) {
+      Builder->Index->UnresolvedScopeCount++;
+      Scope = (EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *)((UINTN)Scope + Scope->Length);
+      continue;
+    } else if (Builder->Fill) {
+      Status = Builder->Resolve (Drhd->SegmentNumber, Scope, &Bus, &Device, &Function);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+    } else {
+      Bus      = 0;
+      Device   = 0;
+      Function = 0;
+    }
+
+    SourceId = ACPI_INDEX_SOURCE_ID (Drhd->SegmentNumber, Bus, Device, Function);
+    AddScope (Builder, SourceId, SourceId, Scope->Type, Unit);
+    Scope = (EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER *)((UINTN)Scope + Scope->Length);
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+IndexDmar (
+  IN OUT ACPI_INDEX_BUILDER    *Builder,
+  IN     EFI_ACPI_DMAR_HEADER  *Dmar
+  )
+{
+  EFI_ACPI_DMAR_STRUCTURE_HEADER  *DmarHeader;
+  EFI_ACPI_DMAR_RMRR_HEADER       *Rmrr;
+  EFI_STATUS                      Status;
+  UINTN                           End;
+  UINTN                           MinLength;
+
+  End        = (UINTN)Dmar + Dmar->Header.Length;
+  DmarHeader = (EFI_ACPI_DMAR_STRUCTURE_HEADER *)(Dmar + 1);
+  while ((UINTN)DmarHeader < End) {
+    switch (DmarHeader->Type) {
+      case EFI_ACPI_DMAR_TYPE_DRHD:
+        MinLength = sizeof (EFI_ACPI_DMAR_DRHD_HEADER);
+        break;
+      case EFI_ACPI_DMAR_TYPE_RMRR:
+        MinLength = sizeof (EFI_ACPI_DMAR_RMRR_HEADER);
+        break;
+      default:
+        MinLength = sizeof (EFI_ACPI_DMAR_STRUCTURE_HEADER);
+        break;
+    }
+
+    if ((End - (UINTN)DmarHeader < sizeof (*DmarHeader)) ||
+        !StructureFits ((UINTN)DmarHeader, End, DmarHeader->Length, MinLength))
+    {
+      DEBUG ((DEBUG_ERROR, "%a - Bad length for DMAR structure type %d\n", __FUNCTION__, DmarHeader->Type));
+      return EFI_COMPROMISED_DATA;
+    }
+
+    switch (DmarHeader->Type) {
+      case EFI_ACPI_DMAR_TYPE_DRHD:
+        Status = IndexDrhd (Builder, (EFI_ACPI_DMAR_DRHD_HEADER *)DmarHeader);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+
+        break;
+      case EFI_ACPI_DMAR_TYPE_RMRR:
+        Rmrr = (EFI_ACPI_DMAR_RMRR_HEADER *)DmarHeader;
+        AddRegion (
+          Builder,
+          Rmrr->ReservedMemoryRegionBaseAddress,
+          Rmrr->ReservedMemoryRegionLimitAddress,
+          Rmrr->SegmentNumber,
+          EFI_ACPI_DMAR_TYPE_RMRR,
+          Rmrr
+          );
+        break;
+      default:
+        break;
+    }
+
+    DmarHeader = (EFI_ACPI_DMAR_STRUCTURE_HEADER *)((UINTN)DmarHeader + DmarHeader->Length);
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+IndexIvhd (
+  IN OUT ACPI_INDEX_BUILDER  *Builder,
+  IN     IVHD_Header         *Ivhd
+  )
+{
+  IVHD_DEVICE_ENTRY_COMMON  *Entry;
+  UINTN                     End;
+  UINTN                     EntryLength;
+  UINT32                    Unit;
+  UINT32                    SourceId;
+  UINT32                    RangeFirst;
+  BOOLEAN                   InRange;
+
+  Unit = AddUnit (Builder, Ivhd->PCISegmentGroup, Ivhd->Type, 0, Ivhd->IOMMUBaseAddress, Ivhd);
+
+  if (Ivhd->Type == IVHD_TYPE_10H) {
+    Entry = (IVHD_DEVICE_ENTRY_COMMON *)(Ivhd + 1);
+  } else {
+    Entry = (IVHD_DEVICE_ENTRY_COMMON *)((UINTN)Ivhd + sizeof (IVHD_Header) + 16);
+  }
+
+  End        = (UINTN)Ivhd + Ivhd->Length;
+  RangeFirst = 0;
+  InRange    = FALSE;
+  while ((UINTN)Entry < End) {
+    //
+    // Entries below 40h are 4 bytes and entries below 80h are 8 bytes long.
+    //
+    if (Entry->DeviceType < 0x40) {
+      EntryLength = sizeof (IVHD_DEVICE_ENTRY_COMMON);
+    } else if (Entry->DeviceType < 0x80) {
+      EntryLength = sizeof (IVHD_DEVICE_ENTRY_COMMON) + sizeof (IVHD_DEVICE_ENTRY_EX);
+    } else if ((Entry->DeviceType == IVRS_DTE_TYPE_F0H) && (End - (UINTN)Entry >= sizeof (IVHD_DEVICE_ENTRY_F0H))) {
+      EntryLength = sizeof (IVHD_DEVICE_ENTRY_F0H) + ((IVHD_DEVICE_ENTRY_F0H *)Entry)->UniqueIdLength;
+    } else if (Entry->DeviceType == IVRS_DTE_TYPE_F0H) {
+      EntryLength = sizeof (IVHD_DEVICE_ENTRY_F0H);
+    } else {
+      DEBUG ((DEBUG_ERROR, "%a - Unknown IVHD device entry type 0x%02x\n", __FUNCTION__, Entry->DeviceType));
+      return EFI_UNSUPPORTED;
+    }
+
+    if (!StructureFits ((UINTN)Entry, End, EntryLength, EntryLength)) {
+      DEBUG ((DEBUG_ERROR, "%a - IVHD device entry overruns IVHD 0x%lx\n", __FUNCTION__, Ivhd->IOMMUBaseAddress));
+      return EFI_COMPROMISED_DATA;
+    }
+
+    SourceId = ACPI_INDEX_SOURCE_ID (Ivhd->PCISegmentGroup, 0, 0, 0) | Entry->DeviceID.Value;
+    switch (Entry->DeviceType) {
+      case IVRS_DTE_TYPE_01H:
+        if (Builder->Fill) {
+          Builder->Index->Units[Unit].Flags |= ACPI_INDEX_UNIT_INCLUDE_ALL;
+        }
+
+        break;
+      case IVRS_DTE_TYPE_02H:
+      case IVRS_DTE_TYPE_42H:
+      case IVRS_DTE_TYPE_46H:
+      case IVRS_DTE_TYPE_F0H:
+        AddScope (Builder, SourceId, SourceId, Entry->DeviceType, Unit);
+        break;
+      case IVRS_DTE_TYPE_48H:
+        //
+        // The special device's own ID lives in the extended half of the entry.
+        //
+        SourceId = ACPI_INDEX_SOURCE_ID (Ivhd->PCISegmentGroup, 0, 0, 0) | ((IVHD_DEVICE_ENTRY_EX *)(Entry + 1))->DeviceID.Value;
+        AddScope (Builder, SourceId, SourceId, Entry->DeviceType, Unit);
+        break;
+      case IVRS_DTE_TYPE_03H:
+      case IVRS_DTE_TYPE_43H:
+      case IVRS_DTE_TYPE_47H:
+        RangeFirst = SourceId;
+        InRange    = TRUE;
+        break;
+      case IVRS_DTE_TYPE_04H:
+        if (InRange && (RangeFirst <= SourceId)) {
+          AddScope (Builder, RangeFirst, SourceId, IVRS_DTE_TYPE_03H, Unit);
+        }
+
+        InRange = FALSE;
+        break;
+      default:
+        break;
+    }
+
+    Entry = (IVHD_DEVICE_ENTRY_COMMON *)((UINTN)Entry + EntryLength);
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+IndexIvrs (
+  IN OUT ACPI_INDEX_BUILDER    *Builder,
+  IN     EFI_ACPI_IVRS_HEADER  *Ivrs
+  )
+{
+  IVMD_Header  *IvrsHeader;
+  EFI_STATUS   Status;
+  UINTN        End;
+  UINTN        MinLength;
+
+  End        = (UINTN)Ivrs + Ivrs->Header.Length;
+  IvrsHeader = (IVMD_Header *)(Ivrs + 1);
+  while ((UINTN)IvrsHeader < End) {
+    switch (IvrsHeader->Type) {
+      case IVHD_TYPE_10H:
+        MinLength = sizeof (IVHD_Header);
+        break;
+      case IVHD_TYPE_11H:
+      case IVHD_TYPE_40H:
+        MinLength = sizeof (IVHD_Header) + 16;
+        break;
+      case IVMD_TYPE_20H:
+      case IVMD_TYPE_21H:
+      case IVMD_TYPE_22H:
+        MinLength = sizeof (IVMD_Header);
+        break;
+      default:
+        MinLength = OFFSET_OF (IVMD_Header, DeviceID);
+        break;
+    }
+
+    if ((End - (UINTN)IvrsHeader < OFFSET_OF (IVMD_Header, DeviceID)) ||
+        !StructureFits ((UINTN)IvrsHeader, End, IvrsHeader->Length, MinLength))
+    {
+      DEBUG ((DEBUG_ERROR, "%a - Bad length for IVRS structure type 0x%02x\n", __FUNCTION__, IvrsHeader->Type));
+      return EFI_COMPROMISED_DATA;
+    }
+
+    switch (IvrsHeader->Type) {
+      case IVHD_TYPE_10H:
+      case IVHD_TYPE_11H:
+      case IVHD_TYPE_40H:
+        Status = IndexIvhd (Builder, (IVHD_Header *)IvrsHeader);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+
+        break;
+      case IVMD_TYPE_20H:
+      case IVMD_TYPE_21H:
+      case IVMD_TYPE_22H:
+        //
+        // IVMD blocks are start and length, an empty block reserves nothing.
+        // A block that wraps past the top of the address space is malformed.
+        //
+        if (IvrsHeader->IVMDMemoryBlockLength != 0) {
+          if (IvrsHeader->IVMDMemoryBlockLength - 1 > MAX_UINT64 - IvrsHeader->IVMDStartAddress) {
+            DEBUG ((DEBUG_ERROR, "%a - IVMD block at 0x%lx wraps past the end of memory\n", __FUNCTION__, IvrsHeader->IVMDStartAddress));
+            return EFI_COMPROMISED_DATA;
+          }
+
+          AddRegion (
+            Builder,
+            IvrsHeader->IVMDStartAddress,
+            IvrsHeader->IVMDStartAddress + IvrsHeader->IVMDMemoryBlockLength - 1,
+            0,
+            IvrsHeader->Type,
+            IvrsHeader
+            );
+        }
+
+        break;
+      default:
+        break;
+    }
+
+    IvrsHeader = (IVMD_Header *)((UINTN)IvrsHeader + IvrsHeader->Length);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Walk the DMAR and IVRS tables. The first pass only counts, the second pass
+  stores into arrays sized by the first.
+**/
+STATIC
+EFI_STATUS
+IndexRemappingTables (
+  IN OUT ACPI_INDEX_BUILDER  *Builder
+  )
+{
+  ACPI_TABLE_INDEX      *Index;
+  EFI_ACPI_DMAR_HEADER  *Dmar;
+  EFI_ACPI_IVRS_HEADER  *Ivrs;
+  EFI_STATUS            Status;
+
+  Index = Builder->Index;
+  if (EFI_ERROR (AcpiTableIndexGetTable (Index, EFI_ACPI_4_0_DMA_REMAPPING_TABLE_SIGNATURE, 0, (VOID **)&Dmar))) {
+    Dmar = NULL;
+  }
+
+  if (EFI_ERROR (AcpiTableIndexGetTable (Index, IVRS_HEADER_SIGNATURE, 0, (VOID **)&Ivrs))) {
+    Ivrs = NULL;
+  }
+
+  Index->UnitCount            = 0;
+  Index->ScopeCount           = 0;
+  Index->UnresolvedScopeCount = 0;
+  Index->RegionCount          = 0;
+
+  if (Dmar != NULL) {
+    Status = IndexDmar (Builder, Dmar);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (Ivrs != NULL) {
+    Status = IndexIvrs (Builder, Ivrs);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Sort the units, point the scopes at the sorted units and sort the scopes and
+  regions, filling in the running maxima the lookups walk back on.
+**/
+STATIC
+EFI_STATUS
+SortRemappingTables (
+  IN OUT ACPI_TABLE_INDEX  *Index
+  )
+{
+  UINT32  *SortedUnit;
+  UINTN   Entry;
+  union {
+    ACPI_INDEX_REMAP_UNIT         Unit;
+    ACPI_INDEX_DEVICE_SCOPE       Scope;
+    ACPI_INDEX_RESERVED_REGION    Region;
+  } Scratch;
+
+  HeapSort (Index->Units, Index->UnitCount, sizeof (ACPI_INDEX_REMAP_UNIT), CompareUnits, &Scratch);
+
+  if (Index->ScopeCount > 0) {
+    SortedUnit = AllocatePool (Index->UnitCount * sizeof (UINT32));
+    if (SortedUnit == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    for (Entry = 0; Entry < Index->UnitCount; Entry++) {
+      SortedUnit[Index->Units[Entry].Order] = (UINT32)Entry;
+    }
+
+    for (Entry = 0; Entry < Index->ScopeCount; Entry++) {
+      Index->Scopes[Entry].Unit = SortedUnit[Index->Scopes[Entry].Unit];
+    }
+
+    FreePool (SortedUnit);
+
+    HeapSort (Index->Scopes, Index->ScopeCount, sizeof (ACPI_INDEX_DEVICE_SCOPE), CompareScopes, &Scratch);
+    Index->Scopes[0].MaxLast = Index->Scopes[0].Last;
+    for (Entry = 1; Entry < Index->ScopeCount; Entry++) {
+      Index->Scopes[Entry].MaxLast = MAX (Index->Scopes[Entry - 1].MaxLast, Index->Scopes[Entry].Last);
+    }
+  }
+
+  if (Index->RegionCount > 0) {
+    HeapSort (Index->Regions, Index->RegionCount, sizeof (ACPI_INDEX_RESERVED_REGION), CompareRegions, &Scratch);
+    Index->Regions[0].MaxLimit = Index->Regions[0].Limit;
+    for (Entry = 1; Entry < Index->RegionCount; Entry++) {
+      Index->Regions[Entry].MaxLimit = MAX (Index->Regions[Entry - 1].MaxLimit, Index->Regions[Entry].Limit);
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Build the index of the ACPI tables reachable from an RSDP.
+
+  A DMAR device scope whose path has more than one element can only be placed
+  by walking the bridges it names. Such scopes are indexed through Resolve and
+  only counted in UnresolvedScopeCount when Resolve is NULL.
+
+  @param[in]  Rsdp      ACPI RSDP
+  @param[in]  Resolve   Optional resolver for multi element DMAR scopes.
+  @param[out] Index     Returns the index, free it with AcpiTableIndexFree.
+
+  @retval EFI_SUCCESS             The index was built.
+  @retval EFI_INVALID_PARAMETER   Rsdp or Index is NULL.
+  @retval EFI_OUT_OF_RESOURCES    The index could not be allocated.
+  @retval EFI_COMPROMISED_DATA    A DMAR or IVRS structure has a bad length, or an
+                                 IVMD block wraps past the end of memory.
+  @retval EFI_UNSUPPORTED         An IVHD uses a type this parser does not know.
+**/
+EFI_STATUS
+AcpiTableIndexBuild (
+  IN  EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER  *Rsdp,
+  IN  ACPI_INDEX_RESOLVE_DEVICE_SCOPE               Resolve  OPTIONAL,
+  OUT ACPI_TABLE_INDEX                              **Index
+  )
+{
+  ACPI_INDEX_BUILDER  Builder;
+  ACPI_TABLE_INDEX    *New;
+  EFI_STATUS          Status;
+
+  if ((Rsdp == NULL) || (Index == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  New = AllocateZeroPool (sizeof (ACPI_TABLE_INDEX));
+  if (New == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = IndexRootTables (New, Rsdp);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Builder.Index   = New;
+  Builder.Resolve = Resolve;
+  Builder.Fill    = FALSE;
+  Status          = IndexRemappingTables (&Builder);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  if (New->UnitCount > 0) {
+    New->Units = AllocatePool (New->UnitCount * sizeof (ACPI_INDEX_REMAP_UNIT));
+  }
+
+  if (New->ScopeCount > 0) {
+    New->Scopes = AllocatePool (New->ScopeCount * sizeof (ACPI_INDEX_DEVICE_SCOPE));
+  }
+
+  if (New->RegionCount > 0) {
+    New->Regions = AllocatePool (New->RegionCount * sizeof (ACPI_INDEX_RESERVED_REGION));
+  }
+
+  if (((New->UnitCount > 0) && (New->Units == NULL)) ||
+      ((New->ScopeCount > 0) && (New->Scopes == NULL)) ||
+      ((New->RegionCount > 0) && (New->Regions == NULL)))
+  {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Builder.Fill = TRUE;
+  Status       = IndexRemappingTables (&Builder);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = SortRemappingTables (New);
+
+Done:
+  if (EFI_ERROR (Status)) {
+    AcpiTableIndexFree (New);
+    return Status;
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a - %d tables, %d remapping units, %d device scopes (%d unresolved), %d reserved regions\n",
+    __FUNCTION__,
+    New->TableCount,
+    New->UnitCount,
+    New->ScopeCount,
+    New->UnresolvedScopeCount,
+    New->RegionCount
+    ));
+
+  *Index = New;
+  return EFI_SUCCESS;
+}
+
+/**
+  Free an index built by AcpiTableIndexBuild.
+
+  @param[in]  Index   The index to free, may be NULL.
+**/
+VOID
+AcpiTableIndexFree (
+  IN ACPI_TABLE_INDEX  *Index
+  )
+{
+  if (Index == NULL) {
+    return;
+  }
+
+  if (Index->Tables != NULL) {
+    FreePool (Index->Tables);
+  }
+
+  if (Index->Units != NULL) {
+    FreePool (Index->Units);
+  }
+
+  if (Index->Scopes != NULL) {
+    FreePool (Index->Scopes);
+  }
+
+  if (Index->Regions != NULL) {
+    FreePool (Index->Regions);
+  }
+
+  FreePool (Index);
+}
+
+/**
+  Find a table by signature.
+
+  @param[in]  Index       The index.
+  @param[in]  Signature   ACPI table signature.
+  @param[in]  Instance    Which of the tables with this signature, 0 for the first.
+  @param[out] Table       Returns the table.
+
+  @retval EFI_SUCCESS     The table was found.
+  @retval EFI_NOT_FOUND   There is no such table.
+**/
+EFI_STATUS
+AcpiTableIndexGetTable (
+  IN  CONST ACPI_TABLE_INDEX  *Index,
+  IN  UINT32                  Signature,
+  IN  UINTN                   Instance,
+  OUT VOID                    **Table
+  )
+{
+  UINTN  Position;
+
+  Position = FindFirstTable (Index->Tables, Index->TableCount, Signature);
+  if ((Instance >= Index->TableCount - Position) ||
+      (Index->Tables[Position + Instance].Signature != Signature))
+  {
+    return EFI_NOT_FOUND;
+  }
+
+  *Table = Index->Tables[Position + Instance].Table;
+  return EFI_SUCCESS;
+}
+
+/**
+  Find the remapping unit that translates DMA from a PCI function. A unit that
+  lists the function in its device scope wins over an include-all unit on the
+  same segment.
+
+  @param[in]  Index       The index.
+  @param[in]  Segment     The segment of the function.
+  @param[in]  Bus         The bus of the function.
+  @param[in]  Device      The device of the function.
+  @param[in]  Function    The function.
+  @param[out] Unit        Returns the remapping unit.
+
+  @retval EFI_SUCCESS     A unit covers the function.
+  @retval EFI_NOT_FOUND   No unit covers the function.
+**/
+EFI_STATUS
+AcpiTableIndexFindDeviceUnit (
+  IN  CONST ACPI_TABLE_INDEX       *Index,
+  IN  UINT16                       Segment,
+  IN  UINT8                        Bus,
+  IN  UINT8                        Device,
+  IN  UINT8                        Function,
+  OUT CONST ACPI_INDEX_REMAP_UNIT  **Unit
+  )
+{
+  UINT32  SourceId;
+  UINTN   Low;
+  UINTN   High;
+  UINTN   Middle;
+
+  SourceId = ACPI_INDEX_SOURCE_ID (Segment, Bus, Device, Function);
+
+  //
+  // Find the first scope starting above SourceId, then walk back while an
+  // earlier scope could still reach it.
+  //
+  Low  = 0;
+  High = Index->ScopeCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Index->Scopes[Middle].First <= SourceId) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  for ( ; (Low > 0) && (Index->Scopes[Low - 1].MaxLast >= SourceId); Low--) {
+    if (Index->Scopes[Low - 1].Last >= SourceId) {
+      *Unit = &Index->Units[Index->Scopes[Low - 1].Unit];
+      return EFI_SUCCESS;
+    }
+  }
+
+  //
+  // Units are sorted by segment, look for one that includes all devices.
+  //
+  Low  = 0;
+  High = Index->UnitCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Index->Units[Middle].Segment < Segment) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  for ( ; (Low < Index->UnitCount) && (Index->Units[Low].Segment == Segment); Low++) {
+    if ((Index->Units[Low].Flags & ACPI_INDEX_UNIT_INCLUDE_ALL) != 0) {
+      *Unit = &Index->Units[Low];
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Find a reserved memory region that contains an address. When regions
+  overlap, the one with the highest base is returned.
+
+  @param[in]  Index     The index.
+  @param[in]  Address   The address to look up.
+  @param[out] Region    Returns the region.
+
+  @retval EFI_SUCCESS     A region contains Address.
+  @retval EFI_NOT_FOUND   No region contains Address.
+**/
+EFI_STATUS
+AcpiTableIndexFindReservedRegion (
+  IN  CONST ACPI_TABLE_INDEX            *Index,
+  IN  UINT64                            Address,
+  OUT CONST ACPI_INDEX_RESERVED_REGION  **Region
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  Low  = 0;
+  High = Index->RegionCount;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Index->Regions[Middle].Base <= Address) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  for ( ; (Low > 0) && (Index->Regions[Low - 1].MaxLimit >= Address); Low--) {
+    if (Index->Regions[Low - 1].Limit >= Address) {
+      *Region = &Index->Regions[Low - 1];
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
@@ -0,0 +1,191 @@
+/** @file AcpiTableIndex.h
+
+One-time index of the ACPI tables reachable from the RSDP. Tables are kept
+sorted by signature, and the remapping units, device scopes and reserved
+memory regions of the DMAR and IVRS tables are parsed once into sorted arrays
+so the audit can answer lookups with a binary search instead of re-walking
+the tables.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef ACPI_TABLE_INDEX_H_
+#define ACPI_TABLE_INDEX_H_
+
+#include <IndustryStandard/Acpi.h>
+#include <IndustryStandard/DmaRemappingReportingTable.h>
+
+///
+/// The remapping unit claims every device on its segment that no other unit
+/// lists (DMAR INCLUDE_PCI_ALL, IVHD "all" device entry).
+///
+#define ACPI_INDEX_UNIT_INCLUDE_ALL  BIT0
+
+typedef struct {
+  UINT32                         Signature;
+  UINT32                         Order;      // XSDT entries first, then RSDT
+  EFI_ACPI_DESCRIPTION_HEADER    *Table;
+} ACPI_INDEX_TABLE;
+
+typedef struct {
+  UINT16    Segment;
+  UINT8     Type;                            // DRHD or IVHD structure type
+  UINT8     Flags;                           // ACPI_INDEX_UNIT_*
+  UINT32    Order;                           // Parse order, DMAR before IVRS
+  UINT64    BaseAddress;
+  VOID      *Header;                         // DRHD or IVHD structure
+} ACPI_INDEX_REMAP_UNIT;
+
+typedef struct {
+  UINT32    First;                           // Segment << 16 | Bus << 8 | Device << 3 | Function
+  UINT32    Last;                            // Same encoding, inclusive
+  UINT32    MaxLast;                         // Largest Last up to this entry
+  UINT32    Unit;                            // Index into ACPI_TABLE_INDEX.Units
+  UINT8     Type;                            // DMAR scope or IVHD device entry type
+} ACPI_INDEX_DEVICE_SCOPE;
+
+typedef struct {
+  UINT64    Base;
+  UINT64    Limit;                           // Inclusive
+  UINT64    MaxLimit;                        // Largest Limit up to this entry
+  UINT16    Segment;
+  UINT8     Type;                            // RMRR or IVMD structure type
+  VOID      *Header;                         // RMRR or IVMD structure
+} ACPI_INDEX_RESERVED_REGION;
+
+typedef struct {
+  ACPI_INDEX_TABLE              *Tables;     // Sorted by Signature, then Order
+  UINTN                         TableCount;
+  ACPI_INDEX_REMAP_UNIT         *Units;      // Sorted by Segment, then BaseAddress
+  UINTN                         UnitCount;
+  ACPI_INDEX_DEVICE_SCOPE       *Scopes;     // Sorted by First, then Last
+  UINTN                         ScopeCount;
+  UINTN                         UnresolvedScopeCount;
+  ACPI_INDEX_RESERVED_REGION    *Regions;    // Sorted by Base, then Limit
+  UINTN                         RegionCount;
+} ACPI_TABLE_INDEX;
+
+#define ACPI_INDEX_SOURCE_ID(Segment, Bus, Device, Function) \
+  (((UINT32)(Segment) << 16) | ((UINT32)(Bus) << 8) | (((UINT32)(Device) & 0x1F) << 3) | ((UINT32)(Function) & 0x7))
+
+/**
+  Resolve a DMAR device scope to the bus, device and function it names.
+
+  @param[in]  Segment               The segment number.
+  @param[in]  DmarDevScopeEntry     DMAR DevScopeEntry
+  @param[out] Bus                   The bus number.
+  @param[out] Device                The device number.
+  @param[out] Function              The function number.
+
+  @retval EFI_SUCCESS  The PCI device information is returned.
+**/
+typedef
+EFI_STATUS
+(*ACPI_INDEX_RESOLVE_DEVICE_SCOPE)(
+  IN  UINT16                                       Segment,
+  IN  EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER  *DmarDevScopeEntry,
+  OUT UINT8                                        *Bus,
+  OUT UINT8                                        *Device,
+  OUT UINT8                                        *Function
+  );
+
+/**
+  Build the index of the ACPI tables reachable from an RSDP.
+
+  A DMAR device scope whose path has more than one element can only be placed
+  by walking the bridges it names. Such scopes are indexed through Resolve and
+  only counted in UnresolvedScopeCount when Resolve is NULL.
+
+  @param[in]  Rsdp      ACPI RSDP
+  @param[in]  Resolve   Optional resolver for multi element DMAR scopes.
+  @param[out] Index     Returns the index, free it with AcpiTableIndexFree.
+
+  @retval EFI_SUCCESS             The index was built.
+  @retval EFI_INVALID_PARAMETER   Rsdp or Index is NULL.
+  @retval EFI_OUT_OF_RESOURCES    The index could not be allocated.
+  @retval EFI_COMPROMISED_DATA    A DMAR or IVRS structure has a bad length, or an
+                                 IVMD block wraps past the end of memory.
+  @retval EFI_UNSUPPORTED         An IVHD uses a type this parser does not know.
+**/
+EFI_STATUS
+AcpiTableIndexBuild (
+  IN  EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER  *Rsdp,
+  IN  ACPI_INDEX_RESOLVE_DEVICE_SCOPE               Resolve  OPTIONAL,
+  OUT ACPI_TABLE_INDEX                              **Index
+  );
+
+/**
+  Free an index built by AcpiTableIndexBuild.
+
+  @param[in]  Index   The index to free, may be NULL.
+**/
+VOID
+AcpiTableIndexFree (
+  IN ACPI_TABLE_INDEX  *Index
+  );
+
+/**
+  Find a table by signature.
+
+  @param[in]  Index       The index.
+  @param[in]  Signature   ACPI table signature.
+  @param[in]  Instance    Which of the tables with this signature, 0 for the first.
+  @param[out] Table       Returns the table.
+
+  @retval EFI_SUCCESS     The table was found.
+  @retval EFI_NOT_FOUND   There is no such table.
+**/
+EFI_STATUS
+AcpiTableIndexGetTable (
+  IN  CONST ACPI_TABLE_INDEX  *Index,
+  IN  UINT32                  Signature,
+  IN  UINTN                   Instance,
+  OUT VOID                    **Table
+  );
+
+/**
+  Find the remapping unit that translates DMA from a PCI function. A unit that
+  lists the function in its device scope wins over an include-all unit on the
+  same segment.
+
+  @param[in]  Index       The index.
+  @param[in]  Segment     The segment of the function.
+  @param[in]  Bus         The bus of the function.
+  @param[in]  Device      The device of the function.
+  @param[in]  Function    The function.
+  @param[out] Unit        Returns the remapping unit.
+
+  @retval EFI_SUCCESS     A unit covers the function.
+  @retval EFI_NOT_FOUND   No unit covers the function.
+**/
+EFI_STATUS
+AcpiTableIndexFindDeviceUnit (
+  IN  CONST ACPI_TABLE_INDEX       *Index,
+  IN  UINT16                       Segment,
+  IN  UINT8                        Bus,
+  IN  UINT8                        Device,
+  IN  UINT8                        Function,
+  OUT CONST ACPI_INDEX_REMAP_UNIT  **Unit
+  );
+
+/**
+  Find a reserved memory region that contains an address. When regions
+  overlap, the one with the highest base is returned.
+
+  @param[in]  Index     The index.
+  @param[in]  Address   The address to look up.
+  @param[out] Region    Returns the region.
+
+  @retval EFI_SUCCESS     A region contains Address.
+  @retval EFI_NOT_FOUND   No region contains Address.
+**/
+EFI_STATUS
+AcpiTableIndexFindReservedRegion (
+  IN  CONST ACPI_TABLE_INDEX            *Index,
+  IN  UINT64                            Address,
+  OUT CONST ACPI_INDEX_RESERVED_REGION  **Region
+  );
+
+#endif // ACPI_TABLE_INDEX_H_
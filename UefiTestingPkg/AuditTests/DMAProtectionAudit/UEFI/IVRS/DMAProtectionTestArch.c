@@ -20,6 +20,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 #include <Library/IoLib.h>
 
+#include "../Acpi.h"
 #include "IVRS.h"
 #include "DmaProtection.h"
 
@@ -37,16 +38,18 @@ CheckExcludedRegions (
   IN UNIT_TEST_CONTEXT  Context
   )
 {
-  EFI_STATUS             Status;
-  EFI_MEMORY_DESCRIPTOR  *EfiMemoryMap;
-  EFI_MEMORY_DESCRIPTOR  *EfiMemoryMapEnd;
-  EFI_MEMORY_DESCRIPTOR  *EfiMemNext;
-  UINTN                  EfiMemoryMapSize;
-  UINTN                  EfiMapKey;
-  UINTN                  EfiDescriptorSize;
-  UINT32                 EfiDescriptorVersion;
-  IVMDListNode           *Head;
-  IVMDListNode           *Current;
+  EFI_STATUS                        Status;
+  EFI_MEMORY_DESCRIPTOR             *EfiMemoryMap;
+  EFI_MEMORY_DESCRIPTOR             *EfiMemoryMapEnd;
+  EFI_MEMORY_DESCRIPTOR             *EfiMemNext;
+  UINTN                             EfiMemoryMapSize;
+  UINTN                             EfiMapKey;
+  UINTN                             EfiDescriptorSize;
+  UINT32                            EfiDescriptorVersion;
+  ACPI_TABLE_INDEX                  *Index;
+  CONST ACPI_INDEX_RESERVED_REGION  *Region;
+  UINTN                             RegionIndex;
+  UINTN                             RegionCount;
 
   //
   // Step 1: Get IVRS Table
@@ -55,16 +58,23 @@ CheckExcludedRegions (
   UT_ASSERT_NOT_EFI_ERROR (Status);
 
   //
-  // Step 2: Get the IVMD Headers from IVRS Table
+  // Step 2: Get the IVMDs indexed from the IVRS Table
   //
-  Head = GetIvrsAcpiTableIvmd ();
-  if (Head == NULL) {
+  Status = GetAcpiTableIndex (NULL, &Index);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  RegionCount = 0;
+  for (RegionIndex = 0; RegionIndex < Index->RegionCount; RegionIndex++) {
+    if ((Index->Regions[RegionIndex].Type >= IVMD_TYPE_20H) && (Index->Regions[RegionIndex].Type <= IVMD_TYPE_22H)) {
+      RegionCount++;
+    }
+  }
+
+  if (RegionCount == 0) {
     UT_LOG_INFO ("No IVMDs Found\n");
     return UNIT_TEST_PASSED;
   }
 
-  Current = Head;
-
   //
   // Step 3: Get the EFI memory map.
   //
@@ -94,39 +104,36 @@ CheckExcludedRegions (
   }
 
   //
-  // Step 4: Step through memory map and verify each
-  //         IVMD memory ranges are marked reserved
+  // Step 4: Verify each IVMD memory range lies in a
+  //         descriptor that is marked reserved
   //
-  EfiMemNext      = EfiMemoryMap;
   EfiMemoryMapEnd = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)EfiMemoryMap + EfiMemoryMapSize);
 
-  while (EfiMemNext < EfiMemoryMapEnd) {
-    // Check if memory range fully encompasses IVMD
-    if (  (EfiMemNext->PhysicalStart <= Current->IVMD->IVMDStartAddress)
-       && ((EfiMemNext->PhysicalStart + EFI_PAGE_SIZE * EfiMemNext->NumberOfPages) >= (Current->IVMD->IVMDStartAddress + Current->IVMD->IVMDMemoryBlockLength)))
-    {
-      // Verify memory range is marked as reserved
-      UT_ASSERT_EQUAL (EfiMemNext->Type, EfiACPIMemoryNVS);
-      UT_LOG_INFO ("IVMDs between %X and %X found with type EfiACPIMemoryNVS\n", Current->IVMD->IVMDStartAddress, Current->IVMD->IVMDStartAddress + Current->IVMD->IVMDMemoryBlockLength);
-
-      // Move on to next IVMD and start search at beginning of memory map again
-      EfiMemNext = EfiMemoryMap;
-      if (Current->Next == NULL) {
-        return UNIT_TEST_PASSED;
+  for (RegionIndex = 0; RegionIndex < Index->RegionCount; RegionIndex++) {
+    Region = &Index->Regions[RegionIndex];
+    if ((Region->Type < IVMD_TYPE_20H) || (Region->Type > IVMD_TYPE_22H)) {
+      continue;
+    }
+
+    // Find the memory range that fully encompasses the IVMD
+    for (EfiMemNext = EfiMemoryMap; EfiMemNext < EfiMemoryMapEnd; EfiMemNext = NEXT_MEMORY_DESCRIPTOR (EfiMemNext, EfiDescriptorSize)) {
+      if (  (EfiMemNext->PhysicalStart <= Region->Base)
+         && ((EfiMemNext->PhysicalStart + EFI_PAGE_SIZE * EfiMemNext->NumberOfPages) > Region->Limit))
+      {
+        break;
       }
+    }
 
-      Current = Current->Next;
-    } else {
-      // Move on to next descriptor
-      EfiMemNext = NEXT_MEMORY_DESCRIPTOR (EfiMemNext, EfiDescriptorSize);
+    // IVMD Not found in memory map
+    UT_ASSERT_TRUE (EfiMemNext < EfiMemoryMapEnd);
 
-      // IVMD Not found in memory map
-      UT_ASSERT_TRUE (EfiMemNext < EfiMemoryMapEnd);
-    }
+    // Verify memory range is marked as reserved
+    UT_ASSERT_EQUAL (EfiMemNext->Type, EfiACPIMemoryNVS);
+    UT_LOG_INFO ("IVMDs between %lX and %lX found with type EfiACPIMemoryNVS\n", Region->Base, Region->Limit);
   }
 
-  // Should never reach here
-  return UNIT_TEST_ERROR_TEST_FAILED;
+  FreePool (EfiMemoryMap);
+  return UNIT_TEST_PASSED;
 } // CheckExcludedRegions()
 
 UNIT_TEST_STATUS
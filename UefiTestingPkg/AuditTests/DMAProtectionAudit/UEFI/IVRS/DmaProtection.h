@@ -29,12 +29,6 @@ for purpose of easy IVRS/BME parsing
 
 #include <IndustryStandard/Pci.h>
 
-// Linked List node used for IVMD Test
-typedef struct IVMDListNode_t_def {
-  IVMD_Header                  *IVMD;
-  struct IVMDListNode_t_def    *Next;
-} IVMDListNode;
-
 extern EFI_ACPI_IVRS_HEADER  *mAcpiIVRSTable;
 extern UINTN                 mIvhdUnitNumber;
 extern IVHD_Header           *mIvhdUnitInformation;
@@ -61,16 +55,6 @@ ParseIvrsAcpiTableIvhd (
   VOID
   );
 
-/**
-  Parse IVRS table.
-
-  @return Linked List to all IVMD headers. Caller is required to check for NULL if no IVMDs found.
-**/
-IVMDListNode *
-GetIvrsAcpiTableIvmd (
-  VOID
-  );
-
 /**
   Get IVHD Entry number.
 **/
@@ -107,55 +107,6 @@ ProcessIvhd (
   return EFI_SUCCESS;
 }
 
-/**
-  Parse IVRS table.
-
-  @return Linked List to all IVMD headers. Caller is required to check for NULL if no RMRRs found.
-**/
-IVMDListNode *
-GetIvrsAcpiTableIvmd (
-  VOID
-  )
-{
-  IVMD_Header   *IvrsHeader;
-  IVMDListNode  *NewNode;
-  IVMDListNode  *Head;
-  IVMDListNode  *Tail;
-
-  NewNode = NULL;
-  Head    = NULL;
-  Tail    = Head;
-
-  IvrsHeader = (IVMD_Header *)((UINTN)(mAcpiIVRSTable + 1));
-  while ((UINTN)IvrsHeader < (UINTN)mAcpiIVRSTable + mAcpiIVRSTable->Header.Length) {
-    switch (IvrsHeader->Type) {
-      case IVMD_TYPE_20H:
-      case IVMD_TYPE_21H:
-      case IVMD_TYPE_22H:
-        // If IVMD found add to end of linked list
-        NewNode       = (IVMDListNode *)AllocateZeroPool (sizeof (IVMDListNode));
-        NewNode->IVMD = (IVMD_Header *)IvrsHeader;
-        NewNode->Next = NULL;
-
-        if (Head == NULL) {
-          Head = NewNode;
-          Tail = NewNode;
-        } else {
-          Tail->Next = NewNode;
-          Tail       = NewNode;
-        }
-
-        break;
-      default:
-        break;
-    }
-
-    IvrsHeader = (IVMD_Header *)((UINTN)IvrsHeader + IvrsHeader->Length);
-  }
-
-  return Head;
-}
-
 /**
   Get Ivhd Entry number.
 **/
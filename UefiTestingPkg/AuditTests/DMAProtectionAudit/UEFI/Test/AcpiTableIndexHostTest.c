@@ -0,0 +1,886 @@
+/** @file -- AcpiTableIndexHostTest.c
+Host-based UnitTest for the ACPI table index used by DMAProtectionAudit.
+
+Synthetic XSDT, DMAR and IVRS tables are built in memory, including DMARs with
+thousands of device scopes, and every lookup the index answers is checked
+against what the tables describe.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../Acpi.h"
+#include "../IVRS/IVRS.h"
+
+#define UNIT_TEST_NAME     "ACPI Table Index Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define TABLE_BUFFER_SIZE  SIZE_256KB
+#define MAX_FAKE_TABLES    8
+
+//
+// DMAR used by the bulk test: three scoped units and an include-all unit on
+// segment 0, and one scoped unit on segment 1.
+//
+#define SCOPES_PER_UNIT     2000
+#define SEGMENT_1_SCOPES    500
+#define RMRR_COUNT          300
+#define INCLUDE_ALL_BASE    0xFED90000ULL
+#define SEGMENT_1_BASE      0xFED80000ULL
+#define RMRR_STRIDE         0x10000ULL
+
+#define FACP_SIGNATURE  SIGNATURE_32 ('F', 'A', 'C', 'P')
+#define SSDT_SIGNATURE  SIGNATURE_32 ('S', 'S', 'D', 'T')
+#define APIC_SIGNATURE  SIGNATURE_32 ('A', 'P', 'I', 'C')
+#define HPET_SIGNATURE  SIGNATURE_32 ('H', 'P', 'E', 'T')
+
+typedef struct {
+  UINT8    *Data;
+  UINTN    Length;
+} FAKE_TABLE;
+
+STATIC EFI_ACPI_2_0_ROOT_SYSTEM_DESCRIPTION_POINTER  mRsdp;
+STATIC FAKE_TABLE                                    mXsdt;
+STATIC FAKE_TABLE                                    mTables[MAX_FAKE_TABLES];
+STATIC UINTN                                         mTableCount;
+STATIC ACPI_TABLE_INDEX                              *mIndex;
+
+//
+// Register bases of the scoped segment 0 units, listed out of order so the
+// index has to sort them.
+//
+STATIC CONST UINT64  mScopedUnitBase[] = { 0xFED93000ULL, 0xFED91000ULL, 0xFED92000ULL };
+
+/**
+  Append Size bytes to a table, copied from Data or zeroed.
+
+  @return Where the bytes were placed in the table.
+**/
+STATIC
+VOID *
+Append (
+  IN OUT FAKE_TABLE  *Table,
+  IN     CONST VOID  *Data  OPTIONAL,
+  IN     UINTN       Size
+  )
+{
+  VOID  *Dest;
+
+  ASSERT (Table->Length + Size <= TABLE_BUFFER_SIZE);
+  Dest = Table->Data + Table->Length;
+  if (Data != NULL) {
+    CopyMem (Dest, Data, Size);
+  } else {
+    ZeroMem (Dest, Size);
+  }
+
+  Table->Length += Size;
+  return Dest;
+}
+
+/**
+  Start a new table with a header of HeaderSize bytes and list it in the XSDT.
+**/
+STATIC
+FAKE_TABLE *
+BeginTable (
+  IN UINT32  Signature,
+  IN UINTN   HeaderSize
+  )
+{
+  FAKE_TABLE                   *Table;
+  EFI_ACPI_DESCRIPTION_HEADER  *Header;
+  UINT64                       Entry;
+
+  ASSERT (mTableCount < MAX_FAKE_TABLES);
+  Table         = &mTables[mTableCount++];
+  Table->Data   = AllocateZeroPool (TABLE_BUFFER_SIZE);
+  Table->Length = 0;
+  ASSERT (Table->Data != NULL);
+
+  Header            = Append (Table, NULL, HeaderSize);
+  Header->Signature = Signature;
+  Header->Revision  = 1;
+
+  Entry = (UINT64)(UINTN)Table->Data;
+  Append (&mXsdt, &Entry, sizeof (Entry));
+  ((EFI_ACPI_DESCRIPTION_HEADER *)mXsdt.Data)->Length = (UINT32)mXsdt.Length;
+  return Table;
+}
+
+STATIC
+VOID
+EndTable (
+  IN FAKE_TABLE  *Table
+  )
+{
+  ((EFI_ACPI_DESCRIPTION_HEADER *)Table->Data)->Length = (UINT32)Table->Length;
+}
+
+/**
+  Add a NULL entry to the XSDT, which the index must skip.
+**/
+STATIC
+VOID
+AddNullXsdtEntry (
+  VOID
+  )
+{
+  UINT64  Entry;
+
+  Entry = 0;
+  Append (&mXsdt, &Entry, sizeof (Entry));
+  ((EFI_ACPI_DESCRIPTION_HEADER *)mXsdt.Data)->Length = (UINT32)mXsdt.Length;
+}
+
+STATIC
+EFI_ACPI_DMAR_DRHD_HEADER *
+AppendDrhd (
+  IN OUT FAKE_TABLE  *Dmar,
+  IN     UINT16      Segment,
+  IN     UINT8       Flags,
+  IN     UINT64      Base
+  )
+{
+  EFI_ACPI_DMAR_DRHD_HEADER  *Drhd;
+
+  Drhd                      = Append (Dmar, NULL, sizeof (*Drhd));
+  Drhd->Header.Type         = EFI_ACPI_DMAR_TYPE_DRHD;
+  Drhd->Header.Length       = sizeof (*Drhd);
+  Drhd->Flags               = Flags;
+  Drhd->SegmentNumber       = Segment;
+  Drhd->RegisterBaseAddress = Base;
+  return Drhd;
+}
+
+/**
+  Append a device scope to the DRHD that was appended last. Path holds
+  PathCount device and function pairs.
+**/
+STATIC
+VOID
+AppendScope (
+  IN OUT FAKE_TABLE                 *Dmar,
+  IN OUT EFI_ACPI_DMAR_DRHD_HEADER  *Drhd,
+  IN     UINT8                      Type,
+  IN     UINT8                      StartBus,
+  IN     CONST UINT8                *Path,
+  IN     UINTN                      PathCount
+  )
+{
+  EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER  *Scope;
+  UINTN                                        Length;
+
+  Length                = sizeof (*Scope) + PathCount * sizeof (EFI_ACPI_DMAR_PCI_PATH);
+  Scope                 = Append (Dmar, NULL, sizeof (*Scope));
+  Scope->Type           = Type;
+  Scope->Length         = (UINT8)Length;
+  Scope->StartBusNumber = StartBus;
+  Append (Dmar, Path, PathCount * sizeof (EFI_ACPI_DMAR_PCI_PATH));
+  Drhd->Header.Length = (UINT16)(Drhd->Header.Length + Length);
+}
+
+STATIC
+VOID
+AppendRmrr (
+  IN OUT FAKE_TABLE  *Dmar,
+  IN     UINT16      Segment,
+  IN     UINT64      Base,
+  IN     UINT64      Limit
+  )
+{
+  EFI_ACPI_DMAR_RMRR_HEADER  *Rmrr;
+
+  Rmrr                                   = Append (Dmar, NULL, sizeof (*Rmrr));
+  Rmrr->Header.Type                      = EFI_ACPI_DMAR_TYPE_RMRR;
+  Rmrr->Header.Length                    = sizeof (*Rmrr);
+  Rmrr->SegmentNumber                    = Segment;
+  Rmrr->ReservedMemoryRegionBaseAddress  = Base;
+  Rmrr->ReservedMemoryRegionLimitAddress = Limit;
+}
+
+/**
+  Append Count endpoint scopes starting at bus FirstBus, device 0, function 0
+  and walking up through every function.
+**/
+STATIC
+VOID
+AppendEndpointScopes (
+  IN OUT FAKE_TABLE                 *Dmar,
+  IN OUT EFI_ACPI_DMAR_DRHD_HEADER  *Drhd,
+  IN     UINT8                      FirstBus,
+  IN     UINTN                      Count
+  )
+{
+  UINTN  Scope;
+  UINT8  Path[2];
+
+  for (Scope = 0; Scope < Count; Scope++) {
+    Path[0] = (UINT8)((Scope >> 3) & 0x1F);
+    Path[1] = (UINT8)(Scope & 0x7);
+    AppendScope (Dmar, Drhd, EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_ENDPOINT, (UINT8)(FirstBus + Scope / 256), Path, 1);
+  }
+}
+
+STATIC
+IVHD_Header *
+AppendIvhd (
+  IN OUT FAKE_TABLE  *Ivrs,
+  IN     UINT8       Type,
+  IN     UINT16      Segment,
+  IN     UINT64      Base
+  )
+{
+  IVHD_Header  *Ivhd;
+  UINTN        Length;
+
+  Length = sizeof (*Ivhd);
+  if (Type != IVHD_TYPE_10H) {
+    Length += 16;
+  }
+
+  Ivhd                   = Append (Ivrs, NULL, Length);
+  Ivhd->Type             = Type;
+  Ivhd->Length           = (UINT16)Length;
+  Ivhd->PCISegmentGroup  = Segment;
+  Ivhd->IOMMUBaseAddress = Base;
+  return Ivhd;
+}
+
+/**
+  Append a 4 byte device entry, or an 8 byte one carrying ExDeviceId.
+**/
+STATIC
+VOID
+AppendIvhdEntry (
+  IN OUT FAKE_TABLE   *Ivrs,
+  IN OUT IVHD_Header  *Ivhd,
+  IN     UINT8        Type,
+  IN     UINT16       DeviceId,
+  IN     UINT16       ExDeviceId
+  )
+{
+  IVHD_DEVICE_ENTRY_COMMON  *Entry;
+  IVHD_DEVICE_ENTRY_EX      *Ex;
+
+  Entry                 = Append (Ivrs, NULL, sizeof (*Entry));
+  Entry->DeviceType     = Type;
+  Entry->DeviceID.Value = DeviceId;
+  Ivhd->Length          = (UINT16)(Ivhd->Length + sizeof (*Entry));
+  if (Type >= 0x40) {
+    Ex                 = Append (Ivrs, NULL, sizeof (*Ex));
+    Ex->DeviceID.Value = ExDeviceId;
+    Ivhd->Length       = (UINT16)(Ivhd->Length + sizeof (*Ex));
+  }
+}
+
+STATIC
+VOID
+AppendIvmd (
+  IN OUT FAKE_TABLE  *Ivrs,
+  IN     UINT8       Type,
+  IN     UINT64      Start,
+  IN     UINT64      Length
+  )
+{
+  IVMD_Header  *Ivmd;
+
+  Ivmd                        = Append (Ivrs, NULL, sizeof (*Ivmd));
+  Ivmd->Type                  = Type;
+  Ivmd->Length                = sizeof (*Ivmd);
+  Ivmd->IVMDStartAddress      = Start;
+  Ivmd->IVMDMemoryBlockLength = Length;
+}
+
+/**
+  Resolver that places every multi element scope on bus 0x42, at the device
+  and function of the last path element.
+**/
+STATIC
+EFI_STATUS
+FakeResolve (
+  IN  UINT16                                       Segment,
+  IN  EFI_ACPI_DMAR_DEVICE_SCOPE_STRUCTURE_HEADER  *DmarDevScopeEntry,
+  OUT UINT8                                        *Bus,
+  OUT UINT8                                        *Device,
+  OUT UINT8                                        *Function
+  )
+{
+  EFI_ACPI_DMAR_PCI_PATH  *Last;
+
+  Last      = (EFI_ACPI_DMAR_PCI_PATH *)((UINTN)DmarDevScopeEntry + DmarDevScopeEntry->Length) - 1;
+  *Bus      = 0x42;
+  *Device   = Last->Device;
+  *Function = Last->Function;
+  return EFI_SUCCESS;
+}
+
+/**
+  Start every test with an RSDP pointing at an empty XSDT.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ResetTables (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_ACPI_DESCRIPTION_HEADER  *Header;
+
+  ZeroMem (&mRsdp, sizeof (mRsdp));
+  ZeroMem (mTables, sizeof (mTables));
+  mTableCount = 0;
+  mIndex      = NULL;
+
+  mXsdt.Data   = AllocateZeroPool (SIZE_4KB);
+  mXsdt.Length = 0;
+  ASSERT (mXsdt.Data != NULL);
+  Header            = Append (&mXsdt, NULL, sizeof (EFI_ACPI_DESCRIPTION_HEADER));
+  Header->Signature = SIGNATURE_32 ('X', 'S', 'D', 'T');
+  Header->Length    = sizeof (EFI_ACPI_DESCRIPTION_HEADER);
+
+  mRsdp.Revision    = 2;
+  mRsdp.XsdtAddress = (UINT64)(UINTN)mXsdt.Data;
+  return UNIT_TEST_PASSED;
+}
+
+STATIC
+VOID
+EFIAPI
+FreeTables (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Table;
+
+  AcpiTableIndexFree (mIndex);
+  mIndex = NULL;
+
+  for (Table = 0; Table < mTableCount; Table++) {
+    FreePool (mTables[Table].Data);
+  }
+
+  mTableCount = 0;
+  FreePool (mXsdt.Data);
+  mXsdt.Data = NULL;
+}
+
+/**
+  Build the DMAR for the bulk tests: SCOPES_PER_UNIT endpoints under each
+  scoped segment 0 unit, an include-all unit, SEGMENT_1_SCOPES endpoints on
+  segment 1, and RMRR_COUNT RMRRs listed in a shuffled order.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BuildLargeDmar (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FAKE_TABLE                 *Dmar;
+  EFI_ACPI_DMAR_DRHD_HEADER  *Drhd;
+  UINTN                      Unit;
+  UINTN                      Rmrr;
+  UINTN                      Slot;
+  UINT8                      Path[2];
+
+  ResetTables (Context);
+  Dmar = BeginTable (EFI_ACPI_4_0_DMA_REMAPPING_TABLE_SIGNATURE, sizeof (EFI_ACPI_DMAR_HEADER));
+
+  //
+  // Scoped unit n owns buses 0x10 * (n + 1) onwards.
+  //
+  for (Unit = 0; Unit < ARRAY_SIZE (mScopedUnitBase); Unit++) {
+    Drhd = AppendDrhd (Dmar, 0, 0, mScopedUnitBase[Unit]);
+    AppendEndpointScopes (Dmar, Drhd, (UINT8)(0x10 * (Unit + 1)), SCOPES_PER_UNIT);
+  }
+
+  Drhd = AppendDrhd (Dmar, 1, 0, SEGMENT_1_BASE);
+  AppendEndpointScopes (Dmar, Drhd, 0x80, SEGMENT_1_SCOPES);
+
+  //
+  // RMRR n covers [n * RMRR_STRIDE, n * RMRR_STRIDE + 0xFFF], emitted with a
+  // stride coprime to the count so they arrive out of order.
+  //
+  for (Rmrr = 0; Rmrr < RMRR_COUNT; Rmrr++) {
+    Slot = (Rmrr * 7) % RMRR_COUNT;
+    AppendRmrr (Dmar, 0, Slot * RMRR_STRIDE, Slot * RMRR_STRIDE + 0xFFF);
+  }
+
+  //
+  // The include-all unit comes last as the spec requires, with an IOAPIC.
+  //
+  Drhd    = AppendDrhd (Dmar, 0, EFI_ACPI_DMAR_DRHD_FLAGS_INCLUDE_PCI_ALL, INCLUDE_ALL_BASE);
+  Path[0] = 0x1F;
+  Path[1] = 0;
+  AppendScope (Dmar, Drhd, EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_IOAPIC, 0xF0, Path, 1);
+  EndTable (Dmar);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Tables are found by signature and instance, in XSDT order.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+TablesFoundBySignature (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FAKE_TABLE  *Ssdt[3];
+  FAKE_TABLE  *Facp;
+  FAKE_TABLE  *Apic;
+  VOID        *Table;
+  UINTN       Instance;
+
+  Facp    = BeginTable (FACP_SIGNATURE, sizeof (EFI_ACPI_DESCRIPTION_HEADER));
+  Ssdt[0] = BeginTable (SSDT_SIGNATURE, sizeof (EFI_ACPI_DESCRIPTION_HEADER));
+  AddNullXsdtEntry ();
+  Apic    = BeginTable (APIC_SIGNATURE, sizeof (EFI_ACPI_DESCRIPTION_HEADER));
+  Ssdt[1] = BeginTable (SSDT_SIGNATURE, sizeof (EFI_ACPI_DESCRIPTION_HEADER));
+  Ssdt[2] = BeginTable (SSDT_SIGNATURE, sizeof (EFI_ACPI_DESCRIPTION_HEADER));
+  EndTable (Facp);
+  EndTable (Apic);
+  for (Instance = 0; Instance < ARRAY_SIZE (Ssdt); Instance++) {
+    EndTable (Ssdt[Instance]);
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex));
+  UT_ASSERT_EQUAL (mIndex->TableCount, 5);
+  UT_ASSERT_EQUAL (mIndex->UnitCount, 0);
+  UT_ASSERT_EQUAL (mIndex->RegionCount, 0);
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexGetTable (mIndex, FACP_SIGNATURE, 0, &Table));
+  UT_ASSERT_EQUAL ((UINTN)Table, (UINTN)Facp->Data);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexGetTable (mIndex, APIC_SIGNATURE, 0, &Table));
+  UT_ASSERT_EQUAL ((UINTN)Table, (UINTN)Apic->Data);
+
+  for (Instance = 0; Instance < ARRAY_SIZE (Ssdt); Instance++) {
+    UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexGetTable (mIndex, SSDT_SIGNATURE, Instance, &Table));
+    UT_ASSERT_EQUAL ((UINTN)Table, (UINTN)Ssdt[Instance]->Data);
+  }
+
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexGetTable (mIndex, SSDT_SIGNATURE, 3, &Table), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexGetTable (mIndex, HPET_SIGNATURE, 0, &Table), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexGetTable (mIndex, EFI_ACPI_4_0_DMA_REMAPPING_TABLE_SIGNATURE, 0, &Table), EFI_NOT_FOUND);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Every one of thousands of DMAR device scopes maps to the unit that lists it,
+  anything else on segment 0 falls to the include-all unit, and units come
+  out sorted by segment and base.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DmarScopesMapToTheirUnit (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CONST ACPI_INDEX_REMAP_UNIT  *Unit;
+  UINTN                        Owner;
+  UINTN                        Scope;
+  UINTN                        Entry;
+  UINT8                        Bus;
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex));
+  UT_ASSERT_EQUAL (mIndex->UnitCount, ARRAY_SIZE (mScopedUnitBase) + 2);
+  UT_ASSERT_EQUAL (mIndex->ScopeCount, ARRAY_SIZE (mScopedUnitBase) * SCOPES_PER_UNIT + SEGMENT_1_SCOPES + 1);
+  UT_ASSERT_EQUAL (mIndex->UnresolvedScopeCount, 0);
+
+  for (Entry = 1; Entry < mIndex->UnitCount; Entry++) {
+    UT_ASSERT_TRUE (
+      (mIndex->Units[Entry - 1].Segment < mIndex->Units[Entry].Segment) ||
+      ((mIndex->Units[Entry - 1].Segment == mIndex->Units[Entry].Segment) &&
+       (mIndex->Units[Entry - 1].BaseAddress < mIndex->Units[Entry].BaseAddress))
+      );
+  }
+
+  for (Entry = 1; Entry < mIndex->ScopeCount; Entry++) {
+    UT_ASSERT_TRUE (mIndex->Scopes[Entry - 1].First <= mIndex->Scopes[Entry].First);
+  }
+
+  for (Owner = 0; Owner < ARRAY_SIZE (mScopedUnitBase); Owner++) {
+    for (Scope = 0; Scope < SCOPES_PER_UNIT; Scope++) {
+      Bus = (UINT8)(0x10 * (Owner + 1) + Scope / 256);
+      UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, Bus, (UINT8)((Scope >> 3) & 0x1F), (UINT8)(Scope & 0x7), &Unit));
+      UT_ASSERT_EQUAL (Unit->BaseAddress, mScopedUnitBase[Owner]);
+      UT_ASSERT_EQUAL (Unit->Type, EFI_ACPI_DMAR_TYPE_DRHD);
+    }
+  }
+
+  for (Scope = 0; Scope < SEGMENT_1_SCOPES; Scope++) {
+    UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 1, (UINT8)(0x80 + Scope / 256), (UINT8)((Scope >> 3) & 0x1F), (UINT8)(Scope & 0x7), &Unit));
+    UT_ASSERT_EQUAL (Unit->BaseAddress, SEGMENT_1_BASE);
+  }
+
+  //
+  // Unlisted devices: segment 0 has an include-all unit, segments 1 and 2 do not.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x00, 0x02, 0, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, INCLUDE_ALL_BASE);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0xF0, 0x1F, 0, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, INCLUDE_ALL_BASE);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindDeviceUnit (mIndex, 1, 0x00, 0x02, 0, &Unit), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindDeviceUnit (mIndex, 2, 0x80, 0x00, 0, &Unit), EFI_NOT_FOUND);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  RMRRs listed out of order come back sorted, and every address inside one is
+  found while the gaps between them are not.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+RmrrsSortedAndFound (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CONST ACPI_INDEX_RESERVED_REGION  *Region;
+  UINTN                             Rmrr;
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex));
+  UT_ASSERT_EQUAL (mIndex->RegionCount, RMRR_COUNT);
+
+  for (Rmrr = 0; Rmrr < RMRR_COUNT; Rmrr++) {
+    UT_ASSERT_EQUAL (mIndex->Regions[Rmrr].Base, Rmrr * RMRR_STRIDE);
+    UT_ASSERT_EQUAL (mIndex->Regions[Rmrr].Type, EFI_ACPI_DMAR_TYPE_RMRR);
+
+    UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindReservedRegion (mIndex, Rmrr * RMRR_STRIDE, &Region));
+    UT_ASSERT_EQUAL (Region->Base, Rmrr * RMRR_STRIDE);
+    UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindReservedRegion (mIndex, Rmrr * RMRR_STRIDE + 0xFFF, &Region));
+    UT_ASSERT_EQUAL (Region->Base, Rmrr * RMRR_STRIDE);
+    UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindReservedRegion (mIndex, Rmrr * RMRR_STRIDE + 0x1000, &Region), EFI_NOT_FOUND);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Overlapping regions: an address is found in any region that contains it,
+  even when a later region starts closer to it without reaching it.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+OverlappingRegionsFound (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FAKE_TABLE                        *Dmar;
+  CONST ACPI_INDEX_RESERVED_REGION  *Region;
+
+  Dmar = BeginTable (EFI_ACPI_4_0_DMA_REMAPPING_TABLE_SIGNATURE, sizeof (EFI_ACPI_DMAR_HEADER));
+  AppendRmrr (Dmar, 0, 0x200000, 0x200FFF);
+  AppendRmrr (Dmar, 0, 0x5000, 0x5FFF);
+  AppendRmrr (Dmar, 0, 0x1000, 0x100FFF);
+  AppendRmrr (Dmar, 0, 0x1000, 0x1FFF);
+  EndTable (Dmar);
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex));
+  UT_ASSERT_EQUAL (mIndex->RegionCount, 4);
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindReservedRegion (mIndex, 0x1800, &Region));
+  UT_ASSERT_TRUE ((Region->Base <= 0x1800) && (Region->Limit >= 0x1800));
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindReservedRegion (mIndex, 0x5800, &Region));
+  UT_ASSERT_EQUAL (Region->Base, 0x5000);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindReservedRegion (mIndex, 0x8000, &Region));
+  UT_ASSERT_EQUAL (Region->Limit, 0x100FFF);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindReservedRegion (mIndex, 0x200800, &Region));
+  UT_ASSERT_EQUAL (Region->Base, 0x200000);
+
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindReservedRegion (mIndex, 0xFFF, &Region), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindReservedRegion (mIndex, 0x101000, &Region), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindReservedRegion (mIndex, MAX_UINT64, &Region), EFI_NOT_FOUND);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Scopes behind a bridge are only indexed when a resolver is given.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BridgedScopesNeedResolver (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FAKE_TABLE                   *Dmar;
+  EFI_ACPI_DMAR_DRHD_HEADER    *Drhd;
+  CONST ACPI_INDEX_REMAP_UNIT  *Unit;
+  UINT8                        Path[4];
+
+  Dmar    = BeginTable (EFI_ACPI_4_0_DMA_REMAPPING_TABLE_SIGNATURE, sizeof (EFI_ACPI_DMAR_HEADER));
+  Drhd    = AppendDrhd (Dmar, 0, 0, 0xFED91000);
+  Path[0] = 0x1C;
+  Path[1] = 0;
+  AppendScope (Dmar, Drhd, EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_BRIDGE, 0, Path, 1);
+  Path[2] = 0x03;
+  Path[3] = 0x01;
+  AppendScope (Dmar, Drhd, EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_ENDPOINT, 0, Path, 2);
+  EndTable (Dmar);
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex));
+  UT_ASSERT_EQUAL (mIndex->ScopeCount, 1);
+  UT_ASSERT_EQUAL (mIndex->UnresolvedScopeCount, 1);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0, 0x1C, 0, &Unit));
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x42, 0x03, 0x01, &Unit), EFI_NOT_FOUND);
+  AcpiTableIndexFree (mIndex);
+  mIndex = NULL;
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexBuild (&mRsdp, FakeResolve, &mIndex));
+  UT_ASSERT_EQUAL (mIndex->ScopeCount, 2);
+  UT_ASSERT_EQUAL (mIndex->UnresolvedScopeCount, 0);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x42, 0x03, 0x01, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, 0xFED91000);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  IVHD select, range, alias, extended and special entries map to their IOMMU,
+  the "all" entry makes an include-all unit, and IVMD blocks become regions.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+IvrsUnitsScopesAndRegions (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FAKE_TABLE                        *Ivrs;
+  IVHD_Header                       *Ivhd;
+  IVHD_DEVICE_ENTRY_F0H             *Acpi;
+  CONST ACPI_INDEX_REMAP_UNIT       *Unit;
+  CONST ACPI_INDEX_RESERVED_REGION  *Region;
+  UINTN                             Function;
+
+  Ivrs = BeginTable (IVRS_HEADER_SIGNATURE, sizeof (EFI_ACPI_IVRS_HEADER));
+
+  Ivhd = AppendIvhd (Ivrs, IVHD_TYPE_40H, 0, 0xFEB80000);
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_01H, 0, 0);
+
+  Ivhd = AppendIvhd (Ivrs, IVHD_TYPE_10H, 0, 0xFEB00000);
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_00H, 0, 0);
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_02H, 0x0010, 0);       // 00:02.0
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_03H, 0x0100, 0);       // 01:00.0 ...
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_04H, 0x01FF, 0);       // ... 01:1F.7
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_43H, 0x0200, 0x0008);  // 02:00.0 ...
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_04H, 0x0207, 0);       // ... 02:00.7
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_46H, 0x0300, 0);       // 03:00.0
+  AppendIvhdEntry (Ivrs, Ivhd, IVRS_DTE_TYPE_48H, 0, 0x00A0);       // 00:14.0
+
+  Acpi                              = Append (Ivrs, NULL, sizeof (*Acpi) + 4);
+  Acpi->CommonHeader.DeviceType     = IVRS_DTE_TYPE_F0H;
+  Acpi->CommonHeader.DeviceID.Value = 0x00F8;                       // 00:1F.0
+  Acpi->UniqueIdLength              = 4;
+  Ivhd->Length                      = (UINT16)(Ivhd->Length + sizeof (*Acpi) + 4);
+
+  AppendIvmd (Ivrs, IVMD_TYPE_20H, 0x9000, 0x1000);
+  AppendIvmd (Ivrs, IVMD_TYPE_21H, 0x3000, 0);
+  AppendIvmd (Ivrs, IVMD_TYPE_22H, 0x4000, 0x2000);
+  EndTable (Ivrs);
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex));
+  UT_ASSERT_EQUAL (mIndex->UnitCount, 2);
+  UT_ASSERT_EQUAL (mIndex->Units[0].BaseAddress, 0xFEB00000);
+  UT_ASSERT_EQUAL (mIndex->Units[0].Type, IVHD_TYPE_10H);
+  UT_ASSERT_EQUAL (mIndex->Units[0].Flags, 0);
+  UT_ASSERT_EQUAL (mIndex->Units[1].Flags, ACPI_INDEX_UNIT_INCLUDE_ALL);
+  UT_ASSERT_EQUAL (mIndex->ScopeCount, 6);
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x00, 0x02, 0, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, 0xFEB00000);
+  for (Function = 0; Function < 0x100; Function++) {
+    UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x01, (UINT8)(Function >> 3), (UINT8)(Function & 0x7), &Unit));
+    UT_ASSERT_EQUAL (Unit->BaseAddress, 0xFEB00000);
+  }
+
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x02, 0x00, 0x7, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, 0xFEB00000);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x03, 0x00, 0x0, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, 0xFEB00000);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x00, 0x14, 0x0, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, 0xFEB00000);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x00, 0x1F, 0x0, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, 0xFEB00000);
+
+  //
+  // Outside every range: the "all" IOMMU picks it up.
+  //
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindDeviceUnit (mIndex, 0, 0x02, 0x01, 0x0, &Unit));
+  UT_ASSERT_EQUAL (Unit->BaseAddress, 0xFEB80000);
+
+  //
+  // The empty IVMD reserves nothing and is left out.
+  //
+  UT_ASSERT_EQUAL (mIndex->RegionCount, 2);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindReservedRegion (mIndex, 0x5FFF, &Region));
+  UT_ASSERT_EQUAL (Region->Base, 0x4000);
+  UT_ASSERT_EQUAL (Region->Type, IVMD_TYPE_22H);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexFindReservedRegion (mIndex, 0x9FFF, &Region));
+  UT_ASSERT_EQUAL (Region->Limit, 0x9FFF);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindReservedRegion (mIndex, 0xA000, &Region), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexFindReservedRegion (mIndex, 0x3000, &Region), EFI_NOT_FOUND);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Structures whose lengths would stall or overrun the walk, and IVMD blocks
+  that wrap past the end of memory, are rejected.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+MalformedTablesRejected (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  FAKE_TABLE                      *Table;
+  EFI_ACPI_DMAR_DRHD_HEADER       *Drhd;
+  EFI_ACPI_DMAR_STRUCTURE_HEADER  *Empty;
+  IVHD_Header                     *Ivhd;
+  UINT8                           Path[2];
+
+  //
+  // A DMAR structure of length 0 would loop forever.
+  //
+  Table         = BeginTable (EFI_ACPI_4_0_DMA_REMAPPING_TABLE_SIGNATURE, sizeof (EFI_ACPI_DMAR_HEADER));
+  Empty         = Append (Table, NULL, sizeof (*Empty));
+  Empty->Type   = EFI_ACPI_DMAR_TYPE_ATSR;
+  Empty->Length = 0;
+  EndTable (Table);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex), EFI_COMPROMISED_DATA);
+  UT_ASSERT_TRUE (mIndex == NULL);
+
+  //
+  // A device scope running past the end of its DRHD.
+  //
+  Table->Length = sizeof (EFI_ACPI_DMAR_HEADER);
+  Drhd          = AppendDrhd (Table, 0, 0, 0xFED91000);
+  Path[0]       = 0x02;
+  Path[1]       = 0;
+  AppendScope (Table, Drhd, EFI_ACPI_DEVICE_SCOPE_ENTRY_TYPE_PCI_ENDPOINT, 0, Path, 1);
+  Drhd->Header.Length = (UINT16)(Drhd->Header.Length - 1);
+  EndTable (Table);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex), EFI_COMPROMISED_DATA);
+  UT_ASSERT_TRUE (mIndex == NULL);
+
+  //
+  // An IVHD device entry type the parser cannot size. The DMAR is renamed so
+  // it is the IVRS that fails.
+  //
+  Table->Data[0] = 'X';
+  Table          = BeginTable (IVRS_HEADER_SIGNATURE, sizeof (EFI_ACPI_IVRS_HEADER));
+  Ivhd           = AppendIvhd (Table, IVHD_TYPE_10H, 0, 0xFEB00000);
+  AppendIvhdEntry (Table, Ivhd, 0x90, 0, 0);
+  EndTable (Table);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex), EFI_UNSUPPORTED);
+  UT_ASSERT_TRUE (mIndex == NULL);
+
+  //
+  // An IVMD block whose limit would wrap around to the bottom of memory. A
+  // block ending at the very top is fine.
+  //
+  Table->Data[0] = 'X';
+  Table          = BeginTable (IVRS_HEADER_SIGNATURE, sizeof (EFI_ACPI_IVRS_HEADER));
+  AppendIvmd (Table, IVMD_TYPE_20H, 0xFFFFFFFFFFFFF000ULL, 0x1000);
+  EndTable (Table);
+  UT_ASSERT_NOT_EFI_ERROR (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex));
+  UT_ASSERT_EQUAL (mIndex->Regions[0].Limit, MAX_UINT64);
+  AcpiTableIndexFree (mIndex);
+  mIndex = NULL;
+
+  AppendIvmd (Table, IVMD_TYPE_21H, 0xFFFFFFFFFFFFF000ULL, 0x2000);
+  EndTable (Table);
+  UT_ASSERT_STATUS_EQUAL (AcpiTableIndexBuild (&mRsdp, NULL, &mIndex), EFI_COMPROMISED_DATA);
+  UT_ASSERT_TRUE (mIndex == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the ACPI
+  table index and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      IndexTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&IndexTests, Framework, "ACPI Table Index Tests", "DMAProtectionAudit.AcpiTableIndex", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ACPI Table Index Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (IndexTests, "Tables are found by signature and instance", "Tables", TablesFoundBySignature, ResetTables, FreeTables, NULL);
+  AddTestCase (IndexTests, "Thousands of DMAR scopes map to their unit", "DmarScopes", DmarScopesMapToTheirUnit, BuildLargeDmar, FreeTables, NULL);
+  AddTestCase (IndexTests, "RMRRs are sorted and found", "Rmrr", RmrrsSortedAndFound, BuildLargeDmar, FreeTables, NULL);
+  AddTestCase (IndexTests, "Overlapping regions are found", "Overlap", OverlappingRegionsFound, ResetTables, FreeTables, NULL);
+  AddTestCase (IndexTests, "Bridged scopes need a resolver", "Bridged", BridgedScopesNeedResolver, ResetTables, FreeTables, NULL);
+  AddTestCase (IndexTests, "IVRS units, scopes and regions", "Ivrs", IvrsUnitsScopesAndRegions, ResetTables, FreeTables, NULL);
+  AddTestCase (IndexTests, "Malformed tables are rejected", "Malformed", MalformedTablesRejected, ResetTables, FreeTables, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
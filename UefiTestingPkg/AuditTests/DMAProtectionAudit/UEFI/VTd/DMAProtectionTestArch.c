@@ -21,6 +21,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/IoLib.h>
 #include <Library/UnitTestBootLib.h>
 
+#include "../Acpi.h"
 #include "DmaProtection.h"
 
 /// ================================================================================================
@@ -37,16 +38,18 @@ CheckExcludedRegions (
   IN UNIT_TEST_CONTEXT  Context
   )
 {
-  EFI_STATUS             Status;
-  EFI_MEMORY_DESCRIPTOR  *EfiMemoryMap;
-  EFI_MEMORY_DESCRIPTOR  *EfiMemoryMapEnd;
-  EFI_MEMORY_DESCRIPTOR  *EfiMemNext;
-  UINTN                  EfiMemoryMapSize;
-  UINTN                  EfiMapKey;
-  UINTN                  EfiDescriptorSize;
-  UINT32                 EfiDescriptorVersion;
-  RMRRListNode           *Head;
-  RMRRListNode           *Current;
+  EFI_STATUS                        Status;
+  EFI_MEMORY_DESCRIPTOR             *EfiMemoryMap;
+  EFI_MEMORY_DESCRIPTOR             *EfiMemoryMapEnd;
+  EFI_MEMORY_DESCRIPTOR             *EfiMemNext;
+  UINTN                             EfiMemoryMapSize;
+  UINTN                             EfiMapKey;
+  UINTN                             EfiDescriptorSize;
+  UINT32                            EfiDescriptorVersion;
+  ACPI_TABLE_INDEX                  *Index;
+  CONST ACPI_INDEX_RESERVED_REGION  *Region;
+  UINTN                             RegionIndex;
+  UINTN                             RegionCount;
 
   //
   // Step 1: Get DMAR Table
@@ -55,16 +58,23 @@ CheckExcludedRegions (
   UT_ASSERT_NOT_EFI_ERROR (Status);
 
   //
-  // Step 2: Get the RMRR Headers from DMAR Table
+  // Step 2: Get the RMRRs indexed from the DMAR Table
   //
-  Head = GetDmarAcpiTableRmrr ();
-  if (Head == NULL) {
+  Status = GetAcpiTableIndex (GetPciBusDeviceFunction, &Index);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  RegionCount = 0;
+  for (RegionIndex = 0; RegionIndex < Index->RegionCount; RegionIndex++) {
+    if (Index->Regions[RegionIndex].Type == EFI_ACPI_DMAR_TYPE_RMRR) {
+      RegionCount++;
+    }
+  }
+
+  if (RegionCount == 0) {
     UT_LOG_INFO ("No RMRRs Found\n");
     return UNIT_TEST_PASSED;
   }
 
-  Current = Head;
-
   //
   // Step 3: Get the EFI memory map.
   //
@@ -94,39 +104,36 @@ CheckExcludedRegions (
   }
 
   //
-  // Step 4: Step through memory map and verify each
-  //         RMRR memory ranges are marked reserved
+  // Step 4: Verify each RMRR memory range lies in a
+  //         descriptor that is marked reserved
   //
-  EfiMemNext      = EfiMemoryMap;
   EfiMemoryMapEnd = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)EfiMemoryMap + EfiMemoryMapSize);
 
-  while (EfiMemNext < EfiMemoryMapEnd) {
-    // Check if memory range fully encompasses RMRR
-    if (  (EfiMemNext->PhysicalStart <= Current->RMRR->ReservedMemoryRegionBaseAddress)
-       && (EfiMemNext->PhysicalStart + (EFI_PAGE_SIZE * EfiMemNext->NumberOfPages) >= Current->RMRR->ReservedMemoryRegionLimitAddress))
-    {
-      // Verify memory range is marked as reserved
-      UT_ASSERT_EQUAL (EfiMemNext->Type, EfiReservedMemoryType);
-      UT_LOG_INFO ("RMRRs between %X and %X found with type EfiReservedMemoryType\n", Current->RMRR->ReservedMemoryRegionBaseAddress, Current->RMRR->ReservedMemoryRegionLimitAddress);
-
-      // Move on to next RMRR and start search at beginning of memory map again
-      EfiMemNext = EfiMemoryMap;
-      if (Current->Next == NULL) {
-        return UNIT_TEST_PASSED;
+  for (RegionIndex = 0; RegionIndex < Index->RegionCount; RegionIndex++) {
+    Region = &Index->Regions[RegionIndex];
+    if (Region->Type != EFI_ACPI_DMAR_TYPE_RMRR) {
+      continue;
+    }
+
+    // Find the memory range that fully encompasses the RMRR
+    for (EfiMemNext = EfiMemoryMap; EfiMemNext < EfiMemoryMapEnd; EfiMemNext = NEXT_MEMORY_DESCRIPTOR (EfiMemNext, EfiDescriptorSize)) {
+      if (  (EfiMemNext->PhysicalStart <= Region->Base)
+         && ((EfiMemNext->PhysicalStart + EFI_PAGE_SIZE * EfiMemNext->NumberOfPages) >= Region->Limit))
+      {
+        break;
       }
+    }
 
-      Current = Current->Next;
-    } else {
-      // Move on to next descriptor
-      EfiMemNext = NEXT_MEMORY_DESCRIPTOR (EfiMemNext, EfiDescriptorSize);
+    // RMRR Not found in memory map
+    UT_ASSERT_TRUE (EfiMemNext < EfiMemoryMapEnd);
 
-      // RMRR Not found in memory map
-      UT_ASSERT_TRUE (EfiMemNext < EfiMemoryMapEnd);
-    }
+    // Verify memory range is marked as reserved
+    UT_ASSERT_EQUAL (EfiMemNext->Type, EfiReservedMemoryType);
+    UT_LOG_INFO ("RMRRs between %lX and %lX found with type EfiReservedMemoryType\n", Region->Base, Region->Limit);
   }
 
-  // Should never reach here
-  return UNIT_TEST_ERROR_TEST_FAILED;
+  FreePool (EfiMemoryMap);
+  return UNIT_TEST_PASSED;
 } // CheckExcludedRegions()
 
 UNIT_TEST_STATUS
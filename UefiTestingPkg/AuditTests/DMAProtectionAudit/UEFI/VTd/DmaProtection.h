@@ -66,12 +66,6 @@ typedef struct {
   PCI_DEVICE_INFORMATION           PciDeviceInfo;
 } VTD_UNIT_INFORMATION;
 
-// Linked List node used for RMRR Test
-typedef struct RMRRListNode_t_def {
-  EFI_ACPI_DMAR_RMRR_HEADER    *RMRR;
-  struct RMRRListNode_t_def    *Next;
-} RMRRListNode;
-
 /**
   The scan bus callback function.
 
@@ -184,16 +178,6 @@ ParseDmarAcpiTableDrhd (
   VOID
   );
 
-/**
-  Parse DMAR table.
-
-  @return Linked List to all RMRR headers. Caller is required to check for NULL if no RMRRs found.
-**/
-RMRRListNode *
-GetDmarAcpiTableRmrr (
-  VOID
-  );
-
 /**
   Get VTd engine number.
 **/
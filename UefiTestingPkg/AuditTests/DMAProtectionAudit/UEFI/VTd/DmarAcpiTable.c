@@ -174,53 +174,6 @@ ProcessDhrd (
   return EFI_SUCCESS;
 }
 
-/**
-  Parse DMAR table.
-
-  @return Linked List to all RMRR headers. Caller is required to check for NULL if no RMRRs found.
-**/
-RMRRListNode *
-GetDmarAcpiTableRmrr (
-  VOID
-  )
-{
-  EFI_ACPI_DMAR_STRUCTURE_HEADER  *DmarHeader;
-  RMRRListNode                    *Head;
-  RMRRListNode                    *Tail;
-  RMRRListNode                    *NewNode;
-
-  NewNode = NULL;
-  Head    = NULL;
-  Tail    = Head;
-
-  DmarHeader = (EFI_ACPI_DMAR_STRUCTURE_HEADER *)((UINTN)(mAcpiDmarTable + 1));
-  while ((UINTN)DmarHeader < (UINTN)mAcpiDmarTable + mAcpiDmarTable->Header.Length) {
-    switch (DmarHeader->Type) {
-      case EFI_ACPI_DMAR_TYPE_RMRR:
-        // If RMRR found add to end of linked list
-        NewNode       = (RMRRListNode *)AllocateZeroPool (sizeof (RMRRListNode));
-        NewNode->RMRR = (EFI_ACPI_DMAR_RMRR_HEADER *)DmarHeader;
-        NewNode->Next = NULL;
-
-        if (Head == NULL) {
-          Head = NewNode;
-          Tail = NewNode;
-        } else {
-          Tail->Next = NewNode;
-          Tail       = NewNode;
-        }
-
-        break;
-      default:
-        break;
-    }
-
-    DmarHeader = (EFI_ACPI_DMAR_STRUCTURE_HEADER *)((UINTN)DmarHeader + DmarHeader->Length);
-  }
-
-  return Head;
-}
-
 /**
   Get VTd engine number.
 **/
@@ -320,5 +273,17 @@ GetDmarAcpiTable (
   VOID
   )
 {
+  EFI_STATUS        Status;
+  ACPI_TABLE_INDEX  *Index;
+
+  //
+  // Build the index with the bridge walk so scopes behind bridges are indexed
+  // by the device they name.
+  //
+  Status = GetAcpiTableIndex (GetPciBusDeviceFunction, &Index);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
   return GetAcpiTable (EFI_ACPI_4_0_DMA_REMAPPING_TABLE_SIGNATURE, (VOID **)&mAcpiDmarTable);
 }
@@ -212,6 +212,51 @@ GetFlatPageTableData (
   return Status;
 }
 
+/**
+  Range records are not implemented for AArch64, the flat entries are used.
+
+  @retval     EFI_UNSUPPORTED
+
+**/
+EFI_STATUS
+EFIAPI
+GetPageTableRangeData (
+  IN OUT UINTN             *Range1GCount,
+  IN OUT UINTN             *Range2MCount,
+  IN OUT UINTN             *Range4KCount,
+  IN OUT UINTN             *PdeCount,
+  IN OUT UINTN             *GuardCount,
+  OUT PAGE_AUDIT_RANGE     *Range1GEntries,
+  OUT PAGE_AUDIT_RANGE     *Range2MEntries,
+  OUT PAGE_AUDIT_RANGE     *Range4KEntries,
+  OUT UINT64               *PdeEntries,
+  OUT UINT64               *GuardEntries
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
+/**
+  Streaming is not implemented for AArch64, the page tables are collected
+  into buffers with GetFlatPageTableData().
+
+  @retval     EFI_UNSUPPORTED
+
+**/
+EFI_STATUS
+EFIAPI
+StreamPageTableData (
+  IN     BOOLEAN            Merge,
+  IN OUT PAGE_AUDIT_STREAM  *Stream1G,
+  IN OUT PAGE_AUDIT_STREAM  *Stream2M,
+  IN OUT PAGE_AUDIT_STREAM  *Stream4K,
+  IN OUT PAGE_AUDIT_STREAM  *PdeStream,
+  OUT    UINTN              *GuardCount
+  )
+{
+  return EFI_UNSUPPORTED;
+}
+
 /**
   Calculate the maximum physical address bits supported.
 
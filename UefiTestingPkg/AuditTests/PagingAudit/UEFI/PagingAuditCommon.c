@@ -90,6 +90,7 @@ EFI_FILE                          *mFs_Handle;
 extern CHAR8                      *mMemoryInfoDatabaseBuffer;
 extern UINTN                      mMemoryInfoDatabaseSize;
 extern UINTN                      mMemoryInfoDatabaseAllocSize;
+STATIC PAGE_AUDIT_STREAM          mMemoryInfoDatabaseStream;
 
 /**
   Populates the heap guard protocol global
@@ -131,7 +132,9 @@ PopulateCpuMpDebugProtocol (
 
 /**
   This helper function writes a string entry to the memory info database buffer.
-  If string would exceed current buffer allocation, it will realloc.
+  If string would exceed current buffer allocation, it will realloc. While the
+  database is opened with OpenMemoryInfoDatabase(), the string is streamed to
+  its file instead.
 
   NOTE: The buffer tracks its size. It does not work with NULL terminators.
 
@@ -141,6 +144,7 @@ PopulateCpuMpDebugProtocol (
   @retval     EFI_SUCCESS           String was successfully added.
   @retval     EFI_OUT_OF_RESOURCES  Buffer could not be grown to accommodate string.
                                     String has not been added.
+  @retval     Others                Streaming the database to its file failed.
 
 **/
 EFI_STATUS
@@ -163,6 +167,12 @@ AppendToMemoryInfoDatabase (
   NewStringSize = AsciiStrnSizeS (DatabaseString, MEM_INFO_DATABASE_MAX_STRING_SIZE);
   NewStringSize = NewStringSize - sizeof (CHAR8);    // Remove NULL.
 
+  // When streaming, the stream buffer bounds the memory used.
+  if (mMemoryInfoDatabaseStream.FileHandle != NULL) {
+    PageAuditStreamWrite (&mMemoryInfoDatabaseStream, DatabaseString, NewStringSize);
+    return mMemoryInfoDatabaseStream.Status;
+  }
+
   // If we need more space, realloc now.
   // Subtract 1 because we only need a single NULL terminator.
   NewDatabaseSize = NewStringSize + mMemoryInfoDatabaseSize;
@@ -295,6 +305,205 @@ WriteBufferToFile (
   DEBUG ((DEBUG_ERROR, "%a Writing file %s - %r\n", __FUNCTION__, FileNameAndExt, Status));
 }
 
+/**
+  Creates a file on the paging audit volume to be written through a stream.
+
+  @param[out] Stream      The stream to initialize.
+  @param[in]  FileName    Name of the file to create.
+
+  @retval     EFI_SUCCESS           The stream is ready for writing.
+  @retval     EFI_OUT_OF_RESOURCES  The stream buffer could not be allocated.
+  @retval     Others                The file could not be created.
+
+**/
+EFI_STATUS
+EFIAPI
+PageAuditStreamOpen (
+  OUT PAGE_AUDIT_STREAM  *Stream,
+  IN  CONST CHAR16       *FileName
+  )
+{
+  EFI_STATUS  Status;
+
+  ZeroMem (Stream, sizeof (*Stream));
+
+  if (mFs_Handle == NULL) {
+    Status = OpenVolumeSFS (&mFs_Handle);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a error opening sfs volume - %r\n", __FUNCTION__, Status));
+      return Status;
+    }
+  }
+
+  Stream->Buffer = AllocatePool (PAGE_AUDIT_STREAM_BUFFER_SIZE);
+  if (Stream->Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  DEBUG ((DEBUG_ERROR, "%a: Creating file: %s \n", __FUNCTION__, FileName));
+  Status = mFs_Handle->Open (
+                         mFs_Handle,
+                         &Stream->FileHandle,
+                         (CHAR16 *)FileName,
+                         EFI_FILE_MODE_READ | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_CREATE,
+                         0
+                         );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to create file %s: %r !\n", __FUNCTION__, FileName, Status));
+    FreePool (Stream->Buffer);
+    ZeroMem (Stream, sizeof (*Stream));
+  }
+
+  return Status;
+}
+
+/**
+  Writes the buffered bytes of a stream to its file.
+
+  @param[in, out] Stream      The stream to drain.
+
+**/
+STATIC
+VOID
+PageAuditStreamDrain (
+  IN OUT PAGE_AUDIT_STREAM  *Stream
+  )
+{
+  UINTN  WriteSize;
+
+  if ((Stream->Used == 0) || EFI_ERROR (Stream->Status)) {
+    Stream->Used = 0;
+    return;
+  }
+
+  WriteSize      = Stream->Used;
+  Stream->Status = Stream->FileHandle->Write (Stream->FileHandle, &WriteSize, Stream->Buffer);
+  if (!EFI_ERROR (Stream->Status) && (WriteSize != Stream->Used)) {
+    Stream->Status = EFI_VOLUME_FULL;
+  }
+
+  if (EFI_ERROR (Stream->Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to write to file: %r !\n", __FUNCTION__, Stream->Status));
+  }
+
+  Stream->Written += WriteSize;
+  Stream->Used     = 0;
+}
+
+/**
+  Appends data to a stream, writing the buffer to the file each time it fills.
+  After an error all further data is dropped and the error is returned by
+  PageAuditStreamClose().
+
+  @param[in, out] Stream      The stream to write to.
+  @param[in]      Data        The data to append.
+  @param[in]      DataSize    Size of Data in bytes.
+
+**/
+VOID
+EFIAPI
+PageAuditStreamWrite (
+  IN OUT PAGE_AUDIT_STREAM  *Stream,
+  IN     CONST VOID         *Data,
+  IN     UINTN              DataSize
+  )
+{
+  UINTN  CopySize;
+
+  while ((DataSize > 0) && !EFI_ERROR (Stream->Status)) {
+    CopySize = MIN (DataSize, PAGE_AUDIT_STREAM_BUFFER_SIZE - Stream->Used);
+    CopyMem (&Stream->Buffer[Stream->Used], Data, CopySize);
+    Stream->Used += CopySize;
+    Data          = (CONST UINT8 *)Data + CopySize;
+    DataSize     -= CopySize;
+
+    if (Stream->Used == PAGE_AUDIT_STREAM_BUFFER_SIZE) {
+      PageAuditStreamDrain (Stream);
+    }
+  }
+}
+
+/**
+  Writes out whatever is left in the stream buffer, closes the file and frees
+  the buffer. Does nothing for a stream that is not open.
+
+  @param[in, out] Stream      The stream to close.
+
+  @retval     EFI_SUCCESS     All data appended to the stream reached the file.
+  @retval     Others          The first error encountered while writing.
+
+**/
+EFI_STATUS
+EFIAPI
+PageAuditStreamClose (
+  IN OUT PAGE_AUDIT_STREAM  *Stream
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Stream->FileHandle == NULL) {
+    return EFI_SUCCESS;
+  }
+
+  PageAuditStreamDrain (Stream);
+  Stream->FileHandle->Flush (Stream->FileHandle);
+  Stream->FileHandle->Close (Stream->FileHandle);
+  FreePool (Stream->Buffer);
+
+  Status = Stream->Status;
+  DEBUG ((DEBUG_INFO, "%a: Wrote %ld bytes - %r\n", __FUNCTION__, Stream->Written, Status));
+  ZeroMem (Stream, sizeof (*Stream));
+  return Status;
+}
+
+/**
+  Sends all further AppendToMemoryInfoDatabase() strings straight to a file
+  through a bounded buffer instead of growing the database in memory, until
+  FlushAndClearMemoryInfoDatabase() is called. Strings already in the
+  database are written to the file first.
+
+  @param[in]  FileName    Name of the file, without the .dat extension.
+
+  @retval     EFI_SUCCESS           The database now streams to the file.
+  @retval     EFI_ALREADY_STARTED   The database already streams to a file.
+  @retval     Others                The file could not be opened. The database keeps
+                                    growing in memory as before.
+
+**/
+EFI_STATUS
+EFIAPI
+OpenMemoryInfoDatabase (
+  IN CONST CHAR16  *FileName
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      FileNameAndExt[MAX_STRING_SIZE];
+
+  if (mMemoryInfoDatabaseStream.FileHandle != NULL) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  UnicodeSPrint (FileNameAndExt, sizeof (FileNameAndExt), L"%s.dat", FileName);
+  Status = PageAuditStreamOpen (&mMemoryInfoDatabaseStream, FileNameAndExt);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (mMemoryInfoDatabaseSize > 0) {
+    PageAuditStreamWrite (&mMemoryInfoDatabaseStream, mMemoryInfoDatabaseBuffer, mMemoryInfoDatabaseSize);
+  }
+
+  if (mMemoryInfoDatabaseBuffer != NULL) {
+    FreePool (mMemoryInfoDatabaseBuffer);
+    mMemoryInfoDatabaseBuffer = NULL;
+  }
+
+  mMemoryInfoDatabaseAllocSize = 0;
+  mMemoryInfoDatabaseSize      = 0;
+
+  return EFI_SUCCESS;
+}
+
 /**
  * @brief      Writes the MemoryAttributesTable to a file.
  */
@@ -1207,6 +1416,214 @@ LoadFlatPageTableData (
   return !EFI_ERROR (Status);
 }
 
+/**
+  Walks the page tables once, streaming the 1G, 2M, 4K and PDE files and the
+  guard page records straight to the volume. Range records are written when
+  PcdPagingAuditRangeRecords is TRUE.
+
+  @retval   EFI_SUCCESS   The page table files and guard page records were written.
+  @retval   Others        Streaming is not supported or a file could not be written.
+                          The caller should collect the page tables into buffers instead.
+
+**/
+STATIC
+EFI_STATUS
+StreamPageTables (
+  VOID
+  )
+{
+  EFI_STATUS               Status;
+  EFI_STATUS               CloseStatus;
+  CONST CHAR16             *FileNames[] = { L"1G.dat", L"2M.dat", L"4K.dat", L"PDE.dat" };
+  CONST UINT64             PageSizes[]  = { SIZE_1GB, SIZE_2MB, SIZE_4KB };
+  PAGE_AUDIT_STREAM        Streams[ARRAY_SIZE (FileNames)];
+  PAGE_AUDIT_RANGE_HEADER  Header;
+  BOOLEAN                  Merge;
+  UINTN                    GuardCount;
+  UINTN                    Index;
+
+  Merge = FixedPcdGetBool (PcdPagingAuditRangeRecords);
+  ZeroMem (Streams, sizeof (Streams));
+
+  for (Index = 0; Index < ARRAY_SIZE (Streams); Index++) {
+    Status = PageAuditStreamOpen (&Streams[Index], FileNames[Index]);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+  }
+
+  if (Merge) {
+    for (Index = 0; Index < ARRAY_SIZE (PageSizes); Index++) {
+      Header.Signature = PAGE_AUDIT_RANGE_SIGNATURE;
+      Header.Version   = PAGE_AUDIT_RANGE_VERSION;
+      Header.PageSize  = PageSizes[Index];
+      PageAuditStreamWrite (&Streams[Index], &Header, sizeof (Header));
+    }
+  }
+
+  Status = OpenMemoryInfoDatabase (L"GuardPage");
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  Status = StreamPageTableData (Merge, &Streams[0], &Streams[1], &Streams[2], &Streams[3], &GuardCount);
+
+Done:
+  for (Index = 0; Index < ARRAY_SIZE (Streams); Index++) {
+    // Nothing the walk did not produce should reach the files
+    if (EFI_ERROR (Status)) {
+      Streams[Index].Used = 0;
+    }
+
+    CloseStatus = PageAuditStreamClose (&Streams[Index]);
+    if (!EFI_ERROR (Status)) {
+      Status = CloseStatus;
+    }
+  }
+
+  FlushAndClearMemoryInfoDatabase (L"GuardPage");
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Streaming page tables returned - %r, collecting them in memory\n", __FUNCTION__, Status));
+  } else {
+    DEBUG ((DEBUG_INFO, "%a - Page tables streamed, %d guard pages\n", __FUNCTION__, GuardCount));
+  }
+
+  return Status;
+}
+
+/**
+  Walks the page tables into range records and writes the 1G, 2M, 4K and PDE
+  files from them. The guard page addresses are returned to the caller.
+
+  @param[out]   GuardCount      Number of guard page addresses returned.
+  @param[out]   GuardEntries    Guard page addresses, to be freed by the caller.
+
+  @retval   TRUE    The page table files were written.
+  @retval   FALSE   Range records are not supported or could not be collected,
+                    no file was written.
+
+**/
+STATIC
+BOOLEAN
+DumpPageTableRanges (
+  OUT UINTN   *GuardCount,
+  OUT UINT64  **GuardEntries
+  )
+{
+  EFI_STATUS               Status;
+  CONST CHAR16             *FileNames[] = { L"1G.dat", L"2M.dat", L"4K.dat" };
+  CONST UINT64             PageSizes[]  = { SIZE_1GB, SIZE_2MB, SIZE_4KB };
+  PAGE_AUDIT_RANGE_HEADER  *Files[ARRAY_SIZE (FileNames)];
+  UINTN                    RangeCount[ARRAY_SIZE (FileNames)];
+  UINTN                    PdeCount;
+  UINT64                   *PdeEntries;
+  UINTN                    Index;
+  UINTN                    Attempt;
+
+  ZeroMem (Files, sizeof (Files));
+  ZeroMem (RangeCount, sizeof (RangeCount));
+  PdeCount      = 0;
+  PdeEntries    = NULL;
+  *GuardCount   = 0;
+  *GuardEntries = NULL;
+
+  // Run once to get counts.
+  Status = GetPageTableRangeData (&RangeCount[0], &RangeCount[1], &RangeCount[2], &PdeCount, GuardCount, NULL, NULL, NULL, NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - GetPageTableRangeData returned - %r, using flat entries\n", __FUNCTION__, Status));
+    return FALSE;
+  }
+
+  // Allocating the buffers may itself split pages, leave some room and retry once if it was not enough.
+  for (Attempt = 0; Attempt < 2; Attempt++) {
+    Status = EFI_SUCCESS;
+    for (Index = 0; Index < ARRAY_SIZE (Files); Index++) {
+      RangeCount[Index] += 15;
+      Files[Index]       = AllocateZeroPool (sizeof (PAGE_AUDIT_RANGE_HEADER) + RangeCount[Index] * sizeof (PAGE_AUDIT_RANGE));
+      if (Files[Index] == NULL) {
+        Status = EFI_OUT_OF_RESOURCES;
+      }
+    }
+
+    PdeCount      += 15;
+    *GuardCount   += 15;
+    PdeEntries     = AllocateZeroPool (PdeCount * sizeof (UINT64));
+    *GuardEntries  = AllocateZeroPool (*GuardCount * sizeof (UINT64));
+    if ((PdeEntries == NULL) || (*GuardEntries == NULL)) {
+      Status = EFI_OUT_OF_RESOURCES;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      Status = GetPageTableRangeData (
+                 &RangeCount[0],
+                 &RangeCount[1],
+                 &RangeCount[2],
+                 &PdeCount,
+                 GuardCount,
+                 (PAGE_AUDIT_RANGE *)(Files[0] + 1),
+                 (PAGE_AUDIT_RANGE *)(Files[1] + 1),
+                 (PAGE_AUDIT_RANGE *)(Files[2] + 1),
+                 PdeEntries,
+                 *GuardEntries
+                 );
+    }
+
+    if (Status != EFI_BUFFER_TOO_SMALL) {
+      break;
+    }
+
+    for (Index = 0; Index < ARRAY_SIZE (Files); Index++) {
+      FreePool (Files[Index]);
+      Files[Index] = NULL;
+    }
+
+    FreePool (PdeEntries);
+    FreePool (*GuardEntries);
+    PdeEntries    = NULL;
+    *GuardEntries = NULL;
+  }
+
+  if (!EFI_ERROR (Status)) {
+    for (Index = 0; Index < ARRAY_SIZE (Files); Index++) {
+      Files[Index]->Signature = PAGE_AUDIT_RANGE_SIGNATURE;
+      Files[Index]->Version   = PAGE_AUDIT_RANGE_VERSION;
+      Files[Index]->PageSize  = PageSizes[Index];
+      CreateAndWriteFileSFS (
+        mFs_Handle,
+        (CHAR16 *)FileNames[Index],
+        sizeof (PAGE_AUDIT_RANGE_HEADER) + RangeCount[Index] * sizeof (PAGE_AUDIT_RANGE),
+        Files[Index]
+        );
+    }
+
+    CreateAndWriteFileSFS (mFs_Handle, L"PDE.dat", PdeCount * sizeof (UINT64), PdeEntries);
+  }
+
+  for (Index = 0; Index < ARRAY_SIZE (Files); Index++) {
+    if (Files[Index] != NULL) {
+      FreePool (Files[Index]);
+    }
+  }
+
+  if (PdeEntries != NULL) {
+    FreePool (PdeEntries);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Collecting range records failed - %r, using flat entries\n", __FUNCTION__, Status));
+    if (*GuardEntries != NULL) {
+      FreePool (*GuardEntries);
+      *GuardEntries = NULL;
+    }
+
+    *GuardCount = 0;
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 /**
   This helper function will flush the MemoryInfoDatabase to its corresponding
   file and free all resources currently associated with it.
@@ -1222,6 +1639,14 @@ FlushAndClearMemoryInfoDatabase (
   IN CONST CHAR16  *FileName
   )
 {
+  EFI_STATUS  Status;
+
+  // If the database is streaming, its contents are already on their way to the file.
+  if (mMemoryInfoDatabaseStream.FileHandle != NULL) {
+    Status = PageAuditStreamClose (&mMemoryInfoDatabaseStream);
+    DEBUG ((DEBUG_ERROR, "%a Streaming database %s - %r\n", __FUNCTION__, FileName, Status));
+  }
+
   // If we have database contents, flush them to the file.
   if (mMemoryInfoDatabaseSize > 0) {
     WriteBufferToFile (FileName, mMemoryInfoDatabaseBuffer, mMemoryInfoDatabaseSize);
@@ -1400,40 +1825,47 @@ DumpPagingInfo (
     }
   }
 
-  if (LoadFlatPageTableData (
-        &Pte1GCount,
-        &Pte2MCount,
-        &Pte4KCount,
-        &PdeCount,
-        &GuardCount,
-        &Pte1GEntries,
-        &Pte2MEntries,
-        &Pte4KEntries,
-        &PdeEntries,
-        &GuardEntries
-        ))
+  if (!EFI_ERROR (StreamPageTables ())) {
+    DEBUG ((DEBUG_INFO, "%a - Page tables streamed in a single walk\n", __FUNCTION__));
+  } else if (FixedPcdGetBool (PcdPagingAuditRangeRecords) && DumpPageTableRanges (&GuardCount, &GuardEntries)) {
+    DEBUG ((DEBUG_INFO, "%a - Page tables written as range records\n", __FUNCTION__));
+  } else if (LoadFlatPageTableData (
+               &Pte1GCount,
+               &Pte2MCount,
+               &Pte4KCount,
+               &PdeCount,
+               &GuardCount,
+               &Pte1GEntries,
+               &Pte2MEntries,
+               &Pte4KEntries,
+               &PdeEntries,
+               &GuardEntries
+               ))
   {
     CreateAndWriteFileSFS (mFs_Handle, L"1G.dat", Pte1GCount * sizeof (UINT64), Pte1GEntries);
     CreateAndWriteFileSFS (mFs_Handle, L"2M.dat", Pte2MCount * sizeof (UINT64), Pte2MEntries);
     CreateAndWriteFileSFS (mFs_Handle, L"4K.dat", Pte4KCount * sizeof (UINT64), Pte4KEntries);
     CreateAndWriteFileSFS (mFs_Handle, L"PDE.dat", PdeCount * sizeof (UINT64), PdeEntries);
-
-    // Only populate guard pages when function call is successful
-    for (UINT64 i = 0; i < GuardCount; i++) {
-      AsciiSPrint (
-        TempString,
-        MAX_STRING_SIZE,
-        "GuardPage,0x%016lx\n",
-        GuardEntries[i]
-        );
-      AppendToMemoryInfoDatabase (TempString);
-    }
   } else {
     DEBUG ((DEBUG_ERROR, "%a - LoadFlatPageTableData returned with failure, bail from here!\n", __FUNCTION__));
     goto Cleanup;
   }
 
+  // Only populate guard pages when function call is successful
+  for (UINT64 i = 0; i < GuardCount; i++) {
+    AsciiSPrint (
+      TempString,
+      MAX_STRING_SIZE,
+      "GuardPage,0x%016lx\n",
+      GuardEntries[i]
+      );
+    AppendToMemoryInfoDatabase (TempString);
+  }
+
   FlushAndClearMemoryInfoDatabase (L"GuardPage");
+
+  // Keep the memory info database bounded, it grows in memory if the file cannot be opened
+  OpenMemoryInfoDatabase (L"MemoryInfoDatabase");
   DumpProcessorSpecificHandlers ();
   MemoryMapDumpHandler ();
   LoadedImageTableDump ();
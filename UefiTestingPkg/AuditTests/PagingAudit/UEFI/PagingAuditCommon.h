@@ -42,6 +42,39 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define NONE_GCD_MEMORY_TYPE  (EfiGcdMemoryTypeMaximum + 1)
 #define NONE_EFI_MEMORY_TYPE  (EfiMaxMemoryType + 2)
 
+//
+// When PcdPagingAuditRangeRecords is TRUE the 1G, 2M and 4K files hold a
+// PAGE_AUDIT_RANGE_HEADER followed by PAGE_AUDIT_RANGE records instead of
+// one raw entry per page.
+//
+#define PAGE_AUDIT_RANGE_SIGNATURE  SIGNATURE_32 ('P', 'A', 'R', 'G')
+#define PAGE_AUDIT_RANGE_VERSION    1
+
+typedef struct {
+  UINT32    Signature;
+  UINT32    Version;
+  UINT64    PageSize;         // Bytes mapped by each page of the file's ranges
+} PAGE_AUDIT_RANGE_HEADER;
+
+typedef struct {
+  UINT64    Entry;            // Leaf entry mapping the first page of the range
+  UINT64    PageCount;        // Contiguous pages mapped with the same attributes
+} PAGE_AUDIT_RANGE;
+
+#define PAGE_AUDIT_STREAM_BUFFER_SIZE  SIZE_64KB
+
+//
+// A file written through a fixed size buffer, so that output of any length
+// only keeps PAGE_AUDIT_STREAM_BUFFER_SIZE bytes in memory.
+//
+typedef struct {
+  EFI_FILE      *FileHandle;
+  UINT8         *Buffer;
+  UINTN         Used;             // Bytes in Buffer not yet written to the file
+  UINT64        Written;          // Bytes written to the file so far
+  EFI_STATUS    Status;           // First error encountered, later data is dropped
+} PAGE_AUDIT_STREAM;
+
 /**
   Calculate the maximum support address.
 
@@ -54,7 +87,9 @@ CalculateMaximumSupportAddress (
 
 /**
   This helper function writes a string entry to the memory info database buffer.
-  If string would exceed current buffer allocation, it will realloc.
+  If string would exceed current buffer allocation, it will realloc. While the
+  database is opened with OpenMemoryInfoDatabase(), the string is streamed to
+  its file instead.
 
   NOTE: The buffer tracks its size. It does not work with NULL terminators.
 
@@ -64,6 +99,7 @@ CalculateMaximumSupportAddress (
   @retval     EFI_SUCCESS           String was successfully added.
   @retval     EFI_OUT_OF_RESOURCES  Buffer could not be grown to accommodate string.
                                     String has not been added.
+  @retval     Others                Streaming the database to its file failed.
 
 **/
 EFI_STATUS
@@ -72,6 +108,78 @@ AppendToMemoryInfoDatabase (
   IN CONST CHAR8  *DatabaseString
   );
 
+/**
+  Sends all further AppendToMemoryInfoDatabase() strings straight to a file
+  through a bounded buffer instead of growing the database in memory, until
+  FlushAndClearMemoryInfoDatabase() is called. Strings already in the
+  database are written to the file first.
+
+  @param[in]  FileName    Name of the file, without the .dat extension.
+
+  @retval     EFI_SUCCESS           The database now streams to the file.
+  @retval     EFI_ALREADY_STARTED   The database already streams to a file.
+  @retval     Others                The file could not be opened. The database keeps
+                                    growing in memory as before.
+
+**/
+EFI_STATUS
+EFIAPI
+OpenMemoryInfoDatabase (
+  IN CONST CHAR16  *FileName
+  );
+
+/**
+  Creates a file on the paging audit volume to be written through a stream.
+
+  @param[out] Stream      The stream to initialize.
+  @param[in]  FileName    Name of the file to create.
+
+  @retval     EFI_SUCCESS           The stream is ready for writing.
+  @retval     EFI_OUT_OF_RESOURCES  The stream buffer could not be allocated.
+  @retval     Others                The file could not be created.
+
+**/
+EFI_STATUS
+EFIAPI
+PageAuditStreamOpen (
+  OUT PAGE_AUDIT_STREAM  *Stream,
+  IN  CONST CHAR16       *FileName
+  );
+
+/**
+  Appends data to a stream, writing the buffer to the file each time it fills.
+  After an error all further data is dropped and the error is returned by
+  PageAuditStreamClose().
+
+  @param[in, out] Stream      The stream to write to.
+  @param[in]      Data        The data to append.
+  @param[in]      DataSize    Size of Data in bytes.
+
+**/
+VOID
+EFIAPI
+PageAuditStreamWrite (
+  IN OUT PAGE_AUDIT_STREAM  *Stream,
+  IN     CONST VOID         *Data,
+  IN     UINTN              DataSize
+  );
+
+/**
+  Writes out whatever is left in the stream buffer, closes the file and frees
+  the buffer. Does nothing for a stream that is not open.
+
+  @param[in, out] Stream      The stream to close.
+
+  @retval     EFI_SUCCESS     All data appended to the stream reached the file.
+  @retval     Others          The first error encountered while writing.
+
+**/
+EFI_STATUS
+EFIAPI
+PageAuditStreamClose (
+  IN OUT PAGE_AUDIT_STREAM  *Stream
+  );
+
 /**
    Dump platform specific handler. Created handler(s) need to be compliant with
    Windows\PagingReportGenerator.py, i.e. TSEG.
@@ -186,6 +294,73 @@ GetFlatPageTableData (
   OUT UINT64    *GuardEntries
   );
 
+/**
+  This helper function walks the page tables like GetFlatPageTableData(), but
+  merges virtually and physically contiguous leaf entries with identical
+  attributes into ranges as they are encountered.
+
+  @param[in, out]   Range1GCount, Range2MCount, Range4KCount, PdeCount, GuardCount
+      On input, the number of records that can fit in the corresponding buffer (if provided).
+      It is expected that this will be zero if the corresponding buffer is NULL.
+      On output, the number of records that were produced from the page table.
+  @param[out]       Range1GEntries, Range2MEntries, Range4KEntries, PdeEntries, GuardEntries
+      A buffer which will be filled with the ranges and addresses encountered in the tables.
+
+  @retval     EFI_SUCCESS             All requested data has been returned.
+  @retval     EFI_INVALID_PARAMETER   One or more of the count parameter pointers is NULL.
+  @retval     EFI_INVALID_PARAMETER   Presence of buffer counts and pointers is incongruent.
+  @retval     EFI_BUFFER_TOO_SMALL    One or more of the buffers was insufficient to hold
+                                      all of the records. The counts have been updated
+                                      with the total number of records produced.
+  @retval     EFI_UNSUPPORTED         Range records are not implemented for this architecture.
+
+**/
+EFI_STATUS
+EFIAPI
+GetPageTableRangeData (
+  IN OUT UINTN             *Range1GCount,
+  IN OUT UINTN             *Range2MCount,
+  IN OUT UINTN             *Range4KCount,
+  IN OUT UINTN             *PdeCount,
+  IN OUT UINTN             *GuardCount,
+  OUT PAGE_AUDIT_RANGE     *Range1GEntries,
+  OUT PAGE_AUDIT_RANGE     *Range2MEntries,
+  OUT PAGE_AUDIT_RANGE     *Range4KEntries,
+  OUT UINT64               *PdeEntries,
+  OUT UINT64               *GuardEntries
+  );
+
+/**
+  This helper function walks the page tables once and writes every entry to
+  the corresponding stream as it is encountered, so no buffer sized by the page
+  tables is needed. Guard page addresses are added to the memory info database.
+
+  @param[in]        Merge
+      TRUE to write the 1G, 2M and 4K entries as PAGE_AUDIT_RANGE records like
+      GetPageTableRangeData(), FALSE to write one raw entry per page like
+      GetFlatPageTableData(). The caller writes any PAGE_AUDIT_RANGE_HEADER.
+  @param[in, out]   Stream1G, Stream2M, Stream4K, PdeStream
+      The streams receiving each kind of value.
+  @param[out]       GuardCount
+      The number of guard pages added to the memory info database.
+
+  @retval     EFI_SUCCESS             The page tables were walked. Write errors are
+                                      reported when the streams are closed.
+  @retval     EFI_INVALID_PARAMETER   One of the parameters is NULL.
+  @retval     EFI_UNSUPPORTED         Streaming is not implemented for this architecture.
+
+**/
+EFI_STATUS
+EFIAPI
+StreamPageTableData (
+  IN     BOOLEAN            Merge,
+  IN OUT PAGE_AUDIT_STREAM  *Stream1G,
+  IN OUT PAGE_AUDIT_STREAM  *Stream2M,
+  IN OUT PAGE_AUDIT_STREAM  *Stream4K,
+  IN OUT PAGE_AUDIT_STREAM  *PdeStream,
+  OUT    UINTN              *GuardCount
+  );
+
 /**
 This helper function will flush the MemoryInfoDatabase to its corresponding
 file and free all resources currently associated with it.
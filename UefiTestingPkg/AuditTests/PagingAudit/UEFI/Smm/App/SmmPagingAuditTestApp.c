@@ -575,6 +575,8 @@ SmmPagingAuditTestAppEntryPoint (
   IN     EFI_SYSTEM_TABLE  *SystemTable
   )
 {
+  // Keep the memory info database bounded, it grows in memory if the file cannot be opened
+  OpenMemoryInfoDatabase (L"MemoryInfoDatabase");
   DumpProcessorSpecificHandlers ();
   MemoryMapDumpHandler ();
   LoadedImageTableDump ();
@@ -582,6 +584,7 @@ SmmPagingAuditTestAppEntryPoint (
 
   if (EFI_ERROR (LocateSmmCommonCommBuffer ())) {
     DEBUG ((DEBUG_ERROR, "%a Comm buffer setup failed\n", __FUNCTION__));
+    FlushAndClearMemoryInfoDatabase (L"MemoryInfoDatabase");
     return EFI_ABORTED;
   }
 
@@ -509,45 +509,146 @@ TSEGDumpHandler (
   return EFI_SUCCESS;
 }
 
+//
+// Accessed and Dirty are status bits set by the CPU, they do not split a range.
+//
+#define PAGE_AUDIT_STATUS_BITS  (BIT5 | BIT6)
+
+//
+// Collects one kind of value as the page tables are walked: the leaf entries of
+// one page size, the page directory addresses or the guard page addresses.
+//
+typedef struct {
+  BOOLEAN              Merge;      // Merge contiguous leaf entries into ranges
+  UINTN                Count;      // Values (or ranges) encountered so far
+  UINTN                Emitted;    // Values (or finished ranges) handed to the output
+  UINTN                Capacity;   // Values (or ranges) that fit in the buffer
+  UINT64               *Entries;   // Buffer when not merging, may be NULL
+  PAGE_AUDIT_RANGE     *Ranges;    // Buffer when merging, may be NULL
+  PAGE_AUDIT_STREAM    *Stream;    // Written to instead of the buffer when not NULL
+  CONST CHAR8          *Format;    // Values are printed into the memory info database when not NULL
+  UINT64               PageSize;   // Bytes mapped by one leaf entry when merging
+  UINT64               NextVa;     // Address and entry that would extend the last range
+  UINT64               NextEntry;
+  PAGE_AUDIT_RANGE     Last;       // Range being extended when merging
+} PAGE_AUDIT_SINK;
+
 /**
-  This helper function walks the page tables to retrieve:
-  - a count of each entry
-  - a count of each directory entry
-  - [optional] a flat list of each entry
-  - [optional] a flat list of each directory entry
+  Hands a value, or a finished range when merging, to the output of a sink.
 
-  @param[in, out]   Pte1GCount, Pte2MCount, Pte4KCount, PdeCount
-      On input, the number of entries that can fit in the corresponding buffer (if provided).
-      It is expected that this will be zero if the corresponding buffer is NULL.
-      On output, the number of entries that were encountered in the page table.
-  @param[out]       Pte1GEntries, Pte2MEntries, Pte4KEntries, PdeEntries
-      A buffer which will be filled with the entries that are encountered in the tables.
+  @param[in, out] Sink    The sink to output from.
+  @param[in]      Data    The UINT64 value or PAGE_AUDIT_RANGE to output.
 
-  @retval     EFI_SUCCESS             All requested data has been returned.
-  @retval     EFI_INVALID_PARAMETER   One or more of the count parameter pointers is NULL.
-  @retval     EFI_INVALID_PARAMETER   Presence of buffer counts and pointers is incongruent.
-  @retval     EFI_BUFFER_TOO_SMALL    One or more of the buffers was insufficient to hold
-                                      all of the entries in the page tables. The counts
-                                      have been updated with the total number of entries
-                                      encountered.
+**/
+STATIC
+VOID
+PageAuditSinkEmit (
+  IN OUT PAGE_AUDIT_SINK  *Sink,
+  IN     CONST VOID       *Data
+  )
+{
+  CHAR8  TempString[MAX_STRING_SIZE];
+
+  if (Sink->Stream != NULL) {
+    PageAuditStreamWrite (Sink->Stream, Data, Sink->Merge ? sizeof (PAGE_AUDIT_RANGE) : sizeof (UINT64));
+  } else if (Sink->Format != NULL) {
+    AsciiSPrint (TempString, MAX_STRING_SIZE, Sink->Format, *(CONST UINT64 *)Data);
+    AppendToMemoryInfoDatabase (TempString);
+  } else if (Sink->Emitted < Sink->Capacity) {
+    if (Sink->Merge) {
+      CopyMem (&Sink->Ranges[Sink->Emitted], Data, sizeof (PAGE_AUDIT_RANGE));
+    } else {
+      Sink->Entries[Sink->Emitted] = *(CONST UINT64 *)Data;
+    }
+  }
+
+  Sink->Emitted++;
+}
+
+/**
+  Adds a value to a sink. When merging, an entry that maps the page virtually
+  and physically following the last range, with the same attributes, grows that
+  range instead of starting a new one.
+
+  @param[in, out] Sink    The sink to add the value to.
+  @param[in]      Va      Virtual address mapped by the entry, only used when merging.
+  @param[in]      Value   The entry or address to add.
 
 **/
-EFI_STATUS
-EFIAPI
-GetFlatPageTableData (
-  IN OUT UINTN  *Pte1GCount,
-  IN OUT UINTN  *Pte2MCount,
-  IN OUT UINTN  *Pte4KCount,
-  IN OUT UINTN  *PdeCount,
-  IN OUT UINTN  *GuardCount,
-  OUT UINT64    *Pte1GEntries,
-  OUT UINT64    *Pte2MEntries,
-  OUT UINT64    *Pte4KEntries,
-  OUT UINT64    *PdeEntries,
-  OUT UINT64    *GuardEntries
+STATIC
+VOID
+PageAuditSinkAdd (
+  IN OUT PAGE_AUDIT_SINK  *Sink,
+  IN     UINT64           Va,
+  IN     UINT64           Value
+  )
+{
+  UINT64  Key;
+
+  if (!Sink->Merge) {
+    Sink->Count++;
+    PageAuditSinkEmit (Sink, &Value);
+    return;
+  }
+
+  // Empty entries are skipped by the parser, so they are left out of the ranges
+  if (Value == 0) {
+    return;
+  }
+
+  Key = Value & ~(UINT64)PAGE_AUDIT_STATUS_BITS;
+  if ((Sink->Count > 0) && (Va == Sink->NextVa) && (Key == Sink->NextEntry)) {
+    Sink->Last.PageCount++;
+  } else {
+    if (Sink->Count > 0) {
+      PageAuditSinkEmit (Sink, &Sink->Last);
+    }
+
+    Sink->Count++;
+    Sink->Last.Entry     = Value;
+    Sink->Last.PageCount = 1;
+  }
+
+  // The page frame number starts at bit log2(PageSize) for every leaf size
+  Sink->NextVa    = Va + Sink->PageSize;
+  Sink->NextEntry = Key + Sink->PageSize;
+}
+
+/**
+  Outputs the range a merging sink is still extending.
+
+  @param[in, out] Sink    The sink to finish.
+
+**/
+STATIC
+VOID
+PageAuditSinkFinish (
+  IN OUT PAGE_AUDIT_SINK  *Sink
+  )
+{
+  if (Sink->Merge && (Sink->Count > Sink->Emitted)) {
+    PageAuditSinkEmit (Sink, &Sink->Last);
+  }
+}
+
+/**
+  Walks the page tables once, handing every leaf entry, page directory and
+  guard page to the corresponding sink.
+
+  @param[in, out]   Sink1G, Sink2M, Sink4K, PdeSink, GuardSink
+      The sinks collecting each kind of value.
+
+**/
+STATIC
+VOID
+WalkPageTables (
+  IN OUT PAGE_AUDIT_SINK  *Sink1G,
+  IN OUT PAGE_AUDIT_SINK  *Sink2M,
+  IN OUT PAGE_AUDIT_SINK  *Sink4K,
+  IN OUT PAGE_AUDIT_SINK  *PdeSink,
+  IN OUT PAGE_AUDIT_SINK  *GuardSink
   )
 {
-  EFI_STATUS                      Status = EFI_SUCCESS;
   PAGE_MAP_AND_DIRECTORY_POINTER  *Work;
   PAGE_MAP_AND_DIRECTORY_POINTER  *Pml4;
   PAGE_TABLE_1G_ENTRY             *Pte1G;
@@ -557,43 +658,13 @@ GetFlatPageTableData (
   UINTN                           Index2;
   UINTN                           Index3;
   UINTN                           Index4;
-  UINTN                           MyGuardCount        = 0;
-  UINTN                           MyPdeCount          = 0;
-  UINTN                           My4KCount           = 0;
-  UINTN                           My2MCount           = 0;
-  UINTN                           My1GCount           = 0;
   UINTN                           NumPage4KNotPresent = 0;
   UINTN                           NumPage2MNotPresent = 0;
   UINTN                           NumPage1GNotPresent = 0;
   UINT64                          Address;
 
-  //
-  // First, fail fast if some of the parameters don't look right.
-  //
-  // ALL count parameters should be provided.
-  if ((Pte1GCount == NULL) || (Pte2MCount == NULL) || (Pte4KCount == NULL) || (PdeCount == NULL) || (GuardCount == NULL)) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  // If a count is greater than 0, the corresponding buffer pointer MUST be provided.
-  // It will be assumed that all buffers have space for any corresponding count.
-  if (((*Pte1GCount > 0) && (Pte1GEntries == NULL)) || ((*Pte2MCount > 0) && (Pte2MEntries == NULL)) ||
-      ((*Pte4KCount > 0) && (Pte4KEntries == NULL)) || ((*PdeCount > 0) && (PdeEntries == NULL)) ||
-      ((*GuardCount > 0) && (GuardEntries == NULL)))
-  {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  //
-  // Alright, let's get to work.
-  //
   Pml4 = (PAGE_MAP_AND_DIRECTORY_POINTER *)AsmReadCr3 ();
-  // Increase the count.
-  // If we have room for more PDE Entries, add one.
-  MyPdeCount++;
-  if (MyPdeCount <= *PdeCount) {
-    PdeEntries[MyPdeCount-1] = (UINT64)(UINTN)Pml4;
-  }
+  PageAuditSinkAdd (PdeSink, 0, (UINT64)(UINTN)Pml4);
 
   for (Index4 = 0x0; Index4 < 0x200; Index4++) {
     if (!Pml4[Index4].Bits.Present) {
@@ -601,12 +672,7 @@ GetFlatPageTableData (
     }
 
     Pte1G = (PAGE_TABLE_1G_ENTRY *)(UINTN)(Pml4[Index4].Bits.PageTableBaseAddress << 12);
-    // Increase the count.
-    // If we have room for more PDE Entries, add one.
-    MyPdeCount++;
-    if (MyPdeCount <= *PdeCount) {
-      PdeEntries[MyPdeCount-1] = (UINT64)(UINTN)Pte1G;
-    }
+    PageAuditSinkAdd (PdeSink, 0, (UINT64)(UINTN)Pte1G);
 
     for (Index3 = 0x0; Index3 < 0x200; Index3++ ) {
       if (!Pte1G[Index3].Bits.Present) {
@@ -625,12 +691,7 @@ GetFlatPageTableData (
         //
         Work  = (PAGE_MAP_AND_DIRECTORY_POINTER *)Pte1G;
         Pte2M = (PAGE_TABLE_ENTRY *)(UINTN)(Work[Index3].Bits.PageTableBaseAddress << 12);
-        // Increase the count.
-        // If we have room for more PDE Entries, add one.
-        MyPdeCount++;
-        if (MyPdeCount <= *PdeCount) {
-          PdeEntries[MyPdeCount-1] = (UINT64)(UINTN)Pte2M;
-        }
+        PageAuditSinkAdd (PdeSink, 0, (UINT64)(UINTN)Pte2M);
 
         for (Index2 = 0x0; Index2 < 0x200; Index2++ ) {
           if (!Pte2M[Index2].Bits.Present) {
@@ -641,67 +702,131 @@ GetFlatPageTableData (
           if (!(Pte2M[Index2].Bits.MustBe1)) {
             Work  = (PAGE_MAP_AND_DIRECTORY_POINTER *)Pte2M;
             Pte4K = (PAGE_TABLE_4K_ENTRY *)(UINTN)(Work[Index2].Bits.PageTableBaseAddress << 12);
-            // Increase the count.
-            // If we have room for more PDE Entries, add one.
-            MyPdeCount++;
-            if (MyPdeCount <= *PdeCount) {
-              PdeEntries[MyPdeCount-1] = (UINT64)(UINTN)Pte4K;
-            }
+            PageAuditSinkAdd (PdeSink, 0, (UINT64)(UINTN)Pte4K);
 
             for (Index1 = 0x0; Index1 < 0x200; Index1++ ) {
+              Address = IndexToAddress (Index4, Index3, Index2, Index1);
               if (!Pte4K[Index1].Bits.Present) {
                 NumPage4KNotPresent++;
-                Address = IndexToAddress (Index4, Index3, Index2, Index1);
                 if ((mMemoryProtectionProtocol != NULL) && (mMemoryProtectionProtocol->IsGuardPage (Address))) {
-                  MyGuardCount++;
-                  if (MyGuardCount <= *GuardCount) {
-                    GuardEntries[MyGuardCount - 1] = Address;
-                  }
-
+                  PageAuditSinkAdd (GuardSink, 0, Address);
                   continue;
                 }
               }
 
-              // Increase the count.
-              // If we have room for more Page Table entries, add one.
-              My4KCount++;
-              if (My4KCount <= *Pte4KCount) {
-                Pte4KEntries[My4KCount-1] = Pte4K[Index1].Uint64;
-              }
+              PageAuditSinkAdd (Sink4K, Address, Pte4K[Index1].Uint64);
             }
           } else {
-            // Increase the count.
-            // If we have room for more Page Table entries, add one.
-            My2MCount++;
-            if (My2MCount <= *Pte2MCount) {
-              Pte2MEntries[My2MCount-1] = Pte2M[Index2].Uint64;
-            }
+            PageAuditSinkAdd (Sink2M, IndexToAddress (Index4, Index3, Index2, 0), Pte2M[Index2].Uint64);
           }
         }
       } else {
-        // Increase the count.
-        // If we have room for more Page Table entries, add one.
-        My1GCount++;
-        if (My1GCount <= *Pte1GCount) {
-          Pte1GEntries[My1GCount-1] = Pte1G[Index3].Uint64;
-        }
+        PageAuditSinkAdd (Sink1G, IndexToAddress (Index4, Index3, 0, 0), Pte1G[Index3].Uint64);
       }
     }
   }
 
-  DEBUG ((DEBUG_ERROR, "Pages used for Page Tables   = %d\n", MyPdeCount));
-  DEBUG ((DEBUG_ERROR, "Number of   4K Pages active  = %d - NotPresent = %d\n", My4KCount, NumPage4KNotPresent));
-  DEBUG ((DEBUG_ERROR, "Number of   2M Pages active  = %d - NotPresent = %d\n", My2MCount, NumPage2MNotPresent));
-  DEBUG ((DEBUG_ERROR, "Number of   1G Pages active  = %d - NotPresent = %d\n", My1GCount, NumPage1GNotPresent));
-  DEBUG ((DEBUG_ERROR, "Number of   Guard Pages active  = %d\n", MyGuardCount));
+  PageAuditSinkFinish (Sink1G);
+  PageAuditSinkFinish (Sink2M);
+  PageAuditSinkFinish (Sink4K);
+
+  DEBUG ((DEBUG_ERROR, "Pages used for Page Tables   = %d\n", PdeSink->Count));
+  DEBUG ((DEBUG_ERROR, "Number of   4K %a active  = %d - NotPresent = %d\n", Sink4K->Merge ? "Ranges" : "Pages", Sink4K->Count, NumPage4KNotPresent));
+  DEBUG ((DEBUG_ERROR, "Number of   2M %a active  = %d - NotPresent = %d\n", Sink2M->Merge ? "Ranges" : "Pages", Sink2M->Count, NumPage2MNotPresent));
+  DEBUG ((DEBUG_ERROR, "Number of   1G %a active  = %d - NotPresent = %d\n", Sink1G->Merge ? "Ranges" : "Pages", Sink1G->Count, NumPage1GNotPresent));
+  DEBUG ((DEBUG_ERROR, "Number of   Guard Pages active  = %d\n", GuardSink->Count));
+}
+
+/**
+  This helper function walks the page tables to retrieve:
+  - a count of each entry
+  - a count of each directory entry
+  - [optional] a flat list of each entry
+  - [optional] a flat list of each directory entry
+
+  @param[in, out]   Pte1GCount, Pte2MCount, Pte4KCount, PdeCount
+      On input, the number of entries that can fit in the corresponding buffer (if provided).
+      It is expected that this will be zero if the corresponding buffer is NULL.
+      On output, the number of entries that were encountered in the page table.
+  @param[out]       Pte1GEntries, Pte2MEntries, Pte4KEntries, PdeEntries
+      A buffer which will be filled with the entries that are encountered in the tables.
+
+  @retval     EFI_SUCCESS             All requested data has been returned.
+  @retval     EFI_INVALID_PARAMETER   One or more of the count parameter pointers is NULL.
+  @retval     EFI_INVALID_PARAMETER   Presence of buffer counts and pointers is incongruent.
+  @retval     EFI_BUFFER_TOO_SMALL    One or more of the buffers was insufficient to hold
+                                      all of the entries in the page tables. The counts
+                                      have been updated with the total number of entries
+                                      encountered.
+
+**/
+EFI_STATUS
+EFIAPI
+GetFlatPageTableData (
+  IN OUT UINTN  *Pte1GCount,
+  IN OUT UINTN  *Pte2MCount,
+  IN OUT UINTN  *Pte4KCount,
+  IN OUT UINTN  *PdeCount,
+  IN OUT UINTN  *GuardCount,
+  OUT UINT64    *Pte1GEntries,
+  OUT UINT64    *Pte2MEntries,
+  OUT UINT64    *Pte4KEntries,
+  OUT UINT64    *PdeEntries,
+  OUT UINT64    *GuardEntries
+  )
+{
+  EFI_STATUS       Status = EFI_SUCCESS;
+  PAGE_AUDIT_SINK  Sink1G;
+  PAGE_AUDIT_SINK  Sink2M;
+  PAGE_AUDIT_SINK  Sink4K;
+  PAGE_AUDIT_SINK  PdeSink;
+  PAGE_AUDIT_SINK  GuardSink;
+
+  //
+  // First, fail fast if some of the parameters don't look right.
+  //
+  // ALL count parameters should be provided.
+  if ((Pte1GCount == NULL) || (Pte2MCount == NULL) || (Pte4KCount == NULL) || (PdeCount == NULL) || (GuardCount == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // If a count is greater than 0, the corresponding buffer pointer MUST be provided.
+  // It will be assumed that all buffers have space for any corresponding count.
+  if (((*Pte1GCount > 0) && (Pte1GEntries == NULL)) || ((*Pte2MCount > 0) && (Pte2MEntries == NULL)) ||
+      ((*Pte4KCount > 0) && (Pte4KEntries == NULL)) || ((*PdeCount > 0) && (PdeEntries == NULL)) ||
+      ((*GuardCount > 0) && (GuardEntries == NULL)))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Alright, let's get to work.
+  //
+  ZeroMem (&Sink1G, sizeof (Sink1G));
+  ZeroMem (&Sink2M, sizeof (Sink2M));
+  ZeroMem (&Sink4K, sizeof (Sink4K));
+  ZeroMem (&PdeSink, sizeof (PdeSink));
+  ZeroMem (&GuardSink, sizeof (GuardSink));
+  Sink1G.Capacity    = *Pte1GCount;
+  Sink1G.Entries     = Pte1GEntries;
+  Sink2M.Capacity    = *Pte2MCount;
+  Sink2M.Entries     = Pte2MEntries;
+  Sink4K.Capacity    = *Pte4KCount;
+  Sink4K.Entries     = Pte4KEntries;
+  PdeSink.Capacity   = *PdeCount;
+  PdeSink.Entries    = PdeEntries;
+  GuardSink.Capacity = *GuardCount;
+  GuardSink.Entries  = GuardEntries;
+
+  WalkPageTables (&Sink1G, &Sink2M, &Sink4K, &PdeSink, &GuardSink);
 
   //
   // determine whether any of the buffers were too small.
   // Only matters if a given buffer was provided.
   //
-  if (((Pte1GEntries != NULL) && (*Pte1GCount < My1GCount)) || ((Pte2MEntries != NULL) && (*Pte2MCount < My2MCount)) ||
-      ((Pte4KEntries != NULL) && (*Pte4KCount < My4KCount)) || ((PdeEntries != NULL) && (*PdeCount < MyPdeCount)) ||
-      ((GuardEntries != NULL) && (*GuardCount < MyGuardCount)))
+  if (((Pte1GEntries != NULL) && (*Pte1GCount < Sink1G.Count)) || ((Pte2MEntries != NULL) && (*Pte2MCount < Sink2M.Count)) ||
+      ((Pte4KEntries != NULL) && (*Pte4KCount < Sink4K.Count)) || ((PdeEntries != NULL) && (*PdeCount < PdeSink.Count)) ||
+      ((GuardEntries != NULL) && (*GuardCount < GuardSink.Count)))
   {
     Status = EFI_BUFFER_TOO_SMALL;
   }
@@ -709,15 +834,172 @@ GetFlatPageTableData (
   //
   // Update all the return pointers.
   //
-  *Pte1GCount = My1GCount;
-  *Pte2MCount = My2MCount;
-  *Pte4KCount = My4KCount;
-  *PdeCount   = MyPdeCount;
-  *GuardCount = MyGuardCount;
+  *Pte1GCount = Sink1G.Count;
+  *Pte2MCount = Sink2M.Count;
+  *Pte4KCount = Sink4K.Count;
+  *PdeCount   = PdeSink.Count;
+  *GuardCount = GuardSink.Count;
 
   return Status;
 } // GetFlatPageTableData()
 
+/**
+  This helper function walks the page tables like GetFlatPageTableData(), but
+  merges virtually and physically contiguous leaf entries with identical
+  attributes into ranges as they are encountered.
+
+  @param[in, out]   Range1GCount, Range2MCount, Range4KCount, PdeCount, GuardCount
+      On input, the number of records that can fit in the corresponding buffer (if provided).
+      It is expected that this will be zero if the corresponding buffer is NULL.
+      On output, the number of records that were produced from the page table.
+  @param[out]       Range1GEntries, Range2MEntries, Range4KEntries, PdeEntries, GuardEntries
+      A buffer which will be filled with the ranges and addresses encountered in the tables.
+
+  @retval     EFI_SUCCESS             All requested data has been returned.
+  @retval     EFI_INVALID_PARAMETER   One or more of the count parameter pointers is NULL.
+  @retval     EFI_INVALID_PARAMETER   Presence of buffer counts and pointers is incongruent.
+  @retval     EFI_BUFFER_TOO_SMALL    One or more of the buffers was insufficient to hold
+                                      all of the records. The counts have been updated
+                                      with the total number of records produced.
+
+**/
+EFI_STATUS
+EFIAPI
+GetPageTableRangeData (
+  IN OUT UINTN             *Range1GCount,
+  IN OUT UINTN             *Range2MCount,
+  IN OUT UINTN             *Range4KCount,
+  IN OUT UINTN             *PdeCount,
+  IN OUT UINTN             *GuardCount,
+  OUT PAGE_AUDIT_RANGE     *Range1GEntries,
+  OUT PAGE_AUDIT_RANGE     *Range2MEntries,
+  OUT PAGE_AUDIT_RANGE     *Range4KEntries,
+  OUT UINT64               *PdeEntries,
+  OUT UINT64               *GuardEntries
+  )
+{
+  EFI_STATUS       Status = EFI_SUCCESS;
+  PAGE_AUDIT_SINK  Sink1G;
+  PAGE_AUDIT_SINK  Sink2M;
+  PAGE_AUDIT_SINK  Sink4K;
+  PAGE_AUDIT_SINK  PdeSink;
+  PAGE_AUDIT_SINK  GuardSink;
+
+  if ((Range1GCount == NULL) || (Range2MCount == NULL) || (Range4KCount == NULL) || (PdeCount == NULL) || (GuardCount == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (((*Range1GCount > 0) && (Range1GEntries == NULL)) || ((*Range2MCount > 0) && (Range2MEntries == NULL)) ||
+      ((*Range4KCount > 0) && (Range4KEntries == NULL)) || ((*PdeCount > 0) && (PdeEntries == NULL)) ||
+      ((*GuardCount > 0) && (GuardEntries == NULL)))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (&Sink1G, sizeof (Sink1G));
+  ZeroMem (&Sink2M, sizeof (Sink2M));
+  ZeroMem (&Sink4K, sizeof (Sink4K));
+  ZeroMem (&PdeSink, sizeof (PdeSink));
+  ZeroMem (&GuardSink, sizeof (GuardSink));
+  Sink1G.Merge       = TRUE;
+  Sink1G.Capacity    = *Range1GCount;
+  Sink1G.Ranges      = Range1GEntries;
+  Sink1G.PageSize    = SIZE_1GB;
+  Sink2M.Merge       = TRUE;
+  Sink2M.Capacity    = *Range2MCount;
+  Sink2M.Ranges      = Range2MEntries;
+  Sink2M.PageSize    = SIZE_2MB;
+  Sink4K.Merge       = TRUE;
+  Sink4K.Capacity    = *Range4KCount;
+  Sink4K.Ranges      = Range4KEntries;
+  Sink4K.PageSize    = SIZE_4KB;
+  PdeSink.Capacity   = *PdeCount;
+  PdeSink.Entries    = PdeEntries;
+  GuardSink.Capacity = *GuardCount;
+  GuardSink.Entries  = GuardEntries;
+
+  WalkPageTables (&Sink1G, &Sink2M, &Sink4K, &PdeSink, &GuardSink);
+
+  if (((Range1GEntries != NULL) && (*Range1GCount < Sink1G.Count)) || ((Range2MEntries != NULL) && (*Range2MCount < Sink2M.Count)) ||
+      ((Range4KEntries != NULL) && (*Range4KCount < Sink4K.Count)) || ((PdeEntries != NULL) && (*PdeCount < PdeSink.Count)) ||
+      ((GuardEntries != NULL) && (*GuardCount < GuardSink.Count)))
+  {
+    Status = EFI_BUFFER_TOO_SMALL;
+  }
+
+  *Range1GCount = Sink1G.Count;
+  *Range2MCount = Sink2M.Count;
+  *Range4KCount = Sink4K.Count;
+  *PdeCount     = PdeSink.Count;
+  *GuardCount   = GuardSink.Count;
+
+  return Status;
+} // GetPageTableRangeData()
+
+/**
+  This helper function walks the page tables once and writes every entry to
+  the corresponding stream as it is encountered, so no buffer sized by the page
+  tables is needed. Guard page addresses are added to the memory info database.
+
+  @param[in]        Merge
+      TRUE to write the 1G, 2M and 4K entries as PAGE_AUDIT_RANGE records like
+      GetPageTableRangeData(), FALSE to write one raw entry per page like
+      GetFlatPageTableData(). The caller writes any PAGE_AUDIT_RANGE_HEADER.
+  @param[in, out]   Stream1G, Stream2M, Stream4K, PdeStream
+      The streams receiving each kind of value.
+  @param[out]       GuardCount
+      The number of guard pages added to the memory info database.
+
+  @retval     EFI_SUCCESS             The page tables were walked. Write errors are
+                                      reported when the streams are closed.
+  @retval     EFI_INVALID_PARAMETER   One of the parameters is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+StreamPageTableData (
+  IN     BOOLEAN            Merge,
+  IN OUT PAGE_AUDIT_STREAM  *Stream1G,
+  IN OUT PAGE_AUDIT_STREAM  *Stream2M,
+  IN OUT PAGE_AUDIT_STREAM  *Stream4K,
+  IN OUT PAGE_AUDIT_STREAM  *PdeStream,
+  OUT    UINTN              *GuardCount
+  )
+{
+  PAGE_AUDIT_SINK  Sink1G;
+  PAGE_AUDIT_SINK  Sink2M;
+  PAGE_AUDIT_SINK  Sink4K;
+  PAGE_AUDIT_SINK  PdeSink;
+  PAGE_AUDIT_SINK  GuardSink;
+
+  if ((Stream1G == NULL) || (Stream2M == NULL) || (Stream4K == NULL) || (PdeStream == NULL) || (GuardCount == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (&Sink1G, sizeof (Sink1G));
+  ZeroMem (&Sink2M, sizeof (Sink2M));
+  ZeroMem (&Sink4K, sizeof (Sink4K));
+  ZeroMem (&PdeSink, sizeof (PdeSink));
+  ZeroMem (&GuardSink, sizeof (GuardSink));
+  Sink1G.Merge     = Merge;
+  Sink1G.Stream    = Stream1G;
+  Sink1G.PageSize  = SIZE_1GB;
+  Sink2M.Merge     = Merge;
+  Sink2M.Stream    = Stream2M;
+  Sink2M.PageSize  = SIZE_2MB;
+  Sink4K.Merge     = Merge;
+  Sink4K.Stream    = Stream4K;
+  Sink4K.PageSize  = SIZE_4KB;
+  PdeSink.Stream   = PdeStream;
+  GuardSink.Format = "GuardPage,0x%016lx\n";
+
+  WalkPageTables (&Sink1G, &Sink2M, &Sink4K, &PdeSink, &GuardSink);
+
+  *GuardCount = GuardSink.Count;
+
+  return EFI_SUCCESS;
+} // StreamPageTableData()
+
 /**
    Dump platform specific handler. Created handler(s) need to be compliant with
    Windows\PagingReportGenerator.py, i.e. TSEG.
@@ -39,43 +39,76 @@ def ParseInfoFile(fileName):
     return MemoryRanges
 
 
+# Range record files start with this header: Signature, Version, PageSize.
+PAGE_AUDIT_RANGE_HEADER = struct.Struct("<4sIQ")
+PAGE_AUDIT_RANGE_SIGNATURE = b"PARG"
+PAGE_AUDIT_RANGE_VERSION = 1
+
+
+def ParsePageEntries(fileName, pageSize):
+    ''' Returns a list of (entry bytes, page count) tuples from a page table file.
+
+    Files written with PcdPagingAuditRangeRecords start with a range header and hold
+    16 byte records: the leaf entry of the first page followed by the number of
+    contiguous pages that share its attributes. Flat files hold one 8 byte entry
+    per page and zero entries are skipped.
+    '''
+    ByteArray = ParseFileToBytes(fileName)
+    Entries = []
+    if len(ByteArray) >= PAGE_AUDIT_RANGE_HEADER.size:
+        Signature, Version, HeaderPageSize = PAGE_AUDIT_RANGE_HEADER.unpack(bytes(ByteArray[:PAGE_AUDIT_RANGE_HEADER.size]))
+        if (Signature == PAGE_AUDIT_RANGE_SIGNATURE) and (Version == PAGE_AUDIT_RANGE_VERSION) and (HeaderPageSize == MemoryRange.PageSize[pageSize]):
+            byteZeroIndex = PAGE_AUDIT_RANGE_HEADER.size
+            while (byteZeroIndex + 15) < len(ByteArray):
+                PageCount = int.from_bytes(ByteArray[byteZeroIndex + 8: byteZeroIndex + 16], 'little')
+                if PageCount != 0:
+                    Entries.append((ByteArray[byteZeroIndex: byteZeroIndex + 8], PageCount))
+                byteZeroIndex += 16
+            logging.debug("%d range records found in file %s" % (len(Entries), fileName))
+            return Entries
+
+    byteZeroIndex = 0
+    while (byteZeroIndex + 7) < len(ByteArray):
+        if any(ByteArray[byteZeroIndex: byteZeroIndex + 8]):
+            Entries.append((ByteArray[byteZeroIndex: byteZeroIndex + 8], 1))
+        byteZeroIndex += 8
+    return Entries
+
+
+def SetPageCount(page, PageCount):
+    if PageCount > 1:
+        page.NumberOfEntries = PageCount
+        page.PhysicalSize *= PageCount
+        page.CalculateEnd()
+    return page
+
+
 def Parse4kPages(fileName, addressbits, architecture):
     num = 0
     pages = []
     logging.debug("-- Processing file '%s'..." % fileName)
-    ByteArray = ParseFileToBytes(fileName)
-    byteZeroIndex = 0
     if (architecture == "X64"):
-        while (byteZeroIndex + 7) < len(ByteArray):
-            if 0 == (ByteArray[byteZeroIndex + 0] + ByteArray[byteZeroIndex + 1] + ByteArray[byteZeroIndex + 2] + ByteArray[byteZeroIndex + 3] + ByteArray[byteZeroIndex + 4] + ByteArray[byteZeroIndex + 5] + ByteArray[byteZeroIndex + 6] + ByteArray[byteZeroIndex + 7]):
-                byteZeroIndex += 8
-                continue
-            Present = ((ByteArray[byteZeroIndex + 0] & 0x1))
-            ReadWrite = ((ByteArray[byteZeroIndex + 0] & 0x2) >> 1)
-            User = ((ByteArray[byteZeroIndex + 0] & 0x4) >> 2)
-            PageTableBaseAddress = (((((ByteArray[byteZeroIndex + 1] & 0xF0) >> 4)) + (ByteArray[byteZeroIndex + 2] << 4) + (ByteArray[byteZeroIndex + 3] << 12) + (ByteArray[byteZeroIndex + 4] << 20) + (ByteArray[byteZeroIndex + 5] << 28) + ((ByteArray[byteZeroIndex + 6] & 0xF) << 36) << 12) & addressbits)
-            Nx = ((ByteArray[byteZeroIndex + 7] & 0x80) >> 7)
-
-            byteZeroIndex += 8
+        for Entry, PageCount in ParsePageEntries(fileName, "4k"):
+            Present = ((Entry[0] & 0x1))
+            ReadWrite = ((Entry[0] & 0x2) >> 1)
+            User = ((Entry[0] & 0x4) >> 2)
+            PageTableBaseAddress = (((((Entry[1] & 0xF0) >> 4)) + (Entry[2] << 4) + (Entry[3] << 12) + (Entry[4] << 20) + (Entry[5] << 28) + ((Entry[6] & 0xF) << 36) << 12) & addressbits)
+            Nx = ((Entry[7] & 0x80) >> 7)
+
             num += 1
-            pages.append(MemoryRange("PTEntry", "4k", Present, ReadWrite, Nx, 1, User, (PageTableBaseAddress)))
+            pages.append(SetPageCount(MemoryRange("PTEntry", "4k", Present, ReadWrite, Nx, 1, User, (PageTableBaseAddress)), PageCount))
     elif (architecture == "AARCH64"):
-        while (byteZeroIndex + 7) < len(ByteArray):
-            # check if this page is zero
-            if 0 == (ByteArray[byteZeroIndex + 0] + ByteArray[byteZeroIndex + 1] + ByteArray[byteZeroIndex + 2] + ByteArray[byteZeroIndex + 3] + ByteArray[byteZeroIndex + 4] + ByteArray[byteZeroIndex + 5] + ByteArray[byteZeroIndex + 6] + ByteArray[byteZeroIndex + 7]):
-                byteZeroIndex += 8
-                continue
-            Valid = ((ByteArray[byteZeroIndex + 0] & 0x1))
-            IsTable = ((ByteArray[byteZeroIndex + 0] & 0x2) >> 1)
-            AccessPermisions = (((ByteArray[byteZeroIndex + 0] & 0xC0) >> 6))
-            Sharability = ((ByteArray[byteZeroIndex + 1] & 0x3))
-            Pxn         = ((ByteArray[byteZeroIndex + 6] & 0x10) >> 4)
-            Uxn         = ((ByteArray[byteZeroIndex + 6] & 0x20) >> 5)
-            PageTableBaseAddress = (int.from_bytes(ByteArray[byteZeroIndex: byteZeroIndex + 8], 'little')) & (0xFFFFFFFFF << 12)
-            logging.debug("4KB Page: 0x%s. Valid: %d. AccessPermissions: %d. Sharability: %d. Pxn: %d. Uxn: %d. PageTableBaseAddress: %s" % (BytesToHexString(ByteArray[byteZeroIndex : byteZeroIndex + 8]), Valid, AccessPermisions, Sharability, Pxn, Uxn, hex(PageTableBaseAddress)))
-            byteZeroIndex += 8
+        for Entry, PageCount in ParsePageEntries(fileName, "4k"):
+            Valid = ((Entry[0] & 0x1))
+            IsTable = ((Entry[0] & 0x2) >> 1)
+            AccessPermisions = (((Entry[0] & 0xC0) >> 6))
+            Sharability = ((Entry[1] & 0x3))
+            Pxn         = ((Entry[6] & 0x10) >> 4)
+            Uxn         = ((Entry[6] & 0x20) >> 5)
+            PageTableBaseAddress = (int.from_bytes(Entry, 'little')) & (0xFFFFFFFFF << 12)
+            logging.debug("4KB Page: 0x%s. Valid: %d. AccessPermissions: %d. Sharability: %d. Pxn: %d. Uxn: %d. PageTableBaseAddress: %s" % (BytesToHexString(Entry), Valid, AccessPermisions, Sharability, Pxn, Uxn, hex(PageTableBaseAddress)))
             num += 1
-            pages.append(MemoryRange("TTEntry", "4k", Valid, (AccessPermisions & 0x2) >> 1, Sharability, Pxn, Uxn, PageTableBaseAddress, IsTable))
+            pages.append(SetPageCount(MemoryRange("TTEntry", "4k", Valid, (AccessPermisions & 0x2) >> 1, Sharability, Pxn, Uxn, PageTableBaseAddress, IsTable), PageCount))
 
     logging.debug("%d entries found in file %s" % (num, fileName))
     return pages
@@ -85,40 +118,29 @@ def Parse2mPages(fileName, addressbits, architecture):
     num = 0
     pages = []
     logging.debug("-- Processing file '%s'..." % fileName)
-    ByteArray = ParseFileToBytes(fileName)
-    byteZeroIndex = 0
     if (architecture == "X64"):
-        while (byteZeroIndex + 7) < len(ByteArray):
-            if 0 == (ByteArray[byteZeroIndex + 0] + ByteArray[byteZeroIndex + 1] + ByteArray[byteZeroIndex + 2] + ByteArray[byteZeroIndex + 3] + ByteArray[byteZeroIndex + 4] + ByteArray[byteZeroIndex + 5] + ByteArray[byteZeroIndex + 6] + ByteArray[byteZeroIndex + 7]):
-                byteZeroIndex += 8
-                continue
-            Present = ((ByteArray[byteZeroIndex + 0] & 0x1) >> 0)
-            ReadWrite = ((ByteArray[byteZeroIndex + 0] & 0x2) >> 1)
-            MustBe1 = ((ByteArray[byteZeroIndex + 0] & 0x80) >> 7)
-            User = ((ByteArray[byteZeroIndex + 0] & 0x4) >> 2)
-            PageTableBaseAddress = (((((ByteArray[byteZeroIndex + 2] & 0xE0) >> 5)) + (ByteArray[byteZeroIndex + 3] << 3) + (ByteArray[byteZeroIndex + 4] << 11) + (ByteArray[byteZeroIndex + 5] << 19) + ((ByteArray[byteZeroIndex + 6] & 0xF) << 27) << 21) & addressbits)
-            Nx = ((ByteArray[byteZeroIndex + 7] & 0x80) >> 7)
-
-            byteZeroIndex += 8
+        for Entry, PageCount in ParsePageEntries(fileName, "2m"):
+            Present = ((Entry[0] & 0x1) >> 0)
+            ReadWrite = ((Entry[0] & 0x2) >> 1)
+            MustBe1 = ((Entry[0] & 0x80) >> 7)
+            User = ((Entry[0] & 0x4) >> 2)
+            PageTableBaseAddress = (((((Entry[2] & 0xE0) >> 5)) + (Entry[3] << 3) + (Entry[4] << 11) + (Entry[5] << 19) + ((Entry[6] & 0xF) << 27) << 21) & addressbits)
+            Nx = ((Entry[7] & 0x80) >> 7)
+
             num += 1
-            pages.append(MemoryRange("PTEntry", "2m", Present, ReadWrite, Nx, MustBe1, User, (PageTableBaseAddress)))
+            pages.append(SetPageCount(MemoryRange("PTEntry", "2m", Present, ReadWrite, Nx, MustBe1, User, (PageTableBaseAddress)), PageCount))
     elif (architecture == "AARCH64"):
-        while (byteZeroIndex + 7) < len(ByteArray):
-            # check if this page is zero
-            if 0 == (ByteArray[byteZeroIndex + 0] + ByteArray[byteZeroIndex + 1] + ByteArray[byteZeroIndex + 2] + ByteArray[byteZeroIndex + 3] + ByteArray[byteZeroIndex + 4] + ByteArray[byteZeroIndex + 5] + ByteArray[byteZeroIndex + 6] + ByteArray[byteZeroIndex + 7]):
-                byteZeroIndex += 8
-                continue
-            Valid = ((ByteArray[byteZeroIndex + 0] & 0x1))
-            IsTable = ((ByteArray[byteZeroIndex + 0] & 0x2) >> 1)
-            AccessPermisions = (((ByteArray[byteZeroIndex + 0] & 0xC0) >> 6))
-            Sharability = ((ByteArray[byteZeroIndex + 1] & 0x3))
-            Pxn         = ((ByteArray[byteZeroIndex + 6] & 0x10) >> 4)
-            Uxn         = ((ByteArray[byteZeroIndex + 6] & 0x20) >> 5)
-            PageTableBaseAddress = (int.from_bytes(ByteArray[byteZeroIndex: byteZeroIndex + 8], 'little')) & (0xFFFFFFFFF << 12)
-            logging.debug("2MB Page: 0x%s. Valid: %d. IsTable: %d AccessPermissions: %d. Sharability: %d. Pxn: %d. Uxn: %d. PageTableBaseAddress: %s" % (BytesToHexString(ByteArray[byteZeroIndex : byteZeroIndex + 8]), Valid, IsTable, AccessPermisions, Sharability, Pxn, Uxn, hex(PageTableBaseAddress)))
-            byteZeroIndex += 8
+        for Entry, PageCount in ParsePageEntries(fileName, "2m"):
+            Valid = ((Entry[0] & 0x1))
+            IsTable = ((Entry[0] & 0x2) >> 1)
+            AccessPermisions = (((Entry[0] & 0xC0) >> 6))
+            Sharability = ((Entry[1] & 0x3))
+            Pxn         = ((Entry[6] & 0x10) >> 4)
+            Uxn         = ((Entry[6] & 0x20) >> 5)
+            PageTableBaseAddress = (int.from_bytes(Entry, 'little')) & (0xFFFFFFFFF << 12)
+            logging.debug("2MB Page: 0x%s. Valid: %d. IsTable: %d AccessPermissions: %d. Sharability: %d. Pxn: %d. Uxn: %d. PageTableBaseAddress: %s" % (BytesToHexString(Entry), Valid, IsTable, AccessPermisions, Sharability, Pxn, Uxn, hex(PageTableBaseAddress)))
             num += 1
-            pages.append(MemoryRange("TTEntry", "2m", Valid, (AccessPermisions & 0x2) >> 1, Sharability, Pxn, Uxn, PageTableBaseAddress, IsTable))
+            pages.append(SetPageCount(MemoryRange("TTEntry", "2m", Valid, (AccessPermisions & 0x2) >> 1, Sharability, Pxn, Uxn, PageTableBaseAddress, IsTable), PageCount))
 
     logging.debug("%d entries found in file %s" % (num, fileName))
     return pages
@@ -128,40 +150,29 @@ def Parse1gPages(fileName, addressbits, architecture):
     num = 0
     pages = []
     logging.debug("-- Processing file '%s'..." % fileName)
-    ByteArray = ParseFileToBytes(fileName)
-    byteZeroIndex = 0
     if (architecture == "X64"):
-        while (byteZeroIndex + 7) < len(ByteArray):
-            if 0 == (ByteArray[byteZeroIndex + 0] + ByteArray[byteZeroIndex + 1] + ByteArray[byteZeroIndex + 2] + ByteArray[byteZeroIndex + 3] + ByteArray[byteZeroIndex + 4] + ByteArray[byteZeroIndex + 5] + ByteArray[byteZeroIndex + 6] + ByteArray[byteZeroIndex + 7]):
-                byteZeroIndex += 8
-                continue
-            Present = ((ByteArray[byteZeroIndex + 0] & 0x1))
-            ReadWrite = ((ByteArray[byteZeroIndex + 0] & 0x2) >> 1)
-            MustBe1 = ((ByteArray[byteZeroIndex + 0] & 0x80) >> 7)
-            User = ((ByteArray[byteZeroIndex + 0] & 0x4) >> 2)
-            PageTableBaseAddress = (((((ByteArray[byteZeroIndex + 3] & 0xC0) >> 6)) + (ByteArray[byteZeroIndex + 4] << 2) + (ByteArray[byteZeroIndex + 5] << 10) + ((ByteArray[byteZeroIndex + 6] & 0xF) << 18) << 30) & addressbits) # shift and address bits
-            Nx = ((ByteArray[byteZeroIndex + 7] & 0x80) >> 7)
-
-            byteZeroIndex += 8
-            pages.append(MemoryRange("PTEntry", "1g", Present, ReadWrite, Nx, MustBe1, User, PageTableBaseAddress))
+        for Entry, PageCount in ParsePageEntries(fileName, "1g"):
+            Present = ((Entry[0] & 0x1))
+            ReadWrite = ((Entry[0] & 0x2) >> 1)
+            MustBe1 = ((Entry[0] & 0x80) >> 7)
+            User = ((Entry[0] & 0x4) >> 2)
+            PageTableBaseAddress = (((((Entry[3] & 0xC0) >> 6)) + (Entry[4] << 2) + (Entry[5] << 10) + ((Entry[6] & 0xF) << 18) << 30) & addressbits) # shift and address bits
+            Nx = ((Entry[7] & 0x80) >> 7)
+
+            pages.append(SetPageCount(MemoryRange("PTEntry", "1g", Present, ReadWrite, Nx, MustBe1, User, PageTableBaseAddress), PageCount))
             num += 1
     elif (architecture == "AARCH64"):
-        while (byteZeroIndex + 7) < len(ByteArray):
-            # check if this page is zero
-            if 0 == (ByteArray[byteZeroIndex + 0] + ByteArray[byteZeroIndex + 1] + ByteArray[byteZeroIndex + 2] + ByteArray[byteZeroIndex + 3] + ByteArray[byteZeroIndex + 4] + ByteArray[byteZeroIndex + 5] + ByteArray[byteZeroIndex + 6] + ByteArray[byteZeroIndex + 7]):
-                byteZeroIndex += 8
-                continue
-            Valid = ((ByteArray[byteZeroIndex + 0] & 0x1))
-            IsTable = ((ByteArray[byteZeroIndex + 0] & 0x2) >> 1)
-            AccessPermisions = (((ByteArray[byteZeroIndex + 0] & 0xC0) >> 6))
-            Sharability = ((ByteArray[byteZeroIndex + 1] & 0x3))
-            Pxn         = ((ByteArray[byteZeroIndex + 6] & 0x10) >> 4)
-            Uxn         = ((ByteArray[byteZeroIndex + 6] & 0x20) >> 5)
-            PageTableBaseAddress = (int.from_bytes(ByteArray[byteZeroIndex: byteZeroIndex + 8], 'little')) & (0xFFFFFFFFF << 12)
-            logging.debug("1GB Page: 0x%s. Valid: %d. IsTable: %d AccessPermissions: %d. Sharability: %d. Pxn: %d. Uxn: %d. PageTableBaseAddress: %s" % (BytesToHexString(ByteArray[byteZeroIndex : byteZeroIndex + 8]), Valid, IsTable, AccessPermisions, Sharability, Pxn, Uxn, hex(PageTableBaseAddress)))
-            byteZeroIndex += 8
+        for Entry, PageCount in ParsePageEntries(fileName, "1g"):
+            Valid = ((Entry[0] & 0x1))
+            IsTable = ((Entry[0] & 0x2) >> 1)
+            AccessPermisions = (((Entry[0] & 0xC0) >> 6))
+            Sharability = ((Entry[1] & 0x3))
+            Pxn         = ((Entry[6] & 0x10) >> 4)
+            Uxn         = ((Entry[6] & 0x20) >> 5)
+            PageTableBaseAddress = (int.from_bytes(Entry, 'little')) & (0xFFFFFFFFF << 12)
+            logging.debug("1GB Page: 0x%s. Valid: %d. IsTable: %d AccessPermissions: %d. Sharability: %d. Pxn: %d. Uxn: %d. PageTableBaseAddress: %s" % (BytesToHexString(Entry), Valid, IsTable, AccessPermisions, Sharability, Pxn, Uxn, hex(PageTableBaseAddress)))
             num += 1
-            pages.append(MemoryRange("TTEntry", "1g", Valid, (AccessPermisions & 0x2) >> 1, Sharability, Pxn, Uxn, PageTableBaseAddress, IsTable))
+            pages.append(SetPageCount(MemoryRange("TTEntry", "1g", Valid, (AccessPermisions & 0x2) >> 1, Sharability, Pxn, Uxn, PageTableBaseAddress, IsTable), PageCount))
 
     logging.debug("%d entries found in file %s" % (num, fileName))
     return pages
@@ -408,8 +408,17 @@ class MemoryRange(object):
         next = copy.deepcopy(self)
         self.PhysicalEnd = end_of_current
         next.PhysicalStart = end_of_current +1
+        self.ResizeToBounds()
+        next.ResizeToBounds()
         return next
 
+    # Recompute the size and entry count from the range bounds.
+    # Each piece counts the entries it overlaps, so a split page counts in both pieces.
+    def ResizeToBounds(self):
+        self.PhysicalSize = self.PhysicalEnd - self.PhysicalStart + 1
+        page_size = self.getPageSize()
+        self.NumberOfEntries = (self.PhysicalEnd // page_size) - (self.PhysicalStart // page_size) + 1
+
     def sameAttributes(self, compare, architecture):
         if compare is None:
             return False
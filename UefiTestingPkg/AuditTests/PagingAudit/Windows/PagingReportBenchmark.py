@@ -0,0 +1,173 @@
+# Times the page to memory range correlation of PagingReportGenerator on synthetic data
+# and checks it against the original nested loop on small inputs.
+#
+# Copyright (C) Microsoft Corporation. All rights reserved.
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+##
+
+import argparse
+import logging
+import operator
+import os
+import random
+import sys
+import time
+
+#Add script dir to path for import
+sp = os.path.dirname(os.path.realpath(__file__))
+sys.path.append(sp)
+
+from MemoryRangeObjects import *
+from PagingReportGenerator import ParsingTool
+
+
+def MakeSyntheticData(PageCount, Seed):
+    ''' Returns (pages, memory ranges, MAT entries) describing PageCount contiguous 4k pages.
+
+    Memory map entries of random length cover the whole space, one in four of them holds a
+    loaded image, one in sixteen has a second image overlapping it and one in eight is
+    followed by a guard page. A quarter of the 2MB aligned blocks are mapped by 2MB pages,
+    which the memory map entries split.
+    '''
+    rand = random.Random(Seed)
+    Pages = []
+    i = 0
+    while i < PageCount:
+        if ((i % 512) == 0) and (i + 512 <= PageCount) and (rand.randint(0, 3) == 0):
+            Pages.append(MemoryRange("PTEntry", "2m", 1, 1, 0, 1, 0, i * 0x1000))
+            i += 512
+        else:
+            Pages.append(MemoryRange("PTEntry", "4k", 1, (i >> 6) & 1, (i >> 7) & 1, 1, 0, i * 0x1000))
+            i += 1
+
+    Ranges = []
+    Mat = []
+    Page = 0
+    while Page < PageCount:
+        Length = min(rand.randint(1, 64), PageCount - Page)
+        Type = rand.choice((1, 2, 3, 4, 5, 6, 7, 10))
+        Ranges.append(MemoryRange("MemoryMap", "%x" % Type, "%x" % (Page * 0x1000), "0", "%x" % Length, "0", "%x" % 0))
+        if Type in (5, 6):
+            Mat.append(MemoryRange("MAT", "%x" % Type, "%x" % (Page * 0x1000), "0", "%x" % Length, "%x" % 0x4000, "%x" % 0))
+        if (len(Ranges) % 4) == 0:
+            Ranges.append(MemoryRange("LoadedImage", "%x" % (Page * 0x1000), "%x" % (Length * 0x1000), "Image%d.efi" % len(Ranges)))
+        if (len(Ranges) % 16) == 0:
+            Ranges.append(MemoryRange("LoadedImage", "%x" % (Page * 0x1000), "%x" % 0x1000, "Overlap%d.efi" % len(Ranges)))
+        if ((len(Ranges) % 8) == 0) and (Page + Length < PageCount):
+            Ranges.append(MemoryRange("GuardPage", "%x" % ((Page + Length) * 0x1000)))
+        Page += Length
+
+    rand.shuffle(Ranges)
+    return Pages, Ranges, Mat
+
+
+def NestedLoopCorrelate(tool):
+    ''' The original O(pages * ranges) matching loop, kept as a reference. '''
+    index = 0
+    while index < len(tool.PageDirectoryInfo):
+        page = tool.PageDirectoryInfo[index]
+        for mr in tool.MemoryRangeInfo:
+            if page.overlap(mr):
+                if (mr.MemoryType is not None) or (mr.GcdType is not None):
+                    if (page.PhysicalStart < mr.PhysicalStart):
+                        next = page.split(mr.PhysicalStart-1)
+                        tool.PageDirectoryInfo.insert(index+1, next)
+                        index -= 1
+                        break
+
+                    if (page.PhysicalEnd > mr.PhysicalEnd):
+                        next = page.split(mr.PhysicalEnd)
+                        tool.PageDirectoryInfo.insert(index +1, next)
+
+                    if page.MemoryType is None:
+                        page.MemoryType = mr.MemoryType
+                    else:
+                        tool.ErrorMsg.append("Multiple memory types")
+
+                    if page.GcdType is None:
+                        page.GcdType = mr.GcdType
+                    else:
+                        tool.ErrorMsg.append("Multiple memory types")
+
+                if mr.ImageName is not None:
+                    if page.ImageName is None:
+                        page.ImageName = mr.ImageName
+                    else:
+                        tool.ErrorMsg.append("Multiple memory contents")
+
+                if mr.SystemMemoryType is not None:
+                    if page.SystemMemoryType is None:
+                        page.SystemMemoryType = mr.SystemMemoryType
+                    else:
+                        tool.ErrorMsg.append("Multiple System Memory types")
+
+                if mr.CpuNumber is not None:
+                    if page.CpuNumber is None:
+                        page.CpuNumber = mr.CpuNumber
+                    else:
+                        tool.ErrorMsg.append("Multiple Cpu Numbers")
+
+        for MatEntry in tool.MemoryAttributesTable:
+            if page.overlap(MatEntry):
+                page.Attribute = MatEntry.Attribute
+        index += 1
+
+    return tool.CombinePages(tool.PageDirectoryInfo)
+
+
+def Summarize(Pages):
+    return [(p.PhysicalStart, p.PhysicalEnd, p.NumberOfEntries, p.MemoryType, p.GcdType, p.ImageName,
+             p.SystemMemoryType, p.Attribute, p.ReadWrite, p.Nx) for p in Pages]
+
+
+def NewTool(PageCount, Seed):
+    tool = ParsingTool(None, "Benchmark", "1.0", "DXE", "X64")
+    tool.PageDirectoryInfo, tool.MemoryRangeInfo, tool.MemoryAttributesTable = MakeSyntheticData(PageCount, Seed)
+    tool.PageDirectoryInfo.sort(key=operator.attrgetter('PhysicalStart'))
+    return tool
+
+
+def Verify(PageCount, Seed):
+    Sweep = NewTool(PageCount, Seed)
+    Result = Sweep.CombinePages(Sweep.CorrelatePages(Sweep.PageDirectoryInfo))
+    Reference = NewTool(PageCount, Seed)
+    Expected = NestedLoopCorrelate(Reference)
+    if Summarize(Result) != Summarize(Expected) or len(Sweep.ErrorMsg) != len(Reference.ErrorMsg):
+        logging.critical("Sweep result does not match the nested loop for %d pages (seed %d)" % (PageCount, Seed))
+        return False
+    print("Verified %d pages: %d ranges after combining, %d errors" % (PageCount, len(Result), len(Sweep.ErrorMsg)))
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark the page to memory range correlation of PagingReportGenerator')
+    parser.add_argument("--max-pages", dest="MaxPages", type=int, default=1000000, help="Largest synthetic page count, 10x steps from 10^3 (default 10^6, 10^7 needs about 16GB of RAM)")
+    parser.add_argument("--verify-pages", dest="VerifyPages", type=int, default=2000, help="Page count used to check against the nested loop (0 to skip)")
+    parser.add_argument("--seed", dest="Seed", type=int, default=0, help="Random seed for the synthetic data")
+    options = parser.parse_args()
+
+    # The tool logs every overlap error, keep the console quiet
+    logging.disable(logging.CRITICAL - 1)
+
+    if options.VerifyPages > 0:
+        for seed in range(options.Seed, options.Seed + 4):
+            if not Verify(options.VerifyPages, seed):
+                return -1
+
+    print("%12s %10s %12s %12s" % ("Pages", "Ranges", "Seconds", "us/page"))
+    PageCount = 1000
+    while PageCount <= options.MaxPages:
+        tool = NewTool(PageCount, options.Seed)
+        RangeCount = len(tool.MemoryRangeInfo)
+        start = time.perf_counter()
+        tool.PageDirectoryInfo = tool.CombinePages(tool.CorrelatePages(tool.PageDirectoryInfo))
+        elapsed = time.perf_counter() - start
+        print("%12d %10d %12.3f %12.3f" % (PageCount, RangeCount, elapsed, elapsed * 1000000 / PageCount))
+        del tool
+        PageCount *= 10
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
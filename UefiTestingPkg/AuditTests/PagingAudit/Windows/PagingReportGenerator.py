@@ -24,6 +24,45 @@ from BinaryParsing import *
 VERSION = "0.90"
 
 
+class RangeSweep(object):
+    ''' Finds the memory ranges overlapping a page while walking pages in address order.
+
+    Ranges are sorted by start once. Each query pulls in the ranges that start at or
+    before the end of the page and drops the ones that ended before it, so a sorted
+    walk over P pages costs O((P + R) log R) instead of O(P * R). Overlapping ranges are
+    returned in their original list order so that the first/last match rules used by
+    the callers do not change. A query that moves backwards, which only happens when
+    page table entries overlap, rebuilds the live set.
+    '''
+
+    def __init__(self, Ranges):
+        self.Ranges = sorted(enumerate(Ranges), key=lambda r: r[1].PhysicalStart)
+        self.Next = 0
+        self.Live = []
+        self.LiveMinEnd = None
+        self.LastStart = None
+
+    def Overlapping(self, page):
+        if (self.LastStart is not None) and (page.PhysicalStart < self.LastStart):
+            self.Live = self.Ranges[:self.Next]
+            self.LiveMinEnd = None
+        self.LastStart = page.PhysicalStart
+
+        while (self.Next < len(self.Ranges)) and (self.Ranges[self.Next][1].PhysicalStart <= page.PhysicalEnd):
+            self.Live.append(self.Ranges[self.Next])
+            self.Next += 1
+            self.LiveMinEnd = None
+
+        if (self.LiveMinEnd is None) or (self.LiveMinEnd < page.PhysicalStart):
+            self.Live = [r for r in self.Live if r[1].PhysicalEnd >= page.PhysicalStart]
+            self.LiveMinEnd = min((r[1].PhysicalEnd for r in self.Live), default=None)
+
+        Found = [r for r in self.Live if r[1].PhysicalStart <= page.PhysicalEnd]
+        if len(Found) > 1:
+            Found.sort(key=lambda r: r[0])
+        return [r[1] for r in Found]
+
+
 class ParsingTool(object):
 
     def __init__(self, DatFolderPath, PlatformName, PlatformVersion, Type, Architecture):
@@ -110,26 +149,49 @@ class ParsingTool(object):
         if len(self.MemoryRangeInfo) == 0:
             self.ErrorMsg.append("No Memory Range info found in Info files")
 
-        # Matching memory ranges up to page table entries
-        # use index based iteration so that page splitting
-        # is supported.
-        index = 0
-        while index < len(self.PageDirectoryInfo):
-            page = self.PageDirectoryInfo[index]
-            for mr in self.MemoryRangeInfo:
-                if page.overlap(mr):
+        # Matching memory ranges up to page table entries, splitting pages
+        # where a typed range starts or ends inside of them.
+        self.PageDirectoryInfo = self.CorrelatePages(self.PageDirectoryInfo)
+
+        # Combining adjacent pages that have the same attributes.
+        self.PageDirectoryInfo = self.CombinePages(self.PageDirectoryInfo)
+
+        return 0
+
+    def CorrelatePages(self, Pages):
+        ''' Annotates each page with the memory ranges and MAT entries that overlap it.
+
+        Pages must be sorted by PhysicalStart. Both lists are swept in address order,
+        so each page only visits the ranges live at its address instead of every range.
+        Pages split by a range are processed again before moving on. Returns the new
+        list of pages.
+        '''
+        Ranges = RangeSweep(self.MemoryRangeInfo)
+        MatEntries = RangeSweep(self.MemoryAttributesTable)
+        Result = []
+        for page in Pages:
+            Pending = [page]
+            while len(Pending) > 0:
+                page = Pending.pop()
+                Reprocess = False
+                for mr in Ranges.Overlapping(page):
+                    # An earlier range may have split this page
+                    if not page.overlap(mr):
+                        continue
+
                     if (mr.MemoryType is not None) or (mr.GcdType is not None):
                         if (page.PhysicalStart < mr.PhysicalStart):
                             next = page.split(mr.PhysicalStart-1)
-                            self.PageDirectoryInfo.insert(index+1, next)
-                            # decrement the index so that we process this partial page again
+                            # process this partial page again before the rest of it
                             # because we are breaking from the MemoryRange Loop
-                            index -= 1
+                            Pending.append(next)
+                            Pending.append(page)
+                            Reprocess = True
                             break
 
                         if (page.PhysicalEnd > mr.PhysicalEnd):
                             next = page.split(mr.PhysicalEnd)
-                            self.PageDirectoryInfo.insert(index +1, next)
+                            Pending.append(next)
 
                         if page.MemoryType is None:
                             page.MemoryType = mr.MemoryType
@@ -156,7 +218,7 @@ class ParsingTool(object):
                         else:
                             self.ErrorMsg.append("Multiple System Memory types found for one region.  Base: 0x%X.  System Memory Type: %s and %s."% (page.PhysicalStart,page.GetSystemMemoryType(), mr.GetSystemMemoryType()))
                             logging.error("Multiple system memory types found for one region " + page.pageDebugStr() + " " +  mr.pageDebugStr())
-                    
+
                     # A CPU Number present in a memory range object implies it represents an AP stack. Capture the CPU
                     # number for printing a CPU identifier for each AP stack.
                     if mr.CpuNumber is not None:
@@ -166,23 +228,24 @@ class ParsingTool(object):
                             self.ErrorMsg.append("Multiple Cpu Numbers found for one region.  Base: 0x%X.  Cpu Numbers: %s and %s."% (page.PhysicalStart,page.CpuNumber, mr.CpuNumber))
                             logging.error("Multiple Cpu Numbers found for one region " + page.pageDebugStr() + " " +  mr.pageDebugStr())
 
-            for MatEntry in self.MemoryAttributesTable:
-                if page.overlap(MatEntry):
-                    page.Attribute = MatEntry.Attribute
-            index += 1
+                for MatEntry in MatEntries.Overlapping(page):
+                    if page.overlap(MatEntry):
+                        page.Attribute = MatEntry.Attribute
 
-        # Combining adjacent pages that have the same attributes.
-        index = 0
-        while index < (len(self.PageDirectoryInfo) - 1):
-            currentPage = self.PageDirectoryInfo[index]
-            nextPage = self.PageDirectoryInfo[index + 1]
-            if currentPage.sameAttributes(nextPage, self.Architecture):
-                currentPage.grow(nextPage)
-                del self.PageDirectoryInfo[index + 1]
-            else:
-                index += 1
+                if not Reprocess:
+                    Result.append(page)
 
-        return 0
+        return Result
+
+    def CombinePages(self, Pages):
+        ''' Merges runs of adjacent pages that have the same attributes. '''
+        Result = []
+        for page in Pages:
+            if (len(Result) > 0) and Result[-1].sameAttributes(page, self.Architecture):
+                Result[-1].grow(page)
+            else:
+                Result.append(page)
+        return Result
 
     def AddErrorMsg(self, msg):
         self.ErrorMsg.append(msg)
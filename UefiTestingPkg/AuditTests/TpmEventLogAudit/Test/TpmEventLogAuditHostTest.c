@@ -0,0 +1,711 @@
+/** @file -- TpmEventLogAuditHostTest.c
+Host-based UnitTest for the streaming TPM event log writer.  Every log is
+written both by the streaming writer and by the XmlTreeLib based tree and the
+two documents must match byte for byte.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../TpmEventLogXml.h"
+#include "../TpmEventLogStream.h"
+#include "TpmEventLogTestData.h"
+
+#define UNIT_TEST_NAME     "TpmEventLogAudit Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define LARGE_LOG_EVENT_COUNT  2000
+#define HUGE_EVENT_SIZE        0x9000
+
+//
+// Memory backed output for a sink.  Records the largest single write so the
+// tests can check the writer never hands out more than its fixed buffer.
+//
+typedef struct {
+  UINT8     *Data;
+  UINTN     Size;
+  UINTN     Capacity;
+  UINTN     Writes;
+  UINTN     LargestWrite;
+  UINTN     FailAfter;    // Fail writes once this many bytes were accepted, 0 for never
+} TEST_OUTPUT;
+
+//
+// Crypto agile log built by the test. Events follow the header in Buffer.
+//
+typedef struct {
+  UINT8    *Buffer;
+  UINTN    Size;
+  UINTN    Capacity;
+  UINTN    LastEntry;     // Offset of the start of the last event
+  UINTN    EventCount;
+} TEST_LOG;
+
+/**
+  The host test does not link Tpm2CommandLib, provide the lookup the walker and
+  New_NodeInList use.
+**/
+UINT16
+EFIAPI
+GetHashSizeFromAlgo (
+  IN TPMI_ALG_HASH  HashAlgo
+  )
+{
+  switch (HashAlgo) {
+    case TPM_ALG_SHA1:
+      return SHA1_DIGEST_SIZE;
+    case TPM_ALG_SHA256:
+      return SHA256_DIGEST_SIZE;
+    case TPM_ALG_SHA384:
+      return SHA384_DIGEST_SIZE;
+    case TPM_ALG_SHA512:
+      return SHA512_DIGEST_SIZE;
+    case TPM_ALG_SM3_256:
+      return SM3_256_DIGEST_SIZE;
+    default:
+      return 0;
+  }
+}
+
+STATIC
+VOID
+OutputAppend (
+  IN OUT TEST_OUTPUT  *Output,
+  IN CONST VOID       *Buffer,
+  IN UINTN            Size
+  )
+{
+  UINT8  *NewData;
+
+  if (Output->Size + Size > Output->Capacity) {
+    NewData = AllocatePool (MAX (Output->Capacity * 2, Output->Size + Size));
+    ASSERT (NewData != NULL);
+    if (Output->Data != NULL) {
+      CopyMem (NewData, Output->Data, Output->Size);
+      FreePool (Output->Data);
+    }
+
+    Output->Data     = NewData;
+    Output->Capacity = MAX (Output->Capacity * 2, Output->Size + Size);
+  }
+
+  CopyMem (Output->Data + Output->Size, Buffer, Size);
+  Output->Size += Size;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+TestSinkWrite (
+  IN VOID        *Context,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Size
+  )
+{
+  TEST_OUTPUT  *Output;
+
+  Output = (TEST_OUTPUT *)Context;
+  Output->Writes++;
+  Output->LargestWrite = MAX (Output->LargestWrite, Size);
+  if ((Output->FailAfter != 0) && (Output->Size + Size > Output->FailAfter)) {
+    return EFI_VOLUME_FULL;
+  }
+
+  OutputAppend (Output, Buffer, Size);
+  return EFI_SUCCESS;
+}
+
+STATIC
+VOID
+FreeOutput (
+  IN OUT TEST_OUTPUT  *Output
+  )
+{
+  if (Output->Data != NULL) {
+    FreePool (Output->Data);
+  }
+
+  ZeroMem (Output, sizeof (*Output));
+}
+
+/**
+  Stream a log into memory.
+**/
+STATIC
+EFI_STATUS
+StreamLog (
+  IN  EFI_PHYSICAL_ADDRESS         Location,
+  IN  EFI_PHYSICAL_ADDRESS         LastEntry,
+  IN  EFI_TCG2_FINAL_EVENTS_TABLE  *FinalEventsTable OPTIONAL,
+  OUT TEST_OUTPUT                  *Xml,
+  OUT TEST_OUTPUT                  *Summary OPTIONAL,
+  OUT UINTN                        *EventCount
+  )
+{
+  TPM_EVENT_LOG_SINK    *XmlSink;
+  TPM_EVENT_LOG_SINK    *SummarySink;
+  TPM_EVENT_LOG_STREAM  Stream;
+  EFI_STATUS            Status;
+
+  XmlSink     = AllocatePool (sizeof (TPM_EVENT_LOG_SINK));
+  SummarySink = AllocatePool (sizeof (TPM_EVENT_LOG_SINK));
+  TpmEventLogSinkInit (XmlSink, TestSinkWrite, Xml);
+  TpmEventLogSinkInit (SummarySink, TestSinkWrite, Summary);
+
+  Stream.Xml     = XmlSink;
+  Stream.Summary = (Summary != NULL) ? SummarySink : NULL;
+
+  Status = TpmEventLogStreamBegin (&Stream);
+  if (!EFI_ERROR (Status)) {
+    Status = TpmEventLogWalk (Location, LastEntry, FinalEventsTable, TpmEventLogStreamEvent, &Stream);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = TpmEventLogStreamEnd (&Stream);
+  }
+
+  *EventCount = Stream.EventCount;
+  FreePool (XmlSink);
+  FreePool (SummarySink);
+  return Status;
+}
+
+/**
+  Build the whole tree the way DumpEventLog -tree does and serialize it.
+**/
+STATIC
+EFI_STATUS
+TreeLog (
+  IN  EFI_PHYSICAL_ADDRESS         Location,
+  IN  EFI_PHYSICAL_ADDRESS         LastEntry,
+  IN  EFI_TCG2_FINAL_EVENTS_TABLE  *FinalEventsTable OPTIONAL,
+  OUT CHAR8                        **XmlString,
+  OUT UINTN                        *XmlLength
+  )
+{
+  XmlNode     *List;
+  UINTN       StringSize;
+  EFI_STATUS  Status;
+
+  *XmlString = NULL;
+  List       = New_EventsNodeList ();
+  if (List == NULL) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Status = TpmEventLogWalk (Location, LastEntry, FinalEventsTable, AddEventToNodeList, List);
+  if (!EFI_ERROR (Status)) {
+    Status = XmlTreeToString (List, FALSE, &StringSize, XmlString);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    *XmlLength = StringSize - 1;
+  }
+
+  FreeXmlTree (&List);
+  return Status;
+}
+
+/**
+  Stream and tree serialize the same log and compare the documents.
+**/
+STATIC
+UNIT_TEST_STATUS
+CompareStreamToTree (
+  IN EFI_PHYSICAL_ADDRESS         Location,
+  IN EFI_PHYSICAL_ADDRESS         LastEntry,
+  IN EFI_TCG2_FINAL_EVENTS_TABLE  *FinalEventsTable OPTIONAL,
+  IN UINTN                        ExpectedEvents
+  )
+{
+  TEST_OUTPUT  Xml;
+  CHAR8        *TreeString;
+  UINTN        TreeLength;
+  UINTN        EventCount;
+
+  ZeroMem (&Xml, sizeof (Xml));
+  UT_ASSERT_NOT_EFI_ERROR (StreamLog (Location, LastEntry, FinalEventsTable, &Xml, NULL, &EventCount));
+  UT_ASSERT_NOT_EFI_ERROR (TreeLog (Location, LastEntry, FinalEventsTable, &TreeString, &TreeLength));
+
+  // Header event plus every crypto agile event
+  UT_ASSERT_EQUAL (EventCount, ExpectedEvents + 1);
+  UT_ASSERT_TRUE (Xml.LargestWrite <= TPM_EVENT_LOG_SINK_BUFFER_SIZE);
+  UT_ASSERT_EQUAL (Xml.Size, TreeLength);
+  UT_ASSERT_MEM_EQUAL (Xml.Data, TreeString, TreeLength);
+
+  FreePool (TreeString);
+  FreeOutput (&Xml);
+  return UNIT_TEST_PASSED;
+}
+
+STATIC
+VOID
+LogAppend (
+  IN OUT TEST_LOG  *Log,
+  IN CONST VOID    *Data,
+  IN UINTN         Size
+  )
+{
+  UINT8  *NewBuffer;
+
+  if (Log->Size + Size > Log->Capacity) {
+    NewBuffer = AllocatePool (MAX (Log->Capacity * 2, Log->Size + Size));
+    ASSERT (NewBuffer != NULL);
+    if (Log->Buffer != NULL) {
+      CopyMem (NewBuffer, Log->Buffer, Log->Size);
+      FreePool (Log->Buffer);
+    }
+
+    Log->Buffer   = NewBuffer;
+    Log->Capacity = MAX (Log->Capacity * 2, Log->Size + Size);
+  }
+
+  CopyMem (Log->Buffer + Log->Size, Data, Size);
+  Log->Size += Size;
+}
+
+/**
+  Append a crypto agile event with one digest per algorithm in Algos.  Digest
+  bytes are derived from Seed so every event is distinct.
+**/
+STATIC
+VOID
+LogAppendEvent (
+  IN OUT TEST_LOG          *Log,
+  IN UINT32                PcrIndex,
+  IN UINT32                EventType,
+  IN CONST TPMI_ALG_HASH   *Algos,
+  IN UINT32                AlgoCount,
+  IN UINT32                EventSize,
+  IN UINT32                Seed
+  )
+{
+  UINT32  Index;
+  UINT32  Byte;
+  UINT8   Value;
+
+  Log->LastEntry = Log->Size;
+  Log->EventCount++;
+
+  LogAppend (Log, &PcrIndex, sizeof (PcrIndex));
+  LogAppend (Log, &EventType, sizeof (EventType));
+  LogAppend (Log, &AlgoCount, sizeof (AlgoCount));
+  for (Index = 0; Index < AlgoCount; Index++) {
+    LogAppend (Log, &Algos[Index], sizeof (TPMI_ALG_HASH));
+    for (Byte = 0; Byte < GetHashSizeFromAlgo (Algos[Index]); Byte++) {
+      Value = (UINT8)(Seed * 31 + Index * 7 + Byte);
+      LogAppend (Log, &Value, sizeof (Value));
+    }
+  }
+
+  LogAppend (Log, &EventSize, sizeof (EventSize));
+  for (Byte = 0; Byte < EventSize; Byte++) {
+    Value = (UINT8)(Seed + Byte * 13);
+    LogAppend (Log, &Value, sizeof (Value));
+  }
+}
+
+/**
+  Start a log with the header event copied from the boot log.
+**/
+STATIC
+VOID
+LogInit (
+  OUT TEST_LOG  *Log
+  )
+{
+  TCG_PCR_EVENT_HDR  *EventHdr;
+  UINTN              HeaderSize;
+  UINT32             NumberOfAlgorithms;
+  UINT8              VendorInfoSize;
+
+  ZeroMem (Log, sizeof (*Log));
+
+  EventHdr = (TCG_PCR_EVENT_HDR *)mBootEventLog;
+  CopyMem (&NumberOfAlgorithms, (UINT8 *)(EventHdr + 1) + sizeof (TCG_EfiSpecIDEventStruct), sizeof (NumberOfAlgorithms));
+  HeaderSize = sizeof (TCG_PCR_EVENT_HDR) + sizeof (TCG_EfiSpecIDEventStruct) + sizeof (UINT32) +
+               NumberOfAlgorithms * sizeof (TCG_EfiSpecIdEventAlgorithmSize);
+  VendorInfoSize = mBootEventLog[HeaderSize];
+  HeaderSize    += sizeof (UINT8) + VendorInfoSize;
+
+  LogAppend (Log, mBootEventLog, HeaderSize);
+}
+
+STATIC
+VOID
+FreeLog (
+  IN OUT TEST_LOG  *Log
+  )
+{
+  if (Log->Buffer != NULL) {
+    FreePool (Log->Buffer);
+  }
+
+  ZeroMem (Log, sizeof (*Log));
+}
+
+/**
+  Find Needle in the first Size bytes of Haystack.
+**/
+STATIC
+CONST CHAR8 *
+FindBytes (
+  IN CONST CHAR8  *Haystack,
+  IN UINTN        Size,
+  IN CONST CHAR8  *Needle
+  )
+{
+  UINTN  Length;
+  UINTN  Index;
+
+  Length = AsciiStrLen (Needle);
+  for (Index = 0; Index + Length <= Size; Index++) {
+    if (CompareMem (Haystack + Index, Needle, Length) == 0) {
+      return Haystack + Index;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  The boot log streams to exactly what the tree produces.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamMatchesTreeForBootLog (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_PHYSICAL_ADDRESS  Location;
+
+  Location = (EFI_PHYSICAL_ADDRESS)(UINTN)mBootEventLog;
+  return CompareStreamToTree (Location, Location + BOOT_EVENT_LOG_LAST_ENTRY_OFFSET, NULL, BOOT_EVENT_LOG_EVENT_COUNT);
+}
+
+/**
+  Events of the final events table follow the main log in both outputs.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamMatchesTreeWithFinalEvents (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_TCG2_FINAL_EVENTS_TABLE  *FinalEventsTable;
+  EFI_PHYSICAL_ADDRESS         Location;
+  UINTN                        FirstEvent;
+  UINTN                        FinalSize;
+  UNIT_TEST_STATUS             Result;
+  TEST_LOG                     Log;
+
+  //
+  // The final table repeats every event of the boot log, as if they were all
+  // logged again after GetEventLog was called.
+  //
+  LogInit (&Log);
+  FirstEvent = Log.Size;
+  FinalSize  = sizeof (mBootEventLog) - FirstEvent;
+
+  FinalEventsTable = AllocateZeroPool (sizeof (EFI_TCG2_FINAL_EVENTS_TABLE) + FinalSize);
+  UT_ASSERT_NOT_NULL (FinalEventsTable);
+  FinalEventsTable->Version        = EFI_TCG2_FINAL_EVENTS_TABLE_VERSION;
+  FinalEventsTable->NumberOfEvents = BOOT_EVENT_LOG_EVENT_COUNT;
+  CopyMem (FinalEventsTable + 1, mBootEventLog + FirstEvent, FinalSize);
+
+  Location = (EFI_PHYSICAL_ADDRESS)(UINTN)mBootEventLog;
+  Result   = CompareStreamToTree (
+               Location,
+               Location + BOOT_EVENT_LOG_LAST_ENTRY_OFFSET,
+               FinalEventsTable,
+               BOOT_EVENT_LOG_EVENT_COUNT * 2
+               );
+
+  FreePool (FinalEventsTable);
+  FreeLog (&Log);
+  return Result;
+}
+
+/**
+  A log with thousands of events, empty events, three banks and event data
+  that spans many output buffers still matches the tree.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamMatchesTreeForLargeLog (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST TPMI_ALG_HASH  Algos[] = { TPM_ALG_SHA1, TPM_ALG_SHA256, TPM_ALG_SHA384 };
+  EFI_PHYSICAL_ADDRESS        Location;
+  UNIT_TEST_STATUS            Result;
+  TEST_LOG                    Log;
+  UINT32                      Index;
+  UINT32                      EventSize;
+
+  LogInit (&Log);
+  for (Index = 0; Index < LARGE_LOG_EVENT_COUNT; Index++) {
+    if (Index % 97 == 0) {
+      EventSize = 0;
+    } else if (Index % 211 == 0) {
+      EventSize = 0x7000;
+    } else {
+      EventSize = (Index * 37) % 300;
+    }
+
+    LogAppendEvent (&Log, Index % 24, 0x80000000 + Index % 16, Algos, 1 + Index % 3, EventSize, Index);
+  }
+
+  Location = (EFI_PHYSICAL_ADDRESS)(UINTN)Log.Buffer;
+  Result   = CompareStreamToTree (Location, Location + Log.LastEntry, NULL, LARGE_LOG_EVENT_COUNT);
+
+  FreeLog (&Log);
+  return Result;
+}
+
+/**
+  Event data too large for New_NodeInList's staging string still streams.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamHandlesEventTreeCannot (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST TPMI_ALG_HASH  Algos[] = { TPM_ALG_SHA256 };
+  EFI_PHYSICAL_ADDRESS        Location;
+  TEST_OUTPUT                 Xml;
+  TEST_LOG                    Log;
+  CHAR8                       *TreeString;
+  UINTN                       TreeLength;
+  UINTN                       EventCount;
+  CONST CHAR8                 *Data;
+  CONST CHAR8                 *DataEnd;
+  UINT8                       *EventBuffer;
+  UINTN                       Index;
+  CHAR8                       Hex[3];
+
+  LogInit (&Log);
+  LogAppendEvent (&Log, 2, EV_EFI_BOOT_SERVICES_DRIVER, Algos, ARRAY_SIZE (Algos), HUGE_EVENT_SIZE, 5);
+  EventBuffer = Log.Buffer + Log.Size - HUGE_EVENT_SIZE;
+  Location    = (EFI_PHYSICAL_ADDRESS)(UINTN)Log.Buffer;
+
+  UT_ASSERT_TRUE (EFI_ERROR (TreeLog (Location, Location + Log.LastEntry, NULL, &TreeString, &TreeLength)));
+
+  ZeroMem (&Xml, sizeof (Xml));
+  UT_ASSERT_NOT_EFI_ERROR (StreamLog (Location, Location + Log.LastEntry, NULL, &Xml, NULL, &EventCount));
+  UT_ASSERT_EQUAL (EventCount, 2);
+  UT_ASSERT_TRUE (Xml.LargestWrite <= TPM_EVENT_LOG_SINK_BUFFER_SIZE);
+  UT_ASSERT_TRUE (Xml.Writes > (HUGE_EVENT_SIZE * 2) / TPM_EVENT_LOG_SINK_BUFFER_SIZE);
+
+  Data = FindBytes ((CHAR8 *)Xml.Data, Xml.Size, "<EventSize>36864</EventSize><EventData>");
+  UT_ASSERT_NOT_NULL (Data);
+  Data   += AsciiStrLen ("<EventSize>36864</EventSize><EventData>");
+  DataEnd = FindBytes (Data, Xml.Size - (Data - (CHAR8 *)Xml.Data), "</EventData>");
+  UT_ASSERT_NOT_NULL (DataEnd);
+  UT_ASSERT_EQUAL (DataEnd - Data, HUGE_EVENT_SIZE * 2);
+  for (Index = 0; Index < HUGE_EVENT_SIZE; Index++) {
+    AsciiSPrint (Hex, sizeof (Hex), "%02X", EventBuffer[Index]);
+    UT_ASSERT_MEM_EQUAL (Data + Index * 2, Hex, 2);
+  }
+
+  FreeOutput (&Xml);
+  FreeLog (&Log);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The digest summary has a record for every digest of every agile event, in
+  log order, with the digest bytes from the log.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DigestSummaryMatchesLog (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_PHYSICAL_ADDRESS         Location;
+  TEST_OUTPUT                  Xml;
+  TEST_OUTPUT                  Summary;
+  TEST_LOG                     Log;
+  UINTN                        EventCount;
+  TPM_EVENT_LOG_DIGEST_HEADER  *Header;
+  TPM_EVENT_LOG_DIGEST_RECORD  Record;
+  TCG_PCR_EVENT2               *Event;
+  UINT8                        *Cursor;
+  UINT8                        *EventCursor;
+  UINTN                        EventIndex;
+  UINT32                       DigestCount;
+  UINT32                       DigestIndex;
+  UINT32                       EventSize;
+  TPMI_ALG_HASH                HashAlgo;
+  UINTN                        DigestSize;
+
+  LogInit (&Log);
+  Location = (EFI_PHYSICAL_ADDRESS)(UINTN)mBootEventLog;
+  ZeroMem (&Xml, sizeof (Xml));
+  ZeroMem (&Summary, sizeof (Summary));
+  UT_ASSERT_NOT_EFI_ERROR (StreamLog (Location, Location + BOOT_EVENT_LOG_LAST_ENTRY_OFFSET, NULL, &Xml, &Summary, &EventCount));
+
+  UT_ASSERT_TRUE (Summary.Size >= sizeof (TPM_EVENT_LOG_DIGEST_HEADER));
+  Header = (TPM_EVENT_LOG_DIGEST_HEADER *)Summary.Data;
+  UT_ASSERT_EQUAL (Header->Signature, TPM_EVENT_LOG_DIGEST_SIGNATURE);
+  UT_ASSERT_EQUAL (Header->Version, TPM_EVENT_LOG_DIGEST_VERSION);
+
+  //
+  // Walk the log by hand next to the summary.
+  //
+  Cursor      = Summary.Data + sizeof (TPM_EVENT_LOG_DIGEST_HEADER);
+  EventCursor = (UINT8 *)mBootEventLog + Log.Size;
+  for (EventIndex = 0; EventIndex < BOOT_EVENT_LOG_EVENT_COUNT; EventIndex++) {
+    Event = (TCG_PCR_EVENT2 *)EventCursor;
+    CopyMem (&DigestCount, &Event->Digest.count, sizeof (DigestCount));
+    EventCursor = (UINT8 *)&Event->Digest.digests[0];
+    for (DigestIndex = 0; DigestIndex < DigestCount; DigestIndex++) {
+      CopyMem (&HashAlgo, EventCursor, sizeof (HashAlgo));
+      DigestSize = GetHashSizeFromAlgo (HashAlgo);
+
+      UT_ASSERT_TRUE ((UINTN)(Cursor - Summary.Data) + sizeof (Record) + DigestSize <= Summary.Size);
+      CopyMem (&Record, Cursor, sizeof (Record));
+      UT_ASSERT_EQUAL (Record.PcrIndex, Event->PCRIndex);
+      UT_ASSERT_EQUAL (Record.EventType, Event->EventType);
+      UT_ASSERT_EQUAL (Record.HashAlgo, HashAlgo);
+      UT_ASSERT_EQUAL (Record.DigestSize, DigestSize);
+      UT_ASSERT_MEM_EQUAL (Cursor + sizeof (Record), EventCursor + sizeof (HashAlgo), DigestSize);
+
+      Cursor      += sizeof (Record) + DigestSize;
+      EventCursor += sizeof (HashAlgo) + DigestSize;
+    }
+
+    CopyMem (&EventSize, EventCursor, sizeof (EventSize));
+    EventCursor += sizeof (EventSize) + EventSize;
+  }
+
+  UT_ASSERT_EQUAL ((UINTN)(Cursor - Summary.Data), Summary.Size);
+
+  FreeOutput (&Xml);
+  FreeOutput (&Summary);
+  FreeLog (&Log);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A failed write stops the walk and no more writes are attempted.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+WriteFailureStopsWalk (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST TPMI_ALG_HASH  Algos[] = { TPM_ALG_SHA1, TPM_ALG_SHA256 };
+  EFI_PHYSICAL_ADDRESS        Location;
+  TEST_OUTPUT                 Xml;
+  TEST_LOG                    Log;
+  UINTN                       EventCount;
+  UINT32                      Index;
+
+  LogInit (&Log);
+  for (Index = 0; Index < 200; Index++) {
+    LogAppendEvent (&Log, Index % 8, EV_POST_CODE, Algos, ARRAY_SIZE (Algos), 64, Index);
+  }
+
+  Location = (EFI_PHYSICAL_ADDRESS)(UINTN)Log.Buffer;
+  ZeroMem (&Xml, sizeof (Xml));
+  Xml.FailAfter = TPM_EVENT_LOG_SINK_BUFFER_SIZE * 2 + 1;
+
+  UT_ASSERT_STATUS_EQUAL (StreamLog (Location, Location + Log.LastEntry, NULL, &Xml, NULL, &EventCount), EFI_VOLUME_FULL);
+  UT_ASSERT_EQUAL (Xml.Writes, 3);
+  UT_ASSERT_TRUE (Xml.Size < Xml.FailAfter);
+  UT_ASSERT_TRUE (EventCount < Log.EventCount);
+
+  FreeOutput (&Xml);
+  FreeLog (&Log);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  TpmEventLogAudit streaming writer and run them.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      StreamTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&StreamTests, Framework, "TpmEventLog Stream Tests", "TpmEventLogAudit.Stream", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for TpmEventLog Stream Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (StreamTests, "Boot log streams to the same XML as the tree", "BootLog", StreamMatchesTreeForBootLog, NULL, NULL, NULL);
+  AddTestCase (StreamTests, "Final events table streams to the same XML as the tree", "FinalEvents", StreamMatchesTreeWithFinalEvents, NULL, NULL, NULL);
+  AddTestCase (StreamTests, "Large log streams to the same XML as the tree", "LargeLog", StreamMatchesTreeForLargeLog, NULL, NULL, NULL);
+  AddTestCase (StreamTests, "Event data too large for the tree streams", "HugeEvent", StreamHandlesEventTreeCannot, NULL, NULL, NULL);
+  AddTestCase (StreamTests, "Digest summary matches the log", "DigestSummary", DigestSummaryMatchesLog, NULL, NULL, NULL);
+  AddTestCase (StreamTests, "Write failure stops the walk", "WriteFailure", WriteFailureStopsWalk, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,123 @@
+/** @file -- TpmEventLogTestData.h
+Synthetic TCG2 crypto agile event log.  It was generated, not captured from a
+machine, to follow the layout Tcg2Dxe produces for a boot with a SHA1 and
+SHA256 bank: the Spec ID header event, StartupLocality, CRTM version,
+firmware blob, secure boot variables, separators for PCR 0-7 and the boot
+manager events up to ExitBootServices.  Digests are the real hashes of the
+generated event data.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef TPM_EVENT_LOG_TEST_DATA_H
+#define TPM_EVENT_LOG_TEST_DATA_H
+
+#define BOOT_EVENT_LOG_EVENT_COUNT        17   // Not counting the header event
+#define BOOT_EVENT_LOG_LAST_ENTRY_OFFSET  0x5CC
+
+STATIC CONST UINT8  mBootEventLog[] = {
+  0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00,
+  0x53, 0x70, 0x65, 0x63, 0x20, 0x49, 0x44, 0x20, 0x45, 0x76, 0x65, 0x6E, 0x74, 0x30, 0x33, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x02, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x14, 0x00,
+  0x0B, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,
+  0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x53, 0x74, 0x61,
+  0x72, 0x74, 0x75, 0x70, 0x4C, 0x6F, 0x63, 0x61, 0x6C, 0x69, 0x74, 0x79, 0x00, 0x03, 0x00, 0x00,
+  0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0xC1, 0xA7, 0x30, 0x7B,
+  0xE9, 0x36, 0x22, 0x30, 0xC9, 0x1E, 0x4F, 0xB2, 0x06, 0x68, 0x75, 0x2B, 0xD4, 0xA0, 0x48, 0xD2,
+  0x0B, 0x00, 0xD6, 0x98, 0xE7, 0x7C, 0x4A, 0x4C, 0x35, 0xC4, 0xA8, 0xA5, 0xA4, 0x63, 0x36, 0x13,
+  0xD5, 0xD0, 0x73, 0x19, 0xB6, 0x7C, 0x5C, 0x9D, 0x4F, 0x6D, 0x79, 0x2A, 0xAB, 0x6E, 0x06, 0xEE,
+  0xB8, 0xD9, 0x08, 0x00, 0x00, 0x00, 0x31, 0x00, 0x2E, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x08, 0x00, 0x00, 0x80, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0xEE, 0xCE, 0x72, 0x3B,
+  0x8A, 0x41, 0x1E, 0x8C, 0x53, 0xE7, 0xBF, 0x49, 0x51, 0x42, 0x34, 0xDA, 0x5D, 0x39, 0x42, 0x36,
+  0x0B, 0x00, 0xCC, 0x73, 0x21, 0xCC, 0xE5, 0xE4, 0x40, 0x9B, 0xD8, 0x07, 0x7D, 0x58, 0x42, 0x2E,
+  0x12, 0x14, 0x96, 0x90, 0x59, 0xBB, 0xD4, 0x0B, 0x4E, 0xEB, 0x0D, 0xE0, 0xA6, 0x42, 0xF4, 0x0F,
+  0x72, 0x82, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0xE0, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x80, 0x02, 0x00,
+  0x00, 0x00, 0x04, 0x00, 0xD4, 0xFD, 0xD1, 0xF1, 0x4D, 0x40, 0x41, 0x49, 0x4D, 0xEB, 0x8F, 0xC9,
+  0x90, 0xC4, 0x53, 0x43, 0xD2, 0x27, 0x7D, 0x08, 0x0B, 0x00, 0xCC, 0xFC, 0x4B, 0xB3, 0x28, 0x88,
+  0xA3, 0x45, 0xBC, 0x8A, 0xEA, 0xDA, 0xBA, 0x55, 0x2B, 0x62, 0x7D, 0x99, 0x34, 0x8C, 0x76, 0x76,
+  0x81, 0xAB, 0x31, 0x41, 0xF5, 0xB0, 0x1E, 0x40, 0xA4, 0x0E, 0x35, 0x00, 0x00, 0x00, 0x61, 0xDF,
+  0xE4, 0x8B, 0xCA, 0x93, 0xD2, 0x11, 0xAA, 0x0D, 0x00, 0xE0, 0x98, 0x03, 0x2B, 0x8C, 0x0A, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x53, 0x00,
+  0x65, 0x00, 0x63, 0x00, 0x75, 0x00, 0x72, 0x00, 0x65, 0x00, 0x42, 0x00, 0x6F, 0x00, 0x6F, 0x00,
+  0x74, 0x00, 0x01, 0x07, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x80, 0x02, 0x00, 0x00, 0x00, 0x04,
+  0x00, 0x9B, 0x13, 0x87, 0x30, 0x6E, 0xBB, 0x7F, 0xF8, 0xE7, 0x95, 0xE7, 0xBE, 0x77, 0x56, 0x36,
+  0x66, 0xBB, 0xF4, 0x51, 0x6E, 0x0B, 0x00, 0xDE, 0xA7, 0xB8, 0x0A, 0xB5, 0x3A, 0x3D, 0xAA, 0xA2,
+  0x4D, 0x5C, 0xC4, 0x6C, 0x64, 0xE1, 0xFA, 0x9F, 0xFD, 0x03, 0x73, 0x9F, 0x90, 0xAA, 0xDB, 0xD8,
+  0xC0, 0x86, 0x7C, 0x4A, 0x5B, 0x48, 0x90, 0x24, 0x00, 0x00, 0x00, 0x61, 0xDF, 0xE4, 0x8B, 0xCA,
+  0x93, 0xD2, 0x11, 0xAA, 0x0D, 0x00, 0xE0, 0x98, 0x03, 0x2B, 0x8C, 0x02, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0x00, 0x4B, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x90, 0x69, 0xCA,
+  0x78, 0xE7, 0x45, 0x0A, 0x28, 0x51, 0x73, 0x43, 0x1B, 0x3E, 0x52, 0xC5, 0xC2, 0x52, 0x99, 0xE4,
+  0x73, 0x0B, 0x00, 0xDF, 0x3F, 0x61, 0x98, 0x04, 0xA9, 0x2F, 0xDB, 0x40, 0x57, 0x19, 0x2D, 0xC4,
+  0x3D, 0xD7, 0x48, 0xEA, 0x77, 0x8A, 0xDC, 0x52, 0xBC, 0x49, 0x8C, 0xE8, 0x05, 0x24, 0xC0, 0x14,
+  0xB8, 0x11, 0x19, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x90, 0x69, 0xCA, 0x78, 0xE7, 0x45, 0x0A,
+  0x28, 0x51, 0x73, 0x43, 0x1B, 0x3E, 0x52, 0xC5, 0xC2, 0x52, 0x99, 0xE4, 0x73, 0x0B, 0x00, 0xDF,
+  0x3F, 0x61, 0x98, 0x04, 0xA9, 0x2F, 0xDB, 0x40, 0x57, 0x19, 0x2D, 0xC4, 0x3D, 0xD7, 0x48, 0xEA,
+  0x77, 0x8A, 0xDC, 0x52, 0xBC, 0x49, 0x8C, 0xE8, 0x05, 0x24, 0xC0, 0x14, 0xB8, 0x11, 0x19, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02,
+  0x00, 0x00, 0x00, 0x04, 0x00, 0x90, 0x69, 0xCA, 0x78, 0xE7, 0x45, 0x0A, 0x28, 0x51, 0x73, 0x43,
+  0x1B, 0x3E, 0x52, 0xC5, 0xC2, 0x52, 0x99, 0xE4, 0x73, 0x0B, 0x00, 0xDF, 0x3F, 0x61, 0x98, 0x04,
+  0xA9, 0x2F, 0xDB, 0x40, 0x57, 0x19, 0x2D, 0xC4, 0x3D, 0xD7, 0x48, 0xEA, 0x77, 0x8A, 0xDC, 0x52,
+  0xBC, 0x49, 0x8C, 0xE8, 0x05, 0x24, 0xC0, 0x14, 0xB8, 0x11, 0x19, 0x04, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04,
+  0x00, 0x90, 0x69, 0xCA, 0x78, 0xE7, 0x45, 0x0A, 0x28, 0x51, 0x73, 0x43, 0x1B, 0x3E, 0x52, 0xC5,
+  0xC2, 0x52, 0x99, 0xE4, 0x73, 0x0B, 0x00, 0xDF, 0x3F, 0x61, 0x98, 0x04, 0xA9, 0x2F, 0xDB, 0x40,
+  0x57, 0x19, 0x2D, 0xC4, 0x3D, 0xD7, 0x48, 0xEA, 0x77, 0x8A, 0xDC, 0x52, 0xBC, 0x49, 0x8C, 0xE8,
+  0x05, 0x24, 0xC0, 0x14, 0xB8, 0x11, 0x19, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x90, 0x69, 0xCA,
+  0x78, 0xE7, 0x45, 0x0A, 0x28, 0x51, 0x73, 0x43, 0x1B, 0x3E, 0x52, 0xC5, 0xC2, 0x52, 0x99, 0xE4,
+  0x73, 0x0B, 0x00, 0xDF, 0x3F, 0x61, 0x98, 0x04, 0xA9, 0x2F, 0xDB, 0x40, 0x57, 0x19, 0x2D, 0xC4,
+  0x3D, 0xD7, 0x48, 0xEA, 0x77, 0x8A, 0xDC, 0x52, 0xBC, 0x49, 0x8C, 0xE8, 0x05, 0x24, 0xC0, 0x14,
+  0xB8, 0x11, 0x19, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x90, 0x69, 0xCA, 0x78, 0xE7, 0x45, 0x0A,
+  0x28, 0x51, 0x73, 0x43, 0x1B, 0x3E, 0x52, 0xC5, 0xC2, 0x52, 0x99, 0xE4, 0x73, 0x0B, 0x00, 0xDF,
+  0x3F, 0x61, 0x98, 0x04, 0xA9, 0x2F, 0xDB, 0x40, 0x57, 0x19, 0x2D, 0xC4, 0x3D, 0xD7, 0x48, 0xEA,
+  0x77, 0x8A, 0xDC, 0x52, 0xBC, 0x49, 0x8C, 0xE8, 0x05, 0x24, 0xC0, 0x14, 0xB8, 0x11, 0x19, 0x04,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02,
+  0x00, 0x00, 0x00, 0x04, 0x00, 0x90, 0x69, 0xCA, 0x78, 0xE7, 0x45, 0x0A, 0x28, 0x51, 0x73, 0x43,
+  0x1B, 0x3E, 0x52, 0xC5, 0xC2, 0x52, 0x99, 0xE4, 0x73, 0x0B, 0x00, 0xDF, 0x3F, 0x61, 0x98, 0x04,
+  0xA9, 0x2F, 0xDB, 0x40, 0x57, 0x19, 0x2D, 0xC4, 0x3D, 0xD7, 0x48, 0xEA, 0x77, 0x8A, 0xDC, 0x52,
+  0xBC, 0x49, 0x8C, 0xE8, 0x05, 0x24, 0xC0, 0x14, 0xB8, 0x11, 0x19, 0x04, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x04,
+  0x00, 0x90, 0x69, 0xCA, 0x78, 0xE7, 0x45, 0x0A, 0x28, 0x51, 0x73, 0x43, 0x1B, 0x3E, 0x52, 0xC5,
+  0xC2, 0x52, 0x99, 0xE4, 0x73, 0x0B, 0x00, 0xDF, 0x3F, 0x61, 0x98, 0x04, 0xA9, 0x2F, 0xDB, 0x40,
+  0x57, 0x19, 0x2D, 0xC4, 0x3D, 0xD7, 0x48, 0xEA, 0x77, 0x8A, 0xDC, 0x52, 0xBC, 0x49, 0x8C, 0xE8,
+  0x05, 0x24, 0xC0, 0x14, 0xB8, 0x11, 0x19, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04,
+  0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x80, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0xB0, 0x0A, 0x7B,
+  0x4D, 0xD7, 0xF5, 0x6A, 0xDF, 0xE0, 0x48, 0x3A, 0x1A, 0xB8, 0xF0, 0xFA, 0xE4, 0x6E, 0x80, 0x9B,
+  0x56, 0x0B, 0x00, 0x76, 0x57, 0xDD, 0x95, 0x11, 0xE1, 0xF2, 0xF5, 0xE8, 0xFB, 0x51, 0x6B, 0x39,
+  0xA1, 0x6B, 0x52, 0x02, 0x30, 0x3E, 0xDD, 0x2A, 0x33, 0x31, 0x12, 0xE7, 0xFF, 0xF6, 0x0B, 0x66,
+  0xBC, 0xB5, 0x09, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7E, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xA0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x80, 0x02,
+  0x00, 0x00, 0x00, 0x04, 0x00, 0xCD, 0x0F, 0xDB, 0x45, 0x31, 0xA6, 0xEC, 0x41, 0xBE, 0x27, 0x53,
+  0xBA, 0x04, 0x26, 0x37, 0xD6, 0xE5, 0xF7, 0xF2, 0x56, 0x0B, 0x00, 0x3D, 0x67, 0x72, 0xB4, 0xF8,
+  0x4E, 0xD4, 0x75, 0x95, 0xD7, 0x2A, 0x2C, 0x4C, 0x5F, 0xFD, 0x15, 0xF5, 0xBB, 0x72, 0xC7, 0x50,
+  0x7F, 0xE2, 0x6F, 0x2A, 0xAE, 0xE2, 0xC6, 0x9D, 0x56, 0x33, 0xBA, 0x28, 0x00, 0x00, 0x00, 0x43,
+  0x61, 0x6C, 0x6C, 0x69, 0x6E, 0x67, 0x20, 0x45, 0x46, 0x49, 0x20, 0x41, 0x70, 0x70, 0x6C, 0x69,
+  0x63, 0x61, 0x74, 0x69, 0x6F, 0x6E, 0x20, 0x66, 0x72, 0x6F, 0x6D, 0x20, 0x42, 0x6F, 0x6F, 0x74,
+  0x20, 0x4F, 0x70, 0x74, 0x69, 0x6F, 0x6E, 0x05, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x80, 0x02,
+  0x00, 0x00, 0x00, 0x04, 0x00, 0x44, 0x3A, 0x6B, 0x7B, 0x82, 0xB7, 0xAF, 0x56, 0x4F, 0x2E, 0x39,
+  0x3C, 0xD9, 0xD5, 0xA3, 0x88, 0xB7, 0xFA, 0x4A, 0x98, 0x0B, 0x00, 0xD8, 0x04, 0x3D, 0x6B, 0x7B,
+  0x85, 0xAD, 0x35, 0x8E, 0xB3, 0xB6, 0xAE, 0x6A, 0x87, 0x3A, 0xB7, 0xEF, 0x23, 0xA2, 0x63, 0x52,
+  0xC5, 0xDC, 0x4F, 0xAA, 0x5A, 0xEE, 0xDA, 0xCF, 0x5E, 0xB4, 0x1B, 0x1D, 0x00, 0x00, 0x00, 0x45,
+  0x78, 0x69, 0x74, 0x20, 0x42, 0x6F, 0x6F, 0x74, 0x20, 0x53, 0x65, 0x72, 0x76, 0x69, 0x63, 0x65,
+  0x73, 0x20, 0x49, 0x6E, 0x76, 0x6F, 0x63, 0x61, 0x74, 0x69, 0x6F, 0x6E, 0x05, 0x00, 0x00, 0x00,
+  0x07, 0x00, 0x00, 0x80, 0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x47, 0x55, 0x45, 0xDD, 0xC9, 0x78,
+  0xD7, 0xBF, 0xD0, 0x36, 0xFA, 0xCC, 0x7E, 0x2E, 0x98, 0x7F, 0x48, 0x18, 0x9F, 0x0D, 0x0B, 0x00,
+  0xB5, 0x4F, 0x75, 0x42, 0xCB, 0xD8, 0x72, 0xA8, 0x1A, 0x9D, 0x9D, 0xEA, 0x83, 0x9B, 0x2B, 0x8D,
+  0x74, 0x7C, 0x7E, 0xBD, 0x5E, 0xA6, 0x61, 0x5C, 0x40, 0xF4, 0x2F, 0x44, 0xA6, 0xDB, 0xEB, 0xA0,
+  0x28, 0x00, 0x00, 0x00, 0x45, 0x78, 0x69, 0x74, 0x20, 0x42, 0x6F, 0x6F, 0x74, 0x20, 0x53, 0x65,
+  0x72, 0x76, 0x69, 0x63, 0x65, 0x73, 0x20, 0x52, 0x65, 0x74, 0x75, 0x72, 0x6E, 0x65, 0x64, 0x20,
+  0x77, 0x69, 0x74, 0x68, 0x20, 0x53, 0x75, 0x63, 0x63, 0x65, 0x73, 0x73
+};
+
+#endif // TPM_EVENT_LOG_TEST_DATA_H
@@ -17,136 +17,97 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Protocol/Tcg2Protocol.h>
 #include <IndustryStandard/UefiTcgPlatform.h>
 #include "TpmEventLogXml.h"
+#include "TpmEventLogStream.h"
 
-/**
-  Add Header Event to XML List
+#define XML_LOG_FILE_NAME     L"TpmEventLogAudit_manifest.xml"
+#define DIGEST_LOG_FILE_NAME  L"TpmEventLogAudit_digests.bin"
 
-  @param[in]  EventHdr     TCG PCR event structure.
-**/
-EFI_STATUS
-AddHeaderEvent (
-  IN XmlNode            *RootNode,
-  IN TCG_PCR_EVENT_HDR  *EventHdr
-  )
-{
-  if (New_NodeInList (RootNode, (UINTN)EventHdr->PCRIndex, (UINTN)EventHdr->EventType, EventHdr->EventSize, (UINT8 *)(EventHdr + 1), 0, NULL) == NULL) {
-    DEBUG ((DEBUG_ERROR, "Failed to create new Header Node.  Event Type: %s PcrIndex: %g\n", EventHdr->EventType, EventHdr->PCRIndex));
-    return EFI_DEVICE_ERROR;
-  }
-
-  return EFI_SUCCESS;
-}
+STATIC CONST SHELL_PARAM_ITEM  ParamList[] = {
+  { L"-h",       TypeFlag },
+  { L"-tree",    TypeFlag },
+  { L"-digests", TypeFlag },
+  { NULL,        TypeMax  }
+};
 
 /**
-  This function get size of TCG_EfiSpecIDEventStruct.
-  NOTE: Copied from Tcg2Dxe driver in UDK.
-
-  @param[in]  TcgEfiSpecIdEventStruct     A pointer to TCG_EfiSpecIDEventStruct.
+  Print the usage of the app.
 **/
-UINTN
-GetTcgEfiSpecIdEventStructSize (
-  IN TCG_EfiSpecIDEventStruct  *TcgEfiSpecIdEventStruct
+STATIC
+VOID
+PrintUsage (
+  VOID
   )
 {
-  TCG_EfiSpecIdEventAlgorithmSize  *DigestSize;
-  UINT8                            *VendorInfoSize;
-  UINT32                           NumberOfAlgorithms;
-
-  CopyMem (&NumberOfAlgorithms, TcgEfiSpecIdEventStruct + 1, sizeof (NumberOfAlgorithms));
-
-  DigestSize     = (TCG_EfiSpecIdEventAlgorithmSize *)((UINT8 *)TcgEfiSpecIdEventStruct + sizeof (*TcgEfiSpecIdEventStruct) + sizeof (NumberOfAlgorithms));
-  VendorInfoSize = (UINT8 *)&DigestSize[NumberOfAlgorithms];
-  return sizeof (TCG_EfiSpecIDEventStruct) + sizeof (UINT32) + (NumberOfAlgorithms * sizeof (TCG_EfiSpecIdEventAlgorithmSize)) + sizeof (UINT8) + (*VendorInfoSize);
+  Print (L"TpmEventLogAudit [-h] [-tree] [-digests]\n");
+  Print (L"  Writes the TPM event log to %s.\n", XML_LOG_FILE_NAME);
+  Print (L"  -h        Print this help.\n");
+  Print (L"  -tree     Build the whole XML tree in memory before writing it instead of\n");
+  Print (L"            streaming one event at a time.  Output is identical.\n");
+  Print (L"  -digests  Also write a binary summary of every event digest to %s.\n", DIGEST_LOG_FILE_NAME);
+  Print (L"            Not supported with -tree.\n");
 }
 
 /**
-  Add Event to Xml List
+  Open an output file for writing, replacing any existing file.
 
-  @param[in]  TcgPcrEvent2     TCG PCR event 2 structure.
+  @param[in]  FileName    Name of the file.
+  @param[out] FileHandle  Handle of the opened file.
 **/
+STATIC
 EFI_STATUS
-AddEvent (
-  IN XmlNode         *RootNode,
-  IN TCG_PCR_EVENT2  *TcgPcrEvent2
+OpenOutputFile (
+  IN  CHAR16             *FileName,
+  OUT SHELL_FILE_HANDLE  *FileHandle
   )
 {
-  UINT32         DigestIndex;
-  UINT32         DigestCount;
-  TPMI_ALG_HASH  HashAlgo;
-  UINT32         DigestSize;
-  UINT8          *DigestBuffer;
-  UINT32         EventSize;
-  UINT8          *EventBuffer;
-
-  DigestCount  = TcgPcrEvent2->Digest.count;
-  HashAlgo     = TcgPcrEvent2->Digest.digests[0].hashAlg;
-  DigestBuffer = (UINT8 *)&TcgPcrEvent2->Digest.digests[0].digest;
-  for (DigestIndex = 0; DigestIndex < DigestCount; DigestIndex++) {
-    DigestSize = GetHashSizeFromAlgo (HashAlgo);
-    //
-    // Prepare next
-    //
-    CopyMem (&HashAlgo, DigestBuffer + DigestSize, sizeof (TPMI_ALG_HASH));
-    DigestBuffer = DigestBuffer + DigestSize + sizeof (TPMI_ALG_HASH);
-  }
-
-  DigestBuffer = DigestBuffer - sizeof (TPMI_ALG_HASH);
+  EFI_STATUS  Status;
 
-  CopyMem (&EventSize, DigestBuffer, sizeof (TcgPcrEvent2->EventSize));
-  EventBuffer = DigestBuffer + sizeof (TcgPcrEvent2->EventSize);
+  Status = ShellOpenFileByName (FileName, FileHandle, EFI_FILE_MODE_CREATE | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_READ, 0);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed to open %s file for create. Status = %r\n", FileName, Status));
+    return Status;
+  }
 
-  if (New_NodeInList (RootNode, (UINTN)TcgPcrEvent2->PCRIndex, (UINTN)TcgPcrEvent2->EventType, EventSize, EventBuffer, TcgPcrEvent2->Digest.count, &TcgPcrEvent2->Digest) == NULL) {
-    DEBUG ((DEBUG_ERROR, "Failed to create new Event Node.  Event Type: %s PcrIndex: %g\n", TcgPcrEvent2->EventType, TcgPcrEvent2->PCRIndex));
-    return EFI_DEVICE_ERROR;
+  // Workaround start - delete the file if it exists and then reopen it to fix an issue where file data may be corrupted at the end
+  ShellDeleteFile (FileHandle);
+  Status = ShellOpenFileByName (FileName, FileHandle, EFI_FILE_MODE_CREATE | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_READ, 0);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed to open %s file for create. Status = %r\n", FileName, Status));
   }
 
-  return EFI_SUCCESS;
+  // Workaround end
+
+  return Status;
 }
 
 /**
-  This function returns size of TCG PCR event 2.
-  NOTE: Copied from Tcg2Dxe driver in UDK.
-
-  @param[in]  TcgPcrEvent2     TCG PCR event 2 structure.
-
-  @return size of TCG PCR event 2.
+  TPM_EVENT_LOG_SINK_WRITE that appends to a shell file.  Context is the
+  SHELL_FILE_HANDLE.
 **/
-UINTN
-GetPcrEvent2Size (
-  IN TCG_PCR_EVENT2  *TcgPcrEvent2
+STATIC
+EFI_STATUS
+EFIAPI
+ShellFileSinkWrite (
+  IN VOID        *Context,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Size
   )
 {
-  UINT32         DigestIndex;
-  UINT32         DigestCount;
-  TPMI_ALG_HASH  HashAlgo;
-  UINT32         DigestSize;
-  UINT8          *DigestBuffer;
-  UINT32         EventSize;
-  UINT8          *EventBuffer;
-
-  DigestCount  = TcgPcrEvent2->Digest.count;
-  HashAlgo     = TcgPcrEvent2->Digest.digests[0].hashAlg;
-  DigestBuffer = (UINT8 *)&TcgPcrEvent2->Digest.digests[0].digest;
-  for (DigestIndex = 0; DigestIndex < DigestCount; DigestIndex++) {
-    DigestSize = GetHashSizeFromAlgo (HashAlgo);
-    //
-    // Prepare next
-    //
-    CopyMem (&HashAlgo, DigestBuffer + DigestSize, sizeof (TPMI_ALG_HASH));
-    DigestBuffer = DigestBuffer + DigestSize + sizeof (TPMI_ALG_HASH);
-  }
+  EFI_STATUS  Status;
+  UINTN       Written;
 
-  DigestBuffer = DigestBuffer - sizeof (TPMI_ALG_HASH);
-
-  CopyMem (&EventSize, DigestBuffer, sizeof (TcgPcrEvent2->EventSize));
-  EventBuffer = DigestBuffer + sizeof (TcgPcrEvent2->EventSize);
+  Written = Size;
+  Status  = ShellWriteFile ((SHELL_FILE_HANDLE)Context, &Written, (VOID *)Buffer);
+  if (!EFI_ERROR (Status) && (Written != Size)) {
+    Status = EFI_VOLUME_FULL;
+  }
 
-  return (UINTN)EventBuffer + EventSize - (UINTN)TcgPcrEvent2;
+  return Status;
 }
 
 /**
-  This function dump event log.
-  NOTE: Copied from Tcg2Dxe driver in UDK.
+  This function dump event log by building the whole XML tree and then
+  writing it out.
 
   @param[in]  EventLogFormat     The type of the event log for which the information is requested.
   @param[in]  EventLogLocation   A pointer to the memory address of the event log.
@@ -162,16 +123,11 @@ DumpEventLog (
   IN EFI_TCG2_FINAL_EVENTS_TABLE  *FinalEventsTable
   )
 {
-  TCG_PCR_EVENT_HDR         *EventHdr;
-  TCG_PCR_EVENT2            *TcgPcrEvent2;
-  TCG_EfiSpecIDEventStruct  *TcgEfiSpecIdEventStruct;
-  UINTN                     NumberOfEvents;
-  XmlNode                   *List;
-  CHAR16                    LogFileName[] = L"TpmEventLogAudit_manifest.xml";
-  SHELL_FILE_HANDLE         FileHandle;
-  UINTN                     StringSize = 0;
-  CHAR8                     *XmlString = NULL;
-  EFI_STATUS                Status;
+  XmlNode            *List = NULL;
+  SHELL_FILE_HANDLE  FileHandle;
+  UINTN              StringSize = 0;
+  CHAR8              *XmlString = NULL;
+  EFI_STATUS         Status;
 
   switch (EventLogFormat) {
     case EFI_TCG2_EVENT_LOG_FORMAT_TCG_2:
@@ -182,40 +138,12 @@ DumpEventLog (
         goto Exit;
       }
 
-      EventHdr = (TCG_PCR_EVENT_HDR *)(UINTN)EventLogLocation;
-      Status   = AddHeaderEvent (List, EventHdr);
+      Status = TpmEventLogWalk (EventLogLocation, EventLogLastEntry, FinalEventsTable, AddEventToNodeList, List);
       if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "AddHeaderEvent failed.  %r\n", Status));
+        DEBUG ((DEBUG_ERROR, "AddEvent failed.  %r\n", Status));
         goto Exit;
       }
 
-      TcgEfiSpecIdEventStruct = (TCG_EfiSpecIDEventStruct *)(EventHdr + 1);
-      TcgPcrEvent2            = (TCG_PCR_EVENT2 *)((UINTN)TcgEfiSpecIdEventStruct + GetTcgEfiSpecIdEventStructSize (TcgEfiSpecIdEventStruct));
-      while ((UINTN)TcgPcrEvent2 <= EventLogLastEntry) {
-        Status = AddEvent (List, TcgPcrEvent2);
-        if (EFI_ERROR (Status)) {
-          DEBUG ((DEBUG_ERROR, "AddEvent failed.  %r\n", Status));
-          goto Exit;
-        }
-
-        TcgPcrEvent2 = (TCG_PCR_EVENT2 *)((UINTN)TcgPcrEvent2 + GetPcrEvent2Size (TcgPcrEvent2));
-      }
-
-      if (FinalEventsTable == NULL) {
-        DEBUG ((DEBUG_ERROR, "FinalEventsTable: NOT FOUND.\n"));
-      } else {
-        TcgPcrEvent2 = (TCG_PCR_EVENT2 *)(UINTN)(FinalEventsTable + 1);
-        for (NumberOfEvents = 0; NumberOfEvents < FinalEventsTable->NumberOfEvents; NumberOfEvents++) {
-          Status = AddEvent (List, TcgPcrEvent2);
-          if (EFI_ERROR (Status)) {
-            DEBUG ((DEBUG_ERROR, "AddEvent failed.  %r\n", Status));
-            goto Exit;
-          }
-
-          TcgPcrEvent2 = (TCG_PCR_EVENT2 *)((UINTN)TcgPcrEvent2 + GetPcrEvent2Size (TcgPcrEvent2));
-        }
-      }
-
       // Write XML
       Status = XmlTreeToString (List, FALSE, &StringSize, &XmlString);
       if (EFI_ERROR (Status)) {
@@ -234,26 +162,15 @@ DumpEventLog (
       //
       StringSize--;
 
-      Status = ShellOpenFileByName (LogFileName, &FileHandle, EFI_FILE_MODE_CREATE | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_READ, 0);
+      Status = OpenOutputFile (XML_LOG_FILE_NAME, &FileHandle);
       if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "Failed to open %s file for create. Status = %r\n", LogFileName, Status));
         goto Exit;
-      } else {
-        // Workaround start - delete the file if it exists and then reopen it to fix an issue where file data may be corrupted at the end
-        ShellDeleteFile (&FileHandle);
-        Status = ShellOpenFileByName (LogFileName, &FileHandle, EFI_FILE_MODE_CREATE | EFI_FILE_MODE_WRITE | EFI_FILE_MODE_READ, 0);
-        if (EFI_ERROR (Status)) {
-          DEBUG ((DEBUG_ERROR, "Failed to open %s file for create. Status = %r\n", LogFileName, Status));
-          goto Exit;
-        }
-
-        // Workaround end
-
-        ShellPrintEx (-1, -1, L"Writing XML to file %s\n", LogFileName);
-        ShellWriteFile (FileHandle, &StringSize, XmlString);
-        ShellCloseFile (&FileHandle);
       }
 
+      ShellPrintEx (-1, -1, L"Writing XML to file %s\n", XML_LOG_FILE_NAME);
+      ShellWriteFile (FileHandle, &StringSize, XmlString);
+      ShellCloseFile (&FileHandle);
+
       // success
       Status = EFI_SUCCESS;
 
@@ -276,6 +193,106 @@ Exit:
   return Status & 0x7FFFFFFFFFFFFF;
 }
 
+/**
+  This function streams the event log to the XML file one event at a time,
+  so memory use does not depend on the size of the log.
+
+  @param[in]  EventLogFormat     The type of the event log for which the information is requested.
+  @param[in]  EventLogLocation   A pointer to the memory address of the event log.
+  @param[in]  EventLogLastEntry  If the Event Log contains more than one entry, this is a pointer to the
+                                 address of the start of the last entry in the event log in memory.
+  @param[in]  FinalEventsTable   A pointer to the memory address of the final event table.
+  @param[in]  WriteDigests       Also write the binary digest summary.
+**/
+EFI_STATUS
+StreamEventLog (
+  IN EFI_TCG2_EVENT_LOG_FORMAT    EventLogFormat,
+  IN EFI_PHYSICAL_ADDRESS         EventLogLocation,
+  IN EFI_PHYSICAL_ADDRESS         EventLogLastEntry,
+  IN EFI_TCG2_FINAL_EVENTS_TABLE  *FinalEventsTable,
+  IN BOOLEAN                      WriteDigests
+  )
+{
+  TPM_EVENT_LOG_STREAM  Stream;
+  SHELL_FILE_HANDLE     XmlHandle     = NULL;
+  SHELL_FILE_HANDLE     SummaryHandle = NULL;
+  EFI_STATUS            Status;
+
+  if (EventLogFormat != EFI_TCG2_EVENT_LOG_FORMAT_TCG_2) {
+    return EFI_UNSUPPORTED;
+  }
+
+  ZeroMem (&Stream, sizeof (Stream));
+  Stream.Xml = AllocatePool (sizeof (TPM_EVENT_LOG_SINK));
+  if (Stream.Xml == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  Status = OpenOutputFile (XML_LOG_FILE_NAME, &XmlHandle);
+  if (EFI_ERROR (Status)) {
+    XmlHandle = NULL;
+    goto Exit;
+  }
+
+  TpmEventLogSinkInit (Stream.Xml, ShellFileSinkWrite, XmlHandle);
+
+  if (WriteDigests) {
+    Stream.Summary = AllocatePool (sizeof (TPM_EVENT_LOG_SINK));
+    if (Stream.Summary == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Exit;
+    }
+
+    Status = OpenOutputFile (DIGEST_LOG_FILE_NAME, &SummaryHandle);
+    if (EFI_ERROR (Status)) {
+      SummaryHandle = NULL;
+      goto Exit;
+    }
+
+    TpmEventLogSinkInit (Stream.Summary, ShellFileSinkWrite, SummaryHandle);
+  }
+
+  ShellPrintEx (-1, -1, L"Writing XML to file %s\n", XML_LOG_FILE_NAME);
+  Status = TpmEventLogStreamBegin (&Stream);
+  if (!EFI_ERROR (Status)) {
+    Status = TpmEventLogWalk (EventLogLocation, EventLogLastEntry, FinalEventsTable, TpmEventLogStreamEvent, &Stream);
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = TpmEventLogStreamEnd (&Stream);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Streaming the event log failed after %d events.  %r\n", Stream.EventCount, Status));
+    goto Exit;
+  }
+
+  ShellPrintEx (-1, -1, L"Wrote %d events, %ld bytes of XML\n", Stream.EventCount, Stream.Xml->Total);
+  if (Stream.Summary != NULL) {
+    ShellPrintEx (-1, -1, L"Wrote digest summary to file %s\n", DIGEST_LOG_FILE_NAME);
+  }
+
+Exit:
+  if (XmlHandle != NULL) {
+    ShellCloseFile (&XmlHandle);
+  }
+
+  if (SummaryHandle != NULL) {
+    ShellCloseFile (&SummaryHandle);
+  }
+
+  if (Stream.Xml != NULL) {
+    FreePool (Stream.Xml);
+  }
+
+  if (Stream.Summary != NULL) {
+    FreePool (Stream.Summary);
+  }
+
+  return Status & 0x7FFFFFFFFFFFFF;
+}
+
 /**
   Test entry point.
 
@@ -297,6 +314,10 @@ UefiTestApp (
   EFI_PHYSICAL_ADDRESS       EventLogLocation, EventLogLastEntry;
   BOOLEAN                    EventLogTruncated;
   EFI_TCG2_EVENT_LOG_FORMAT  RequestedFormat = EFI_TCG2_EVENT_LOG_FORMAT_TCG_2;
+  LIST_ENTRY                 *Package;
+  CHAR16                     *ProblemParam;
+  BOOLEAN                    UseTree;
+  BOOLEAN                    WriteDigests;
 
   //
   // Initialize the shell lib (we must be in non-auto-init...)
@@ -308,6 +329,34 @@ UefiTestApp (
     return Status;
   }
 
+  Package = NULL;
+  Status  = ShellCommandLineParse (ParamList, &Package, &ProblemParam, FALSE);
+  if (EFI_ERROR (Status)) {
+    Print (L"Invalid parameter %s\n", ProblemParam != NULL ? ProblemParam : L"");
+    if (ProblemParam != NULL) {
+      FreePool (ProblemParam);
+    }
+
+    PrintUsage ();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-h")) {
+    PrintUsage ();
+    ShellCommandLineFreeVarList (Package);
+    return EFI_SUCCESS;
+  }
+
+  UseTree      = ShellCommandLineGetFlag (Package, L"-tree");
+  WriteDigests = ShellCommandLineGetFlag (Package, L"-digests");
+  ShellCommandLineFreeVarList (Package);
+
+  if (UseTree && WriteDigests) {
+    Print (L"-digests can not be used with -tree\n");
+    PrintUsage ();
+    return EFI_INVALID_PARAMETER;
+  }
+
   //
   // Let's locate the protocol.
   //
@@ -332,7 +381,11 @@ UefiTestApp (
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "Failed to retrieve the event log.  %r\n", Status));
     } else {
-      Status = DumpEventLog (RequestedFormat, EventLogLocation, EventLogLastEntry, NULL);
+      if (UseTree) {
+        Status = DumpEventLog (RequestedFormat, EventLogLocation, EventLogLastEntry, NULL);
+      } else {
+        Status = StreamEventLog (RequestedFormat, EventLogLocation, EventLogLastEntry, NULL, WriteDigests);
+      }
     }
   }
 
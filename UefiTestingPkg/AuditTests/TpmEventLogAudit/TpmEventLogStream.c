@@ -0,0 +1,525 @@
+/** @file -- TpmEventLogStream.c
+Single pass walker for the TCG2 crypto agile event log and a streaming writer
+that emits the TpmEventLogAudit XML format one event at a time.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PrintLib.h>
+#include <Library/Tpm2CommandLib.h>
+#include "TpmEventLogStream.h"
+#include "TpmEventLogXml.h"
+
+//
+// Must match what XmlTreeToString writes for LIST_XML_TEMPLATE.
+//
+#define STREAM_XML_DECLARATION  "<?xml version=\"1.0\" encoding=\"utf-8\"?>"
+
+// Large enough for a decimal UINT64 and its terminator
+#define DECIMAL_STRING_SIZE  (24)
+
+STATIC CONST CHAR8  mHexDigits[] = "0123456789ABCDEF";
+
+/**
+  Initialize a sink.
+
+  @param[out] Sink      Sink to initialize.
+  @param[in]  Write     Callback that receives each full or flushed buffer.
+  @param[in]  Context   Passed to Write.
+**/
+VOID
+EFIAPI
+TpmEventLogSinkInit (
+  OUT TPM_EVENT_LOG_SINK        *Sink,
+  IN  TPM_EVENT_LOG_SINK_WRITE  Write,
+  IN  VOID                      *Context
+  )
+{
+  Sink->Write   = Write;
+  Sink->Context = Context;
+  Sink->Status  = EFI_SUCCESS;
+  Sink->Used    = 0;
+  Sink->Total   = 0;
+}
+
+/**
+  Pass any buffered bytes to the write callback.
+
+  @param[in,out]  Sink  Sink to flush.
+
+  @return The first error the sink ran into, or EFI_SUCCESS.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogSinkFlush (
+  IN OUT TPM_EVENT_LOG_SINK  *Sink
+  )
+{
+  EFI_STATUS  Status;
+
+  if (EFI_ERROR (Sink->Status) || (Sink->Used == 0)) {
+    return Sink->Status;
+  }
+
+  Status = Sink->Write (Sink->Context, Sink->Buffer, Sink->Used);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Write of 0x%X bytes failed.  Status %r\n", __FUNCTION__, Sink->Used, Status));
+    Sink->Status = Status;
+    return Status;
+  }
+
+  Sink->Total += Sink->Used;
+  Sink->Used   = 0;
+  return EFI_SUCCESS;
+}
+
+/**
+  Append bytes to a sink, flushing whenever the buffer fills.
+**/
+STATIC
+VOID
+SinkAppend (
+  IN OUT TPM_EVENT_LOG_SINK  *Sink,
+  IN CONST VOID              *Data,
+  IN UINTN                   Size
+  )
+{
+  CONST UINT8  *Bytes;
+  UINTN        Chunk;
+
+  Bytes = (CONST UINT8 *)Data;
+  while ((Size > 0) && !EFI_ERROR (Sink->Status)) {
+    if (Sink->Used == sizeof (Sink->Buffer)) {
+      TpmEventLogSinkFlush (Sink);
+      continue;
+    }
+
+    Chunk = MIN (Size, sizeof (Sink->Buffer) - Sink->Used);
+    CopyMem (&Sink->Buffer[Sink->Used], Bytes, Chunk);
+    Sink->Used += Chunk;
+    Bytes      += Chunk;
+    Size       -= Chunk;
+  }
+}
+
+/**
+  Append a null terminated ascii string without its terminator.
+**/
+STATIC
+VOID
+SinkAppendString (
+  IN OUT TPM_EVENT_LOG_SINK  *Sink,
+  IN CONST CHAR8             *String
+  )
+{
+  SinkAppend (Sink, String, AsciiStrLen (String));
+}
+
+/**
+  Append Value in decimal, the same way New_NodeInList formats it.
+**/
+STATIC
+VOID
+SinkAppendDecimal (
+  IN OUT TPM_EVENT_LOG_SINK  *Sink,
+  IN UINTN                   Value
+  )
+{
+  CHAR8  String[DECIMAL_STRING_SIZE];
+
+  String[0] = '\0';
+  AsciiValueToStringS (String, sizeof (String), 0, (INT64)Value, DECIMAL_STRING_SIZE - 1);
+  SinkAppendString (Sink, String);
+}
+
+/**
+  Append Size bytes as two upper case hex digits each.  Digits are written
+  straight into the sink buffer so large event data is never staged.
+**/
+STATIC
+VOID
+SinkAppendHex (
+  IN OUT TPM_EVENT_LOG_SINK  *Sink,
+  IN CONST UINT8             *Data,
+  IN UINTN                   Size
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; (Index < Size) && !EFI_ERROR (Sink->Status); Index++) {
+    if (sizeof (Sink->Buffer) - Sink->Used < 2) {
+      TpmEventLogSinkFlush (Sink);
+      if (EFI_ERROR (Sink->Status)) {
+        break;
+      }
+    }
+
+    Sink->Buffer[Sink->Used++] = mHexDigits[Data[Index] >> 4];
+    Sink->Buffer[Sink->Used++] = mHexDigits[Data[Index] & 0xF];
+  }
+}
+
+/**
+  Append <Name>Value</Name> for a decimal value.
+**/
+STATIC
+VOID
+SinkAppendDecimalElement (
+  IN OUT TPM_EVENT_LOG_SINK  *Sink,
+  IN CONST CHAR8             *Name,
+  IN UINTN                   Value
+  )
+{
+  SinkAppendString (Sink, "<");
+  SinkAppendString (Sink, Name);
+  SinkAppendString (Sink, ">");
+  SinkAppendDecimal (Sink, Value);
+  SinkAppendString (Sink, "</");
+  SinkAppendString (Sink, Name);
+  SinkAppendString (Sink, ">");
+}
+
+/**
+  Append an element holding hex data.  Like XmlTreeToString an element with no
+  value and no children uses the empty element notation.
+**/
+STATIC
+VOID
+SinkAppendHexElement (
+  IN OUT TPM_EVENT_LOG_SINK  *Sink,
+  IN CONST CHAR8             *Name,
+  IN CONST CHAR8             *Attributes OPTIONAL,
+  IN CONST UINT8             *Data,
+  IN UINTN                   Size
+  )
+{
+  SinkAppendString (Sink, "<");
+  SinkAppendString (Sink, Name);
+  if (Attributes != NULL) {
+    SinkAppendString (Sink, Attributes);
+  }
+
+  if (Size == 0) {
+    SinkAppendString (Sink, " />");
+    return;
+  }
+
+  SinkAppendString (Sink, ">");
+  SinkAppendHex (Sink, Data, Size);
+  SinkAppendString (Sink, "</");
+  SinkAppendString (Sink, Name);
+  SinkAppendString (Sink, ">");
+}
+
+/**
+  Find the event data of a crypto agile event.
+
+  @param[in]  TcgPcrEvent2   TCG PCR event 2 structure.
+  @param[out] EventSize      Size of the event data.
+  @param[out] EventBuffer    Start of the event data.
+
+  @return Size of the whole TCG PCR event 2.
+**/
+STATIC
+UINTN
+ParsePcrEvent2 (
+  IN  TCG_PCR_EVENT2  *TcgPcrEvent2,
+  OUT UINT32          *EventSize,
+  OUT UINT8           **EventBuffer
+  )
+{
+  UINT32         DigestIndex;
+  UINT32         DigestCount;
+  TPMI_ALG_HASH  HashAlgo;
+  UINT32         DigestSize;
+  UINT8          *DigestBuffer;
+
+  DigestCount  = TcgPcrEvent2->Digest.count;
+  HashAlgo     = TcgPcrEvent2->Digest.digests[0].hashAlg;
+  DigestBuffer = (UINT8 *)&TcgPcrEvent2->Digest.digests[0].digest;
+  for (DigestIndex = 0; DigestIndex < DigestCount; DigestIndex++) {
+    DigestSize = GetHashSizeFromAlgo (HashAlgo);
+    //
+    // Prepare next
+    //
+    CopyMem (&HashAlgo, DigestBuffer + DigestSize, sizeof (TPMI_ALG_HASH));
+    DigestBuffer = DigestBuffer + DigestSize + sizeof (TPMI_ALG_HASH);
+  }
+
+  DigestBuffer = DigestBuffer - sizeof (TPMI_ALG_HASH);
+
+  CopyMem (EventSize, DigestBuffer, sizeof (TcgPcrEvent2->EventSize));
+  *EventBuffer = DigestBuffer + sizeof (TcgPcrEvent2->EventSize);
+
+  return (UINTN)*EventBuffer + *EventSize - (UINTN)TcgPcrEvent2;
+}
+
+/**
+  This function get size of TCG_EfiSpecIDEventStruct.
+  NOTE: Copied from Tcg2Dxe driver in UDK.
+
+  @param[in]  TcgEfiSpecIdEventStruct     A pointer to TCG_EfiSpecIDEventStruct.
+**/
+STATIC
+UINTN
+GetTcgEfiSpecIdEventStructSize (
+  IN TCG_EfiSpecIDEventStruct  *TcgEfiSpecIdEventStruct
+  )
+{
+  TCG_EfiSpecIdEventAlgorithmSize  *DigestSize;
+  UINT8                            *VendorInfoSize;
+  UINT32                           NumberOfAlgorithms;
+
+  CopyMem (&NumberOfAlgorithms, TcgEfiSpecIdEventStruct + 1, sizeof (NumberOfAlgorithms));
+
+  DigestSize     = (TCG_EfiSpecIdEventAlgorithmSize *)((UINT8 *)TcgEfiSpecIdEventStruct + sizeof (*TcgEfiSpecIdEventStruct) + sizeof (NumberOfAlgorithms));
+  VendorInfoSize = (UINT8 *)&DigestSize[NumberOfAlgorithms];
+  return sizeof (TCG_EfiSpecIDEventStruct) + sizeof (UINT32) + (NumberOfAlgorithms * sizeof (TCG_EfiSpecIdEventAlgorithmSize)) + sizeof (UINT8) + (*VendorInfoSize);
+}
+
+/**
+  Report one crypto agile event to the callback.
+
+  @return Size of the event, or 0 if the callback failed.
+**/
+STATIC
+UINTN
+WalkPcrEvent2 (
+  IN  TCG_PCR_EVENT2                *TcgPcrEvent2,
+  IN  TPM_EVENT_LOG_EVENT_CALLBACK  Callback,
+  IN  VOID                          *Context,
+  OUT EFI_STATUS                    *Status
+  )
+{
+  UINT32  EventSize;
+  UINT8   *EventBuffer;
+  UINTN   Size;
+
+  Size    = ParsePcrEvent2 (TcgPcrEvent2, &EventSize, &EventBuffer);
+  *Status = Callback (
+              Context,
+              (UINTN)TcgPcrEvent2->PCRIndex,
+              (UINTN)TcgPcrEvent2->EventType,
+              EventSize,
+              EventBuffer,
+              TcgPcrEvent2->Digest.count,
+              &TcgPcrEvent2->Digest
+              );
+  if (EFI_ERROR (*Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Event failed.  PcrIndex: %d Event Type: 0x%X  %r\n", __FUNCTION__, TcgPcrEvent2->PCRIndex, TcgPcrEvent2->EventType, *Status));
+    return 0;
+  }
+
+  return Size;
+}
+
+/**
+  Walk a TCG2 crypto agile event log once, reporting the header event, every
+  event up to and including EventLogLastEntry and then every event of the final
+  events table.
+
+  @param[in]  EventLogLocation   Address of the first (header) event.
+  @param[in]  EventLogLastEntry  Address of the start of the last event.
+  @param[in]  FinalEventsTable   Optional final events table.
+  @param[in]  Callback           Called for each event.
+  @param[in]  Context            Passed to Callback.
+
+  @retval EFI_SUCCESS   Every event was reported.
+  @retval Others        Status returned by Callback.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogWalk (
+  IN EFI_PHYSICAL_ADDRESS          EventLogLocation,
+  IN EFI_PHYSICAL_ADDRESS          EventLogLastEntry,
+  IN EFI_TCG2_FINAL_EVENTS_TABLE   *FinalEventsTable OPTIONAL,
+  IN TPM_EVENT_LOG_EVENT_CALLBACK  Callback,
+  IN VOID                          *Context
+  )
+{
+  TCG_PCR_EVENT_HDR         *EventHdr;
+  TCG_PCR_EVENT2            *TcgPcrEvent2;
+  TCG_EfiSpecIDEventStruct  *TcgEfiSpecIdEventStruct;
+  UINT64                    NumberOfEvents;
+  UINTN                     Size;
+  EFI_STATUS                Status;
+
+  EventHdr = (TCG_PCR_EVENT_HDR *)(UINTN)EventLogLocation;
+  Status   = Callback (Context, (UINTN)EventHdr->PCRIndex, (UINTN)EventHdr->EventType, EventHdr->EventSize, (UINT8 *)(EventHdr + 1), 0, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Header event failed.  %r\n", __FUNCTION__, Status));
+    return Status;
+  }
+
+  TcgEfiSpecIdEventStruct = (TCG_EfiSpecIDEventStruct *)(EventHdr + 1);
+  TcgPcrEvent2            = (TCG_PCR_EVENT2 *)((UINTN)TcgEfiSpecIdEventStruct + GetTcgEfiSpecIdEventStructSize (TcgEfiSpecIdEventStruct));
+  while ((UINTN)TcgPcrEvent2 <= EventLogLastEntry) {
+    Size = WalkPcrEvent2 (TcgPcrEvent2, Callback, Context, &Status);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    TcgPcrEvent2 = (TCG_PCR_EVENT2 *)((UINTN)TcgPcrEvent2 + Size);
+  }
+
+  if (FinalEventsTable == NULL) {
+    DEBUG ((DEBUG_ERROR, "FinalEventsTable: NOT FOUND.\n"));
+    return EFI_SUCCESS;
+  }
+
+  TcgPcrEvent2 = (TCG_PCR_EVENT2 *)(UINTN)(FinalEventsTable + 1);
+  for (NumberOfEvents = 0; NumberOfEvents < FinalEventsTable->NumberOfEvents; NumberOfEvents++) {
+    Size = WalkPcrEvent2 (TcgPcrEvent2, Callback, Context, &Status);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    TcgPcrEvent2 = (TCG_PCR_EVENT2 *)((UINTN)TcgPcrEvent2 + Size);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Start a streamed document: writes the xml declaration and opens the Events
+  element, and writes the digest summary header if there is a summary sink.
+
+  @param[in,out]  Stream  Stream with its sinks initialized.
+
+  @return Sticky status of the sinks.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogStreamBegin (
+  IN OUT TPM_EVENT_LOG_STREAM  *Stream
+  )
+{
+  TPM_EVENT_LOG_DIGEST_HEADER  Header;
+
+  Stream->EventCount = 0;
+
+  SinkAppendString (Stream->Xml, STREAM_XML_DECLARATION "<" LIST_ELEMENT_NAME ">");
+  if (Stream->Summary == NULL) {
+    return Stream->Xml->Status;
+  }
+
+  Header.Signature = TPM_EVENT_LOG_DIGEST_SIGNATURE;
+  Header.Version   = TPM_EVENT_LOG_DIGEST_VERSION;
+  SinkAppend (Stream->Summary, &Header, sizeof (Header));
+
+  return EFI_ERROR (Stream->Xml->Status) ? Stream->Xml->Status : Stream->Summary->Status;
+}
+
+/**
+  TPM_EVENT_LOG_EVENT_CALLBACK that writes one HeaderEvent or Event element,
+  and the digest records of the event.  Context is a TPM_EVENT_LOG_STREAM.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogStreamEvent (
+  IN VOID                *Context,
+  IN UINTN               PcrIndex,
+  IN UINTN               EventType,
+  IN UINTN               EventSize,
+  IN UINT8               *EventBuffer,
+  IN UINTN               DigestCount,
+  IN TPML_DIGEST_VALUES  *Digest
+  )
+{
+  TPM_EVENT_LOG_STREAM         *Stream;
+  TPM_EVENT_LOG_SINK           *Xml;
+  CONST CHAR8                  *EntryName;
+  CHAR8                        Attribute[sizeof (" " EVENT_HASH_ALGO_ATTRIBUTE_NAME "=\"\"") + DECIMAL_STRING_SIZE];
+  TPM_EVENT_LOG_DIGEST_RECORD  Record;
+  UINTN                        DigestIndex;
+  TPMI_ALG_HASH                HashAlgo;
+  UINTN                        DigestSize;
+  UINT8                        *DigestBuffer;
+
+  Stream    = (TPM_EVENT_LOG_STREAM *)Context;
+  Xml       = Stream->Xml;
+  EntryName = (DigestCount > 0) ? EVENT_ENTRY_ELEMENT_NAME : HEADER_ENTRY_ELEMENT_NAME;
+
+  SinkAppendString (Xml, "<");
+  SinkAppendString (Xml, EntryName);
+  SinkAppendString (Xml, ">");
+  SinkAppendDecimalElement (Xml, EVENT_PCR_ELEMENT_NAME, PcrIndex);
+  SinkAppendDecimalElement (Xml, EVENT_TYPE_ELEMENT_NAME, EventType);
+  SinkAppendDecimalElement (Xml, EVENT_SIZE_ELEMENT_NAME, EventSize);
+  SinkAppendHexElement (Xml, EVENT_DATA_ELEMENT_NAME, NULL, EventBuffer, EventSize);
+
+  if (DigestCount > 0) {
+    SinkAppendDecimalElement (Xml, EVENT_DIGEST_COUNT_ELEMENT_NAME, DigestCount);
+    SinkAppendString (Xml, "<" EVENT_DIGESTS_ELEMENT_NAME ">");
+
+    HashAlgo     = Digest->digests[0].hashAlg;
+    DigestBuffer = (UINT8 *)Digest->digests[0].digest.sha1;
+    for (DigestIndex = 0; DigestIndex < DigestCount; DigestIndex++) {
+      DigestSize = GetHashSizeFromAlgo (HashAlgo);
+
+      AsciiSPrint (Attribute, sizeof (Attribute), " %a=\"%d\"", EVENT_HASH_ALGO_ATTRIBUTE_NAME, HashAlgo);
+      SinkAppendHexElement (Xml, EVENT_DIGEST_ELEMENT_NAME, Attribute, DigestBuffer, DigestSize);
+
+      if (Stream->Summary != NULL) {
+        Record.PcrIndex   = (UINT32)PcrIndex;
+        Record.EventType  = (UINT32)EventType;
+        Record.HashAlgo   = HashAlgo;
+        Record.DigestSize = (UINT16)DigestSize;
+        SinkAppend (Stream->Summary, &Record, sizeof (Record));
+        SinkAppend (Stream->Summary, DigestBuffer, DigestSize);
+      }
+
+      //
+      // Prepare next
+      //
+      CopyMem (&HashAlgo, DigestBuffer + DigestSize, sizeof (TPMI_ALG_HASH));
+      DigestBuffer = DigestBuffer + DigestSize + sizeof (TPMI_ALG_HASH);
+    }
+
+    SinkAppendString (Xml, "</" EVENT_DIGESTS_ELEMENT_NAME ">");
+  }
+
+  SinkAppendString (Xml, "</");
+  SinkAppendString (Xml, EntryName);
+  SinkAppendString (Xml, ">");
+
+  Stream->EventCount++;
+
+  if (EFI_ERROR (Xml->Status)) {
+    return Xml->Status;
+  }
+
+  return (Stream->Summary != NULL) ? Stream->Summary->Status : EFI_SUCCESS;
+}
+
+/**
+  Close the Events element and flush the sinks.
+
+  @param[in,out]  Stream  Stream to finish.
+
+  @return The first error either sink ran into, or EFI_SUCCESS.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogStreamEnd (
+  IN OUT TPM_EVENT_LOG_STREAM  *Stream
+  )
+{
+  EFI_STATUS  Status;
+
+  SinkAppendString (Stream->Xml, "</" LIST_ELEMENT_NAME ">");
+  Status = TpmEventLogSinkFlush (Stream->Xml);
+
+  if (Stream->Summary != NULL) {
+    if (EFI_ERROR (TpmEventLogSinkFlush (Stream->Summary)) && !EFI_ERROR (Status)) {
+      Status = Stream->Summary->Status;
+    }
+  }
+
+  return Status;
+}
@@ -0,0 +1,200 @@
+/** @file -- TpmEventLogStream.h
+Single pass walker for the TCG2 crypto agile event log and a streaming writer
+that emits the TpmEventLogAudit XML format one event at a time.
+
+The streamed document is byte for byte what XmlTreeToString produces for the
+tree built by New_EventsNodeList/New_NodeInList, but memory use is bounded by
+the output buffer instead of growing with the size of the log.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef TPM_EVENT_LOG_STREAM_H
+#define TPM_EVENT_LOG_STREAM_H
+
+#include <Uefi.h>
+#include <Protocol/Tcg2Protocol.h>
+#include <IndustryStandard/UefiTcgPlatform.h>
+
+#define TPM_EVENT_LOG_SINK_BUFFER_SIZE  SIZE_4KB
+
+/**
+  Consumes a chunk of output from a sink.
+
+  @param[in]  Context   Context given to TpmEventLogSinkInit.
+  @param[in]  Buffer    Bytes to write.
+  @param[in]  Size      Number of bytes in Buffer.
+
+  @retval EFI_SUCCESS   All of Buffer was written.
+  @retval Others        The write failed, the sink stops writing.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *TPM_EVENT_LOG_SINK_WRITE)(
+  IN VOID        *Context,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Size
+  );
+
+//
+// Fixed size output buffer in front of a write callback. The first failure is
+// kept in Status and every later append or flush is dropped, so callers only
+// have to check once at the end.
+//
+typedef struct {
+  TPM_EVENT_LOG_SINK_WRITE    Write;
+  VOID                        *Context;
+  EFI_STATUS                  Status;
+  UINTN                       Used;
+  UINT64                      Total;
+  UINT8                       Buffer[TPM_EVENT_LOG_SINK_BUFFER_SIZE];
+} TPM_EVENT_LOG_SINK;
+
+/**
+  Called by TpmEventLogWalk for every event in the log.  The header event is
+  reported with DigestCount 0 and Digest NULL, matching New_NodeInList.
+
+  @retval EFI_SUCCESS   Continue the walk.
+  @retval Others        Stop the walk and return this status.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *TPM_EVENT_LOG_EVENT_CALLBACK)(
+  IN VOID                *Context,
+  IN UINTN               PcrIndex,
+  IN UINTN               EventType,
+  IN UINTN               EventSize,
+  IN UINT8               *EventBuffer,
+  IN UINTN               DigestCount,
+  IN TPML_DIGEST_VALUES  *Digest
+  );
+
+//
+// Binary digest summary. The file starts with a TPM_EVENT_LOG_DIGEST_HEADER
+// followed by one TPM_EVENT_LOG_DIGEST_RECORD per digest of every crypto agile
+// event, each immediately followed by DigestSize bytes of digest.  The header
+// event carries no agile digests and has no records.  Readers consume records
+// until the end of the file.
+//
+#define TPM_EVENT_LOG_DIGEST_SIGNATURE  SIGNATURE_32 ('T', 'E', 'L', 'D')
+#define TPM_EVENT_LOG_DIGEST_VERSION    1
+
+#pragma pack(1)
+typedef struct {
+  UINT32    Signature;
+  UINT32    Version;
+} TPM_EVENT_LOG_DIGEST_HEADER;
+
+typedef struct {
+  UINT32    PcrIndex;
+  UINT32    EventType;
+  UINT16    HashAlgo;
+  UINT16    DigestSize;
+  // UINT8  Digest[DigestSize];
+} TPM_EVENT_LOG_DIGEST_RECORD;
+#pragma pack()
+
+typedef struct {
+  TPM_EVENT_LOG_SINK    *Xml;
+  TPM_EVENT_LOG_SINK    *Summary;   // Optional, NULL for no digest summary
+  UINTN                 EventCount;
+} TPM_EVENT_LOG_STREAM;
+
+/**
+  Initialize a sink.
+
+  @param[out] Sink      Sink to initialize.
+  @param[in]  Write     Callback that receives each full or flushed buffer.
+  @param[in]  Context   Passed to Write.
+**/
+VOID
+EFIAPI
+TpmEventLogSinkInit (
+  OUT TPM_EVENT_LOG_SINK        *Sink,
+  IN  TPM_EVENT_LOG_SINK_WRITE  Write,
+  IN  VOID                      *Context
+  );
+
+/**
+  Pass any buffered bytes to the write callback.
+
+  @param[in,out]  Sink  Sink to flush.
+
+  @return The first error the sink ran into, or EFI_SUCCESS.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogSinkFlush (
+  IN OUT TPM_EVENT_LOG_SINK  *Sink
+  );
+
+/**
+  Walk a TCG2 crypto agile event log once, reporting the header event, every
+  event up to and including EventLogLastEntry and then every event of the final
+  events table.
+
+  @param[in]  EventLogLocation   Address of the first (header) event.
+  @param[in]  EventLogLastEntry  Address of the start of the last event.
+  @param[in]  FinalEventsTable   Optional final events table.
+  @param[in]  Callback           Called for each event.
+  @param[in]  Context            Passed to Callback.
+
+  @retval EFI_SUCCESS   Every event was reported.
+  @retval Others        Status returned by Callback.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogWalk (
+  IN EFI_PHYSICAL_ADDRESS          EventLogLocation,
+  IN EFI_PHYSICAL_ADDRESS          EventLogLastEntry,
+  IN EFI_TCG2_FINAL_EVENTS_TABLE   *FinalEventsTable OPTIONAL,
+  IN TPM_EVENT_LOG_EVENT_CALLBACK  Callback,
+  IN VOID                          *Context
+  );
+
+/**
+  Start a streamed document: writes the xml declaration and opens the Events
+  element, and writes the digest summary header if there is a summary sink.
+
+  @param[in,out]  Stream  Stream with its sinks initialized.
+
+  @return Sticky status of the sinks.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogStreamBegin (
+  IN OUT TPM_EVENT_LOG_STREAM  *Stream
+  );
+
+/**
+  TPM_EVENT_LOG_EVENT_CALLBACK that writes one HeaderEvent or Event element,
+  and the digest records of the event.  Context is a TPM_EVENT_LOG_STREAM.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogStreamEvent (
+  IN VOID                *Context,
+  IN UINTN               PcrIndex,
+  IN UINTN               EventType,
+  IN UINTN               EventSize,
+  IN UINT8               *EventBuffer,
+  IN UINTN               DigestCount,
+  IN TPML_DIGEST_VALUES  *Digest
+  );
+
+/**
+  Close the Events element and flush the sinks.
+
+  @param[in,out]  Stream  Stream to finish.
+
+  @return The first error either sink ran into, or EFI_SUCCESS.
+**/
+EFI_STATUS
+EFIAPI
+TpmEventLogStreamEnd (
+  IN OUT TPM_EVENT_LOG_STREAM  *Stream
+  );
+
+#endif // TPM_EVENT_LOG_STREAM_H
@@ -233,6 +233,9 @@ New_NodeInList (
       DEBUG ((DEBUG_ERROR, "%a - Can't add DigestNode list to NewEventNode.  Status %r\n", __FUNCTION__, Status));
       goto ERROR_EXIT;
     }
+
+    // NewEventNode owns the digest list now
+    DigestNode = NULL;
   } else {
     DEBUG ((DEBUG_INFO, "Header node\n"));
   }
@@ -244,17 +247,15 @@ New_NodeInList (
     goto ERROR_EXIT;
   }
 
+  FreePages (AsciiString, NUM_OF_PAGES);
   return NewEventNode;
 
 ERROR_EXIT:
+  // TempNode is always a child of NewEventNode or DigestNode and is freed with them
   if (NewEventNode != NULL) {
     FreeXmlTree (&NewEventNode);
   }
 
-  if (TempNode != NULL) {
-    FreeXmlTree (&TempNode);
-  }
-
   if (DigestNode != NULL) {
     FreeXmlTree (&DigestNode);
   }
@@ -265,3 +266,29 @@ ERROR_EXIT:
 
   return NULL;
 }
+
+/**
+Event callback for TpmEventLogWalk that adds each event to the list.
+
+Context is the root node returned by New_EventsNodeList.
+
+**/
+EFI_STATUS
+EFIAPI
+AddEventToNodeList (
+  IN VOID                *Context,
+  IN UINTN               PcrIndex,
+  IN UINTN               EventType,
+  IN UINTN               EventSize,
+  IN UINT8               *EventBuffer,
+  IN UINTN               DigestCount,
+  IN TPML_DIGEST_VALUES  *Digest
+  )
+{
+  if (New_NodeInList ((XmlNode *)Context, PcrIndex, EventType, EventSize, EventBuffer, DigestCount, Digest) == NULL) {
+    DEBUG ((DEBUG_ERROR, "Failed to create new Event Node.  Event Type: 0x%X PcrIndex: %d\n", EventType, PcrIndex));
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
@@ -19,7 +19,6 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <XmlTypes.h>
 #include <Library/XmlTreeLib.h>
 #include <Library/XmlTreeQueryLib.h>
-#include <Library/ShellLib.h>
 #include <Library/Tpm2CommandLib.h>
 #include <IndustryStandard/UefiTcgPlatform.h>
 
@@ -102,4 +101,22 @@ New_NodeInList (
   IN TPML_DIGEST_VALUES  *Digest
   );
 
+/**
+Event callback for TpmEventLogWalk that adds each event to the list.
+
+Context is the root node returned by New_EventsNodeList.
+
+**/
+EFI_STATUS
+EFIAPI
+AddEventToNodeList (
+  IN VOID                *Context,
+  IN UINTN               PcrIndex,
+  IN UINTN               EventType,
+  IN UINTN               EventSize,
+  IN UINT8               *EventBuffer,
+  IN UINTN               DigestCount,
+  IN TPML_DIGEST_VALUES  *Digest
+  );
+
 #endif // TPM_EVENT_LOG_XML_H
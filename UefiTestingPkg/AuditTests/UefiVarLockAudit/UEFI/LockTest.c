@@ -21,129 +21,66 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/ShellLib.h>
 #include "LockTestXml.h"
 
-#define MAX_NAME_LEN   1024
-#define MAX_NAME_SIZE  (MAX_NAME_LEN * sizeof(CHAR16 ))
+#include "VarSnapshot.h"
 
+/**
+  Build the variables XML list from a probed snapshot.  Entries keep the order
+  GetNextVariableName returned them in.
+
+  @param[in]  Snapshot  Snapshot that has been through VarSnapshotProbe.
+
+  @return The list, or NULL if it could not be built.  Free with FreeXmlTree.
+**/
 XmlNode *
 EFIAPI
-CreateListOfAllVars (
+CreateListFromSnapshot (
+  IN CONST VAR_SNAPSHOT  *Snapshot
   )
 {
-  EFI_STATUS  Status;
-  CHAR16      varName[MAX_NAME_LEN];
-  EFI_GUID    varGuid;
-  UINTN       varNameSize;
-  XmlNode     *List;
+  EFI_STATUS                Status;
+  XmlNode                   *List;
+  XmlNode                   *VarNode;
+  CHAR8                     *AsciiString;
+  CONST VAR_SNAPSHOT_ENTRY  *Entry;
+  UINTN                     Index;
+
+  AsciiString = AllocatePool (VAR_XML_STRING_SIZE);
+  if (AsciiString == NULL) {
+    DEBUG ((DEBUG_ERROR, "Failed to allocate the XML scratch string\n"));
+    return NULL;
+  }
 
   List = New_VariablesNodeList ();
   if (List == NULL) {
     DEBUG ((DEBUG_ERROR, "Failed to allocate an XML list\n"));
+    FreePool (AsciiString);
     return NULL;
   }
 
-  ZeroMem (&varGuid, sizeof (EFI_GUID));
-  varName[0]  = L'\0';
-  varNameSize = MAX_NAME_SIZE;
-  Status      = gRT->GetNextVariableName (&varNameSize, &varName[0], &varGuid);
-  while (!EFI_ERROR (Status)) {
-    UINT8   *varData      = NULL;
-    UINTN   varDataSize   = 0;
-    UINT32  varAttributes = 0;
-
-    Status = GetVariable3 (varName, &varGuid, (VOID **)&varData, &varDataSize, &varAttributes);
-    if (!EFI_ERROR (Status)) {
-      if (New_VariableNodeInList (List, varName, &varGuid, varAttributes, varDataSize, varData) == NULL) {
-        DEBUG ((DEBUG_ERROR, "Failed to create new Var Node.  Var Name: %s Guid: %g\n", varName, &varGuid));
-        Status = EFI_DEVICE_ERROR;
-      }
+  for (Index = 0; Index < Snapshot->Count; Index++) {
+    Entry   = &Snapshot->Entries[Index];
+    VarNode = New_VariableNodeInList (
+                List,
+                VarSnapshotName (Snapshot, Entry),
+                &Entry->Guid,
+                Entry->Attributes,
+                Entry->DataSize,
+                VarSnapshotData (Snapshot, Entry),
+                AsciiString
+                );
+    if (VarNode == NULL) {
+      DEBUG ((DEBUG_ERROR, "Failed to create new Var Node.  Var Name: %s Guid: %g\n", VarSnapshotName (Snapshot, Entry), &Entry->Guid));
+      continue;
     }
 
-    if (varData) {
-      FreePool (varData);
-    }
-
-    // get next
-    varNameSize = MAX_NAME_SIZE;
-    Status      = gRT->GetNextVariableName (&varNameSize, &varName[0], &varGuid);
-  }
-
-  return List;
-}
-
-EFI_STATUS
-EFIAPI
-UpdateListWithReadWriteInfo (
-  XmlNode  *List
-  )
-{
-  EFI_STATUS  Status;
-  LIST_ENTRY  *Link = NULL;
-
-  if (List == NULL) {
-    return EFI_INVALID_PARAMETER;
-  }
-
-  // loop thru all children of the list
-  if (List->ParentNode != NULL) {
-    DEBUG ((DEBUG_ERROR, "!!!ERROR: BAD XML.  List should be head node\n"));
-    return EFI_INVALID_PARAMETER;
-  }
-
-  // Loop thru all children which should be variable nodes
-  for (Link = List->ChildrenListHead.ForwardLink; Link != &(List->ChildrenListHead); Link = Link->ForwardLink) {
-    XmlNode     *Current = (XmlNode *)Link;
-    CHAR16      *varName = NULL;
-    EFI_GUID    varGuid;
-    UINT8       *varData         = NULL;
-    UINTN       varDataSize      = 0;
-    UINT32      varAttributes    = 0;
-    EFI_STATUS  StatusFromDelete = EFI_SUCCESS;
-
-    // Get current info
-    Status = GetNameGuidMembersFromNode (Current, &varName, &varGuid);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a Failed in GetNameGuidMembers.  Status = %r\n", __FUNCTION__, Status));
-      return Status;
-    }
-
-    // Get current data - don't use XML stringified data...easier just to read binary again
-    Status = GetVariable3 (varName, &varGuid, (VOID **)&varData, &varDataSize, &varAttributes);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a Failed in GetVar3.  Status = %r\n", __FUNCTION__, Status));
-      FreePool (varName);
-      return Status;
-    }
-
-    DEBUG ((DEBUG_INFO, "%a testing write properties for var %g", __FUNCTION__, &varGuid));
-    DEBUG ((DEBUG_INFO, " ::%s", varName));
-    DEBUG ((DEBUG_INFO, "\n"));  // do independent debug print so that we always have newline.  Some names can be long and overrun the debug buffer
-
-    // Delete current var
-    StatusFromDelete = gRT->SetVariable (varName, &varGuid, varAttributes, 0, NULL);
-    Status           = AddReadyToBootStatusToNode (Current, EFI_SUCCESS, StatusFromDelete);
+    Status = AddReadyToBootStatusToNode (VarNode, Entry->ReadStatus, Entry->WriteStatus);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a failed in AddReadyToBootStatusToNode.  Status = %r\n", __FUNCTION__, Status));
     }
-
-    // restore if needed
-    if (!EFI_ERROR (StatusFromDelete)) {
-      Status = gRT->SetVariable (varName, &varGuid, varAttributes, varDataSize, varData);
-      if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "%a failed to restore variable data.  Status = %r\n", __FUNCTION__, Status));
-      }
-    }
-
-    // clean up
-    if (varName != NULL) {
-      FreePool (varName);
-    }
-
-    if (varData != NULL) {
-      FreePool (varData);
-    }
   }
 
-  return EFI_SUCCESS;
+  FreePool (AsciiString);
+  return List;
 }
 
 /**
@@ -170,21 +107,31 @@ LockTestEntry (
   XmlNode            *MyList    = NULL;
   UINTN              StringSize = 0;
   CHAR8              *XmlString = NULL;
+  VAR_SNAPSHOT       Snapshot;
 
-  MyList = CreateListOfAllVars ();
-  if (MyList == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
+  ZeroMem (&Snapshot, sizeof (Snapshot));
+
+  // Take every variable in one pass before anything is deleted
+  Status = VarSnapshotCreate (&Snapshot);
+  if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Failed to get list of vars Status = %r\n", Status));
     goto Exit;
   }
 
   // Get R/W properties
-  Status = UpdateListWithReadWriteInfo (MyList);
+  Status = VarSnapshotProbe (&Snapshot);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Failed to Update List with Read/Write Properties = %r\n", Status));
     goto Exit;
   }
 
+  MyList = CreateListFromSnapshot (&Snapshot);
+  if (MyList == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    DEBUG ((DEBUG_ERROR, "Failed to build the XML list of vars Status = %r\n", Status));
+    goto Exit;
+  }
+
   // Write XML
   Status = XmlTreeToString (MyList, TRUE, &StringSize, &XmlString);
   if (EFI_ERROR (Status)) {
@@ -229,6 +176,8 @@ LockTestEntry (
   Status = EFI_SUCCESS;
 
 Exit:
+  VarSnapshotFree (&Snapshot);
+
   if (MyList != NULL) {
     FreeXmlTree (&MyList);
   }
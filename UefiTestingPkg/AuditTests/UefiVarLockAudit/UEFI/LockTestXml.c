@@ -9,9 +9,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include "LockTestXml.h"
 
 #define LIST_XML_TEMPLATE   "<?xml version=\"1.0\" encoding=\"utf-8\"?><Variables></Variables>"
-#define READY_XML_TEMPLATE  "<ReadyToBoot></ReadyToBoot>"
-
-#define MAX_STRING_LENGTH  (0x10000)
+#define MAX_STRING_LENGTH  VAR_XML_STRING_SIZE
 
 #define DATA_TO_BIG  ("DATA AS STRING EXCEEDS MAX LENGTH")
 
@@ -56,108 +54,6 @@ ERROR:
   return Root;
 }
 
-/**
-If success return pointers populated with a copy of the data
-
-**/
-EFI_STATUS
-EFIAPI
-GetNameGuidMembersFromNode (
-  IN CONST  XmlNode   *Node,
-  OUT       CHAR16    **VarName,
-  OUT       EFI_GUID  *VarGuid
-  )
-{
-  EFI_STATUS  Status;
-  LIST_ENTRY  *Link = NULL;
-  UINTN       i, Length;
-
-  if (VarName == NULL) {
-    DEBUG ((DEBUG_ERROR, "%a - VarName is NULL\n", __FUNCTION__));
-    Status = EFI_INVALID_PARAMETER;
-    goto EXIT;
-  }
-
-  *VarName = NULL;
-
-  if (Node == NULL) {
-    DEBUG ((DEBUG_ERROR, "%a - Node is NULL\n", __FUNCTION__));
-    Status = EFI_INVALID_PARAMETER;
-    goto EXIT;
-  }
-
-  if (VarGuid == NULL) {
-    DEBUG ((DEBUG_ERROR, "%a - VarGuid is NULL\n", __FUNCTION__));
-    Status = EFI_INVALID_PARAMETER;
-    goto EXIT;
-  }
-
-  if (AsciiStrnCmp (VARIABLE_ENTRY_ELEMENT_NAME, Node->Name, sizeof (VARIABLE_ENTRY_ELEMENT_NAME)) != 0) {
-    DEBUG ((DEBUG_ERROR, "%a - Node is Not a Variable Node.  Element Name = %a \n", __FUNCTION__, Node->Name));
-    Status = EFI_INVALID_PARAMETER;
-    goto EXIT;
-  }
-
-  if (Node->NumAttributes < 2) {
-    DEBUG ((DEBUG_ERROR, "%a - Node not in valid state for this function (too few attributes). \n", __FUNCTION__));
-    DebugPrintXmlTree (Node, 0);
-    Status = EFI_VOLUME_CORRUPTED;
-    goto EXIT;
-  }
-
-  Link = Node->AttributesListHead.ForwardLink;
-  for (i = 0; i < 2; i++, Link = Link->ForwardLink) {
-    XmlAttribute  *CurrentAttribute = (XmlAttribute *)Link;
-    //
-    // TODO:  this code should change to do string compare on attribute name.
-    // Assuming order is not safe.
-    //
-    switch (i) {
-      case 0: // Name
-        Length   = AsciiStrnLenS (CurrentAttribute->Value, 1024);
-        *VarName = (CHAR16 *)AllocateZeroPool ((Length + 1) * sizeof (CHAR16));
-        if (*VarName == NULL) {
-          DEBUG ((DEBUG_ERROR, "%a Failed to allocate for varname\n", __FUNCTION__));
-          Status = EFI_OUT_OF_RESOURCES;
-          goto EXIT;
-        }
-
-        Status = AsciiStrToUnicodeStrS (CurrentAttribute->Value, *VarName, Length + 1);
-        if (EFI_ERROR (Status)) {
-          DEBUG ((DEBUG_ERROR, "Error converting Ascii to Unicode for %a, Length=%d, code=%r\n", CurrentAttribute->Value, Length, Status));
-        }
-
-        break;
-
-      case 1: // guid
-        Status = ConvertAsciiStringToGuid (CurrentAttribute->Value, VarGuid);
-        if (EFI_ERROR (Status)) {
-          DEBUG ((DEBUG_ERROR, "%a Failed to convert ascii string to guid. %r\n", __FUNCTION__, Status));
-          goto EXIT;
-        }
-
-        break;
-
-      default:
-        DEBUG ((DEBUG_ERROR, "%a logic error: should never hit the default case\n", __FUNCTION__));
-        Status = EFI_DEVICE_ERROR;
-        goto EXIT;
-    }
-  }
-
-  Status = EFI_SUCCESS;
-
-EXIT:
-  if (EFI_ERROR (Status)) {
-    if ((VarName != NULL) && (*VarName != NULL)) {
-      FreePool (*VarName);
-      *VarName = NULL;
-    }
-  }
-
-  return Status;
-}
-
 /**
 Creates a new XmlNode for a var and adds it to the list
 
@@ -165,6 +61,9 @@ Return NULL if error occurs. Otherwise return a pointer Variable Node.
 
 List must be freed using FreeXmlTree
 
+AsciiString is scratch space of VAR_XML_STRING_SIZE bytes owned by the caller
+so it can be reused for every variable.
+
 return pointer will be the variable element node
 VAR_XML_TEMPLATE
 
@@ -177,18 +76,17 @@ New_VariableNodeInList (
   IN CONST GUID     *VarGuid,
   IN UINT32         Attributes,
   IN UINTN          DataSize,
-  IN CONST UINT8    *Data
+  IN CONST UINT8    *Data,
+  IN OUT CHAR8      *AsciiString
   )
 {
-  XmlNode     *NewVarNode  = NULL;
-  XmlNode     *TempNode    = NULL;
-  CHAR8       *AsciiString = NULL;
+  XmlNode     *NewVarNode = NULL;
+  XmlNode     *TempNode   = NULL;
   EFI_STATUS  Status;
   UINTN       i;
 
-  AsciiString = AllocatePages (EFI_SIZE_TO_PAGES (MAX_STRING_LENGTH));  // allocate 64kb
   if (AsciiString == NULL) {
-    DEBUG ((DEBUG_ERROR, "%a - Failed to allocate 64kb for string conversion\n", __FUNCTION__));
+    DEBUG ((DEBUG_ERROR, "%a - AsciiString is NULL\n", __FUNCTION__));
     return NULL;
   }
 
@@ -329,10 +227,6 @@ ERROR_EXIT:
     FreeXmlTree (&NewVarNode);
   }
 
-  if (AsciiString != NULL) {
-    FreePages (AsciiString, EFI_SIZE_TO_PAGES (MAX_STRING_LENGTH));
-  }
-
   return NewVarNode;
 }
 
@@ -348,7 +242,8 @@ AddReadyToBootStatusToNode (
   EFI_STATUS  Status;
   CHAR8       AsciiString[100];// hold the ascii for UINT64 converted to string
 
-  Status = CreateXmlTree (READY_XML_TEMPLATE, sizeof (READY_XML_TEMPLATE) - 1, &StatusNode);
+  // Built with no parent, same as parsing "<ReadyToBoot></ReadyToBoot>" but without the parser
+  Status = AddNode (NULL, VAR_READYTOBOOT_ELEMENT_NAME, NULL, &StatusNode);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a - Failed.  Status %r\n", __FUNCTION__, Status));
     return Status;
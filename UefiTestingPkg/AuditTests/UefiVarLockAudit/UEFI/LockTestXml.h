@@ -51,6 +51,9 @@
 #define VAR_READ_STATUS_ELEMENT_NAME   "ReadStatus"
 #define VAR_WRITE_STATUS_ELEMENT_NAME  "WriteStatus"
 
+// Size of the scratch string New_VariableNodeInList formats into
+#define VAR_XML_STRING_SIZE  (0x10000)
+
 /**
 Creates a new XmlNode list following the List
 format.
@@ -76,6 +79,9 @@ Return NULL if error occurs. Otherwise return a pointer Variable Node.
 
 List must be freed using FreeXmlTree
 
+AsciiString is scratch space of VAR_XML_STRING_SIZE bytes owned by the caller
+so it can be reused for every variable.
+
 return pointer will be the variable element node
 VAR_XML_TEMPLATE
 
@@ -88,7 +94,8 @@ New_VariableNodeInList (
   IN CONST GUID     *VarGuid,
   IN UINT32         Attributes,
   IN UINTN          DataSize,
-  IN CONST UINT8    *Data
+  IN CONST UINT8    *Data,
+  IN OUT CHAR8      *AsciiString
   );
 
 EFI_STATUS
@@ -99,19 +106,4 @@ AddReadyToBootStatusToNode (
   IN EFI_STATUS     WriteStatus
   );
 
-EFI_STATUS
-EFIAPI
-GetNameGuidMembersFromNode (
-  IN CONST  XmlNode   *Node,
-  OUT       CHAR16    **VarName,
-  OUT       EFI_GUID  *VarGuid
-  );
-
-EFI_STATUS
-EFIAPI
-ConvertAsciiStringToGuid (
-  IN CONST CHAR8   *StringGuid,
-  IN OUT EFI_GUID  *Guid
-  );
-
 #endif
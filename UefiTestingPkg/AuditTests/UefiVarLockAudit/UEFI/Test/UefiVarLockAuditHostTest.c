@@ -0,0 +1,606 @@
+/** @file -- UefiVarLockAuditHostTest.c
+Host-based UnitTest for the variable snapshot and delete/restore probe used by
+UefiVarLockAudit.
+
+The runtime services are backed by an in memory variable store where some
+variables are locked, so the tests can check what the probe reports and that
+the store is left as it was found.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PrintLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../VarSnapshot.h"
+
+#define UNIT_TEST_NAME     "UefiVarLockAudit Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define MAX_FAKE_VARIABLES    4096
+#define MANY_VARIABLES        3000
+#define LONG_NAME_LENGTH      300
+#define LARGE_DATA_SIZE       0x5000
+#define PROBE_VARIABLES       50
+#define ENUM_FAIL_AFTER       10
+
+typedef struct {
+  EFI_GUID    Guid;
+  CHAR16      *Name;
+  UINT32      Attributes;
+  UINT8       *Data;
+  UINTN       DataSize;
+  BOOLEAN     Present;
+  BOOLEAN     Locked;
+} FAKE_VARIABLE;
+
+//
+// Variables keep their slot when deleted, so restoring one puts it back where
+// it was and the store can be compared before and after a probe.
+//
+STATIC FAKE_VARIABLE  mVariables[MAX_FAKE_VARIABLES];
+STATIC UINTN          mVariableCount;
+
+STATIC UINTN  mGetNextVariableNameCalls;
+STATIC UINTN  mGetNextVariableNameFailAt;   // Fail this call with EFI_DEVICE_ERROR, 0 for never
+STATIC UINTN  mSetVariableCalls;
+
+STATIC EFI_GUID  mTestGuid  = {
+  0x6f0c2a47, 0x3d15, 0x4e8b, { 0x9a, 0x21, 0x57, 0xc4, 0x0e, 0xb3, 0x78, 0xd2 }
+};
+STATIC EFI_GUID  mOtherGuid = {
+  0xb1d4e863, 0x0a7f, 0x4c52, { 0x86, 0x3e, 0x19, 0xf2, 0xa5, 0x6d, 0xc0, 0x4b }
+};
+
+/**
+  Find a variable slot by name and guid, present or not.
+**/
+STATIC
+FAKE_VARIABLE *
+FindFakeVariable (
+  IN CONST CHAR16    *Name,
+  IN CONST EFI_GUID  *Guid
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mVariableCount; Index++) {
+    if (CompareGuid (&mVariables[Index].Guid, Guid) && (StrCmp (mVariables[Index].Name, Name) == 0)) {
+      return &mVariables[Index];
+    }
+  }
+
+  return NULL;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeGetVariable (
+  IN     CHAR16    *VariableName,
+  IN     EFI_GUID  *VendorGuid,
+  OUT    UINT32    *Attributes OPTIONAL,
+  IN OUT UINTN     *DataSize,
+  OUT    VOID      *Data OPTIONAL
+  )
+{
+  FAKE_VARIABLE  *Variable;
+
+  Variable = FindFakeVariable (VariableName, VendorGuid);
+  if ((Variable == NULL) || !Variable->Present) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (Attributes != NULL) {
+    *Attributes = Variable->Attributes;
+  }
+
+  if (*DataSize < Variable->DataSize) {
+    *DataSize = Variable->DataSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *DataSize = Variable->DataSize;
+  CopyMem (Data, Variable->Data, Variable->DataSize);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeGetNextVariableName (
+  IN OUT UINTN     *VariableNameSize,
+  IN OUT CHAR16    *VariableName,
+  IN OUT EFI_GUID  *VendorGuid
+  )
+{
+  UINTN  Index;
+  UINTN  NameSize;
+
+  mGetNextVariableNameCalls++;
+  if (mGetNextVariableNameCalls == mGetNextVariableNameFailAt) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Index = 0;
+  if (VariableName[0] != L'\0') {
+    for (Index = 0; Index < mVariableCount; Index++) {
+      if (CompareGuid (&mVariables[Index].Guid, VendorGuid) && (StrCmp (mVariables[Index].Name, VariableName) == 0)) {
+        break;
+      }
+    }
+
+    if ((Index == mVariableCount) || !mVariables[Index].Present) {
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Index++;
+  }
+
+  while ((Index < mVariableCount) && !mVariables[Index].Present) {
+    Index++;
+  }
+
+  if (Index == mVariableCount) {
+    return EFI_NOT_FOUND;
+  }
+
+  NameSize = StrSize (mVariables[Index].Name);
+  if (*VariableNameSize < NameSize) {
+    *VariableNameSize = NameSize;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *VariableNameSize = NameSize;
+  CopyMem (VariableName, mVariables[Index].Name, NameSize);
+  CopyGuid (VendorGuid, &mVariables[Index].Guid);
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeSetVariable (
+  IN CHAR16    *VariableName,
+  IN EFI_GUID  *VendorGuid,
+  IN UINT32    Attributes,
+  IN UINTN     DataSize,
+  IN VOID      *Data
+  )
+{
+  FAKE_VARIABLE  *Variable;
+
+  mSetVariableCalls++;
+  Variable = FindFakeVariable (VariableName, VendorGuid);
+  if (Variable == NULL) {
+    // The probe only ever writes variables it found
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Variable->Locked) {
+    return EFI_WRITE_PROTECTED;
+  }
+
+  if (DataSize == 0) {
+    if (!Variable->Present) {
+      return EFI_NOT_FOUND;
+    }
+
+    Variable->Present = FALSE;
+    return EFI_SUCCESS;
+  }
+
+  if (Variable->Present) {
+    // Every delete is followed by a restore, never an overwrite
+    return EFI_UNSUPPORTED;
+  }
+
+  FreePool (Variable->Data);
+  Variable->Data = AllocateCopyPool (DataSize, Data);
+  if (Variable->Data == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Variable->DataSize   = DataSize;
+  Variable->Attributes = Attributes;
+  Variable->Present    = TRUE;
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_RUNTIME_SERVICES  mMockRuntime = {
+  .GetVariable         = FakeGetVariable,
+  .GetNextVariableName = FakeGetNextVariableName,
+  .SetVariable         = FakeSetVariable,
+};
+
+//
+// VarSnapshot.c only touches variable services, so the test provides gRT
+// itself instead of linking a UefiRuntimeServicesTableLib.
+//
+EFI_RUNTIME_SERVICES  *gRT = &mMockRuntime;
+
+/**
+  Add a variable to the store.  Data is a pattern derived from Seed.
+**/
+STATIC
+VOID
+AddFakeVariable (
+  IN CONST EFI_GUID  *Guid,
+  IN CONST CHAR16    *Name,
+  IN UINT32          Attributes,
+  IN UINTN           DataSize,
+  IN UINT8           Seed,
+  IN BOOLEAN         Locked
+  )
+{
+  FAKE_VARIABLE  *Variable;
+  UINTN          Index;
+
+  ASSERT (mVariableCount < MAX_FAKE_VARIABLES);
+  Variable = &mVariables[mVariableCount++];
+  CopyGuid (&Variable->Guid, Guid);
+  Variable->Name       = AllocateCopyPool (StrSize (Name), Name);
+  Variable->Attributes = Attributes;
+  Variable->DataSize   = DataSize;
+  Variable->Data       = AllocatePool (DataSize);
+  Variable->Present    = TRUE;
+  Variable->Locked     = Locked;
+  ASSERT (Variable->Name != NULL && Variable->Data != NULL);
+  for (Index = 0; Index < DataSize; Index++) {
+    Variable->Data[Index] = (UINT8)(Seed + Index);
+  }
+}
+
+/**
+  Check one snapshot entry against a store variable.
+**/
+STATIC
+BOOLEAN
+EntryMatchesVariable (
+  IN CONST VAR_SNAPSHOT        *Snapshot,
+  IN CONST VAR_SNAPSHOT_ENTRY  *Entry,
+  IN CONST FAKE_VARIABLE       *Variable
+  )
+{
+  return CompareGuid (&Entry->Guid, &Variable->Guid) &&
+         (StrCmp (VarSnapshotName (Snapshot, Entry), Variable->Name) == 0) &&
+         (Entry->Attributes == Variable->Attributes) &&
+         (Entry->DataSize == Variable->DataSize) &&
+         (CompareMem (VarSnapshotData (Snapshot, Entry), Variable->Data, Variable->DataSize) == 0);
+}
+
+/**
+  Store of PROBE_VARIABLES variables where every fifth one is locked.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BuildProbeStore (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR16  Name[32];
+  UINTN   Index;
+
+  for (Index = 0; Index < PROBE_VARIABLES; Index++) {
+    UnicodeSPrint (Name, sizeof (Name), L"ProbeVar%04d", Index);
+    AddFakeVariable (
+      (Index % 2 == 0) ? &mTestGuid : &mOtherGuid,
+      Name,
+      EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+      16 + Index,
+      (UINT8)Index,
+      (Index % 5) == 0
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Store with thousands of variables, some with names longer than the initial
+  name buffer and some with data larger than the initial data buffer.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+BuildManyStore (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR16  Name[LONG_NAME_LENGTH + 1];
+  UINTN   Index;
+  UINTN   Length;
+
+  for (Index = 0; Index < MANY_VARIABLES; Index++) {
+    UnicodeSPrint (Name, sizeof (Name), L"Var%05d", Index);
+    if ((Index % 100) == 7) {
+      for (Length = StrLen (Name); Length < LONG_NAME_LENGTH; Length++) {
+        Name[Length] = (CHAR16)(L'a' + (Length % 26));
+      }
+
+      Name[Length] = L'\0';
+    }
+
+    AddFakeVariable (
+      (Index % 3 == 0) ? &mOtherGuid : &mTestGuid,
+      Name,
+      EFI_VARIABLE_BOOTSERVICE_ACCESS | ((Index % 2) ? EFI_VARIABLE_RUNTIME_ACCESS : 0),
+      ((Index % 500) == 499) ? LARGE_DATA_SIZE : (Index % 64),
+      (UINT8)Index,
+      FALSE
+      );
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Empty the store and reset the call counters.
+**/
+STATIC
+VOID
+EFIAPI
+ResetStore (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < mVariableCount; Index++) {
+    FreePool (mVariables[Index].Name);
+    FreePool (mVariables[Index].Data);
+  }
+
+  ZeroMem (mVariables, sizeof (mVariables));
+  mVariableCount             = 0;
+  mGetNextVariableNameCalls  = 0;
+  mGetNextVariableNameFailAt = 0;
+  mSetVariableCalls          = 0;
+}
+
+/**
+  Every variable is captured once, in store order, including long names and
+  large data that need the scratch buffers to grow.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SnapshotCapturesEveryVariable (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VAR_SNAPSHOT  Snapshot;
+  UINTN         Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (VarSnapshotCreate (&Snapshot));
+  UT_ASSERT_EQUAL (Snapshot.Count, MANY_VARIABLES);
+
+  for (Index = 0; Index < Snapshot.Count; Index++) {
+    UT_ASSERT_TRUE (EntryMatchesVariable (&Snapshot, &Snapshot.Entries[Index], &mVariables[Index]));
+    UT_ASSERT_EQUAL (Snapshot.Entries[Index].ReadStatus, EFI_NOT_STARTED);
+    UT_ASSERT_EQUAL (Snapshot.Entries[Index].WriteStatus, EFI_NOT_STARTED);
+  }
+
+  // One call per variable, one per name that outgrew the buffer, one to end
+  UT_ASSERT_TRUE (mGetNextVariableNameCalls <= MANY_VARIABLES + 2);
+  UT_ASSERT_EQUAL (mSetVariableCalls, 0);
+
+  VarSnapshotFree (&Snapshot);
+  UT_ASSERT_EQUAL (Snapshot.Count, 0);
+  UT_ASSERT_TRUE (Snapshot.Arena == NULL);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Unlocked variables are deleted and put back, locked ones report
+  EFI_WRITE_PROTECTED, and the store ends up as it started.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ProbeRestoresAndReportsLocked (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VAR_SNAPSHOT  Snapshot;
+  UINTN         Index;
+  UINTN         Locked;
+
+  UT_ASSERT_NOT_EFI_ERROR (VarSnapshotCreate (&Snapshot));
+  UT_ASSERT_EQUAL (Snapshot.Count, PROBE_VARIABLES);
+  UT_ASSERT_NOT_EFI_ERROR (VarSnapshotProbe (&Snapshot));
+
+  Locked = 0;
+  for (Index = 0; Index < Snapshot.Count; Index++) {
+    UT_ASSERT_EQUAL (Snapshot.Entries[Index].ReadStatus, EFI_SUCCESS);
+    if (mVariables[Index].Locked) {
+      UT_ASSERT_EQUAL (Snapshot.Entries[Index].WriteStatus, EFI_WRITE_PROTECTED);
+      Locked++;
+    } else {
+      UT_ASSERT_EQUAL (Snapshot.Entries[Index].WriteStatus, EFI_SUCCESS);
+    }
+
+    // Store is back to what the snapshot saw
+    UT_ASSERT_TRUE (mVariables[Index].Present);
+    UT_ASSERT_TRUE (EntryMatchesVariable (&Snapshot, &Snapshot.Entries[Index], &mVariables[Index]));
+  }
+
+  // A delete for every variable and a restore for every unlocked one
+  UT_ASSERT_EQUAL (mSetVariableCalls, Locked + 2 * (PROBE_VARIABLES - Locked));
+
+  VarSnapshotFree (&Snapshot);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A variable that disappears between the snapshot and the probe is reported
+  with its read error and is never written.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ProbeSkipsVanishedVariable (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VAR_SNAPSHOT  Snapshot;
+
+  UT_ASSERT_NOT_EFI_ERROR (VarSnapshotCreate (&Snapshot));
+  UT_ASSERT_EQUAL (Snapshot.Count, PROBE_VARIABLES);
+
+  mVariables[3].Present = FALSE;
+  UT_ASSERT_NOT_EFI_ERROR (VarSnapshotProbe (&Snapshot));
+
+  UT_ASSERT_EQUAL (Snapshot.Entries[3].ReadStatus, EFI_NOT_FOUND);
+  UT_ASSERT_EQUAL (Snapshot.Entries[3].WriteStatus, EFI_NOT_STARTED);
+  UT_ASSERT_FALSE (mVariables[3].Present);
+
+  // Neighbours are still probed normally
+  UT_ASSERT_EQUAL (Snapshot.Entries[2].WriteStatus, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (Snapshot.Entries[4].WriteStatus, EFI_SUCCESS);
+
+  VarSnapshotFree (&Snapshot);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A variable that grew past the probe scratch buffer after the snapshot is
+  read in full and restored with its new data.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ProbeRestoresGrownVariable (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VAR_SNAPSHOT   Snapshot;
+  FAKE_VARIABLE  *Variable;
+  UINT8          *Grown;
+
+  UT_ASSERT_NOT_EFI_ERROR (VarSnapshotCreate (&Snapshot));
+
+  Variable = &mVariables[1];
+  UT_ASSERT_FALSE (Variable->Locked);
+  Grown = AllocatePool (LARGE_DATA_SIZE);
+  UT_ASSERT_NOT_NULL (Grown);
+  SetMem (Grown, LARGE_DATA_SIZE, 0xA5);
+  FreePool (Variable->Data);
+  Variable->Data     = Grown;
+  Variable->DataSize = LARGE_DATA_SIZE;
+
+  UT_ASSERT_NOT_EFI_ERROR (VarSnapshotProbe (&Snapshot));
+  UT_ASSERT_EQUAL (Snapshot.Entries[1].ReadStatus, EFI_SUCCESS);
+  UT_ASSERT_EQUAL (Snapshot.Entries[1].WriteStatus, EFI_SUCCESS);
+  UT_ASSERT_TRUE (Variable->Present);
+  UT_ASSERT_EQUAL (Variable->DataSize, LARGE_DATA_SIZE);
+  UT_ASSERT_EQUAL (Variable->Data[0], 0xA5);
+  UT_ASSERT_EQUAL (Variable->Data[LARGE_DATA_SIZE - 1], 0xA5);
+
+  VarSnapshotFree (&Snapshot);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  An enumeration error part way through keeps the variables found so far.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+EnumerationErrorKeepsPartialSnapshot (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  VAR_SNAPSHOT  Snapshot;
+  UINTN         Index;
+
+  mGetNextVariableNameFailAt = ENUM_FAIL_AFTER + 1;
+  UT_ASSERT_NOT_EFI_ERROR (VarSnapshotCreate (&Snapshot));
+  UT_ASSERT_EQUAL (Snapshot.Count, ENUM_FAIL_AFTER);
+
+  for (Index = 0; Index < Snapshot.Count; Index++) {
+    UT_ASSERT_TRUE (EntryMatchesVariable (&Snapshot, &Snapshot.Entries[Index], &mVariables[Index]));
+  }
+
+  VarSnapshotFree (&Snapshot);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  variable snapshot and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SnapshotTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&SnapshotTests, Framework, "Variable Snapshot Tests", "UefiVarLockAudit.Snapshot", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Variable Snapshot Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (SnapshotTests, "Snapshot captures every variable", "ManyVariables", SnapshotCapturesEveryVariable, BuildManyStore, ResetStore, NULL);
+  AddTestCase (SnapshotTests, "Probe restores variables and reports locked ones", "ProbeLocked", ProbeRestoresAndReportsLocked, BuildProbeStore, ResetStore, NULL);
+  AddTestCase (SnapshotTests, "Probe skips a variable that vanished", "ProbeVanished", ProbeSkipsVanishedVariable, BuildProbeStore, ResetStore, NULL);
+  AddTestCase (SnapshotTests, "Probe restores a variable that grew", "ProbeGrown", ProbeRestoresGrownVariable, BuildProbeStore, ResetStore, NULL);
+  AddTestCase (SnapshotTests, "Enumeration error keeps the partial snapshot", "EnumError", EnumerationErrorKeepsPartialSnapshot, BuildProbeStore, ResetStore, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
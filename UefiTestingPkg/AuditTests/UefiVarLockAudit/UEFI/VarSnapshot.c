@@ -0,0 +1,371 @@
+/** @file
+  Snapshot of every variable visible through GetNextVariableName, and the
+  delete/restore probe run over it.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  **/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+#include "VarSnapshot.h"
+
+#define INITIAL_NAME_SIZE       (256 * sizeof (CHAR16))
+#define INITIAL_DATA_SIZE       SIZE_4KB
+#define INITIAL_ENTRY_CAPACITY  (256)
+#define INITIAL_ARENA_SIZE      SIZE_64KB
+
+/**
+  Make sure Buffer can hold Needed bytes, keeping its contents.
+**/
+STATIC
+EFI_STATUS
+GrowBuffer (
+  IN OUT VOID   **Buffer,
+  IN OUT UINTN  *BufferSize,
+  IN     UINTN  Needed
+  )
+{
+  VOID   *NewBuffer;
+  UINTN  NewSize;
+
+  if (Needed <= *BufferSize) {
+    return EFI_SUCCESS;
+  }
+
+  NewSize   = MAX (Needed, *BufferSize * 2);
+  NewBuffer = ReallocatePool (*BufferSize, NewSize, *Buffer);
+  if (NewBuffer == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to grow buffer to 0x%X bytes\n", __FUNCTION__, NewSize));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  *Buffer     = NewBuffer;
+  *BufferSize = NewSize;
+  return EFI_SUCCESS;
+}
+
+/**
+  GetVariable into a scratch buffer, growing the buffer when it is too small.
+
+  @param[in]      Name        Variable name.
+  @param[in]      Guid        Variable guid.
+  @param[out]     Attributes  Variable attributes.
+  @param[in,out]  Buffer      Scratch buffer, may be reallocated.
+  @param[in,out]  BufferSize  Size of Buffer.
+  @param[out]     DataSize    Size of the variable data in Buffer.
+**/
+STATIC
+EFI_STATUS
+ReadVariable (
+  IN     CHAR16    *Name,
+  IN     EFI_GUID  *Guid,
+  OUT    UINT32    *Attributes,
+  IN OUT VOID      **Buffer,
+  IN OUT UINTN     *BufferSize,
+  OUT    UINTN     *DataSize
+  )
+{
+  EFI_STATUS  Status;
+
+  do {
+    *DataSize = *BufferSize;
+    Status    = gRT->GetVariable (Name, Guid, Attributes, DataSize, *Buffer);
+    if (Status == EFI_BUFFER_TOO_SMALL) {
+      if (*DataSize <= *BufferSize) {
+        // Asking for a buffer we already have would never end
+        return EFI_DEVICE_ERROR;
+      }
+
+      if (EFI_ERROR (GrowBuffer (Buffer, BufferSize, *DataSize))) {
+        return EFI_OUT_OF_RESOURCES;
+      }
+    }
+  } while (Status == EFI_BUFFER_TOO_SMALL);
+
+  return Status;
+}
+
+/**
+  Copy one variable into the snapshot.
+**/
+STATIC
+EFI_STATUS
+AppendEntry (
+  IN OUT VAR_SNAPSHOT  *Snapshot,
+  IN CONST CHAR16      *Name,
+  IN CONST EFI_GUID    *Guid,
+  IN UINT32            Attributes,
+  IN CONST VOID        *Data,
+  IN UINTN             DataSize
+  )
+{
+  VAR_SNAPSHOT_ENTRY  *Entry;
+  UINTN               NameSize;
+  UINTN               NameOffset;
+  UINTN               DataOffset;
+  UINTN               EntriesSize;
+  EFI_STATUS          Status;
+
+  if (Snapshot->Count == Snapshot->EntryCapacity) {
+    EntriesSize = Snapshot->EntryCapacity * sizeof (VAR_SNAPSHOT_ENTRY);
+    Status      = GrowBuffer ((VOID **)&Snapshot->Entries, &EntriesSize, EntriesSize + sizeof (VAR_SNAPSHOT_ENTRY));
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Snapshot->EntryCapacity = EntriesSize / sizeof (VAR_SNAPSHOT_ENTRY);
+  }
+
+  NameSize   = StrSize (Name);
+  NameOffset = ALIGN_VALUE (Snapshot->ArenaUsed, sizeof (UINT64));
+  DataOffset = ALIGN_VALUE (NameOffset + NameSize, sizeof (UINT64));
+  Status     = GrowBuffer ((VOID **)&Snapshot->Arena, &Snapshot->ArenaSize, DataOffset + DataSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  CopyMem (Snapshot->Arena + NameOffset, Name, NameSize);
+  CopyMem (Snapshot->Arena + DataOffset, Data, DataSize);
+  Snapshot->ArenaUsed = DataOffset + DataSize;
+
+  Entry = &Snapshot->Entries[Snapshot->Count++];
+  CopyGuid (&Entry->Guid, Guid);
+  Entry->Attributes  = Attributes;
+  Entry->NameOffset  = NameOffset;
+  Entry->DataOffset  = DataOffset;
+  Entry->DataSize    = DataSize;
+  Entry->ReadStatus  = EFI_NOT_STARTED;
+  Entry->WriteStatus = EFI_NOT_STARTED;
+  return EFI_SUCCESS;
+}
+
+/**
+  Enumerate every variable once, capturing name, guid, attributes and data.
+
+  Variables that can not be read are skipped, as are any left after
+  GetNextVariableName fails with something other than EFI_NOT_FOUND.
+
+  @param[out] Snapshot  Snapshot to fill in.  Free with VarSnapshotFree.
+
+  @retval EFI_SUCCESS           The snapshot was taken.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated.
+**/
+EFI_STATUS
+EFIAPI
+VarSnapshotCreate (
+  OUT VAR_SNAPSHOT  *Snapshot
+  )
+{
+  EFI_STATUS  Status;
+  CHAR16      *Name;
+  UINTN       NameBufferSize;
+  UINTN       NameSize;
+  EFI_GUID    Guid;
+  VOID        *Data;
+  UINTN       DataBufferSize;
+  UINTN       DataSize;
+  UINT32      Attributes;
+
+  ZeroMem (Snapshot, sizeof (*Snapshot));
+
+  NameBufferSize          = INITIAL_NAME_SIZE;
+  DataBufferSize          = INITIAL_DATA_SIZE;
+  Snapshot->EntryCapacity = INITIAL_ENTRY_CAPACITY;
+  Snapshot->ArenaSize     = INITIAL_ARENA_SIZE;
+  Name                    = AllocateZeroPool (NameBufferSize);
+  Data                    = AllocatePool (DataBufferSize);
+  Snapshot->Entries       = AllocatePool (Snapshot->EntryCapacity * sizeof (VAR_SNAPSHOT_ENTRY));
+  Snapshot->Arena         = AllocatePool (Snapshot->ArenaSize);
+  if ((Name == NULL) || (Data == NULL) || (Snapshot->Entries == NULL) || (Snapshot->Arena == NULL)) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Exit;
+  }
+
+  ZeroMem (&Guid, sizeof (Guid));
+  while (TRUE) {
+    NameSize = NameBufferSize;
+    Status   = gRT->GetNextVariableName (&NameSize, Name, &Guid);
+    if ((Status == EFI_BUFFER_TOO_SMALL) && (NameSize > NameBufferSize)) {
+      // Name still holds the previous name, which the retry continues from
+      Status = GrowBuffer ((VOID **)&Name, &NameBufferSize, NameSize);
+      if (EFI_ERROR (Status)) {
+        goto Exit;
+      }
+
+      continue;
+    }
+
+    if (EFI_ERROR (Status)) {
+      if (Status != EFI_NOT_FOUND) {
+        DEBUG ((DEBUG_ERROR, "%a - GetNextVariableName failed after %d variables.  Status = %r\n", __FUNCTION__, Snapshot->Count, Status));
+      }
+
+      break;
+    }
+
+    Status = ReadVariable (Name, &Guid, &Attributes, &Data, &DataBufferSize, &DataSize);
+    if (Status == EFI_OUT_OF_RESOURCES) {
+      goto Exit;
+    }
+
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a - Skipping %g::%s.  GetVariable Status = %r\n", __FUNCTION__, &Guid, Name, Status));
+      continue;
+    }
+
+    Status = AppendEntry (Snapshot, Name, &Guid, Attributes, Data, DataSize);
+    if (EFI_ERROR (Status)) {
+      goto Exit;
+    }
+  }
+
+  DEBUG ((DEBUG_INFO, "%a - %d variables, 0x%X bytes of names and data\n", __FUNCTION__, Snapshot->Count, Snapshot->ArenaUsed));
+  Status = EFI_SUCCESS;
+
+Exit:
+  if (Name != NULL) {
+    FreePool (Name);
+  }
+
+  if (Data != NULL) {
+    FreePool (Data);
+  }
+
+  if (EFI_ERROR (Status)) {
+    VarSnapshotFree (Snapshot);
+  }
+
+  return Status;
+}
+
+/**
+  Free everything a snapshot owns.
+
+  @param[in,out]  Snapshot  Snapshot to free.
+**/
+VOID
+EFIAPI
+VarSnapshotFree (
+  IN OUT VAR_SNAPSHOT  *Snapshot
+  )
+{
+  if (Snapshot->Entries != NULL) {
+    FreePool (Snapshot->Entries);
+  }
+
+  if (Snapshot->Arena != NULL) {
+    FreePool (Snapshot->Arena);
+  }
+
+  ZeroMem (Snapshot, sizeof (*Snapshot));
+}
+
+/**
+  Name of a snapshot entry.
+**/
+CONST CHAR16 *
+EFIAPI
+VarSnapshotName (
+  IN CONST VAR_SNAPSHOT        *Snapshot,
+  IN CONST VAR_SNAPSHOT_ENTRY  *Entry
+  )
+{
+  return (CONST CHAR16 *)(Snapshot->Arena + Entry->NameOffset);
+}
+
+/**
+  Data of a snapshot entry.
+**/
+CONST UINT8 *
+EFIAPI
+VarSnapshotData (
+  IN CONST VAR_SNAPSHOT        *Snapshot,
+  IN CONST VAR_SNAPSHOT_ENTRY  *Entry
+  )
+{
+  return Snapshot->Arena + Entry->DataOffset;
+}
+
+/**
+  For every entry read the variable again, try to delete it and put it back
+  if the delete worked.  ReadStatus and WriteStatus of each entry record the
+  read and the delete.  A variable that can no longer be read is not written
+  and gets WriteStatus EFI_NOT_STARTED.
+
+  @param[in,out]  Snapshot  Snapshot to probe.
+
+  @retval EFI_SUCCESS           Every entry was probed.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated.
+**/
+EFI_STATUS
+EFIAPI
+VarSnapshotProbe (
+  IN OUT VAR_SNAPSHOT  *Snapshot
+  )
+{
+  VAR_SNAPSHOT_ENTRY  *Entry;
+  CHAR16              *Name;
+  VOID                *Data;
+  UINTN               DataBufferSize;
+  UINTN               DataSize;
+  UINT32              Attributes;
+  UINTN               Index;
+  EFI_STATUS          Status;
+
+  //
+  // Size the scratch buffer for the largest variable up front so the reads
+  // only have to grow it if a variable grew since the snapshot.
+  //
+  DataBufferSize = INITIAL_DATA_SIZE;
+  for (Index = 0; Index < Snapshot->Count; Index++) {
+    DataBufferSize = MAX (DataBufferSize, Snapshot->Entries[Index].DataSize);
+  }
+
+  Data = AllocatePool (DataBufferSize);
+  if (Data == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = EFI_SUCCESS;
+  for (Index = 0; Index < Snapshot->Count; Index++) {
+    Entry = &Snapshot->Entries[Index];
+    Name  = (CHAR16 *)VarSnapshotName (Snapshot, Entry);
+
+    DEBUG ((DEBUG_VERBOSE, "%a testing write properties for var %g", __FUNCTION__, &Entry->Guid));
+    DEBUG ((DEBUG_VERBOSE, " ::%s", Name));
+    DEBUG ((DEBUG_VERBOSE, "\n"));  // do independent debug print so that we always have newline.  Some names can be long and overrun the debug buffer
+
+    // Get current data - it may have changed since the snapshot
+    Entry->ReadStatus = ReadVariable (Name, &Entry->Guid, &Attributes, &Data, &DataBufferSize, &DataSize);
+    if (Entry->ReadStatus == EFI_OUT_OF_RESOURCES) {
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
+    }
+
+    if (EFI_ERROR (Entry->ReadStatus)) {
+      DEBUG ((DEBUG_ERROR, "%a Failed to read %g::%s.  Status = %r\n", __FUNCTION__, &Entry->Guid, Name, Entry->ReadStatus));
+      Entry->WriteStatus = EFI_NOT_STARTED;
+      continue;
+    }
+
+    // Delete current var
+    Entry->WriteStatus = gRT->SetVariable (Name, &Entry->Guid, Attributes, 0, NULL);
+
+    // restore if needed
+    if (!EFI_ERROR (Entry->WriteStatus)) {
+      if (EFI_ERROR (gRT->SetVariable (Name, &Entry->Guid, Attributes, DataSize, Data))) {
+        DEBUG ((DEBUG_ERROR, "%a failed to restore variable data for %g::%s\n", __FUNCTION__, &Entry->Guid, Name));
+      }
+    }
+  }
+
+  FreePool (Data);
+  return Status;
+}
@@ -0,0 +1,103 @@
+/** @file
+  Snapshot of every variable visible through GetNextVariableName, and the
+  delete/restore probe run over it.
+
+  All names and data live in one arena that only grows, and the probe reuses a
+  single scratch buffer, so the cost of the audit does not depend on one pool
+  allocation per variable.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+  **/
+
+#ifndef VAR_SNAPSHOT_H
+#define VAR_SNAPSHOT_H
+
+#include <Uefi.h>
+
+typedef struct {
+  EFI_GUID      Guid;
+  UINT32        Attributes;
+  UINTN         NameOffset;   // Null terminated CHAR16 name in the arena
+  UINTN         DataOffset;   // DataSize bytes in the arena
+  UINTN         DataSize;
+  EFI_STATUS    ReadStatus;   // Filled in by VarSnapshotProbe
+  EFI_STATUS    WriteStatus;  // Filled in by VarSnapshotProbe
+} VAR_SNAPSHOT_ENTRY;
+
+typedef struct {
+  VAR_SNAPSHOT_ENTRY    *Entries;
+  UINTN                 Count;
+  UINTN                 EntryCapacity;
+  UINT8                 *Arena;
+  UINTN                 ArenaUsed;
+  UINTN                 ArenaSize;
+} VAR_SNAPSHOT;
+
+/**
+  Enumerate every variable once, capturing name, guid, attributes and data.
+
+  Variables that can not be read are skipped, as are any left after
+  GetNextVariableName fails with something other than EFI_NOT_FOUND.
+
+  @param[out] Snapshot  Snapshot to fill in.  Free with VarSnapshotFree.
+
+  @retval EFI_SUCCESS           The snapshot was taken.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated.
+**/
+EFI_STATUS
+EFIAPI
+VarSnapshotCreate (
+  OUT VAR_SNAPSHOT  *Snapshot
+  );
+
+/**
+  Free everything a snapshot owns.
+
+  @param[in,out]  Snapshot  Snapshot to free.
+**/
+VOID
+EFIAPI
+VarSnapshotFree (
+  IN OUT VAR_SNAPSHOT  *Snapshot
+  );
+
+/**
+  Name of a snapshot entry.
+**/
+CONST CHAR16 *
+EFIAPI
+VarSnapshotName (
+  IN CONST VAR_SNAPSHOT        *Snapshot,
+  IN CONST VAR_SNAPSHOT_ENTRY  *Entry
+  );
+
+/**
+  Data of a snapshot entry.
+**/
+CONST UINT8 *
+EFIAPI
+VarSnapshotData (
+  IN CONST VAR_SNAPSHOT        *Snapshot,
+  IN CONST VAR_SNAPSHOT_ENTRY  *Entry
+  );
+
+/**
+  For every entry read the variable again, try to delete it and put it back
+  if the delete worked.  ReadStatus and WriteStatus of each entry record the
+  read and the delete.  A variable that can no longer be read is not written
+  and gets WriteStatus EFI_NOT_STARTED.
+
+  @param[in,out]  Snapshot  Snapshot to probe.
+
+  @retval EFI_SUCCESS           Every entry was probed.
+  @retval EFI_OUT_OF_RESOURCES  Memory could not be allocated.
+**/
+EFI_STATUS
+EFIAPI
+VarSnapshotProbe (
+  IN OUT VAR_SNAPSHOT  *Snapshot
+  );
+
+#endif // VAR_SNAPSHOT_H
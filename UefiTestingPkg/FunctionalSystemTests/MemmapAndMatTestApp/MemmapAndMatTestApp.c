@@ -15,6 +15,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
+#include <Library/MemoryMapValidationLib.h>
 
 #include <Guid/MemoryAttributesTable.h>
 
@@ -22,14 +23,12 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define UNIT_TEST_APP_SHORT_NAME  "MemMap_and_MAT_Test"
 #define UNIT_TEST_APP_VERSION     "1.0"
 
-#define A_IS_BETWEEN_B_AND_C(A, B, C) \
-  (((B) < (A)) && ((A) < (C)))
-
 typedef struct _MEM_MAP_META {
-  UINTN    MapSize;
-  UINTN    EntrySize;
-  UINTN    EntryCount;
-  VOID     *Map;
+  UINTN                          MapSize;
+  UINTN                          EntrySize;
+  UINTN                          EntryCount;
+  VOID                           *Map;
+  MEMORY_MAP_VALIDATION_INDEX    *Index;    // Sorted view of Map for the range tests
 } MEM_MAP_META;
 
 MEM_MAP_META  mLegacyMapMeta;
@@ -61,6 +60,15 @@ DumpDescriptor (
   DEBUG ((DebugLevel, "Attribute - 0x%016lX\n", Descriptor->Attribute));
 } // DumpDescriptor()
 
+EFI_MEMORY_DESCRIPTOR *
+GetDescriptor (
+  IN  MEM_MAP_META  *MapMeta,
+  IN  UINTN         Index
+  )
+{
+  return (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)MapMeta->Map + (Index * MapMeta->EntrySize));
+} // GetDescriptor()
+
 /// ================================================================================================
 /// ================================================================================================
 ///
@@ -343,36 +351,15 @@ EntriesInASingleMapShouldNotOverlapAtAll (
   MEM_MAP_META  *TestMap
   )
 {
-  UNIT_TEST_STATUS       Status = UNIT_TEST_PASSED;
-  UINTN                  LeftIndex, RightIndex;
-  EFI_PHYSICAL_ADDRESS   LeftEnd, RightEnd;
-  EFI_MEMORY_DESCRIPTOR  *LeftDescriptor, *RightDescriptor;
-  BOOLEAN                Ok;
-
-  Ok = TRUE;
-  for (LeftIndex = 0; LeftIndex < TestMap->EntryCount && Ok; LeftIndex++) {
-    LeftDescriptor = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)TestMap->Map + (LeftIndex * TestMap->EntrySize));
-    LeftEnd        = LeftDescriptor->PhysicalStart + EFI_PAGES_TO_SIZE (LeftDescriptor->NumberOfPages) - 1;
-
-    // Start a new loop checking all of the entries in this list against the current one.
-    for (RightIndex = LeftIndex + 1; RightIndex < TestMap->EntryCount && Ok; RightIndex++) {
-      RightDescriptor = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)TestMap->Map + (RightIndex * TestMap->EntrySize));
-      RightEnd        = RightDescriptor->PhysicalStart + EFI_PAGES_TO_SIZE (RightDescriptor->NumberOfPages) - 1;
-
-      // Actually compare the data.
-      if (A_IS_BETWEEN_B_AND_C (RightDescriptor->PhysicalStart, LeftDescriptor->PhysicalStart, LeftEnd) ||
-          A_IS_BETWEEN_B_AND_C (LeftDescriptor->PhysicalStart, RightDescriptor->PhysicalStart, RightEnd))
-      {
-        DumpDescriptor (DEBUG_VERBOSE, L"[LeftDescriptor]", LeftDescriptor);
-        DumpDescriptor (DEBUG_VERBOSE, L"[RightDescriptor]", RightDescriptor);
-        Status = UNIT_TEST_ERROR_TEST_FAILED;
-        Ok     = FALSE;
-        break;
-      }
-    }
+  UINTN  LeftIndex, RightIndex;
+
+  if (MemoryMapValidationFindOverlap (TestMap->Index, &LeftIndex, &RightIndex) == EFI_NOT_FOUND) {
+    return UNIT_TEST_PASSED;
   }
 
-  return Status;
+  DumpDescriptor (DEBUG_VERBOSE, L"[LeftDescriptor]", GetDescriptor (TestMap, LeftIndex));
+  DumpDescriptor (DEBUG_VERBOSE, L"[RightDescriptor]", GetDescriptor (TestMap, RightIndex));
+  return UNIT_TEST_ERROR_TEST_FAILED;
 } // EntriesInASingleMapShouldNotOverlapAtAll()
 
 UNIT_TEST_STATUS
@@ -399,48 +386,30 @@ EntriesBetweenListsShouldNotOverlapBoundaries (
   IN UNIT_TEST_CONTEXT  Context
   )
 {
-  UNIT_TEST_STATUS       Status = UNIT_TEST_PASSED;
-  UINTN                  LegacyIndex, MatIndex;
-  EFI_PHYSICAL_ADDRESS   LegacyEnd, MatEnd;
-  EFI_MEMORY_DESCRIPTOR  *LegacyDescriptor, *MatDescriptor;
-
-  // Create an outer loop for the first list.
-  for (LegacyIndex = 0; LegacyIndex < mLegacyMapMeta.EntryCount; LegacyIndex++) {
-    LegacyDescriptor = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)mLegacyMapMeta.Map + (LegacyIndex * mLegacyMapMeta.EntrySize));
-    LegacyEnd        = LegacyDescriptor->PhysicalStart + EFI_PAGES_TO_SIZE (LegacyDescriptor->NumberOfPages) - 1;
-
-    // Create an inner loop for the second list.
-    for (MatIndex = 0; MatIndex < mMatMapMeta.EntryCount; MatIndex++) {
-      MatDescriptor = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)mMatMapMeta.Map + (MatIndex * mMatMapMeta.EntrySize));
-      MatEnd        = MatDescriptor->PhysicalStart + EFI_PAGES_TO_SIZE (MatDescriptor->NumberOfPages) - 1;
-
-      //
-      // A bondary overlap is defined as an entry that lies across the start OR the end of another entry,
-      // but not both (See diagram).
-      //
-      //    |---------|
-      //    |         |
-      //    |    A    |   |---------|
-      //    |         |   |         |
-      //    |         |   |    B    |
-      //    |         |   |         |
-      //    |---------|   |         |
-      //                  |         |
-      //                  |---------|
-      //
-      if ((A_IS_BETWEEN_B_AND_C (MatDescriptor->PhysicalStart, LegacyDescriptor->PhysicalStart, LegacyEnd) && (MatEnd > LegacyEnd)) ||
-          (A_IS_BETWEEN_B_AND_C (LegacyDescriptor->PhysicalStart, MatDescriptor->PhysicalStart, MatEnd) && (LegacyEnd > MatEnd)))
-      {
-        DEBUG ((DEBUG_VERBOSE, "%a - Overlap between MemoryMaps!\n", __FUNCTION__));
-        DumpDescriptor (DEBUG_VERBOSE, L"[MatDescriptor]", MatDescriptor);
-        DumpDescriptor (DEBUG_VERBOSE, L"[LegacyDescriptor]", LegacyDescriptor);
-        Status = UNIT_TEST_ERROR_TEST_FAILED;
-        break;
-      }
-    }
+  UINTN  LegacyIndex, MatIndex;
+
+  //
+  // A bondary overlap is defined as an entry that lies across the start OR the end of another entry,
+  // but not both (See diagram).
+  //
+  //    |---------|
+  //    |         |
+  //    |    A    |   |---------|
+  //    |         |   |         |
+  //    |         |   |    B    |
+  //    |         |   |         |
+  //    |---------|   |         |
+  //                  |         |
+  //                  |---------|
+  //
+  if (MemoryMapValidationFindBoundaryCrossing (mLegacyMapMeta.Index, mMatMapMeta.Index, &LegacyIndex, &MatIndex) == EFI_NOT_FOUND) {
+    return UNIT_TEST_PASSED;
   }
 
-  return Status;
+  DEBUG ((DEBUG_VERBOSE, "%a - Overlap between MemoryMaps!\n", __FUNCTION__));
+  DumpDescriptor (DEBUG_VERBOSE, L"[MatDescriptor]", GetDescriptor (&mMatMapMeta, MatIndex));
+  DumpDescriptor (DEBUG_VERBOSE, L"[LegacyDescriptor]", GetDescriptor (&mLegacyMapMeta, LegacyIndex));
+  return UNIT_TEST_ERROR_TEST_FAILED;
 } // EntriesBetweenListsShouldNotOverlapBoundaries()
 
 UNIT_TEST_STATUS
@@ -449,52 +418,18 @@ AllEntriesInMatShouldLieWithinAMatchingEntryInMemmap (
   IN UNIT_TEST_CONTEXT  Context
   )
 {
-  UNIT_TEST_STATUS       Status = UNIT_TEST_PASSED;
-  UINTN                  MatIndex, LegacyIndex;
-  EFI_PHYSICAL_ADDRESS   MatEnd, LegacyEnd;
-  EFI_MEMORY_DESCRIPTOR  *MatDescriptor, *LegacyDescriptor;
-  BOOLEAN                MatchFound;
-
-  // Create an outer loop for the first list.
-  for (MatIndex = 0; MatIndex < mMatMapMeta.EntryCount; MatIndex++) {
-    MatDescriptor = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)mMatMapMeta.Map + (MatIndex * mMatMapMeta.EntrySize));
-    MatEnd        = MatDescriptor->PhysicalStart + EFI_PAGES_TO_SIZE (MatDescriptor->NumberOfPages) - 1;
-
-    // Indicate that no match has yet been found for this entry.
-    MatchFound = FALSE;
-
-    // Create an inner loop for the second list.
-    for (LegacyIndex = 0; LegacyIndex < mLegacyMapMeta.EntryCount && !MatchFound; LegacyIndex++) {
-      LegacyDescriptor = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)mLegacyMapMeta.Map + (LegacyIndex * mLegacyMapMeta.EntrySize));
-      LegacyEnd        = LegacyDescriptor->PhysicalStart + EFI_PAGES_TO_SIZE (LegacyDescriptor->NumberOfPages) - 1;
-
-      //
-      // Determine whether this MAT entry lies entirely within this Legacy entry.
-      // An entry lies within if:
-      //    - It starts at the same address or starts within AND
-      //    - It ends at the same address or ends within.
-      //
-      if ((A_IS_BETWEEN_B_AND_C (MatDescriptor->PhysicalStart, LegacyDescriptor->PhysicalStart, LegacyEnd) ||
-           (MatDescriptor->PhysicalStart == LegacyDescriptor->PhysicalStart)) &&
-          (A_IS_BETWEEN_B_AND_C (MatEnd, LegacyDescriptor->PhysicalStart, LegacyEnd) || (MatEnd == LegacyEnd)))
-      {
-        // Now, make sure that the type matches.
-        if (MatDescriptor->Type == LegacyDescriptor->Type) {
-          MatchFound = TRUE;
-        }
-      }
-    }
+  UINTN  MatIndex;
 
-    // If a match was not found for this MAT entry, we have a problem.
-    if (!MatchFound) {
-      DEBUG ((DEBUG_VERBOSE, "%a - MAT entry not found in Legacy MemoryMap!\n", __FUNCTION__));
-      DumpDescriptor (DEBUG_VERBOSE, NULL, MatDescriptor);
-      Status = UNIT_TEST_ERROR_TEST_FAILED;
-      break;
-    }
+  //
+  // Each MAT entry must lie entirely within a single Legacy entry of the same type.
+  //
+  if (MemoryMapValidationFindUncontained (mMatMapMeta.Index, mLegacyMapMeta.Index, &MatIndex) == EFI_NOT_FOUND) {
+    return UNIT_TEST_PASSED;
   }
 
-  return Status;
+  DEBUG ((DEBUG_VERBOSE, "%a - MAT entry not found in Legacy MemoryMap!\n", __FUNCTION__));
+  DumpDescriptor (DEBUG_VERBOSE, NULL, GetDescriptor (&mMatMapMeta, MatIndex));
+  return UNIT_TEST_ERROR_TEST_FAILED;
 } // AllEntriesInMatShouldLieWithinAMatchingEntryInMemmap()
 
 UNIT_TEST_STATUS
@@ -503,70 +438,24 @@ AllMemmapRuntimeCodeAndDataEntriesMustBeEntirelyDescribedByMat (
   IN UNIT_TEST_CONTEXT  Context
   )
 {
-  UNIT_TEST_STATUS       Status = UNIT_TEST_PASSED;
-  UINTN                  LegacyIndex, MatIndex;
-  EFI_PHYSICAL_ADDRESS   LegacyEnd, MatEnd;
-  EFI_MEMORY_DESCRIPTOR  *LegacyDescriptor, *MatDescriptor;
-  EFI_PHYSICAL_ADDRESS   CurrentEntryProgress;
-  BOOLEAN                EntryComplete;
-
-  // Create an outer loop for the first list.
-  for (LegacyIndex = 0; LegacyIndex < mLegacyMapMeta.EntryCount; LegacyIndex++) {
-    LegacyDescriptor = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)mLegacyMapMeta.Map + (LegacyIndex * mLegacyMapMeta.EntrySize));
-    LegacyEnd        = LegacyDescriptor->PhysicalStart + EFI_PAGES_TO_SIZE (LegacyDescriptor->NumberOfPages) - 1;
-
-    // If this entry is not EfiRuntimeServicesCode or EfiRuntimeServicesData, we don't care.
-    if ((LegacyDescriptor->Type != EfiRuntimeServicesCode) && (LegacyDescriptor->Type != EfiRuntimeServicesData)) {
-      continue;   // Just keep looping over other entries.
-    }
+  STATIC CONST UINT32   RuntimeTypes[] = { EfiRuntimeServicesCode, EfiRuntimeServicesData };
+  UINTN                 TypeIndex;
+  UINTN                 LegacyIndex;
+  EFI_PHYSICAL_ADDRESS  GapStart;
 
-    //
-    // Now that we've found an entry of interest, we must make sure that
-    // the entire region is covered by MAT entries.
-    // We'll start by setting a "high water mark" for how much of the current entry has been verified.
-    // Since there's a prerequisite on the MAT entries being in ascending order, we can be confident
-    // that a bottom-up approach will work.
-    //
-    CurrentEntryProgress = LegacyDescriptor->PhysicalStart;
-    EntryComplete        = FALSE;
-
-    // Create an inner loop for the second list.
-    for (MatIndex = 0; MatIndex < mMatMapMeta.EntryCount && !EntryComplete; MatIndex++) {
-      MatDescriptor = (EFI_MEMORY_DESCRIPTOR *)((UINT8 *)mMatMapMeta.Map + (MatIndex * mMatMapMeta.EntrySize));
-      MatEnd        = MatDescriptor->PhysicalStart + EFI_PAGES_TO_SIZE (MatDescriptor->NumberOfPages) - 1;
-
-      // If this entry doesn't match the type we're looking for, then it's of no interest.
-      if (LegacyDescriptor->Type != MatDescriptor->Type) {
-        continue;
-      }
-
-      //
-      // If the start is the same as the high-water mark, we can remove the size from
-      // the "unaccounted" region of the current entry.
-      //
-      if ((CurrentEntryProgress == MatDescriptor->PhysicalStart) ||
-          A_IS_BETWEEN_B_AND_C (CurrentEntryProgress, MatDescriptor->PhysicalStart, MatEnd))
-      {
-        CurrentEntryProgress = MatEnd + 1;
-      }
-
-      // If the progress has now covered the entire entry, we're good.
-      if (CurrentEntryProgress > LegacyEnd) {
-        EntryComplete = TRUE;
-        break;
-      }
-    }
-
-    // If we never completed this entry, we're borked.
-    if (!EntryComplete) {
-      DEBUG ((DEBUG_VERBOSE, "%a - Legacy MemoryMap entry not covered by MAT entries!\n", __FUNCTION__));
-      DumpDescriptor (DEBUG_VERBOSE, NULL, LegacyDescriptor);
-      Status = UNIT_TEST_ERROR_TEST_FAILED;
-      break;
+  //
+  // Every EfiRuntimeServicesCode and EfiRuntimeServicesData entry must be covered from start to end
+  // by MAT entries of the same type. Several MAT entries may describe one Legacy entry together.
+  //
+  for (TypeIndex = 0; TypeIndex < ARRAY_SIZE (RuntimeTypes); TypeIndex++) {
+    if (MemoryMapValidationFindCoverageGap (mLegacyMapMeta.Index, mMatMapMeta.Index, RuntimeTypes[TypeIndex], &LegacyIndex, &GapStart) != EFI_NOT_FOUND) {
+      DEBUG ((DEBUG_VERBOSE, "%a - Legacy MemoryMap entry not covered by MAT entries at 0x%016lX!\n", __FUNCTION__, GapStart));
+      DumpDescriptor (DEBUG_VERBOSE, NULL, GetDescriptor (&mLegacyMapMeta, LegacyIndex));
+      return UNIT_TEST_ERROR_TEST_FAILED;
     }
   }
 
-  return Status;
+  return UNIT_TEST_PASSED;
 } // AllMemmapRuntimeCodeAndDataEntriesMustBeEntirelyDescribedByMat()
 
 /// ================================================================================================
@@ -643,6 +532,16 @@ InitializeTestEnvironment (
   mMatMapMeta.EntryCount = MatMap->NumberOfEntries;
   mMatMapMeta.Map        = (VOID *)((UINT8 *)MatMap + sizeof (*MatMap));
 
+  //
+  // Sort both maps once for the range tests.
+  //
+  Status = MemoryMapValidationCreateIndex (mLegacyMapMeta.Map, mLegacyMapMeta.MapSize, mLegacyMapMeta.EntrySize, &mLegacyMapMeta.Index);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Status = MemoryMapValidationCreateIndex (mMatMapMeta.Map, mMatMapMeta.MapSize, mMatMapMeta.EntrySize, &mMatMapMeta.Index);
+
   return Status;
 } // InitializeTestEnvironment()
 
@@ -736,8 +635,6 @@ MemmapAndMatTestApp (
   AddTestCase (TableEntryRangeTests, "Entries in MAT should not overlap each other at all", "Security.MAT.MatEntryOverlap", EntriesInMatMapShouldNotOverlapAtAll, NULL, NULL, NULL);
   AddTestCase (TableEntryRangeTests, "Entries in one list should not overlap any of the boundaries of entries in the other", "Security.MAT.EntryOverlap", EntriesBetweenListsShouldNotOverlapBoundaries, NULL, NULL, NULL);
   AddTestCase (TableEntryRangeTests, "All MAT entries should lie entirely within a standard MemoryMap entry of the same type", "Security.MAT.EntriesWithinMemMap", AllEntriesInMatShouldLieWithinAMatchingEntryInMemmap, NULL, NULL, NULL);
-  // NOTE: For this test, it would be ideal for the AllMatEntriesMustBeInAscendingOrder test to be a prereq, but since the prototype for
-  //       a test case and a prereq are now different (and since I'm too lazy to write a wrapper function...) here we are.
   AddTestCase (
     TableEntryRangeTests,
     "All EfiRuntimeServicesCode and EfiRuntimeServicesData entries in standard MemoryMap must be entirely described by MAT",
@@ -759,6 +656,9 @@ EXIT:
     FreePool (mLegacyMapMeta.Map);
   }
 
+  MemoryMapValidationFreeIndex (mLegacyMapMeta.Index);
+  MemoryMapValidationFreeIndex (mMatMapMeta.Index);
+
   if (Fw) {
     FreeUnitTestFramework (Fw);
   }
@@ -841,6 +841,7 @@ UefiPageGuard (
   MEMORY_PROTECTION_TEST_CONTEXT  MemoryProtectionContext = (*(MEMORY_PROTECTION_TEST_CONTEXT *)Context);
   EFI_PHYSICAL_ADDRESS            ptr;
   EFI_STATUS                      Status;
+  BOOLEAN                         Missed = FALSE;
 
   DEBUG ((DEBUG_INFO, "%a - Testing Type: %a\n", __FUNCTION__, MEMORY_TYPES[MemoryProtectionContext.TargetMemoryType]));
 
@@ -860,9 +861,13 @@ UefiPageGuard (
     // Hit the head guard page
     HeadPageTest ((UINT64 *)(UINTN)ptr);
 
+    //
+    // Record a missing head guard and still check the tail guard.
+    //
     if (GetIgnoreNextEx ()) {
-      UT_LOG_ERROR ("Head guard page failed: %p", ptr);
-      UT_ASSERT_FALSE (GetIgnoreNextEx ());
+      UT_LOG_ERROR ("Head guard page failed for type %a: %p", MEMORY_TYPES[MemoryProtectionContext.TargetMemoryType], ptr);
+      ExPersistClearIgnoreNextPageFault ();
+      Missed = TRUE;
     }
 
     UT_ASSERT_NOT_EFI_ERROR (mNonstopModeProtocol->ResetPageAttributes ());
@@ -872,11 +877,13 @@ UefiPageGuard (
     TailPageTest ((UINT64 *)(UINTN)ptr);
 
     if (GetIgnoreNextEx ()) {
-      UT_LOG_ERROR ("Tail guard page failed: %p", ptr);
-      UT_ASSERT_FALSE (GetIgnoreNextEx ());
+      UT_LOG_ERROR ("Tail guard page failed for type %a: %p", MEMORY_TYPES[MemoryProtectionContext.TargetMemoryType], ptr);
+      ExPersistClearIgnoreNextPageFault ();
+      Missed = TRUE;
     }
 
     UT_ASSERT_NOT_EFI_ERROR (mNonstopModeProtocol->ResetPageAttributes ());
+    UT_ASSERT_FALSE (Missed);
 
     return UNIT_TEST_PASSED;
   }
@@ -943,7 +950,8 @@ UefiPoolGuard (
   UINT64                          *ptr;
   EFI_STATUS                      Status;
   UINTN                           AllocationSize;
-  UINT8                           Index = 0;
+  UINT8                           Index  = 0;
+  BOOLEAN                         Missed = FALSE;
 
   DEBUG ((DEBUG_INFO, "%a - Testing Type: %a\n", __FUNCTION__, MEMORY_TYPES[MemoryProtectionContext.TargetMemoryType]));
 
@@ -973,15 +981,32 @@ UefiPoolGuard (
 
       if (EFI_ERROR (Status)) {
         UT_LOG_WARNING ("Memory allocation failed for type %a of size %x - %r\n", MEMORY_TYPES[MemoryProtectionContext.TargetMemoryType], AllocationSize, Status);
+        //
+        // A guard already found missing is a failure, not a skip.
+        //
+        if (Missed) {
+          break;
+        }
+
         return UNIT_TEST_SKIPPED;
       }
 
       PoolTest ((UINT64 *)ptr, AllocationSize);
 
-      UT_ASSERT_FALSE (GetIgnoreNextEx ());
+      //
+      // Record a missing pool guard and move on to the next pool size.
+      //
+      if (GetIgnoreNextEx ()) {
+        UT_LOG_ERROR ("Pool guard failed for type %a of size %x: %p", MEMORY_TYPES[MemoryProtectionContext.TargetMemoryType], AllocationSize, ptr);
+        ExPersistClearIgnoreNextPageFault ();
+        Missed = TRUE;
+      }
+
       UT_ASSERT_NOT_EFI_ERROR (mNonstopModeProtocol->ResetPageAttributes ());
     }
 
+    UT_ASSERT_FALSE (Missed);
+
     return UNIT_TEST_PASSED;
   }
 
@@ -1243,7 +1268,13 @@ UefiNxProtection (
 
     FreePool (ptr);
 
-    UT_ASSERT_FALSE (GetIgnoreNextEx ());
+    if (GetIgnoreNextEx ()) {
+      UT_LOG_ERROR ("NX Test failed for type %a: %p", MEMORY_TYPES[MemoryProtectionContext.TargetMemoryType], ptr);
+      ExPersistClearIgnoreNextPageFault ();
+      UT_ASSERT_NOT_EFI_ERROR (mNonstopModeProtocol->ResetPageAttributes ());
+      return UNIT_TEST_ERROR_TEST_FAILED;
+    }
+
     UT_ASSERT_NOT_EFI_ERROR (mNonstopModeProtocol->ResetPageAttributes ());
 
     return UNIT_TEST_PASSED;
@@ -0,0 +1,335 @@
+/** @file
+  Benchmarks for the MP management test app: latency of AP power transitions
+  through the MP management protocol, and throughput of StartupAllAPs style
+  dispatch through the MP services protocol.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PerfStatsLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiLib.h>
+
+#include "MpManagementBenchmark.h"
+
+///
+/// Shared by the BSP and every AP running DispatchWorkItem.
+///
+typedef struct {
+  EFI_MP_SERVICES_PROTOCOL    *MpServices;
+  UINT8                       *Payload;
+  UINTN                       PayloadSize;
+  volatile UINT64             *Runs;    // Rounds run, per processor
+} MP_BENCH_DISPATCH_CONTEXT;
+
+/**
+  Empty a latency histogram and its failure count.
+
+  @param[out] Latency   The latencies to reset.
+**/
+STATIC
+VOID
+LatencyReset (
+  OUT MP_BENCH_LATENCY  *Latency
+  )
+{
+  Latency->Failures = 0;
+  PerfStatsHistogramReset (&Latency->Latency);
+}
+
+/**
+  Print a one line summary of a latency histogram followed by its non-empty
+  buckets.
+
+  @param[in]  Label       Name of the row.
+  @param[in]  Latency     The latencies to print.
+**/
+VOID
+MpBenchLatencyPrint (
+  IN CONST CHAR16            *Label,
+  IN CONST MP_BENCH_LATENCY  *Latency
+  )
+{
+  CONST PERF_STATS_HISTOGRAM  *Histogram;
+  UINTN                       Bucket;
+
+  Histogram = &Latency->Latency;
+  if (Histogram->Count == 0) {
+    Print (L"  %-10s n=0 fail=%ld\n", Label, Latency->Failures);
+    return;
+  }
+
+  Print (
+    L"  %-10s n=%ld fail=%ld min=%ldns avg=%ldns p50=%ldns p99=%ldns max=%ldns\n",
+    Label,
+    Histogram->Count,
+    Latency->Failures,
+    Histogram->Min,
+    DivU64x64Remainder (Histogram->Sum, Histogram->Count, NULL),
+    PerfStatsHistogramPercentile (Histogram, 500),
+    PerfStatsHistogramPercentile (Histogram, 990),
+    Histogram->Max
+    );
+
+  for (Bucket = 0; Bucket < PERF_STATS_BUCKETS; Bucket++) {
+    if (Histogram->Buckets[Bucket] != 0) {
+      Print (L"    <= %16ldns  %ld\n", PerfStatsHistogramBucketLimit (Bucket), Histogram->Buckets[Bucket]);
+    }
+  }
+}
+
+/**
+  Count the outcome of one transition of an AP.
+
+  @param[in]      MpManagement  MP management protocol.
+  @param[in]      Status        What the transition returned.
+  @param[in,out]  Core          The AP the transition ran on.
+  @param[in]      Transition    Which transition it was.
+  @param[in,out]  Aggregate     Latencies over all APs.
+
+  @return Status, or the failure to read the latency.
+**/
+STATIC
+EFI_STATUS
+RecordTransition (
+  IN     MP_MANAGEMENT_PROTOCOL  *MpManagement,
+  IN     EFI_STATUS              Status,
+  IN OUT MP_BENCH_CORE_RESULT    *Core,
+  IN     MP_BENCH_TRANSITION     Transition,
+  IN OUT MP_BENCH_LATENCY        *Aggregate
+  )
+{
+  UINT64  LatencyNs;
+
+  if (!EFI_ERROR (Status)) {
+    Status = MpManagement->ApGetTransitionLatency (MpManagement, Core->ProcessorNumber, &LatencyNs);
+  }
+
+  if (EFI_ERROR (Status)) {
+    Core->Transitions[Transition].Failures++;
+    Aggregate[Transition].Failures++;
+    return Status;
+  }
+
+  PerfStatsHistogramAdd (&Core->Transitions[Transition].Latency, LatencyNs);
+  PerfStatsHistogramAdd (&Aggregate[Transition].Latency, LatencyNs);
+  return EFI_SUCCESS;
+}
+
+/**
+  Cycle each AP through on, suspend, resume and off Iterations times, one AP
+  at a time, and count the latency the driver reports for every transition.
+
+  Every AP must be off on entry and is left off. A failed transition is
+  counted as a failure and ends the run for that AP; the other APs still run.
+
+  @param[in]      MpManagement      MP management protocol.
+  @param[in]      Iterations        Cycles to run on each AP.
+  @param[in]      SuspendState      Power state to suspend the APs to.
+  @param[in]      SuspendPowerLevel Power level paired with SuspendState.
+  @param[in,out]  Cores             One entry per AP to cycle.
+  @param[in]      CoreCount         Number of entries in Cores.
+  @param[out]     Aggregate         MpBenchTransitionNum latencies over all APs.
+
+  @retval EFI_SUCCESS   Every cycle completed.
+  @retval Others        The first transition failure.
+**/
+EFI_STATUS
+MpBenchPowerTransitions (
+  IN     MP_MANAGEMENT_PROTOCOL  *MpManagement,
+  IN     UINTN                   Iterations,
+  IN     AP_POWER_STATE          SuspendState,
+  IN     UINTN                   SuspendPowerLevel,
+  IN OUT MP_BENCH_CORE_RESULT    *Cores,
+  IN     UINTN                   CoreCount,
+  OUT    MP_BENCH_LATENCY        *Aggregate
+  )
+{
+  EFI_STATUS            Status;
+  EFI_STATUS            OffStatus;
+  EFI_STATUS            FirstError;
+  MP_BENCH_CORE_RESULT  *Core;
+  UINTN                 CoreIndex;
+  UINTN                 Iteration;
+  UINTN                 Transition;
+
+  for (Transition = 0; Transition < MpBenchTransitionNum; Transition++) {
+    LatencyReset (&Aggregate[Transition]);
+  }
+
+  FirstError = EFI_SUCCESS;
+  for (CoreIndex = 0; CoreIndex < CoreCount; CoreIndex++) {
+    Core = &Cores[CoreIndex];
+    for (Transition = 0; Transition < MpBenchTransitionNum; Transition++) {
+      LatencyReset (&Core->Transitions[Transition]);
+    }
+
+    Status = EFI_SUCCESS;
+    for (Iteration = 0; Iteration < Iterations; Iteration++) {
+      Status = MpManagement->ApOn (MpManagement, Core->ProcessorNumber);
+      Status = RecordTransition (MpManagement, Status, Core, MpBenchApOn, Aggregate);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+
+      Status = MpManagement->ApSuspend (MpManagement, Core->ProcessorNumber, SuspendState, SuspendPowerLevel);
+      Status = RecordTransition (MpManagement, Status, Core, MpBenchApSuspend, Aggregate);
+      if (!EFI_ERROR (Status)) {
+        Status = MpManagement->ApResume (MpManagement, Core->ProcessorNumber);
+        Status = RecordTransition (MpManagement, Status, Core, MpBenchApResume, Aggregate);
+      }
+
+      // Turn the AP off even when the suspend failed so the next AP starts clean
+      OffStatus = MpManagement->ApOff (MpManagement, Core->ProcessorNumber);
+      OffStatus = RecordTransition (MpManagement, OffStatus, Core, MpBenchApOff, Aggregate);
+      if (!EFI_ERROR (Status)) {
+        Status = OffStatus;
+      }
+
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a AP %d failed after %d cycles - %r\n", __FUNCTION__, Core->ProcessorNumber, Iteration, Status));
+      if (!EFI_ERROR (FirstError)) {
+        FirstError = Status;
+      }
+    }
+  }
+
+  return FirstError;
+}
+
+/**
+  Work item run by each AP: read and write this processor's slice of the
+  payload, then count the round.
+
+  @param[in,out]  Buffer  The MP_BENCH_DISPATCH_CONTEXT.
+**/
+STATIC
+VOID
+EFIAPI
+DispatchWorkItem (
+  IN OUT VOID  *Buffer
+  )
+{
+  MP_BENCH_DISPATCH_CONTEXT  *Context;
+  UINT8                      *Slice;
+  UINTN                      ProcessorNumber;
+  UINTN                      Index;
+
+  Context = (MP_BENCH_DISPATCH_CONTEXT *)Buffer;
+  if (EFI_ERROR (Context->MpServices->WhoAmI (Context->MpServices, &ProcessorNumber))) {
+    return;
+  }
+
+  Slice = Context->Payload + ProcessorNumber * Context->PayloadSize;
+  for (Index = 0; Index < Context->PayloadSize; Index++) {
+    Slice[Index] = (UINT8)(Slice[Index] + Index);
+  }
+
+  Context->Runs[ProcessorNumber]++;
+}
+
+/**
+  Dispatch a work item to every enabled AP with blocking StartupAllAPs Rounds
+  times. Each work item reads and writes PayloadSize bytes of its own slice of
+  a shared buffer.
+
+  @param[in]  MpServices    MP services protocol.
+  @param[in]  NumCpus       Number of logical processors.
+  @param[in]  PayloadSize   Bytes each work item touches, may be 0.
+  @param[in]  Rounds        Number of StartupAllAPs calls.
+  @param[out] Result        Latency of each round and the total time.
+
+  @retval EFI_SUCCESS           Every AP that ran, ran every round.
+  @retval EFI_NOT_STARTED       No AP ran.
+  @retval EFI_DEVICE_ERROR      Some AP missed rounds.
+  @retval EFI_OUT_OF_RESOURCES  The payload could not be allocated.
+  @retval Others                StartupAllAPs failed.
+**/
+EFI_STATUS
+MpBenchDispatchThroughput (
+  IN  EFI_MP_SERVICES_PROTOCOL  *MpServices,
+  IN  UINTN                     NumCpus,
+  IN  UINTN                     PayloadSize,
+  IN  UINTN                     Rounds,
+  OUT MP_BENCH_DISPATCH_RESULT  *Result
+  )
+{
+  EFI_STATUS                 Status;
+  MP_BENCH_DISPATCH_CONTEXT  Context;
+  UINT64                     *Runs;
+  UINT64                     RunStart;
+  UINT64                     RoundStart;
+  UINTN                      Round;
+  UINTN                      Index;
+
+  ZeroMem (Result, sizeof (*Result));
+  LatencyReset (&Result->RoundLatency);
+  Result->PayloadSize = PayloadSize;
+  Result->Rounds      = Rounds;
+
+  Runs            = AllocateZeroPool (NumCpus * sizeof (UINT64));
+  Context.Payload = (PayloadSize == 0) ? NULL : AllocateZeroPool (NumCpus * PayloadSize);
+  if ((Runs == NULL) || ((PayloadSize != 0) && (Context.Payload == NULL))) {
+    Status = EFI_OUT_OF_RESOURCES;
+    goto Done;
+  }
+
+  Context.MpServices  = MpServices;
+  Context.PayloadSize = PayloadSize;
+  Context.Runs        = Runs;
+
+  Status   = EFI_SUCCESS;
+  RunStart = GetPerformanceCounter ();
+  for (Round = 0; Round < Rounds; Round++) {
+    RoundStart = GetPerformanceCounter ();
+    Status     = MpServices->StartupAllAPs (MpServices, DispatchWorkItem, FALSE, NULL, 0, &Context, NULL);
+    PerfStatsHistogramAdd (&Result->RoundLatency.Latency, GetTimeInNanoSecond (GetPerformanceCounter () - RoundStart));
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a StartupAllAPs failed in round %d - %r\n", __FUNCTION__, Round, Status));
+      Result->RoundLatency.Failures++;
+      break;
+    }
+  }
+
+  Result->ElapsedNs = GetTimeInNanoSecond (GetPerformanceCounter () - RunStart);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+
+  // Disabled APs and the BSP never run, every other processor must run each round
+  for (Index = 0; Index < NumCpus; Index++) {
+    if (Runs[Index] == Rounds) {
+      Result->ApCount++;
+    } else if (Runs[Index] != 0) {
+      DEBUG ((DEBUG_ERROR, "%a processor %d ran %ld of %d rounds\n", __FUNCTION__, Index, Runs[Index], Rounds));
+      Status = EFI_DEVICE_ERROR;
+    }
+  }
+
+  if (!EFI_ERROR (Status) && (Result->ApCount == 0) && (Rounds != 0)) {
+    Status = EFI_NOT_STARTED;
+  }
+
+Done:
+  if (Runs != NULL) {
+    FreePool (Runs);
+  }
+
+  if (Context.Payload != NULL) {
+    FreePool (Context.Payload);
+  }
+
+  return Status;
+}
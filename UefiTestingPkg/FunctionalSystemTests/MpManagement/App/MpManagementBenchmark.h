@@ -0,0 +1,121 @@
+/** @file
+  Benchmarks for the MP management test app: latency of AP power transitions
+  through the MP management protocol, and throughput of StartupAllAPs style
+  dispatch through the MP services protocol.
+
+  Copyright (C) Microsoft Corporation. All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MP_MANAGEMENT_BENCHMARK_H_
+#define MP_MANAGEMENT_BENCHMARK_H_
+
+#include <Protocol/MpService.h>
+#include <Protocol/MpManagement.h>
+#include <Library/PerfStatsLib.h>
+
+///
+/// Latencies of one kind of operation and the number of times it failed.
+///
+typedef struct {
+  UINT64                  Failures;
+  PERF_STATS_HISTOGRAM    Latency;
+} MP_BENCH_LATENCY;
+
+///
+/// Transitions timed by the power benchmark, in the order a cycle runs them.
+///
+typedef enum {
+  MpBenchApOn,
+  MpBenchApSuspend,
+  MpBenchApResume,
+  MpBenchApOff,
+  MpBenchTransitionNum
+} MP_BENCH_TRANSITION;
+
+///
+/// Latencies of one AP. ProcessorNumber is filled in by the caller.
+///
+typedef struct {
+  UINTN               ProcessorNumber;
+  MP_BENCH_LATENCY    Transitions[MpBenchTransitionNum];
+} MP_BENCH_CORE_RESULT;
+
+typedef struct {
+  UINTN               PayloadSize;
+  UINTN               Rounds;
+  UINTN               ApCount;        // APs that ran every round
+  UINT64              ElapsedNs;
+  MP_BENCH_LATENCY    RoundLatency;
+} MP_BENCH_DISPATCH_RESULT;
+
+/**
+  Print a one line summary of a latency histogram followed by its non-empty
+  buckets.
+
+  @param[in]  Label       Name of the row.
+  @param[in]  Latency     The latencies to print.
+**/
+VOID
+MpBenchLatencyPrint (
+  IN CONST CHAR16            *Label,
+  IN CONST MP_BENCH_LATENCY  *Latency
+  );
+
+/**
+  Cycle each AP through on, suspend, resume and off Iterations times, one AP
+  at a time, and count the latency the driver reports for every transition.
+
+  Every AP must be off on entry and is left off. A failed transition is
+  counted as a failure and ends the run for that AP; the other APs still run.
+
+  @param[in]      MpManagement      MP management protocol.
+  @param[in]      Iterations        Cycles to run on each AP.
+  @param[in]      SuspendState      Power state to suspend the APs to.
+  @param[in]      SuspendPowerLevel Power level paired with SuspendState.
+  @param[in,out]  Cores             One entry per AP to cycle.
+  @param[in]      CoreCount         Number of entries in Cores.
+  @param[out]     Aggregate         MpBenchTransitionNum latencies over all APs.
+
+  @retval EFI_SUCCESS   Every cycle completed.
+  @retval Others        The first transition failure.
+**/
+EFI_STATUS
+MpBenchPowerTransitions (
+  IN     MP_MANAGEMENT_PROTOCOL  *MpManagement,
+  IN     UINTN                   Iterations,
+  IN     AP_POWER_STATE          SuspendState,
+  IN     UINTN                   SuspendPowerLevel,
+  IN OUT MP_BENCH_CORE_RESULT    *Cores,
+  IN     UINTN                   CoreCount,
+  OUT    MP_BENCH_LATENCY        *Aggregate
+  );
+
+/**
+  Dispatch a work item to every enabled AP with blocking StartupAllAPs Rounds
+  times. Each work item reads and writes PayloadSize bytes of its own slice of
+  a shared buffer.
+
+  @param[in]  MpServices    MP services protocol.
+  @param[in]  NumCpus       Number of logical processors.
+  @param[in]  PayloadSize   Bytes each work item touches, may be 0.
+  @param[in]  Rounds        Number of StartupAllAPs calls.
+  @param[out] Result        Latency of each round and the total time.
+
+  @retval EFI_SUCCESS           Every AP that ran, ran every round.
+  @retval EFI_NOT_STARTED       No AP ran.
+  @retval EFI_DEVICE_ERROR      Some AP missed rounds.
+  @retval EFI_OUT_OF_RESOURCES  The payload could not be allocated.
+  @retval Others                StartupAllAPs failed.
+**/
+EFI_STATUS
+MpBenchDispatchThroughput (
+  IN  EFI_MP_SERVICES_PROTOCOL  *MpServices,
+  IN  UINTN                     NumCpus,
+  IN  UINTN                     PayloadSize,
+  IN  UINTN                     Rounds,
+  OUT MP_BENCH_DISPATCH_RESULT  *Result
+  );
+
+#endif // MP_MANAGEMENT_BENCHMARK_H_
@@ -16,8 +16,12 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/TimerLib.h>
+#include <Library/PerfStatsLib.h>
 #include <Protocol/MpService.h>
 #include <Protocol/MpManagement.h>
+#include <Protocol/ShellParameters.h>
+
+#include "MpManagementBenchmark.h"
 
 #define UNIT_TEST_APP_NAME        "MP Management Unit Test"
 #define UNIT_TEST_APP_SHORT_NAME  "Mp_Mgmt_Test"
@@ -27,9 +31,25 @@
 #define BSP_SUSPEND_TIMER_US   1000000
 #define US_TO_NS(a)  (a * 1000)
 
-MP_MANAGEMENT_PROTOCOL  *mMpManagement = NULL;
-UINTN                   mBspIndex      = 0;
-UINTN                   mApDutIndex    = 0;
+#define BENCH_DEFAULT_ITERATIONS  100
+#define BENCH_DISPATCH_ROUNDS     100
+
+MP_MANAGEMENT_PROTOCOL    *mMpManagement = NULL;
+EFI_MP_SERVICES_PROTOCOL  *mMpServices   = NULL;
+UINTN                     mNumCpus       = 0;
+UINTN                     mBspIndex      = 0;
+UINTN                     mApDutIndex    = 0;
+
+///
+/// Payload sizes each AP touches per work item in the dispatch benchmark.
+///
+STATIC CONST UINTN  mBenchPayloadSizes[] = { 0, SIZE_1KB, SIZE_16KB, SIZE_256KB };
+
+///
+/// Names of the rows printed for each transition.
+///
+STATIC CONST CHAR16  *mBenchTransitionNames[MpBenchTransitionNum] = { L"On", L"Suspend", L"Resume", L"Off" };
+STATIC CONST CHAR16  *mBenchStateNames[AP_POWER_NUM]               = { L"C1", L"C2", L"C3" };
 
 /// ================================================================================================
 /// ================================================================================================
@@ -901,6 +921,9 @@ InitializeTestEnvironment (
     goto Done;
   }
 
+  mMpServices = MpServices;
+  mNumCpus    = NumCpus;
+
   Status = gBS->LocateProtocol (
                   &gMpManagementProtocolGuid,
                   NULL,
@@ -916,6 +939,133 @@ Done:
   return Status;
 } // InitializeTestEnvironment()
 
+/**
+  Print the power transition histograms of every AP and of all APs together.
+
+  @param[in] StateName  Name of the suspend state that was benchmarked.
+  @param[in] Cores      Results of each AP.
+  @param[in] CoreCount  Number of entries in Cores.
+  @param[in] Aggregate  Latencies over all APs.
+
+**/
+STATIC
+VOID
+PrintPowerTransitionResults (
+  IN CONST CHAR16                *StateName,
+  IN CONST MP_BENCH_CORE_RESULT  *Cores,
+  IN UINTN                       CoreCount,
+  IN CONST MP_BENCH_LATENCY      *Aggregate
+  )
+{
+  UINTN  CoreIndex;
+  UINTN  Transition;
+
+  for (CoreIndex = 0; CoreIndex < CoreCount; CoreIndex++) {
+    Print (L"AP %d, suspend to %s:\n", Cores[CoreIndex].ProcessorNumber, StateName);
+    for (Transition = 0; Transition < MpBenchTransitionNum; Transition++) {
+      MpBenchLatencyPrint (mBenchTransitionNames[Transition], &Cores[CoreIndex].Transitions[Transition]);
+    }
+  }
+
+  Print (L"All %d APs, suspend to %s:\n", CoreCount, StateName);
+  for (Transition = 0; Transition < MpBenchTransitionNum; Transition++) {
+    MpBenchLatencyPrint (mBenchTransitionNames[Transition], &Aggregate[Transition]);
+  }
+}
+
+/**
+  Benchmark mode. Cycles every AP through on, suspend, resume and off for each
+  suspend state and reports the transition latencies, then measures how fast
+  work items can be dispatched to all APs at a few payload sizes.
+
+  @param[in] Iterations   Power cycles to run on each AP per suspend state.
+
+  @retval EFI_SUCCESS     Every benchmark completed.
+  @retval Others          The first benchmark failure.
+
+**/
+STATIC
+EFI_STATUS
+RunBenchmarks (
+  IN UINTN  Iterations
+  )
+{
+  EFI_STATUS                Status;
+  EFI_STATUS                FirstError;
+  MP_BENCH_CORE_RESULT      *Cores;
+  MP_BENCH_LATENCY          Aggregate[MpBenchTransitionNum];
+  MP_BENCH_DISPATCH_RESULT  Dispatch;
+  UINTN                     CoreCount;
+  UINTN                     Index;
+  UINTN                     State;
+  UINTN                     PowerLevel;
+
+  Cores = AllocateZeroPool (mNumCpus * sizeof (MP_BENCH_CORE_RESULT));
+  if (Cores == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  CoreCount = 0;
+  for (Index = 0; Index < mNumCpus; Index++) {
+    if (Index != mBspIndex) {
+      Cores[CoreCount++].ProcessorNumber = Index;
+    }
+  }
+
+  // Every cycle starts from off, APs already off are fine
+  Status = mMpManagement->ApOff (mMpManagement, OPERATION_FOR_ALL_APS);
+  if (EFI_ERROR (Status) && (Status != EFI_ALREADY_STARTED)) {
+    DEBUG ((DEBUG_ERROR, "%a Failed to power off the APs - %r\n", __FUNCTION__, Status));
+    FreePool (Cores);
+    return Status;
+  }
+
+  FirstError = EFI_SUCCESS;
+  for (State = AP_POWER_C1; State < AP_POWER_NUM; State++) {
+    switch (State) {
+      case AP_POWER_C2:
+        PowerLevel = (UINTN)PcdGet64 (PcdPlatformC2PowerState);
+        break;
+      case AP_POWER_C3:
+        PowerLevel = (UINTN)PcdGet64 (PcdPlatformC3PowerState);
+        break;
+      default:
+        PowerLevel = 0;
+        break;
+    }
+
+    Status = MpBenchPowerTransitions (mMpManagement, Iterations, (AP_POWER_STATE)State, PowerLevel, Cores, CoreCount, Aggregate);
+    PrintPowerTransitionResults (mBenchStateNames[State], Cores, CoreCount, Aggregate);
+    if (EFI_ERROR (Status) && !EFI_ERROR (FirstError)) {
+      FirstError = Status;
+    }
+  }
+
+  FreePool (Cores);
+
+  for (Index = 0; Index < ARRAY_SIZE (mBenchPayloadSizes); Index++) {
+    Status = MpBenchDispatchThroughput (mMpServices, mNumCpus, mBenchPayloadSizes[Index], BENCH_DISPATCH_ROUNDS, &Dispatch);
+    Print (
+      L"Dispatch %d bytes per AP to %d APs, %d rounds - %r\n",
+      Dispatch.PayloadSize,
+      Dispatch.ApCount,
+      Dispatch.Rounds,
+      Status
+      );
+    Print (
+      L"  %ld work items/s, %ld bytes/s\n",
+      PerfStatsPerSecond ((UINT64)Dispatch.ApCount * Dispatch.Rounds, Dispatch.ElapsedNs),
+      PerfStatsPerSecond ((UINT64)Dispatch.ApCount * Dispatch.Rounds * Dispatch.PayloadSize, Dispatch.ElapsedNs)
+      );
+    MpBenchLatencyPrint (L"Round", &Dispatch.RoundLatency);
+    if (EFI_ERROR (Status) && !EFI_ERROR (FirstError)) {
+      FirstError = Status;
+    }
+  }
+
+  return FirstError;
+} // RunBenchmarks()
+
 /**
   MpManagementTestApp entrypoint.
 
@@ -933,11 +1083,14 @@ MpManagementTestApp (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
-  EFI_STATUS                  Status;
-  UNIT_TEST_FRAMEWORK_HANDLE  Fw = NULL;
-  UNIT_TEST_SUITE_HANDLE      BasicOperationTests;
-  UNIT_TEST_SUITE_HANDLE      SuspendOperationTests;
-  UINTN                       Context = PROTOCOL_DOUBLE_CHECK;
+  EFI_STATUS                     Status;
+  UNIT_TEST_FRAMEWORK_HANDLE     Fw = NULL;
+  UNIT_TEST_SUITE_HANDLE         BasicOperationTests;
+  UNIT_TEST_SUITE_HANDLE         SuspendOperationTests;
+  UINTN                          Context = PROTOCOL_DOUBLE_CHECK;
+  EFI_SHELL_PARAMETERS_PROTOCOL  *ShellParams;
+  UINTN                          Iterations;
+  CHAR16                         *End;
 
   DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
 
@@ -950,6 +1103,42 @@ MpManagementTestApp (
     goto EXIT;
   }
 
+  //
+  // Without arguments the unit tests run, "-b [iterations]" runs the benchmarks instead.
+  //
+  Status = gBS->HandleProtocol (
+                  ImageHandle,
+                  &gEfiShellParametersProtocolGuid,
+                  (VOID **)&ShellParams
+                  );
+  if (!EFI_ERROR (Status) && (ShellParams->Argc > 1)) {
+    if (StrCmp (ShellParams->Argv[1], L"-b") == 0) {
+      Iterations = BENCH_DEFAULT_ITERATIONS;
+      if (ShellParams->Argc > 2) {
+        // Reject anything but a whole positive number rather than silently running no cycles
+        Status = StrDecimalToUintnS (ShellParams->Argv[2], &End, &Iterations);
+        if (EFI_ERROR (Status) || (End == ShellParams->Argv[2]) || (*End != L'\0') || (Iterations == 0)) {
+          Print (L"Invalid iteration count \"%s\"!\n", ShellParams->Argv[2]);
+          Status = EFI_INVALID_PARAMETER;
+          goto EXIT;
+        }
+      }
+
+      Status = RunBenchmarks (Iterations);
+    } else {
+      if (StrCmp (ShellParams->Argv[1], L"-h") != 0) {
+        Print (L"Invalid argument!\n");
+      }
+
+      Print (L"-h              : Print available flags\n");
+      Print (L"-b [iterations] : Benchmark AP power transitions (%d iterations by default) and dispatch\n", BENCH_DEFAULT_ITERATIONS);
+      Print (L"No flag         : Run the unit tests\n");
+      Status = EFI_SUCCESS;
+    }
+
+    goto EXIT;
+  }
+
   //
   // Start setting up the test framework for running the tests.
   //
@@ -0,0 +1,538 @@
+/** @file -- MpManagementBenchmarkHostTest.c
+Host-based UnitTest for the MP management benchmarks. The MP management and
+MP services protocols are replaced with fakes that track the power state of
+each processor, report a known latency for every transition and run work
+items on the calling thread.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../MpManagementBenchmark.h"
+
+#define UNIT_TEST_NAME     "MpManagement Benchmark Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define FAKE_NUM_CPUS        4
+#define FAKE_BSP_INDEX       0
+#define FAKE_DISABLED_CPU    3
+#define BENCH_ITERATIONS     5
+#define DISPATCH_ROUNDS      20
+#define DISPATCH_PAYLOAD     64
+#define NO_FAILURE           MAX_UINTN
+
+typedef enum {
+  FakeStateOff,
+  FakeStateOn,
+  FakeStateSuspended
+} FAKE_AP_STATE;
+
+typedef struct {
+  FAKE_AP_STATE    State;
+  UINT64           LastLatency;
+  BOOLEAN          LatencyValid;
+  UINTN            Transitions[MpBenchTransitionNum];
+} FAKE_CPU;
+
+STATIC FAKE_CPU  mCpus[FAKE_NUM_CPUS];
+
+//
+// Failure injection: the suspend of mFailSuspendCpu fails on its
+// mFailSuspendAt'th call. The dispatch skips mSkipDispatchCpu in round
+// mSkipDispatchRound.
+//
+STATIC UINTN  mFailSuspendCpu;
+STATIC UINTN  mFailSuspendAt;
+STATIC UINTN  mSkipDispatchCpu;
+STATIC UINTN  mSkipDispatchRound;
+
+STATIC UINTN   mDispatchRound;
+STATIC UINTN   mCurrentCpu;
+STATIC UINT64  mTick;
+
+/**
+  Latency the fake reports: unique per processor, transition and attempt so
+  the tests can tell exactly which samples were counted.
+**/
+STATIC
+UINT64
+FakeLatency (
+  IN UINTN                CpuIndex,
+  IN MP_BENCH_TRANSITION  Transition
+  )
+{
+  return (CpuIndex + 1) * 10000 + Transition * 1000 + mCpus[CpuIndex].Transitions[Transition];
+}
+
+/**
+  Move a processor between power states the way the driver does.
+**/
+STATIC
+EFI_STATUS
+FakeTransition (
+  IN UINTN                ProcessorNumber,
+  IN MP_BENCH_TRANSITION  Transition,
+  IN FAKE_AP_STATE        From,
+  IN FAKE_AP_STATE        To
+  )
+{
+  FAKE_CPU  *Cpu;
+
+  if ((ProcessorNumber == FAKE_BSP_INDEX) || (ProcessorNumber >= FAKE_NUM_CPUS)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Cpu = &mCpus[ProcessorNumber];
+  if (Cpu->State == To) {
+    return EFI_ALREADY_STARTED;
+  }
+
+  if (Cpu->State != From) {
+    return EFI_ABORTED;
+  }
+
+  Cpu->Transitions[Transition]++;
+  Cpu->LastLatency  = FakeLatency (ProcessorNumber, Transition);
+  Cpu->LatencyValid = TRUE;
+  Cpu->State        = To;
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeApOn (
+  IN  MP_MANAGEMENT_PROTOCOL  *This,
+  IN  UINTN                   ProcessorNumber
+  )
+{
+  return FakeTransition (ProcessorNumber, MpBenchApOn, FakeStateOff, FakeStateOn);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeApOff (
+  IN  MP_MANAGEMENT_PROTOCOL  *This,
+  IN  UINTN                   ProcessorNumber
+  )
+{
+  return FakeTransition (ProcessorNumber, MpBenchApOff, FakeStateOn, FakeStateOff);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeApSuspend (
+  IN  MP_MANAGEMENT_PROTOCOL  *This,
+  IN  UINTN                   ProcessorNumber,
+  IN  AP_POWER_STATE          ApPowerState,
+  IN  UINTN                   TargetPowerLevel  OPTIONAL
+  )
+{
+  if ((ProcessorNumber == mFailSuspendCpu) && (mCpus[ProcessorNumber].Transitions[MpBenchApSuspend] + 1 == mFailSuspendAt)) {
+    mCpus[ProcessorNumber].Transitions[MpBenchApSuspend]++;
+    return EFI_DEVICE_ERROR;
+  }
+
+  return FakeTransition (ProcessorNumber, MpBenchApSuspend, FakeStateOn, FakeStateSuspended);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeApResume (
+  IN  MP_MANAGEMENT_PROTOCOL  *This,
+  IN  UINTN                   ProcessorNumber
+  )
+{
+  return FakeTransition (ProcessorNumber, MpBenchApResume, FakeStateSuspended, FakeStateOn);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeApGetTransitionLatency (
+  IN  MP_MANAGEMENT_PROTOCOL  *This,
+  IN  UINTN                   ProcessorNumber,
+  OUT UINT64                  *Nanoseconds
+  )
+{
+  if ((ProcessorNumber == FAKE_BSP_INDEX) || (ProcessorNumber >= FAKE_NUM_CPUS) || (Nanoseconds == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!mCpus[ProcessorNumber].LatencyValid) {
+    return EFI_NOT_STARTED;
+  }
+
+  *Nanoseconds = mCpus[ProcessorNumber].LastLatency;
+  return EFI_SUCCESS;
+}
+
+STATIC MP_MANAGEMENT_PROTOCOL  mFakeMpManagement = {
+  .ApOn                   = FakeApOn,
+  .ApOff                  = FakeApOff,
+  .ApSuspend              = FakeApSuspend,
+  .ApResume               = FakeApResume,
+  .ApGetTransitionLatency = FakeApGetTransitionLatency
+};
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeWhoAmI (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  OUT UINTN                     *ProcessorNumber
+  )
+{
+  *ProcessorNumber = mCurrentCpu;
+  return EFI_SUCCESS;
+}
+
+/**
+  Runs the procedure once for every enabled AP on the calling thread, with
+  WhoAmI answering for that AP.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+FakeStartupAllAPs (
+  IN  EFI_MP_SERVICES_PROTOCOL  *This,
+  IN  EFI_AP_PROCEDURE          Procedure,
+  IN  BOOLEAN                   SingleThread,
+  IN  EFI_EVENT                 WaitEvent               OPTIONAL,
+  IN  UINTN                     TimeoutInMicroSeconds,
+  IN  VOID                      *ProcedureArgument      OPTIONAL,
+  OUT UINTN                     **FailedCpuList         OPTIONAL
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < FAKE_NUM_CPUS; Index++) {
+    if ((Index == FAKE_BSP_INDEX) || (Index == FAKE_DISABLED_CPU)) {
+      continue;
+    }
+
+    if ((Index == mSkipDispatchCpu) && (mDispatchRound == mSkipDispatchRound)) {
+      continue;
+    }
+
+    mCurrentCpu = Index;
+    Procedure (ProcedureArgument);
+  }
+
+  mCurrentCpu = FAKE_BSP_INDEX;
+  mDispatchRound++;
+  return EFI_SUCCESS;
+}
+
+STATIC EFI_MP_SERVICES_PROTOCOL  mFakeMpServices = {
+  .StartupAllAPs = FakeStartupAllAPs,
+  .WhoAmI        = FakeWhoAmI
+};
+
+/**
+  Every read of the counter advances it, one tick is one nanosecond.
+**/
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  mTick += 10;
+  return mTick;
+}
+
+UINT64
+EFIAPI
+GetTimeInNanoSecond (
+  IN UINT64  Ticks
+  )
+{
+  return Ticks;
+}
+
+/**
+  Output is not checked, UefiLib is not linked into the host test.
+**/
+UINTN
+EFIAPI
+Print (
+  IN CONST CHAR16  *Format,
+  ...
+  )
+{
+  return 0;
+}
+
+/**
+  Put every processor back to off and clear the failure injection.
+**/
+STATIC
+UNIT_TEST_STATUS
+EFIAPI
+ResetFakes (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ZeroMem (mCpus, sizeof (mCpus));
+  mFailSuspendCpu    = NO_FAILURE;
+  mFailSuspendAt     = 0;
+  mSkipDispatchCpu   = NO_FAILURE;
+  mSkipDispatchRound = 0;
+  mDispatchRound     = 0;
+  mCurrentCpu        = FAKE_BSP_INDEX;
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Fill in one core result per AP of the fake.
+**/
+STATIC
+UINTN
+FakeCores (
+  OUT MP_BENCH_CORE_RESULT  *Cores
+  )
+{
+  UINTN  Index;
+  UINTN  Count;
+
+  Count = 0;
+  for (Index = 0; Index < FAKE_NUM_CPUS; Index++) {
+    if (Index != FAKE_BSP_INDEX) {
+      Cores[Count++].ProcessorNumber = Index;
+    }
+  }
+
+  return Count;
+}
+
+/**
+  Each AP is cycled the requested number of times and every transition is
+  counted once per AP and once in the aggregate, with the latency the driver
+  reported.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PowerCycleCountsEveryTransition (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MP_BENCH_CORE_RESULT  Cores[FAKE_NUM_CPUS];
+  MP_BENCH_LATENCY      Aggregate[MpBenchTransitionNum];
+  UINTN                 CoreCount;
+  UINTN                 Index;
+  UINTN                 Transition;
+  UINTN                 Cpu;
+
+  CoreCount = FakeCores (Cores);
+  UT_ASSERT_NOT_EFI_ERROR (MpBenchPowerTransitions (&mFakeMpManagement, BENCH_ITERATIONS, AP_POWER_C1, 0, Cores, CoreCount, Aggregate));
+
+  for (Index = 0; Index < CoreCount; Index++) {
+    Cpu = Cores[Index].ProcessorNumber;
+    UT_ASSERT_EQUAL (mCpus[Cpu].State, FakeStateOff);
+    for (Transition = 0; Transition < MpBenchTransitionNum; Transition++) {
+      UT_ASSERT_EQUAL (Cores[Index].Transitions[Transition].Latency.Count, BENCH_ITERATIONS);
+      UT_ASSERT_EQUAL (Cores[Index].Transitions[Transition].Failures, 0);
+      UT_ASSERT_EQUAL (Cores[Index].Transitions[Transition].Latency.Min, (Cpu + 1) * 10000 + Transition * 1000 + 1);
+      UT_ASSERT_EQUAL (Cores[Index].Transitions[Transition].Latency.Max, (Cpu + 1) * 10000 + Transition * 1000 + BENCH_ITERATIONS);
+    }
+  }
+
+  for (Transition = 0; Transition < MpBenchTransitionNum; Transition++) {
+    UT_ASSERT_EQUAL (Aggregate[Transition].Latency.Count, BENCH_ITERATIONS * CoreCount);
+    UT_ASSERT_EQUAL (Aggregate[Transition].Latency.Min, Cores[0].Transitions[Transition].Latency.Min);
+    UT_ASSERT_EQUAL (Aggregate[Transition].Latency.Max, Cores[CoreCount - 1].Transitions[Transition].Latency.Max);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  A failed suspend is counted, the AP is still turned off, its run ends and
+  the APs after it are still benchmarked.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SuspendFailureEndsOnlyThatAp (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MP_BENCH_CORE_RESULT  Cores[FAKE_NUM_CPUS];
+  MP_BENCH_LATENCY      Aggregate[MpBenchTransitionNum];
+  UINTN                 CoreCount;
+
+  mFailSuspendCpu = 2;
+  mFailSuspendAt  = 3;
+
+  CoreCount = FakeCores (Cores);
+  UT_ASSERT_EQUAL (MpBenchPowerTransitions (&mFakeMpManagement, BENCH_ITERATIONS, AP_POWER_C2, 1, Cores, CoreCount, Aggregate), EFI_DEVICE_ERROR);
+
+  // Cores[1] is processor 2
+  UT_ASSERT_EQUAL (Cores[1].Transitions[MpBenchApOn].Latency.Count, 3);
+  UT_ASSERT_EQUAL (Cores[1].Transitions[MpBenchApSuspend].Latency.Count, 2);
+  UT_ASSERT_EQUAL (Cores[1].Transitions[MpBenchApSuspend].Failures, 1);
+  UT_ASSERT_EQUAL (Cores[1].Transitions[MpBenchApResume].Latency.Count, 2);
+  UT_ASSERT_EQUAL (Cores[1].Transitions[MpBenchApOff].Latency.Count, 3);
+  UT_ASSERT_EQUAL (mCpus[2].State, FakeStateOff);
+
+  UT_ASSERT_EQUAL (Cores[2].Transitions[MpBenchApOff].Latency.Count, BENCH_ITERATIONS);
+  UT_ASSERT_EQUAL (mCpus[3].State, FakeStateOff);
+
+  UT_ASSERT_EQUAL (Aggregate[MpBenchApSuspend].Failures, 1);
+  UT_ASSERT_EQUAL (Aggregate[MpBenchApSuspend].Latency.Count, 2 * BENCH_ITERATIONS + 2);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  An AP that is not off at the start fails its first transition instead of
+  being counted.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ApNotOffIsReported (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MP_BENCH_CORE_RESULT  Cores[FAKE_NUM_CPUS];
+  MP_BENCH_LATENCY      Aggregate[MpBenchTransitionNum];
+  UINTN                 CoreCount;
+
+  mCpus[1].State = FakeStateOn;
+
+  CoreCount = FakeCores (Cores);
+  UT_ASSERT_EQUAL (MpBenchPowerTransitions (&mFakeMpManagement, BENCH_ITERATIONS, AP_POWER_C1, 0, Cores, CoreCount, Aggregate), EFI_ALREADY_STARTED);
+  UT_ASSERT_EQUAL (Cores[0].Transitions[MpBenchApOn].Failures, 1);
+  UT_ASSERT_EQUAL (Cores[0].Transitions[MpBenchApOn].Latency.Count, 0);
+  UT_ASSERT_EQUAL (Cores[1].Transitions[MpBenchApOn].Latency.Count, BENCH_ITERATIONS);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Every enabled AP runs every round and touches its own slice of the payload.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DispatchRunsEveryAp (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MP_BENCH_DISPATCH_RESULT  Result;
+
+  UT_ASSERT_NOT_EFI_ERROR (MpBenchDispatchThroughput (&mFakeMpServices, FAKE_NUM_CPUS, DISPATCH_PAYLOAD, DISPATCH_ROUNDS, &Result));
+  UT_ASSERT_EQUAL (Result.ApCount, FAKE_NUM_CPUS - 2);
+  UT_ASSERT_EQUAL (Result.Rounds, DISPATCH_ROUNDS);
+  UT_ASSERT_EQUAL (Result.PayloadSize, DISPATCH_PAYLOAD);
+  UT_ASSERT_EQUAL (Result.RoundLatency.Latency.Count, DISPATCH_ROUNDS);
+  UT_ASSERT_EQUAL (Result.RoundLatency.Failures, 0);
+  UT_ASSERT_TRUE (Result.ElapsedNs >= Result.RoundLatency.Latency.Sum);
+
+  ResetFakes (NULL);
+  UT_ASSERT_NOT_EFI_ERROR (MpBenchDispatchThroughput (&mFakeMpServices, FAKE_NUM_CPUS, 0, DISPATCH_ROUNDS, &Result));
+  UT_ASSERT_EQUAL (Result.ApCount, FAKE_NUM_CPUS - 2);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  An AP that misses a round fails the run.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+DispatchMissedRoundIsError (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  MP_BENCH_DISPATCH_RESULT  Result;
+
+  mSkipDispatchCpu   = 2;
+  mSkipDispatchRound = 7;
+  UT_ASSERT_EQUAL (MpBenchDispatchThroughput (&mFakeMpServices, FAKE_NUM_CPUS, DISPATCH_PAYLOAD, DISPATCH_ROUNDS, &Result), EFI_DEVICE_ERROR);
+  UT_ASSERT_EQUAL (Result.ApCount, 1);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the MP
+  management benchmarks and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      BenchmarkTests;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&BenchmarkTests, Framework, "MpManagement Benchmark Tests", "MpManagement.Benchmark", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for MpManagement Benchmark Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (BenchmarkTests, "Power cycle counts every transition", "PowerCycle", PowerCycleCountsEveryTransition, ResetFakes, NULL, NULL);
+  AddTestCase (BenchmarkTests, "Suspend failure ends only that AP", "SuspendFailure", SuspendFailureEndsOnlyThatAp, ResetFakes, NULL, NULL);
+  AddTestCase (BenchmarkTests, "AP that is not off is reported", "ApNotOff", ApNotOffIsReported, ResetFakes, NULL, NULL);
+  AddTestCase (BenchmarkTests, "Dispatch runs every AP", "Dispatch", DispatchRunsEveryAp, ResetFakes, NULL, NULL);
+  AddTestCase (BenchmarkTests, "Dispatch round missed by an AP is an error", "DispatchMissed", DispatchMissedRoundIsError, ResetFakes, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -17,6 +17,7 @@
 #include <Library/PrintLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
+#include <Library/TimerLib.h>
 #include <Pi/PiMultiPhase.h>
 #include <Protocol/LoadedImage.h>
 #include <Protocol/MpService.h>
@@ -29,6 +30,7 @@ EFI_HANDLE                       mHandle        = NULL;
 UINTN                            mNumCpus       = 0;
 UINTN                            mBspIndex      = 0;
 volatile MP_MANAGEMENT_METADATA  *mCommonBuffer = NULL;
+MP_MANAGEMENT_TRANSITION_TIME    *mTransitionTime = NULL;
 
 /**
   Fetches the number of processors and which processor is the BSP.
@@ -117,6 +119,35 @@ Done:
   return Status;
 }
 
+/**
+  Mark the point where the BSP releases an AP into a new power state.
+
+  @param CpuIndex   The index of the AP being released.
+**/
+STATIC
+VOID
+StartTransitionTimer (
+  IN  UINTN  CpuIndex
+  )
+{
+  mTransitionTime[CpuIndex].StartTick = GetPerformanceCounter ();
+}
+
+/**
+  Record the latency of a transition once the AP has acknowledged it.
+
+  @param CpuIndex   The index of the AP that acknowledged.
+**/
+STATIC
+VOID
+StopTransitionTimer (
+  IN  UINTN  CpuIndex
+  )
+{
+  mTransitionTime[CpuIndex].LatencyNs = GetTimeInNanoSecond (GetPerformanceCounter () - mTransitionTime[CpuIndex].StartTick);
+  mTransitionTime[CpuIndex].Valid     = TRUE;
+}
+
 /**
   A BSP invoked function to perform self suspend. A timeout period needs
   to be provided by the called to invoke self-wakeup service.
@@ -288,6 +319,7 @@ MpMgmtApOn (
     ZeroMem (mCommonBuffer[Index].ApBuffer, mCommonBuffer[Index].ApBufferSize);
 
     // This is the flag to release the core.
+    StartTransitionTimer (Index);
     mCommonBuffer[Index].ApTask = AP_TASK_ACTIVE;
 
     Status = mMpServices->StartupThisAP (
@@ -322,6 +354,8 @@ MpMgmtApOn (
     while (mCommonBuffer[Index].ApTask != AP_TASK_IDLE) {
     }
 
+    StopTransitionTimer (Index);
+
     DEBUG ((DEBUG_INFO, "Initial message from common buffer: %a\n", (CHAR8 *)mCommonBuffer[Index].ApBuffer));
   }
 
@@ -395,7 +429,8 @@ MpMgmtApOff (
 
     // Update the task flag to be active, AP will clear it once wake up.
     mCommonBuffer[Index].TargetStatus = AP_STATE_OFF;
-    mCommonBuffer[Index].ApTask       = AP_TASK_ACTIVE;
+    StartTransitionTimer (Index);
+    mCommonBuffer[Index].ApTask = AP_TASK_ACTIVE;
 
     // At least we are successful for this AP.
     Status = EFI_SUCCESS;
@@ -415,6 +450,8 @@ MpMgmtApOff (
     while (mCommonBuffer[Index].ApTask != AP_TASK_IDLE) {
     }
 
+    StopTransitionTimer (Index);
+
     DEBUG ((DEBUG_INFO, "Last word from common buffer: %a\n", (CHAR8 *)mCommonBuffer[Index].ApBuffer));
   }
 
@@ -523,7 +560,8 @@ MpMgmtApSuspend (
     // Update the task flag to be active, AP will clear it once wake up.
     mCommonBuffer[Index].TargetStatus     = InternalApPowerState;
     mCommonBuffer[Index].TargetPowerState = TargetPowerLevel;
-    mCommonBuffer[Index].ApTask           = AP_TASK_ACTIVE;
+    StartTransitionTimer (Index);
+    mCommonBuffer[Index].ApTask = AP_TASK_ACTIVE;
 
     // At least we are successful for this AP.
     Status = EFI_SUCCESS;
@@ -543,6 +581,8 @@ MpMgmtApSuspend (
     while (mCommonBuffer[Index].ApTask != AP_TASK_IDLE) {
     }
 
+    StopTransitionTimer (Index);
+
     DEBUG ((DEBUG_INFO, "Suspend message from common buffer: %a\n", (CHAR8 *)mCommonBuffer[Index].ApBuffer));
   }
 
@@ -622,7 +662,8 @@ MpMgmtApResume (
 
     // Update the task flag to be active, AP will clear it once wake up.
     mCommonBuffer[Index].TargetStatus = AP_STATE_RESUME;
-    mCommonBuffer[Index].ApTask       = AP_TASK_ACTIVE;
+    StartTransitionTimer (Index);
+    mCommonBuffer[Index].ApTask = AP_TASK_ACTIVE;
 
     // Abstracted call to allow arch specific method to wake up this CPU
     CpuArchWakeFromSleep (Index);
@@ -645,6 +686,8 @@ MpMgmtApResume (
     while (mCommonBuffer[Index].ApTask != AP_TASK_IDLE) {
     }
 
+    StopTransitionTimer (Index);
+
     DEBUG ((DEBUG_INFO, "Resume message from common buffer: %a\n", (CHAR8 *)mCommonBuffer[Index].ApBuffer));
   }
 
@@ -652,12 +695,46 @@ Done:
   return Status;
 }
 
+/**
+  Function to retrieve how long the last power transition of an AP took.
+
+  @param This             MP Management Protocol.
+  @param ProcessorNumber  The CPU index to query.
+  @param Nanoseconds      Returns the latency of the last transition.
+
+  @return EFI_SUCCESS             The routine completed successfully.
+  @return EFI_INVALID_PARAMETER   The CPU index is out of range or Nanoseconds
+                                  is NULL.
+  @return EFI_NOT_STARTED         The target AP has not completed a transition.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+MpMgmtApGetTransitionLatency (
+  IN  MP_MANAGEMENT_PROTOCOL  *This,
+  IN  UINTN                   ProcessorNumber,
+  OUT UINT64                  *Nanoseconds
+  )
+{
+  if ((ProcessorNumber == mBspIndex) || (ProcessorNumber >= mNumCpus) || (Nanoseconds == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!mTransitionTime[ProcessorNumber].Valid) {
+    return EFI_NOT_STARTED;
+  }
+
+  *Nanoseconds = mTransitionTime[ProcessorNumber].LatencyNs;
+  return EFI_SUCCESS;
+}
+
 MP_MANAGEMENT_PROTOCOL  mMpManagement = {
-  .BspSuspend = MpMgmtBspSuspend,
-  .ApOn       = MpMgmtApOn,
-  .ApOff      = MpMgmtApOff,
-  .ApSuspend  = MpMgmtApSuspend,
-  .ApResume   = MpMgmtApResume
+  .BspSuspend             = MpMgmtBspSuspend,
+  .ApOn                   = MpMgmtApOn,
+  .ApOff                  = MpMgmtApOff,
+  .ApSuspend              = MpMgmtApSuspend,
+  .ApResume               = MpMgmtApResume,
+  .ApGetTransitionLatency = MpMgmtApGetTransitionLatency
 };
 
 /**
@@ -717,6 +794,13 @@ MpManagementEntryPoint (
     goto Done;
   }
 
+  mTransitionTime = AllocateZeroPool (sizeof (MP_MANAGEMENT_TRANSITION_TIME) * mNumCpus);
+  if (mTransitionTime == NULL) {
+    Status = EFI_OUT_OF_RESOURCES;
+    DEBUG ((DEBUG_ERROR, "Error: Failed to allocate transition timing buffer.\n"));
+    goto Done;
+  }
+
   Status = CpuMpArchInit (mNumCpus);
   if (EFI_ERROR (Status)) {
     return Status;
@@ -42,9 +42,19 @@ typedef struct {
 } MP_MANAGEMENT_METADATA;
 #pragma pack (pop)
 
+///
+/// BSP side timing of the last power transition of a logical CPU.
+///
+typedef struct {
+  UINT64     StartTick;
+  UINT64     LatencyNs;
+  BOOLEAN    Valid;
+} MP_MANAGEMENT_TRANSITION_TIME;
+
 extern UINTN                            mNumCpus;
 extern UINTN                            mBspIndex;
 extern volatile MP_MANAGEMENT_METADATA  *mCommonBuffer;
+extern MP_MANAGEMENT_TRANSITION_TIME    *mTransitionTime;
 extern EFI_MP_SERVICES_PROTOCOL         *mMpServices;
 
 /** The procedure to run with the MP Services interface.
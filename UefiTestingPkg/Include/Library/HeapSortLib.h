@@ -0,0 +1,40 @@
+/** @file -- HeapSortLib.h
+
+In-place heap sort for the tables the tests in this package index. It is
+O(n log n) in the worst case, does not recurse and needs no buffer beyond one
+element, so neither the stack nor the pool use depends on the input size.
+
+The sort is not stable. Callers that need a fixed order for equal keys break
+ties in CompareFunction.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef HEAP_SORT_LIB_H_
+#define HEAP_SORT_LIB_H_
+
+/**
+  Sorts an array in ascending order. Takes the same arguments as BaseLib's
+  QuickSort().
+
+  @param[in, out] BufferToSort      The array to sort.
+  @param[in]      Count             Number of elements in BufferToSort.
+  @param[in]      ElementSize       Size of each element in bytes.
+  @param[in]      CompareFunction   Returns < 0, 0 or > 0 when its first
+                                    element sorts before, with or after the second.
+  @param[out]     BufferOneElement  Scratch space of ElementSize bytes.
+
+**/
+VOID
+EFIAPI
+HeapSort (
+  IN OUT VOID               *BufferToSort,
+  IN     UINTN              Count,
+  IN     UINTN              ElementSize,
+  IN     BASE_SORT_COMPARE  CompareFunction,
+  OUT    VOID               *BufferOneElement
+  );
+
+#endif // HEAP_SORT_LIB_H_
@@ -0,0 +1,148 @@
+/** @file -- MemoryMapValidationLib.h
+
+Sorts the descriptors of a UEFI memory map once and answers overlap,
+containment, coverage and cross-map consistency queries against it in
+O(n log n), so memory maps and Memory Attributes Tables with thousands of
+entries can be validated quickly.
+
+Descriptors with a NumberOfPages of 0 describe no memory and are left out of
+every query. Reported indices are positions of descriptors in the map that
+was passed to MemoryMapValidationCreateIndex().
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef MEMORY_MAP_VALIDATION_LIB_H_
+#define MEMORY_MAP_VALIDATION_LIB_H_
+
+typedef struct _MEMORY_MAP_VALIDATION_INDEX MEMORY_MAP_VALIDATION_INDEX;
+
+/**
+  Builds the sorted index of a memory map.
+
+  @param[in]  Map             The memory map descriptors.
+  @param[in]  MapSize         Size of Map in bytes.
+  @param[in]  DescriptorSize  Size of each descriptor in bytes.
+  @param[out] Index           The new index. Free with MemoryMapValidationFreeIndex().
+
+  @retval EFI_SUCCESS             The index was built.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL or DescriptorSize is too small.
+  @retval EFI_OUT_OF_RESOURCES    The index could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationCreateIndex (
+  IN  CONST EFI_MEMORY_DESCRIPTOR  *Map,
+  IN  UINTN                        MapSize,
+  IN  UINTN                        DescriptorSize,
+  OUT MEMORY_MAP_VALIDATION_INDEX  **Index
+  );
+
+/**
+  Frees an index built by MemoryMapValidationCreateIndex().
+
+  @param[in]  Index   The index to free. May be NULL.
+
+**/
+VOID
+EFIAPI
+MemoryMapValidationFreeIndex (
+  IN MEMORY_MAP_VALIDATION_INDEX  *Index
+  );
+
+/**
+  Finds two entries of the same map that share at least one byte.
+
+  @param[in]  Index   The map to check.
+  @param[out] First   Index of the entry that starts first.
+  @param[out] Second  Index of the entry that overlaps it.
+
+  @retval EFI_SUCCESS             An overlap was found.
+  @retval EFI_NOT_FOUND           No entries overlap.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationFindOverlap (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Index,
+  OUT UINTN                              *First,
+  OUT UINTN                              *Second
+  );
+
+/**
+  Finds an entry of one map that lies across a boundary of an entry in the
+  other map: it starts inside the other entry, after its start, and ends
+  after its end.
+
+  @param[in]  IndexA  The first map.
+  @param[in]  IndexB  The second map.
+  @param[out] EntryA  Index of the entry in the first map.
+  @param[out] EntryB  Index of the entry in the second map.
+
+  @retval EFI_SUCCESS             A boundary crossing was found.
+  @retval EFI_NOT_FOUND           No entries cross a boundary of the other map.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL.
+  @retval EFI_OUT_OF_RESOURCES    The scratch buffer could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationFindBoundaryCrossing (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *IndexA,
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *IndexB,
+  OUT UINTN                              *EntryA,
+  OUT UINTN                              *EntryB
+  );
+
+/**
+  Finds an entry of the inner map that does not lie entirely within a single
+  entry of the same type in the outer map.
+
+  @param[in]  Inner       The map whose entries must be contained.
+  @param[in]  Outer       The map whose entries must contain them.
+  @param[out] InnerEntry  Index of the entry in the inner map.
+
+  @retval EFI_SUCCESS             An uncontained entry was found.
+  @retval EFI_NOT_FOUND           Every inner entry is contained.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationFindUncontained (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Inner,
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Outer,
+  OUT UINTN                              *InnerEntry
+  );
+
+/**
+  Finds an entry of the given type in the covered map whose range is not
+  completely described by the entries of the same type in the covering map.
+  Several covering entries may describe one covered entry together.
+
+  @param[in]  Covered       The map whose entries must be described.
+  @param[in]  Covering      The map whose entries must describe them.
+  @param[in]  Type          The memory type to check.
+  @param[out] CoveredEntry  Index of the entry in the covered map.
+  @param[out] GapStart      First address of the entry that is not described.
+
+  @retval EFI_SUCCESS             A gap was found.
+  @retval EFI_NOT_FOUND           Every entry of the type is described.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationFindCoverageGap (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Covered,
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Covering,
+  IN  UINT32                             Type,
+  OUT UINTN                              *CoveredEntry,
+  OUT EFI_PHYSICAL_ADDRESS               *GapStart
+  );
+
+#endif // MEMORY_MAP_VALIDATION_LIB_H_
@@ -0,0 +1,119 @@
+/** @file -- PerfStatsLib.h
+
+Latency histogram and rate helpers shared by the performance tests and
+benchmarks in this package. A histogram has a fixed size however many
+samples it counts.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef PERF_STATS_LIB_H_
+#define PERF_STATS_LIB_H_
+
+//
+// Each power of two is split into 2^PERF_STATS_SUB_BUCKET_BITS linear buckets,
+// so a reported latency is within 12.5% of the true value over the whole UINT64 range.
+//
+#define PERF_STATS_SUB_BUCKET_BITS  3
+#define PERF_STATS_SUB_BUCKETS      (1 << PERF_STATS_SUB_BUCKET_BITS)
+#define PERF_STATS_BUCKETS          ((64 - PERF_STATS_SUB_BUCKET_BITS + 1) * PERF_STATS_SUB_BUCKETS)
+
+typedef struct {
+  UINT64    Count;
+  UINT64    Min;
+  UINT64    Max;
+  UINT64    Sum;
+  UINT64    Buckets[PERF_STATS_BUCKETS];
+} PERF_STATS_HISTOGRAM;
+
+/**
+  Empties a histogram.
+
+  @param[out] Histogram   The histogram to reset.
+
+**/
+VOID
+EFIAPI
+PerfStatsHistogramReset (
+  OUT PERF_STATS_HISTOGRAM  *Histogram
+  );
+
+/**
+  Returns the bucket a value is counted in.
+
+  @param[in]  Value   The value to look up.
+
+  @return The bucket index, below PERF_STATS_BUCKETS.
+
+**/
+UINTN
+EFIAPI
+PerfStatsHistogramBucket (
+  IN UINT64  Value
+  );
+
+/**
+  Returns the largest value counted in a bucket.
+
+  @param[in]  Bucket  The bucket index.
+
+  @return The inclusive upper bound of the bucket.
+
+**/
+UINT64
+EFIAPI
+PerfStatsHistogramBucketLimit (
+  IN UINTN  Bucket
+  );
+
+/**
+  Counts a value in a histogram.
+
+  @param[in, out] Histogram   The histogram to add to.
+  @param[in]      Value       The value, usually a latency in nanoseconds.
+
+**/
+VOID
+EFIAPI
+PerfStatsHistogramAdd (
+  IN OUT PERF_STATS_HISTOGRAM  *Histogram,
+  IN     UINT64                   Value
+  );
+
+/**
+  Returns the value at a percentile of a histogram, rounded up to the limit of
+  its bucket and clamped to the largest value counted.
+
+  @param[in]  Histogram   The histogram to query.
+  @param[in]  PerMille    The percentile in tenths of a percent, 500 for p50, 999 for p99.9.
+
+  @return The value at the percentile, 0 for an empty histogram.
+
+**/
+UINT64
+EFIAPI
+PerfStatsHistogramPercentile (
+  IN CONST PERF_STATS_HISTOGRAM  *Histogram,
+  IN       UINTN                    PerMille
+  );
+
+/**
+  Scales an amount measured over ElapsedNs to an amount per second without
+  overflowing for large amounts.
+
+  @param[in]  Amount      Bytes or operations counted.
+  @param[in]  ElapsedNs   Time over which they were counted.
+
+  @return The amount per second, 0 if ElapsedNs is 0, MAX_UINT64 if it does not fit.
+
+**/
+UINT64
+EFIAPI
+PerfStatsPerSecond (
+  IN UINT64  Amount,
+  IN UINT64  ElapsedNs
+  );
+
+#endif // PERF_STATS_LIB_H_
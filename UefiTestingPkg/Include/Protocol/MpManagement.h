@@ -162,13 +162,41 @@ EFI_STATUS
   IN  UINTN                   ProcessorNumber
   );
 
+/**
+  Function to retrieve how long the last power transition of an AP took,
+  measured from the BSP releasing the AP until the AP acknowledged the new
+  state. Settling delays the driver adds after the acknowledgement are not
+  included.
+
+  When an operation is applied to all APs the BSP checks for the
+  acknowledgements in processor order, so later APs may report a latency
+  longer than they took.
+
+  @param This             MP Management Protocol.
+  @param ProcessorNumber  The CPU index to query.
+  @param Nanoseconds      Returns the latency of the last transition.
+
+  @return EFI_SUCCESS             The routine completed successfully.
+  @return EFI_INVALID_PARAMETER   The CPU index is out of range or Nanoseconds
+                                  is NULL.
+  @return EFI_NOT_STARTED         The target AP has not completed a transition.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *MP_MANAGEMENT_AP_GET_TRANSITION_LATENCY)(
+  IN  MP_MANAGEMENT_PROTOCOL  *This,
+  IN  UINTN                   ProcessorNumber,
+  OUT UINT64                  *Nanoseconds
+  );
+
 struct _MP_MANAGEMENT_PROTOCOL {
-  MP_MANAGEMENT_BSP_SUSPEND    BspSuspend;
-  MP_MANAGEMENT_AP_ON          ApOn;
+  MP_MANAGEMENT_BSP_SUSPEND                  BspSuspend;
+  MP_MANAGEMENT_AP_ON                        ApOn;
   // MP_MANAGEMENT_AP_PROCEDURE  ApProcedure;
-  MP_MANAGEMENT_AP_OFF         ApOff;
-  MP_MANAGEMENT_AP_SUSPEND     ApSuspend;
-  MP_MANAGEMENT_AP_RESUME      ApResume;
+  MP_MANAGEMENT_AP_OFF                       ApOff;
+  MP_MANAGEMENT_AP_SUSPEND                   ApSuspend;
+  MP_MANAGEMENT_AP_RESUME                    ApResume;
+  MP_MANAGEMENT_AP_GET_TRANSITION_LATENCY    ApGetTransitionLatency;
 };
 
 extern EFI_GUID  gMpManagementProtocolGuid;
@@ -0,0 +1,108 @@
+/** @file -- HeapSortLib.c
+
+In-place heap sort for the tables the tests in this package index.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HeapSortLib.h>
+
+/**
+  Swaps two elements through Scratch.
+**/
+STATIC
+VOID
+SwapElements (
+  IN OUT UINT8  *Left,
+  IN OUT UINT8  *Right,
+  IN     UINTN  ElementSize,
+  OUT    VOID   *Scratch
+  )
+{
+  CopyMem (Scratch, Left, ElementSize);
+  CopyMem (Left, Right, ElementSize);
+  CopyMem (Right, Scratch, ElementSize);
+}
+
+/**
+  Moves an element down a binary max-heap until both children are smaller.
+**/
+STATIC
+VOID
+SiftDown (
+  IN OUT UINT8              *Buffer,
+  IN     UINTN              Root,
+  IN     UINTN              Count,
+  IN     UINTN              ElementSize,
+  IN     BASE_SORT_COMPARE  Compare,
+  OUT    VOID               *Scratch
+  )
+{
+  UINTN  Child;
+
+  while ((Root * 2 + 1) < Count) {
+    Child = Root * 2 + 1;
+    if (((Child + 1) < Count) && (Compare (Buffer + Child * ElementSize, Buffer + (Child + 1) * ElementSize) < 0)) {
+      Child++;
+    }
+
+    if (Compare (Buffer + Root * ElementSize, Buffer + Child * ElementSize) >= 0) {
+      return;
+    }
+
+    SwapElements (Buffer + Root * ElementSize, Buffer + Child * ElementSize, ElementSize, Scratch);
+    Root = Child;
+  }
+}
+
+/**
+  Sorts an array in ascending order. Takes the same arguments as BaseLib's
+  QuickSort().
+
+  @param[in, out] BufferToSort      The array to sort.
+  @param[in]      Count             Number of elements in BufferToSort.
+  @param[in]      ElementSize       Size of each element in bytes.
+  @param[in]      CompareFunction   Returns < 0, 0 or > 0 when its first
+                                    element sorts before, with or after the second.
+  @param[out]     BufferOneElement  Scratch space of ElementSize bytes.
+
+**/
+VOID
+EFIAPI
+HeapSort (
+  IN OUT VOID               *BufferToSort,
+  IN     UINTN              Count,
+  IN     UINTN              ElementSize,
+  IN     BASE_SORT_COMPARE  CompareFunction,
+  OUT    VOID               *BufferOneElement
+  )
+{
+  UINT8  *Bytes;
+  UINTN  Index;
+
+  if (Count < 2) {
+    return;
+  }
+
+  ASSERT (BufferToSort != NULL);
+  ASSERT (CompareFunction != NULL);
+  ASSERT (BufferOneElement != NULL);
+  ASSERT (ElementSize != 0);
+
+  Bytes = (UINT8 *)BufferToSort;
+  for (Index = Count / 2; Index > 0; Index--) {
+    SiftDown (Bytes, Index - 1, Count, ElementSize, CompareFunction, BufferOneElement);
+  }
+
+  for (Index = Count - 1; Index > 0; Index--) {
+    SwapElements (Bytes, Bytes + Index * ElementSize, ElementSize, BufferOneElement);
+    SiftDown (Bytes, 0, Index, ElementSize, CompareFunction, BufferOneElement);
+  }
+}
@@ -0,0 +1,213 @@
+/** @file -- HeapSortLibHostTest.c
+Host-based UnitTest for HeapSortLib.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HeapSortLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "HeapSortLib Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define MAX_ELEMENTS  1000
+
+//
+// An odd sized element, so the sort cannot get away with word sized copies.
+//
+#pragma pack (1)
+typedef struct {
+  UINT32    Key;
+  UINT16    Position;  // Where the element started, to check nothing is lost or duplicated
+  UINT8     Tag;
+} TEST_ELEMENT;
+#pragma pack ()
+
+typedef enum {
+  PatternAscending,
+  PatternDescending,
+  PatternEqual,
+  PatternScattered,
+  PatternFewKeys,
+  PatternNum
+} TEST_PATTERN;
+
+//
+// Sizes around the points where the heap gains a level, and a large one.
+//
+STATIC CONST UINTN  mCounts[] = { 0, 1, 2, 3, 4, 6, 7, 8, 15, 16, 17, 31, 32, 33, 100, 257, MAX_ELEMENTS };
+
+STATIC
+INTN
+EFIAPI
+CompareKeys (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  CONST TEST_ELEMENT  *A;
+  CONST TEST_ELEMENT  *B;
+
+  A = (CONST TEST_ELEMENT *)Left;
+  B = (CONST TEST_ELEMENT *)Right;
+  return (A->Key == B->Key) ? 0 : ((A->Key < B->Key) ? -1 : 1);
+}
+
+/**
+  Returns the key of element Index of Count in Pattern.
+**/
+STATIC
+UINT32
+PatternKey (
+  IN TEST_PATTERN  Pattern,
+  IN UINTN         Index,
+  IN UINTN         Count
+  )
+{
+  switch (Pattern) {
+    case PatternAscending:
+      return (UINT32)Index;
+    case PatternDescending:
+      return (UINT32)(Count - Index);
+    case PatternEqual:
+      return 7;
+    case PatternScattered:
+      return (UINT32)((Index * 7919) % 1009);
+    default:
+      return (UINT32)((Index * 37) % 5);
+  }
+}
+
+/**
+  Every pattern at every size comes out in ascending order and holds the
+  elements it started with.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SortsEveryPattern (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_ELEMENT  *Elements;
+  TEST_ELEMENT  Scratch;
+  BOOLEAN       *Seen;
+  UINTN         Pattern;
+  UINTN         CountIndex;
+  UINTN         Count;
+  UINTN         Index;
+
+  Elements = AllocatePool (MAX_ELEMENTS * sizeof (TEST_ELEMENT));
+  Seen     = AllocatePool (MAX_ELEMENTS * sizeof (BOOLEAN));
+  UT_ASSERT_NOT_NULL (Elements);
+  UT_ASSERT_NOT_NULL (Seen);
+
+  for (Pattern = 0; Pattern < PatternNum; Pattern++) {
+    for (CountIndex = 0; CountIndex < ARRAY_SIZE (mCounts); CountIndex++) {
+      Count = mCounts[CountIndex];
+      for (Index = 0; Index < Count; Index++) {
+        Elements[Index].Key      = PatternKey ((TEST_PATTERN)Pattern, Index, Count);
+        Elements[Index].Position = (UINT16)Index;
+        Elements[Index].Tag      = (UINT8)(Elements[Index].Key ^ Index);
+      }
+
+      HeapSort (Elements, Count, sizeof (TEST_ELEMENT), CompareKeys, &Scratch);
+
+      ZeroMem (Seen, MAX_ELEMENTS * sizeof (BOOLEAN));
+      for (Index = 0; Index < Count; Index++) {
+        if (Index > 0) {
+          UT_ASSERT_TRUE (Elements[Index - 1].Key <= Elements[Index].Key);
+        }
+
+        UT_ASSERT_TRUE (Elements[Index].Position < Count);
+        UT_ASSERT_FALSE (Seen[Elements[Index].Position]);
+        Seen[Elements[Index].Position] = TRUE;
+        UT_ASSERT_EQUAL (Elements[Index].Key, PatternKey ((TEST_PATTERN)Pattern, Elements[Index].Position, Count));
+        UT_ASSERT_EQUAL (Elements[Index].Tag, (UINT8)(Elements[Index].Key ^ Elements[Index].Position));
+      }
+    }
+  }
+
+  FreePool (Seen);
+  FreePool (Elements);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for HeapSortLib
+  and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      SortSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&SortSuite, Framework, "HeapSortLib", "HeapSortLib.Sort", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for SortSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (SortSuite, "Every input pattern should come out sorted and complete", "Patterns", SortsEveryPattern, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,618 @@
+/** @file -- MemoryMapValidationLib.c
+
+Sorts the descriptors of a UEFI memory map once and answers overlap,
+containment, coverage and cross-map consistency queries against it in
+O(n log n).
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HeapSortLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/MemoryMapValidationLib.h>
+
+typedef struct {
+  EFI_PHYSICAL_ADDRESS    Start;
+  EFI_PHYSICAL_ADDRESS    Last;     // Inclusive, so an entry may end at the top of the address space
+  UINT32                  Type;
+  UINTN                   Entry;    // Position of the descriptor in the source map
+} MEMORY_MAP_RANGE;
+
+struct _MEMORY_MAP_VALIDATION_INDEX {
+  UINTN                   Count;
+  MEMORY_MAP_RANGE        *ByStart;     // Sorted by Start, then Last
+  EFI_PHYSICAL_ADDRESS    *SortedLast;  // Last of every entry in ascending order
+  MEMORY_MAP_RANGE        *ByType;      // Sorted by Type, then Start
+  EFI_PHYSICAL_ADDRESS    *TypeMaxLast; // Largest Last of ByType[0..i] within the same type
+  UINTN                   RunCount;
+  MEMORY_MAP_RANGE        *Runs;        // Union of the entries of each type, sorted by Type, then Start
+};
+
+STATIC
+INTN
+EFIAPI
+CompareByStart (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  CONST MEMORY_MAP_RANGE  *A;
+  CONST MEMORY_MAP_RANGE  *B;
+
+  A = (CONST MEMORY_MAP_RANGE *)Left;
+  B = (CONST MEMORY_MAP_RANGE *)Right;
+  if (A->Start != B->Start) {
+    return (A->Start < B->Start) ? -1 : 1;
+  }
+
+  if (A->Last != B->Last) {
+    return (A->Last < B->Last) ? -1 : 1;
+  }
+
+  return 0;
+}
+
+STATIC
+INTN
+EFIAPI
+CompareByType (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  CONST MEMORY_MAP_RANGE  *A;
+  CONST MEMORY_MAP_RANGE  *B;
+
+  A = (CONST MEMORY_MAP_RANGE *)Left;
+  B = (CONST MEMORY_MAP_RANGE *)Right;
+  if (A->Type != B->Type) {
+    return (A->Type < B->Type) ? -1 : 1;
+  }
+
+  return CompareByStart (Left, Right);
+}
+
+STATIC
+INTN
+EFIAPI
+CompareAddress (
+  IN CONST VOID  *Left,
+  IN CONST VOID  *Right
+  )
+{
+  EFI_PHYSICAL_ADDRESS  A;
+  EFI_PHYSICAL_ADDRESS  B;
+
+  A = *(CONST EFI_PHYSICAL_ADDRESS *)Left;
+  B = *(CONST EFI_PHYSICAL_ADDRESS *)Right;
+  return (A == B) ? 0 : ((A < B) ? -1 : 1);
+}
+
+/**
+  Returns the number of addresses in a sorted array that are below Address.
+**/
+STATIC
+UINTN
+LowerBound (
+  IN CONST EFI_PHYSICAL_ADDRESS  *Sorted,
+  IN       UINTN                 Count,
+  IN       EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  Low  = 0;
+  High = Count;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Sorted[Middle] < Address) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  return Low;
+}
+
+/**
+  Returns the position of the first range of Type in an array sorted by Type,
+  or the position where it would be inserted.
+**/
+STATIC
+UINTN
+FindTypeFirst (
+  IN CONST MEMORY_MAP_RANGE  *Ranges,
+  IN       UINTN             Count,
+  IN       UINT32            Type
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  Low  = 0;
+  High = Count;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if (Ranges[Middle].Type < Type) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  return Low;
+}
+
+/**
+  Returns the position of the last range of Type that starts at or below
+  Address in an array sorted by Type then Start, or MAX_UINTN if there is none.
+**/
+STATIC
+UINTN
+FindTypeFloor (
+  IN CONST MEMORY_MAP_RANGE      *Ranges,
+  IN       UINTN                 Count,
+  IN       UINT32                Type,
+  IN       EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  // Count the ranges that sort at or before (Type, Address)
+  Low  = 0;
+  High = Count;
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+    if ((Ranges[Middle].Type < Type) || ((Ranges[Middle].Type == Type) && (Ranges[Middle].Start <= Address))) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  if ((Low == 0) || (Ranges[Low - 1].Type != Type)) {
+    return MAX_UINTN;
+  }
+
+  return Low - 1;
+}
+
+/**
+  Builds the sorted index of a memory map.
+
+  @param[in]  Map             The memory map descriptors.
+  @param[in]  MapSize         Size of Map in bytes.
+  @param[in]  DescriptorSize  Size of each descriptor in bytes.
+  @param[out] Index           The new index. Free with MemoryMapValidationFreeIndex().
+
+  @retval EFI_SUCCESS             The index was built.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL or DescriptorSize is too small.
+  @retval EFI_OUT_OF_RESOURCES    The index could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationCreateIndex (
+  IN  CONST EFI_MEMORY_DESCRIPTOR  *Map,
+  IN  UINTN                        MapSize,
+  IN  UINTN                        DescriptorSize,
+  OUT MEMORY_MAP_VALIDATION_INDEX  **Index
+  )
+{
+  MEMORY_MAP_VALIDATION_INDEX  *New;
+  CONST EFI_MEMORY_DESCRIPTOR  *Descriptor;
+  MEMORY_MAP_RANGE             *Range;
+  MEMORY_MAP_RANGE             *Run;
+  MEMORY_MAP_RANGE             RangeScratch;
+  EFI_PHYSICAL_ADDRESS         AddressScratch;
+  UINTN                        EntryCount;
+  UINTN                        Entry;
+  UINTN                        Count;
+
+  if (((Map == NULL) && (MapSize != 0)) || (Index == NULL) ||
+      (DescriptorSize < OFFSET_OF (EFI_MEMORY_DESCRIPTOR, Attribute)))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  EntryCount = MapSize / DescriptorSize;
+  New        = AllocateZeroPool (sizeof (*New));
+  if (New == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (EntryCount > 0) {
+    New->ByStart     = AllocatePool (EntryCount * sizeof (MEMORY_MAP_RANGE));
+    New->ByType      = AllocatePool (EntryCount * sizeof (MEMORY_MAP_RANGE));
+    New->Runs        = AllocatePool (EntryCount * sizeof (MEMORY_MAP_RANGE));
+    New->SortedLast  = AllocatePool (EntryCount * sizeof (EFI_PHYSICAL_ADDRESS));
+    New->TypeMaxLast = AllocatePool (EntryCount * sizeof (EFI_PHYSICAL_ADDRESS));
+    if ((New->ByStart == NULL) || (New->ByType == NULL) || (New->Runs == NULL) ||
+        (New->SortedLast == NULL) || (New->TypeMaxLast == NULL))
+    {
+      MemoryMapValidationFreeIndex (New);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  Count = 0;
+  for (Entry = 0; Entry < EntryCount; Entry++) {
+    Descriptor = (CONST EFI_MEMORY_DESCRIPTOR *)((CONST UINT8 *)Map + Entry * DescriptorSize);
+    if (Descriptor->NumberOfPages == 0) {
+      continue;
+    }
+
+    Range        = &New->ByStart[Count++];
+    Range->Start = Descriptor->PhysicalStart;
+    Range->Type  = Descriptor->Type;
+    Range->Entry = Entry;
+    if (Descriptor->NumberOfPages > RShiftU64 (MAX_UINT64 - Descriptor->PhysicalStart, EFI_PAGE_SHIFT)) {
+      Range->Last = MAX_UINT64;
+    } else {
+      Range->Last = Descriptor->PhysicalStart + LShiftU64 (Descriptor->NumberOfPages, EFI_PAGE_SHIFT) - 1;
+    }
+  }
+
+  New->Count = Count;
+  HeapSort (New->ByStart, Count, sizeof (MEMORY_MAP_RANGE), CompareByStart, &RangeScratch);
+
+  for (Entry = 0; Entry < Count; Entry++) {
+    New->SortedLast[Entry] = New->ByStart[Entry].Last;
+  }
+
+  HeapSort (New->SortedLast, Count, sizeof (EFI_PHYSICAL_ADDRESS), CompareAddress, &AddressScratch);
+
+  if (Count > 0) {
+    CopyMem (New->ByType, New->ByStart, Count * sizeof (MEMORY_MAP_RANGE));
+  }
+
+  HeapSort (New->ByType, Count, sizeof (MEMORY_MAP_RANGE), CompareByType, &RangeScratch);
+
+  //
+  // Walk the entries of each type in order, keeping the furthest end seen so
+  // far for containment queries and merging touching entries into runs for
+  // coverage queries.
+  //
+  Run = NULL;
+  for (Entry = 0; Entry < Count; Entry++) {
+    Range = &New->ByType[Entry];
+    if ((Entry == 0) || (Range->Type != New->ByType[Entry - 1].Type)) {
+      New->TypeMaxLast[Entry] = Range->Last;
+      Run                     = NULL;
+    } else {
+      New->TypeMaxLast[Entry] = MAX (New->TypeMaxLast[Entry - 1], Range->Last);
+    }
+
+    if ((Run != NULL) && ((Run->Last == MAX_UINT64) || (Range->Start <= Run->Last + 1))) {
+      Run->Last = MAX (Run->Last, Range->Last);
+    } else {
+      Run = &New->Runs[New->RunCount++];
+      CopyMem (Run, Range, sizeof (*Run));
+    }
+  }
+
+  *Index = New;
+  return EFI_SUCCESS;
+}
+
+/**
+  Frees an index built by MemoryMapValidationCreateIndex().
+
+  @param[in]  Index   The index to free. May be NULL.
+
+**/
+VOID
+EFIAPI
+MemoryMapValidationFreeIndex (
+  IN MEMORY_MAP_VALIDATION_INDEX  *Index
+  )
+{
+  if (Index == NULL) {
+    return;
+  }
+
+  if (Index->ByStart != NULL) {
+    FreePool (Index->ByStart);
+  }
+
+  if (Index->SortedLast != NULL) {
+    FreePool (Index->SortedLast);
+  }
+
+  if (Index->ByType != NULL) {
+    FreePool (Index->ByType);
+  }
+
+  if (Index->TypeMaxLast != NULL) {
+    FreePool (Index->TypeMaxLast);
+  }
+
+  if (Index->Runs != NULL) {
+    FreePool (Index->Runs);
+  }
+
+  FreePool (Index);
+}
+
+/**
+  Finds two entries of the same map that share at least one byte.
+
+  @param[in]  Index   The map to check.
+  @param[out] First   Index of the entry that starts first.
+  @param[out] Second  Index of the entry that overlaps it.
+
+  @retval EFI_SUCCESS             An overlap was found.
+  @retval EFI_NOT_FOUND           No entries overlap.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationFindOverlap (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Index,
+  OUT UINTN                              *First,
+  OUT UINTN                              *Second
+  )
+{
+  UINTN  Position;
+  UINTN  Furthest;
+
+  if ((Index == NULL) || (First == NULL) || (Second == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // In start order, an entry overlaps an earlier one exactly when it starts before the furthest end so far
+  Furthest = 0;
+  for (Position = 1; Position < Index->Count; Position++) {
+    if (Index->ByStart[Position].Start <= Index->ByStart[Furthest].Last) {
+      *First  = Index->ByStart[Furthest].Entry;
+      *Second = Index->ByStart[Position].Entry;
+      return EFI_SUCCESS;
+    }
+
+    if (Index->ByStart[Position].Last > Index->ByStart[Furthest].Last) {
+      Furthest = Position;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Finds X in Outer and Y in Inner with X.Start < Y.Start <= X.Last < Y.Last.
+
+  Inner entries are visited in start order while the Outer entries that start
+  before them are added to a Fenwick tree indexed by the rank of their end, so
+  each Y is answered by counting the ends that fall in [Y.Start, Y.Last).
+
+  @retval EFI_SUCCESS           A crossing was found.
+  @retval EFI_NOT_FOUND         There is none.
+  @retval EFI_OUT_OF_RESOURCES  The tree could not be allocated.
+**/
+STATIC
+EFI_STATUS
+FindEndCrossing (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Outer,
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Inner,
+  OUT UINTN                              *OuterEntry,
+  OUT UINTN                              *InnerEntry
+  )
+{
+  UINT32                  *Tree;
+  UINTN                   Added;
+  UINTN                   Position;
+  UINTN                   Node;
+  UINTN                   Low;
+  UINTN                   High;
+  UINTN                   Hits;
+  CONST MEMORY_MAP_RANGE  *Y;
+  CONST MEMORY_MAP_RANGE  *X;
+
+  if ((Outer->Count == 0) || (Inner->Count == 0)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Tree = AllocateZeroPool ((Outer->Count + 1) * sizeof (UINT32));
+  if (Tree == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Added = 0;
+  for (Position = 0; Position < Inner->Count; Position++) {
+    Y = &Inner->ByStart[Position];
+    while ((Added < Outer->Count) && (Outer->ByStart[Added].Start < Y->Start)) {
+      Node = LowerBound (Outer->SortedLast, Outer->Count, Outer->ByStart[Added].Last) + 1;
+      for ( ; Node <= Outer->Count; Node += Node & (~Node + 1)) {
+        Tree[Node]++;
+      }
+
+      Added++;
+    }
+
+    // Hits = added ends below Y->Last - added ends below Y->Start
+    Low  = LowerBound (Outer->SortedLast, Outer->Count, Y->Start);
+    High = LowerBound (Outer->SortedLast, Outer->Count, Y->Last);
+    Hits = 0;
+    for (Node = High; Node > 0; Node -= Node & (~Node + 1)) {
+      Hits += Tree[Node];
+    }
+
+    for (Node = Low; Node > 0; Node -= Node & (~Node + 1)) {
+      Hits -= Tree[Node];
+    }
+
+    if (Hits == 0) {
+      continue;
+    }
+
+    FreePool (Tree);
+    for (Node = 0; Node < Added; Node++) {
+      X = &Outer->ByStart[Node];
+      if ((X->Last >= Y->Start) && (X->Last < Y->Last)) {
+        *OuterEntry = X->Entry;
+        *InnerEntry = Y->Entry;
+        return EFI_SUCCESS;
+      }
+    }
+
+    ASSERT (FALSE);
+    return EFI_NOT_FOUND;
+  }
+
+  FreePool (Tree);
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Finds an entry of one map that lies across a boundary of an entry in the
+  other map: it starts inside the other entry, after its start, and ends
+  after its end.
+
+  @param[in]  IndexA  The first map.
+  @param[in]  IndexB  The second map.
+  @param[out] EntryA  Index of the entry in the first map.
+  @param[out] EntryB  Index of the entry in the second map.
+
+  @retval EFI_SUCCESS             A boundary crossing was found.
+  @retval EFI_NOT_FOUND           No entries cross a boundary of the other map.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL.
+  @retval EFI_OUT_OF_RESOURCES    The scratch buffer could not be allocated.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationFindBoundaryCrossing (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *IndexA,
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *IndexB,
+  OUT UINTN                              *EntryA,
+  OUT UINTN                              *EntryB
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((IndexA == NULL) || (IndexB == NULL) || (EntryA == NULL) || (EntryB == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = FindEndCrossing (IndexA, IndexB, EntryA, EntryB);
+  if (Status != EFI_NOT_FOUND) {
+    return Status;
+  }
+
+  return FindEndCrossing (IndexB, IndexA, EntryB, EntryA);
+}
+
+/**
+  Finds an entry of the inner map that does not lie entirely within a single
+  entry of the same type in the outer map.
+
+  @param[in]  Inner       The map whose entries must be contained.
+  @param[in]  Outer       The map whose entries must contain them.
+  @param[out] InnerEntry  Index of the entry in the inner map.
+
+  @retval EFI_SUCCESS             An uncontained entry was found.
+  @retval EFI_NOT_FOUND           Every inner entry is contained.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationFindUncontained (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Inner,
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Outer,
+  OUT UINTN                              *InnerEntry
+  )
+{
+  UINTN                   Position;
+  UINTN                   Floor;
+  CONST MEMORY_MAP_RANGE  *Range;
+
+  if ((Inner == NULL) || (Outer == NULL) || (InnerEntry == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Position = 0; Position < Inner->Count; Position++) {
+    Range = &Inner->ByStart[Position];
+
+    // Of the outer entries of this type starting at or before Range, the one reaching furthest decides
+    Floor = FindTypeFloor (Outer->ByType, Outer->Count, Range->Type, Range->Start);
+    if ((Floor == MAX_UINTN) || (Outer->TypeMaxLast[Floor] < Range->Last)) {
+      *InnerEntry = Range->Entry;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Finds an entry of the given type in the covered map whose range is not
+  completely described by the entries of the same type in the covering map.
+  Several covering entries may describe one covered entry together.
+
+  @param[in]  Covered       The map whose entries must be described.
+  @param[in]  Covering      The map whose entries must describe them.
+  @param[in]  Type          The memory type to check.
+  @param[out] CoveredEntry  Index of the entry in the covered map.
+  @param[out] GapStart      First address of the entry that is not described.
+
+  @retval EFI_SUCCESS             A gap was found.
+  @retval EFI_NOT_FOUND           Every entry of the type is described.
+  @retval EFI_INVALID_PARAMETER   A pointer is NULL.
+
+**/
+EFI_STATUS
+EFIAPI
+MemoryMapValidationFindCoverageGap (
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Covered,
+  IN  CONST MEMORY_MAP_VALIDATION_INDEX  *Covering,
+  IN  UINT32                             Type,
+  OUT UINTN                              *CoveredEntry,
+  OUT EFI_PHYSICAL_ADDRESS               *GapStart
+  )
+{
+  UINTN                   Position;
+  UINTN                   Run;
+  CONST MEMORY_MAP_RANGE  *Range;
+
+  if ((Covered == NULL) || (Covering == NULL) || (CoveredEntry == NULL) || (GapStart == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // The covered entries of Type are contiguous in ByType
+  for (Position = FindTypeFirst (Covered->ByType, Covered->Count, Type); Position < Covered->Count; Position++) {
+    Range = &Covered->ByType[Position];
+    if (Range->Type != Type) {
+      break;
+    }
+
+    // Runs never touch each other, so a single run has to reach from Start to Last
+    Run = FindTypeFloor (Covering->Runs, Covering->RunCount, Type, Range->Start);
+    if ((Run == MAX_UINTN) || (Covering->Runs[Run].Last < Range->Start)) {
+      *CoveredEntry = Range->Entry;
+      *GapStart     = Range->Start;
+      return EFI_SUCCESS;
+    }
+
+    if (Covering->Runs[Run].Last < Range->Last) {
+      *CoveredEntry = Range->Entry;
+      *GapStart     = Covering->Runs[Run].Last + 1;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_NOT_FOUND;
+}
@@ -0,0 +1,687 @@
+/** @file -- MemoryMapValidationLibHostTest.c
+Host-based UnitTest for MemoryMapValidationLib.
+
+Small random maps are checked against brute force versions of every query,
+large random maps check that defects are still found among 100k entries.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PseudoRandomLib.h>
+#include <Library/MemoryMapValidationLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "MemoryMapValidationLib Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+// Larger than EFI_MEMORY_DESCRIPTOR, like the descriptors firmware returns
+#define TEST_DESCRIPTOR_SIZE  (sizeof (EFI_MEMORY_DESCRIPTOR) + 8)
+
+#define SMALL_MAP_TRIALS   2000
+#define SMALL_MAP_ENTRIES  24
+#define LARGE_MAP_ENTRIES  100000
+
+typedef struct {
+  UINTN    Count;
+  UINT8    *Buffer;
+} TEST_MAP;
+
+STATIC CONST UINT32  mTypes[] = { EfiRuntimeServicesCode, EfiRuntimeServicesData, EfiConventionalMemory, EfiBootServicesData };
+
+STATIC UINT64  mRandomState;
+
+STATIC
+EFI_MEMORY_DESCRIPTOR *
+Descriptor (
+  IN TEST_MAP  *Map,
+  IN UINTN     Entry
+  )
+{
+  return (EFI_MEMORY_DESCRIPTOR *)(Map->Buffer + Entry * TEST_DESCRIPTOR_SIZE);
+}
+
+STATIC
+BOOLEAN
+AllocateMap (
+  OUT TEST_MAP  *Map,
+  IN  UINTN     Count
+  )
+{
+  Map->Count  = Count;
+  Map->Buffer = AllocateZeroPool (MAX (Count, 1) * TEST_DESCRIPTOR_SIZE);
+  return (BOOLEAN)(Map->Buffer != NULL);
+}
+
+STATIC
+VOID
+SetEntry (
+  IN TEST_MAP              *Map,
+  IN UINTN                 Entry,
+  IN UINT32                Type,
+  IN EFI_PHYSICAL_ADDRESS  Start,
+  IN UINT64                Pages
+  )
+{
+  EFI_MEMORY_DESCRIPTOR  *Desc;
+
+  Desc                = Descriptor (Map, Entry);
+  Desc->Type          = Type;
+  Desc->PhysicalStart = Start;
+  Desc->VirtualStart  = Start;
+  Desc->NumberOfPages = Pages;
+  Desc->Attribute     = EFI_MEMORY_RUNTIME;
+}
+
+STATIC
+VOID
+ShuffleMap (
+  IN TEST_MAP  *Map
+  )
+{
+  UINT8  Scratch[TEST_DESCRIPTOR_SIZE];
+  UINTN  Entry;
+  UINTN  Other;
+
+  for (Entry = Map->Count; Entry > 1; Entry--) {
+    Other = (UINTN)PseudoRandomBelow (&mRandomState, Entry);
+    CopyMem (Scratch, Descriptor (Map, Entry - 1), TEST_DESCRIPTOR_SIZE);
+    CopyMem (Descriptor (Map, Entry - 1), Descriptor (Map, Other), TEST_DESCRIPTOR_SIZE);
+    CopyMem (Descriptor (Map, Other), Scratch, TEST_DESCRIPTOR_SIZE);
+  }
+}
+
+STATIC
+MEMORY_MAP_VALIDATION_INDEX *
+BuildIndex (
+  IN TEST_MAP  *Map
+  )
+{
+  MEMORY_MAP_VALIDATION_INDEX  *Index;
+
+  Index = NULL;
+  if (EFI_ERROR (MemoryMapValidationCreateIndex ((EFI_MEMORY_DESCRIPTOR *)Map->Buffer, Map->Count * TEST_DESCRIPTOR_SIZE, TEST_DESCRIPTOR_SIZE, &Index))) {
+    return NULL;
+  }
+
+  return Index;
+}
+
+//
+// Brute force versions of the queries, written straight from the definitions
+// in MemoryMapValidationLib.h.
+//
+
+STATIC
+EFI_PHYSICAL_ADDRESS
+LastOf (
+  IN EFI_MEMORY_DESCRIPTOR  *Desc
+  )
+{
+  return Desc->PhysicalStart + LShiftU64 (Desc->NumberOfPages, EFI_PAGE_SHIFT) - 1;
+}
+
+STATIC
+BOOLEAN
+EntriesOverlap (
+  IN EFI_MEMORY_DESCRIPTOR  *A,
+  IN EFI_MEMORY_DESCRIPTOR  *B
+  )
+{
+  return (BOOLEAN)((A->NumberOfPages != 0) && (B->NumberOfPages != 0) &&
+                   (MAX (A->PhysicalStart, B->PhysicalStart) <= MIN (LastOf (A), LastOf (B))));
+}
+
+STATIC
+BOOLEAN
+EndCrosses (
+  IN EFI_MEMORY_DESCRIPTOR  *Outer,
+  IN EFI_MEMORY_DESCRIPTOR  *Inner
+  )
+{
+  return (BOOLEAN)((Outer->NumberOfPages != 0) && (Inner->NumberOfPages != 0) &&
+                   (Outer->PhysicalStart < Inner->PhysicalStart) && (Inner->PhysicalStart <= LastOf (Outer)) &&
+                   (LastOf (Outer) < LastOf (Inner)));
+}
+
+STATIC
+BOOLEAN
+EntryContained (
+  IN EFI_MEMORY_DESCRIPTOR  *Inner,
+  IN TEST_MAP               *Outer
+  )
+{
+  UINTN                  Entry;
+  EFI_MEMORY_DESCRIPTOR  *Desc;
+
+  if (Inner->NumberOfPages == 0) {
+    return TRUE;
+  }
+
+  for (Entry = 0; Entry < Outer->Count; Entry++) {
+    Desc = Descriptor (Outer, Entry);
+    if ((Desc->NumberOfPages != 0) && (Desc->Type == Inner->Type) &&
+        (Desc->PhysicalStart <= Inner->PhysicalStart) && (LastOf (Inner) <= LastOf (Desc)))
+    {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/**
+  Returns the first address of Covered that the entries of its type in
+  Covering do not describe, or MAX_UINT64 if it is fully described.
+**/
+STATIC
+EFI_PHYSICAL_ADDRESS
+FirstUncovered (
+  IN EFI_MEMORY_DESCRIPTOR  *Covered,
+  IN TEST_MAP               *Covering
+  )
+{
+  EFI_PHYSICAL_ADDRESS   Progress;
+  EFI_PHYSICAL_ADDRESS   Furthest;
+  UINTN                  Entry;
+  EFI_MEMORY_DESCRIPTOR  *Desc;
+  BOOLEAN                Found;
+
+  Progress = Covered->PhysicalStart;
+  while (TRUE) {
+    Found = FALSE;
+    for (Entry = 0; Entry < Covering->Count; Entry++) {
+      Desc = Descriptor (Covering, Entry);
+      if ((Desc->NumberOfPages != 0) && (Desc->Type == Covered->Type) &&
+          (Desc->PhysicalStart <= Progress) && (Progress <= LastOf (Desc)) && (!Found || (LastOf (Desc) > Furthest)))
+      {
+        Furthest = LastOf (Desc);
+        Found    = TRUE;
+      }
+    }
+
+    if (!Found) {
+      return Progress;
+    }
+
+    if (Furthest >= LastOf (Covered)) {
+      return MAX_UINT64;
+    }
+
+    Progress = Furthest + 1;
+  }
+}
+
+/**
+  Fills a map with entries that may overlap in a small address space, so every
+  query has both answers.
+**/
+STATIC
+VOID
+RandomSmallMap (
+  OUT TEST_MAP  *Map,
+  IN  UINT64    SpanPages
+  )
+{
+  UINTN  Entry;
+
+  for (Entry = 0; Entry < Map->Count; Entry++) {
+    SetEntry (
+      Map,
+      Entry,
+      mTypes[PseudoRandomBelow (&mRandomState, 2)],
+      EFI_PAGES_TO_SIZE ((UINTN)PseudoRandomBelow (&mRandomState, SpanPages)),
+      (PseudoRandomBelow (&mRandomState, 16) == 0) ? 0 : 1 + PseudoRandomBelow (&mRandomState, 8)
+      );
+  }
+}
+
+/**
+  Queries on small random maps give the same answers as brute force, and the
+  reported entries really show the problem.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+SmallMapsMatchBruteForce (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_MAP                     MapA;
+  TEST_MAP                     MapB;
+  MEMORY_MAP_VALIDATION_INDEX  *IndexA;
+  MEMORY_MAP_VALIDATION_INDEX  *IndexB;
+  EFI_STATUS                   Status;
+  UINTN                        Trial;
+  UINTN                        I;
+  UINTN                        J;
+  UINTN                        First;
+  UINTN                        Second;
+  EFI_PHYSICAL_ADDRESS         Gap;
+  BOOLEAN                      Expected;
+  UINT32                       Type;
+  UINT64                       SpanPages;
+
+  mRandomState = 0x5EED;
+  for (Trial = 0; Trial < SMALL_MAP_TRIALS; Trial++) {
+    UT_ASSERT_TRUE (AllocateMap (&MapA, (UINTN)PseudoRandomBelow (&mRandomState, SMALL_MAP_ENTRIES)));
+    UT_ASSERT_TRUE (AllocateMap (&MapB, (UINTN)PseudoRandomBelow (&mRandomState, SMALL_MAP_ENTRIES)));
+    SpanPages = (Trial % 2 == 0) ? 64 : 2048;
+    RandomSmallMap (&MapA, SpanPages);
+    RandomSmallMap (&MapB, SpanPages);
+    IndexA = BuildIndex (&MapA);
+    IndexB = BuildIndex (&MapB);
+    UT_ASSERT_NOT_NULL (IndexA);
+    UT_ASSERT_NOT_NULL (IndexB);
+
+    // Overlap
+    Expected = FALSE;
+    for (I = 0; I < MapA.Count; I++) {
+      for (J = I + 1; J < MapA.Count; J++) {
+        Expected |= EntriesOverlap (Descriptor (&MapA, I), Descriptor (&MapA, J));
+      }
+    }
+
+    Status = MemoryMapValidationFindOverlap (IndexA, &First, &Second);
+    UT_ASSERT_EQUAL (Status == EFI_SUCCESS, Expected);
+    if (Expected) {
+      UT_ASSERT_NOT_EQUAL (First, Second);
+      UT_ASSERT_TRUE (EntriesOverlap (Descriptor (&MapA, First), Descriptor (&MapA, Second)));
+    }
+
+    // Boundary crossing
+    Expected = FALSE;
+    for (I = 0; I < MapA.Count; I++) {
+      for (J = 0; J < MapB.Count; J++) {
+        Expected |= EndCrosses (Descriptor (&MapA, I), Descriptor (&MapB, J));
+        Expected |= EndCrosses (Descriptor (&MapB, J), Descriptor (&MapA, I));
+      }
+    }
+
+    Status = MemoryMapValidationFindBoundaryCrossing (IndexA, IndexB, &First, &Second);
+    UT_ASSERT_EQUAL (Status == EFI_SUCCESS, Expected);
+    if (Expected) {
+      UT_ASSERT_TRUE (
+        EndCrosses (Descriptor (&MapA, First), Descriptor (&MapB, Second)) ||
+        EndCrosses (Descriptor (&MapB, Second), Descriptor (&MapA, First))
+        );
+    }
+
+    // Containment
+    Expected = FALSE;
+    for (I = 0; I < MapB.Count; I++) {
+      Expected |= !EntryContained (Descriptor (&MapB, I), &MapA);
+    }
+
+    Status = MemoryMapValidationFindUncontained (IndexB, IndexA, &First);
+    UT_ASSERT_EQUAL (Status == EFI_SUCCESS, Expected);
+    if (Expected) {
+      UT_ASSERT_FALSE (EntryContained (Descriptor (&MapB, First), &MapA));
+    }
+
+    // Coverage, for both types in the maps
+    for (Type = EfiRuntimeServicesCode; Type <= EfiRuntimeServicesData; Type++) {
+      Expected = FALSE;
+      for (I = 0; I < MapA.Count; I++) {
+        if ((Descriptor (&MapA, I)->Type == Type) && (Descriptor (&MapA, I)->NumberOfPages != 0)) {
+          Expected |= (FirstUncovered (Descriptor (&MapA, I), &MapB) != MAX_UINT64);
+        }
+      }
+
+      Status = MemoryMapValidationFindCoverageGap (IndexA, IndexB, Type, &First, &Gap);
+      UT_ASSERT_EQUAL (Status == EFI_SUCCESS, Expected);
+      if (Expected) {
+        UT_ASSERT_EQUAL (Descriptor (&MapA, First)->Type, Type);
+        UT_ASSERT_EQUAL (Gap, FirstUncovered (Descriptor (&MapA, First), &MapB));
+      }
+    }
+
+    MemoryMapValidationFreeIndex (IndexA);
+    MemoryMapValidationFreeIndex (IndexB);
+    FreePool (MapA.Buffer);
+    FreePool (MapB.Buffer);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Builds a large consistent pair of maps: a memory map of disjoint entries
+  and a MAT that splits every runtime entry into pieces, both shuffled.
+**/
+STATIC
+BOOLEAN
+BuildLargeMaps (
+  OUT TEST_MAP  *Legacy,
+  OUT TEST_MAP  *Mat
+  )
+{
+  EFI_PHYSICAL_ADDRESS  Address;
+  UINTN                 Entry;
+  UINTN                 MatCount;
+  UINT64                Pages;
+  UINT64                Piece;
+  UINT32                Type;
+
+  if (!AllocateMap (Legacy, LARGE_MAP_ENTRIES) || !AllocateMap (Mat, LARGE_MAP_ENTRIES * 4)) {
+    return FALSE;
+  }
+
+  //
+  // Start with a known runtime entry split in two MAT pieces and followed by
+  // conventional memory, so a defect can be planted at the end of it.
+  //
+  SetEntry (Legacy, 0, EfiRuntimeServicesCode, SIZE_1MB, 2);
+  SetEntry (Legacy, 1, EfiConventionalMemory, SIZE_1MB + SIZE_8KB, 1);
+  SetEntry (Mat, 0, EfiRuntimeServicesCode, SIZE_1MB, 1);
+  SetEntry (Mat, 1, EfiRuntimeServicesCode, SIZE_1MB + SIZE_4KB, 1);
+
+  Address  = SIZE_1MB + SIZE_16KB;
+  MatCount = 2;
+  for (Entry = 2; Entry < LARGE_MAP_ENTRIES; Entry++) {
+    Type  = mTypes[PseudoRandomBelow (&mRandomState, ARRAY_SIZE (mTypes))];
+    Pages = 1 + PseudoRandomBelow (&mRandomState, 4);
+    SetEntry (Legacy, Entry, Type, Address, Pages);
+
+    if ((Type == EfiRuntimeServicesCode) || (Type == EfiRuntimeServicesData)) {
+      while (Pages > 0) {
+        Piece = 1 + PseudoRandomBelow (&mRandomState, Pages);
+        SetEntry (Mat, MatCount++, Type, Address, Piece);
+        Address += EFI_PAGES_TO_SIZE ((UINTN)Piece);
+        Pages   -= Piece;
+      }
+    } else {
+      Address += EFI_PAGES_TO_SIZE ((UINTN)Pages);
+    }
+
+    // Leave an occasional hole
+    Address += EFI_PAGES_TO_SIZE ((UINTN)PseudoRandomBelow (&mRandomState, 2));
+  }
+
+  Mat->Count = MatCount;
+  ShuffleMap (Legacy);
+  ShuffleMap (Mat);
+  return TRUE;
+}
+
+/**
+  Finds the entry of a map that starts at Address.
+**/
+STATIC
+UINTN
+FindEntryAt (
+  IN TEST_MAP              *Map,
+  IN EFI_PHYSICAL_ADDRESS  Address
+  )
+{
+  UINTN  Entry;
+
+  for (Entry = 0; Entry < Map->Count; Entry++) {
+    if (Descriptor (Map, Entry)->PhysicalStart == Address) {
+      return Entry;
+    }
+  }
+
+  return 0;
+}
+
+/**
+  Finds an entry of a map with the given type.
+**/
+STATIC
+UINTN
+FindEntryOfType (
+  IN TEST_MAP  *Map,
+  IN UINT32    Type
+  )
+{
+  UINTN  Entry;
+
+  for (Entry = 0; Entry < Map->Count; Entry++) {
+    if (Descriptor (Map, Entry)->Type == Type) {
+      return Entry;
+    }
+  }
+
+  return 0;
+}
+
+/**
+  A consistent pair of 100k entry maps passes every query, and each kind of
+  defect planted in it is found and reported at the planted entry.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LargeMapsFindPlantedDefects (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_MAP                     Legacy;
+  TEST_MAP                     Mat;
+  MEMORY_MAP_VALIDATION_INDEX  *LegacyIndex;
+  MEMORY_MAP_VALIDATION_INDEX  *MatIndex;
+  EFI_MEMORY_DESCRIPTOR        *Desc;
+  EFI_MEMORY_DESCRIPTOR        Saved;
+  UINTN                        Planted;
+  UINTN                        First;
+  UINTN                        Second;
+  EFI_PHYSICAL_ADDRESS         Gap;
+
+  mRandomState = 0xB16B00B5;
+  UT_ASSERT_TRUE (BuildLargeMaps (&Legacy, &Mat));
+  UT_LOG_INFO ("%d memory map entries, %d MAT entries\n", Legacy.Count, Mat.Count);
+
+  LegacyIndex = BuildIndex (&Legacy);
+  MatIndex    = BuildIndex (&Mat);
+  UT_ASSERT_NOT_NULL (LegacyIndex);
+  UT_ASSERT_NOT_NULL (MatIndex);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (LegacyIndex, &First, &Second), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (MatIndex, &First, &Second), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindBoundaryCrossing (LegacyIndex, MatIndex, &First, &Second), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindUncontained (MatIndex, LegacyIndex, &First), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindCoverageGap (LegacyIndex, MatIndex, EfiRuntimeServicesCode, &First, &Gap), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindCoverageGap (LegacyIndex, MatIndex, EfiRuntimeServicesData, &First, &Gap), EFI_NOT_FOUND);
+  MemoryMapValidationFreeIndex (MatIndex);
+
+  //
+  // A MAT entry that changes type is no longer contained, and the memory map
+  // entry it was part of is no longer covered.
+  //
+  Planted = FindEntryOfType (&Mat, EfiRuntimeServicesData);
+  Desc    = Descriptor (&Mat, Planted);
+  CopyMem (&Saved, Desc, sizeof (Saved));
+  Desc->Type = EfiRuntimeServicesCode;
+  MatIndex   = BuildIndex (&Mat);
+  UT_ASSERT_NOT_NULL (MatIndex);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindUncontained (MatIndex, LegacyIndex, &First), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (First, Planted);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindCoverageGap (LegacyIndex, MatIndex, EfiRuntimeServicesData, &First, &Gap), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (Gap, Saved.PhysicalStart);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (MatIndex, &First, &Second), EFI_NOT_FOUND);
+  MemoryMapValidationFreeIndex (MatIndex);
+  CopyMem (Desc, &Saved, sizeof (Saved));
+
+  //
+  // The second MAT piece of the known entry grows across its end.
+  //
+  Planted = FindEntryAt (&Mat, SIZE_1MB + SIZE_4KB);
+  Desc    = Descriptor (&Mat, Planted);
+  Desc->NumberOfPages++;
+  MatIndex = BuildIndex (&Mat);
+  UT_ASSERT_NOT_NULL (MatIndex);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindBoundaryCrossing (LegacyIndex, MatIndex, &First, &Second), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (First, FindEntryAt (&Legacy, SIZE_1MB));
+  UT_ASSERT_EQUAL (Second, Planted);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindUncontained (MatIndex, LegacyIndex, &First), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (First, Planted);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (MatIndex, &First, &Second), EFI_NOT_FOUND);
+  MemoryMapValidationFreeIndex (MatIndex);
+  Desc->NumberOfPages--;
+
+  //
+  // A memory map entry that grows over its neighbour overlaps it.
+  //
+  MemoryMapValidationFreeIndex (LegacyIndex);
+  Planted = FindEntryAt (&Legacy, SIZE_1MB);
+  Descriptor (&Legacy, Planted)->NumberOfPages++;
+  LegacyIndex = BuildIndex (&Legacy);
+  UT_ASSERT_NOT_NULL (LegacyIndex);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (LegacyIndex, &First, &Second), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (First, Planted);
+  UT_ASSERT_EQUAL (Second, FindEntryAt (&Legacy, SIZE_1MB + SIZE_8KB));
+
+  MemoryMapValidationFreeIndex (LegacyIndex);
+  FreePool (Legacy.Buffer);
+  FreePool (Mat.Buffer);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Edge cases: empty maps, zero page entries, entries at the top of the
+  address space and invalid parameters.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+EdgeCases (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  TEST_MAP                     Map;
+  MEMORY_MAP_VALIDATION_INDEX  *Index;
+  MEMORY_MAP_VALIDATION_INDEX  *Empty;
+  UINTN                        First;
+  UINTN                        Second;
+  EFI_PHYSICAL_ADDRESS         Gap;
+
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationCreateIndex (NULL, 0, TEST_DESCRIPTOR_SIZE, &Empty), EFI_SUCCESS);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (Empty, &First, &Second), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationCreateIndex (NULL, TEST_DESCRIPTOR_SIZE, TEST_DESCRIPTOR_SIZE, &Index), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationCreateIndex (NULL, 0, 8, &Index), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (NULL, &First, &Second), EFI_INVALID_PARAMETER);
+
+  UT_ASSERT_TRUE (AllocateMap (&Map, 4));
+  SetEntry (&Map, 0, EfiRuntimeServicesCode, 0x1000, 0);              // Empty, ignored
+  SetEntry (&Map, 1, EfiRuntimeServicesCode, 0x1000, 1);
+  SetEntry (&Map, 2, EfiRuntimeServicesData, MAX_UINT64 - 0xFFF, 1);  // Ends at the top
+  SetEntry (&Map, 3, EfiRuntimeServicesData, 0x2000, MAX_UINT64);     // Would wrap, clamped to the top
+  Index = BuildIndex (&Map);
+  UT_ASSERT_NOT_NULL (Index);
+
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (Index, &First, &Second), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (First, 3);
+  UT_ASSERT_EQUAL (Second, 2);
+
+  // Entry 2 lies within entry 3, a map always contains and covers itself
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindUncontained (Index, Index, &First), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindCoverageGap (Index, Index, EfiRuntimeServicesData, &First, &Gap), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindBoundaryCrossing (Index, Index, &First, &Second), EFI_NOT_FOUND);
+
+  // Nothing covers anything in an empty map
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindCoverageGap (Index, Empty, EfiRuntimeServicesCode, &First, &Gap), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (First, 1);
+  UT_ASSERT_EQUAL (Gap, 0x1000);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindCoverageGap (Index, Empty, EfiConventionalMemory, &First, &Gap), EFI_NOT_FOUND);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindUncontained (Empty, Index, &First), EFI_NOT_FOUND);
+
+  MemoryMapValidationFreeIndex (Index);
+  FreePool (Map.Buffer);
+
+  // Entries of 4GB and more must not be truncated to the width of UINTN
+  UT_ASSERT_TRUE (AllocateMap (&Map, 2));
+  SetEntry (&Map, 0, EfiRuntimeServicesData, BASE_4GB, 0x200000);         // 8GB
+  SetEntry (&Map, 1, EfiRuntimeServicesData, (3 * BASE_4GB) - 0x1000, 1);  // Last page of entry 0
+  Index = BuildIndex (&Map);
+  UT_ASSERT_NOT_NULL (Index);
+  UT_ASSERT_STATUS_EQUAL (MemoryMapValidationFindOverlap (Index, &First, &Second), EFI_SUCCESS);
+  UT_ASSERT_EQUAL (First, 0);
+  UT_ASSERT_EQUAL (Second, 1);
+
+  MemoryMapValidationFreeIndex (Index);
+  MemoryMapValidationFreeIndex (Empty);
+  MemoryMapValidationFreeIndex (NULL);
+  FreePool (Map.Buffer);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for
+  MemoryMapValidationLib and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ValidationSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the Validation Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&ValidationSuite, Framework, "MemoryMapValidation", "MemoryMapValidation.Queries", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for ValidationSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ValidationSuite, "Queries on small random maps should match brute force", "SmallMaps", SmallMapsMatchBruteForce, NULL, NULL, NULL);
+  AddTestCase (ValidationSuite, "Defects planted in 100k entry maps should be found", "LargeMaps", LargeMapsFindPlantedDefects, NULL, NULL, NULL);
+  AddTestCase (ValidationSuite, "Empty maps, empty entries and the top of memory should be handled", "EdgeCases", EdgeCases, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,198 @@
+/** @file -- PerfStatsLib.c
+
+Latency histogram and rate helpers shared by the performance tests and
+benchmarks in this package.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+
+#include <Library/PerfStatsLib.h>
+
+#define NS_PER_SECOND  1000000000ULL
+
+/**
+  Empties a histogram.
+
+  @param[out] Histogram   The histogram to reset.
+
+**/
+VOID
+EFIAPI
+PerfStatsHistogramReset (
+  OUT PERF_STATS_HISTOGRAM  *Histogram
+  )
+{
+  ZeroMem (Histogram, sizeof (*Histogram));
+  Histogram->Min = MAX_UINT64;
+}
+
+/**
+  Returns the bucket a value is counted in.
+
+  @param[in]  Value   The value to look up.
+
+  @return The bucket index, below PERF_STATS_BUCKETS.
+
+**/
+UINTN
+EFIAPI
+PerfStatsHistogramBucket (
+  IN UINT64  Value
+  )
+{
+  UINTN  HighBit;
+  UINTN  SubBucket;
+
+  // Values below the number of sub buckets are counted exactly
+  if (Value < PERF_STATS_SUB_BUCKETS) {
+    return (UINTN)Value;
+  }
+
+  HighBit   = (UINTN)HighBitSet64 (Value);
+  SubBucket = (UINTN)RShiftU64 (Value, HighBit - PERF_STATS_SUB_BUCKET_BITS) & (PERF_STATS_SUB_BUCKETS - 1);
+  return (HighBit - PERF_STATS_SUB_BUCKET_BITS + 1) * PERF_STATS_SUB_BUCKETS + SubBucket;
+}
+
+/**
+  Returns the largest value counted in a bucket.
+
+  @param[in]  Bucket  The bucket index.
+
+  @return The inclusive upper bound of the bucket.
+
+**/
+UINT64
+EFIAPI
+PerfStatsHistogramBucketLimit (
+  IN UINTN  Bucket
+  )
+{
+  UINTN   Shift;
+  UINT64  Lower;
+
+  if (Bucket < PERF_STATS_SUB_BUCKETS) {
+    return Bucket;
+  }
+
+  Shift = Bucket / PERF_STATS_SUB_BUCKETS - 1;
+  Lower = LShiftU64 (PERF_STATS_SUB_BUCKETS + (Bucket % PERF_STATS_SUB_BUCKETS), Shift);
+  return Lower + (LShiftU64 (1, Shift) - 1);
+}
+
+/**
+  Counts a value in a histogram.
+
+  @param[in, out] Histogram   The histogram to add to.
+  @param[in]      Value       The value, usually a latency in nanoseconds.
+
+**/
+VOID
+EFIAPI
+PerfStatsHistogramAdd (
+  IN OUT PERF_STATS_HISTOGRAM  *Histogram,
+  IN     UINT64                   Value
+  )
+{
+  Histogram->Buckets[PerfStatsHistogramBucket (Value)]++;
+  Histogram->Count++;
+  Histogram->Sum += Value;
+  Histogram->Min  = MIN (Histogram->Min, Value);
+  Histogram->Max  = MAX (Histogram->Max, Value);
+}
+
+/**
+  Returns the value at a percentile of a histogram, rounded up to the limit of
+  its bucket and clamped to the largest value counted.
+
+  @param[in]  Histogram   The histogram to query.
+  @param[in]  PerMille    The percentile in tenths of a percent, 500 for p50, 999 for p99.9.
+
+  @return The value at the percentile, 0 for an empty histogram.
+
+**/
+UINT64
+EFIAPI
+PerfStatsHistogramPercentile (
+  IN CONST PERF_STATS_HISTOGRAM  *Histogram,
+  IN       UINTN                    PerMille
+  )
+{
+  UINT64  Rank;
+  UINT64  Seen;
+  UINTN   Bucket;
+
+  if (Histogram->Count == 0) {
+    return 0;
+  }
+
+  // Smallest value with at least PerMille/1000 of the samples at or below it
+  Rank = DivU64x32 (MultU64x32 (Histogram->Count, (UINT32)MIN (PerMille, 1000)) + 999, 1000);
+  Rank = MAX (Rank, 1);
+
+  Seen = 0;
+  for (Bucket = 0; Bucket < PERF_STATS_BUCKETS; Bucket++) {
+    Seen += Histogram->Buckets[Bucket];
+    if (Seen >= Rank) {
+      return MAX (MIN (PerfStatsHistogramBucketLimit (Bucket), Histogram->Max), Histogram->Min);
+    }
+  }
+
+  return Histogram->Max;
+}
+
+/**
+  Scales an amount measured over ElapsedNs to an amount per second without
+  overflowing for large amounts.
+
+  @param[in]  Amount      Bytes or operations counted.
+  @param[in]  ElapsedNs   Time over which they were counted.
+
+  @return The amount per second, 0 if ElapsedNs is 0, MAX_UINT64 if it does not fit.
+
+**/
+UINT64
+EFIAPI
+PerfStatsPerSecond (
+  IN UINT64  Amount,
+  IN UINT64  ElapsedNs
+  )
+{
+  UINT64  Whole;
+  UINT64  Remainder;
+  UINT64  Limit;
+
+  if (ElapsedNs == 0) {
+    return 0;
+  }
+
+  Limit = DivU64x64Remainder (MAX_UINT64, NS_PER_SECOND, NULL);
+  if (Amount <= Limit) {
+    return DivU64x64Remainder (MultU64x64 (Amount, NS_PER_SECOND), ElapsedNs, NULL);
+  }
+
+  //
+  // Split Amount into whole multiples of ElapsedNs and a remainder, each of
+  // which is scaled on its own.
+  //
+  Whole = DivU64x64Remainder (Amount, ElapsedNs, &Remainder);
+  if (Whole > Limit) {
+    return MAX_UINT64;
+  }
+
+  // Remainder < ElapsedNs, so shifting both only drops insignificant low bits
+  while (Remainder > Limit) {
+    Remainder = RShiftU64 (Remainder, 1);
+    ElapsedNs = RShiftU64 (ElapsedNs, 1);
+  }
+
+  Whole     = MultU64x64 (Whole, NS_PER_SECOND);
+  Remainder = DivU64x64Remainder (MultU64x64 (Remainder, NS_PER_SECOND), ElapsedNs, NULL);
+  return (Remainder > MAX_UINT64 - Whole) ? MAX_UINT64 : Whole + Remainder;
+}
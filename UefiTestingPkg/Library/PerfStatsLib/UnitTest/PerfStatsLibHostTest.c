@@ -0,0 +1,212 @@
+/** @file -- PerfStatsLibHostTest.c
+Host-based UnitTest for the latency histogram and rate helpers of PerfStatsLib.
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PerfStatsLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "PerfStatsLib Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+/**
+  Every value lands in a bucket whose limits contain it, and the limits grow
+  with the bucket index.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+HistogramBucketsContainValues (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINT64  Value;
+  UINT64  Lower;
+  UINTN   Bucket;
+  UINTN   Shift;
+
+  for (Bucket = 0; Bucket < PERF_STATS_BUCKETS; Bucket++) {
+    Lower = (Bucket == 0) ? 0 : PerfStatsHistogramBucketLimit (Bucket - 1) + 1;
+    UT_ASSERT_TRUE (Lower <= PerfStatsHistogramBucketLimit (Bucket));
+    UT_ASSERT_EQUAL (PerfStatsHistogramBucket (Lower), Bucket);
+    UT_ASSERT_EQUAL (PerfStatsHistogramBucket (PerfStatsHistogramBucketLimit (Bucket)), Bucket);
+  }
+
+  UT_ASSERT_EQUAL (PerfStatsHistogramBucketLimit (PERF_STATS_BUCKETS - 1), MAX_UINT64);
+  UT_ASSERT_EQUAL (PerfStatsHistogramBucket (MAX_UINT64), PERF_STATS_BUCKETS - 1);
+
+  // A bucket never spans more than an eighth of the values in it
+  for (Shift = 0; Shift < 64; Shift++) {
+    Value  = LShiftU64 (1, Shift) + 1;
+    Bucket = PerfStatsHistogramBucket (Value);
+    UT_ASSERT_TRUE (PerfStatsHistogramBucketLimit (Bucket) - Value <= Value / PERF_STATS_SUB_BUCKETS);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Percentiles of a uniform distribution are within a bucket width of the
+  exact answer, and an empty histogram reports 0.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+HistogramPercentiles (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  PERF_STATS_HISTOGRAM     *Histogram;
+  UINT64                   Value;
+  UINT64                   Expected;
+  UINTN                    PerMille;
+  UINTN                    Index;
+  STATIC CONST UINTN       PerMilles[] = { 1, 500, 900, 990, 999, 1000 };
+
+  Histogram = AllocatePool (sizeof (*Histogram));
+  UT_ASSERT_NOT_NULL (Histogram);
+
+  PerfStatsHistogramReset (Histogram);
+  UT_ASSERT_EQUAL (PerfStatsHistogramPercentile (Histogram, 500), 0);
+
+  for (Value = 1000; Value > 0; Value--) {
+    PerfStatsHistogramAdd (Histogram, Value);
+  }
+
+  UT_ASSERT_EQUAL (Histogram->Count, 1000);
+  UT_ASSERT_EQUAL (Histogram->Min, 1);
+  UT_ASSERT_EQUAL (Histogram->Max, 1000);
+  UT_ASSERT_EQUAL (Histogram->Sum, 500500);
+
+  for (Index = 0; Index < ARRAY_SIZE (PerMilles); Index++) {
+    PerMille = PerMilles[Index];
+    Expected = PerMille;
+    Value    = PerfStatsHistogramPercentile (Histogram, PerMille);
+    UT_LOG_INFO ("p%d.%d = %ld, exact %ld\n", PerMille / 10, PerMille % 10, Value, Expected);
+    UT_ASSERT_TRUE (Value >= Expected);
+    UT_ASSERT_TRUE (Value <= Expected + Expected / PERF_STATS_SUB_BUCKETS);
+  }
+
+  UT_ASSERT_EQUAL (PerfStatsHistogramPercentile (Histogram, 1000), 1000);
+
+  // A single value is reported exactly at every percentile
+  PerfStatsHistogramReset (Histogram);
+  PerfStatsHistogramAdd (Histogram, 123456789);
+  UT_ASSERT_EQUAL (PerfStatsHistogramPercentile (Histogram, 1), 123456789);
+  UT_ASSERT_EQUAL (PerfStatsHistogramPercentile (Histogram, 999), 123456789);
+
+  FreePool (Histogram);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Rates are exact for small amounts and do not overflow for large ones.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+PerSecondScales (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (100, 0), 0);
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (100, 1000000000), 100);
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (1, 1000), 1000000);
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (3, 2000000000), 1);
+
+  // 64 TB over 100 seconds would overflow Amount * 10^9
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (LShiftU64 (64, 40), 100000000000ULL), DivU64x32 (LShiftU64 (64, 40), 100));
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (MAX_UINT64, 1000000000), MAX_UINT64);
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (MAX_UINT64, 1), MAX_UINT64);
+
+  // Faster than one per nanosecond
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (10, 4), 2500000000ULL);
+
+  // 2^62 bytes over 100 seconds, the remainder has to be scaled down
+  UT_ASSERT_EQUAL (PerfStatsPerSecond (0x4000000000000000ULL, 100000000000ULL), 0x4000000000000000ULL / 100);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for
+  PerfStatsLib and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      StatsSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the Stats Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&StatsSuite, Framework, "PerfStatsLib", "PerfStatsLib.Stats", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for StatsSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (StatsSuite, "Histogram buckets should contain the values counted in them", "Buckets", HistogramBucketsContainValues, NULL, NULL, NULL);
+  AddTestCase (StatsSuite, "Histogram percentiles should be within a bucket of the exact value", "Percentiles", HistogramPercentiles, NULL, NULL, NULL);
+  AddTestCase (StatsSuite, "Per second rates should not overflow", "PerSecond", PerSecondScales, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
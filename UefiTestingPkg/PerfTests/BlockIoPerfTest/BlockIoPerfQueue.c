@@ -0,0 +1,278 @@
+/** @file -- BlockIoPerfQueue.c
+ *
+ * Keeps a fixed number of BlockIo2 transfers in flight for a set time and
+ * measures their throughput and latency.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PseudoRandomLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+
+#include "BlockIoPerfQueue.h"
+
+typedef struct {
+  EFI_BLOCK_IO2_TOKEN    Token;
+  VOID                   *Buffer;
+  UINT64                 StartNs;
+  BOOLEAN                Busy;
+  BOOLEAN                Write;
+} BLOCK_IO_PERF_SLOT;
+
+typedef struct {
+  EFI_BLOCK_IO2_PROTOCOL              *BlockIo2;
+  CONST BLOCK_IO_PERF_QUEUE_CONFIG    *Config;
+  BLOCK_IO_PERF_QUEUE_RESULT          *Result;
+  UINT64                              TransferBlocks;
+  UINT64                              TransferSlots; // Transfer aligned positions on the media
+  UINT64                              NextSlot;      // Next sequential position
+  UINT64                              RandomState;
+  UINT32                              InFlight;
+} BLOCK_IO_PERF_QUEUE;
+
+/**
+  Returns the current time in nanoseconds.
+**/
+STATIC
+UINT64
+NowNs (
+  VOID
+  )
+{
+  return GetTimeInNanoSecond (GetPerformanceCounter ());
+}
+
+/**
+  Starts the next transfer on a free slot.
+
+  @param[in, out] Queue   The running benchmark.
+  @param[in, out] Slot    The free slot to use.
+
+  @retval TRUE    The transfer was started.
+  @retval FALSE   The device refused it, it was counted as an error.
+
+**/
+STATIC
+BOOLEAN
+StartTransfer (
+  IN OUT BLOCK_IO_PERF_QUEUE  *Queue,
+  IN OUT BLOCK_IO_PERF_SLOT   *Slot
+  )
+{
+  EFI_STATUS  Status;
+  UINT64      Position;
+  EFI_LBA     Lba;
+  UINT32      MediaId;
+
+  if (Queue->Config->Random) {
+    Position = PseudoRandomBelow (&Queue->RandomState, Queue->TransferSlots);
+  } else {
+    Position = Queue->NextSlot;
+    Queue->NextSlot++;
+    if (Queue->NextSlot == Queue->TransferSlots) {
+      Queue->NextSlot = 0;
+    }
+  }
+
+  Lba         = MultU64x64 (Position, Queue->TransferBlocks);
+  MediaId     = Queue->BlockIo2->Media->MediaId;
+  Slot->Write = FALSE;
+  if (Queue->Config->WritePercent > 0) {
+    Slot->Write = (BOOLEAN)(PseudoRandomBelow (&Queue->RandomState, 100) < Queue->Config->WritePercent);
+  }
+
+  Slot->Token.TransactionStatus = EFI_NOT_READY;
+  Slot->StartNs                 = NowNs ();
+  if (Slot->Write) {
+    Status = Queue->BlockIo2->WriteBlocksEx (Queue->BlockIo2, MediaId, Lba, &Slot->Token, Queue->Config->TransferSize, Slot->Buffer);
+  } else {
+    Status = Queue->BlockIo2->ReadBlocksEx (Queue->BlockIo2, MediaId, Lba, &Slot->Token, Queue->Config->TransferSize, Slot->Buffer);
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - %a of LBA 0x%lx failed to start - %r\n", __FUNCTION__, Slot->Write ? "Write" : "Read", Lba, Status));
+    Queue->Result->Errors++;
+    return FALSE;
+  }
+
+  Slot->Busy = TRUE;
+  Queue->InFlight++;
+  Queue->Result->MaxInFlight = MAX (Queue->Result->MaxInFlight, Queue->InFlight);
+  return TRUE;
+}
+
+/**
+  Accounts for a transfer that has completed.
+
+  @param[in, out] Queue   The running benchmark.
+  @param[in, out] Slot    The slot whose transfer completed.
+  @param[in]      Now     The time the completion was seen.
+
+**/
+STATIC
+VOID
+CompleteTransfer (
+  IN OUT BLOCK_IO_PERF_QUEUE  *Queue,
+  IN OUT BLOCK_IO_PERF_SLOT   *Slot,
+  IN     UINT64               Now
+  )
+{
+  Slot->Busy = FALSE;
+  Queue->InFlight--;
+
+  PerfStatsHistogramAdd (&Queue->Result->Latency, Now - Slot->StartNs);
+  if (EFI_ERROR (Slot->Token.TransactionStatus)) {
+    Queue->Result->Errors++;
+    return;
+  }
+
+  if (Slot->Write) {
+    Queue->Result->Writes++;
+  } else {
+    Queue->Result->Reads++;
+  }
+
+  Queue->Result->Bytes += Queue->Config->TransferSize;
+}
+
+/**
+  Runs a queue depth benchmark on a BlockIo2 device. QueueDepth transfers are
+  started with ReadBlocksEx or WriteBlocksEx and each one is restarted as soon
+  as it completes, until DurationNs has passed and all transfers are done.
+
+  @param[in]  BlockIo2    The device to test.
+  @param[in]  Config      The benchmark parameters.
+  @param[out] Result      Counters and the latency histogram of the run.
+
+  @retval EFI_SUCCESS             The run finished, Result->Errors counts failed transfers.
+  @retval EFI_INVALID_PARAMETER   A parameter is NULL or Config does not fit the media.
+  @retval EFI_NO_MEDIA            There is no media in the device.
+  @retval EFI_WRITE_PROTECTED     Writes were requested on read only media.
+  @retval EFI_OUT_OF_RESOURCES    The buffers or events could not be allocated.
+
+**/
+EFI_STATUS
+BlockIoPerfRunQueue (
+  IN  EFI_BLOCK_IO2_PROTOCOL            *BlockIo2,
+  IN  CONST BLOCK_IO_PERF_QUEUE_CONFIG  *Config,
+  OUT BLOCK_IO_PERF_QUEUE_RESULT        *Result
+  )
+{
+  EFI_STATUS           Status;
+  EFI_BLOCK_IO_MEDIA   *Media;
+  BLOCK_IO_PERF_QUEUE  Queue;
+  BLOCK_IO_PERF_SLOT   *Slots;
+  UINTN                Pages;
+  UINTN                Alignment;
+  UINT32               Index;
+  UINT64               Begin;
+  UINT64               Now;
+  UINT64               LastCompletion;
+  BOOLEAN              Stopping;
+
+  if ((BlockIo2 == NULL) || (BlockIo2->Media == NULL) || (Config == NULL) || (Result == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Media = BlockIo2->Media;
+  if (!Media->MediaPresent) {
+    return EFI_NO_MEDIA;
+  }
+
+  if ((Config->QueueDepth == 0) || (Config->QueueDepth > BLOCK_IO_PERF_MAX_QUEUE_DEPTH) ||
+      (Media->BlockSize == 0) || (Config->TransferSize == 0) || ((Config->TransferSize % Media->BlockSize) != 0) ||
+      (Config->WritePercent > 100) || (Config->TransferSize / Media->BlockSize > Media->LastBlock + 1))
+  {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((Config->WritePercent > 0) && Media->ReadOnly) {
+    return EFI_WRITE_PROTECTED;
+  }
+
+  ZeroMem (Result, sizeof (*Result));
+  PerfStatsHistogramReset (&Result->Latency);
+
+  ZeroMem (&Queue, sizeof (Queue));
+  Queue.BlockIo2       = BlockIo2;
+  Queue.Config         = Config;
+  Queue.Result         = Result;
+  Queue.TransferBlocks = Config->TransferSize / Media->BlockSize;
+  Queue.TransferSlots  = DivU64x64Remainder (Media->LastBlock + 1, Queue.TransferBlocks, NULL);
+  Queue.RandomState    = (Config->Seed != 0) ? Config->Seed : 0x9E3779B97F4A7C15ULL;
+
+  Slots = AllocateZeroPool (Config->QueueDepth * sizeof (BLOCK_IO_PERF_SLOT));
+  if (Slots == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status    = EFI_SUCCESS;
+  Pages     = EFI_SIZE_TO_PAGES (Config->TransferSize);
+  Alignment = MAX (Media->IoAlign, EFI_PAGE_SIZE);
+  for (Index = 0; Index < Config->QueueDepth; Index++) {
+    Slots[Index].Buffer = AllocateAlignedPages (Pages, Alignment);
+    if (Slots[Index].Buffer == NULL) {
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Done;
+    }
+
+    // Polled with CheckEvent(), so no notification function is needed
+    Status = gBS->CreateEvent (0, 0, NULL, NULL, &Slots[Index].Token.Event);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+  }
+
+  Stopping       = FALSE;
+  Begin          = NowNs ();
+  LastCompletion = Begin;
+  for (Index = 0; Index < Config->QueueDepth; Index++) {
+    if (!StartTransfer (&Queue, &Slots[Index])) {
+      Stopping = TRUE;
+      break;
+    }
+  }
+
+  while (Queue.InFlight > 0) {
+    for (Index = 0; Index < Config->QueueDepth; Index++) {
+      if (!Slots[Index].Busy || (gBS->CheckEvent (Slots[Index].Token.Event) != EFI_SUCCESS)) {
+        continue;
+      }
+
+      Now            = NowNs ();
+      LastCompletion = Now;
+      CompleteTransfer (&Queue, &Slots[Index], Now);
+
+      // A device that refuses a transfer is not asked again, the rest drain
+      if (!Stopping && ((Now - Begin) < Config->DurationNs)) {
+        Stopping = !StartTransfer (&Queue, &Slots[Index]);
+      }
+    }
+  }
+
+  Result->ElapsedNs = LastCompletion - Begin;
+  Status            = EFI_SUCCESS;
+
+Done:
+  for (Index = 0; Index < Config->QueueDepth; Index++) {
+    if (Slots[Index].Token.Event != NULL) {
+      gBS->CloseEvent (Slots[Index].Token.Event);
+    }
+
+    if (Slots[Index].Buffer != NULL) {
+      FreeAlignedPages (Slots[Index].Buffer, Pages);
+    }
+  }
+
+  FreePool (Slots);
+  return Status;
+}
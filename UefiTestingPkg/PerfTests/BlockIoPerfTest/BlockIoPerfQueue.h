@@ -0,0 +1,61 @@
+/** @file -- BlockIoPerfQueue.h
+ *
+ * Keeps a fixed number of BlockIo2 transfers in flight for a set time and
+ * measures their throughput and latency.
+
+Copyright (C) Microsoft Corporation. All rights reserved.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef BLOCK_IO_PERF_QUEUE_H_
+#define BLOCK_IO_PERF_QUEUE_H_
+
+#include <Protocol/BlockIo2.h>
+#include <Library/PerfStatsLib.h>
+
+#define BLOCK_IO_PERF_MAX_QUEUE_DEPTH  64
+
+typedef struct {
+  UINT32     QueueDepth;          // Transfers kept in flight, 1 to BLOCK_IO_PERF_MAX_QUEUE_DEPTH
+  UINT32     TransferSize;        // Bytes per transfer, a multiple of the block size
+  BOOLEAN    Random;              // Random transfer aligned LBAs instead of sequential ones
+  UINT32     WritePercent;        // Share of transfers that write, 0 to 100. Destroys media contents.
+  UINT64     DurationNs;          // No new transfer is started after this much time
+  UINT64     Seed;                // Seed for random LBAs and the read/write mix
+} BLOCK_IO_PERF_QUEUE_CONFIG;
+
+typedef struct {
+  UINT64                  Reads;
+  UINT64                  Writes;
+  UINT64                  Errors;         // Transfers that failed to start or complete
+  UINT64                  Bytes;          // Bytes of the transfers that succeeded
+  UINT64                  ElapsedNs;      // From the first start to the last completion
+  UINT32                  MaxInFlight;
+  PERF_STATS_HISTOGRAM    Latency;        // Nanoseconds from start to completion
+} BLOCK_IO_PERF_QUEUE_RESULT;
+
+/**
+  Runs a queue depth benchmark on a BlockIo2 device. QueueDepth transfers are
+  started with ReadBlocksEx or WriteBlocksEx and each one is restarted as soon
+  as it completes, until DurationNs has passed and all transfers are done.
+
+  @param[in]  BlockIo2    The device to test.
+  @param[in]  Config      The benchmark parameters.
+  @param[out] Result      Counters and the latency histogram of the run.
+
+  @retval EFI_SUCCESS             The run finished, Result->Errors counts failed transfers.
+  @retval EFI_INVALID_PARAMETER   A parameter is NULL or Config does not fit the media.
+  @retval EFI_NO_MEDIA            There is no media in the device.
+  @retval EFI_WRITE_PROTECTED     Writes were requested on read only media.
+  @retval EFI_OUT_OF_RESOURCES    The buffers or events could not be allocated.
+
+**/
+EFI_STATUS
+BlockIoPerfRunQueue (
+  IN  EFI_BLOCK_IO2_PROTOCOL            *BlockIo2,
+  IN  CONST BLOCK_IO_PERF_QUEUE_CONFIG  *Config,
+  OUT BLOCK_IO_PERF_QUEUE_RESULT        *Result
+  );
+
+#endif // BLOCK_IO_PERF_QUEUE_H_
@@ -9,6 +9,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <Uefi.h>
 #include <Protocol/BlockIo.h>
+#include <Protocol/BlockIo2.h>
 #include <Protocol/DevicePath.h>
 
 #include <Library/BaseLib.h>
@@ -22,6 +23,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/MemoryAllocationLib.h>
 #include <Library/TimerLib.h>
 #include <Library/DevicePathLib.h>
+#include <Library/PerfStatsLib.h>
+
+#include "BlockIoPerfQueue.h"
 
 #define MAX_SIZE_FOR_TEST  (0x100000 * 20)
 
@@ -33,6 +37,20 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define GET_MILLISECONDS(a)  (DivU64x32 ((a), ONE_MILLISECOND))
 #define GET_MICROSECONDS(a)  (DivU64x32 ((a), ONE_MICROSECOND))
 
+#define DEFAULT_QUEUE_TRANSFER_SIZE  0x1000
+#define DEFAULT_QUEUE_SECONDS        10
+
+STATIC CONST SHELL_PARAM_ITEM  ParamList[] = {
+  { L"-h",      TypeFlag  },
+  { L"-qd",     TypeValue },
+  { L"-size",   TypeValue },
+  { L"-time",   TypeValue },
+  { L"-random", TypeFlag  },
+  { L"-write",  TypeValue },
+  { L"-device", TypeValue },
+  { NULL,       TypeMax   }
+};
+
 VOID
 PrintTimeFromNs (
   UINT64  TimeInNs
@@ -125,6 +143,200 @@ TestBlockIo (
   FreePages (Buffer, EFI_SIZE_TO_PAGES (MAX_SIZE_FOR_TEST));
 }
 
+/**
+  Prints the command line help.
+**/
+VOID
+PrintUsage (
+  VOID
+  )
+{
+  Print (L"BlockIoPerfTest [-qd <depth> [-size <KB>] [-time <seconds>] [-random] [-write <percent> -device <index>]]\n");
+  Print (L"  Without -qd every BlockIo device is timed with synchronous reads of increasing size.\n");
+  Print (L"  -qd      Keep <depth> BlockIo2 transfers in flight, 1 to %d.\n", BLOCK_IO_PERF_MAX_QUEUE_DEPTH);
+  Print (L"  -size    Transfer size in KB.  Default is %d.\n", DEFAULT_QUEUE_TRANSFER_SIZE / 1024);
+  Print (L"  -time    Seconds to run on each device.  Default is %d.\n", DEFAULT_QUEUE_SECONDS);
+  Print (L"  -random  Use random LBAs instead of sequential ones.\n");
+  Print (L"  -write   Percent of transfers that write.  DESTROYS THE CONTENTS of the device.\n");
+  Print (L"  -device  Only test the BlockIo2 device with this index.  Required with -write.\n");
+}
+
+/**
+  Runs the queue depth benchmark on one BlockIo2 device and prints the results.
+
+  @param[in]  BlockIo2  The device to test.
+  @param[in]  Config    The benchmark parameters.
+
+**/
+VOID
+TestBlockIo2Queue (
+  IN EFI_BLOCK_IO2_PROTOCOL            *BlockIo2,
+  IN CONST BLOCK_IO_PERF_QUEUE_CONFIG  *Config
+  )
+{
+  EFI_STATUS                  Status;
+  BLOCK_IO_PERF_QUEUE_RESULT  *Result;
+  UINT64                      Operations;
+
+  // The latency histogram is too large for the stack
+  Result = AllocateZeroPool (sizeof (*Result));
+  if (Result == NULL) {
+    Print (L"Failed to allocate memory\n");
+    return;
+  }
+
+  Print (
+    L" BlockSize: 0x%X\n IoAlign: 0x%X\n LastBlock: 0x%lX\n",
+    BlockIo2->Media->BlockSize,
+    BlockIo2->Media->IoAlign,
+    BlockIo2->Media->LastBlock
+    );
+  Print (
+    L"Test QD%d %dKB %a %d%% write\n",
+    Config->QueueDepth,
+    Config->TransferSize / 1024,
+    Config->Random ? "random" : "sequential",
+    Config->WritePercent
+    );
+
+  Status = BlockIoPerfRunQueue (BlockIo2, Config, Result);
+  if (EFI_ERROR (Status)) {
+    Print (L"Queue test failed.  Status = %r\n", Status);
+    FreePool (Result);
+    return;
+  }
+
+  Operations = Result->Reads + Result->Writes;
+  Print (L" Reads: %ld  Writes: %ld  Errors: %ld  Max in flight: %d\n", Result->Reads, Result->Writes, Result->Errors, Result->MaxInFlight);
+  Print (L" Elapsed: ");
+  PrintTimeFromNs (Result->ElapsedNs);
+  Print (L" Throughput: %ld KB/s\n", PerfStatsPerSecond (Result->Bytes, Result->ElapsedNs) / 1024);
+  Print (L" IOPS: %ld\n", PerfStatsPerSecond (Operations, Result->ElapsedNs));
+  Print (L" Latency p50: ");
+  PrintTimeFromNs (PerfStatsHistogramPercentile (&Result->Latency, 500));
+  Print (L" Latency p99: ");
+  PrintTimeFromNs (PerfStatsHistogramPercentile (&Result->Latency, 990));
+  Print (L" Latency p99.9: ");
+  PrintTimeFromNs (PerfStatsHistogramPercentile (&Result->Latency, 999));
+  Print (L" Latency max: ");
+  PrintTimeFromNs (Result->Latency.Max);
+
+  FreePool (Result);
+}
+
+/**
+  Runs the queue depth benchmark on the BlockIo2 devices selected on the
+  command line.
+
+  @param[in]  Package   The parsed command line.
+
+  @retval EFI_SUCCESS             The selected devices were tested.
+  @retval EFI_INVALID_PARAMETER   The command line is not valid.
+  @retval EFI_NOT_FOUND           No BlockIo2 device matched.
+
+**/
+EFI_STATUS
+RunQueueTests (
+  IN LIST_ENTRY  *Package
+  )
+{
+  EFI_STATUS                  Status;
+  BLOCK_IO_PERF_QUEUE_CONFIG  Config;
+  CONST CHAR16                *Value;
+  UINTN                       Device;
+  UINTN                       HandleCount;
+  EFI_HANDLE                  *Handles;
+  UINTN                       Index;
+  EFI_BLOCK_IO2_PROTOCOL      *BlockIo2;
+  EFI_DEVICE_PATH_PROTOCOL    *DevicePath;
+  CHAR16                      *DevicePathString;
+
+  ZeroMem (&Config, sizeof (Config));
+  Config.QueueDepth   = (UINT32)ShellStrToUintn (ShellCommandLineGetValue (Package, L"-qd"));
+  Config.TransferSize = DEFAULT_QUEUE_TRANSFER_SIZE;
+  Config.DurationNs   = MultU64x32 (DEFAULT_QUEUE_SECONDS, ONE_SECOND);
+  Config.Random       = ShellCommandLineGetFlag (Package, L"-random");
+  Config.Seed         = GetPerformanceCounter ();
+
+  Value = ShellCommandLineGetValue (Package, L"-size");
+  if (Value != NULL) {
+    Config.TransferSize = (UINT32)ShellStrToUintn (Value) * 1024;
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-time");
+  if (Value != NULL) {
+    Config.DurationNs = MultU64x32 (ShellStrToUintn (Value), ONE_SECOND);
+  }
+
+  Value = ShellCommandLineGetValue (Package, L"-write");
+  if (Value != NULL) {
+    Config.WritePercent = (UINT32)ShellStrToUintn (Value);
+  }
+
+  Device = MAX_UINTN;
+  Value  = ShellCommandLineGetValue (Package, L"-device");
+  if (Value != NULL) {
+    Device = ShellStrToUintn (Value);
+  }
+
+  if ((Config.QueueDepth == 0) || (Config.QueueDepth > BLOCK_IO_PERF_MAX_QUEUE_DEPTH) ||
+      (Config.TransferSize == 0) || (Config.DurationNs == 0) || (Config.WritePercent > 100))
+  {
+    PrintUsage ();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Writes destroy whatever is on the media, so never spray them over every
+  // device in the system.
+  //
+  if ((Config.WritePercent > 0) && (Device == MAX_UINTN)) {
+    Print (L"-write requires -device to select a scratch device\n");
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiBlockIo2ProtocolGuid, NULL, &HandleCount, &Handles);
+  if (EFI_ERROR (Status) || (HandleCount == 0)) {
+    Print (L"No BlockIO2 in this system\n");
+    return EFI_NOT_FOUND;
+  }
+
+  Print (L"Found %d BlockIO2 handles\n", HandleCount);
+  if ((Device != MAX_UINTN) && (Device >= HandleCount)) {
+    Print (L"Device %d does not exist\n", Device);
+    gBS->FreePool (Handles);
+    return EFI_NOT_FOUND;
+  }
+
+  for (Index = 0; Index < HandleCount; Index++) {
+    if ((Device != MAX_UINTN) && (Index != Device)) {
+      continue;
+    }
+
+    Print (L"Device %d\n", Index);
+    Status = gBS->HandleProtocol (Handles[Index], &gEfiDevicePathProtocolGuid, (VOID **)&DevicePath);
+    if (!EFI_ERROR (Status)) {
+      DevicePathString = ConvertDevicePathToText (DevicePath, TRUE, FALSE);
+      if (DevicePathString != NULL) {
+        Print (L"DevicePath is %s\n", DevicePathString);
+        FreePool (DevicePathString);
+      }
+    }
+
+    Status = gBS->HandleProtocol (Handles[Index], &gEfiBlockIo2ProtocolGuid, (VOID **)&BlockIo2);
+    if (EFI_ERROR (Status) || (BlockIo2 == NULL)) {
+      Print (L"BlockIo2Protocol failed.  Can't test this one\n\n");
+      continue;
+    }
+
+    TestBlockIo2Queue (BlockIo2, &Config);
+    Print (L"\n\n");
+  }
+
+  gBS->FreePool (Handles);
+  return EFI_SUCCESS;
+}
+
 /**
   Test entry point.
 
@@ -148,6 +360,8 @@ TestMain (
   EFI_DEVICE_PATH_PROTOCOL  *BlockIoDevicePath = NULL;
   CHAR16                    *DevicePathString  = NULL;
   EFI_BLOCK_IO_PROTOCOL     *BlockIoProtocol   = NULL;
+  LIST_ENTRY                *Package           = NULL;
+  CHAR16                    *ProblemParam      = NULL;
 
   //
   // Initialize the shell lib (we must be in non-auto-init...)
@@ -159,6 +373,31 @@ TestMain (
     return Status;
   }
 
+  Status = ShellCommandLineParse (ParamList, &Package, &ProblemParam, FALSE);
+  if (EFI_ERROR (Status)) {
+    Print (L"Invalid parameter %s\n", ProblemParam != NULL ? ProblemParam : L"");
+    if (ProblemParam != NULL) {
+      FreePool (ProblemParam);
+    }
+
+    PrintUsage ();
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-h")) {
+    PrintUsage ();
+    ShellCommandLineFreeVarList (Package);
+    return EFI_SUCCESS;
+  }
+
+  if (ShellCommandLineGetFlag (Package, L"-qd")) {
+    Status = RunQueueTests (Package);
+    ShellCommandLineFreeVarList (Package);
+    return Status;
+  }
+
+  ShellCommandLineFreeVarList (Package);
+
   // locate all handles with blockio
   Status = gBS->LocateHandleBuffer (ByProtocol, &gEfiBlockIoProtocolGuid, NULL, &BlockIoHandleCount, &BlockIoBuffer);
   if (EFI_ERROR (Status) || (BlockIoHandleCount == 0) || (BlockIoBuffer == NULL)) {
@@ -0,0 +1,590 @@
+/** @file -- BlockIoPerfHostTest.c
+Host-based UnitTest for the BlockIo2 queue depth engine of the block io
+performance test, run against a fake BlockIo2 device.
+
+Copyright (c) Microsoft Corporation
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../BlockIoPerfQueue.h"
+
+#define UNIT_TEST_NAME     "BlockIoPerfTest Host Test"
+#define UNIT_TEST_VERSION  "0.1"
+
+#define FAKE_BLOCK_SIZE      512
+#define FAKE_LAST_BLOCK      0xFFFF
+#define FAKE_LATENCY_NS      10000
+#define FAKE_CHECK_EVENT_NS  1
+#define FAKE_MAX_EVENTS      BLOCK_IO_PERF_MAX_QUEUE_DEPTH
+
+typedef struct {
+  BOOLEAN                Allocated;
+  BOOLEAN                Pending;
+  UINT64                 DueNs;
+  EFI_STATUS             Completion;
+  EFI_BLOCK_IO2_TOKEN    *Token;
+} FAKE_EVENT;
+
+//
+// State of the fake clock and the fake device. Time only moves when the
+// engine polls an event, so every run is repeatable.
+//
+STATIC UINT64              mNowNs;
+STATIC FAKE_EVENT          mEvents[FAKE_MAX_EVENTS];
+STATIC UINT32              mInFlight;
+STATIC UINT32              mMaxInFlight;
+STATIC UINT64              mReads;
+STATIC UINT64              mWrites;
+STATIC UINT64              mBadRequests;  // Misaligned, out of range or reused tokens
+STATIC UINT64              mSequentialBreaks;
+STATIC EFI_LBA             mNextLba;
+STATIC UINT64              mFailEvery;    // Complete every Nth transfer with an error, 0 for never
+STATIC UINT64              mRejectAfter;  // Refuse to start transfers after this many, 0 for never
+STATIC UINT64              mStarted;
+STATIC EFI_BLOCK_IO_MEDIA  mMedia;
+
+/**
+  Fake TimerLib clock, counts in nanoseconds.
+**/
+UINT64
+EFIAPI
+GetPerformanceCounter (
+  VOID
+  )
+{
+  return mNowNs;
+}
+
+UINT64
+EFIAPI
+GetTimeInNanoSecond (
+  IN UINT64  Ticks
+  )
+{
+  return Ticks;
+}
+
+EFI_STATUS
+EFIAPI
+UnitTestCreateEvent (
+  IN  UINT32            Type,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction,
+  IN  VOID              *NotifyContext,
+  OUT EFI_EVENT         *Event
+  )
+{
+  UINTN  Index;
+
+  assert_int_equal (Type, 0);
+  assert_null (NotifyFunction);
+  for (Index = 0; Index < FAKE_MAX_EVENTS; Index++) {
+    if (!mEvents[Index].Allocated) {
+      ZeroMem (&mEvents[Index], sizeof (mEvents[Index]));
+      mEvents[Index].Allocated = TRUE;
+      *Event                   = &mEvents[Index];
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_OUT_OF_RESOURCES;
+}
+
+EFI_STATUS
+EFIAPI
+UnitTestCheckEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  FAKE_EVENT  *Fake;
+
+  Fake = (FAKE_EVENT *)Event;
+  assert_true (Fake->Allocated);
+
+  mNowNs += FAKE_CHECK_EVENT_NS;
+  if (!Fake->Pending || (mNowNs < Fake->DueNs)) {
+    return EFI_NOT_READY;
+  }
+
+  Fake->Pending                   = FALSE;
+  Fake->Token->TransactionStatus = Fake->Completion;
+  mInFlight--;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+UnitTestCloseEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  FAKE_EVENT  *Fake;
+
+  Fake = (FAKE_EVENT *)Event;
+  assert_true (Fake->Allocated);
+  assert_false (Fake->Pending);
+  Fake->Allocated = FALSE;
+  return EFI_SUCCESS;
+}
+
+EFI_BOOT_SERVICES  mBootSvc = {
+  .CreateEvent = UnitTestCreateEvent,
+  .CheckEvent  = UnitTestCheckEvent,
+  .CloseEvent  = UnitTestCloseEvent,
+};
+
+EFI_BOOT_SERVICES  *gBS = &mBootSvc;
+
+/**
+  Queues a transfer on the fake device, it completes FAKE_LATENCY_NS later.
+**/
+STATIC
+EFI_STATUS
+FakeTransfer (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN UINT32                  MediaId,
+  IN EFI_LBA                 Lba,
+  IN EFI_BLOCK_IO2_TOKEN     *Token,
+  IN UINTN                   BufferSize,
+  IN VOID                    *Buffer,
+  IN BOOLEAN                 Write
+  )
+{
+  FAKE_EVENT  *Fake;
+  UINT64      Blocks;
+
+  if ((mRejectAfter != 0) && (mStarted >= mRejectAfter)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  mStarted++;
+  Fake   = (FAKE_EVENT *)Token->Event;
+  Blocks = BufferSize / FAKE_BLOCK_SIZE;
+  if ((MediaId != mMedia.MediaId) || (Buffer == NULL) || (((UINTN)Buffer % EFI_PAGE_SIZE) != 0) ||
+      ((BufferSize % FAKE_BLOCK_SIZE) != 0) || ((Lba % Blocks) != 0) || (Lba + Blocks - 1 > mMedia.LastBlock) ||
+      (Fake == NULL) || !Fake->Allocated || Fake->Pending)
+  {
+    mBadRequests++;
+  }
+
+  if (Lba != mNextLba) {
+    mSequentialBreaks++;
+  }
+
+  // The engine only uses whole transfers, so it wraps when the next one would not fit
+  mNextLba = (Lba + 2 * Blocks - 1 > mMedia.LastBlock) ? 0 : Lba + Blocks;
+
+  Fake->Pending    = TRUE;
+  Fake->Token      = Token;
+  Fake->DueNs      = mNowNs + FAKE_LATENCY_NS;
+  Fake->Completion = ((mFailEvery != 0) && ((mStarted % mFailEvery) == 0)) ? EFI_DEVICE_ERROR : EFI_SUCCESS;
+
+  mInFlight++;
+  mMaxInFlight = MAX (mMaxInFlight, mInFlight);
+  if (Write) {
+    mWrites++;
+  } else {
+    mReads++;
+  }
+
+  return EFI_SUCCESS;
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeReadBlocksEx (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN UINT32                  MediaId,
+  IN EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN *Token,
+  IN UINTN                   BufferSize,
+  OUT VOID                   *Buffer
+  )
+{
+  return FakeTransfer (This, MediaId, Lba, Token, BufferSize, Buffer, FALSE);
+}
+
+STATIC
+EFI_STATUS
+EFIAPI
+FakeWriteBlocksEx (
+  IN EFI_BLOCK_IO2_PROTOCOL  *This,
+  IN UINT32                  MediaId,
+  IN EFI_LBA                 Lba,
+  IN OUT EFI_BLOCK_IO2_TOKEN *Token,
+  IN UINTN                   BufferSize,
+  IN VOID                    *Buffer
+  )
+{
+  return FakeTransfer (This, MediaId, Lba, Token, BufferSize, Buffer, TRUE);
+}
+
+STATIC EFI_BLOCK_IO2_PROTOCOL  mBlockIo2 = {
+  .Media         = &mMedia,
+  .ReadBlocksEx  = FakeReadBlocksEx,
+  .WriteBlocksEx = FakeWriteBlocksEx,
+};
+
+STATIC BLOCK_IO_PERF_QUEUE_RESULT  mResult;
+
+/**
+  Puts the fake device back in its initial state before each queue test.
+**/
+STATIC
+VOID
+EFIAPI
+ResetFakeDevice (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  ZeroMem (mEvents, sizeof (mEvents));
+  mNowNs            = 1000;
+  mInFlight         = 0;
+  mMaxInFlight      = 0;
+  mReads            = 0;
+  mWrites           = 0;
+  mBadRequests      = 0;
+  mSequentialBreaks = 0;
+  mNextLba          = 0;
+  mFailEvery        = 0;
+  mRejectAfter      = 0;
+  mStarted          = 0;
+
+  ZeroMem (&mMedia, sizeof (mMedia));
+  mMedia.MediaId      = 7;
+  mMedia.MediaPresent = TRUE;
+  mMedia.BlockSize    = FAKE_BLOCK_SIZE;
+  mMedia.LastBlock    = FAKE_LAST_BLOCK;
+}
+
+/**
+  Checks that the engine left no event or transfer behind.
+**/
+STATIC
+UNIT_TEST_STATUS
+CheckDrained (
+  VOID
+  )
+{
+  UINTN  Index;
+
+  UT_ASSERT_EQUAL (mInFlight, 0);
+  for (Index = 0; Index < FAKE_MAX_EVENTS; Index++) {
+    UT_ASSERT_FALSE (mEvents[Index].Allocated);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+STATIC
+VOID
+InitConfig (
+  OUT BLOCK_IO_PERF_QUEUE_CONFIG  *Config,
+  IN  UINT32                      QueueDepth
+  )
+{
+  ZeroMem (Config, sizeof (*Config));
+  Config->QueueDepth   = QueueDepth;
+  Config->TransferSize = 8 * FAKE_BLOCK_SIZE;
+  Config->DurationNs   = 100 * FAKE_LATENCY_NS;
+  Config->Seed         = 0x1234;
+}
+
+/**
+  The engine keeps exactly QueueDepth transfers in flight and completes about
+  Duration / Latency * QueueDepth of them.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+QueueDepthIsHonored (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BLOCK_IO_PERF_QUEUE_CONFIG  Config;
+  EFI_STATUS                  Status;
+  UINT32                      Depths[] = { 1, 2, 8, 32, BLOCK_IO_PERF_MAX_QUEUE_DEPTH };
+  UINTN                       Index;
+  UINT64                      Ideal;
+
+  for (Index = 0; Index < ARRAY_SIZE (Depths); Index++) {
+    ResetFakeDevice (NULL);
+    InitConfig (&Config, Depths[Index]);
+
+    Status = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+    UT_ASSERT_STATUS_EQUAL (CheckDrained (), UNIT_TEST_PASSED);
+
+    UT_ASSERT_EQUAL (mMaxInFlight, Depths[Index]);
+    UT_ASSERT_EQUAL (mResult.MaxInFlight, Depths[Index]);
+    UT_ASSERT_EQUAL (mBadRequests, 0);
+    UT_ASSERT_EQUAL (mResult.Reads, mReads);
+    UT_ASSERT_EQUAL (mResult.Writes, 0);
+    UT_ASSERT_EQUAL (mResult.Errors, 0);
+    UT_ASSERT_EQUAL (mResult.Bytes, MultU64x32 (mReads, Config.TransferSize));
+    UT_ASSERT_EQUAL (mResult.Latency.Count, mReads);
+    UT_ASSERT_TRUE (mResult.Latency.Min >= FAKE_LATENCY_NS);
+    UT_ASSERT_TRUE (mResult.ElapsedNs >= Config.DurationNs);
+
+    // Polling every slot costs a tick each, allow for it
+    Ideal = DivU64x32 (MultU64x32 (Config.DurationNs, Depths[Index]), FAKE_LATENCY_NS);
+    UT_LOG_INFO ("QD%d: %ld transfers, ideal %ld\n", Depths[Index], mReads, Ideal);
+    UT_ASSERT_TRUE (mReads <= Ideal + Depths[Index]);
+    UT_ASSERT_TRUE (mReads >= Ideal * 8 / 10);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Sequential runs walk the media in order and wrap, random runs stay aligned
+  and in range.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+LbaPatterns (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BLOCK_IO_PERF_QUEUE_CONFIG  Config;
+  EFI_STATUS                  Status;
+
+  // Small media so the sequential walk wraps several times
+  ResetFakeDevice (NULL);
+  mMedia.LastBlock = 8 * 10 + 3;
+  InitConfig (&Config, 4);
+  Status = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_TRUE (mReads > 100);
+  UT_ASSERT_EQUAL (mBadRequests, 0);
+  UT_ASSERT_EQUAL (mSequentialBreaks, 0);
+
+  ResetFakeDevice (NULL);
+  InitConfig (&Config, 16);
+  Config.Random = TRUE;
+  Status        = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mBadRequests, 0);
+  UT_ASSERT_TRUE (mSequentialBreaks > mReads / 2);
+  UT_ASSERT_STATUS_EQUAL (CheckDrained (), UNIT_TEST_PASSED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  The read/write mix follows WritePercent, and writes are refused on read
+  only media.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+WriteMix (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BLOCK_IO_PERF_QUEUE_CONFIG  Config;
+  EFI_STATUS                  Status;
+  UINT64                      Total;
+
+  ResetFakeDevice (NULL);
+  InitConfig (&Config, 32);
+  Config.WritePercent = 30;
+  Config.DurationNs   = 1000 * FAKE_LATENCY_NS;
+  Status              = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mResult.Reads, mReads);
+  UT_ASSERT_EQUAL (mResult.Writes, mWrites);
+  Total = mReads + mWrites;
+  UT_ASSERT_TRUE (mWrites * 100 >= Total * 27);
+  UT_ASSERT_TRUE (mWrites * 100 <= Total * 33);
+
+  ResetFakeDevice (NULL);
+  InitConfig (&Config, 32);
+  Config.WritePercent = 100;
+  Status              = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mReads, 0);
+  UT_ASSERT_EQUAL (mResult.Writes, mWrites);
+
+  ResetFakeDevice (NULL);
+  mMedia.ReadOnly = TRUE;
+  InitConfig (&Config, 4);
+  Config.WritePercent = 1;
+  Status              = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_WRITE_PROTECTED);
+  UT_ASSERT_EQUAL (mStarted, 0);
+
+  // Reads are still fine on read only media
+  Config.WritePercent = 0;
+  Status              = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_STATUS_EQUAL (CheckDrained (), UNIT_TEST_PASSED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Configurations that do not fit the device are rejected before any transfer.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+InvalidConfigs (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BLOCK_IO_PERF_QUEUE_CONFIG  Config;
+
+  ResetFakeDevice (NULL);
+
+  InitConfig (&Config, 0);
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult), EFI_INVALID_PARAMETER);
+  InitConfig (&Config, BLOCK_IO_PERF_MAX_QUEUE_DEPTH + 1);
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult), EFI_INVALID_PARAMETER);
+
+  InitConfig (&Config, 1);
+  Config.TransferSize = FAKE_BLOCK_SIZE + 1;
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult), EFI_INVALID_PARAMETER);
+  Config.TransferSize = 0;
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult), EFI_INVALID_PARAMETER);
+  Config.TransferSize = (FAKE_LAST_BLOCK + 2) * FAKE_BLOCK_SIZE;
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult), EFI_INVALID_PARAMETER);
+
+  InitConfig (&Config, 1);
+  Config.WritePercent = 101;
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult), EFI_INVALID_PARAMETER);
+
+  InitConfig (&Config, 1);
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (NULL, &Config, &mResult), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, NULL, &mResult), EFI_INVALID_PARAMETER);
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, &Config, NULL), EFI_INVALID_PARAMETER);
+
+  mMedia.MediaPresent = FALSE;
+  UT_ASSERT_STATUS_EQUAL (BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult), EFI_NO_MEDIA);
+
+  UT_ASSERT_EQUAL (mStarted, 0);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Failed completions are counted as errors and the run goes on, a device that
+  refuses new transfers ends the run once the queue drains.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ErrorsAreCounted (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  BLOCK_IO_PERF_QUEUE_CONFIG  Config;
+  EFI_STATUS                  Status;
+
+  ResetFakeDevice (NULL);
+  mFailEvery = 10;
+  InitConfig (&Config, 8);
+  Status = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mResult.Errors, mReads / 10);
+  UT_ASSERT_EQUAL (mResult.Reads + mResult.Errors, mReads);
+  UT_ASSERT_EQUAL (mResult.Bytes, MultU64x32 (mResult.Reads, Config.TransferSize));
+  UT_ASSERT_STATUS_EQUAL (CheckDrained (), UNIT_TEST_PASSED);
+
+  ResetFakeDevice (NULL);
+  mRejectAfter = 20;
+  InitConfig (&Config, 8);
+  Status = BlockIoPerfRunQueue (&mBlockIo2, &Config, &mResult);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (mResult.Reads, 20);
+  UT_ASSERT_EQUAL (mResult.Errors, 1);
+  UT_ASSERT_STATUS_EQUAL (CheckDrained (), UNIT_TEST_PASSED);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  block io performance test and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      QueueSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  //
+  // Start setting up the test framework for running the tests.
+  //
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  //
+  // Populate the Queue Unit Test Suite.
+  //
+  Status = CreateUnitTestSuite (&QueueSuite, Framework, "BlockIoPerfQueue", "BlockIoPerf.Queue", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for QueueSuite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (QueueSuite, "The queue should keep QueueDepth transfers in flight", "QueueDepth", QueueDepthIsHonored, NULL, NULL, NULL);
+  AddTestCase (QueueSuite, "Sequential and random LBAs should be aligned and on the media", "LbaPatterns", LbaPatterns, NULL, NULL, NULL);
+  AddTestCase (QueueSuite, "The read/write mix should follow WritePercent", "WriteMix", WriteMix, NULL, NULL, NULL);
+  AddTestCase (QueueSuite, "Invalid configurations should be rejected", "InvalidConfigs", InvalidConfigs, NULL, NULL, NULL);
+  AddTestCase (QueueSuite, "Failed transfers should be counted as errors", "Errors", ErrorsAreCounted, NULL, NULL, NULL);
+
+  //
+  // Execute the tests.
+  //
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -14,6 +14,103 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define XML_MAX_ATTRIBUTE_VALUE_LENGTH  (1024)
 #define XML_MAX_ELEMENT_VALUE_LENGTH    (0xFFFF)
 
+// Max element nesting supported by ParseXmlStream
+#define XML_MAX_STREAM_DEPTH  (32)
+
+///
+/// A run of characters inside the caller's XML document.  The data is
+/// not null terminated and is only valid while the document buffer is.
+/// Attribute values and text are passed as they appear in the document
+/// (still xml escaped).
+///
+typedef struct {
+  CONST CHAR8    *Data;
+  UINTN          Length;
+} XML_STRING_SLICE;
+
+/**
+Called when a start tag is parsed.
+
+@param[in]  Context  Caller context passed to ParseXmlStream
+@param[in]  Name     Element name
+@param[in]  Depth    Depth of the element.  The root element is depth 0.
+
+@retval EFI_SUCCESS  Continue parsing.
+@retval Others       Stop parsing.  ParseXmlStream returns this status.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *XML_STREAM_START_ELEMENT)(
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Name,
+  IN UINTN                   Depth
+  );
+
+/**
+Called for each attribute of the most recently started element.
+
+@param[in]  Context  Caller context passed to ParseXmlStream
+@param[in]  Name     Attribute name
+@param[in]  Value    Attribute value (xml escaped)
+
+@retval EFI_SUCCESS  Continue parsing.
+@retval Others       Stop parsing.  ParseXmlStream returns this status.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *XML_STREAM_ATTRIBUTE)(
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Name,
+  IN CONST XML_STRING_SLICE  *Value
+  );
+
+/**
+Called for each run of text inside the current element that is not
+only white space.  Leading and trailing white space is trimmed.
+
+@param[in]  Context  Caller context passed to ParseXmlStream
+@param[in]  Text     Element text (xml escaped)
+@param[in]  Depth    Depth of the element that contains the text
+
+@retval EFI_SUCCESS  Continue parsing.
+@retval Others       Stop parsing.  ParseXmlStream returns this status.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *XML_STREAM_TEXT)(
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Text,
+  IN UINTN                   Depth
+  );
+
+/**
+Called when an element ends.  This includes empty elements (<Name />).
+
+@param[in]  Context  Caller context passed to ParseXmlStream
+@param[in]  Name     Element name
+@param[in]  Depth    Depth of the element.  The root element is depth 0.
+
+@retval EFI_SUCCESS  Continue parsing.
+@retval Others       Stop parsing.  ParseXmlStream returns this status.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *XML_STREAM_END_ELEMENT)(
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Name,
+  IN UINTN                   Depth
+  );
+
+///
+/// Event callbacks for ParseXmlStream.  Any of them can be NULL.
+///
+typedef struct {
+  XML_STREAM_START_ELEMENT    StartElement;
+  XML_STREAM_ATTRIBUTE        Attribute;
+  XML_STREAM_TEXT             Text;
+  XML_STREAM_END_ELEMENT      EndElement;
+} XML_STREAM_CALLBACKS;
+
 /**
 This function will create a xml tree given an XML document as a ascii string.
 
@@ -32,6 +129,50 @@ CreateXmlTree (
   OUT       XmlNode  **RootNode
   );
 
+/**
+Parse an XML document and report elements, attributes and text to the
+callbacks without building a tree.  Nothing is copied or allocated; the
+callbacks get slices of XmlDocument.  Memory use only depends on the depth
+of the document.
+
+A callback can return any error to stop parsing early.  EFI_ABORTED is the
+suggested status once the caller has found what it needs.
+
+@param[in]  XmlDocument      XML document to parse
+@param[in]  SizeXmlDocument  Length of the document
+@param[in]  Callbacks        Event callbacks
+@param[in]  Context          Optional caller context passed to each callback
+
+@retval EFI_SUCCESS            The whole document was parsed
+@retval EFI_INVALID_PARAMETER  A parameter is invalid or the XML is malformed
+@retval EFI_BAD_BUFFER_SIZE    The document is nested deeper than XML_MAX_STREAM_DEPTH
+@retval Others                 Status returned by a callback that stopped parsing
+**/
+EFI_STATUS
+EFIAPI
+ParseXmlStream (
+  IN CONST CHAR8                 *XmlDocument,
+  IN       UINTN                 SizeXmlDocument,
+  IN CONST XML_STREAM_CALLBACKS  *Callbacks,
+  IN       VOID                  *Context OPTIONAL
+  );
+
+/**
+Compare a slice from ParseXmlStream to a null terminated string.
+
+@param[in]  Slice   Slice to compare
+@param[in]  String  Null terminated string
+
+@retval TRUE   The slice and the string are equal
+@retval FALSE  They are not equal
+**/
+BOOLEAN
+EFIAPI
+XmlSliceEqual (
+  IN CONST XML_STRING_SLICE  *Slice,
+  IN CONST CHAR8             *String
+  );
+
 /**
   This function creates a new XML tree.
 
@@ -218,6 +359,24 @@ XmlUnEscape (
   OUT CHAR8       **String
   );
 
+/**
+Remove XML escape sequences from the string without allocating a new string.
+The un-escaped string is never longer than the escaped one so it is written over the input.
+
+@param String - Xml Escaped Ascii string.  On success contains the string with no XML escape sequences.
+@param MaxStringLength - Max length of the Ascii string "String"
+@param Length - Optional.  On success set to the length of the un-escaped string.
+
+@return Status of un escape process.
+**/
+EFI_STATUS
+EFIAPI
+XmlUnEscapeInPlace (
+  IN OUT CHAR8  *String,
+  IN     UINTN  MaxStringLength,
+  OUT    UINTN  *Length OPTIONAL
+  );
+
 /**
 Function to go thru a tree and count the nodes
 **/
@@ -14,6 +14,17 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define MAX_ELEMENT_NAME_LENGTH    (50)
 #define MAX_ATTRIBUTE_NAME_LENGTH  (50)
 
+// Nodes with at least this many children or attributes get a lazily built hash index
+#define XML_QUERY_INDEX_THRESHOLD  (8)
+
+// Max number of '/' separated steps in a compiled path query
+#define XML_QUERY_MAX_STEPS  (16)
+
+//
+// Opaque handle for a compiled path query
+//
+typedef struct _XML_QUERY XML_QUERY;
+
 /**
 Find the first 1st generation child that has a matching ElementName
 
@@ -44,4 +55,72 @@ FindFirstAttributeByName (
   IN CONST CHAR8    *AttributeName
   );
 
+/**
+Compile a path query so it can be executed many times without being re-parsed.
+
+The path is a '/' separated list of element names.  Each step can be the
+wildcard '*' and can have one attribute predicate, either [@name] to require
+the attribute or [@name=value] to require the value.  Values can be quoted
+with ' or ".  A leading '/' makes the first step match the starting node
+itself; otherwise the first step matches its children.
+
+  Example: "/Root/Suite[@name='x']/Case"
+
+@param[in]  Path   Null terminated path to compile
+@param[out] Query  Compiled query.  Free with FreeXmlQuery.
+
+@retval EFI_SUCCESS            Query was compiled
+@retval EFI_INVALID_PARAMETER  A parameter is NULL or the path is malformed
+@retval EFI_OUT_OF_RESOURCES   Memory allocation failed
+**/
+EFI_STATUS
+EFIAPI
+CompileXmlQuery (
+  IN  CONST CHAR8  *Path,
+  OUT XML_QUERY    **Query
+  );
+
+/**
+Free a query created by CompileXmlQuery
+
+@param[in]  Query  Query to free.  Can be NULL.
+**/
+VOID
+EFIAPI
+FreeXmlQuery (
+  IN XML_QUERY  *Query
+  );
+
+/**
+Execute a compiled query and return the first matching node in document order.
+
+@param[in]  Node   Starting node for the query
+@param[in]  Query  Compiled query
+
+@retval XmlNode that matches or NULL if not found
+**/
+XmlNode *
+EFIAPI
+XmlQueryFindFirst (
+  IN CONST XmlNode    *Node,
+  IN CONST XML_QUERY  *Query
+  );
+
+/**
+Execute a compiled query and return the next matching node after Previous.
+
+@param[in]  Node      Starting node used for XmlQueryFindFirst
+@param[in]  Query     Compiled query
+@param[in]  Previous  Node returned by the last XmlQueryFindFirst or XmlQueryFindNext
+
+@retval XmlNode that matches or NULL if there are no more matches
+**/
+XmlNode *
+EFIAPI
+XmlQueryFindNext (
+  IN CONST XmlNode    *Node,
+  IN CONST XML_QUERY  *Query,
+  IN CONST XmlNode    *Previous
+  );
+
 #endif
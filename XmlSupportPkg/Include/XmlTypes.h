@@ -30,6 +30,7 @@ typedef struct _XmlNode {
   CHAR8              *Name;              // Name of this node.
   CHAR8              *Value;             // Optional value.
   XmlDeclaration     XmlDeclaration;     // Optional XML declaration for the node.
+  VOID               *QueryIndex;        // Optional lookup index built lazily by XmlTreeQueryLib.
 } XmlNode;
 
 typedef struct _XmlAttribute {
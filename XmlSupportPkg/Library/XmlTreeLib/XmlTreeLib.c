@@ -31,6 +31,33 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // DEFINE the max number of nodes deep the parser will support
 #define MAX_RECURSIVE_LEVEL  (25)
 
+//
+// Word at a time byte search.  XML_WORD_HAS_ZERO_BYTE is non zero if any byte of W is zero.
+//
+#define XML_WORD_ONES                ((UINTN)-1 / 0xFF)
+#define XML_WORD_HIGHS               (XML_WORD_ONES * 0x80)
+#define XML_WORD_HAS_ZERO_BYTE(W)    (((W) - XML_WORD_ONES) & ~(W) & XML_WORD_HIGHS)
+#define XML_WORD_HAS_BYTE(W, C)      XML_WORD_HAS_ZERO_BYTE ((W) ^ (XML_WORD_ONES * (UINT8)(C)))
+#define XML_WORD_ALL_SPACES          (XML_WORD_ONES * (UINT8)' ')
+
+typedef struct {
+  CONST CHAR8    *Sequence;   // escape sequence without the leading '&'
+  UINTN          Length;      // length of Sequence
+  CHAR8          Char;        // character the sequence stands for
+} XML_ESCAPE_SEQUENCE;
+
+//
+// Order matches GetEscapeSequence() and the order XmlUnEscape has always
+// tried the sequences in.
+//
+STATIC CONST XML_ESCAPE_SEQUENCE  mXmlEscapeSequences[] = {
+  { "lt;",   3, '<'  },
+  { "gt;",   3, '>'  },
+  { "quot;", 5, '\"' },
+  { "apos;", 5, '\'' },
+  { "amp;",  4, '&'  }
+};
+
 //
 // Private function prototypes
 //
@@ -47,6 +74,14 @@ _GetXmlEscapedLength (
   IN UINTN        MaxStringLength
   );
 
+EFI_STATUS
+_XmlEscapeAppend (
+  IN OUT CHAR8        *Buffer,
+  IN     UINTN        BufferSize,
+  IN     CONST CHAR8  *String,
+  IN     UINTN        MaxStringLength
+  );
+
 /**
 Given a character, determine if it is white space.
 ch -- Character to test.
@@ -75,6 +110,79 @@ IsWhiteSpace (
   return fIsWhiteSpace;
 }// IsWhiteSpace()
 
+/**
+Count the white space characters at the start of Data.  Runs of spaces
+used for indenting are skipped a word at a time.
+
+@param Data    Characters to check
+@param Length  Number of characters in Data
+
+@return Number of leading white space characters.  Length if Data is all white space.
+**/
+STATIC
+UINTN
+CountLeadingWhiteSpace (
+  IN CONST CHAR8  *Data,
+  IN UINTN        Length
+  )
+{
+  UINTN  Index;
+
+  Index = 0;
+  while (Index < Length) {
+    if (((((UINTN)&Data[Index]) & (sizeof (UINTN) - 1)) == 0) && (Index + sizeof (UINTN) <= Length) &&
+        (*(CONST UINTN *)&Data[Index] == XML_WORD_ALL_SPACES))
+    {
+      Index += sizeof (UINTN);
+      continue;
+    }
+
+    if (!IsWhiteSpace (Data[Index])) {
+      break;
+    }
+
+    Index++;
+  }
+
+  return Index;
+}
+
+/**
+Count the white space characters at the end of Data.
+
+@param Data    Characters to check
+@param Length  Number of characters in Data
+
+@return Number of trailing white space characters.  Length if Data is all white space.
+**/
+STATIC
+UINTN
+CountTrailingWhiteSpace (
+  IN CONST CHAR8  *Data,
+  IN UINTN        Length
+  )
+{
+  UINTN  End;
+
+  End = Length;
+  while (End > 0) {
+    if (((((UINTN)&Data[End]) & (sizeof (UINTN) - 1)) == 0) && (End >= sizeof (UINTN)) &&
+        (*(CONST UINTN *)&Data[End - sizeof (UINTN)] == XML_WORD_ALL_SPACES))
+    {
+      End -= sizeof (UINTN);
+      continue;
+    }
+
+    if (!IsWhiteSpace (Data[End - 1])) {
+      break;
+    }
+
+    End--;
+  }
+
+  return Length - End;
+}
+
 /**
 Function to safely free a buffer.  If
 the buffer is NULL then just return.
@@ -90,6 +198,22 @@ SafeFreeBuffer (
   }
 }// SafeFreeBuffer()
 
+/**
+Function to drop the lookup index of a node.  The index
+is built lazily by XmlTreeQueryLib and must be discarded
+whenever the children or attributes of the node change.
+**/
+STATIC
+VOID
+InvalidateQueryIndex (
+  XmlNode  *Node
+  )
+{
+  if (Node != NULL) {
+    SafeFreeBuffer ((CHAR8 **)&Node->QueryIndex);
+  }
+}// InvalidateQueryIndex()
+
 //
 // Public functions
 //
@@ -181,6 +305,7 @@ AddNode (
       // Increase the number of child nodes that the parent owns.
       //
       Parent->NumChildren++;
+      InvalidateQueryIndex (Parent);
     }
 
     //
@@ -240,6 +365,7 @@ AddChildTree (
     // Increase the number of child nodes that the parent owns.
     //
     Parent->NumChildren++;
+    InvalidateQueryIndex (Parent);
 
     //
     // Set the node's new parent...
@@ -322,6 +448,7 @@ AddAttributeToNode (
     InsertTailList (&(Parent->AttributesListHead), &(Attribute->Link));
     Parent->NumAttributes++;
     Attribute->Parent = Parent;
+    InvalidateQueryIndex (Parent);
   } while (fDoOnce);
 
   //
@@ -398,6 +525,8 @@ DeleteNode (
   }// go to next attribute
 
   // now free our node memory
+  InvalidateQueryIndex (Node);
+  InvalidateQueryIndex (Node->ParentNode);
   SafeFreeBuffer (&(Node->XmlDeclaration.Declaration));
   SafeFreeBuffer (&(Node->Name));
   SafeFreeBuffer (&(Node->Value));
@@ -427,6 +556,7 @@ DeleteAttribute (
     return EFI_INVALID_PARAMETER;
   }
 
+  InvalidateQueryIndex (Attribute->Parent);
   SafeFreeBuffer (&(Attribute->Name));
   SafeFreeBuffer (&(Attribute->Value));
   Attribute->Parent = NULL;
@@ -627,14 +757,7 @@ _ToStringRecursively (
     }
 
     if (Escaped) {
-      CHAR8  *EscapedString = NULL;
-      Status = XmlEscape (Att->Value, XML_MAX_ATTRIBUTE_VALUE_LENGTH, &EscapedString);
-      if (EFI_ERROR (Status)) {
-        goto EXIT;
-      }
-
-      Status = AsciiStrCatS (String, BufferSize, EscapedString);
-      SafeFreeBuffer (&EscapedString);
+      Status = _XmlEscapeAppend (String, BufferSize, Att->Value, XML_MAX_ATTRIBUTE_VALUE_LENGTH);
     } else {
       Status = AsciiStrCatS (String, BufferSize, Att->Value);
     }
@@ -666,14 +789,7 @@ _ToStringRecursively (
     // Show Value if value
     if (Node->Value != NULL) {
       if (Escaped) {
-        CHAR8  *EscapedString = NULL;
-        Status = XmlEscape (Node->Value, XML_MAX_ELEMENT_VALUE_LENGTH, &EscapedString);
-        if (EFI_ERROR (Status)) {
-          goto EXIT;
-        }
-
-        Status = AsciiStrCatS (String, BufferSize, EscapedString);
-        SafeFreeBuffer (&EscapedString);
+        Status = _XmlEscapeAppend (String, BufferSize, Node->Value, XML_MAX_ELEMENT_VALUE_LENGTH);
       } else {
         Status = AsciiStrCatS (String, BufferSize, Node->Value);
       }
@@ -994,34 +1110,17 @@ BuildNodeList (
       }
 
       //
-      // See if we have a value.
+      // See if we have a value.  Trim leading and trailing whitespace.
       //
-      for (UINT32 i = 0; i < Next.Run.ulCharacters; i++) {
-        if (!IsWhiteSpace (LocalHyperSpace[i])) {
-          // MS_CHANGE
-          NotWhiteSpace = TRUE;
-          break;
-        } else {
-          // MS_CHANGE
-          LocalSize--;           // Trim leading whitespace       // MS_CHANGE
-          LocalHyperSpace++;     // MS_CHANGE
-        }
+      TempSize = CountLeadingWhiteSpace (LocalHyperSpace, LocalSize);
+      if (TempSize < LocalSize) {
+        NotWhiteSpace    = TRUE;
+        LocalHyperSpace += TempSize;
+        LocalSize       -= TempSize;
       }
 
       if (NotWhiteSpace) {
-        // MS_CHANGE
-        for (UINTN i = LocalSize-1; i > 0; i--) {
-          // MS_CHANGE
-          // MS_CHANGE
-          if (!IsWhiteSpace (LocalHyperSpace[i])) {
-            // MS_CHANGE
-            // MS_CHANGE
-            break;                                                // MS_CHANGE
-          } else {
-            // MS_CHANGE
-            LocalSize--;       // Trim trailing whitespace        // MS_CHANGE
-          }                                                       // MS_CHANGE
-        }                                                         // MS_CHANGE
+        LocalSize -= CountTrailingWhiteSpace (LocalHyperSpace, LocalSize);
 
         //
         // Allocate memory for the value.  This will be cleaned up when the
@@ -1034,10 +1133,7 @@ BuildNodeList (
         }
 
         DEBUG ((DEBUG_VERBOSE, "Found value %a\n", HyperSpace));
-        Status = AsciiStrnCpyS (Value, LocalSize + 1, LocalHyperSpace, LocalSize); // MS_CHANGE
-        if (EFI_ERROR (Status)) {
-          goto Exit;
-        }
+        CopyMem (Value, LocalHyperSpace, LocalSize);              // Value is zeroed so already terminated
 
         if (CurrentNode) {
           CurrentNode->Value = Value;
@@ -1149,6 +1245,226 @@ Exit:
   return Status;
 }// BuildNodeList()
 
+/**
+Trim white space from both ends of a slice.
+
+@param[in, out] Slice  Slice to trim
+
+@retval TRUE   Slice has non white space characters
+@retval FALSE  Slice was only white space
+**/
+STATIC
+BOOLEAN
+TrimSlice (
+  IN OUT XML_STRING_SLICE  *Slice
+  )
+{
+  UINTN  Leading;
+
+  Leading        = CountLeadingWhiteSpace (Slice->Data, Slice->Length);
+  Slice->Data   += Leading;
+  Slice->Length -= Leading;
+  Slice->Length -= CountTrailingWhiteSpace (Slice->Data, Slice->Length);
+
+  return (BOOLEAN)(Slice->Length > 0);
+}
+
+/**
+Compare a slice from ParseXmlStream to a null terminated string.
+
+@param[in]  Slice   Slice to compare
+@param[in]  String  Null terminated string
+
+@retval TRUE   The slice and the string are equal
+@retval FALSE  They are not equal
+**/
+BOOLEAN
+EFIAPI
+XmlSliceEqual (
+  IN CONST XML_STRING_SLICE  *Slice,
+  IN CONST CHAR8             *String
+  )
+{
+  if ((Slice == NULL) || (String == NULL)) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((AsciiStrnLenS (String, Slice->Length + 1) == Slice->Length) &&
+                   (CompareMem (Slice->Data, String, Slice->Length) == 0));
+}
+
+/**
+Parse an XML document and report elements, attributes and text to the
+callbacks without building a tree.  Nothing is copied or allocated; the
+callbacks get slices of XmlDocument.  Memory use only depends on the depth
+of the document.
+
+A callback can return any error to stop parsing early.  EFI_ABORTED is the
+suggested status once the caller has found what it needs.
+
+@param[in]  XmlDocument      XML document to parse
+@param[in]  SizeXmlDocument  Length of the document
+@param[in]  Callbacks        Event callbacks
+@param[in]  Context          Optional caller context passed to each callback
+
+@retval EFI_SUCCESS            The whole document was parsed
+@retval EFI_INVALID_PARAMETER  A parameter is invalid or the XML is malformed
+@retval EFI_BAD_BUFFER_SIZE    The document is nested deeper than XML_MAX_STREAM_DEPTH
+@retval Others                 Status returned by a callback that stopped parsing
+**/
+EFI_STATUS
+EFIAPI
+ParseXmlStream (
+  IN CONST CHAR8                 *XmlDocument,
+  IN       UINTN                 SizeXmlDocument,
+  IN CONST XML_STREAM_CALLBACKS  *Callbacks,
+  IN       VOID                  *Context OPTIONAL
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       EncodingLength = 0;
+  UINTN       Depth          = 0;
+  BOOLEAN     SawElement     = FALSE;
+
+  XML_TOKENIZATION_STATE  State;
+  XML_TOKENIZATION_INIT   Init;
+  XML_TOKEN               Next;
+  XML_STRING_SLICE        Slice;
+  XML_STRING_SLICE        AttributeName;
+  XML_STRING_SLICE        OpenElements[XML_MAX_STREAM_DEPTH];
+
+  if ((XmlDocument == NULL) || (SizeXmlDocument == 0) || (SizeXmlDocument > MAX_UINT32) || (Callbacks == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (&State, sizeof (State));
+  ZeroMem (&Init, sizeof (Init));
+  ZeroMem (&AttributeName, sizeof (AttributeName));
+
+  Init.Size            = sizeof (Init);
+  Init.XmlData         = (VOID *)XmlDocument;
+  Init.XmlDataSize     = (UINT32)SizeXmlDocument;
+  Init.SupportPosition = FALSE;
+
+  Status = RtlXmlInitializeTokenization (&State, &Init);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to initialize tokenization\n", __FUNCTION__));
+    return Status;
+  }
+
+  Status = RtlXmlDetermineStreamEncoding (&State, &EncodingLength);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to determine encoding type\n", __FUNCTION__));
+    return Status;
+  }
+
+  State.RawTokenState.pvCursor = (VOID *)(((UINTN)State.RawTokenState.pvCursor) + EncodingLength);
+
+  do {
+    Status = RtlXmlNextToken (&State, &Next, FALSE);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a - Failed to get the next token, Status = %r\n", __FUNCTION__, Status));
+      return Status;
+    }
+
+    if (Next.fError) {
+      DEBUG ((DEBUG_ERROR, "%a - Error during tokenization\n", __FUNCTION__));
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if (Next.State == XTSS_STREAM_END) {
+      break;
+    }
+
+    Slice.Data   = (CONST CHAR8 *)Next.Run.pvData;
+    Slice.Length = (UINTN)Next.Run.ulCharacters;
+
+    switch (Next.State) {
+      case XTSS_ELEMENT_NAME:
+        if (SawElement && (Depth == 0)) {
+          DEBUG ((DEBUG_ERROR, "%a - More than one root element\n", __FUNCTION__));
+          return EFI_INVALID_PARAMETER;
+        }
+
+        if (Depth >= XML_MAX_STREAM_DEPTH) {
+          DEBUG ((DEBUG_ERROR, "%a - Allowable depth exceeded\n", __FUNCTION__));
+          return EFI_BAD_BUFFER_SIZE;
+        }
+
+        OpenElements[Depth] = Slice;
+        SawElement          = TRUE;
+        if (Callbacks->StartElement != NULL) {
+          Status = Callbacks->StartElement (Context, &Slice, Depth);
+        }
+
+        Depth++;
+        break;
+
+      case XTSS_ELEMENT_ATTRIBUTE_NAME:
+        AttributeName = Slice;
+        break;
+
+      case XTSS_ELEMENT_ATTRIBUTE_VALUE:
+        if (Callbacks->Attribute != NULL) {
+          Status = Callbacks->Attribute (Context, &AttributeName, &Slice);
+        }
+
+        break;
+
+      case XTSS_STREAM_HYPERSPACE:
+        if ((Depth > 0) && TrimSlice (&Slice) && (Callbacks->Text != NULL)) {
+          Status = Callbacks->Text (Context, &Slice, Depth - 1);
+        }
+
+        break;
+
+      case XTSS_ENDELEMENT_NAME:
+        if ((Depth == 0) ||
+            (Slice.Length != OpenElements[Depth - 1].Length) ||
+            (CompareMem (Slice.Data, OpenElements[Depth - 1].Data, Slice.Length) != 0))
+        {
+          DEBUG ((DEBUG_ERROR, "%a - Ending element does not match the open element\n", __FUNCTION__));
+          return EFI_INVALID_PARAMETER;
+        }
+
+      // Fall through
+      case XTSS_ELEMENT_CLOSE_EMPTY:
+        if (Depth == 0) {
+          DEBUG ((DEBUG_ERROR, "%a - Close without an open element\n", __FUNCTION__));
+          return EFI_INVALID_PARAMETER;
+        }
+
+        Depth--;
+        if (Callbacks->EndElement != NULL) {
+          Status = Callbacks->EndElement (Context, &OpenElements[Depth], Depth);
+        }
+
+        break;
+
+      default:
+        break;
+    }
+
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_INFO, "%a - Stopped by callback. %r\n", __FUNCTION__, Status));
+      return Status;
+    }
+
+    Status = RtlXmlAdvanceTokenization (&State, &Next);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a - Failed to advance tokenization\n", __FUNCTION__));
+      return Status;
+    }
+  } while (Next.State != XTSS_STREAM_END);
+
+  if (!SawElement || (Depth != 0)) {
+    DEBUG ((DEBUG_ERROR, "%a - Document has no root element or unclosed elements\n", __FUNCTION__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
 This function will create a xml tree given an XML document as a ascii string.
 
@@ -1291,52 +1607,272 @@ DebugPrintXmlTree (
   return;
 }
 
+/**
+Return the escape sequence for a character or NULL if the character
+does not need to be escaped.
+**/
+STATIC
+CONST XML_ESCAPE_SEQUENCE *
+GetEscapeSequence (
+  IN CHAR8  Char
+  )
+{
+  switch (Char) {
+    case '<':
+      return &mXmlEscapeSequences[0];
+    case '>':
+      return &mXmlEscapeSequences[1];
+    case '\"':
+      return &mXmlEscapeSequences[2];
+    case '\'':
+      return &mXmlEscapeSequences[3];
+    case '&':
+      return &mXmlEscapeSequences[4];
+    default:
+      return NULL;
+  }
+}
+
+/**
+Find the next character in String that must be escaped.
+
+Whole aligned words are checked at once and only a word that contains one of
+the special characters is looked at byte by byte.  Nothing past Length is read.
+
+@param String  Characters to search
+@param Length  Number of characters in String
+
+@return Index of the first character that must be escaped or Length if there are none.
+**/
+STATIC
+UINTN
+FindNextEscapeChar (
+  IN CONST CHAR8  *String,
+  IN UINTN        Length
+  )
+{
+  UINTN  Index;
+  UINTN  Word;
+
+  Index = 0;
+  while ((Index < Length) && ((((UINTN)&String[Index]) & (sizeof (UINTN) - 1)) != 0)) {
+    if (GetEscapeSequence (String[Index]) != NULL) {
+      return Index;
+    }
+
+    Index++;
+  }
+
+  while (Index + sizeof (UINTN) <= Length) {
+    Word = *(CONST UINTN *)&String[Index];
+    if ((XML_WORD_HAS_BYTE (Word, '<') | XML_WORD_HAS_BYTE (Word, '>') | XML_WORD_HAS_BYTE (Word, '&') |
+         XML_WORD_HAS_BYTE (Word, '\"') | XML_WORD_HAS_BYTE (Word, '\'')) != 0)
+    {
+      break;
+    }
+
+    Index += sizeof (UINTN);
+  }
+
+  while (Index < Length) {
+    if (GetEscapeSequence (String[Index]) != NULL) {
+      return Index;
+    }
+
+    Index++;
+  }
+
+  return Length;
+}
+
+/**
+Find the next '&' in EscapedString.  Same word at a time approach as FindNextEscapeChar.
+
+@return Index of the next '&' or Length if there are none.
+**/
+STATIC
+UINTN
+FindNextAmpersand (
+  IN CONST CHAR8  *EscapedString,
+  IN UINTN        Length
+  )
+{
+  UINTN  Index;
+
+  Index = 0;
+  while ((Index < Length) && ((((UINTN)&EscapedString[Index]) & (sizeof (UINTN) - 1)) != 0)) {
+    if (EscapedString[Index] == '&') {
+      return Index;
+    }
+
+    Index++;
+  }
+
+  while ((Index + sizeof (UINTN) <= Length) && (XML_WORD_HAS_BYTE (*(CONST UINTN *)&EscapedString[Index], '&') == 0)) {
+    Index += sizeof (UINTN);
+  }
+
+  while (Index < Length) {
+    if (EscapedString[Index] == '&') {
+      return Index;
+    }
+
+    Index++;
+  }
+
+  return Length;
+}
+
+/**
+Match the escape sequence that starts with the '&' at the start of EscapedString.
+
+@param EscapedString  String starting with '&'
+@param Length         Number of characters available in EscapedString
+
+@return Matching escape sequence or NULL if the '&' does not start a valid escape sequence.
+**/
+STATIC
+CONST XML_ESCAPE_SEQUENCE *
+MatchEscapeSequence (
+  IN CONST CHAR8  *EscapedString,
+  IN UINTN        Length
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < ARRAYSIZE (mXmlEscapeSequences); Index++) {
+    if ((mXmlEscapeSequences[Index].Length <= Length) &&
+        (CompareMem (EscapedString, mXmlEscapeSequences[Index].Sequence, mXmlEscapeSequences[Index].Length) == 0))
+    {
+      return &mXmlEscapeSequences[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+Escape Length characters of String into Buffer.  Buffer must be large
+enough to hold the escaped string.  No NULL terminator is written.
+
+@return Number of characters written to Buffer
+**/
+STATIC
+UINTN
+InternalXmlEscapeCopy (
+  IN  CONST CHAR8  *String,
+  IN  UINTN        Length,
+  OUT CHAR8        *Buffer
+  )
+{
+  CONST XML_ESCAPE_SEQUENCE  *Sequence;
+  UINTN                      Run;
+  UINTN                      i;
+  UINTN                      j;
+
+  i = 0;
+  j = 0;
+  while (i < Length) {
+    // copy the run that doesn't need escaping in one go
+    Run = FindNextEscapeChar (&String[i], Length - i);
+    CopyMem (&Buffer[j], &String[i], Run);
+    i += Run;
+    j += Run;
+
+    if (i < Length) {
+      Sequence    = GetEscapeSequence (String[i++]);
+      Buffer[j++] = '&';
+      CopyMem (&Buffer[j], Sequence->Sequence, Sequence->Length);
+      j += Sequence->Length;
+    }
+  }
+
+  return j;
+}
+
+/**
+Remove the escape sequences from Length characters of EscapedString and write the
+result to Buffer.  Buffer may be the same as EscapedString to un-escape in place
+because the output is never longer than the input.  No NULL terminator is written.
+
+@return Number of characters written to Buffer
+**/
+STATIC
+UINTN
+InternalXmlUnEscapeCopy (
+  IN  CONST CHAR8  *EscapedString,
+  IN  UINTN        Length,
+  OUT CHAR8        *Buffer
+  )
+{
+  CONST XML_ESCAPE_SEQUENCE  *Sequence;
+  UINTN                      Run;
+  UINTN                      i;
+  UINTN                      j;
+
+  i = 0;
+  j = 0;
+  while (i < Length) {
+    Run = FindNextAmpersand (&EscapedString[i], Length - i);
+    if (&Buffer[j] != &EscapedString[i]) {
+      CopyMem (&Buffer[j], &EscapedString[i], Run);
+    }
+
+    i += Run;
+    j += Run;
+
+    if (i < Length) {
+      Sequence = MatchEscapeSequence (&EscapedString[i + 1], Length - i - 1);
+      if (Sequence != NULL) {
+        Buffer[j++] = Sequence->Char;
+        i          += Sequence->Length + 1;
+      } else {
+        DEBUG ((DEBUG_INFO, "%a found an & char that is not valid xml escape sequence\n", __FUNCTION__));
+        Buffer[j++] = EscapedString[i++];
+      }
+    }
+  }
+
+  return j;
+}
+
+/**
+return Length after removing escape sequences.  This length does not include null terminator
+**/
 UINTN
 _GetXmlUnEscapedLength (
   IN CONST CHAR8  *String,
   IN UINTN        MaxStringLength
   )
 {
-  UINTN  Len = 0;
-  UINTN  i   = 0;
+  CONST XML_ESCAPE_SEQUENCE  *Sequence;
+  UINTN                      StringLength;
+  UINTN                      Len;
+  UINTN                      i;
 
-  Len = AsciiStrnLenS (String, MaxStringLength + 1);
+  StringLength = AsciiStrnLenS (String, MaxStringLength + 1);
 
-  if (Len > MaxStringLength) {
+  if (StringLength > MaxStringLength) {
     DEBUG ((DEBUG_ERROR, "%a String is too big or not NULL terminated.  MaxLen = 0x%LX\n", __FUNCTION__, (UINT64)MaxStringLength));
-    ASSERT (Len <= MaxStringLength);
+    ASSERT (StringLength <= MaxStringLength);
     return 0;
   }
 
   // String is good null terminated string.
-  // loop thru all chars looking for chars that are escaped.
-  // When found subtract the size of escape sequence
-  while (String[i] != '\0') {
-    if (String[i] == '&') {
-      // Must use a string compare with length because
-      // string is not null terminated because we are
-      // in the middle of the string.
-      if (AsciiStrnCmp (&String[i + 1], "lt;", 3) == 0) {
-        Len -= 3;
-        i   += 3;
-      } else if (AsciiStrnCmp (&String[i + 1], "gt;", 3) == 0) {
-        Len -= 3;
-        i   += 3;
-      } else if (AsciiStrnCmp (&String[i + 1], "quot;", 5) == 0) {
-        Len -= 5;
-        i   += 5;
-      } else if (AsciiStrnCmp (&String[i + 1], "apos;", 5) == 0) {
-        Len -= 5;
-        i   += 5;
-      } else if (AsciiStrnCmp (&String[i + 1], "amp;", 4) == 0) {
-        Len -= 4;
-        i   += 4;
-      } else {
-        DEBUG ((DEBUG_INFO, "%a found an & char that is not valid xml escape sequence\n", __FUNCTION__));
-      }
+  // jump from '&' to '&' and subtract the size of each escape sequence found
+  Len = StringLength;
+  i   = FindNextAmpersand (String, StringLength);
+  while (i < StringLength) {
+    Sequence = MatchEscapeSequence (&String[i + 1], StringLength - i - 1);
+    if (Sequence != NULL) {
+      Len -= Sequence->Length;
+      i   += Sequence->Length;
+    } else {
+      DEBUG ((DEBUG_INFO, "%a found an & char that is not valid xml escape sequence\n", __FUNCTION__));
     }
 
     i++;
+    i += FindNextAmpersand (&String[i], StringLength - i);
   }
 
   return Len;
@@ -1351,43 +1887,70 @@ _GetXmlEscapedLength (
   IN UINTN        MaxStringLength
   )
 {
-  UINTN  Len = 0;
-  UINTN  i   = 0;
+  UINTN  StringLength;
+  UINTN  Len;
+  UINTN  i;
 
-  Len = AsciiStrnLenS (String, MaxStringLength + 1);
+  StringLength = AsciiStrnLenS (String, MaxStringLength + 1);
 
-  if (Len > MaxStringLength) {
+  if (StringLength > MaxStringLength) {
     DEBUG ((DEBUG_ERROR, "%a String is too big or not NULL terminated\n", __FUNCTION__));
-    ASSERT (Len <= MaxStringLength);
+    ASSERT (StringLength <= MaxStringLength);
     return 0;
   }
 
   // String is good null terminated string.
-  // loop thru all chars looking for chars that need
-  // to be escaped.  When found add the additional length
-  // of the escape sequence
-  while (String[i] != '\0') {
-    switch (String[i++]) {
-      case '<':  // &lt;
-      case '>':  // &gt;
-        Len += 3;
-        break;
+  // jump from special char to special char adding the
+  // additional length of each escape sequence
+  Len = StringLength;
+  i   = FindNextEscapeChar (String, StringLength);
+  while (i < StringLength) {
+    Len += GetEscapeSequence (String[i])->Length;
+    i++;
+    i += FindNextEscapeChar (&String[i], StringLength - i);
+  }
 
-      case '\"': // &quot;
-      case '\'': // &apos;
-        Len += 5;
-        break;
+  return Len;
+}
 
-      case '&': // &amp;
-        Len += 4;
-        break;
+/**
+Append the escaped form of String to the NULL terminated string in Buffer.
+Used when writing a tree so the escaped value doesn't need its own allocation.
 
-      default:
-        break;
-    }
+@param Buffer           NULL terminated string to append to
+@param BufferSize       Size of Buffer in bytes
+@param String           Ascii string to escape
+@param MaxStringLength  Max length of the Ascii string "String"
+
+@retval EFI_SUCCESS            Escaped string appended
+@retval EFI_INVALID_PARAMETER  String is empty or too long.  Same as XmlEscape.
+@retval EFI_BUFFER_TOO_SMALL   Buffer can't hold the escaped string
+**/
+EFI_STATUS
+_XmlEscapeAppend (
+  IN OUT CHAR8        *Buffer,
+  IN     UINTN        BufferSize,
+  IN     CONST CHAR8  *String,
+  IN     UINTN        MaxStringLength
+  )
+{
+  UINTN  EscapedLength;
+  UINTN  Used;
+
+  EscapedLength = _GetXmlEscapedLength (String, MaxStringLength);
+  if (EscapedLength == 0) {
+    DEBUG ((DEBUG_ERROR, "%a failed to get valid escaped length\n", __FUNCTION__));
+    return EFI_INVALID_PARAMETER;
   }
 
-  return Len;
+  Used = AsciiStrnLenS (Buffer, BufferSize);
+  if ((Used >= BufferSize) || (EscapedLength >= BufferSize - Used)) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Used        += InternalXmlEscapeCopy (String, AsciiStrLen (String), &Buffer[Used]);
+  Buffer[Used] = '\0';
+  return EFI_SUCCESS;
 }
 
 /**
@@ -1410,7 +1973,6 @@ XmlEscape (
 {
   UINTN  EscapedLength = 0;
   CHAR8  *EString      = NULL; // local copy of the escaped string
-  UINTN  i             = 0;
   UINTN  j             = 0;
 
   if (EscapedString == NULL) {
@@ -1423,102 +1985,18 @@ XmlEscape (
     return EFI_INVALID_PARAMETER;
   }
 
-  EString = AllocateZeroPool (EscapedLength +1); // add one for NULL termination
+  // Length is exact so the whole buffer gets written.  No need to zero it.
+  EString = AllocatePool (EscapedLength + 1); // add one for NULL termination
   if (EString == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  // Now traverse the String and escape chars
-  while ((String[i] != '\0') && (j < EscapedLength)) {
-    switch (String[i]) {
-      case '<': // &lt;
-        if (j + 4 > EscapedLength) {
-          DEBUG ((DEBUG_ERROR, "%a invalid parsing <.  J+4 will cause overflow\n", __FUNCTION__));
-          j = EscapedLength; // cause error to force break without corrupting memory
-          break;
-        }
-
-        EString[j++] = '&';
-        EString[j++] = 'l';
-        EString[j++] = 't';
-        EString[j++] = ';';
-        break;
-
-      case '>': // &gt;
-        if (j + 4 > EscapedLength) {
-          DEBUG ((DEBUG_ERROR, "%a invalid parsing >.  J + 4 will cause overflow\n", __FUNCTION__));
-          j = EscapedLength + 1; // cause error to force break without corrupting memory
-          break;
-        }
-
-        EString[j++] = '&';
-        EString[j++] = 'g';
-        EString[j++] = 't';
-        EString[j++] = ';';
-        break;
-
-      case '\"': // &quot;
-        if (j + 6 > EscapedLength) {
-          DEBUG ((DEBUG_ERROR, "%a invalid parsing \".  J+6 will cause overflow\n", __FUNCTION__));
-          j = EscapedLength +1;  // cause error to force break without corrupting memory
-          break;
-        }
-
-        EString[j++] = '&';
-        EString[j++] = 'q';
-        EString[j++] = 'u';
-        EString[j++] = 'o';
-        EString[j++] = 't';
-        EString[j++] = ';';
-        break;
-
-      case '\'': // &apos;
-        if (j + 6 > EscapedLength) {
-          DEBUG ((DEBUG_ERROR, "%a invalid parsing '.  J+6 will cause overflow\n", __FUNCTION__));
-          j = EscapedLength; // cause error to force break without corrupting memory
-          break;
-        }
-
-        EString[j++] = '&';
-        EString[j++] = 'a';
-        EString[j++] = 'p';
-        EString[j++] = 'o';
-        EString[j++] = 's';
-        EString[j++] = ';';
-        break;
-
-      case '&': // &amp;
-        if (j + 5 > EscapedLength) {
-          DEBUG ((DEBUG_ERROR, "%a invalid parsing &.  J+5 will cause overflow\n", __FUNCTION__));
-          j = EscapedLength +1;  // cause error to force break without corrupting memory
-          break;
-        }
-
-        EString[j++] = '&';
-        EString[j++] = 'a';
-        EString[j++] = 'm';
-        EString[j++] = 'p';
-        EString[j++] = ';';
-        break;
-
-      default:  // char that doesn't require escaping
-        EString[j++] = String[i];
-    }  // switch
-
-    i++;
-  } // while
+  j = InternalXmlEscapeCopy (String, AsciiStrLen (String), EString);
 
   // check for errors:
-  if ((j != EscapedLength) || (String[i] != '\0')) {
-    // report unique messages for easier debug
-    if (j != EscapedLength) {
-      DEBUG ((DEBUG_ERROR, "%a escape string process failed.  New String index counter (j = %d EscapedLength = %d) not at end point\n", __FUNCTION__, j, EscapedLength));
-      ASSERT (j == EscapedLength);
-    } else {
-      DEBUG ((DEBUG_ERROR, "%a escape string process failed.  Input String index counter (i = %d String[i] = %c) not at NULL terminator\n", __FUNCTION__, i, (CHAR16)String[i]));
-      ASSERT (String[i] == '\0');
-    }
-
+  if (j != EscapedLength) {
+    DEBUG ((DEBUG_ERROR, "%a escape string process failed.  New String index counter (j = %d EscapedLength = %d) not at end point\n", __FUNCTION__, j, EscapedLength));
+    ASSERT (j == EscapedLength);
     FreePool (EString);
     return EFI_DEVICE_ERROR;
   }
@@ -1546,12 +2024,9 @@ XmlUnEscape (
   OUT CHAR8       **String
   )
 {
-  UINTN  Length = 0;
+  UINTN  Length     = 0;
   CHAR8  *RawString = NULL; // local copy of the raw string
-  UINTN  i, j;
-
-  i = 0;
-  j = 0;
+  UINTN  j;
 
   if (String == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -1563,50 +2038,18 @@ XmlUnEscape (
     return EFI_INVALID_PARAMETER;
   }
 
-  RawString = AllocateZeroPool (Length + 1); // add one for NULL termination
+  // Length is exact so the whole buffer gets written.  No need to zero it.
+  RawString = AllocatePool (Length + 1); // add one for NULL termination
   if (RawString == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  // Now traverse the String and Unescape chars
-  while ((EscapedString[i] != '\0') && (j < Length)) {
-    if (EscapedString[i] == '&') {
-      if (AsciiStrnCmp (&EscapedString[i + 1], "lt;", 3) == 0) {
-        RawString[j++] = '<';
-        i             += 4;
-      } else if (AsciiStrnCmp (&EscapedString[i + 1], "gt;", 3) == 0) {
-        RawString[j++] = '>';
-        i             += 4;
-      } else if (AsciiStrnCmp (&EscapedString[i + 1], "quot;", 5) == 0) {
-        RawString[j++] = '"';
-        i             += 6;
-      } else if (AsciiStrnCmp (&EscapedString[i + 1], "apos;", 5) == 0) {
-        RawString[j++] = '\'';
-        i             += 6;
-      } else if (AsciiStrnCmp (&EscapedString[i + 1], "amp;", 4) == 0) {
-        RawString[j++] = '&';
-        i             += 5;
-      } else {
-        DEBUG ((DEBUG_INFO, "%a found an & char that is not valid xml escape sequence\n", __FUNCTION__));
-        RawString[j++] = EscapedString[i++];
-      }
-    } else {
-      // not an escape character
-      RawString[j++] = EscapedString[i++];
-    }
-  } // while
+  j = InternalXmlUnEscapeCopy (EscapedString, AsciiStrLen (EscapedString), RawString);
 
   // check for errors:
-  if ((j != Length) || (EscapedString[i] != '\0')) {
-    // report unique messages for easier debug
-    if (j != Length) {
-      DEBUG ((DEBUG_ERROR, "%a unescape string process failed.  New String index counter (j = %d Length = %d) not at end point\n", __FUNCTION__, j, Length));
-      ASSERT (j == Length);
-    } else {
-      DEBUG ((DEBUG_ERROR, "%a unescape string process failed.  Input String index counter (i = %d EscapedString[i] = %c) not at NULL terminator\n", __FUNCTION__, i, (CHAR16)EscapedString[i]));
-      ASSERT (EscapedString[i] == '\0');
-    }
-
+  if (j != Length) {
+    DEBUG ((DEBUG_ERROR, "%a unescape string process failed.  New String index counter (j = %d Length = %d) not at end point\n", __FUNCTION__, j, Length));
+    ASSERT (j == Length);
     FreePool (RawString);
     return EFI_DEVICE_ERROR;
   }
@@ -1617,6 +2060,48 @@ XmlUnEscape (
   return EFI_SUCCESS;
 }
 
+/**
+Remove XML escape sequences from the string without allocating a new one.
+The un-escaped string is never longer than the escaped string so it
+is written over the input.
+
+@param String - Xml Escaped Ascii string.  On success contains the un-escaped string.
+@param MaxStringLength - Max length of the Ascii string "String"
+@param Length - Optional.  On success set to the length of the un-escaped string.
+
+@retval EFI_SUCCESS            String was un-escaped
+@retval EFI_INVALID_PARAMETER  String is NULL, too long, or not NULL terminated
+**/
+EFI_STATUS
+EFIAPI
+XmlUnEscapeInPlace (
+  IN OUT CHAR8  *String,
+  IN     UINTN  MaxStringLength,
+  OUT    UINTN  *Length OPTIONAL
+  )
+{
+  UINTN  StringLength;
+
+  if (String == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  StringLength = AsciiStrnLenS (String, MaxStringLength + 1);
+  if (StringLength > MaxStringLength) {
+    DEBUG ((DEBUG_ERROR, "%a String is too big or not NULL terminated.  MaxLen = 0x%LX\n", __FUNCTION__, (UINT64)MaxStringLength));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  StringLength         = InternalXmlUnEscapeCopy (String, StringLength, String);
+  String[StringLength] = '\0';
+
+  if (Length != NULL) {
+    *Length = StringLength;
+  }
+
+  return EFI_SUCCESS;
+}
+
 /**
 Function to go thru a xml tree and count the nodes
 **/
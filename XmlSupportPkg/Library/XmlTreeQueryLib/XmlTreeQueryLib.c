@@ -12,10 +12,310 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <XmlTypes.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <XmlTypes.h>
 #include <Library/XmlTreeLib.h>
 #include <Library/XmlTreeQueryLib.h>
 
+#define XML_QUERY_INDEX_SIGNATURE  SIGNATURE_32 ('X', 'Q', 'I', 'X')
+#define XML_QUERY_SIGNATURE        SIGNATURE_32 ('X', 'Q', 'R', 'Y')
+
+//
+// One slot of the open addressed name table.  Entry is the first
+// XmlNode or XmlAttribute (in list order) with the given name.
+//
+typedef struct {
+  UINT32    Hash;
+  VOID      *Entry;
+} XML_QUERY_INDEX_SLOT;
+
+//
+// Per node lookup index.  It is a single pool allocation hung off
+// XmlNode.QueryIndex so XmlTreeLib can free it with FreePool when
+// the node changes.  The slot arrays follow the header.
+//
+typedef struct {
+  UINT32                  Signature;
+  UINTN                   NumChildren;        // NumChildren of the node when the index was built
+  UINTN                   NumAttributes;      // NumAttributes of the node when the index was built
+  UINTN                   ChildSlotCount;     // Power of 2
+  UINTN                   AttributeSlotCount; // Power of 2
+  XML_QUERY_INDEX_SLOT    *ChildSlots;
+  XML_QUERY_INDEX_SLOT    *AttributeSlots;
+} XML_QUERY_INDEX;
+
+//
+// One step of a compiled path query
+//
+typedef struct {
+  CONST CHAR8    *Name;           // NULL for wildcard
+  UINT32         NameHash;
+  CONST CHAR8    *AttributeName;  // NULL if the step has no predicate
+  UINT32         AttributeHash;
+  CONST CHAR8    *AttributeValue; // NULL if only presence of the attribute is required
+} XML_QUERY_STEP;
+
+struct _XML_QUERY {
+  UINT32            Signature;
+  BOOLEAN           Absolute;
+  UINTN             StepCount;
+  XML_QUERY_STEP    Steps[XML_QUERY_MAX_STEPS];
+  CHAR8             Strings[1];   // Copy of the path, split in place.  Must be last.
+};
+
+/**
+Hash a name.  Only the first MaxLength characters are used so that
+lookups agree with the AsciiStrnCmp based linear search.
+
+@param[in]  Name       Name to hash
+@param[in]  MaxLength  Max number of characters to consider
+
+@retval 32 bit FNV-1a hash of the name
+**/
+STATIC
+UINT32
+HashName (
+  IN CONST CHAR8  *Name,
+  IN UINTN        MaxLength
+  )
+{
+  UINT32  Hash;
+
+  Hash = 0x811C9DC5;
+  while ((*Name != '\0') && (MaxLength > 0)) {
+    Hash ^= (UINT8)*Name;
+    Hash *= 0x01000193;
+    Name++;
+    MaxLength--;
+  }
+
+  return Hash;
+}
+
+/**
+Get a slot count for a table that holds Count entries with a load factor of at most 1/2.
+**/
+STATIC
+UINTN
+GetSlotCount (
+  IN UINTN  Count
+  )
+{
+  UINTN  Slots;
+
+  Slots = 4;
+  while (Slots < (Count * 2)) {
+    Slots <<= 1;
+  }
+
+  return Slots;
+}
+
+/**
+Insert an entry into a slot table if no entry with the same name is there yet.
+Entries are inserted in list order so the slot always keeps the first match.
+**/
+STATIC
+VOID
+InsertSlot (
+  IN XML_QUERY_INDEX_SLOT  *Slots,
+  IN UINTN                 SlotCount,
+  IN UINT32                Hash,
+  IN VOID                  *Entry,
+  IN CONST CHAR8           *Name,
+  IN BOOLEAN               IsNode
+  )
+{
+  UINTN        Index;
+  CONST CHAR8  *SlotName;
+
+  for (Index = Hash & (SlotCount - 1); Slots[Index].Entry != NULL; Index = (Index + 1) & (SlotCount - 1)) {
+    if (Slots[Index].Hash == Hash) {
+      SlotName = IsNode ? ((XmlNode *)Slots[Index].Entry)->Name : ((XmlAttribute *)Slots[Index].Entry)->Name;
+      if (AsciiStrnCmp (Name, SlotName, MAX_ELEMENT_NAME_LENGTH) == 0) {
+        // keep the first one
+        return;
+      }
+    }
+  }
+
+  Slots[Index].Hash  = Hash;
+  Slots[Index].Entry = Entry;
+}
+
+/**
+Look up an entry in a slot table.
+
+@retval First XmlNode or XmlAttribute with the name or NULL if not found
+**/
+STATIC
+VOID *
+LookupSlot (
+  IN CONST XML_QUERY_INDEX_SLOT  *Slots,
+  IN UINTN                       SlotCount,
+  IN UINT32                      Hash,
+  IN CONST CHAR8                 *Name,
+  IN BOOLEAN                     IsNode
+  )
+{
+  UINTN        Index;
+  CONST CHAR8  *SlotName;
+
+  for (Index = Hash & (SlotCount - 1); Slots[Index].Entry != NULL; Index = (Index + 1) & (SlotCount - 1)) {
+    if (Slots[Index].Hash == Hash) {
+      SlotName = IsNode ? ((XmlNode *)Slots[Index].Entry)->Name : ((XmlAttribute *)Slots[Index].Entry)->Name;
+      if (AsciiStrnCmp (Name, SlotName, MAX_ELEMENT_NAME_LENGTH) == 0) {
+        return Slots[Index].Entry;
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/**
+Get the lookup index of a node, building it if needed.
+
+The index is only built for nodes that have at least XML_QUERY_INDEX_THRESHOLD
+children or attributes.  For smaller nodes a list walk is cheaper.
+
+@param[in]  Node  Node to get the index for
+
+@retval Index or NULL if the node is too small or memory could not be allocated
+**/
+STATIC
+CONST XML_QUERY_INDEX *
+GetQueryIndex (
+  IN CONST XmlNode  *Node
+  )
+{
+  XML_QUERY_INDEX  *QueryIndex;
+  LIST_ENTRY       *Link;
+  UINTN            ChildSlotCount;
+  UINTN            AttributeSlotCount;
+
+  QueryIndex = (XML_QUERY_INDEX *)Node->QueryIndex;
+  if (QueryIndex != NULL) {
+    if ((QueryIndex->Signature == XML_QUERY_INDEX_SIGNATURE) &&
+        (QueryIndex->NumChildren == Node->NumChildren) &&
+        (QueryIndex->NumAttributes == Node->NumAttributes))
+    {
+      return QueryIndex;
+    }
+
+    // Stale index.  Tree was changed without going thru XmlTreeLib.
+    FreePool (QueryIndex);
+    ((XmlNode *)Node)->QueryIndex = NULL;
+  }
+
+  if ((Node->NumChildren < XML_QUERY_INDEX_THRESHOLD) && (Node->NumAttributes < XML_QUERY_INDEX_THRESHOLD)) {
+    return NULL;
+  }
+
+  ChildSlotCount     = GetSlotCount (Node->NumChildren);
+  AttributeSlotCount = GetSlotCount (Node->NumAttributes);
+  QueryIndex         = AllocateZeroPool (sizeof (XML_QUERY_INDEX) + ((ChildSlotCount + AttributeSlotCount) * sizeof (XML_QUERY_INDEX_SLOT)));
+  if (QueryIndex == NULL) {
+    DEBUG ((DEBUG_WARN, "%a - Failed to allocate index for node '%a'.  Using list walk.\n", __FUNCTION__, Node->Name));
+    return NULL;
+  }
+
+  QueryIndex->Signature          = XML_QUERY_INDEX_SIGNATURE;
+  QueryIndex->NumChildren        = Node->NumChildren;
+  QueryIndex->NumAttributes      = Node->NumAttributes;
+  QueryIndex->ChildSlotCount     = ChildSlotCount;
+  QueryIndex->AttributeSlotCount = AttributeSlotCount;
+  QueryIndex->ChildSlots         = (XML_QUERY_INDEX_SLOT *)(QueryIndex + 1);
+  QueryIndex->AttributeSlots     = QueryIndex->ChildSlots + ChildSlotCount;
+
+  for (Link = GetFirstNode (&Node->ChildrenListHead);
+       !IsNull (&Node->ChildrenListHead, Link);
+       Link = GetNextNode (&Node->ChildrenListHead, Link))
+  {
+    XmlNode  *NodeThis = (XmlNode *)Link;
+    InsertSlot (QueryIndex->ChildSlots, ChildSlotCount, HashName (NodeThis->Name, MAX_ELEMENT_NAME_LENGTH), NodeThis, NodeThis->Name, TRUE);
+  }
+
+  for (Link = GetFirstNode (&Node->AttributesListHead);
+       !IsNull (&Node->AttributesListHead, Link);
+       Link = GetNextNode (&Node->AttributesListHead, Link))
+  {
+    XmlAttribute  *AttrThis = (XmlAttribute *)Link;
+    InsertSlot (QueryIndex->AttributeSlots, AttributeSlotCount, HashName (AttrThis->Name, MAX_ATTRIBUTE_NAME_LENGTH), AttrThis, AttrThis->Name, FALSE);
+  }
+
+  // The index is a cache.  Building it does not logically change the node.
+  ((XmlNode *)Node)->QueryIndex = QueryIndex;
+  return QueryIndex;
+}
+
+/**
+Internal child lookup that uses the index when there is one.
+**/
+STATIC
+XmlNode *
+InternalFindChild (
+  IN CONST XmlNode  *ParentNode,
+  IN CONST CHAR8    *ElementName,
+  IN UINT32         Hash
+  )
+{
+  CONST XML_QUERY_INDEX  *QueryIndex;
+  LIST_ENTRY             *Link;
+
+  if (ParentNode->NumChildren >= XML_QUERY_INDEX_THRESHOLD) {
+    QueryIndex = GetQueryIndex (ParentNode);
+    if (QueryIndex != NULL) {
+      return (XmlNode *)LookupSlot (QueryIndex->ChildSlots, QueryIndex->ChildSlotCount, Hash, ElementName, TRUE);
+    }
+  }
+
+  for (Link = GetFirstNode (&ParentNode->ChildrenListHead);
+       !IsNull (&ParentNode->ChildrenListHead, Link);
+       Link = GetNextNode (&ParentNode->ChildrenListHead, Link))
+  {
+    if (AsciiStrnCmp (ElementName, ((XmlNode *)Link)->Name, MAX_ELEMENT_NAME_LENGTH) == 0) {
+      return (XmlNode *)Link;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+Internal attribute lookup that uses the index when there is one.
+**/
+STATIC
+XmlAttribute *
+InternalFindAttribute (
+  IN CONST XmlNode  *Node,
+  IN CONST CHAR8    *AttributeName,
+  IN UINT32         Hash
+  )
+{
+  CONST XML_QUERY_INDEX  *QueryIndex;
+  LIST_ENTRY             *Link;
+
+  if (Node->NumAttributes >= XML_QUERY_INDEX_THRESHOLD) {
+    QueryIndex = GetQueryIndex (Node);
+    if (QueryIndex != NULL) {
+      return (XmlAttribute *)LookupSlot (QueryIndex->AttributeSlots, QueryIndex->AttributeSlotCount, Hash, AttributeName, FALSE);
+    }
+  }
+
+  for (Link = GetFirstNode (&Node->AttributesListHead);
+       !IsNull (&Node->AttributesListHead, Link);
+       Link = GetNextNode (&Node->AttributesListHead, Link))
+  {
+    if (AsciiStrnCmp (AttributeName, ((XmlAttribute *)Link)->Name, MAX_ATTRIBUTE_NAME_LENGTH) == 0) {
+      return (XmlAttribute *)Link;
+    }
+  }
+
+  return NULL;
+}
+
 /**
 Find the first 1st generation child that has a matching ElementName
 
@@ -31,7 +331,7 @@ FindFirstChildNodeByName (
   IN CONST CHAR8    *ElementName
   )
 {
-  LIST_ENTRY  *Link = NULL;
+  XmlNode  *NodeThis;
 
   if (ParentNode == NULL) {
     DEBUG ((DEBUG_ERROR, "%a - Parent Node is NULL\n", __FUNCTION__));
@@ -48,21 +348,12 @@ FindFirstChildNodeByName (
   DEBUG ((DEBUG_INFO, "%a - Looking for '%a;\n", __FUNCTION__, ElementName));
   DEBUG ((DEBUG_INFO, "%a - Looking in children of '%a\n", __FUNCTION__, ParentNode->Name));
 
-  for (Link = GetFirstNode (&ParentNode->ChildrenListHead);
-       !IsNull (&ParentNode->ChildrenListHead, Link);
-       Link = GetNextNode (&ParentNode->ChildrenListHead, Link))
-  {
-    XmlNode  *NodeThis = (XmlNode *)Link;
-    DEBUG ((DEBUG_INFO, "Checking Node: ElementName = '%a'\n", NodeThis->Name));
-    if (AsciiStrnCmp (ElementName, NodeThis->Name, MAX_ELEMENT_NAME_LENGTH) == 0) {
-      // Found it
-      DEBUG ((DEBUG_INFO, "Found element\n"));
-      return NodeThis;
-    }
+  NodeThis = InternalFindChild (ParentNode, ElementName, HashName (ElementName, MAX_ELEMENT_NAME_LENGTH));
+  if (NodeThis == NULL) {
+    DEBUG ((DEBUG_INFO, "Didn't find element named %a\n", ElementName));
   }
 
-  DEBUG ((DEBUG_INFO, "Didn't find element named %a\n", ElementName));
-  return NULL;
+  return NodeThis;
 }
 
 /**
@@ -80,7 +371,7 @@ FindFirstAttributeByName (
   IN CONST CHAR8    *AttributeName
   )
 {
-  LIST_ENTRY  *Link = NULL;
+  XmlAttribute  *AttrThis;
 
   if (Node == NULL) {
     DEBUG ((DEBUG_ERROR, "%a - Node is NULL\n", __FUNCTION__));
@@ -97,19 +388,470 @@ FindFirstAttributeByName (
   DEBUG ((DEBUG_INFO, "%a - Looking for attribute with name '%a'\n", __FUNCTION__, AttributeName));
   DEBUG ((DEBUG_INFO, "%a - Looking in attributes of node '%a'\n", __FUNCTION__, Node->Name));
 
-  for (Link = GetFirstNode (&Node->AttributesListHead);
-       !IsNull (&Node->AttributesListHead, Link);
-       Link = GetNextNode (&Node->AttributesListHead, Link))
-  {
-    XmlAttribute  *AttrThis = (XmlAttribute *)Link;
-    DEBUG ((DEBUG_INFO, "Checking Attribute: Name = '%a'\n", AttrThis->Name));
-    if (AsciiStrnCmp (AttributeName, AttrThis->Name, MAX_ATTRIBUTE_NAME_LENGTH) == 0) {
-      // Found it
-      DEBUG ((DEBUG_INFO, "Found Attribute\n"));
-      return AttrThis;
+  AttrThis = InternalFindAttribute (Node, AttributeName, HashName (AttributeName, MAX_ATTRIBUTE_NAME_LENGTH));
+  if (AttrThis == NULL) {
+    DEBUG ((DEBUG_INFO, "Didn't find Attribute named '%a'\n", AttributeName));
+  }
+
+  return AttrThis;
+}
+
+/**
+Parse one step of a path query in place.
+
+@param[in, out] Cursor  Start of the step.  On return points past the step.
+@param[out]     Step    Step to fill in
+
+@retval EFI_SUCCESS            Step parsed
+@retval EFI_INVALID_PARAMETER  Step is malformed
+**/
+STATIC
+EFI_STATUS
+ParseQueryStep (
+  IN OUT CHAR8           **Cursor,
+  OUT    XML_QUERY_STEP  *Step
+  )
+{
+  CHAR8  *Char;
+  CHAR8  Quote;
+
+  Char = *Cursor;
+  ZeroMem (Step, sizeof (XML_QUERY_STEP));
+
+  Step->Name = Char;
+  while ((*Char != '\0') && (*Char != '/') && (*Char != '[')) {
+    Char++;
+  }
+
+  if (Char == Step->Name) {
+    DEBUG ((DEBUG_ERROR, "%a - Empty step name\n", __FUNCTION__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (*Char == '[') {
+    *Char++ = '\0';
+    if (*Char++ != '@') {
+      DEBUG ((DEBUG_ERROR, "%a - Only attribute predicates are supported\n", __FUNCTION__));
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Step->AttributeName = Char;
+    while ((*Char != '\0') && (*Char != '=') && (*Char != ']')) {
+      Char++;
+    }
+
+    if ((*Char == '\0') || (Char == Step->AttributeName)) {
+      DEBUG ((DEBUG_ERROR, "%a - Malformed predicate\n", __FUNCTION__));
+      return EFI_INVALID_PARAMETER;
+    }
+
+    if (*Char == '=') {
+      *Char++ = '\0';
+      Quote   = '\0';
+      if ((*Char == '\'') || (*Char == '"')) {
+        Quote = *Char++;
+      }
+
+      Step->AttributeValue = Char;
+      while ((*Char != '\0') && (*Char != ((Quote != '\0') ? Quote : ']'))) {
+        Char++;
+      }
+
+      if (*Char == '\0') {
+        DEBUG ((DEBUG_ERROR, "%a - Unterminated predicate value\n", __FUNCTION__));
+        return EFI_INVALID_PARAMETER;
+      }
+
+      if (Quote != '\0') {
+        *Char++ = '\0';
+        if (*Char != ']') {
+          DEBUG ((DEBUG_ERROR, "%a - Expected ] after quoted value\n", __FUNCTION__));
+          return EFI_INVALID_PARAMETER;
+        }
+      }
+    }
+
+    // Char points at the closing ]
+    *Char++ = '\0';
+    if ((*Char != '\0') && (*Char != '/')) {
+      DEBUG ((DEBUG_ERROR, "%a - Unexpected character after predicate\n", __FUNCTION__));
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Step->AttributeHash = HashName (Step->AttributeName, MAX_ATTRIBUTE_NAME_LENGTH);
+  }
+
+  if (*Char == '/') {
+    *Char++ = '\0';
+    if (*Char == '\0') {
+      DEBUG ((DEBUG_ERROR, "%a - Path ends with /\n", __FUNCTION__));
+      return EFI_INVALID_PARAMETER;
+    }
+  }
+
+  if (AsciiStrCmp (Step->Name, "*") == 0) {
+    Step->Name = NULL;
+  } else {
+    Step->NameHash = HashName (Step->Name, MAX_ELEMENT_NAME_LENGTH);
+  }
+
+  *Cursor = Char;
+  return EFI_SUCCESS;
+}
+
+/**
+Compile a path query so it can be executed many times without being re-parsed.
+
+The path is a '/' separated list of element names.  Each step can be the
+wildcard '*' and can have one attribute predicate, either [@name] to require
+the attribute or [@name=value] to require the value.  Values can be quoted
+with ' or ".  A leading '/' makes the first step match the starting node
+itself; otherwise the first step matches its children.
+
+  Example: "/Root/Suite[@name='x']/Case"
+
+@param[in]  Path   Null terminated path to compile
+@param[out] Query  Compiled query.  Free with FreeXmlQuery.
+
+@retval EFI_SUCCESS            Query was compiled
+@retval EFI_INVALID_PARAMETER  A parameter is NULL or the path is malformed
+@retval EFI_OUT_OF_RESOURCES   Memory allocation failed
+**/
+EFI_STATUS
+EFIAPI
+CompileXmlQuery (
+  IN  CONST CHAR8  *Path,
+  OUT XML_QUERY    **Query
+  )
+{
+  EFI_STATUS  Status;
+  XML_QUERY   *NewQuery;
+  CHAR8       *Cursor;
+  UINTN       PathSize;
+
+  if ((Path == NULL) || (Query == NULL)) {
+    DEBUG ((DEBUG_ERROR, "%a - Invalid parameter\n", __FUNCTION__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Query   = NULL;
+  PathSize = AsciiStrSize (Path);
+  NewQuery = AllocateZeroPool (sizeof (XML_QUERY) + PathSize);
+  if (NewQuery == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  NewQuery->Signature = XML_QUERY_SIGNATURE;
+  CopyMem (NewQuery->Strings, Path, PathSize);
+  Cursor = NewQuery->Strings;
+  if (*Cursor == '/') {
+    NewQuery->Absolute = TRUE;
+    Cursor++;
+  }
+
+  Status = EFI_SUCCESS;
+  while (*Cursor != '\0') {
+    if (NewQuery->StepCount >= XML_QUERY_MAX_STEPS) {
+      DEBUG ((DEBUG_ERROR, "%a - Path has more than %d steps\n", __FUNCTION__, XML_QUERY_MAX_STEPS));
+      Status = EFI_INVALID_PARAMETER;
+      break;
+    }
+
+    Status = ParseQueryStep (&Cursor, &NewQuery->Steps[NewQuery->StepCount]);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    NewQuery->StepCount++;
+  }
+
+  if (!EFI_ERROR (Status) && (NewQuery->StepCount == 0)) {
+    DEBUG ((DEBUG_ERROR, "%a - Path has no steps\n", __FUNCTION__));
+    Status = EFI_INVALID_PARAMETER;
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a - Failed to compile '%a'. %r\n", __FUNCTION__, Path, Status));
+    FreePool (NewQuery);
+    return Status;
+  }
+
+  *Query = NewQuery;
+  return EFI_SUCCESS;
+}
+
+/**
+Free a query created by CompileXmlQuery
+
+@param[in]  Query  Query to free.  Can be NULL.
+**/
+VOID
+EFIAPI
+FreeXmlQuery (
+  IN XML_QUERY  *Query
+  )
+{
+  if (Query != NULL) {
+    ASSERT (Query->Signature == XML_QUERY_SIGNATURE);
+    FreePool (Query);
+  }
+}
+
+/**
+Check if a node satisfies the name and predicate of a step
+**/
+STATIC
+BOOLEAN
+NodeMatchesStep (
+  IN CONST XmlNode         *Node,
+  IN CONST XML_QUERY_STEP  *Step
+  )
+{
+  XmlAttribute  *Attribute;
+
+  if ((Step->Name != NULL) && (AsciiStrnCmp (Step->Name, Node->Name, MAX_ELEMENT_NAME_LENGTH) != 0)) {
+    return FALSE;
+  }
+
+  if (Step->AttributeName == NULL) {
+    return TRUE;
+  }
+
+  Attribute = InternalFindAttribute (Node, Step->AttributeName, Step->AttributeHash);
+  if (Attribute == NULL) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((Step->AttributeValue == NULL) || (AsciiStrCmp (Step->AttributeValue, Attribute->Value) == 0));
+}
+
+STATIC
+XmlNode *
+MatchSteps (
+  IN CONST XmlNode    *Node,
+  IN CONST XML_QUERY  *Query,
+  IN UINTN            StepIndex
+  );
+
+/**
+Depth first search of the steps starting at StepIndex, trying Link and the
+siblings that follow it under Parent.
+
+@param[in]  Parent     Node whose children are matched against Steps[StepIndex]
+@param[in]  Query      Compiled query
+@param[in]  StepIndex  Step to match
+@param[in]  Link       First child of Parent to try
+
+@retval First match or NULL
+**/
+STATIC
+XmlNode *
+MatchSiblings (
+  IN CONST XmlNode    *Parent,
+  IN CONST XML_QUERY  *Query,
+  IN UINTN            StepIndex,
+  IN LIST_ENTRY       *Link
+  )
+{
+  XmlNode  *Candidate;
+  XmlNode  *Result;
+
+  for ( ; !IsNull (&Parent->ChildrenListHead, Link); Link = GetNextNode (&Parent->ChildrenListHead, Link)) {
+    Candidate = (XmlNode *)Link;
+    if (!NodeMatchesStep (Candidate, &Query->Steps[StepIndex])) {
+      continue;
+    }
+
+    if (StepIndex + 1 == Query->StepCount) {
+      return Candidate;
+    }
+
+    Result = MatchSteps (Candidate, Query, StepIndex + 1);
+    if (Result != NULL) {
+      return Result;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+Depth first search of the steps starting at StepIndex under the children of Node.
+
+@param[in]  Node       Node whose children are matched against Steps[StepIndex]
+@param[in]  Query      Compiled query
+@param[in]  StepIndex  Step to match
+
+@retval First match or NULL
+**/
+STATIC
+XmlNode *
+MatchSteps (
+  IN CONST XmlNode    *Node,
+  IN CONST XML_QUERY  *Query,
+  IN UINTN            StepIndex
+  )
+{
+  CONST XML_QUERY_STEP  *Step;
+  XmlNode               *Candidate;
+
+  Step = &Query->Steps[StepIndex];
+
+  //
+  // With a name the index takes us straight to the first candidate.
+  // Later siblings with the same name are found by walking on from there.
+  //
+  if (Step->Name == NULL) {
+    return MatchSiblings (Node, Query, StepIndex, GetFirstNode (&Node->ChildrenListHead));
+  }
+
+  Candidate = InternalFindChild (Node, Step->Name, Step->NameHash);
+  if (Candidate == NULL) {
+    return NULL;
+  }
+
+  return MatchSiblings (Node, Query, StepIndex, &Candidate->Link);
+}
+
+/**
+Check the parameters passed to XmlQueryFindFirst and XmlQueryFindNext.
+
+@retval TRUE   Parameters are valid.
+@retval FALSE  Parameters are invalid.
+**/
+STATIC
+BOOLEAN
+IsValidQuery (
+  IN CONST XmlNode    *Node,
+  IN CONST XML_QUERY  *Query
+  )
+{
+  if ((Node == NULL) || (Query == NULL)) {
+    DEBUG ((DEBUG_ERROR, "%a - Invalid parameter\n", __FUNCTION__));
+    return FALSE;
+  }
+
+  if (Query->Signature != XML_QUERY_SIGNATURE) {
+    DEBUG ((DEBUG_ERROR, "%a - Query is not a compiled query\n", __FUNCTION__));
+    ASSERT (Query->Signature == XML_QUERY_SIGNATURE);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+Execute a compiled query and return the first matching node in document order.
+
+@param[in]  Node   Starting node for the query
+@param[in]  Query  Compiled query
+
+@retval XmlNode that matches or NULL if not found
+**/
+XmlNode *
+EFIAPI
+XmlQueryFindFirst (
+  IN CONST XmlNode    *Node,
+  IN CONST XML_QUERY  *Query
+  )
+{
+  if (!IsValidQuery (Node, Query)) {
+    return NULL;
+  }
+
+  if (!Query->Absolute) {
+    return MatchSteps (Node, Query, 0);
+  }
+
+  //
+  // The first step of an absolute query must match the starting node itself
+  //
+  if (!NodeMatchesStep (Node, &Query->Steps[0])) {
+    return NULL;
+  }
+
+  if (Query->StepCount == 1) {
+    return (XmlNode *)Node;
+  }
+
+  return MatchSteps (Node, Query, 1);
+}
+
+/**
+Execute a compiled query and return the next matching node after Previous.
+
+The search resumes where Previous was found instead of running the query
+again, so iterating over all matches visits each node at most once.
+
+@param[in]  Node      Starting node used for XmlQueryFindFirst
+@param[in]  Query     Compiled query
+@param[in]  Previous  Node returned by the last XmlQueryFindFirst or XmlQueryFindNext
+
+@retval XmlNode that matches or NULL if there are no more matches
+**/
+XmlNode *
+EFIAPI
+XmlQueryFindNext (
+  IN CONST XmlNode    *Node,
+  IN CONST XML_QUERY  *Query,
+  IN CONST XmlNode    *Previous
+  )
+{
+  CONST XmlNode  *Path[XML_QUERY_MAX_STEPS];
+  XmlNode        *Result;
+  UINTN          FirstStep;
+  UINTN          StepIndex;
+
+  if (Previous == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a - Previous is NULL\n", __FUNCTION__));
+    return NULL;
+  }
+
+  if (!IsValidQuery (Node, Query)) {
+    return NULL;
+  }
+
+  //
+  // A single step absolute query only ever matches the starting node
+  //
+  FirstStep = Query->Absolute ? 1 : 0;
+  if (FirstStep >= Query->StepCount) {
+    return NULL;
+  }
+
+  //
+  // Every step is one generation, so the ancestors of Previous are the nodes
+  // the earlier steps matched.  They are where the search left off.
+  //
+  Path[Query->StepCount - 1] = Previous;
+  for (StepIndex = Query->StepCount - 1; StepIndex > FirstStep; StepIndex--) {
+    Path[StepIndex - 1] = Path[StepIndex]->ParentNode;
+    if (Path[StepIndex - 1] == NULL) {
+      break;
+    }
+  }
+
+  if ((StepIndex != FirstStep) || (Path[FirstStep]->ParentNode != Node)) {
+    DEBUG ((DEBUG_ERROR, "%a - Previous was not returned by this query from this node\n", __FUNCTION__));
+    return NULL;
+  }
+
+  //
+  // Try the siblings after the matched node at each step, deepest first.
+  //
+  StepIndex = Query->StepCount;
+  while (StepIndex > FirstStep) {
+    StepIndex--;
+    Result = MatchSiblings (
+               Path[StepIndex]->ParentNode,
+               Query,
+               StepIndex,
+               GetNextNode (&Path[StepIndex]->ParentNode->ChildrenListHead, (LIST_ENTRY *)&Path[StepIndex]->Link)
+               );
+    if (Result != NULL) {
+      return Result;
     }
   }
 
-  DEBUG ((DEBUG_INFO, "Didn't find Attribute named '%a'\n", AttributeName));
   return NULL;
 }
@@ -0,0 +1,360 @@
+/**
+@file
+Tests for XmlEscape and XmlUnEscape.  Fixed vectors pin the output of the
+escape and un-escape tables.  Fuzzed strings are built from random runs of
+plain text, special characters, and complete and partial escape sequences
+and placed at random alignments.
+
+Copyright (C) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PseudoRandomLib.h>
+#include <Library/UnitTestLib.h>
+#include <XmlTypes.h>
+#include <Library/XmlTreeLib.h>
+#include "EscapeFuzzTests.h"
+
+#define FUZZ_ITERATIONS       (2000)
+#define FUZZ_MAX_LENGTH       (600)
+#define FUZZ_LARGE_LENGTH     (60000)
+#define FUZZ_MAX_ALIGNMENT    (16)
+#define FUZZ_BUFFER_SIZE      (FUZZ_LARGE_LENGTH + FUZZ_MAX_ALIGNMENT + 64)
+#define FUZZ_SEED             (0x584D4C31)
+
+STATIC CONST CHAR8  *mFuzzFragments[] = {
+  "<",        ">",        "\"",     "'",    "&",
+  "&lt;",     "&gt;",     "&quot;",  "&apos;", "&amp;",
+  "&l",       "&lt",      "&quot",   "&am",    "&&",
+  "&amp;lt;", "a",        "abcdefgh",
+  "        ", "\r\n\t",
+  "QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVo wMTIzNDU2Nzg5Kw=="
+};
+
+STATIC UINT64  mFuzzState;
+
+typedef struct {
+  CONST CHAR8    *Input;
+  CONST CHAR8    *Expected;         // NULL when the input must be rejected
+} ESCAPE_VECTOR;
+
+//
+// Expected output for every entry in the escape table, alone and mixed with
+// text long enough to cross a word boundary.
+//
+STATIC CONST ESCAPE_VECTOR  mEscapeVectors[] = {
+  { "a",                               "a"                                                            },
+  { "<",                               "&lt;"                                                         },
+  { ">",                               "&gt;"                                                         },
+  { "\"",                              "&quot;"                                                       },
+  { "'",                               "&apos;"                                                       },
+  { "&",                               "&amp;"                                                        },
+  { "&lt;",                            "&amp;lt;"                                                     },
+  { "<a href=\"x\">Tom & Jerry's</a>", "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&apos;s&lt;/a&gt;" },
+  { "abcdefghijklmnopqrstuvwxyz<",     "abcdefghijklmnopqrstuvwxyz&lt;"                               },
+  { "<<>>\r\n\t  ",                    "&lt;&lt;&gt;&gt;\r\n\t  "                                     },
+  { "",                                NULL                                                           }
+};
+
+//
+// Expected output for every entry in the un-escape table, partial and unknown
+// sequences that must be left alone, and a sequence that is only un-escaped once.
+//
+STATIC CONST ESCAPE_VECTOR  mUnEscapeVectors[] = {
+  { "a",                                                            "a"                               },
+  { "&lt;",                                                         "<"                               },
+  { "&gt;",                                                         ">"                               },
+  { "&quot;",                                                       "\""                              },
+  { "&apos;",                                                       "'"                               },
+  { "&amp;",                                                        "&"                               },
+  { "&amp;lt;",                                                     "&lt;"                            },
+  { "&",                                                            "&"                               },
+  { "&&",                                                           "&&"                              },
+  { "&l",                                                           "&l"                              },
+  { "&lt",                                                          "&lt"                             },
+  { "&quot",                                                        "&quot"                           },
+  { "&foo;",                                                        "&foo;"                           },
+  { "&lt;a href=&quot;x&quot;&gt;Tom &amp; Jerry&apos;s&lt;/a&gt;", "<a href=\"x\">Tom & Jerry's</a>" },
+  { "abcdefghijklmnopqrstuvwxyz&amp;",                              "abcdefghijklmnopqrstuvwxyz&"     },
+  { "",                                                             NULL                              }
+};
+
+//
+// Fuzz helpers
+//
+
+/**
+Fill Buffer with a NULL terminated string of about Length characters
+built from random fragments.
+**/
+STATIC
+VOID
+BuildFuzzString (
+  OUT CHAR8  *Buffer,
+  IN  UINTN  Length
+  )
+{
+  CONST CHAR8  *Fragment;
+  UINTN        Used;
+  UINTN        FragmentLength;
+
+  Used = 0;
+  while (Used < Length) {
+    Fragment       = mFuzzFragments[PseudoRandomBelow (&mFuzzState, ARRAY_SIZE (mFuzzFragments))];
+    FragmentLength = MIN (AsciiStrLen (Fragment), Length - Used);
+    CopyMem (&Buffer[Used], Fragment, FragmentLength);
+    Used += FragmentLength;
+  }
+
+  Buffer[Used] = '\0';
+}
+
+/**
+Un-escape Input with both the allocating and in place versions and require
+identical results.  The only input the allocating version rejects is one that
+un-escapes to nothing, which in place reports as length 0.
+**/
+STATIC
+UNIT_TEST_STATUS
+CompareUnEscape (
+  IN CONST CHAR8  *Input,
+  IN CHAR8        *Scratch
+  )
+{
+  EFI_STATUS  Status;
+  CHAR8       *Output = NULL;
+  UINTN       Length  = MAX_UINTN;
+  BOOLEAN     Same;
+
+  Status = XmlUnEscape (Input, XML_MAX_ELEMENT_VALUE_LENGTH, &Output);
+
+  CopyMem (Scratch, Input, AsciiStrLen (Input) + 1);
+  Same = (BOOLEAN)!EFI_ERROR (XmlUnEscapeInPlace (Scratch, XML_MAX_ELEMENT_VALUE_LENGTH, &Length));
+
+  if (Same) {
+    if (EFI_ERROR (Status)) {
+      Same = (BOOLEAN)(Length == 0);
+    } else {
+      Same = (BOOLEAN)((Length == AsciiStrLen (Output)) && (AsciiStrCmp (Output, Scratch) == 0));
+    }
+  }
+
+  if (Output != NULL) {
+    FreePool (Output);
+  }
+
+  UT_ASSERT_TRUE (Same);
+  return UNIT_TEST_PASSED;
+}
+
+//
+// Test cases
+//
+
+/**
+Escape each vector at every alignment and require the expected output
+**/
+UNIT_TEST_STATUS
+EFIAPI
+EscapeVectors (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8       Buffer[128 + FUZZ_MAX_ALIGNMENT];
+  CHAR8       *Input;
+  CHAR8       *Output;
+  UINTN       Index;
+  UINTN       Offset;
+  EFI_STATUS  Status;
+
+  for (Index = 0; Index < ARRAY_SIZE (mEscapeVectors); Index++) {
+    for (Offset = 0; Offset < FUZZ_MAX_ALIGNMENT; Offset++) {
+      Input = &Buffer[Offset];
+      CopyMem (Input, mEscapeVectors[Index].Input, AsciiStrLen (mEscapeVectors[Index].Input) + 1);
+
+      Output = NULL;
+      Status = XmlEscape (Input, XML_MAX_ELEMENT_VALUE_LENGTH, &Output);
+      if (mEscapeVectors[Index].Expected == NULL) {
+        UT_ASSERT_TRUE (EFI_ERROR (Status));
+        continue;
+      }
+
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      UT_ASSERT_NOT_NULL (Output);
+      Status = (AsciiStrCmp (Output, mEscapeVectors[Index].Expected) == 0) ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+      FreePool (Output);
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+Un-escape each vector at every alignment, both allocating and in place,
+and require the expected output
+**/
+UNIT_TEST_STATUS
+EFIAPI
+UnEscapeVectors (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8       Buffer[128 + FUZZ_MAX_ALIGNMENT];
+  CHAR8       *Input;
+  CHAR8       *Output;
+  UINTN       Index;
+  UINTN       Offset;
+  UINTN       Length;
+  EFI_STATUS  Status;
+
+  for (Index = 0; Index < ARRAY_SIZE (mUnEscapeVectors); Index++) {
+    for (Offset = 0; Offset < FUZZ_MAX_ALIGNMENT; Offset++) {
+      Input = &Buffer[Offset];
+      CopyMem (Input, mUnEscapeVectors[Index].Input, AsciiStrLen (mUnEscapeVectors[Index].Input) + 1);
+
+      Output = NULL;
+      Status = XmlUnEscape (Input, XML_MAX_ELEMENT_VALUE_LENGTH, &Output);
+      if (mUnEscapeVectors[Index].Expected == NULL) {
+        UT_ASSERT_TRUE (EFI_ERROR (Status));
+      } else {
+        UT_ASSERT_NOT_EFI_ERROR (Status);
+        UT_ASSERT_NOT_NULL (Output);
+        Status = (AsciiStrCmp (Output, mUnEscapeVectors[Index].Expected) == 0) ? EFI_SUCCESS : EFI_DEVICE_ERROR;
+        FreePool (Output);
+        UT_ASSERT_NOT_EFI_ERROR (Status);
+      }
+
+      Length = MAX_UINTN;
+      Status = XmlUnEscapeInPlace (Input, XML_MAX_ELEMENT_VALUE_LENGTH, &Length);
+      UT_ASSERT_NOT_EFI_ERROR (Status);
+      if (mUnEscapeVectors[Index].Expected == NULL) {
+        UT_ASSERT_EQUAL (Length, 0);
+      } else {
+        UT_ASSERT_EQUAL (Length, AsciiStrLen (mUnEscapeVectors[Index].Expected));
+        UT_ASSERT_MEM_EQUAL (Input, mUnEscapeVectors[Index].Expected, Length + 1);
+      }
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+Un-escaping random input allocating and in place must agree
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FuzzUnEscape (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8             *Buffer;
+  CHAR8             *Scratch;
+  CHAR8             *Input;
+  UINTN             Iteration;
+  UNIT_TEST_STATUS  Result;
+
+  Buffer  = AllocatePool (FUZZ_BUFFER_SIZE);
+  Scratch = AllocatePool (FUZZ_BUFFER_SIZE);
+  if ((Buffer == NULL) || (Scratch == NULL)) {
+    if (Buffer != NULL) {
+      FreePool (Buffer);
+    }
+
+    if (Scratch != NULL) {
+      FreePool (Scratch);
+    }
+
+    UT_ASSERT_TRUE (FALSE);
+  }
+
+  mFuzzState = FUZZ_SEED + 1;
+  Result     = UNIT_TEST_PASSED;
+  for (Iteration = 0; (Iteration < FUZZ_ITERATIONS) && (Result == UNIT_TEST_PASSED); Iteration++) {
+    Input = &Buffer[PseudoRandomBelow (&mFuzzState, FUZZ_MAX_ALIGNMENT)];
+    BuildFuzzString (Input, (UINTN)PseudoRandomBelow (&mFuzzState, FUZZ_MAX_LENGTH));
+    Result = CompareUnEscape (Input, &Scratch[PseudoRandomBelow (&mFuzzState, FUZZ_MAX_ALIGNMENT)]);
+  }
+
+  if (Result == UNIT_TEST_PASSED) {
+    Input = &Buffer[3];
+    BuildFuzzString (Input, FUZZ_LARGE_LENGTH);
+    Result = CompareUnEscape (Input, Scratch);
+  }
+
+  FreePool (Buffer);
+  FreePool (Scratch);
+  return Result;
+}
+
+/**
+Escaping then un-escaping must give back the original string
+**/
+UNIT_TEST_STATUS
+EFIAPI
+FuzzRoundTrip (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  CHAR8       Input[FUZZ_MAX_LENGTH + 1];
+  CHAR8       *Escaped;
+  CHAR8       *UnEscaped;
+  UINTN       Iteration;
+  UINTN       Length;
+  BOOLEAN     Same;
+  EFI_STATUS  Status;
+
+  mFuzzState = FUZZ_SEED + 2;
+  for (Iteration = 0; Iteration < FUZZ_ITERATIONS; Iteration++) {
+    BuildFuzzString (Input, (UINTN)PseudoRandomBelow (&mFuzzState, FUZZ_MAX_LENGTH) + 1);
+
+    Escaped = NULL;
+    Status  = XmlEscape (Input, FUZZ_MAX_LENGTH, &Escaped);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+
+    UnEscaped = NULL;
+    Status    = XmlUnEscape (Escaped, XML_MAX_ELEMENT_VALUE_LENGTH, &UnEscaped);
+    Same      = (BOOLEAN)(!EFI_ERROR (Status) && (AsciiStrCmp (Input, UnEscaped) == 0));
+    if (UnEscaped != NULL) {
+      FreePool (UnEscaped);
+    }
+
+    Status = XmlUnEscapeInPlace (Escaped, XML_MAX_ELEMENT_VALUE_LENGTH, &Length);
+    Same   = (BOOLEAN)(Same && !EFI_ERROR (Status) && (Length == AsciiStrLen (Input)) && (AsciiStrCmp (Input, Escaped) == 0));
+    FreePool (Escaped);
+
+    UT_ASSERT_TRUE (Same);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+EFI_STATUS
+EFIAPI
+RegisterEscapeFuzzTests (
+  IN UNIT_TEST_FRAMEWORK_HANDLE  Framework
+  )
+{
+  EFI_STATUS              Status;
+  UNIT_TEST_SUITE_HANDLE  FuzzTestSuite;
+
+  Status = CreateUnitTestSuite (&FuzzTestSuite, Framework, "XML Escape Fuzz Test Suite", "Common.Xml.EscapeFuzz", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for XML Escape Fuzz Test Suite\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  AddTestCase (FuzzTestSuite, "Escape gives the expected output", "EscapeVectors", EscapeVectors, NULL, NULL, NULL);
+  AddTestCase (FuzzTestSuite, "UnEscape and UnEscape in place give the expected output", "UnEscapeVectors", UnEscapeVectors, NULL, NULL, NULL);
+  AddTestCase (FuzzTestSuite, "UnEscape and UnEscape in place agree", "UnEscape", FuzzUnEscape, NULL, NULL, NULL);
+  AddTestCase (FuzzTestSuite, "Escape then UnEscape gives the original string", "RoundTrip", FuzzRoundTrip, NULL, NULL, NULL);
+
+  return EFI_SUCCESS;
+}
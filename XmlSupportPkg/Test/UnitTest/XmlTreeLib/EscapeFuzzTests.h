@@ -0,0 +1,24 @@
+/**
+@file
+Fixed vector and fuzz tests for XmlEscape and XmlUnEscape.
+
+Copyright (C) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef ESCAPE_FUZZ_TESTS_H_
+#define ESCAPE_FUZZ_TESTS_H_
+
+/**
+Add the escape fuzz test cases to the framework in a new suite.
+
+@param Framework  Unit test framework to add the suite to
+**/
+EFI_STATUS
+EFIAPI
+RegisterEscapeFuzzTests (
+  IN UNIT_TEST_FRAMEWORK_HANDLE  Framework
+  );
+
+#endif // ESCAPE_FUZZ_TESTS_H_
@@ -13,12 +13,20 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/UnitTestLib.h>
+#include <Library/TimerLib.h>
 #include <XmlTypes.h>
 #include <Library/XmlTreeLib.h>
 #include "TestData.h"
+#include "EscapeFuzzTests.h"
 
 #define UNIT_TEST_APP_NAME     "XML Lib Unit Test Application"
-#define UNIT_TEST_APP_VERSION  "0.3"
+#define UNIT_TEST_APP_VERSION  "0.5"
+
+// Number of records in the generated document used to benchmark tree vs stream parsing
+#define BENCHMARK_RECORD_COUNT  (2000)
+
+// Largest generated record, including the closing tags
+#define BENCHMARK_RECORD_SIZE  (96)
 
 /**
 Simple clean up method to make sure string parsing tests clean up even if interrupted and fail in the middle.
@@ -450,6 +458,395 @@ TestAttributeMax (
   return UNIT_TEST_PASSED;
 }
 
+//
+// Streaming parser tests
+//
+
+typedef struct {
+  UINTN          Elements;
+  UINTN          Attributes;
+  UINTN          MaxDepth;
+  UINTN          MaxAttributes;
+  UINTN          CurrentAttributes;
+  UINTN          TextRuns;
+  CONST CHAR8    *DocStart;
+  CONST CHAR8    *DocEnd;
+  BOOLEAN        OutsideDocument;
+  CONST CHAR8    *StopAtElement;   // if set stop when this element has text
+  CHAR8          FoundText[64];
+} XmlStreamCounts;
+
+/**
+Record if a slice is not a view into the document
+**/
+STATIC
+VOID
+CheckSlice (
+  IN XmlStreamCounts         *Counts,
+  IN CONST XML_STRING_SLICE  *Slice
+  )
+{
+  if ((Slice->Data < Counts->DocStart) || ((Slice->Data + Slice->Length) > Counts->DocEnd)) {
+    Counts->OutsideDocument = TRUE;
+  }
+}
+
+EFI_STATUS
+EFIAPI
+CountStartElement (
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Name,
+  IN UINTN                   Depth
+  )
+{
+  XmlStreamCounts  *Counts = (XmlStreamCounts *)Context;
+
+  CheckSlice (Counts, Name);
+  Counts->Elements++;
+  Counts->CurrentAttributes = 0;
+  if (Depth + 1 > Counts->MaxDepth) {
+    Counts->MaxDepth = Depth + 1;
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+CountAttribute (
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Name,
+  IN CONST XML_STRING_SLICE  *Value
+  )
+{
+  XmlStreamCounts  *Counts = (XmlStreamCounts *)Context;
+
+  CheckSlice (Counts, Name);
+  CheckSlice (Counts, Value);
+  Counts->Attributes++;
+  Counts->CurrentAttributes++;
+  if (Counts->CurrentAttributes > Counts->MaxAttributes) {
+    Counts->MaxAttributes = Counts->CurrentAttributes;
+  }
+
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+CountText (
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Text,
+  IN UINTN                   Depth
+  )
+{
+  CheckSlice ((XmlStreamCounts *)Context, Text);
+  ((XmlStreamCounts *)Context)->TextRuns++;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+CountEndElement (
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Name,
+  IN UINTN                   Depth
+  )
+{
+  CheckSlice ((XmlStreamCounts *)Context, Name);
+  return EFI_SUCCESS;
+}
+
+CONST XML_STREAM_CALLBACKS  mCountCallbacks = { CountStartElement, CountAttribute, CountText, CountEndElement };
+
+/**
+Stream parse the test document and make sure the counts match the tree based values
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamValidXml (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XmlTestContext   *XmlContext = (XmlTestContext *)Context;
+  XmlStreamCounts  Counts;
+  EFI_STATUS       Status;
+  UINTN            Length;
+
+  Length = AsciiStrLen (XmlContext->InputXmlString);
+  ZeroMem (&Counts, sizeof (Counts));
+  Counts.DocStart = XmlContext->InputXmlString;
+  Counts.DocEnd   = XmlContext->InputXmlString + Length;
+
+  Status = ParseXmlStream (XmlContext->InputXmlString, Length, &mCountCallbacks, &Counts);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (XmlContext->TotalElements, Counts.Elements);
+  UT_ASSERT_EQUAL (XmlContext->TotalAttributes, Counts.Attributes);
+  UT_ASSERT_EQUAL (XmlContext->MaxDepth, Counts.MaxDepth);
+  UT_ASSERT_EQUAL (XmlContext->MaxAttributes, Counts.MaxAttributes);
+  UT_ASSERT_FALSE (Counts.OutsideDocument);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+Test that invalid Xml is reported by the streaming parser
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamInValidXml (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XmlStreamCounts  Counts;
+  UINTN            Index;
+  CONST CHAR8      *BadStrings[] = {
+    "This is not valid xml",
+    "<Node1><Node2></Node1>",
+    "<Node1><Node2><Node3 /></Node1>",
+    "<Node1><Node2 /><Node2></Node2>",
+    "<Node1 /><Node2 />"
+  };
+
+  for (Index = 0; Index < ARRAY_SIZE (BadStrings); Index++) {
+    ZeroMem (&Counts, sizeof (Counts));
+    Counts.DocStart = BadStrings[Index];
+    Counts.DocEnd   = BadStrings[Index] + AsciiStrLen (BadStrings[Index]);
+    UT_ASSERT_TRUE (EFI_ERROR (ParseXmlStream (BadStrings[Index], AsciiStrLen (BadStrings[Index]), &mCountCallbacks, &Counts)));
+  }
+
+  UT_ASSERT_EQUAL (ParseXmlStream (NULL, 10, &mCountCallbacks, &Counts), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (ParseXmlStream (BadStrings[1], 0, &mCountCallbacks, &Counts), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (ParseXmlStream (BadStrings[1], AsciiStrLen (BadStrings[1]), NULL, &Counts), EFI_INVALID_PARAMETER);
+
+  return UNIT_TEST_PASSED;
+}
+
+EFI_STATUS
+EFIAPI
+StopStartElement (
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Name,
+  IN UINTN                   Depth
+  )
+{
+  XmlStreamCounts  *Counts = (XmlStreamCounts *)Context;
+
+  Counts->Elements++;
+  Counts->MaxDepth = XmlSliceEqual (Name, Counts->StopAtElement) ? Depth : MAX_UINTN;
+  return EFI_SUCCESS;
+}
+
+EFI_STATUS
+EFIAPI
+StopText (
+  IN VOID                    *Context,
+  IN CONST XML_STRING_SLICE  *Text,
+  IN UINTN                   Depth
+  )
+{
+  XmlStreamCounts  *Counts = (XmlStreamCounts *)Context;
+
+  if (Counts->MaxDepth != Depth) {
+    return EFI_SUCCESS;
+  }
+
+  AsciiStrnCpyS (Counts->FoundText, sizeof (Counts->FoundText), Text->Data, Text->Length);
+  return EFI_ABORTED;
+}
+
+/**
+Make sure a callback can stop the parse as soon as it has what it needs
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamEarlyStop (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XmlTestContext        *XmlContext = (XmlTestContext *)Context;
+  XmlStreamCounts       Counts;
+  EFI_STATUS            Status;
+  XML_STREAM_CALLBACKS  Callbacks = { StopStartElement, NULL, StopText, NULL };
+
+  ZeroMem (&Counts, sizeof (Counts));
+  Counts.StopAtElement = "Gen3Node";
+
+  Status = ParseXmlStream (XmlContext->InputXmlString, AsciiStrLen (XmlContext->InputXmlString), &Callbacks, &Counts);
+  UT_ASSERT_EQUAL (Status, EFI_ABORTED);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Counts.FoundText, "Gen3Node1 contents"), 0);
+
+  // Stopped before the remaining elements were seen
+  UT_ASSERT_TRUE (Counts.Elements < XmlContext->TotalElements);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+Make sure documents nested deeper than XML_MAX_STREAM_DEPTH are rejected
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamTooDeep (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XmlStreamCounts  Counts;
+  CHAR8            *Doc;
+  UINTN            Index;
+  UINTN            Size;
+  EFI_STATUS       Status;
+
+  Size = ((XML_MAX_STREAM_DEPTH + 1) * 7) + 1;
+  Doc  = AllocateZeroPool (Size);
+  UT_ASSERT_NOT_NULL (Doc);
+
+  for (Index = 0; Index <= XML_MAX_STREAM_DEPTH; Index++) {
+    AsciiStrCatS (Doc, Size, "<a>");
+  }
+
+  for (Index = 0; Index <= XML_MAX_STREAM_DEPTH; Index++) {
+    AsciiStrCatS (Doc, Size, "</a>");
+  }
+
+  ZeroMem (&Counts, sizeof (Counts));
+  Counts.DocStart = Doc;
+  Counts.DocEnd   = Doc + AsciiStrLen (Doc);
+  Status          = ParseXmlStream (Doc, AsciiStrLen (Doc), &mCountCallbacks, &Counts);
+  FreePool (Doc);
+
+  UT_ASSERT_EQUAL (Status, EFI_BAD_BUFFER_SIZE);
+  UT_ASSERT_EQUAL (Counts.Elements, XML_MAX_STREAM_DEPTH);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+Count the bytes allocated for a tree.  Pool headers are not included.
+
+@param[in]  Node  Root of the tree
+
+@retval Bytes held by the nodes, attributes and strings of the tree
+**/
+UINTN
+TreeAllocatedBytes (
+  IN CONST XmlNode  *Node
+  )
+{
+  LIST_ENTRY    *Link;
+  XmlAttribute  *Attribute;
+  UINTN         Bytes;
+
+  Bytes = sizeof (XmlNode) + AsciiStrSize (Node->Name);
+  if (Node->Value != NULL) {
+    Bytes += AsciiStrSize (Node->Value);
+  }
+
+  if (Node->XmlDeclaration.Declaration != NULL) {
+    Bytes += AsciiStrSize (Node->XmlDeclaration.Declaration);
+  }
+
+  for (Link = Node->AttributesListHead.ForwardLink; Link != &Node->AttributesListHead; Link = Link->ForwardLink) {
+    Attribute = (XmlAttribute *)Link;
+    Bytes    += sizeof (XmlAttribute) + AsciiStrSize (Attribute->Name) + AsciiStrSize (Attribute->Value);
+  }
+
+  for (Link = Node->ChildrenListHead.ForwardLink; Link != &Node->ChildrenListHead; Link = Link->ForwardLink) {
+    Bytes += TreeAllocatedBytes ((XmlNode *)Link);
+  }
+
+  return Bytes;
+}
+
+/**
+Compare building a tree against streaming for a large generated document.
+Timing and peak allocation are logged.  Results must agree.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+StreamBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XmlStreamCounts  Counts;
+  XmlNode          *Tree = NULL;
+  CHAR8            *Doc;
+  CHAR8            *End;
+  UINTN            Index;
+  UINTN            Size;
+  UINTN            Length;
+  UINTN            TreeElements = 0;
+  UINTN            TreeBytes    = 0;
+  UINT64           Start;
+  UINT64           TreeNs;
+  UINT64           StreamNs;
+  EFI_STATUS       Status;
+
+  Size = (BENCHMARK_RECORD_COUNT * BENCHMARK_RECORD_SIZE) + 32;
+  Doc  = AllocateZeroPool (Size);
+  UT_ASSERT_NOT_NULL (Doc);
+
+  //
+  // Append at the end of what has been written so far.  Appending with
+  // AsciiStrCatS would scan the whole document for every record.
+  //
+  End  = Doc;
+  End += AsciiSPrint (End, Size - (End - Doc), "<Records>");
+  for (Index = 0; Index < BENCHMARK_RECORD_COUNT; Index++) {
+    End += AsciiSPrint (End, Size - (End - Doc), "<Record id='%d' kind='test'><Data>0123456789ABCDEF %d</Data></Record>", Index, Index);
+  }
+
+  End   += AsciiSPrint (End, Size - (End - Doc), "</Records>");
+  Length = End - Doc;
+
+  //
+  // The whole tree is live before it is freed so its size is the peak
+  // allocation of the tree parse.
+  //
+  Start  = GetPerformanceCounter ();
+  Status = CreateXmlTree (Doc, Length, &Tree);
+  TreeNs = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+  if (!EFI_ERROR (Status)) {
+    TreeBytes = TreeAllocatedBytes (Tree);
+    Status    = XmlTreeNumberOfNodes (Tree, &TreeElements);
+    FreeXmlTree (&Tree);
+  }
+
+  if (EFI_ERROR (Status)) {
+    FreePool (Doc);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+
+  ZeroMem (&Counts, sizeof (Counts));
+  Counts.DocStart = Doc;
+  Counts.DocEnd   = Doc + Length;
+  Start           = GetPerformanceCounter ();
+  Status          = ParseXmlStream (Doc, Length, &mCountCallbacks, &Counts);
+  StreamNs        = GetTimeInNanoSecond (GetPerformanceCounter () - Start);
+  FreePool (Doc);
+
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  UT_ASSERT_EQUAL (TreeElements, Counts.Elements);
+  UT_ASSERT_EQUAL ((BENCHMARK_RECORD_COUNT * 2) + 1, Counts.Elements);
+  UT_ASSERT_EQUAL (BENCHMARK_RECORD_COUNT * 2, Counts.Attributes);
+  UT_ASSERT_EQUAL (BENCHMARK_RECORD_COUNT, Counts.TextRuns);
+  UT_ASSERT_TRUE (TreeBytes > Length);
+
+  //
+  // The stream parser keeps its state on the stack and returns slices of
+  // the document so it makes no allocations.
+  //
+  UT_LOG_INFO (
+    "%d bytes.  Tree parse %ld us, peak allocation %d bytes.  Stream parse %ld us, peak allocation 0 bytes.\n",
+    Length,
+    TreeNs / 1000,
+    TreeBytes,
+    StreamNs / 1000
+    );
+
+  return UNIT_TEST_PASSED;
+}
+
 /**
 
   Main fuction sets up the unit test environment
@@ -465,6 +862,7 @@ UnitTestingEntry (
   UNIT_TEST_SUITE_HANDLE      InputTestSuite;
   UNIT_TEST_SUITE_HANDLE      ProcessEscapedInputTestSuite;
   UNIT_TEST_SUITE_HANDLE      BasicMetricsTestSuite;
+  UNIT_TEST_SUITE_HANDLE      StreamTestSuite;
 
   DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_APP_NAME, UNIT_TEST_APP_VERSION));
 
@@ -531,6 +929,34 @@ UnitTestingEntry (
   AddTestCase (InputTestSuite, "Fail parsing string missing nested closing element", "InvalidString", ParseInValidXml3, NULL, NULL, NULL);
 
   AddTestCase (InputTestSuite, "Parse Valid XML with a long data element", "LongElement", ParseValidXml, NULL, CleanUpXmlTestContext, &LongElementContext);
+
+  //
+  // Test parsing without building a tree
+  //
+  Status = CreateUnitTestSuite (&StreamTestSuite, Fw, "XML Stream Parsing Test Suite ", "Common.Xml.Stream", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for XML Stream Parsing Test Suite\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (StreamTestSuite, "Stream Valid XML with simple elements 3 layers", "StreamElements", StreamValidXml, NULL, NULL, &SimpleElementsOnlyContext);
+  AddTestCase (StreamTestSuite, "Stream Valid XML with 2 elements and 2 attributes", "StreamElementsAndAttributes", StreamValidXml, NULL, NULL, &SimpleElementsAttributesContext);
+  AddTestCase (StreamTestSuite, "Stream encoded XML string containing an attribute with encoded xml chars", "StreamEncodedAttribute", StreamValidXml, NULL, NULL, &EncodedXmlAttribute1Context);
+  AddTestCase (StreamTestSuite, "Stream Valid XML with a long data element", "StreamLongElement", StreamValidXml, NULL, NULL, &LongElementContext);
+  AddTestCase (StreamTestSuite, "Fail streaming invalid XML", "StreamInvalid", StreamInValidXml, NULL, NULL, NULL);
+  AddTestCase (StreamTestSuite, "Stop streaming from a callback", "StreamEarlyStop", StreamEarlyStop, NULL, NULL, &SimpleElementsOnlyContext);
+  AddTestCase (StreamTestSuite, "Fail streaming XML nested too deep", "StreamTooDeep", StreamTooDeep, NULL, NULL, NULL);
+  AddTestCase (StreamTestSuite, "Benchmark tree vs stream parsing", "StreamBenchmark", StreamBenchmark, NULL, NULL, NULL);
+
+  //
+  // Escape and un-escape vectors and fuzzing
+  //
+  Status = RegisterEscapeFuzzTests (Fw);
+  if (EFI_ERROR (Status)) {
+    goto EXIT;
+  }
+
   //
   // Execute the tests.
   //
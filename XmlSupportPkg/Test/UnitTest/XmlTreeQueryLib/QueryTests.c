@@ -0,0 +1,293 @@
+/**
+Unit Tests that verify functionality of XmlTreeQueryLib for indexed lookups
+and compiled path queries
+
+
+Copyright (C) Microsoft Corporation.
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+#include "XmlTreeQueryLibUnitTests.h"
+
+#define WIDE_NODE_CHILDREN  (64)
+
+/**
+Create a root node with many children so lookups use the hash index.
+Child i is named "Child<i % 16>" so every name appears 4 times
+and has an attribute index="<i>".
+**/
+STATIC
+XmlNode *
+CreateWideTree (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  XmlNode     *Root  = NULL;
+  XmlNode     *Child = NULL;
+  CHAR8       Name[16];
+  CHAR8       Value[16];
+  UINTN       Index;
+
+  Status = AddNode (NULL, "Wide", NULL, &Root);
+  if (EFI_ERROR (Status)) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < WIDE_NODE_CHILDREN; Index++) {
+    AsciiSPrint (Name, sizeof (Name), "Child%d", Index % 16);
+    AsciiSPrint (Value, sizeof (Value), "%d", Index);
+    Status = AddNode (Root, Name, NULL, &Child);
+    if (!EFI_ERROR (Status)) {
+      Status = AddAttributeToNode (Child, "index", Value);
+    }
+
+    if (EFI_ERROR (Status)) {
+      FreeXmlTree (&Root);
+      return NULL;
+    }
+  }
+
+  return Root;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+IndexedChildLookup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XmlNode       *Root   = NULL;
+  XmlNode       *Result = NULL;
+  XmlAttribute  *Att    = NULL;
+
+  Root = CreateWideTree ();
+  UT_ASSERT_NOT_NULL (Root);
+
+  // Duplicate names must return the first one in document order
+  Result = FindFirstChildNodeByName (Root, "Child3");
+  UT_ASSERT_NOT_NULL (Result);
+  UT_ASSERT_NOT_NULL (Root->QueryIndex);
+  Att = FindFirstAttributeByName (Result, "index");
+  UT_ASSERT_NOT_NULL (Att);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Att->Value, "3"), 0);
+
+  Result = FindFirstChildNodeByName (Root, "Child15");
+  UT_ASSERT_NOT_NULL (Result);
+  Att = FindFirstAttributeByName (Result, "index");
+  UT_ASSERT_NOT_NULL (Att);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Att->Value, "15"), 0);
+
+  Result = FindFirstChildNodeByName (Root, "Child16");
+  UT_ASSERT_TRUE (Result == NULL);
+
+  // Adding a child drops the index and the new child is found
+  UT_ASSERT_NOT_EFI_ERROR (AddNode (Root, "Child16", NULL, NULL));
+  UT_ASSERT_TRUE (Root->QueryIndex == NULL);
+  Result = FindFirstChildNodeByName (Root, "Child16");
+  UT_ASSERT_NOT_NULL (Result);
+  UT_ASSERT_NOT_NULL (Root->QueryIndex);
+
+  FreeXmlTree (&Root);
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+IndexedAttributeLookup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XmlNode       *Node   = NULL;
+  XmlAttribute  *Result = NULL;
+  CHAR8         Name[16];
+  CHAR8         Value[16];
+  UINTN         Index;
+
+  UT_ASSERT_NOT_EFI_ERROR (AddNode (NULL, "ManyAttributes", NULL, &Node));
+  for (Index = 0; Index < 2 * XML_QUERY_INDEX_THRESHOLD; Index++) {
+    AsciiSPrint (Name, sizeof (Name), "att%d", Index);
+    AsciiSPrint (Value, sizeof (Value), "value%d", Index);
+    UT_ASSERT_NOT_EFI_ERROR (AddAttributeToNode (Node, Name, Value));
+  }
+
+  Result = FindFirstAttributeByName (Node, "att7");
+  UT_ASSERT_NOT_NULL (Result);
+  UT_ASSERT_NOT_NULL (Node->QueryIndex);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Result->Value, "value7"), 0);
+  UT_ASSERT_EQUAL ((UINTN)Result->Parent, (UINTN)Node);
+
+  Result = FindFirstAttributeByName (Node, "att99");
+  UT_ASSERT_TRUE (Result == NULL);
+
+  FreeXmlTree (&Node);
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+QueryCompileInvalid (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XML_QUERY  *Query = NULL;
+
+  UT_ASSERT_EQUAL (CompileXmlQuery (NULL, &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("RootNode", NULL), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("", &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("/", &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("A//B", &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("A/", &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("A[name=x]", &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("A[@name", &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("A[@name='x]", &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_EQUAL (CompileXmlQuery ("A[@name=x]B", &Query), EFI_INVALID_PARAMETER);
+  UT_ASSERT_TRUE (Query == NULL);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+QueryAbsolutePath (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XML_QUERY  *Query  = NULL;
+  XmlNode    *Result = NULL;
+
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("/RootNode", &Query));
+  Result = XmlQueryFindFirst (mNode, Query);
+  UT_ASSERT_EQUAL ((UINTN)Result, (UINTN)mNode);
+  UT_ASSERT_TRUE (XmlQueryFindNext (mNode, Query, Result) == NULL);
+  FreeXmlQuery (Query);
+
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("/RootNode/AnotherGen1Node", &Query));
+  Result = XmlQueryFindFirst (mNode, Query);
+  UT_ASSERT_NOT_NULL (Result);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Result->Value, "Test Data 123"), 0);
+  FreeXmlQuery (Query);
+
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("/NotTheRoot/AnotherGen1Node", &Query));
+  UT_ASSERT_TRUE (XmlQueryFindFirst (mNode, Query) == NULL);
+  FreeXmlQuery (Query);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+QueryBacktracking (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XML_QUERY  *Query  = NULL;
+  XmlNode    *Result = NULL;
+
+  // First Gen1Node has no Gen2Node and the first Gen2Node has no Gen3Node
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("Gen1Node/Gen2Node/Gen3Node", &Query));
+  Result = XmlQueryFindFirst (mNode, Query);
+  UT_ASSERT_NOT_NULL (Result);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Result->Value, "Gen3Node1 contents"), 0);
+
+  Result = XmlQueryFindNext (mNode, Query, Result);
+  UT_ASSERT_NOT_NULL (Result);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Result->Value, "Gen2Node2 contents"), 0);
+
+  // Previous must come from this query, so a node at the wrong depth is rejected
+  UT_ASSERT_TRUE (XmlQueryFindNext (mNode, Query, Result->ParentNode) == NULL);
+
+  Result = XmlQueryFindNext (mNode, Query, Result);
+  UT_ASSERT_TRUE (Result == NULL);
+  FreeXmlQuery (Query);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+QueryPredicates (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XML_QUERY  *Query  = NULL;
+  XmlNode    *Result = NULL;
+
+  // Attribute must exist
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("Gen1Node[@attribute1]/Gen2Node", &Query));
+  Result = XmlQueryFindFirst (mNode, Query);
+  UT_ASSERT_NOT_NULL (Result);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Result->Value, "Gen2Node1 contents"), 0);
+  UT_ASSERT_TRUE (XmlQueryFindNext (mNode, Query, Result) == NULL);
+  FreeXmlQuery (Query);
+
+  // Quoted value
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("*/Gen2Node[@attribute2.2=\"value2.2\"]", &Query));
+  Result = XmlQueryFindFirst (mNode, Query);
+  UT_ASSERT_NOT_NULL (Result);
+  UT_ASSERT_NOT_NULL (FindFirstAttributeByName (Result, "attribute2.1"));
+  FreeXmlQuery (Query);
+
+  // Unquoted value that does not match
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("Gen1Node[@attribute1=value2]", &Query));
+  UT_ASSERT_TRUE (XmlQueryFindFirst (mNode, Query) == NULL);
+  FreeXmlQuery (Query);
+
+  return UNIT_TEST_PASSED;
+}
+
+UNIT_TEST_STATUS
+EFIAPI
+QueryWideTree (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  XML_QUERY     *Query  = NULL;
+  XmlNode       *Root   = NULL;
+  XmlNode       *Result = NULL;
+  XmlAttribute  *Att    = NULL;
+  UINTN         Count   = 0;
+
+  Root = CreateWideTree ();
+  UT_ASSERT_NOT_NULL (Root);
+
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("/Wide/Child5[@index='37']", &Query));
+  Result = XmlQueryFindFirst (Root, Query);
+  UT_ASSERT_NOT_NULL (Result);
+  Att = FindFirstAttributeByName (Result, "index");
+  UT_ASSERT_NOT_NULL (Att);
+  UT_ASSERT_EQUAL (AsciiStrCmp (Att->Value, "37"), 0);
+  FreeXmlQuery (Query);
+
+  // Every Child5 is returned in document order
+  UT_ASSERT_NOT_EFI_ERROR (CompileXmlQuery ("Child5", &Query));
+  for (Result = XmlQueryFindFirst (Root, Query); Result != NULL; Result = XmlQueryFindNext (Root, Query, Result)) {
+    Att = FindFirstAttributeByName (Result, "index");
+    UT_ASSERT_NOT_NULL (Att);
+    UT_ASSERT_EQUAL (AsciiStrDecimalToUintn (Att->Value), 5 + (16 * Count));
+    Count++;
+  }
+
+  UT_ASSERT_EQUAL (Count, WIDE_NODE_CHILDREN / 16);
+  FreeXmlQuery (Query);
+
+  FreeXmlTree (&Root);
+  return UNIT_TEST_PASSED;
+}
+
+EFI_STATUS
+EFIAPI
+RegisterQueryTests (
+  IN UNIT_TEST_SUITE_HANDLE  TestSuite
+  )
+{
+  AddTestCase (TestSuite, "Indexed child lookup on a wide node", "Index.Child", IndexedChildLookup, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Indexed attribute lookup on a wide node", "Index.Attribute", IndexedAttributeLookup, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Compile invalid path queries", "Query.Invalid", QueryCompileInvalid, NULL, NULL, NULL);
+  AddTestCase (TestSuite, "Query with absolute path", "Query.Absolute", QueryAbsolutePath, PreReqNodeTreeIsValid, NULL, NULL);
+  AddTestCase (TestSuite, "Query needing backtracking", "Query.Backtrack", QueryBacktracking, PreReqNodeTreeIsValid, NULL, NULL);
+  AddTestCase (TestSuite, "Query with attribute predicates", "Query.Predicate", QueryPredicates, PreReqNodeTreeIsValid, NULL, NULL);
+  AddTestCase (TestSuite, "Query a wide node", "Query.Wide", QueryWideTree, NULL, NULL, NULL);
+
+  return EFI_SUCCESS;
+}